@@ -3,36 +3,59 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 
 static void print_usage(void) {
     fprintf(stderr,
             "Usage:\n"
-            "  kolibri_indexer build --output DIR ROOT...\n"
+            "  kolibri_indexer build --output DIR [--threads N] [--full] ROOT...\n"
             "  kolibri_indexer search --query TEXT [--limit N] ROOT...\n");
 }
 
 static int handle_build(int argc, char **argv) {
     const char *output_dir = NULL;
+    size_t threads = 0U;
+    int full = 0;
     size_t root_start = 0U;
     for (int i = 0; i < argc; ++i) {
         if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
             output_dir = argv[i + 1];
-            root_start = (size_t)(i + 2);
+            i++;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = (size_t)atoi(argv[i + 1]);
+            i++;
+        } else if (strcmp(argv[i], "--full") == 0) {
+            full = 1;
+        } else {
+            root_start = (size_t)i;
             break;
         }
     }
-    if (!output_dir || root_start >= (size_t)argc) {
+    if (!output_dir || root_start == 0U || root_start >= (size_t)argc) {
         print_usage();
         return 1;
     }
 
+    /* The manifest next to index.json lets the next run skip unchanged files */
+    char manifest_path[4096];
+    snprintf(manifest_path, sizeof(manifest_path), "%s/index.manifest", output_dir);
+    if (full) {
+        remove(manifest_path);
+    }
+    mkdir(output_dir, 0777);
+    KolibriKnowledgeBuildOptions options = {threads, manifest_path};
+    KolibriKnowledgeBuildStats stats;
     size_t root_count = (size_t)argc - root_start;
     KolibriKnowledgeIndex *index = NULL;
-    int err = kolibri_knowledge_index_create((const char *const *)&argv[root_start], root_count, 1024U, &index);
+    int err = kolibri_knowledge_index_build((const char *const *)&argv[root_start], root_count, 1024U,
+                                            &options, &index, &stats);
     if (err != 0 || !index) {
         fprintf(stderr, "Failed to build index: %d\n", err);
         return 1;
     }
+    printf("Indexed %zu files: %zu parsed, %zu unchanged, %zu removed, %zu vectors updated\n",
+           stats.files_seen, stats.files_parsed, stats.files_unchanged, stats.files_removed,
+           stats.vectors_updated);
     err = kolibri_knowledge_index_write_json(index, output_dir);
     kolibri_knowledge_index_destroy(index);
     if (err != 0) {
@@ -1,15 +1,60 @@
 /*
  * Kolibri Knowledge Relay: replicate TEACH/USER_FEEDBACK from knowledge genome
  * to node genomes, re-signing with node HMAC keys.
+ *
+ * Target genomes stay open for the whole run and receive new events in
+ * batches; the source is tailed from the saved block offset. With --watch
+ * the relay keeps running and wakes on inotify events.
  */
 
 #include "kolibri/genome.h"
 
 #include <dirent.h>
 #include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define RELAY_DEFAULT_BATCH 256
+#define RELAY_DEFAULT_INTERVAL_MS 1000
+
+typedef struct {
+  char path[512];
+  KolibriGenome genome;
+  int open;
+} RelayTarget;
+
+typedef struct {
+  RelayTarget *items;
+  size_t count;
+  size_t capacity;
+} RelayTargets;
+
+typedef struct {
+  char event_type[KOLIBRI_EVENT_TYPE_SIZE + 1];
+  char payload[KOLIBRI_PAYLOAD_SIZE + 1];
+} RelayEvent;
+
+typedef struct {
+  const char *path;
+  FILE *file;
+  dev_t dev;
+  ino_t ino;
+  unsigned long long next_index; /* Следующий непрочитанный блок */
+} RelaySource;
+
+static volatile sig_atomic_t g_stop = 0;
+
+static void on_signal(int signo) {
+  (void)signo;
+  g_stop = 1;
+}
 
 static int ends_with(const char *s, const char *suffix) {
   size_t ls = strlen(s), lsf = strlen(suffix);
@@ -18,20 +63,6 @@ static int ends_with(const char *s, const char *suffix) {
 
 static int is_genome_file(const char *name) { return ends_with(name, ".dat"); }
 
-static void relay_event_to_target(const char *target_path, const unsigned char *key,
-                                  size_t key_len, const char *event_type,
-                                  const char *payload) {
-  KolibriGenome g;
-  if (kg_open(&g, target_path, key, key_len) != 0) {
-    fprintf(stderr, "[relay] open target failed: %s\n", target_path);
-    return;
-  }
-  if (kg_append(&g, event_type, payload, NULL) != 0) {
-    fprintf(stderr, "[relay] append failed: %s\n", target_path);
-  }
-  kg_close(&g);
-}
-
 static int load_key_from_file(const char *path, unsigned char *out, size_t *out_len) {
   FILE *f = fopen(path, "rb");
   if (!f) return -1;
@@ -42,12 +73,277 @@ static int load_key_from_file(const char *path, unsigned char *out, size_t *out_
   return 0;
 }
 
+/* ----------------------------- Targets ------------------------------ */
+
+static int target_open(RelayTarget *t, const unsigned char *key, size_t key_len) {
+  if (kg_open(&t->genome, t->path, key, key_len) != 0) {
+    fprintf(stderr, "[relay] open target failed: %s\n", t->path);
+    t->open = 0;
+    return -1;
+  }
+  t->open = 1;
+  return 0;
+}
+
+/* Another writer (the node itself) may have appended since we opened the
+ * genome: the size no longer matches our chain, so reopen to resync. */
+static int target_sync(RelayTarget *t, const unsigned char *key, size_t key_len) {
+  if (t->open) {
+    struct stat st;
+    if (fstat(fileno(t->genome.file), &st) == 0 &&
+        (unsigned long long)st.st_size ==
+            (unsigned long long)t->genome.next_index * KOLIBRI_BLOCK_SIZE) {
+      return 0;
+    }
+    kg_close(&t->genome);
+    t->open = 0;
+  }
+  return target_open(t, key, key_len);
+}
+
+static int targets_contains(const RelayTargets *targets, const char *path) {
+  for (size_t i = 0; i < targets->count; ++i) {
+    if (strcmp(targets->items[i].path, path) == 0) return 1;
+  }
+  return 0;
+}
+
+/* Adds genomes of dir that are not tracked yet; returns -1 if dir is missing */
+static int targets_scan(RelayTargets *targets, const char *dir_path,
+                        const unsigned char *key, size_t key_len) {
+  DIR *dir = opendir(dir_path);
+  if (!dir) {
+    fprintf(stderr, "[relay] cannot open targets-dir %s\n", dir_path);
+    return -1;
+  }
+  struct dirent *ent;
+  while ((ent = readdir(dir)) != NULL) {
+    if (ent->d_name[0] == '.') continue;
+    if (!is_genome_file(ent->d_name)) continue;
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", dir_path, ent->d_name);
+    if (targets_contains(targets, path)) continue;
+
+    if (targets->count == targets->capacity) {
+      size_t capacity = targets->capacity ? targets->capacity * 2 : 8;
+      RelayTarget *items = (RelayTarget *)realloc(targets->items, capacity * sizeof(RelayTarget));
+      if (!items) break;
+      targets->items = items;
+      targets->capacity = capacity;
+    }
+    RelayTarget *t = &targets->items[targets->count++];
+    memset(t, 0, sizeof(*t));
+    snprintf(t->path, sizeof(t->path), "%s", path);
+    target_open(t, key, key_len);
+  }
+  closedir(dir);
+  return 0;
+}
+
+static void targets_close(RelayTargets *targets) {
+  for (size_t i = 0; i < targets->count; ++i) {
+    if (targets->items[i].open) kg_close(&targets->items[i].genome);
+  }
+  free(targets->items);
+  memset(targets, 0, sizeof(*targets));
+}
+
+static void targets_append(RelayTargets *targets, const unsigned char *key, size_t key_len,
+                           const RelayEvent *events, size_t count) {
+  if (count == 0) return;
+  const char *types[RELAY_DEFAULT_BATCH];
+  const char *payloads[RELAY_DEFAULT_BATCH];
+
+  for (size_t t = 0; t < targets->count; ++t) {
+    RelayTarget *target = &targets->items[t];
+    if (target_sync(target, key, key_len) != 0) continue;
+    for (size_t done = 0; done < count;) {
+      size_t chunk = count - done;
+      if (chunk > RELAY_DEFAULT_BATCH) chunk = RELAY_DEFAULT_BATCH;
+      for (size_t i = 0; i < chunk; ++i) {
+        types[i] = events[done + i].event_type;
+        payloads[i] = events[done + i].payload;
+      }
+      if (kg_append_batch(&target->genome, types, payloads, chunk) != 0) {
+        fprintf(stderr, "[relay] append failed: %s\n", target->path);
+        kg_close(&target->genome);
+        target->open = 0;
+        break;
+      }
+      done += chunk;
+    }
+  }
+}
+
+/* ------------------------------ Source ------------------------------ */
+
+static unsigned long long block_index(const unsigned char *bytes) {
+  unsigned long long idx = 0ULL;
+  for (int i = 0; i < 8; ++i) {
+    idx = (idx << 8) | (unsigned long long)bytes[i];
+  }
+  return idx;
+}
+
+static void source_close(RelaySource *src) {
+  if (src->file) fclose(src->file);
+  src->file = NULL;
+}
+
+/* Opens the source and positions it at next_index. Blocks are fixed-size
+ * and numbered from 0, so the offset is computed; a mismatching index
+ * (file rewritten) falls back to a scan from the start. */
+static int source_open(RelaySource *src) {
+  source_close(src);
+  src->file = fopen(src->path, "rb");
+  if (!src->file) return -1;
+  struct stat st;
+  if (fstat(fileno(src->file), &st) == 0) {
+    src->dev = st.st_dev;
+    src->ino = st.st_ino;
+  }
+
+  unsigned char bytes[KOLIBRI_BLOCK_SIZE];
+  off_t offset = (off_t)(src->next_index * KOLIBRI_BLOCK_SIZE);
+  if (src->next_index == 0 || fseeko(src->file, offset, SEEK_SET) != 0) {
+    rewind(src->file);
+    return 0;
+  }
+  if (fread(bytes, 1, KOLIBRI_BLOCK_SIZE, src->file) == KOLIBRI_BLOCK_SIZE &&
+      block_index(bytes) != src->next_index) {
+    rewind(src->file);
+    return 0;
+  }
+  fseeko(src->file, offset, SEEK_SET);
+  return 0;
+}
+
+/* Source replaced (rotation, re-creation): reopen on the new inode */
+static int source_replaced(const RelaySource *src) {
+  struct stat st;
+  if (stat(src->path, &st) != 0) return 0;
+  return !src->file || st.st_dev != src->dev || st.st_ino != src->ino;
+}
+
+/* Reads up to max relayable events; returns how many were stored */
+static size_t source_read(RelaySource *src, RelayEvent *events, size_t max, int *eof) {
+  unsigned char bytes[KOLIBRI_BLOCK_SIZE];
+  size_t count = 0;
+  *eof = 0;
+  while (count < max) {
+    off_t pos = ftello(src->file);
+    size_t got = fread(bytes, 1, KOLIBRI_BLOCK_SIZE, src->file);
+    if (got != KOLIBRI_BLOCK_SIZE) {
+      /* Неполный блок ещё дописывается: вернёмся к нему позже */
+      clearerr(src->file);
+      if (pos >= 0) fseeko(src->file, pos, SEEK_SET);
+      *eof = 1;
+      break;
+    }
+    unsigned long long idx = block_index(bytes);
+    if (idx < src->next_index) continue;
+
+    const char *type = (const char *)bytes + 16 + KOLIBRI_HASH_SIZE * 2;
+    src->next_index = idx + 1ULL;
+    /* Filter events */
+    if (strncmp(type, "TEACH", 5) != 0 && strncmp(type, "USER_FEEDBACK", 13) != 0) {
+      continue;
+    }
+    RelayEvent *ev = &events[count++];
+    memcpy(ev->event_type, type, KOLIBRI_EVENT_TYPE_SIZE);
+    memcpy(ev->payload, type + KOLIBRI_EVENT_TYPE_SIZE, KOLIBRI_PAYLOAD_SIZE);
+    ev->event_type[KOLIBRI_EVENT_TYPE_SIZE] = '\0';
+    ev->payload[KOLIBRI_PAYLOAD_SIZE] = '\0';
+  }
+  return count;
+}
+
+static void save_offset(const char *path, unsigned long long next_index) {
+  char tmp[600];
+  snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+  FILE *ofs = fopen(tmp, "w");
+  if (!ofs) return;
+  fprintf(ofs, "%llu\n", next_index);
+  if (fclose(ofs) == 0) {
+    rename(tmp, path);
+  } else {
+    unlink(tmp);
+  }
+}
+
+/* Relays everything available now; returns the number of events relayed */
+static unsigned long long relay_pending(RelaySource *src, RelayTargets *targets,
+                                        const unsigned char *key, size_t key_len,
+                                        RelayEvent *events, size_t batch,
+                                        const char *offset_path) {
+  unsigned long long processed = 0ULL;
+  if (!src->file || source_replaced(src)) {
+    if (source_open(src) != 0) return 0;
+  }
+  int eof = 0;
+  while (!eof && !g_stop) {
+    unsigned long long before = src->next_index;
+    size_t count = source_read(src, events, batch, &eof);
+    targets_append(targets, key, key_len, events, count);
+    processed += count;
+    if (src->next_index != before) save_offset(offset_path, src->next_index);
+  }
+  return processed;
+}
+
+/* ------------------------------ Watch ------------------------------- */
+
+static void dir_of(const char *path, char *out, size_t out_len) {
+  const char *slash = strrchr(path, '/');
+  if (!slash) {
+    snprintf(out, out_len, ".");
+  } else if (slash == path) {
+    snprintf(out, out_len, "/");
+  } else {
+    snprintf(out, out_len, "%.*s", (int)(slash - path), path);
+  }
+}
+
+static int watch_setup(const char *source_path, const char *targets_dir) {
+  int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (fd < 0) {
+    fprintf(stderr, "[relay] inotify unavailable, polling: %s\n", strerror(errno));
+    return -1;
+  }
+  char source_dir[512];
+  dir_of(source_path, source_dir, sizeof(source_dir));
+  /* Каталог, а не файл: переживает пересоздание и ротацию источника */
+  if (inotify_add_watch(fd, source_dir, IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE | IN_MOVED_TO) < 0 ||
+      inotify_add_watch(fd, targets_dir, IN_CREATE | IN_MOVED_TO) < 0) {
+    fprintf(stderr, "[relay] inotify watch failed, polling: %s\n", strerror(errno));
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static void watch_wait(int fd, int interval_ms) {
+  struct pollfd pfd = {.fd = fd, .events = POLLIN, .revents = 0};
+  if (fd < 0) {
+    poll(NULL, 0, interval_ms);
+    return;
+  }
+  if (poll(&pfd, 1, interval_ms) > 0) {
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    while (read(fd, buffer, sizeof(buffer)) > 0) {
+    }
+  }
+}
+
 int main(int argc, char **argv) {
   const char *source_path = ".kolibri/knowledge_genome.dat";
   const char *targets_dir = "build/cluster";
   const char *target_key_path = "build/cluster/swarm.key";
   const char *target_key_inline = NULL;
   const char *offset_path = ".kolibri/knowledge_relay.offset";
+  int watch = 0;
+  int interval_ms = RELAY_DEFAULT_INTERVAL_MS;
+  size_t batch = RELAY_DEFAULT_BATCH;
 
   for (int i = 1; i < argc; ++i) {
     if (strcmp(argv[i], "--source") == 0 && i + 1 < argc) {
@@ -70,8 +366,23 @@ int main(int argc, char **argv) {
       offset_path = argv[++i];
       continue;
     }
+    if (strcmp(argv[i], "--watch") == 0) {
+      watch = 1;
+      continue;
+    }
+    if (strcmp(argv[i], "--interval-ms") == 0 && i + 1 < argc) {
+      interval_ms = atoi(argv[++i]);
+      if (interval_ms <= 0) interval_ms = RELAY_DEFAULT_INTERVAL_MS;
+      continue;
+    }
+    if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+      long value = atol(argv[++i]);
+      batch = value > 0 ? (size_t)value : RELAY_DEFAULT_BATCH;
+      continue;
+    }
     if (strcmp(argv[i], "--help") == 0) {
-      printf("Usage: %s [--source PATH] [--targets-dir DIR] [--target-key FILE] [--offset FILE]\n", argv[0]);
+      printf("Usage: %s [--source PATH] [--targets-dir DIR] [--target-key FILE] [--offset FILE]\n"
+             "          [--watch] [--interval-ms N] [--batch N]\n", argv[0]);
       return 0;
     }
   }
@@ -90,78 +401,67 @@ int main(int argc, char **argv) {
     }
   }
 
-  FILE *src = fopen(source_path, "rb");
-  if (!src) {
-    fprintf(stderr, "[relay] cannot open source %s: %s\n", source_path, strerror(errno));
-    return 1;
-  }
+  RelaySource src;
+  memset(&src, 0, sizeof(src));
+  src.path = source_path;
 
-  unsigned long long start_index = 0ULL;
   FILE *ofs = fopen(offset_path, "r");
   if (ofs) {
-    if (fscanf(ofs, "%llu", &start_index) != 1) {
-      start_index = 0ULL;
+    if (fscanf(ofs, "%llu", &src.next_index) != 1) {
+      src.next_index = 0ULL;
     }
     fclose(ofs);
   }
 
-  /* Iterate over fixed-size blocks */
-  unsigned char bytes[KOLIBRI_BLOCK_SIZE];
-  unsigned long long processed = 0ULL;
+  if (source_open(&src) != 0 && !watch) {
+    fprintf(stderr, "[relay] cannot open source %s: %s\n", source_path, strerror(errno));
+    return 1;
+  }
 
-  /* Skip blocks below start_index by reading and counting */
-  while (fread(bytes, 1, KOLIBRI_BLOCK_SIZE, src) == KOLIBRI_BLOCK_SIZE) {
-    /* Deserialize minimal fields: index, event_type, payload */
-    unsigned long long idx = 0ULL;
-    for (int i = 0; i < 8; ++i) {
-      idx = (idx << 8) | (unsigned long long)bytes[i];
-    }
-    if (idx < start_index) {
-      continue;
-    }
+  RelayEvent *events = (RelayEvent *)malloc(batch * sizeof(RelayEvent));
+  if (!events) {
+    source_close(&src);
+    return 1;
+  }
 
-    char event_type[KOLIBRI_EVENT_TYPE_SIZE + 1];
-    char payload[KOLIBRI_PAYLOAD_SIZE + 1];
-    memset(event_type, 0, sizeof(event_type));
-    memset(payload, 0, sizeof(payload));
-    memcpy(event_type, bytes + 16 + KOLIBRI_HASH_SIZE * 2, KOLIBRI_EVENT_TYPE_SIZE);
-    memcpy(payload, bytes + 16 + KOLIBRI_HASH_SIZE * 2 + KOLIBRI_EVENT_TYPE_SIZE, KOLIBRI_PAYLOAD_SIZE);
-    event_type[KOLIBRI_EVENT_TYPE_SIZE] = '\0';
-    payload[KOLIBRI_PAYLOAD_SIZE] = '\0';
+  RelayTargets targets;
+  memset(&targets, 0, sizeof(targets));
+  int targets_ok = targets_scan(&targets, targets_dir, target_key, target_key_len) == 0;
 
-    /* Filter events */
-    if (strncmp(event_type, "TEACH", 5) != 0 && strncmp(event_type, "USER_FEEDBACK", 13) != 0) {
-      start_index = idx + 1ULL;
-      continue;
+  unsigned long long processed = 0ULL;
+  if (!watch) {
+    if (targets_ok) {
+      processed = relay_pending(&src, &targets, target_key, target_key_len,
+                                events, batch, offset_path);
     }
+  } else {
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
 
-    /* Broadcast to all genomes in targets_dir */
-    DIR *dir = opendir(targets_dir);
-    if (!dir) {
-      fprintf(stderr, "[relay] cannot open targets-dir %s\n", targets_dir);
-      break;
-    }
-    struct dirent *ent;
-    while ((ent = readdir(dir)) != NULL) {
-      if (ent->d_name[0] == '.') continue;
-      if (!is_genome_file(ent->d_name)) continue;
-      char path[512];
-      snprintf(path, sizeof(path), "%s/%s", targets_dir, ent->d_name);
-      relay_event_to_target(path, target_key, target_key_len, event_type, payload);
+    int fd = watch_setup(source_path, targets_dir);
+    while (!g_stop) {
+      if (targets_scan(&targets, targets_dir, target_key, target_key_len) == 0) {
+        unsigned long long n = relay_pending(&src, &targets, target_key, target_key_len,
+                                             events, batch, offset_path);
+        if (n > 0) {
+          printf("[relay] relayed %llu events\n", n);
+          fflush(stdout);
+        }
+        processed += n;
+      }
+      watch_wait(fd, interval_ms);
     }
-    closedir(dir);
-
-    start_index = idx + 1ULL;
-    processed += 1ULL;
+    if (fd >= 0) close(fd);
   }
 
-  fclose(src);
-
-  ofs = fopen(offset_path, "w");
-  if (ofs) {
-    fprintf(ofs, "%llu\n", start_index);
-    fclose(ofs);
-  }
+  targets_close(&targets);
+  source_close(&src);
+  free(events);
+  save_offset(offset_path, src.next_index);
 
   printf("[relay] processed %llu events\n", processed);
   return 0;
@@ -2,23 +2,38 @@
  * Copyright (c) 2025 Кочуров Владислав Евгеньевич
  */
 
+#define _GNU_SOURCE
+
 #include "kolibri/decimal.h"
 #include "kolibri/formula.h"
+#include "kolibri/formula_snapshot.h"
 #include "kolibri/genome.h"
 #include "kolibri/net.h"
 #include "kolibri/script.h"
 #include <ctype.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <inttypes.h>
+#include <signal.h>
+#include <stdarg.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/epoll.h>
 #include <sys/select.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
 #include <sys/time.h>
+#include <sys/timerfd.h>
+#include <sys/un.h>
+#include <unistd.h>
 
 
 #define KOLIBRI_MEMORY_CAPACITY 8192U
+/* Поколений за один запрос демона: :tick выполняется прямо в цикле событий */
+#define NODE_DAEMON_MAX_GENERATIONS 64
 
 typedef enum {
     KOLIBRI_KEY_SOURCE_DEFAULT,
@@ -45,6 +60,12 @@ typedef struct {
     bool auto_learn;
     uint32_t auto_evolve_ms;
     uint32_t auto_sync_ms;
+    bool daemon;
+    bool show_help;
+    char rpc_path[108];
+    bool snapshot_enabled;
+    char snapshot_path[272];
+    uint32_t snapshot_ms;
 } KolibriNodeOptions;
 
 typedef struct {
@@ -67,6 +88,10 @@ typedef struct {
     char hmac_key_origin[320];
     uint64_t last_evolve_ms;
     uint64_t last_sync_ms;
+    FILE *reply;
+    char snapshot_path[272];
+    uint64_t snapshot_index;
+    uint64_t last_snapshot_ms;
 } KolibriNode;
 
 static const unsigned char KOLIBRI_HMAC_KEY[] = "kolibri-secret-key";
@@ -91,6 +116,13 @@ static void options_init(KolibriNodeOptions *options) {
     options->auto_learn = true;
     options->auto_evolve_ms = 500U;
     options->auto_sync_ms = 2000U;
+    options->daemon = false;
+    options->show_help = false;
+    strncpy(options->rpc_path, "kolibri_node.sock", sizeof(options->rpc_path) - 1);
+    options->rpc_path[sizeof(options->rpc_path) - 1] = '\0';
+    options->snapshot_enabled = true;
+    options->snapshot_path[0] = '\0';
+    options->snapshot_ms = 30000U;
 }
 
 static void parse_options(int argc, char **argv, KolibriNodeOptions *options) {
@@ -195,9 +227,62 @@ static void parse_options(int argc, char **argv, KolibriNodeOptions *options) {
             ++i;
             continue;
         }
+        if (strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc) {
+            strncpy(options->snapshot_path, argv[i + 1],
+                    sizeof(options->snapshot_path) - 1);
+            options->snapshot_path[sizeof(options->snapshot_path) - 1] = '\0';
+            options->snapshot_enabled = true;
+            ++i;
+            continue;
+        }
+        if (strcmp(argv[i], "--snapshot-ms") == 0 && i + 1 < argc) {
+            options->snapshot_ms = (uint32_t)strtoul(argv[i + 1], NULL, 10);
+            ++i;
+            continue;
+        }
+        if (strcmp(argv[i], "--no-snapshot") == 0) {
+            options->snapshot_enabled = false;
+            continue;
+        }
+        if (strcmp(argv[i], "--daemon") == 0) {
+            options->daemon = true;
+            continue;
+        }
+        if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            options->show_help = true;
+            continue;
+        }
+        if (strcmp(argv[i], "--rpc") == 0 && i + 1 < argc) {
+            strncpy(options->rpc_path, argv[i + 1], sizeof(options->rpc_path) - 1);
+            options->rpc_path[sizeof(options->rpc_path) - 1] = '\0';
+            options->daemon = true;
+            ++i;
+            continue;
+        }
     }
 }
 
+static void print_usage(void) {
+    printf("Использование: kolibri_node [параметры]\n"
+           "  --seed N              зерно генератора\n"
+           "  --node-id N           номер узла в рое\n"
+           "  --listen PORT         принимать соседей на порту\n"
+           "  --peer HOST:PORT      сосед для обмена формулами\n"
+           "  --genome PATH         журнал генома (genome.dat)\n"
+           "  --verify-genome       полная проверка генома при запуске\n"
+           "  --hmac-key KEY        ключ HMAC (@файл или строка)\n"
+           "  --bootstrap PATH      сценарий KolibriScript при запуске\n"
+           "  --health              проверить состояние и выйти\n"
+           "  --no-auto-learn       отключить автоэволюцию и синхронизацию\n"
+           "  --auto-evolve-ms MS   период автоэволюции\n"
+           "  --auto-sync-ms MS     период синхронизации с соседом\n"
+           "  --snapshot PATH       файл снимка пула (<геном>.pool)\n"
+           "  --snapshot-ms MS      период записи снимка (0 - только :sync и выход)\n"
+           "  --no-snapshot         не сохранять и не загружать снимок\n"
+           "  --daemon              режим демона без REPL\n"
+           "  --rpc PATH            сокет RPC демона (kolibri_node.sock)\n");
+}
+
 static uint64_t now_ms(void) {
 #if defined(CLOCK_MONOTONIC)
     struct timespec ts;
@@ -356,6 +441,15 @@ static bool parse_int32(const char *text, int *out_value) {
     return true;
 }
 
+/* Ответ команды: в поток терминала или в ответ RPC-клиенту */
+__attribute__((format(printf, 3, 4)))
+static void node_emit(const KolibriNode *node, FILE *stream, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    vfprintf(node->reply ? node->reply : stream, format, args);
+    va_end(args);
+}
+
 static int node_record_event(KolibriNode *node, const char *event, const char *payload) {
     if (!node || !node->genome_ready) {
         return -1;
@@ -408,16 +502,16 @@ static void node_apply_feedback(KolibriNode *node, double delta, const char *rat
         return;
     }
     if (!node->last_gene_valid) {
-        printf("[Учитель] нет последнего ответа для оценки\n");
+        node_emit(node, stdout, "[Учитель] нет последнего ответа для оценки\n");
         return;
     }
     if (kf_pool_feedback(&node->pool, &node->last_gene, delta) != 0) {
-        printf("[Учитель] текущий ген уже изменился, повторите запрос\n");
+        node_emit(node, stdout, "[Учитель] текущий ген уже изменился, повторите запрос\n");
         node_reset_last_answer(node);
         return;
     }
     if (message) {
-        printf("%s\n", message);
+        node_emit(node, stdout, "%s\n", message);
     }
     char payload[128];
     snprintf(payload, sizeof(payload), "rating=%s input=%d output=%d delta=%.3f",
@@ -427,7 +521,7 @@ static void node_apply_feedback(KolibriNode *node, double delta, const char *rat
     if (best) {
         char description[128];
         if (kf_formula_describe(best, description, sizeof(description)) == 0) {
-            printf("[Формулы] %s\n", description);
+            node_emit(node, stdout, "[Формулы] %s\n", description);
         }
     }
 }
@@ -444,31 +538,37 @@ static int node_open_genome(KolibriNode *node) {
     if (!node) {
         return -1;
     }
+    /* Проверка и открытие - один проход по журналу. Без --verify-genome
+     * проверяются только блоки после подписанного состояния хвоста. */
+    KolibriGenomeOpenOptions open_options = {KG_VERIFY_TAIL, 0};
+    bool genome_missing = false;
     if (node->options.verify_genome) {
         printf("[Геном] проверяем %s (ключ: %s)\n", node->options.genome_path,
                node->hmac_key_origin);
-        int status = kg_verify_file(node->options.genome_path, node->hmac_key,
-                                    node->hmac_key_len);
-        if (status == 1) {
+        open_options.verify = KG_VERIFY_FULL;
+        if (access(node->options.genome_path, F_OK) != 0 && errno == ENOENT) {
+            genome_missing = true;
             printf("[Геном] журнал отсутствует, создаём новый (ключ: %s)\n",
                    node->hmac_key_origin);
-        } else if (status != 0) {
+        }
+    }
+    if (kg_open_ex(&node->genome, node->options.genome_path, node->hmac_key,
+                   node->hmac_key_len, &open_options) != 0) {
+        if (node->options.verify_genome) {
             fprintf(stderr,
                     "[Геном] проверка целостности провалена для %s (ключ: %s)\n",
                     node->options.genome_path, node->hmac_key_origin);
-            return -1;
         } else {
-            printf("[Геном] целостность подтверждена (ключ: %s)\n",
-                   node->hmac_key_origin);
+            fprintf(stderr,
+                    "[Геном] не удалось открыть %s (ключ: %s)\n",
+                    node->options.genome_path, node->hmac_key_origin);
         }
-    }
-    if (kg_open(&node->genome, node->options.genome_path, node->hmac_key,
-                node->hmac_key_len) != 0) {
-        fprintf(stderr,
-                "[Геном] не удалось открыть %s (ключ: %s)\n",
-                node->options.genome_path, node->hmac_key_origin);
         return -1;
     }
+    if (node->options.verify_genome && !genome_missing) {
+        printf("[Геном] целостность подтверждена (ключ: %s)\n",
+               node->hmac_key_origin);
+    }
     node->genome_ready = true;
     printf("[Геном] журнал %s открыт (ключ: %s)\n", node->options.genome_path,
            node->hmac_key_origin);
@@ -486,26 +586,112 @@ static void node_close_genome(KolibriNode *node) {
     }
 }
 
+/* ------------------------- Снимок пула формул ------------------------- */
+
+/* Доигрывает события генома [from, next_index): примеры и циклы эволюции
+ * детерминированы генератором пула, поэтому восстанавливаются точно.
+ * Оценки и импорт от соседей в журнале неполны - их сохраняет снимок. */
+static size_t node_replay_genome(KolibriNode *node, uint64_t from) {
+    size_t replayed = 0;
+    for (uint64_t index = from; index < node->genome.next_index; ++index) {
+        ReasonBlock block;
+        char text[KOLIBRI_PAYLOAD_SIZE];
+        if (kg_read_block(&node->genome, index, &block) != 0 ||
+            k_decode_text(block.payload, text, sizeof(text)) != 0) {
+            continue;
+        }
+        int input = 0;
+        int target = 0;
+        size_t generations = 0;
+        if (strcmp(block.event_type, "TEACH") == 0 &&
+            sscanf(text, "пример %d->%d", &input, &target) == 2) {
+            kf_pool_add_example(&node->pool, input, target);
+        } else if (strcmp(block.event_type, "EVOLVE") == 0 &&
+                   node->pool.examples > 0 &&
+                   (sscanf(text, "поколений=%zu", &generations) == 1 ||
+                    (strcmp(text, "автоцикл") == 0 && (generations = 1U) != 0U))) {
+            kf_pool_tick(&node->pool, generations);
+        } else {
+            continue;
+        }
+        replayed++;
+    }
+    return replayed;
+}
+
+static void node_restore_pool(KolibriNode *node) {
+    if (!node->genome_ready) {
+        return;
+    }
+    uint64_t from = 0;
+    KolibriPoolSnapshotInfo info;
+    if (node->options.snapshot_enabled &&
+        kf_pool_snapshot_load(&node->pool, node->snapshot_path, &info) == 0) {
+        if (info.genome_index <= node->genome.next_index) {
+            from = info.genome_index;
+            printf("[Снимок] пул восстановлен из %s: формул %zu, примеров %zu, "
+                   "ассоциаций %zu (блок генома %" PRIu64 ")\n",
+                   node->snapshot_path, info.formulas, info.examples,
+                   info.associations, info.genome_index);
+        } else {
+            /* Снимок новее журнала: геном заменён, доверяем журналу */
+            kf_pool_init(&node->pool, node->options.seed);
+            printf("[Снимок] %s не соответствует геному, пропускаем\n",
+                   node->snapshot_path);
+        }
+    }
+    size_t replayed = node_replay_genome(node, from);
+    if (replayed > 0) {
+        printf("[Снимок] доиграно событий генома: %zu\n", replayed);
+    }
+    node->snapshot_index = from;
+    node->last_snapshot_ms = now_ms();
+}
+
+static void node_save_snapshot(KolibriNode *node, bool verbose) {
+    if (!node->options.snapshot_enabled || !node->genome_ready) {
+        return;
+    }
+    node->last_snapshot_ms = now_ms();
+    if (node->snapshot_index == node->genome.next_index && !verbose) {
+        return;
+    }
+    KolibriPoolSnapshotInfo info;
+    if (kf_pool_snapshot_save(&node->pool, node->genome.next_index,
+                              node->snapshot_path, &info) != 0) {
+        node_emit(node, stderr, "[Снимок] не удалось записать %s\n",
+                  node->snapshot_path);
+        return;
+    }
+    node->snapshot_index = info.genome_index;
+    if (verbose) {
+        node_emit(node, stdout,
+                  "[Снимок] записан %s: %zu байт, ассоциаций %zu (уникальных %zu)\n",
+                  node->snapshot_path, info.bytes, info.associations,
+                  info.unique_associations);
+    }
+}
+
 static void node_print_canvas(const KolibriNode *node) {
     if (!node) {
         return;
     }
-    printf("== Фрактальная канва памяти ==\n");
+    node_emit(node, stdout, "== Фрактальная канва памяти ==\n");
     if (node->memory.length == 0) {
-        printf("(память пуста)\n");
+        node_emit(node, stdout, "(память пуста)\n");
         return;
     }
     size_t offset = 0;
     size_t depth = 0;
     while (offset < node->memory.length) {
-        printf("слой %zu: ", depth);
+        node_emit(node, stdout, "слой %zu: ", depth);
         for (size_t i = 0; i < 30 && offset + i < node->memory.length; ++i) {
-            printf("%u", (unsigned)node->memory.digits[offset + i]);
+            node_emit(node, stdout, "%u", (unsigned)node->memory.digits[offset + i]);
             if ((i + 1U) % 10U == 0U) {
-                printf(" ");
+                node_emit(node, stdout, " ");
             }
         }
-        printf("\n");
+        node_emit(node, stdout, "\n");
         offset += 30U;
         depth++;
     }
@@ -514,66 +700,59 @@ static void node_print_canvas(const KolibriNode *node) {
 static void node_report_formula(const KolibriNode *node) {
     const KolibriFormula *best = kf_pool_best(&node->pool);
     if (!best) {
-        printf("[Формулы] пока нет подходящих генов\n");
+        node_emit(node, stdout, "[Формулы] пока нет подходящих генов\n");
         return;
     }
     char description[128];
     if (kf_formula_describe(best, description, sizeof(description)) != 0) {
-        printf("[Формулы] не удалось построить описание\n");
+        node_emit(node, stdout, "[Формулы] не удалось построить описание\n");
         return;
     }
     uint8_t digits[32];
     size_t len = kf_formula_digits(best, digits, sizeof(digits));
-    printf("[Формулы] %s\n", description);
-    printf("[Формулы] ген: ");
+    node_emit(node, stdout, "[Формулы] %s\n", description);
+    node_emit(node, stdout, "[Формулы] ген: ");
     for (size_t i = 0; i < len; ++i) {
-        printf("%u", (unsigned)digits[i]);
+        node_emit(node, stdout, "%u", (unsigned)digits[i]);
     }
-    printf("\n");
+    node_emit(node, stdout, "\n");
 }
 
 static void node_share_formula(KolibriNode *node) {
     if (!node->options.peer_enabled) {
-        printf("[Рой] соседи не заданы\n");
+        node_emit(node, stdout, "[Рой] соседи не заданы\n");
         return;
     }
     const KolibriFormula *best = kf_pool_best(&node->pool);
     if (!best) {
-        printf("[Рой] подходящая формула отсутствует\n");
+        node_emit(node, stdout, "[Рой] подходящая формула отсутствует\n");
         return;
     }
     if (kn_share_formula(node->options.peer_host, node->options.peer_port,
                          node->options.node_id, best) == 0) {
-        printf("[Рой] формула отправлена на %s:%u\n", node->options.peer_host,
-               node->options.peer_port);
+        node_emit(node, stdout, "[Рой] формула отправлена на %s:%u\n",
+                  node->options.peer_host, node->options.peer_port);
         node_record_event(node, "SYNC", "передан лучший ген");
     } else {
-        fprintf(stderr, "[Рой] не удалось отправить формулу\n");
+        node_emit(node, stderr, "[Рой] не удалось отправить формулу\n");
     }
 }
 
-static void node_poll_listener(KolibriNode *node) {
-    if (!node->listener_ready) {
-        return;
-    }
-    KolibriNetMessage message;
-    int status = kn_listener_poll(&node->listener, 0U, &message);
-    if (status <= 0) {
-        return;
-    }
-    switch (message.type) {
+static void node_handle_peer_message(KolibriNode *node,
+                                     const KolibriNetMessage *message) {
+    switch (message->type) {
     case KOLIBRI_MSG_HELLO:
-        printf("[Рой] приветствие от узла %u\n", message.data.hello.node_id);
+        printf("[Рой] приветствие от узла %u\n", message->data.hello.node_id);
         break;
     case KOLIBRI_MSG_MIGRATE_RULE: {
         KolibriFormula imported;
-        imported.gene.length = message.data.formula.length;
+        imported.gene.length = message->data.formula.length;
         if (imported.gene.length > sizeof(imported.gene.digits)) {
             imported.gene.length = sizeof(imported.gene.digits);
         }
-        memcpy(imported.gene.digits, message.data.formula.digits,
+        memcpy(imported.gene.digits, message->data.formula.digits,
                imported.gene.length);
-        imported.fitness = message.data.formula.fitness;
+        imported.fitness = message->data.formula.fitness;
         imported.feedback = 0.0;
 
         char digits_text[33];
@@ -594,12 +773,12 @@ static void node_poll_listener(KolibriNode *node) {
         bool preview_ok = kf_formula_apply(&imported, 4, &preview) == 0;
         if (preview_ok) {
             printf("[Рой] получен ген от узла %u %s fitness=%.3f f(4)=%d\n",
-                   message.data.formula.node_id, description,
-                   message.data.formula.fitness, preview);
+                   message->data.formula.node_id, description,
+                   message->data.formula.fitness, preview);
         } else {
             printf("[Рой] получен ген от узла %u %s fitness=%.3f\n",
-                   message.data.formula.node_id, description,
-                   message.data.formula.fitness);
+                   message->data.formula.node_id, description,
+                   message->data.formula.fitness);
         }
         if (node->pool.count > 0) {
             size_t slot = node->pool.count - 1U;
@@ -610,31 +789,45 @@ static void node_poll_listener(KolibriNode *node) {
         break;
     }
     case KOLIBRI_MSG_ACK:
-        printf("[Рой] ACK=%u\n", message.data.ack.status);
+        printf("[Рой] ACK=%u\n", message->data.ack.status);
         break;
     }
 }
 
+static void node_poll_listener(KolibriNode *node) {
+    if (!node->listener_ready) {
+        return;
+    }
+    KolibriNetMessage message;
+    int status = kn_listener_poll(&node->listener, 0U, &message);
+    if (status <= 0) {
+        return;
+    }
+    node_handle_peer_message(node, &message);
+}
+
 static void node_handle_tick(KolibriNode *node, size_t generations) {
     if (node->pool.examples == 0) {
-        printf("[Формулы] нет обучающих примеров\n");
+        node_emit(node, stdout, "[Формулы] нет обучающих примеров\n");
         return;
     }
     kf_pool_tick(&node->pool, generations);
-    printf("[Формулы] выполнено поколений: %zu\n", generations);
-    node_record_event(node, "EVOLVE", "цикл выполнен");
+    node_emit(node, stdout, "[Формулы] выполнено поколений: %zu\n", generations);
+    char payload[32];
+    snprintf(payload, sizeof(payload), "поколений=%zu", generations);
+    node_record_event(node, "EVOLVE", payload);
     node_reset_last_answer(node);
 }
 
 static void node_execute_script(KolibriNode *node, const char *path) {
     if (!node || !path || path[0] == '\0') {
-        printf("[KolibriScript] требуется путь к файлу\n");
+        node_emit(node, stdout, "[KolibriScript] требуется путь к файлу\n");
         return;
     }
 
     if (!node->script_ready) {
         if (ks_init(&node->script, &node->pool, node->genome_ready ? &node->genome : NULL) != 0) {
-            fprintf(stderr, "[KolibriScript] не удалось инициализировать интерпретатор\n");
+            node_emit(node, stderr, "[KolibriScript] не удалось инициализировать интерпретатор\n");
             return;
         }
         node->script_ready = true;
@@ -643,24 +836,24 @@ static void node_execute_script(KolibriNode *node, const char *path) {
         node->script.genome = node->genome_ready ? &node->genome : NULL;
     }
 
-    ks_set_output(&node->script, stdout);
+    ks_set_output(&node->script, node->reply ? node->reply : stdout);
     if (ks_load_file(&node->script, path) != 0) {
-        fprintf(stderr, "[KolibriScript] не удалось загрузить сценарий %s\n", path);
+        node_emit(node, stderr, "[KolibriScript] не удалось загрузить сценарий %s\n", path);
         return;
     }
     if (ks_execute(&node->script) != 0) {
-        fprintf(stderr, "[KolibriScript] выполнение завершилось ошибкой для %s\n", path);
+        node_emit(node, stderr, "[KolibriScript] выполнение завершилось ошибкой для %s\n", path);
         return;
     }
 
     node_record_event(node, "SCRIPT", path);
-    printf("[KolibriScript] сценарий выполнен: %s\n", path);
+    node_emit(node, stdout, "[KolibriScript] сценарий выполнен: %s\n", path);
     node_reset_last_answer(node);
 }
 
 static void node_handle_teach(KolibriNode *node, const char *payload) {
     if (!payload || payload[0] == '\0') {
-        printf("[Учитель] требуется пример формата a->b\n");
+        node_emit(node, stdout, "[Учитель] требуется пример формата a->b\n");
         return;
     }
     char buffer[256];
@@ -676,83 +869,197 @@ static void node_handle_teach(KolibriNode *node, const char *payload) {
         int input = 0;
         int target = 0;
         if (!parse_int32(buffer, &input) || !parse_int32(rhs, &target)) {
-            printf("[Учитель] не удалось разобрать числа\n");
+            node_emit(node, stdout, "[Учитель] не удалось разобрать числа\n");
             return;
         }
         if (kf_pool_add_example(&node->pool, input, target) != 0) {
-            printf("[Учитель] буфер примеров заполнен\n");
+            node_emit(node, stdout, "[Учитель] буфер примеров заполнен\n");
             return;
         }
         node_store_text(node, payload);
-        node_record_event(node, "TEACH", "пример добавлен");
+        char example[64];
+        snprintf(example, sizeof(example), "пример %d->%d", input, target);
+        node_record_event(node, "TEACH", example);
         node_handle_tick(node, 8);
         return;
     }
     node_store_text(node, payload);
     node_record_event(node, "NOTE", "произвольный импульс сохранён");
-    printf("[Учитель] сохранён числовой импульс\n");
+    node_emit(node, stdout, "[Учитель] сохранён числовой импульс\n");
 }
 
 static void node_handle_ask(KolibriNode *node, const char *payload) {
     if (!payload || payload[0] == '\0') {
-        printf("[Вопрос] требуется аргумент\n");
+        node_emit(node, stdout, "[Вопрос] требуется аргумент\n");
         return;
     }
     int value = 0;
     if (!parse_int32(payload, &value)) {
-        printf("[Вопрос] ожидалось целое число\n");
+        node_emit(node, stdout, "[Вопрос] ожидалось целое число\n");
         return;
     }
     const KolibriFormula *best = kf_pool_best(&node->pool);
     if (!best) {
-        printf("[Вопрос] эволюция ещё не дала формулы\n");
+        node_emit(node, stdout, "[Вопрос] эволюция ещё не дала формулы\n");
         return;
     }
     int result = 0;
     if (kf_formula_apply(best, value, &result) != 0) {
-        printf("[Вопрос] формула не смогла ответить\n");
+        node_emit(node, stdout, "[Вопрос] формула не смогла ответить\n");
         return;
     }
-    printf("[Ответ] f(%d) = %d\n", value, result);
+    node_emit(node, stdout, "[Ответ] f(%d) = %d\n", value, result);
     node->last_gene = best->gene;
     node->last_gene_valid = true;
     node->last_question = value;
     node->last_answer = result;
     char description[128];
     if (kf_formula_describe(best, description, sizeof(description)) == 0) {
-        printf("[Пояснение] %s\n", description);
+        node_emit(node, stdout, "[Пояснение] %s\n", description);
     }
     node_record_event(node, "ASK", "вопрос обработан");
 }
 
 static void node_handle_verify(KolibriNode *node) {
-    printf("[Геном] проверяем %s (ключ: %s)\n", node->options.genome_path,
-           node->hmac_key_origin);
+    node_emit(node, stdout, "[Геном] проверяем %s (ключ: %s)\n",
+              node->options.genome_path, node->hmac_key_origin);
     int status = kg_verify_file(node->options.genome_path, node->hmac_key,
                                 node->hmac_key_len);
     if (status == 0) {
-        printf("[Геном] проверка завершилась успехом\n");
+        node_emit(node, stdout, "[Геном] проверка завершилась успехом\n");
     } else if (status == 1) {
-        printf("[Геном] файл отсутствует\n");
+        node_emit(node, stdout, "[Геном] файл отсутствует\n");
     } else {
-        printf("[Геном] обнаружено повреждение\n");
+        node_emit(node, stdout, "[Геном] обнаружено повреждение\n");
     }
 }
 
-static void node_print_help(void) {
-    printf(":teach a->b — добавить обучающий пример\n");
-    printf(":ask x — вычислить значение лучшей формулы\n");
-    printf(":good — поощрить последнюю формулу за ответ\n");
-    printf(":bad — наказать последнюю формулу\n");
-    printf(":tick [n] — выполнить n поколений (по умолчанию 1)\n");
-    printf(":evolve [n] — форсировать дополнительную эволюцию\n");
-    printf(":why — показать текущую формулу\n");
-    printf(":canvas — вывести канву памяти\n");
-    printf(":sync — поделиться формулой с соседом\n");
-    printf(":verify — проверить геном\n");
-    printf(":script <файл> — выполнить KolibriScript из файла\n");
-    printf(":fractal — показать фрактальную канву памяти\n");
-    printf(":quit — завершить работу\n");
+static void node_print_help(const KolibriNode *node) {
+    node_emit(node, stdout, ":teach a->b — добавить обучающий пример\n");
+    node_emit(node, stdout, ":ask x — вычислить значение лучшей формулы\n");
+    node_emit(node, stdout, ":good — поощрить последнюю формулу за ответ\n");
+    node_emit(node, stdout, ":bad — наказать последнюю формулу\n");
+    node_emit(node, stdout, ":tick [n] — выполнить n поколений (по умолчанию 1)\n");
+    node_emit(node, stdout, ":evolve [n] — форсировать дополнительную эволюцию\n");
+    node_emit(node, stdout, ":why — показать текущую формулу\n");
+    node_emit(node, stdout, ":canvas — вывести канву памяти\n");
+    node_emit(node, stdout, ":sync — поделиться формулой с соседом и записать снимок пула\n");
+    node_emit(node, stdout, ":verify — проверить геном\n");
+    node_emit(node, stdout, ":script <файл> — выполнить KolibriScript из файла\n");
+    node_emit(node, stdout, ":fractal — показать фрактальную канву памяти\n");
+    node_emit(node, stdout, ":quit — завершить работу\n");
+}
+
+typedef enum {
+    NODE_COMMAND_DONE,
+    NODE_COMMAND_UNKNOWN,
+    NODE_COMMAND_QUIT
+} NodeCommandStatus;
+
+/* Одна строка REPL: директива ":имя аргументы" или свободный текст */
+static NodeCommandStatus node_dispatch(KolibriNode *node, const char *line) {
+    if (line[0] != ':') {
+        node_store_text(node, line);
+        node_record_event(node, "NOTE", "свободный текст сохранён");
+        return NODE_COMMAND_DONE;
+    }
+    const char *command = line + 1;
+    while (*command && !isspace((unsigned char)*command)) {
+        ++command;
+    }
+    size_t prefix = (size_t)(command - (line + 1));
+    char name[32];
+    if (prefix >= sizeof(name)) {
+        prefix = sizeof(name) - 1U;
+    }
+    memcpy(name, line + 1, prefix);
+    name[prefix] = '\0';
+    while (*command && isspace((unsigned char)*command)) {
+        ++command;
+    }
+    if (strcmp(name, "teach") == 0) {
+        node_handle_teach(node, command);
+        return NODE_COMMAND_DONE;
+    }
+    if (strcmp(name, "ask") == 0) {
+        node_handle_ask(node, command);
+        return NODE_COMMAND_DONE;
+    }
+    if (strcmp(name, "good") == 0) {
+        node_handle_good(node);
+        return NODE_COMMAND_DONE;
+    }
+    if (strcmp(name, "bad") == 0) {
+        node_handle_bad(node);
+        return NODE_COMMAND_DONE;
+    }
+    if (strcmp(name, "tick") == 0 || strcmp(name, "evolve") == 0) {
+        int gens = strcmp(name, "tick") == 0 ? 1 : 32;
+        if (command[0] != '\0') {
+            if (!parse_int32(command, &gens) || gens <= 0) {
+                node_emit(node, stdout, "[Формулы] ожидалось натуральное число\n");
+                return NODE_COMMAND_DONE;
+            }
+        }
+        if (node->options.daemon && gens > NODE_DAEMON_MAX_GENERATIONS) {
+            node_emit(node, stdout, "[Формулы] в режиме демона не более %d поколений за запрос\n",
+                      NODE_DAEMON_MAX_GENERATIONS);
+            gens = NODE_DAEMON_MAX_GENERATIONS;
+        }
+        node_handle_tick(node, (size_t)gens);
+        return NODE_COMMAND_DONE;
+    }
+    if (strcmp(name, "why") == 0) {
+        node_report_formula(node);
+        return NODE_COMMAND_DONE;
+    }
+    if (strcmp(name, "canvas") == 0 || strcmp(name, "fractal") == 0) {
+        node_print_canvas(node);
+        return NODE_COMMAND_DONE;
+    }
+    if (strcmp(name, "sync") == 0) {
+        node_share_formula(node);
+        node_save_snapshot(node, true);
+        return NODE_COMMAND_DONE;
+    }
+    if (strcmp(name, "verify") == 0) {
+        node_handle_verify(node);
+        return NODE_COMMAND_DONE;
+    }
+    if (strcmp(name, "script") == 0) {
+        if (command[0] == '\0') {
+            node_emit(node, stdout, "[KolibriScript] требуется путь к файлу\n");
+            return NODE_COMMAND_DONE;
+        }
+        node_execute_script(node, command);
+        return NODE_COMMAND_DONE;
+    }
+    if (strcmp(name, "help") == 0) {
+        node_print_help(node);
+        return NODE_COMMAND_DONE;
+    }
+    if (strcmp(name, "quit") == 0 || strcmp(name, "exit") == 0) {
+        node_emit(node, stdout, "[Сессия] завершение работы по команде\n");
+        return NODE_COMMAND_QUIT;
+    }
+    node_emit(node, stdout, "[Команда] неизвестная директива %s\n", name);
+    return NODE_COMMAND_UNKNOWN;
+}
+
+static void node_auto_evolve(KolibriNode *node) {
+    node->last_evolve_ms = now_ms();
+    if (node->pool.examples == 0) {
+        return;
+    }
+    kf_pool_tick(&node->pool, 1);
+    node_record_event(node, "EVOLVE", "автоцикл");
+}
+
+static void node_auto_sync(KolibriNode *node) {
+    node->last_sync_ms = now_ms();
+    if (node->options.peer_enabled) {
+        node_share_formula(node);
+    }
 }
 
 static void node_run(KolibriNode *node) {
@@ -792,112 +1099,589 @@ static void node_run(KolibriNode *node) {
                 continue;
             }
             node_poll_listener(node);
-            if (line[0] == ':') {
-            const char *command = line + 1;
-            while (*command && !isspace((unsigned char)*command)) {
-                ++command;
-            }
-            size_t prefix = (size_t)(command - (line + 1));
-            char name[32];
-            strncpy(name, line + 1, prefix);
-            name[prefix] = '\0';
-            while (*command && isspace((unsigned char)*command)) {
-                ++command;
-            }
-            if (strcmp(name, "teach") == 0) {
-                node_handle_teach(node, command);
-                continue;
-            }
-            if (strcmp(name, "ask") == 0) {
-                node_handle_ask(node, command);
-                continue;
-            }
-            if (strcmp(name, "good") == 0) {
-                node_handle_good(node);
-                continue;
-            }
-            if (strcmp(name, "bad") == 0) {
-                node_handle_bad(node);
-                continue;
+            if (node_dispatch(node, line) == NODE_COMMAND_QUIT) {
+                break;
             }
-            if (strcmp(name, "tick") == 0) {
-                int gens = 1;
-                if (command[0] != '\0') {
-                    if (!parse_int32(command, &gens) || gens <= 0) {
-                        printf("[Формулы] ожидалось натуральное число\n");
-                        continue;
-                    }
+        } else {
+            if (node->options.auto_learn) {
+                uint64_t now = now_ms();
+                if ((now - node->last_evolve_ms) >= node->options.auto_evolve_ms) {
+                    node_auto_evolve(node);
                 }
-                node_handle_tick(node, (size_t)gens);
-                continue;
-            }
-            if (strcmp(name, "evolve") == 0) {
-                int gens = 32;
-                if (command[0] != '\0') {
-                    if (!parse_int32(command, &gens) || gens <= 0) {
-                        printf("[Формулы] ожидалось натуральное число\n");
-                        continue;
-                    }
+                if ((now - node->last_sync_ms) >= node->options.auto_sync_ms) {
+                    node_auto_sync(node);
                 }
-                node_handle_tick(node, (size_t)gens);
-                continue;
-            }
-            if (strcmp(name, "why") == 0) {
-                node_report_formula(node);
-                continue;
             }
-            if (strcmp(name, "canvas") == 0) {
-                node_print_canvas(node);
-                continue;
-            }
-            if (strcmp(name, "sync") == 0) {
-                node_share_formula(node);
-                continue;
+            if (node->options.snapshot_ms > 0U &&
+                (now_ms() - node->last_snapshot_ms) >= node->options.snapshot_ms) {
+                node_save_snapshot(node, false);
             }
-            if (strcmp(name, "verify") == 0) {
-                node_handle_verify(node);
-                continue;
+        }
+    }
+}
+
+/* -------------------------- Режим демона -------------------------- */
+
+/*
+ * Демон обслуживает узел без терминала в одном потоке на epoll: порт роя,
+ * RPC-сокет Unix, таймеры автоэволюции и автосинхронизации (timerfd) и
+ * SIGINT/SIGTERM (signalfd). Все сокеты неблокирующие, поэтому медленный
+ * клиент не задерживает остальных.
+ *
+ * Кадр запроса RPC: длина u32 (big-endian) и строка в синтаксисе REPL
+ * (":teach 2->5", ":ask 3", ":tick 4", ":sync"). Кадр ответа: длина u32,
+ * байт статуса NODE_RPC_* и вывод команды. Клиент может отправить
+ * несколько запросов подряд; ответы приходят в том же порядке.
+ */
+
+#define NODE_RPC_MAX_REQUEST 4096U
+#define NODE_RPC_MAX_OUTPUT (1U << 20)
+#define NODE_RPC_FRAMES_PER_WAKE 8U
+#define NODE_MAX_CONNECTIONS 256U
+#define NODE_EPOLL_EVENTS 64
+
+enum {
+    NODE_RPC_OK = 0,
+    NODE_RPC_UNKNOWN = 1,
+    NODE_RPC_BAD_FRAME = 2,
+    NODE_RPC_STOPPING = 3
+};
+
+typedef enum {
+    NODE_WATCH_SWARM,
+    NODE_WATCH_RPC,
+    NODE_WATCH_EVOLVE,
+    NODE_WATCH_SYNC,
+    NODE_WATCH_SNAPSHOT,
+    NODE_WATCH_SIGNAL,
+    NODE_WATCH_PEER,
+    NODE_WATCH_CLIENT
+} NodeWatch;
+
+typedef struct {
+    int fd;
+    NodeWatch kind;
+    uint8_t in[4U + NODE_RPC_MAX_REQUEST];
+    size_t in_len;
+    char *out;
+    size_t out_len;
+    size_t out_sent;
+    size_t out_cap;
+    bool eof;
+    bool backlog;
+} NodeConnection;
+
+typedef struct {
+    int epoll_fd;
+    int rpc_fd;
+    int evolve_fd;
+    int sync_fd;
+    int snapshot_fd;
+    int signal_fd;
+    bool running;
+    NodeConnection *connections;
+} NodeDaemon;
+
+static uint64_t daemon_tag(NodeWatch kind, size_t slot) {
+    return ((uint64_t)kind << 32) | (uint64_t)slot;
+}
+
+static int daemon_watch(NodeDaemon *daemon, int fd, uint32_t events, NodeWatch kind,
+                        size_t slot) {
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = events;
+    event.data.u64 = daemon_tag(kind, slot);
+    return epoll_ctl(daemon->epoll_fd, EPOLL_CTL_ADD, fd, &event);
+}
+
+static int daemon_timer(NodeDaemon *daemon, uint32_t period_ms, NodeWatch kind) {
+    if (period_ms == 0U) {
+        return -1;
+    }
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    struct itimerspec spec;
+    spec.it_interval.tv_sec = period_ms / 1000U;
+    spec.it_interval.tv_nsec = (long)(period_ms % 1000U) * 1000000L;
+    spec.it_value = spec.it_interval;
+    if (timerfd_settime(fd, 0, &spec, NULL) != 0 ||
+        daemon_watch(daemon, fd, EPOLLIN, kind, 0) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int daemon_open_rpc(NodeDaemon *daemon, const char *path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "[Демон] слишком длинный путь сокета %s\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    unlink(path);
+    /* Сокет доступен только владельцу узла */
+    mode_t previous = umask(077);
+    int status = bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+    umask(previous);
+    if (status != 0 || listen(fd, SOMAXCONN) != 0 ||
+        daemon_watch(daemon, fd, EPOLLIN, NODE_WATCH_RPC, 0) != 0) {
+        fprintf(stderr, "[Демон] не удалось открыть RPC-сокет %s: %s\n", path,
+                strerror(errno));
+        close(fd);
+        return -1;
+    }
+    daemon->rpc_fd = fd;
+    return 0;
+}
+
+static void daemon_close_connection(NodeDaemon *daemon, size_t slot) {
+    NodeConnection *conn = &daemon->connections[slot];
+    if (conn->fd < 0) {
+        return;
+    }
+    epoll_ctl(daemon->epoll_fd, EPOLL_CTL_DEL, conn->fd, NULL);
+    close(conn->fd);
+    free(conn->out);
+    memset(conn, 0, sizeof(*conn));
+    conn->fd = -1;
+}
+
+/* Чтение приостанавливается, пока клиент не заберёт накопленные ответы */
+static void daemon_update_events(NodeDaemon *daemon, size_t slot) {
+    NodeConnection *conn = &daemon->connections[slot];
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    size_t pending = conn->out_len - conn->out_sent;
+    if (!conn->eof && pending < NODE_RPC_MAX_OUTPUT) {
+        event.events |= EPOLLIN;
+    }
+    if (pending > 0) {
+        event.events |= EPOLLOUT;
+    }
+    event.data.u64 = daemon_tag(conn->kind, slot);
+    epoll_ctl(daemon->epoll_fd, EPOLL_CTL_MOD, conn->fd, &event);
+}
+
+static void daemon_accept(NodeDaemon *daemon, int listen_fd, NodeWatch kind) {
+    size_t slot = 0;
+    while (true) {
+        int fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        while (slot < NODE_MAX_CONNECTIONS && daemon->connections[slot].fd >= 0) {
+            ++slot;
+        }
+        if (slot == NODE_MAX_CONNECTIONS) {
+            close(fd);
+            continue;
+        }
+        NodeConnection *conn = &daemon->connections[slot];
+        conn->fd = fd;
+        conn->kind = kind;
+        if (daemon_watch(daemon, fd, EPOLLIN, kind, slot) != 0) {
+            close(fd);
+            conn->fd = -1;
+        }
+    }
+}
+
+static int daemon_queue_reply(NodeConnection *conn, uint8_t status, const char *text,
+                              size_t text_len) {
+    size_t frame = 5U + text_len;
+    if (conn->out_sent > 0 && conn->out_sent == conn->out_len) {
+        conn->out_len = 0;
+        conn->out_sent = 0;
+    }
+    if (conn->out_len + frame > conn->out_cap) {
+        size_t cap = conn->out_cap ? conn->out_cap : 4096U;
+        while (cap < conn->out_len + frame) {
+            cap *= 2U;
+        }
+        char *grown = (char *)realloc(conn->out, cap);
+        if (!grown) {
+            return -1;
+        }
+        conn->out = grown;
+        conn->out_cap = cap;
+    }
+    uint32_t length = (uint32_t)(1U + text_len);
+    uint8_t *head = (uint8_t *)conn->out + conn->out_len;
+    head[0] = (uint8_t)(length >> 24);
+    head[1] = (uint8_t)(length >> 16);
+    head[2] = (uint8_t)(length >> 8);
+    head[3] = (uint8_t)length;
+    head[4] = status;
+    if (text_len > 0) {
+        memcpy(head + 5, text, text_len);
+    }
+    conn->out_len += frame;
+    return 0;
+}
+
+/* Выполняет запрос RPC, перенаправляя вывод команды в ответ */
+static int daemon_run_request(NodeDaemon *daemon, KolibriNode *node, NodeConnection *conn,
+                              const uint8_t *data, size_t len) {
+    char line[NODE_RPC_MAX_REQUEST + 1U];
+    if (memchr(data, '\0', len)) {
+        return daemon_queue_reply(conn, NODE_RPC_BAD_FRAME, NULL, 0);
+    }
+    memcpy(line, data, len);
+    line[len] = '\0';
+    trim_newline(line);
+    trim_spaces(line);
+    if (line[0] == '\0') {
+        return daemon_queue_reply(conn, NODE_RPC_UNKNOWN, NULL, 0);
+    }
+
+    char *text = NULL;
+    size_t text_len = 0;
+    FILE *reply = open_memstream(&text, &text_len);
+    if (!reply) {
+        return -1;
+    }
+    node->reply = reply;
+    NodeCommandStatus status = node_dispatch(node, line);
+    node->reply = NULL;
+    fclose(reply);
+
+    uint8_t code = NODE_RPC_OK;
+    if (status == NODE_COMMAND_UNKNOWN) {
+        code = NODE_RPC_UNKNOWN;
+    } else if (status == NODE_COMMAND_QUIT) {
+        code = NODE_RPC_STOPPING;
+        daemon->running = false;
+    }
+    int result = daemon_queue_reply(conn, code, text, text_len);
+    free(text);
+    return result;
+}
+
+static void daemon_consume(NodeConnection *conn, size_t used) {
+    memmove(conn->in, conn->in + used, conn->in_len - used);
+    conn->in_len -= used;
+}
+
+/* Разбирает накопленные кадры. Клиент RPC получает не больше
+ * NODE_RPC_FRAMES_PER_WAKE запросов за проход, остаток ждёт следующего */
+static int daemon_process(NodeDaemon *daemon, KolibriNode *node, size_t slot) {
+    NodeConnection *conn = &daemon->connections[slot];
+    conn->backlog = false;
+    if (conn->kind == NODE_WATCH_PEER) {
+        while (true) {
+            size_t size = 0;
+            int status = kn_message_frame_size(conn->in, conn->in_len, &size);
+            if (status < 0) {
+                return -1;
             }
-            if (strcmp(name, "script") == 0) {
-                if (command[0] == '\0') {
-                    printf("[KolibriScript] требуется путь к файлу\n");
-                    continue;
-                }
-                node_execute_script(node, command);
-                continue;
+            if (status == 0 || conn->in_len < size) {
+                break;
             }
-            if (strcmp(name, "fractal") == 0) {
-                node_print_canvas(node);
-                continue;
+            KolibriNetMessage message;
+            if (kn_message_decode(conn->in, size, &message) == 0) {
+                node_handle_peer_message(node, &message);
             }
-            if (strcmp(name, "help") == 0) {
-                node_print_help();
+            daemon_consume(conn, size);
+        }
+        return conn->in_len == sizeof(conn->in) ? -1 : 0;
+    }
+
+    for (size_t handled = 0; conn->in_len >= 4U; ++handled) {
+        if (handled == NODE_RPC_FRAMES_PER_WAKE ||
+            conn->out_len - conn->out_sent >= NODE_RPC_MAX_OUTPUT ||
+            !daemon->running) {
+            conn->backlog = daemon->running;
+            break;
+        }
+        uint32_t length = ((uint32_t)conn->in[0] << 24) | ((uint32_t)conn->in[1] << 16) |
+                          ((uint32_t)conn->in[2] << 8) | (uint32_t)conn->in[3];
+        if (length > NODE_RPC_MAX_REQUEST) {
+            /* Поток кадров рассинхронизирован: отвечаем и закрываем */
+            daemon_queue_reply(conn, NODE_RPC_BAD_FRAME, NULL, 0);
+            conn->in_len = 0;
+            conn->eof = true;
+            break;
+        }
+        if (conn->in_len < 4U + length) {
+            break;
+        }
+        if (daemon_run_request(daemon, node, conn, conn->in + 4, length) != 0) {
+            return -1;
+        }
+        daemon_consume(conn, 4U + length);
+    }
+    return 0;
+}
+
+static int daemon_flush(NodeConnection *conn) {
+    while (conn->out_sent < conn->out_len) {
+        ssize_t sent = send(conn->fd, conn->out + conn->out_sent,
+                            conn->out_len - conn->out_sent, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
                 continue;
             }
-            if (strcmp(name, "quit") == 0 || strcmp(name, "exit") == 0) {
-                printf("[Сессия] завершение работы по команде\n");
-                break;
-            }
-            printf("[Команда] неизвестная директива %s\n", name);
+            return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+        }
+        conn->out_sent += (size_t)sent;
+    }
+    conn->out_len = 0;
+    conn->out_sent = 0;
+    return 0;
+}
+
+/* Отправляет готовые ответы и решает судьбу соединения */
+static void daemon_settle(NodeDaemon *daemon, size_t slot) {
+    NodeConnection *conn = &daemon->connections[slot];
+    if (daemon_flush(conn) != 0) {
+        daemon_close_connection(daemon, slot);
+        return;
+    }
+    if (conn->eof && !conn->backlog && conn->out_len == 0) {
+        daemon_close_connection(daemon, slot);
+        return;
+    }
+    daemon_update_events(daemon, slot);
+}
+
+static void daemon_read(NodeDaemon *daemon, KolibriNode *node, size_t slot) {
+    NodeConnection *conn = &daemon->connections[slot];
+    while (!conn->eof && conn->in_len < sizeof(conn->in)) {
+        ssize_t got = recv(conn->fd, conn->in + conn->in_len,
+                           sizeof(conn->in) - conn->in_len, 0);
+        if (got > 0) {
+            conn->in_len += (size_t)got;
             continue;
-            }
-            node_store_text(node, line);
-            node_record_event(node, "NOTE", "свободный текст сохранён");
+        }
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        /* Клиент закрыл запись: дорабатываем принятые запросы */
+        conn->eof = true;
+    }
+    if (daemon_process(daemon, node, slot) != 0) {
+        daemon_close_connection(daemon, slot);
+        return;
+    }
+    daemon_settle(daemon, slot);
+}
+
+static void daemon_drain_backlog(NodeDaemon *daemon, KolibriNode *node) {
+    for (size_t slot = 0; slot < NODE_MAX_CONNECTIONS; ++slot) {
+        NodeConnection *conn = &daemon->connections[slot];
+        if (conn->fd < 0 || !conn->backlog ||
+            conn->out_len - conn->out_sent >= NODE_RPC_MAX_OUTPUT) {
+            continue;
+        }
+        if (daemon_process(daemon, node, slot) != 0) {
+            daemon_close_connection(daemon, slot);
+            continue;
+        }
+        daemon_settle(daemon, slot);
+    }
+}
+
+static bool daemon_has_backlog(const NodeDaemon *daemon) {
+    for (size_t slot = 0; slot < NODE_MAX_CONNECTIONS; ++slot) {
+        const NodeConnection *conn = &daemon->connections[slot];
+        if (conn->fd >= 0 && conn->backlog &&
+            conn->out_len - conn->out_sent < NODE_RPC_MAX_OUTPUT) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void daemon_close(NodeDaemon *daemon, const KolibriNode *node) {
+    if (daemon->connections) {
+        for (size_t slot = 0; slot < NODE_MAX_CONNECTIONS; ++slot) {
+            daemon_close_connection(daemon, slot);
+        }
+        free(daemon->connections);
+        daemon->connections = NULL;
+    }
+    if (daemon->rpc_fd >= 0) {
+        close(daemon->rpc_fd);
+        unlink(node->options.rpc_path);
+    }
+    if (daemon->evolve_fd >= 0) {
+        close(daemon->evolve_fd);
+    }
+    if (daemon->sync_fd >= 0) {
+        close(daemon->sync_fd);
+    }
+    if (daemon->snapshot_fd >= 0) {
+        close(daemon->snapshot_fd);
+    }
+    if (daemon->signal_fd >= 0) {
+        close(daemon->signal_fd);
+    }
+    if (daemon->epoll_fd >= 0) {
+        close(daemon->epoll_fd);
+    }
+}
+
+static int daemon_init(NodeDaemon *daemon, KolibriNode *node) {
+    daemon->epoll_fd = -1;
+    daemon->rpc_fd = -1;
+    daemon->evolve_fd = -1;
+    daemon->sync_fd = -1;
+    daemon->snapshot_fd = -1;
+    daemon->signal_fd = -1;
+    daemon->running = true;
+    daemon->connections =
+        (NodeConnection *)calloc(NODE_MAX_CONNECTIONS, sizeof(NodeConnection));
+    if (!daemon->connections) {
+        return -1;
+    }
+    for (size_t slot = 0; slot < NODE_MAX_CONNECTIONS; ++slot) {
+        daemon->connections[slot].fd = -1;
+    }
+    daemon->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (daemon->epoll_fd < 0) {
+        return -1;
+    }
+
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    if (sigprocmask(SIG_BLOCK, &mask, NULL) != 0) {
+        return -1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    daemon->signal_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (daemon->signal_fd < 0 ||
+        daemon_watch(daemon, daemon->signal_fd, EPOLLIN, NODE_WATCH_SIGNAL, 0) != 0) {
+        return -1;
+    }
+
+    if (daemon_open_rpc(daemon, node->options.rpc_path) != 0) {
+        return -1;
+    }
+    if (node->listener_ready) {
+        int flags = fcntl(node->listener.socket_fd, F_GETFL, 0);
+        if (flags < 0 ||
+            fcntl(node->listener.socket_fd, F_SETFL, flags | O_NONBLOCK) != 0 ||
+            daemon_watch(daemon, node->listener.socket_fd, EPOLLIN, NODE_WATCH_SWARM, 0) != 0) {
+            return -1;
+        }
+    }
+    if (node->options.auto_learn) {
+        daemon->evolve_fd = daemon_timer(daemon, node->options.auto_evolve_ms, NODE_WATCH_EVOLVE);
+        if (node->options.peer_enabled) {
+            daemon->sync_fd = daemon_timer(daemon, node->options.auto_sync_ms, NODE_WATCH_SYNC);
+        }
+    }
+    if (node->options.snapshot_enabled && node->options.snapshot_ms > 0U) {
+        daemon->snapshot_fd =
+            daemon_timer(daemon, node->options.snapshot_ms, NODE_WATCH_SNAPSHOT);
+    }
+    return 0;
+}
+
+static void daemon_handle_event(NodeDaemon *daemon, KolibriNode *node,
+                                const struct epoll_event *event) {
+    NodeWatch kind = (NodeWatch)(event->data.u64 >> 32);
+    size_t slot = (size_t)(event->data.u64 & 0xFFFFFFFFULL);
+    uint64_t expirations = 0;
+    switch (kind) {
+    case NODE_WATCH_SWARM:
+        daemon_accept(daemon, node->listener.socket_fd, NODE_WATCH_PEER);
+        break;
+    case NODE_WATCH_RPC:
+        daemon_accept(daemon, daemon->rpc_fd, NODE_WATCH_CLIENT);
+        break;
+    case NODE_WATCH_EVOLVE:
+        /* Пропущенные срабатывания сливаются в один цикл */
+        if (read(daemon->evolve_fd, &expirations, sizeof(expirations)) > 0) {
+            node_auto_evolve(node);
+        }
+        break;
+    case NODE_WATCH_SYNC:
+        if (read(daemon->sync_fd, &expirations, sizeof(expirations)) > 0) {
+            node_auto_sync(node);
+        }
+        break;
+    case NODE_WATCH_SNAPSHOT:
+        if (read(daemon->snapshot_fd, &expirations, sizeof(expirations)) > 0) {
+            node_save_snapshot(node, false);
+        }
+        break;
+    case NODE_WATCH_SIGNAL: {
+        struct signalfd_siginfo info;
+        if (read(daemon->signal_fd, &info, sizeof(info)) == (ssize_t)sizeof(info)) {
+            printf("[Демон] получен сигнал %u, завершаем работу\n", info.ssi_signo);
+            daemon->running = false;
+        }
+        break;
+    }
+    case NODE_WATCH_PEER:
+    case NODE_WATCH_CLIENT:
+        if (slot >= NODE_MAX_CONNECTIONS || daemon->connections[slot].fd < 0) {
+            break;
+        }
+        if (event->events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+            daemon_read(daemon, node, slot);
         } else {
-            if (node->options.auto_learn) {
-                uint64_t now = now_ms();
-                if (node->pool.examples > 0 && (now - node->last_evolve_ms) >= node->options.auto_evolve_ms) {
-                    kf_pool_tick(&node->pool, 1);
-                    node_record_event(node, "EVOLVE", "автоцикл");
-                    node->last_evolve_ms = now;
-                }
-                if (node->options.peer_enabled && (now - node->last_sync_ms) >= node->options.auto_sync_ms) {
-                    node_share_formula(node);
-                    node->last_sync_ms = now;
-                }
+            daemon_settle(daemon, slot);
+        }
+        break;
+    }
+}
+
+static int node_run_daemon(KolibriNode *node) {
+    NodeDaemon daemon;
+    if (daemon_init(&daemon, node) != 0) {
+        fprintf(stderr, "[Демон] не удалось запустить цикл событий\n");
+        daemon_close(&daemon, node);
+        return -1;
+    }
+    printf("[Демон] узел %u: RPC %s\n", node->options.node_id, node->options.rpc_path);
+    if (node->options.bootstrap_script[0] != '\0') {
+        node_execute_script(node, node->options.bootstrap_script);
+    }
+    fflush(stdout);
+
+    struct epoll_event events[NODE_EPOLL_EVENTS];
+    while (daemon.running) {
+        int timeout = daemon_has_backlog(&daemon) ? 0 : -1;
+        int ready = epoll_wait(daemon.epoll_fd, events, NODE_EPOLL_EVENTS, timeout);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
             }
+            fprintf(stderr, "[Демон] epoll: %s\n", strerror(errno));
+            break;
+        }
+        for (int i = 0; i < ready; ++i) {
+            daemon_handle_event(&daemon, node, &events[i]);
+        }
+        daemon_drain_backlog(&daemon, node);
+        fflush(stdout);
+    }
+
+    /* Ответ на :quit уходит клиентам до закрытия */
+    for (size_t slot = 0; slot < NODE_MAX_CONNECTIONS; ++slot) {
+        if (daemon.connections[slot].fd >= 0) {
+            daemon_flush(&daemon.connections[slot]);
         }
     }
+    daemon_close(&daemon, node);
+    return 0;
 }
 
 static int node_start_listener(KolibriNode *node) {
@@ -931,9 +1715,19 @@ static int node_init(KolibriNode *node, const KolibriNodeOptions *options) {
     node_reset_last_answer(node);
     k_digit_stream_init(&node->memory, node->memory_buffer, sizeof(node->memory_buffer));
     kf_pool_init(&node->pool, node->options.seed);
+    if (node->options.snapshot_path[0] != '\0') {
+        strncpy(node->snapshot_path, node->options.snapshot_path,
+                sizeof(node->snapshot_path) - 1);
+    } else {
+        snprintf(node->snapshot_path, sizeof(node->snapshot_path), "%s.pool",
+                 node->options.genome_path);
+    }
     if (node_open_genome(node) != 0) {
         return -1;
     }
+    if (!node->options.health_check) {
+        node_restore_pool(node);
+    }
     if (node_start_listener(node) != 0) {
         node_close_genome(node);
         return -1;
@@ -943,6 +1737,9 @@ static int node_init(KolibriNode *node, const KolibriNodeOptions *options) {
 
 static void node_shutdown(KolibriNode *node) {
     node_stop_listener(node);
+    if (!node->options.health_check) {
+        node_save_snapshot(node, false);
+    }
     if (node->script_ready) {
         ks_free(&node->script);
         node->script_ready = false;
@@ -976,20 +1773,37 @@ static int node_emit_health(KolibriNode *node) {
 int main(int argc, char **argv) {
     KolibriNodeOptions options;
     parse_options(argc, argv, &options);
+    if (options.show_help) {
+        print_usage();
+        return 0;
+    }
     if (options.health_check) {
         options.listen_enabled = false;
     }
-    KolibriNode node;
-    if (node_init(&node, &options) != 0) {
+    /* Пул формул занимает десятки мегабайт: узел живёт в куче, не на стеке */
+    KolibriNode *node = (KolibriNode *)calloc(1, sizeof(KolibriNode));
+    if (!node) {
+        fprintf(stderr, "[Узел] недостаточно памяти\n");
+        return 1;
+    }
+    if (node_init(node, &options) != 0) {
+        free(node);
         return 1;
     }
     if (options.health_check) {
-        int status = node_emit_health(&node);
-        node_shutdown(&node);
+        int status = node_emit_health(node);
+        node_shutdown(node);
+        free(node);
         return status;
     }
-    node_run(&node);
-    node_shutdown(&node);
+    int status = 0;
+    if (options.daemon) {
+        status = node_run_daemon(node) == 0 ? 0 : 1;
+    } else {
+        node_run(node);
+    }
+    node_shutdown(node);
     printf("Колибри узел %u завершил работу\n", options.node_id);
-    return 0;
+    free(node);
+    return status;
 }
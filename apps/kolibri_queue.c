@@ -1,3 +1,5 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "kolibri/knowledge_queue.h"
 
 #include <sqlite3.h>
@@ -9,9 +11,11 @@ static void print_usage(void) {
     fprintf(stderr,
             "Usage:\n"
             "  kolibri_queue enqueue --db PATH --title TITLE --content TEXT [--source S] [--metadata JSON]\n"
-            "  kolibri_queue list --db PATH [--status pending|approved|rejected] [--limit N]\n"
+            "  kolibri_queue import --db PATH --input FILE   (TSV: title<TAB>content[<TAB>source])\n"
+            "  kolibri_queue list --db PATH [--status pending|approved|rejected] [--limit N] [--after ID]\n"
             "  kolibri_queue moderate --db PATH --id ID --status approved|rejected --moderator NAME [--note TEXT]\n"
-            "  kolibri_queue export --db PATH --status approved|rejected --output DIR\n");
+            "  kolibri_queue export --db PATH --status approved|rejected --output DIR\n"
+            "  kolibri_queue export --db PATH --status approved|rejected --format jsonl [--output FILE|-]\n");
 }
 
 static int parse_status(const char *text, KolibriQueueStatus *out_status) {
@@ -53,6 +57,10 @@ static int cmd_enqueue(int argc, char **argv) {
     long long submission_id = 0;
     int rc = kolibri_queue_enqueue(queue, title, content, source, metadata, &submission_id);
     kolibri_queue_close(queue);
+    if (rc == SQLITE_CONSTRAINT) {
+        fprintf(stderr, "--metadata must be valid JSON\n");
+        return 1;
+    }
     if (rc != SQLITE_OK) {
         fprintf(stderr, "Failed to enqueue: %d\n", rc);
         return 1;
@@ -61,10 +69,108 @@ static int cmd_enqueue(int argc, char **argv) {
     return 0;
 }
 
+#define IMPORT_BATCH 512U
+
+static int flush_import(KolibriQueue *queue, KolibriQueueSubmission *batch, char **lines,
+                        size_t *count, size_t *imported) {
+    int rc = kolibri_queue_enqueue_batch(queue, batch, *count, NULL);
+    if (rc == SQLITE_OK) {
+        *imported += *count;
+    }
+    for (size_t i = 0; i < *count; ++i) {
+        free(lines[i]);
+    }
+    *count = 0U;
+    return rc;
+}
+
+static int cmd_import(int argc, char **argv) {
+    const char *db_path = NULL;
+    const char *input_path = NULL;
+    for (int i = 0; i < argc; ++i) {
+        if (strcmp(argv[i], "--db") == 0 && i + 1 < argc) {
+            db_path = argv[++i];
+        } else if (strcmp(argv[i], "--input") == 0 && i + 1 < argc) {
+            input_path = argv[++i];
+        }
+    }
+    if (!db_path || !input_path) {
+        print_usage();
+        return 1;
+    }
+    FILE *input = strcmp(input_path, "-") == 0 ? stdin : fopen(input_path, "rb");
+    if (!input) {
+        fprintf(stderr, "Unable to open %s\n", input_path);
+        return 1;
+    }
+    KolibriQueue *queue = NULL;
+    if (kolibri_queue_open(db_path, &queue) != SQLITE_OK) {
+        fprintf(stderr, "Unable to open queue database\n");
+        if (input != stdin) {
+            fclose(input);
+        }
+        return 1;
+    }
+    /* Строки копятся пачками и вставляются одной транзакцией на пачку */
+    KolibriQueueSubmission batch[IMPORT_BATCH];
+    char *lines[IMPORT_BATCH];
+    size_t count = 0U;
+    size_t imported = 0U;
+    size_t skipped = 0U;
+    int rc = SQLITE_OK;
+    char *line = NULL;
+    size_t line_cap = 0U;
+    ssize_t length;
+    while (rc == SQLITE_OK && (length = getline(&line, &line_cap, input)) >= 0) {
+        while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) {
+            line[--length] = '\0';
+        }
+        char *title = line;
+        char *content = strchr(title, '\t');
+        if (!content || title == content) {
+            skipped++;
+            continue;
+        }
+        *content++ = '\0';
+        char *source = strchr(content, '\t');
+        if (source) {
+            *source++ = '\0';
+        }
+        batch[count].title = title;
+        batch[count].content = content;
+        batch[count].source = source && source[0] ? source : NULL;
+        batch[count].metadata_json = NULL;
+        lines[count++] = line;
+        line = NULL;
+        line_cap = 0U;
+        if (count == IMPORT_BATCH) {
+            rc = flush_import(queue, batch, lines, &count, &imported);
+        }
+    }
+    free(line);
+    if (rc == SQLITE_OK && count > 0U) {
+        rc = flush_import(queue, batch, lines, &count, &imported);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        free(lines[i]);
+    }
+    kolibri_queue_close(queue);
+    if (input != stdin) {
+        fclose(input);
+    }
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Import failed after %zu rows: %d\n", imported, rc);
+        return 1;
+    }
+    printf("Импортировано заявок: %zu (пропущено строк: %zu)\n", imported, skipped);
+    return 0;
+}
+
 static int cmd_list(int argc, char **argv) {
     const char *db_path = NULL;
     KolibriQueueStatus status = KOLIBRI_QUEUE_STATUS_PENDING;
     size_t limit = 20U;
+    long long after_id = 0;
     for (int i = 0; i < argc; ++i) {
         if (strcmp(argv[i], "--db") == 0 && i + 1 < argc) {
             db_path = argv[++i];
@@ -74,6 +180,8 @@ static int cmd_list(int argc, char **argv) {
             }
         } else if (strcmp(argv[i], "--limit") == 0 && i + 1 < argc) {
             limit = (size_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--after") == 0 && i + 1 < argc) {
+            after_id = atoll(argv[++i]);
         }
     }
     if (!db_path) {
@@ -85,32 +193,43 @@ static int cmd_list(int argc, char **argv) {
         fprintf(stderr, "Unable to open queue database\n");
         return 1;
     }
-    KolibriQueueRecord *records = NULL;
+    /* Списку не нужен текст заявок: курсор его не читает. Лишняя строка
+     * страницы показывает, есть ли продолжение */
+    KolibriQueueCursor *cursor = NULL;
+    int rc = kolibri_queue_cursor_open(queue, status, after_id, 0, limit + 1U, &cursor);
     size_t count = 0U;
-    int rc = kolibri_queue_fetch(queue, status, limit, &records, &count);
-    if (rc != SQLITE_OK) {
+    const KolibriQueueRecord *rec = NULL;
+    while (rc == SQLITE_OK && count < limit &&
+           (rc = kolibri_queue_cursor_next(cursor, &rec)) == SQLITE_ROW) {
+        printf("#%lld [%s] %s\n", rec->submission_id, kolibri_queue_status_to_string(rec->status), rec->title ? rec->title : "-");
+        if (rec->source) {
+            printf("  источник: %s\n", rec->source);
+        }
+        if (rec->moderator) {
+            printf("  модератор: %s\n", rec->moderator);
+        }
+        if (rec->moderation_note) {
+            printf("  заметка: %s\n", rec->moderation_note);
+        }
+        count++;
+        rc = SQLITE_OK;
+    }
+    long long last_id = kolibri_queue_cursor_position(cursor);
+    if (rc == SQLITE_OK && count == limit) {
+        rc = kolibri_queue_cursor_next(cursor, &rec);
+    }
+    if (rc != SQLITE_OK && rc != SQLITE_ROW && rc != SQLITE_DONE) {
         fprintf(stderr, "Fetch failed: %d\n", rc);
+        kolibri_queue_cursor_close(cursor);
         kolibri_queue_close(queue);
         return 1;
     }
     if (count == 0U) {
         printf("Заявок не найдено\n");
-    } else {
-        for (size_t i = 0; i < count; ++i) {
-            KolibriQueueRecord *rec = &records[i];
-            printf("#%lld [%s] %s\n", rec->submission_id, kolibri_queue_status_to_string(rec->status), rec->title ? rec->title : "-");
-            if (rec->source) {
-                printf("  источник: %s\n", rec->source);
-            }
-            if (rec->moderator) {
-                printf("  модератор: %s\n", rec->moderator);
-            }
-            if (rec->moderation_note) {
-                printf("  заметка: %s\n", rec->moderation_note);
-            }
-        }
+    } else if (rc == SQLITE_ROW) {
+        printf("Далее: --after %lld\n", last_id);
     }
-    kolibri_queue_free_records(records, count);
+    kolibri_queue_cursor_close(cursor);
     kolibri_queue_close(queue);
     return 0;
 }
@@ -158,6 +277,7 @@ static int cmd_moderate(int argc, char **argv) {
 static int cmd_export(int argc, char **argv) {
     const char *db_path = NULL;
     const char *output_dir = NULL;
+    const char *format = "markdown";
     KolibriQueueStatus status = KOLIBRI_QUEUE_STATUS_APPROVED;
     for (int i = 0; i < argc; ++i) {
         if (strcmp(argv[i], "--db") == 0 && i + 1 < argc) {
@@ -168,9 +288,12 @@ static int cmd_export(int argc, char **argv) {
             }
         } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
             output_dir = argv[++i];
+        } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            format = argv[++i];
         }
     }
-    if (!db_path || !output_dir) {
+    int jsonl = strcmp(format, "jsonl") == 0;
+    if (!db_path || (!jsonl && strcmp(format, "markdown") != 0) || (!jsonl && !output_dir)) {
         print_usage();
         return 1;
     }
@@ -180,13 +303,29 @@ static int cmd_export(int argc, char **argv) {
         return 1;
     }
     size_t exported = 0U;
-    int rc = kolibri_queue_export_markdown(queue, status, output_dir, &exported);
+    int rc;
+    if (jsonl) {
+        int to_stdout = !output_dir || strcmp(output_dir, "-") == 0;
+        FILE *out = to_stdout ? stdout : fopen(output_dir, "wb");
+        if (!out) {
+            fprintf(stderr, "Unable to open %s\n", output_dir);
+            kolibri_queue_close(queue);
+            return 1;
+        }
+        rc = kolibri_queue_export_jsonl(queue, status, out, &exported);
+        if (!to_stdout && fclose(out) != 0 && rc == SQLITE_OK) {
+            rc = SQLITE_IOERR;
+        }
+    } else {
+        rc = kolibri_queue_export_markdown(queue, status, output_dir, &exported);
+    }
     kolibri_queue_close(queue);
     if (rc != SQLITE_OK) {
         fprintf(stderr, "Export failed: %d\n", rc);
         return 1;
     }
-    printf("Экспортировано %zu файлов\n", exported);
+    /* В режиме stdout итог уходит в stderr, чтобы не портить поток */
+    fprintf(jsonl ? stderr : stdout, "Экспортировано %zu %s\n", exported, jsonl ? "записей" : "файлов");
     return 0;
 }
 
@@ -199,6 +338,9 @@ int main(int argc, char **argv) {
     if (strcmp(command, "enqueue") == 0) {
         return cmd_enqueue(argc - 2, &argv[2]);
     }
+    if (strcmp(command, "import") == 0) {
+        return cmd_import(argc - 2, &argv[2]);
+    }
     if (strcmp(command, "list") == 0) {
         return cmd_list(argc - 2, &argv[2]);
     }
@@ -0,0 +1,100 @@
+/*
+ * Kolibri OS Archiver - Burrows-Wheeler transform
+ * Linear-time suffix array construction (SA-IS) and block BWT
+ */
+
+#ifndef KOLIBRI_BWT_H
+#define KOLIBRI_BWT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Default block size: bounds working memory to about 5x the block */
+#define KOLIBRI_BWT_DEFAULT_BLOCK (4u << 20)
+
+/* Largest supported block (suffix array entries are int32_t) */
+#define KOLIBRI_BWT_MAX_BLOCK ((size_t)INT32_MAX - 1)
+
+/**
+ * Build the suffix array of text with an implicit terminator that sorts
+ * below every byte. Runs in O(n) time regardless of input redundancy.
+ * @param text Input bytes
+ * @param length Number of input bytes
+ * @param sa Output, length + 1 entries; sa[0] is always length (the empty suffix)
+ * @return 0 on success, -1 on error
+ */
+int kolibri_suffix_array(const uint8_t *text, size_t length, int32_t *sa);
+
+/**
+ * Forward BWT of a single block (terminator-based, bzip2/divsufsort style)
+ * @param input Input bytes
+ * @param length Number of bytes
+ * @param output Transformed bytes (length bytes, may not alias input)
+ * @param primary Position of the terminator row, needed for the inverse
+ * @param workspace Optional length + 1 int32_t entries, allocated when NULL
+ * @return 0 on success, -1 on error
+ */
+int kolibri_bwt_encode(const uint8_t *input,
+                       size_t length,
+                       uint8_t *output,
+                       uint32_t *primary,
+                       int32_t *workspace);
+
+/**
+ * Inverse BWT of a single block
+ * @param input Transformed bytes
+ * @param length Number of bytes
+ * @param primary Value returned by kolibri_bwt_encode
+ * @param output Restored bytes (length bytes, may not alias input)
+ * @param workspace Optional length + 1 uint32_t entries, allocated when NULL
+ * @return 0 on success, -1 on malformed input
+ */
+int kolibri_bwt_decode(const uint8_t *input,
+                       size_t length,
+                       uint32_t primary,
+                       uint8_t *output,
+                       uint32_t *workspace);
+
+/**
+ * Number of blocks kolibri_bwt_encode_blocks produces
+ */
+size_t kolibri_bwt_block_count(size_t length, size_t block_size);
+
+/**
+ * Transform input as independent blocks of block_size bytes in parallel.
+ * Block i covers [i * block_size, min(length, (i + 1) * block_size)).
+ * @param input Input bytes
+ * @param length Number of bytes
+ * @param block_size Block size (0 = KOLIBRI_BWT_DEFAULT_BLOCK)
+ * @param threads Worker threads (0 = online CPUs)
+ * @param output Transformed bytes, same layout as input
+ * @param primaries One entry per block
+ * @return 0 on success, -1 on error
+ */
+int kolibri_bwt_encode_blocks(const uint8_t *input,
+                              size_t length,
+                              size_t block_size,
+                              size_t threads,
+                              uint8_t *output,
+                              uint32_t *primaries);
+
+/**
+ * Inverse of kolibri_bwt_encode_blocks
+ * @return 0 on success, -1 on malformed input
+ */
+int kolibri_bwt_decode_blocks(const uint8_t *input,
+                              size_t length,
+                              size_t block_size,
+                              size_t threads,
+                              const uint32_t *primaries,
+                              uint8_t *output);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KOLIBRI_BWT_H */
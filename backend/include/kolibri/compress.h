@@ -8,6 +8,7 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -28,6 +29,14 @@ extern "C" {
 #define KOLIBRI_COMPRESS_ZSTD    0x40  /* v40: Zstandard compression */
 #define KOLIBRI_COMPRESS_ADAPTIVE 0x80 /* v40: Adaptive dictionary */
 #define KOLIBRI_COMPRESS_ALL     0xFF
+/* v41: block codec BWT -> MTF -> context-modelled range coder (from kolibri_v40).
+ * Not part of ALL: it replaces the layered methods instead of chaining with them. */
+#define KOLIBRI_COMPRESS_BWT     0x100
+/* v41: arena-backed PPM context model (see kolibri/ppm.h), also standalone */
+#define KOLIBRI_COMPRESS_PPM     0x200
+
+/* Default block size of the block codec */
+#define KOLIBRI_COMPRESS_BWT_BLOCK (1u << 20)
 
 /* File type detection */
 typedef enum {
@@ -96,6 +105,52 @@ int kolibri_decompress(const uint8_t *input,
                        size_t *output_size,
                        KolibriCompressStats *stats);
 
+/**
+ * Configure the block codec (KOLIBRI_COMPRESS_BWT)
+ * Model state for each worker is allocated once and reused for every block.
+ * A compressor must not be used from several threads at once; separate
+ * compressors are independent.
+ * @param comp Compressor instance
+ * @param block_size Bytes per independently coded block (0 = KOLIBRI_COMPRESS_BWT_BLOCK)
+ * @param threads Worker threads coding blocks in parallel (0 = online CPUs)
+ * @return 0 on success, -1 on error
+ */
+int kolibri_compressor_set_blocks(KolibriCompressor *comp, size_t block_size, size_t threads);
+
+/**
+ * Configure the PPM method (KOLIBRI_COMPRESS_PPM)
+ * The model and its memory budget are allocated on first use and reused.
+ * @param comp Compressor instance
+ * @param order Context order (0 = KOLIBRI_PPM_DEFAULT_ORDER)
+ * @param memory_limit Bytes for context tables (0 = KOLIBRI_PPM_DEFAULT_MEMORY)
+ * @return 0 on success, -1 on error
+ */
+int kolibri_compressor_set_ppm(KolibriCompressor *comp, unsigned order, size_t memory_limit);
+
+/**
+ * Compress a stream with the block codec without loading it whole.
+ * Reads one block per worker at a time; memory use is bounded by
+ * block_size * threads.
+ * @param comp Compressor instance
+ * @param in Input stream
+ * @param out Output stream
+ * @param stats Optional statistics output
+ * @return 0 on success, -1 on error
+ */
+int kolibri_compress_stream(KolibriCompressor *comp, FILE *in, FILE *out,
+                            KolibriCompressStats *stats);
+
+/**
+ * Decompress a stream written by kolibri_compress_stream
+ * @param in Compressed stream
+ * @param out Output stream
+ * @param threads Worker threads (0 = online CPUs)
+ * @param stats Optional statistics output
+ * @return 0 on success, -1 on error or checksum mismatch
+ */
+int kolibri_decompress_stream(FILE *in, FILE *out, size_t threads,
+                              KolibriCompressStats *stats);
+
 /**
  * Detect file type from data
  */
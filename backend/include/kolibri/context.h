@@ -24,6 +24,21 @@ extern "C" {
 /* Максимальное количество паттернов в окне */
 #define KOLIBRI_CONTEXT_MAX_PATTERNS 128
 
+/* Цифр на токен (3 цифры на байт UTF-8, длиннее — усекается) */
+#define KOLIBRI_CONTEXT_TOKEN_DIGITS 192
+
+/* Максимальное число весов в строке разреженного attention */
+#define KOLIBRI_CONTEXT_SPARSE_MAX 64
+
+/**
+ * Режим вычисления attention
+ */
+typedef enum {
+    KOLIBRI_ATTENTION_DENSE = 0,    /* Полная матрица double, пересчёт целиком */
+    KOLIBRI_ATTENTION_INCREMENTAL,  /* Треугольная матрица float, O(n) на токен */
+    KOLIBRI_ATTENTION_SPARSE        /* Только top-k весов строки (опционально в полосе) */
+} KolibriAttentionMode;
+
 /**
  * Токен в контекстном окне
  */
@@ -32,8 +47,17 @@ typedef struct {
     KolibriSemanticPattern pattern;   /* Семантический паттерн */
     double attention_weight;          /* Вес внимания (0.0 - 1.0) */
     size_t position;                  /* Позиция в окне */
+    uint8_t digit_data[KOLIBRI_CONTEXT_TOKEN_DIGITS]; /* Буфер для digits */
 } KolibriContextToken;
 
+/**
+ * Элемент разреженной строки attention
+ */
+typedef struct {
+    uint32_t position;                /* Позиция целевого токена */
+    float score;                      /* exp(сходство), до нормализации */
+} KolibriAttentionEntry;
+
 /**
  * Контекстное окно
  */
@@ -43,6 +67,17 @@ typedef struct {
     size_t current_position;              /* Текущая позиция */
     double *attention_matrix;             /* Матрица внимания (token_count x token_count) */
     size_t attention_matrix_size;         /* Размер выделенной матрицы */
+
+    /* Инкрементальные режимы (INCREMENTAL / SPARSE) */
+    KolibriAttentionMode attention_mode;  /* Текущий режим */
+    size_t sparse_top_k;                  /* Весов на строку в SPARSE */
+    size_t sparse_band;                   /* 0 — все позиции, иначе |i-j| <= band */
+    size_t scored_count;                  /* Токенов, уже учтённых в весах */
+    float *attention_scores;              /* INCREMENTAL: exp(сходство), нижний треугольник */
+    size_t attention_scores_size;         /* Выделено элементов attention_scores */
+    KolibriAttentionEntry *sparse_rows;   /* SPARSE: WINDOW_SIZE x sparse_top_k */
+    uint16_t sparse_counts[KOLIBRI_CONTEXT_WINDOW_SIZE]; /* Заполнение строк SPARSE */
+    double row_sums[KOLIBRI_CONTEXT_WINDOW_SIZE];        /* Знаменатели softmax строк */
 } KolibriContextWindow;
 
 /**
@@ -81,6 +116,25 @@ int k_context_window_add_token(KolibriContextWindow *ctx,
  */
 int k_context_window_compute_attention(KolibriContextWindow *ctx);
 
+/**
+ * Выбор режима attention
+ *
+ * В режимах INCREMENTAL и SPARSE k_context_window_add_token сразу
+ * досчитывает строку и столбец нового токена (O(n) вместо O(n^2)),
+ * а k_context_window_compute_attention лишь догоняет отставшие строки.
+ * Веса хранятся во float; SPARSE хранит только top_k весов строки.
+ *
+ * @param ctx Контекстное окно
+ * @param mode Режим
+ * @param top_k Весов на строку для SPARSE (1..KOLIBRI_CONTEXT_SPARSE_MAX)
+ * @param band Ширина полосы для SPARSE (0 — без ограничения)
+ * @return 0 в случае успеха, -1 при ошибке
+ */
+int k_context_window_set_attention_mode(KolibriContextWindow *ctx,
+                                        KolibriAttentionMode mode,
+                                        size_t top_k,
+                                        size_t band);
+
 /**
  * Получение токена по позиции
  * 
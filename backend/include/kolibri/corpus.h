@@ -24,6 +24,11 @@ extern "C" {
 /* Максимальная длина текста для обработки */
 #define KOLIBRI_CORPUS_MAX_TEXT_SIZE (1024 * 1024) /* 1MB */
 
+/* LSH-индекс: таблиц и цифр паттерна в ключе бакета */
+#define KOLIBRI_CORPUS_LSH_TABLES 8
+#define KOLIBRI_CORPUS_LSH_DIGITS 4
+#define KOLIBRI_CORPUS_LSH_BUCKETS 10000 /* 10^KOLIBRI_CORPUS_LSH_DIGITS */
+
 /**
  * Статистика обучения на корпусе
  */
@@ -34,6 +39,17 @@ typedef struct {
     size_t failed_patterns;       /* Паттернов с ошибками */
     double avg_fitness;           /* Средний fitness паттернов */
     double learning_time_sec;     /* Время обучения в секундах */
+    
+    /* Конвейер: объём и занятое время каждой стадии */
+    size_t files_scanned;         /* Файлов найдено сканером */
+    size_t bytes_read;            /* Байт прочитано токенизаторами */
+    size_t learn_jobs;            /* Уникальных слов обучено (после дедупликации) */
+    size_t batches;               /* Обработано батчей */
+    size_t threads;               /* Потоков обучения в последнем запуске */
+    double scan_time_sec;         /* Обход директорий */
+    double tokenize_time_sec;     /* Чтение и токенизация (сумма по потокам) */
+    double learn_time_sec;        /* Эволюция паттернов (стена) */
+    double merge_time_sec;        /* Слияние в хранилище (стена) */
 } KolibriCorpusStats;
 
 /**
@@ -44,8 +60,25 @@ typedef struct {
     char **words;                      /* Соответствующие слова */
     size_t count;                      /* Количество паттернов */
     size_t capacity;                   /* Вместимость массива */
+    uint8_t *digits;                   /* SoA: цифры паттернов подряд (count x 64) */
+    uint32_t *hashes;                  /* FNV-1a хэши слов */
+    uint32_t *index;                   /* Хэш-индекс слов: номер + 1, 0 — пусто */
+    size_t index_capacity;             /* Размер индекса (степень двойки) */
+    uint32_t *lsh_heads;               /* LSH: TABLES x BUCKETS, номер + 1 */
+    uint32_t *lsh_next;                /* LSH: цепочки, capacity x TABLES */
+    uint32_t *lsh_seen;                /* Метки кандидатов текущего запроса */
+    uint32_t lsh_epoch;                /* Номер текущего запроса */
+    int lsh_dirty;                     /* LSH нужно перестроить */
 } KolibriPatternStore;
 
+/**
+ * Результат поиска ближайших паттернов
+ */
+typedef struct {
+    size_t index;                      /* Номер паттерна в хранилище */
+    double similarity;                 /* Сходство 0.0 - 1.0 */
+} KolibriPatternMatch;
+
 /**
  * Контекст обучения на корпусе
  */
@@ -55,6 +88,9 @@ typedef struct {
     size_t batch_size;            /* Размер батча */
     size_t context_window_size;   /* Размер контекстного окна */
     int verbose;                  /* Уровень логирования */
+    size_t threads;               /* Потоков обучения (0 = по числу CPU) */
+    size_t generations;           /* Поколений эволюции на слово */
+    uint64_t seed;                /* Базовый seed: результат не зависит от числа потоков */
 } KolibriCorpusContext;
 
 /**
@@ -79,6 +115,11 @@ void k_corpus_free(KolibriCorpusContext *ctx);
 /**
  * Обучение на текстовом документе
  * 
+ * Каждое уникальное слово батча обучается один раз (контексты всех
+ * вхождений объединяются) на пуле потоков с перехватом работы.
+ * Seed каждого слова выводится из ctx->seed, слова и номера батча,
+ * поэтому результат детерминирован при любом числе потоков.
+ * 
  * @param ctx Контекст корпуса
  * @param text Текст документа
  * @param text_len Длина текста
@@ -101,6 +142,11 @@ int k_corpus_learn_file(KolibriCorpusContext *ctx,
 /**
  * Обучение на директории с файлами
  * 
+ * Конвейер: сканер (отсортированный обход) -> ограниченная очередь ->
+ * потоки токенизации -> батчи в порядке обхода -> пул обучения ->
+ * шардированное слияние в хранилище. Пропускная способность стадий
+ * отражается в KolibriCorpusStats.
+ * 
  * @param ctx Контекст корпуса
  * @param dirpath Путь к директории
  * @param recursive Рекурсивный обход
@@ -144,6 +190,39 @@ int k_corpus_merge_pattern(KolibriCorpusContext *ctx,
                            const char *word,
                            const KolibriSemanticPattern *new_pattern);
 
+/**
+ * Точный поиск top-k ближайших паттернов (пакетное SIMD-сравнение)
+ * 
+ * @param ctx Контекст корпуса
+ * @param query Паттерн запроса
+ * @param top_k Количество результатов
+ * @param results Массив результатов (размер >= top_k), по убыванию сходства
+ * @return Количество найденных паттернов или -1 при ошибке
+ */
+int k_corpus_find_nearest(const KolibriCorpusContext *ctx,
+                          const KolibriSemanticPattern *query,
+                          size_t top_k,
+                          KolibriPatternMatch *results);
+
+/**
+ * Приближённый поиск top-k через LSH-бакеты
+ * 
+ * Кандидаты — паттерны, совпадающие с запросом хотя бы в одной
+ * LSH-таблице (KOLIBRI_CORPUS_LSH_DIGITS фиксированных позиций).
+ * Индекс перестраивается лениво после изменений хранилища.
+ * Если кандидатов нет, выполняется точный поиск.
+ * 
+ * @param ctx Контекст корпуса
+ * @param query Паттерн запроса
+ * @param top_k Количество результатов
+ * @param results Массив результатов (размер >= top_k), по убыванию сходства
+ * @return Количество найденных паттернов или -1 при ошибке
+ */
+int k_corpus_find_nearest_approx(KolibriCorpusContext *ctx,
+                                 const KolibriSemanticPattern *query,
+                                 size_t top_k,
+                                 KolibriPatternMatch *results);
+
 /**
  * Сохранение изученных паттернов в файл
  * 
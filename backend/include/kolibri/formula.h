@@ -51,9 +51,62 @@ typedef struct {
     size_t association_count;
 } KolibriFormulaPool;
 
+/* Компактный пул: только гены и числовые примеры, без ассоциаций.
+ * Эволюционирует так же, как kf_pool_tick без ассоциаций. */
+typedef struct {
+    KolibriGene gene;
+    double fitness;
+    double feedback;
+} KolibriGeneSlot;
+
+typedef struct {
+    KolibriGeneSlot slots[24];
+    size_t count;
+    KolibriRng rng;
+    int inputs[64];
+    int targets[64];
+    size_t examples;
+} KolibriGenePool;
+
+/* Формула со списком ассоциаций по ссылке: формула пула или оверлея. */
+typedef struct {
+    KolibriGene gene;
+    double fitness;
+    double feedback;
+    const KolibriAssociation *associations;
+    size_t association_count;
+} KolibriFormulaView;
+
+/* Изменения одного запроса поверх неизменяемого пула base. Ассоциации
+ * только дописываются, base не копируется: запись и сброс стоят
+ * O(изменений запроса). Формулы читаются из base до первой эволюции. */
+typedef struct {
+    const KolibriFormulaPool *base;
+    KolibriAssociation *fresh;        /* Новые вопросы в порядке добавления */
+    size_t fresh_count;
+    size_t fresh_capacity;
+    KolibriAssociation *replaced;     /* Новые ответы на вопросы из base */
+    size_t *replaced_index;           /* Номер заменённой ассоциации base */
+    size_t *replaced_order;           /* Записи replaced по возрастанию номера */
+    size_t replaced_count;
+    size_t replaced_capacity;
+    int inputs[64];                   /* Примеры сверх примеров base */
+    int targets[64];
+    size_t examples;
+    KolibriFormulaView formulas[24];  /* Формулы после эволюции */
+    size_t formula_count;             /* 0 - формулы base */
+    KolibriRng rng;
+    KolibriAssociation **snapshots;   /* Наборы ассоциаций, выданные формулам */
+    size_t snapshot_count;
+    size_t snapshot_capacity;
+    int snapshot_current;             /* Последний снимок совпадает с ассоциациями */
+} KolibriPoolOverlay;
+
 void kf_pool_init(KolibriFormulaPool *pool, uint64_t seed);
 void kf_pool_clear_examples(KolibriFormulaPool *pool);
 int kf_pool_add_example(KolibriFormulaPool *pool, int input, int target);
+/* -1, если ассоциацию не удалось сохранить (символы не закодированы или не
+ * записаны в геном); переполнение примеров не ошибка. */
 int kf_pool_add_association(KolibriFormulaPool *pool,
                             KolibriSymbolTable *symbols,
                             const char *question,
@@ -70,5 +123,38 @@ int kf_formula_lookup_answer(const KolibriFormula *formula, int input,
                              char *buffer, size_t buffer_len);
 int kf_hash_from_text(const char *text);
 
+void kf_formula_view_init(KolibriFormulaView *view, const KolibriFormula *formula);
+int kf_formula_view_apply(const KolibriFormulaView *view, int input, int *output);
+int kf_formula_view_lookup_answer(const KolibriFormulaView *view, int input,
+                                  char *buffer, size_t buffer_len);
+size_t kf_formula_view_digits(const KolibriFormulaView *view, uint8_t *out, size_t out_len);
+
+void kf_overlay_init(KolibriPoolOverlay *overlay, const KolibriFormulaPool *base);
+/* Забывает изменения запроса; выделенная память остаётся для следующего. */
+void kf_overlay_reset(KolibriPoolOverlay *overlay);
+void kf_overlay_free(KolibriPoolOverlay *overlay);
+/* Как kf_pool_add_association над base с изменениями оверлея; -1 также
+ * при нехватке памяти. */
+int kf_overlay_add_association(KolibriPoolOverlay *overlay,
+                               KolibriSymbolTable *symbols,
+                               const char *question,
+                               const char *answer,
+                               const char *source,
+                               uint64_t timestamp);
+/* Как kf_pool_tick; формулы оверлея ссылаются на ассоциации, а не копируют
+ * их. -1 при нехватке памяти. */
+int kf_overlay_tick(KolibriPoolOverlay *overlay, size_t generations);
+/* Ассоциации в том же порядке, что в пуле после тех же изменений. */
+size_t kf_overlay_association_count(const KolibriPoolOverlay *overlay);
+const KolibriAssociation *kf_overlay_association(const KolibriPoolOverlay *overlay, size_t index);
+size_t kf_overlay_formula_count(const KolibriPoolOverlay *overlay);
+int kf_overlay_formula(const KolibriPoolOverlay *overlay, size_t index, KolibriFormulaView *view);
+
+void kf_gene_pool_init(KolibriGenePool *pool, uint64_t seed);
+int kf_gene_pool_add_example(KolibriGenePool *pool, int input, int target);
+void kf_gene_pool_tick(KolibriGenePool *pool, size_t generations);
+const KolibriGeneSlot *kf_gene_pool_best(const KolibriGenePool *pool);
+int kf_gene_describe(const KolibriGene *gene, double fitness, char *buffer, size_t buffer_len);
+
 
 #endif /* KOLIBRI_FORMULA_H */
@@ -91,6 +91,16 @@ typedef struct {
     size_t output_size_estimate; /* Ожидаемый размер выхода */
 } MetaFormula;
 
+/* Итоги последнего пакетного выполнения */
+typedef struct {
+    size_t requested;       /* Ячеек в пакете */
+    size_t executed;        /* Записано в память */
+    size_t failed;          /* Формула не дала логики */
+    size_t blocked;         /* Пропущено из-за цикла зависимостей */
+    size_t levels;          /* Уровней топологического порядка */
+    size_t threads;         /* Использовано потоков */
+} MfBatchStats;
+
 /* Хранилище мета-формул */
 typedef struct {
     MetaFormula formulas[256];
@@ -100,8 +110,16 @@ typedef struct {
     LogicExpression *generated_cache[256];
     char cache_ids[256][64];
     size_t cache_count;
+    
+    /* Пакетное выполнение */
+    size_t threads;             /* 0 = по числу процессоров */
+    MfBatchStats last_batch;
 } MetaFormulaStore;
 
+/* Скомпилированная мета-формула: формулы разобраны один раз в
+ * программы над переменными i (номер ячейки в пакете) и n (размер пакета) */
+typedef struct MfPlan MfPlan;
+
 /* ========== API ========== */
 
 /* Создать хранилище мета-формул */
@@ -183,7 +201,29 @@ int mf_auto_discover_patterns(
     MetaFormulaStore *store
 );
 
-/* Применить мета-формулу к множеству логических ячеек */
+/* Скомпилировать мета-формулу в план; NULL при ошибке разбора */
+MfPlan* mf_compile(const MetaFormula *meta);
+
+/* Выполнить план для ячейки index из count; потокобезопасно */
+LogicExpression* mf_plan_execute(
+    const MfPlan *plan,
+    LogicalMemory *memory,
+    size_t index,
+    size_t count
+);
+
+/* Уничтожить план */
+void mf_plan_destroy(MfPlan *plan);
+
+/* Число потоков пакетного выполнения (0 = по числу процессоров) */
+void mf_set_threads(MetaFormulaStore *store, size_t threads);
+
+/* Применить мета-формулу к множеству логических ячеек.
+ * Формула компилируется один раз, ячейки считаются на пуле потоков
+ * уровнями: ячейка выполняется после ячеек пакета, от которых зависит
+ * (LogicCell.dependencies существующей ячейки, вход трансформации).
+ * Результаты пишутся в память по порядку cell_ids; существующая ячейка
+ * получает новую логику. Возвращает число записанных ячеек или -1 */
 int mf_batch_execute(
     MetaFormulaStore *store,
     const MetaFormula *meta,
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2025 Кочуров Владислав Евгеньевич
+ *
+ * Formula Pool Snapshot
+ * Компактный версионированный снимок KolibriFormulaPool: гены, фитнес,
+ * обратная связь, примеры, состояние генератора и ассоциации. Одинаковые
+ * ассоциации пула и формул хранятся один раз, цифры упакованы по две в
+ * байт. Снимок помнит индекс генома, после которого журнал нужно доиграть.
+ */
+
+#ifndef KOLIBRI_FORMULA_SNAPSHOT_H
+#define KOLIBRI_FORMULA_SNAPSHOT_H
+
+#include "kolibri/formula.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Сведения о снимке
+ */
+typedef struct {
+    uint64_t genome_index;       /* Блоков генома, учтённых в снимке */
+    size_t formulas;
+    size_t examples;
+    size_t associations;         /* Ссылок на ассоциации: пул и формулы */
+    size_t unique_associations;  /* Записей после дедупликации */
+    size_t bytes;                /* Размер файла */
+} KolibriPoolSnapshotInfo;
+
+/**
+ * Запись снимка пула (атомарно через временный файл)
+ *
+ * @param genome_index Число блоков генома, отражённых в состоянии пула
+ * @param info Сведения о записанном снимке (может быть NULL)
+ * @return 0 в случае успеха, -1 при ошибке
+ */
+int kf_pool_snapshot_save(const KolibriFormulaPool *pool, uint64_t genome_index,
+                          const char *path, KolibriPoolSnapshotInfo *info);
+
+/**
+ * Загрузка снимка через mmap. Файл проверяется целиком (границы секций,
+ * лимиты пула, контрольная сумма) до изменения пула: при ошибке пул
+ * остаётся прежним.
+ *
+ * @param info Сведения о снимке, включая genome_index (может быть NULL)
+ * @return 0 в случае успеха, -1 при ошибке или отсутствии файла
+ */
+int kf_pool_snapshot_load(KolibriFormulaPool *pool, const char *path,
+                          KolibriPoolSnapshotInfo *info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KOLIBRI_FORMULA_SNAPSHOT_H */
@@ -11,6 +11,8 @@
 #include "kolibri/context.h"
 #include "kolibri/corpus.h"
 #include "kolibri/formula.h"
+#include "kolibri/ngram.h"
+#include "kolibri/pattern_dict.h"
 #include "kolibri/semantic.h"
 
 #include <stddef.h>
@@ -64,6 +66,20 @@ typedef struct {
     size_t formulas_used;               /* Сколько раз использованы формулы */
     double avg_compression_ratio;       /* Средняя степень компрессии */
     double generation_time_sec;
+    
+    /* Языковая модель */
+    KolibriNgramModel *model;           /* n-граммная модель (NULL - строится из корпуса) */
+    int owns_model;                     /* Модель построена из корпуса и принадлежит контексту */
+    size_t model_corpus_count;          /* corpus->store.count на момент построения */
+    uint32_t history[KOLIBRI_NGRAM_MAX_ORDER]; /* Последние слова, последнее - ближайшее */
+    size_t history_len;
+    uint64_t rng_state;                 /* Состояние генератора выборки */
+    
+    /* Компрессия паттернов */
+    KolibriPatternDict patterns;        /* Паттерны до выгрузки в пул формул */
+    uint32_t *assoc_index;              /* input_hash ассоциации пула -> номер + 1 */
+    size_t assoc_index_slots;           /* Размер индекса (степень двойки) */
+    size_t assoc_indexed;               /* Проиндексировано ассоциаций пула */
 } KolibriGenerationContext;
 
 /**
@@ -85,9 +101,31 @@ int k_gen_init(KolibriGenerationContext *ctx,
  */
 void k_gen_free(KolibriGenerationContext *ctx);
 
+/**
+ * Подключение внешней n-граммной модели (например, k_ngram_load).
+ * Модель не освобождается контекстом и должна жить дольше него.
+ * NULL - вернуться к униграммной модели, построенной из словаря корпуса.
+ * 
+ * @param ctx Контекст генерации
+ * @param model Модель или NULL
+ */
+void k_gen_set_model(KolibriGenerationContext *ctx, KolibriNgramModel *model);
+
+/**
+ * Seed генератора выборки: одинаковый seed даёт одинаковый текст
+ * 
+ * @param ctx Контекст генерации
+ * @param seed Начальное значение
+ */
+void k_gen_set_seed(KolibriGenerationContext *ctx, uint64_t seed);
+
 /**
  * Генерация следующего токена на основе контекста
  * 
+ * GREEDY и BEAM берут самое вероятное слово, SAMPLING и FORMULA -
+ * выборку с temperature. Токен добавляется в историю контекста;
+ * память не выделяется.
+ * 
  * @param ctx Контекст генерации
  * @param output Буфер для результата
  * @param output_size Размер буфера
@@ -100,6 +138,9 @@ int k_gen_next_token(KolibriGenerationContext *ctx,
 /**
  * Генерация текста заданной длины
  * 
+ * История начинается с prompt; в output пишутся только новые токены
+ * через пробел. Стратегия BEAM ищет последовательность целиком.
+ * 
  * @param ctx Контекст генерации
  * @param prompt Начальный текст (может быть NULL)
  * @param num_tokens Количество токенов для генерации
@@ -117,17 +158,43 @@ int k_gen_generate(KolibriGenerationContext *ctx,
  * КЛЮЧЕВАЯ ФУНКЦИЯ: Компрессия паттерна через формулу
  * Использует эволюцию формул для нахождения компактного представления
  * 
+ * Паттерн попадает в словарь ctx->patterns (вставка и дедупликация
+ * за O(1), 40 байт на паттерн); ассоциации пула создаются пакетно
+ * в k_gen_flush_patterns / k_gen_finalize_compression.
+ * 
  * @param ctx Контекст генерации
  * @param pattern Паттерн для компрессии
  * @param formula Результирующая формула (выход)
- * @return Степень компрессии (> 1.0 = хорошо) или -1.0 при ошибке
+ * @return Количество ассоциаций с учётом невыгруженных или -1.0 при ошибке
  */
 double k_gen_compress_pattern(KolibriGenerationContext *ctx,
                               const KolibriSemanticPattern *pattern,
                               KolibriFormula *formula);
 
 /**
- * Финализация компрессии - запускает эволюцию формул
+ * Выгрузка новых и изменённых паттернов словаря в пул формул.
+ * Ассоциация с тем же хэшем обновляется на месте; при переполнении
+ * пула старейшие ассоциации вытесняются одним сдвигом.
+ * 
+ * @param ctx Контекст генерации
+ * @return Количество записанных ассоциаций или -1 при ошибке
+ */
+int k_gen_flush_patterns(KolibriGenerationContext *ctx);
+
+/**
+ * Поиск паттерна в словаре компрессора по хэшу
+ * 
+ * @param ctx Контекст генерации
+ * @param hash Хэш паттерна (input_hash ассоциации)
+ * @param pattern Восстановленный паттерн (выход)
+ * @return 0 в случае успеха, -1 если паттерн не найден
+ */
+int k_gen_lookup_pattern(const KolibriGenerationContext *ctx,
+                         int hash,
+                         KolibriSemanticPattern *pattern);
+
+/**
+ * Финализация компрессии - выгружает паттерны и запускает эволюцию формул
  * ВАЖНО: Вызывать ОДИН РАЗ после добавления ВСЕХ паттернов!
  * 
  * @param ctx Контекст генерации
@@ -189,6 +256,9 @@ int k_gen_decompress_pattern(KolibriGenerationContext *ctx,
 /**
  * Beam search генерация с использованием формул
  * 
+ * Лучшие beam_size продолжений текущей истории по убыванию score
+ * (log2 вероятности).
+ * 
  * @param ctx Контекст генерации
  * @param candidates Массив кандидатов (размер = beam_size)
  * @param num_candidates Количество кандидатов (выход)
@@ -249,7 +319,7 @@ void k_gen_set_temperature(KolibriGenerationContext *ctx, double temperature);
  * Настройка размера beam
  * 
  * @param ctx Контекст генерации
- * @param beam_size Размер beam (1-100)
+ * @param beam_size Размер beam (1-KOLIBRI_BEAM_SIZE)
  */
 void k_gen_set_beam_size(KolibriGenerationContext *ctx, size_t beam_size);
 
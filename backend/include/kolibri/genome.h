@@ -1,6 +1,7 @@
 #ifndef KOLIBRI_GENOME_H
 #define KOLIBRI_GENOME_H
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 
@@ -34,13 +35,38 @@ typedef struct {
   char path[260];
   uint64_t next_index;
   int has_last_block;
+  int verified;          /* Цепочка проверена при открытии (FULL/TAIL) */
+  uint64_t tail_blocks;  /* Блоков в сохранённом состоянии хвоста */
 } KolibriGenome;
 
+/* Проверка при открытии. Состояние хвоста хранится рядом с геномом в
+ * <path>.tail: число блоков и SHA-256 последнего, подписанные ключом. */
+typedef enum {
+  KG_VERIFY_FULL = 0,  /* Все блоки, параллельно */
+  KG_VERIFY_TAIL = 1,  /* Только блоки после сохранённого хвоста; без
+                          пригодного хвоста - как FULL */
+  KG_VERIFY_NONE = 2   /* Без HMAC: читается только последний блок */
+} KolibriGenomeVerify;
+
+typedef struct {
+  KolibriGenomeVerify verify;
+  size_t threads;        /* Потоки проверки FULL, 0 - по числу процессоров */
+} KolibriGenomeOpenOptions;
+
+/* kg_open = kg_open_ex с KG_VERIFY_FULL */
 int kg_open(KolibriGenome *ctx, const char *path, const unsigned char *key,
             size_t key_len);
+int kg_open_ex(KolibriGenome *ctx, const char *path, const unsigned char *key,
+               size_t key_len, const KolibriGenomeOpenOptions *options);
 void kg_close(KolibriGenome *ctx);
 int kg_append(KolibriGenome *ctx, const char *event_type, const char *payload,
               ReasonBlock *out_block);
+/* Appends count blocks with one write and one flush; on failure the file
+ * and the context stay as they were. payloads may be NULL (empty). */
+int kg_append_batch(KolibriGenome *ctx, const char *const *event_types,
+                    const char *const *payloads, size_t count);
+/* Reads block `index` of an open genome (checked at open time). */
+int kg_read_block(KolibriGenome *ctx, uint64_t index, ReasonBlock *out_block);
 int kg_verify_file(const char *path, const unsigned char *key,
                    size_t key_len);
 int kg_encode_payload(const char *utf8, char *out, size_t out_len);
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2025 Кочуров Владислав Евгеньевич
+ *
+ * Kolibri Knowledge Handle
+ * Версионированный индекс знаний с подсчётом ссылок. Запрос берёт текущую
+ * версию и работает с ней до конца, даже если тем временем фоновый поток
+ * собрал и опубликовал новую. Старая версия освобождается, когда её
+ * отпускает последний читатель.
+ */
+
+#ifndef KOLIBRI_KNOWLEDGE_HANDLE_H
+#define KOLIBRI_KNOWLEDGE_HANDLE_H
+
+#include "kolibri/knowledge.h"
+
+#include <stddef.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    KolibriKnowledgeIndex index;
+    unsigned long long version; /* 1, 2, ... в порядке публикации */
+    time_t loaded_at;
+    double build_ms;
+} KolibriKnowledgeVersion;
+
+typedef struct KolibriKnowledgeHandle KolibriKnowledgeHandle;
+
+/* Вызывается после публикации новой версии, в потоке сборки */
+typedef void (*KolibriKnowledgePublishFn)(const KolibriKnowledgeVersion *version, void *user);
+
+/**
+ * Создание дескриптора: первая версия строится сразу, затем запускается
+ * фоновый сборщик.
+ *
+ * @param roots Каталоги с документами (.md, .txt)
+ * @param root_count Число каталогов
+ * @param watch_ms Период проверки изменений в каталогах (0 = не следить)
+ * @return Дескриптор или NULL при ошибке
+ */
+KolibriKnowledgeHandle *kolibri_knowledge_handle_create(const char *const *roots,
+                                                        size_t root_count,
+                                                        unsigned watch_ms);
+
+/**
+ * Остановка сборщика и освобождение. Все версии должны быть отпущены.
+ */
+void kolibri_knowledge_handle_destroy(KolibriKnowledgeHandle *handle);
+
+/**
+ * Текущая версия индекса; не блокируется сборкой. Каждый вызов
+ * парный с kolibri_knowledge_release.
+ */
+const KolibriKnowledgeVersion *kolibri_knowledge_acquire(KolibriKnowledgeHandle *handle);
+
+/**
+ * Отпускание версии; последний читатель устаревшей версии её освобождает.
+ */
+void kolibri_knowledge_release(const KolibriKnowledgeVersion *version);
+
+/**
+ * Запрос пересборки в фоне. Безопасен из любого потока, но не из
+ * обработчика сигнала; несколько запросов во время сборки дают одну.
+ */
+void kolibri_knowledge_request_reload(KolibriKnowledgeHandle *handle);
+
+/**
+ * Обработчик публикации новых версий (NULL - без обработчика). Вызовы
+ * не пересекаются; версия живёт по меньшей мере до выхода из обработчика.
+ * Первая версия строится до установки и обработчик не вызывает.
+ */
+void kolibri_knowledge_handle_on_publish(KolibriKnowledgeHandle *handle,
+                                         KolibriKnowledgePublishFn fn,
+                                         void *user);
+
+/**
+ * Синхронная пересборка и публикация новой версии
+ *
+ * @return 0 при успехе, -1 при ошибке чтения каталога или пустой сборке
+ *         поверх непустой версии (текущая версия остаётся)
+ */
+int kolibri_knowledge_reload(KolibriKnowledgeHandle *handle);
+
+/**
+ * Номер опубликованной версии
+ */
+unsigned long long kolibri_knowledge_handle_version(KolibriKnowledgeHandle *handle);
+
+/**
+ * Число ещё не освобождённых версий, включая текущую
+ */
+size_t kolibri_knowledge_handle_live_versions(const KolibriKnowledgeHandle *handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KOLIBRI_KNOWLEDGE_HANDLE_H */
@@ -33,11 +33,42 @@ typedef struct {
     float idf;
 } KolibriKnowledgeToken;
 
+typedef struct {
+    size_t threads;            /* crawl/parse workers, 0 = one per CPU */
+    const char *manifest_path; /* per-file mtime/size/hash and parsed terms, NULL = none */
+} KolibriKnowledgeBuildOptions;
+
+typedef struct {
+    size_t files_seen;
+    size_t files_parsed;    /* new or changed content */
+    size_t files_unchanged; /* same mtime/size, or same hash */
+    size_t files_removed;
+    size_t vectors_updated;
+} KolibriKnowledgeBuildStats;
+
 int kolibri_knowledge_index_create(const char *const *roots,
                                    size_t root_count,
                                    size_t max_length,
                                    KolibriKnowledgeIndex **out_index);
 
+/* Builds the index on a thread pool. With a manifest, files whose mtime,
+ * size or content hash match the previous run are not re-parsed, and the
+ * manifest is rewritten afterwards. */
+int kolibri_knowledge_index_build(const char *const *roots,
+                                  size_t root_count,
+                                  size_t max_length,
+                                  const KolibriKnowledgeBuildOptions *options,
+                                  KolibriKnowledgeIndex **out_index,
+                                  KolibriKnowledgeBuildStats *out_stats);
+
+/* Re-crawls the roots, re-parses changed files and updates IDF and only
+ * the affected document vectors. Document indices may change. */
+int kolibri_knowledge_index_refresh(KolibriKnowledgeIndex *index,
+                                    KolibriKnowledgeBuildStats *out_stats);
+
+int kolibri_knowledge_index_save_manifest(const KolibriKnowledgeIndex *index,
+                                          const char *path);
+
 void kolibri_knowledge_index_destroy(KolibriKnowledgeIndex *index);
 
 size_t kolibri_knowledge_index_document_count(const KolibriKnowledgeIndex *index);
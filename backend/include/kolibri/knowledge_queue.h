@@ -6,6 +6,7 @@
 #define KOLIBRI_KNOWLEDGE_QUEUE_H
 
 #include <stddef.h>
+#include <stdio.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -18,6 +19,7 @@ typedef enum {
 } KolibriQueueStatus;
 
 typedef struct KolibriQueue KolibriQueue;
+typedef struct KolibriQueueCursor KolibriQueueCursor;
 
 typedef struct {
     long long submission_id;
@@ -32,10 +34,30 @@ typedef struct {
     char *moderated_at;
 } KolibriQueueRecord;
 
+/* Submission for batch insert; source and metadata_json may be NULL. */
+typedef struct {
+    const char *title;
+    const char *content;
+    const char *source;
+    const char *metadata_json;
+} KolibriQueueSubmission;
+
+/* Moderation decision for batch updates; moderator and note may be NULL. */
+typedef struct {
+    long long submission_id;
+    KolibriQueueStatus status;
+    const char *moderator;
+    const char *note;
+} KolibriQueueModeration;
+
+/* Opens the database in WAL mode with synchronous=NORMAL. Prepared
+ * statements are cached in the handle until kolibri_queue_close. */
 int kolibri_queue_open(const char *database_path, KolibriQueue **out_queue);
 
 void kolibri_queue_close(KolibriQueue *queue);
 
+/* metadata_json must be NULL or valid JSON, otherwise SQLITE_CONSTRAINT
+ * is returned and nothing is inserted. */
 int kolibri_queue_enqueue(KolibriQueue *queue,
                           const char *title,
                           const char *content,
@@ -43,6 +65,15 @@ int kolibri_queue_enqueue(KolibriQueue *queue,
                           const char *metadata_json,
                           long long *out_submission_id);
 
+/* Inserts count submissions in one transaction; on error none are
+ * inserted. out_submission_ids (may be NULL) receives count ids. */
+int kolibri_queue_enqueue_batch(KolibriQueue *queue,
+                                const KolibriQueueSubmission *submissions,
+                                size_t count,
+                                long long *out_submission_ids);
+
+/* Records and all their strings share one allocation, released by a
+ * single kolibri_queue_free_records call. */
 int kolibri_queue_fetch(KolibriQueue *queue,
                         KolibriQueueStatus status,
                         size_t limit,
@@ -57,11 +88,48 @@ int kolibri_queue_moderate(KolibriQueue *queue,
                            const char *moderator,
                            const char *note);
 
+/* Applies count decisions in one transaction. Unknown ids are skipped;
+ * out_updated (may be NULL) receives the number of updated submissions.
+ * Any SQLite error rolls back the whole batch. */
+int kolibri_queue_moderate_batch(KolibriQueue *queue,
+                                 const KolibriQueueModeration *moderations,
+                                 size_t count,
+                                 size_t *out_updated);
+
+/* Keyset cursor over one status, ordered by id. Pages of page_size rows
+ * (0 = default) are read with "id > last" so no read transaction stays
+ * open between pages. Without include_content the content column is not
+ * read and the record's content is NULL. */
+int kolibri_queue_cursor_open(KolibriQueue *queue,
+                              KolibriQueueStatus status,
+                              long long after_id,
+                              int include_content,
+                              size_t page_size,
+                              KolibriQueueCursor **out_cursor);
+
+/* Advances the cursor. Returns SQLITE_ROW with *out_record set, SQLITE_DONE
+ * at the end, or an error code. The record and its strings are borrowed
+ * and stay valid until the next call or kolibri_queue_cursor_close. */
+int kolibri_queue_cursor_next(KolibriQueueCursor *cursor,
+                              const KolibriQueueRecord **out_record);
+
+/* Id of the last returned row: pass it as after_id to resume later. */
+long long kolibri_queue_cursor_position(const KolibriQueueCursor *cursor);
+
+void kolibri_queue_cursor_close(KolibriQueueCursor *cursor);
+
+/* Writes one Markdown file per submission, streaming rows from a cursor. */
 int kolibri_queue_export_markdown(KolibriQueue *queue,
                                   KolibriQueueStatus status,
                                   const char *destination_dir,
                                   size_t *out_exported);
 
+/* Streams submissions as JSON Lines (one object per row) into out. */
+int kolibri_queue_export_jsonl(KolibriQueue *queue,
+                               KolibriQueueStatus status,
+                               FILE *out,
+                               size_t *out_exported);
+
 const char *kolibri_queue_status_to_string(KolibriQueueStatus status);
 
 int kolibri_queue_status_from_string(const char *text, KolibriQueueStatus *out_status);
@@ -15,9 +15,20 @@
 #ifndef KOLIBRI_LOGICAL_MEMORY_H
 #define KOLIBRI_LOGICAL_MEMORY_H
 
+#include <pthread.h>
 #include <stddef.h>
 #include <stdint.h>
 
+/* Первые LM_INLINE_CELLS ячеек лежат прямо в структуре, остальные - в
+ * сегментах, выделяемых по мере роста (адреса ячеек не меняются) */
+#define LM_INLINE_CELLS 1024
+#define LM_SEGMENT_CELLS 4096
+#define LM_MAX_SEGMENTS 256
+#define LM_MAX_CELLS (LM_INLINE_CELLS + LM_SEGMENT_CELLS * LM_MAX_SEGMENTS)
+
+/* Бюджет кэша материализаций по умолчанию */
+#define LM_DEFAULT_CACHE_BUDGET (16u << 20)
+
 /* ========== ЛОГИЧЕСКИЕ ПРИМИТИВЫ ========== */
 
 /* Тип логического выражения */
@@ -93,6 +104,10 @@ typedef struct LogicExpression {
     uint64_t creation_time;
     double complexity;      /* Вычислительная сложность */
     size_t materialized_size;  /* Размер при материализации */
+    
+    /* Служебные поля памяти-владельца, меняются под mem->lock */
+    size_t pins;               /* Читатели, работающие с выражением без блокировки */
+    int retired;               /* Заменено в ячейке; освобождает последний читатель */
 } LogicExpression;
 
 /* Логическая ячейка памяти (memory cell) */
@@ -109,11 +124,16 @@ typedef struct {
     /* Связи с другими ячейками */
     char dependencies[16][64];  /* ID зависимых ячеек */
     size_t dependency_count;
+    
+    /* Служебные поля каталога и LRU-кэша (заполняются памятью) */
+    uint32_t id_hash;
+    int32_t lru_prev;          /* Индексы соседей в LRU-списке, -1 = нет */
+    int32_t lru_next;
 } LogicCell;
 
 /* Логическая память (вместо традиционной RAM/storage) */
 typedef struct {
-    LogicCell cells[1024];     /* Ячейки логической памяти */
+    LogicCell cells[LM_INLINE_CELLS];  /* Ячейки логической памяти */
     size_t cell_count;
     
     /* Статистика */
@@ -123,8 +143,42 @@ typedef struct {
     
     /* Индексы для быстрого поиска */
     int (*query_fn)(const char*, LogicCell**);
+    
+    /* Ячейки сверх cells[]; запись в cells[] напрямую допустима только
+     * пока cell_count < LM_INLINE_CELLS */
+    LogicCell *segments[LM_MAX_SEGMENTS];
+    
+    /* Хэш-каталог ячеек: индекс ячейки + 1, 0 = пусто. Ячейки, дописанные
+     * в cells[] напрямую, индексируются лениво при следующем поиске */
+    uint32_t *directory;
+    size_t directory_slots;
+    size_t indexed_count;
+    
+    /* Защищает добавление ячеек, каталог и кэш: API можно вызывать
+     * из нескольких потоков */
+    pthread_mutex_t lock;
+    
+    /* Кэш материализаций с бюджетом в байтах и вытеснением по LRU */
+    size_t cache_budget;
+    size_t cache_bytes;
+    int32_t lru_head;          /* Самая свежая ячейка */
+    int32_t lru_tail;          /* Кандидат на вытеснение */
+    size_t cache_hits;
+    size_t cache_misses;
+    size_t cache_evictions;
 } LogicalMemory;
 
+/* Курсор потоковой материализации: выдаёт байты ячейки порциями
+ * произвольного размера, поддерживает переход к любому смещению.
+ * Курсор на ячейку удерживает её логику до lm_cursor_close, даже если
+ * ячейку тем временем перезаписали; курсор на выражение им не владеет. */
+typedef struct {
+    LogicalMemory *mem;        /* Память, в которой закреплена логика, или NULL */
+    const LogicExpression *logic;
+    size_t size;               /* Точный размер материализации */
+    size_t offset;             /* Текущая позиция */
+} LogicCursor;
+
 /* ========== API ========== */
 
 /* Создать логическую память */
@@ -157,12 +211,67 @@ LogicExpression* lm_optimize_logic(LogicExpression *logic);
 /* Вывести логическое выражение как текст */
 int lm_logic_to_string(LogicExpression *logic, char *output, size_t output_size);
 
-/* Материализовать данные из логики (lazy evaluation) */
+/* Сохранить логику в новой ячейке (память становится владельцем) */
+int lm_store_logic(LogicalMemory *mem, const char *id, LogicExpression *logic);
+
+/* Сохранить логику в ячейке id: новую ячейку или замена логики
+ * существующей (кэш сбрасывается, старая логика уничтожается, когда её
+ * отпустит последний читатель) */
+int lm_put_logic(LogicalMemory *mem, const char *id, LogicExpression *logic);
+
+/* Добавить ячейке id зависимость от ячейки dependency_id */
+int lm_add_dependency(LogicalMemory *mem, const char *id, const char *dependency_id);
+
+/* Закрепить логику ячейки id: она не освободится при замене через
+ * lm_put_logic до парного lm_release_logic. NULL если ячейки нет */
+const LogicExpression* lm_acquire_logic(LogicalMemory *mem, const char *id);
+
+/* Отпустить логику, закреплённую lm_acquire_logic */
+void lm_release_logic(LogicalMemory *mem, const LogicExpression *logic);
+
+/* Найти ячейку по ID через хэш-каталог; NULL если нет */
+LogicCell* lm_find_cell(LogicalMemory *mem, const char *id);
+
+/* Ячейка по порядковому номеру (0..cell_count-1) */
+LogicCell* lm_cell_at(LogicalMemory *mem, size_t index);
+
+/* Материализовать данные из логики (lazy evaluation).
+ * Буфер должен вмещать весь результат и завершающий ноль;
+ * для больших ячеек используйте курсор. Возвращает длину или -1 */
 int lm_materialize(LogicalMemory *mem, const char *id, void *output, size_t output_size);
 
-/* Запросить размер материализованных данных (без материализации) */
+/* Запросить точный размер материализованных данных (без материализации) */
 size_t lm_predict_size(LogicalMemory *mem, const char *id);
 
+/* Точный размер материализации выражения; -1 если тип не материализуется */
+int lm_logic_size(const LogicExpression *logic, size_t *size);
+
+/* Задать бюджет кэша в байтах (0 - не кэшировать), лишнее вытесняется сразу */
+void lm_set_cache_budget(LogicalMemory *mem, size_t budget);
+
+/* ========== ПОТОКОВАЯ МАТЕРИАЛИЗАЦИЯ ========== */
+
+/* Открыть курсор на ячейку; 0 или -1 если ячейки нет или она не материализуется.
+ * Каждый открытый курсор закрывается lm_cursor_close до уничтожения памяти */
+int lm_cursor_open(LogicalMemory *mem, const char *id, LogicCursor *cursor);
+
+/* Закрыть курсор и отпустить логику ячейки */
+void lm_cursor_close(LogicCursor *cursor);
+
+/* Открыть курсор прямо на выражение */
+int lm_cursor_open_logic(const LogicExpression *logic, LogicCursor *cursor);
+
+/* Прочитать до size байт с текущей позиции; 0 в конце данных.
+ * Без завершающего нуля */
+size_t lm_cursor_read(LogicCursor *cursor, void *buffer, size_t size);
+
+/* Перейти к смещению (0..size); REPEAT и SEQUENCE - за O(1)/O(разрядов) */
+int lm_cursor_seek(LogicCursor *cursor, size_t offset);
+
+/* Текущая позиция и полный размер */
+size_t lm_cursor_tell(const LogicCursor *cursor);
+size_t lm_cursor_size(const LogicCursor *cursor);
+
 /* Уничтожить логическое выражение */
 void lm_destroy_logic(LogicExpression *logic);
 
@@ -173,7 +282,12 @@ typedef struct {
     size_t predicted_data_size;
     double compression_ratio;
     size_t cached_cells;
-    size_t cache_hit_rate;
+    size_t cache_hit_rate;     /* Процент попаданий в кэш */
+    size_t cache_bytes;
+    size_t cache_budget;
+    size_t cache_hits;
+    size_t cache_misses;
+    size_t cache_evictions;
 } LogicalMemoryStats;
 
 int lm_get_stats(LogicalMemory *mem, LogicalMemoryStats *stats);
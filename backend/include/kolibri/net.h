@@ -42,6 +42,9 @@ size_t kn_message_encode_hello(uint8_t *buffer, size_t buffer_len, uint32_t node
 size_t kn_message_encode_formula(uint8_t *buffer, size_t buffer_len, uint32_t node_id, const KolibriFormula *formula);
 size_t kn_message_encode_ack(uint8_t *buffer, size_t buffer_len, uint8_t status);
 int kn_message_decode(const uint8_t *buffer, size_t buffer_len, KolibriNetMessage *out_message);
+/* Размер кадра по заголовку: 1 - размер известен, 0 - заголовок неполон,
+ * -1 - кадр превышает допустимую длину */
+int kn_message_frame_size(const uint8_t *buffer, size_t buffer_len, size_t *out_size);
 
 int kn_share_formula(const char *host, uint16_t port, uint32_t node_id, const KolibriFormula *formula);
 
@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2025 Кочуров Владислав Евгеньевич
+ *
+ * N-gram Language Model
+ * Компактная n-граммная модель: отсортированные контексты с
+ * квантованными вероятностями, построение из корпуса и загрузка через mmap
+ */
+
+#ifndef KOLIBRI_NGRAM_H
+#define KOLIBRI_NGRAM_H
+
+#include "kolibri/corpus.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Максимальный и стандартный порядок модели */
+#define KOLIBRI_NGRAM_MAX_ORDER 5
+#define KOLIBRI_NGRAM_DEFAULT_ORDER 3
+
+/* Максимальная длина слова в байтах (длиннее - обрезается) */
+#define KOLIBRI_NGRAM_MAX_WORD 127
+
+/* Максимальный размер словаря (номер слова занимает 22 бита) */
+#define KOLIBRI_NGRAM_MAX_VOCAB ((1u << 22) - 1u)
+
+/* Номер неизвестного слова */
+#define KOLIBRI_NGRAM_UNK 0u
+
+/* Максимум вариантов в k_ngram_top */
+#define KOLIBRI_NGRAM_MAX_TOP 64
+
+typedef struct KolibriNgramBuilder KolibriNgramBuilder;
+typedef struct KolibriNgramModel KolibriNgramModel;
+
+/**
+ * Вариант следующего слова
+ */
+typedef struct {
+    uint32_t word;                /* Номер слова */
+    double logprob;               /* log2 вероятности */
+} KolibriNgramChoice;
+
+/**
+ * Сведения о модели
+ */
+typedef struct {
+    unsigned order;                               /* Порядок модели */
+    size_t vocab_size;                            /* Слов вместе с <unk> */
+    uint64_t total_tokens;                        /* Токенов в обучении */
+    size_t contexts[KOLIBRI_NGRAM_MAX_ORDER + 1]; /* Контекстов порядка k */
+    size_t ngrams[KOLIBRI_NGRAM_MAX_ORDER + 1];   /* n-грамм порядка k */
+    size_t bytes;                                 /* Размер образа модели */
+    int mapped;                                   /* Загружена через mmap */
+} KolibriNgramInfo;
+
+/**
+ * Создание построителя модели
+ *
+ * @param order Порядок модели (1..KOLIBRI_NGRAM_MAX_ORDER, 0 = по умолчанию)
+ * @return Построитель или NULL при ошибке
+ */
+KolibriNgramBuilder *k_ngram_builder_create(unsigned order);
+
+/**
+ * Освобождение построителя
+ */
+void k_ngram_builder_destroy(KolibriNgramBuilder *builder);
+
+/**
+ * Добавление словаря корпуса: каждое слово хранилища получает
+ * униграммный счётчик usage_count (не меньше 1)
+ *
+ * @return 0 в случае успеха, -1 при ошибке
+ */
+int k_ngram_builder_add_corpus(KolibriNgramBuilder *builder,
+                               const KolibriCorpusContext *corpus);
+
+/**
+ * Добавление документа: токенизация по правилам k_corpus_tokenize
+ * (пробелы и пунктуация), подсчёт n-грамм всех порядков.
+ * Контекст не переходит через границу документов.
+ *
+ * @return 0 в случае успеха, -1 при ошибке
+ */
+int k_ngram_builder_add_text(KolibriNgramBuilder *builder,
+                             const char *text,
+                             size_t text_len);
+
+/**
+ * Построение модели в памяти. Построитель остаётся пригодным
+ * для дальнейшего пополнения.
+ *
+ * @return Модель или NULL при ошибке
+ */
+KolibriNgramModel *k_ngram_build(const KolibriNgramBuilder *builder);
+
+/**
+ * Запись модели в файл (атомарно через временный файл)
+ *
+ * @return 0 в случае успеха, -1 при ошибке
+ */
+int k_ngram_save(const KolibriNgramModel *model, const char *path);
+
+/**
+ * Загрузка модели через mmap: проверяется только заголовок и границы
+ * секций, данные не копируются
+ *
+ * @return Модель или NULL при ошибке
+ */
+KolibriNgramModel *k_ngram_load(const char *path);
+
+/**
+ * Освобождение модели
+ */
+void k_ngram_free(KolibriNgramModel *model);
+
+/**
+ * Сведения о модели
+ */
+void k_ngram_get_info(const KolibriNgramModel *model, KolibriNgramInfo *info);
+
+/**
+ * Номер слова или KOLIBRI_NGRAM_UNK
+ */
+uint32_t k_ngram_lookup(const KolibriNgramModel *model, const char *word, size_t len);
+
+/**
+ * Слово по номеру (строка внутри модели) или NULL
+ */
+const char *k_ngram_word(const KolibriNgramModel *model, uint32_t word);
+
+/**
+ * Токенизация текста в номера слов без выделения памяти
+ *
+ * @param ids Буфер номеров (может быть NULL при max_ids = 0)
+ * @return Количество слов в тексте; записано не больше max_ids
+ */
+size_t k_ngram_tokenize(const KolibriNgramModel *model,
+                        const char *text,
+                        size_t text_len,
+                        uint32_t *ids,
+                        size_t max_ids);
+
+/**
+ * log2 вероятности слова после истории (интерполяция Виттена-Белла)
+ *
+ * @param history Предыдущие слова, последнее - ближайшее
+ */
+double k_ngram_logprob(const KolibriNgramModel *model,
+                       const uint32_t *history,
+                       size_t history_len,
+                       uint32_t word);
+
+/**
+ * Выборка следующего слова без выделения памяти
+ *
+ * @param temperature 0 и меньше - жадный выбор
+ * @param rng Состояние генератора (xorshift64*), не ноль
+ * @return Номер слова (KOLIBRI_NGRAM_UNK только для пустой модели)
+ */
+uint32_t k_ngram_sample(const KolibriNgramModel *model,
+                        const uint32_t *history,
+                        size_t history_len,
+                        double temperature,
+                        uint64_t *rng);
+
+/**
+ * Лучшие k следующих слов (ограниченная куча), по убыванию вероятности
+ *
+ * @param k Не больше KOLIBRI_NGRAM_MAX_TOP
+ * @return Количество записанных вариантов
+ */
+size_t k_ngram_top(const KolibriNgramModel *model,
+                   const uint32_t *history,
+                   size_t history_len,
+                   KolibriNgramChoice *out,
+                   size_t k);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KOLIBRI_NGRAM_H */
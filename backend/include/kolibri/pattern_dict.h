@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2025 Кочуров Владислав Евгеньевич
+ *
+ * Pattern Dictionary
+ * Компактный словарь хэш -> 64-цифровой паттерн для компрессора генерации:
+ * цифры упакованы по две в байт, вставка и поиск за O(1)
+ */
+
+#ifndef KOLIBRI_PATTERN_DICT_H
+#define KOLIBRI_PATTERN_DICT_H
+
+#include "kolibri/semantic.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Байт на упакованный паттерн */
+#define KOLIBRI_PATTERN_DICT_PACKED (KOLIBRI_SEMANTIC_PATTERN_SIZE / 2)
+
+/**
+ * Запись словаря (40 байт)
+ */
+typedef struct {
+    int32_t hash;                                  /* Хэш строки цифр (kf_hash_from_text) */
+    uint32_t pending;                              /* Добавлена или изменена после выгрузки */
+    uint8_t digits[KOLIBRI_PATTERN_DICT_PACKED];   /* Цифры: младший полубайт - чётная */
+} KolibriPatternEntry;
+
+/**
+ * Словарь паттернов; записи хранятся в порядке первой вставки
+ */
+typedef struct {
+    KolibriPatternEntry *entries;
+    size_t count;
+    size_t capacity;
+    uint32_t *slots;              /* Открытая адресация: номер записи + 1 */
+    size_t slot_count;            /* Степень двойки, заполнение не больше половины */
+    size_t pending;               /* Записей с флагом pending */
+    size_t inserted;              /* Новых записей после k_pattern_dict_clear_pending */
+} KolibriPatternDict;
+
+/**
+ * Инициализация словаря
+ *
+ * @param capacity Ожидаемое число паттернов (0 = по умолчанию)
+ * @return 0 в случае успеха, -1 при ошибке
+ */
+int k_pattern_dict_init(KolibriPatternDict *dict, size_t capacity);
+
+/**
+ * Освобождение ресурсов словаря
+ */
+void k_pattern_dict_free(KolibriPatternDict *dict);
+
+/**
+ * Вставка или замена паттерна
+ *
+ * @param hash Хэш паттерна
+ * @param pattern 64 цифры 0-9
+ * @return 1 - новая запись, 0 - запись обновлена, -1 при ошибке
+ */
+int k_pattern_dict_put(KolibriPatternDict *dict, int32_t hash,
+                       const uint8_t pattern[KOLIBRI_SEMANTIC_PATTERN_SIZE]);
+
+/**
+ * Поиск записи по хэшу
+ *
+ * @return Запись или NULL
+ */
+const KolibriPatternEntry *k_pattern_dict_find(const KolibriPatternDict *dict, int32_t hash);
+
+/**
+ * Распаковка цифр записи
+ */
+void k_pattern_dict_unpack(const KolibriPatternEntry *entry,
+                           uint8_t pattern[KOLIBRI_SEMANTIC_PATTERN_SIZE]);
+
+/**
+ * Снять флаги pending со всех записей (после выгрузки)
+ */
+void k_pattern_dict_clear_pending(KolibriPatternDict *dict);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KOLIBRI_PATTERN_DICT_H */
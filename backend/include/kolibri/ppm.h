@@ -0,0 +1,100 @@
+/*
+ * Kolibri OS Archiver - PPM context model
+ * Hashed, arena-backed prediction by partial matching with a memory budget
+ */
+
+#ifndef KOLIBRI_PPM_H
+#define KOLIBRI_PPM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Highest supported context order (contexts hash up to 8 previous bytes) */
+#define KOLIBRI_PPM_MAX_ORDER 8
+#define KOLIBRI_PPM_DEFAULT_ORDER 5
+
+/* Memory budget for context tables and symbol lists */
+#define KOLIBRI_PPM_MIN_MEMORY (1u << 16)
+#define KOLIBRI_PPM_DEFAULT_MEMORY (32u << 20)
+#define KOLIBRI_PPM_MAX_MEMORY ((size_t)1 << 30)
+
+typedef struct {
+    unsigned order;         /* 1..KOLIBRI_PPM_MAX_ORDER, 0 = default */
+    size_t memory_limit;    /* bytes, 0 = KOLIBRI_PPM_DEFAULT_MEMORY */
+} KolibriPpmConfig;
+
+typedef struct {
+    size_t contexts;        /* live contexts in the hash table */
+    size_t evictions;       /* contexts replaced in a full bucket */
+    size_t restarts;        /* model flushes after the symbol pool filled up */
+    size_t memory_used;     /* bytes of the arena handed out so far */
+    size_t memory_limit;    /* arena size */
+} KolibriPpmStats;
+
+typedef struct KolibriPpmModel KolibriPpmModel;
+
+/**
+ * Create a model. The whole budget is allocated up front; coding never
+ * allocates. Encoder and decoder must use the same configuration.
+ * @param config Order and memory budget, NULL for defaults
+ * @return New model or NULL on failure
+ */
+KolibriPpmModel *kolibri_ppm_create(const KolibriPpmConfig *config);
+
+/**
+ * Destroy a model
+ */
+void kolibri_ppm_destroy(KolibriPpmModel *model);
+
+/**
+ * Forget all statistics; called automatically at the start of every
+ * encode/decode so a model can be reused for independent inputs.
+ */
+void kolibri_ppm_reset(KolibriPpmModel *model);
+
+/**
+ * Effective configuration of a model (defaults resolved, budget clamped)
+ */
+void kolibri_ppm_get_config(const KolibriPpmModel *model, KolibriPpmConfig *config);
+
+/**
+ * Statistics of the last encode/decode
+ */
+void kolibri_ppm_get_stats(const KolibriPpmModel *model, KolibriPpmStats *stats);
+
+/**
+ * Encode bytes with the model
+ * @param model Model instance
+ * @param input Input bytes
+ * @param length Number of input bytes
+ * @param output Output buffer
+ * @param capacity Output buffer size
+ * @param output_size Bytes written
+ * @return 0 on success, -1 if the output does not fit in capacity
+ */
+int kolibri_ppm_encode(KolibriPpmModel *model,
+                       const uint8_t *input,
+                       size_t length,
+                       uint8_t *output,
+                       size_t capacity,
+                       size_t *output_size);
+
+/**
+ * Decode exactly length bytes produced by kolibri_ppm_encode
+ * @return 0 on success, -1 on malformed input
+ */
+int kolibri_ppm_decode(KolibriPpmModel *model,
+                       const uint8_t *input,
+                       size_t input_size,
+                       uint8_t *output,
+                       size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KOLIBRI_PPM_H */
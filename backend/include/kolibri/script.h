@@ -28,6 +28,25 @@ typedef struct {
     int has_evaluate;
 } KolibriCrystalCore;
 
+/*
+ * Приёмник вывода сценария: получает очередной фрагмент текста (без
+ * завершающего нуля), возвращает 0 при успехе.
+ */
+typedef int (*KolibriScriptWriteFn)(void *user, const char *data, size_t length);
+
+typedef struct {
+    KolibriScriptWriteFn write;
+    void *user;
+} KolibriScriptSink;
+
+/* Растущий буфер вывода в памяти, всегда завершён нулём. */
+typedef struct {
+    char *data;
+    size_t length;
+    size_t capacity;
+    int failed;
+} KolibriScriptBuffer;
+
 /*
  * Контекст исполнения KolibriScript. Хранит цифровой поток сценария, кристалл
  * генезиса и предоставляет доступ к пулу формул и цифровому геному.
@@ -57,18 +76,52 @@ typedef struct {
     struct KolibriScriptFormulaBinding *formulas;
     size_t formulas_count;
     size_t formulas_capacity;
+
+    /* Output */
+    KolibriScriptSink sink;      /* write == NULL: вывод идёт в vyvod */
+    KolibriScriptBuffer buffer;  /* Буфер ks_capture_output */
+
+    /* Изменения поверх общего пула (ks_init_shared) */
+    const KolibriFormulaPool *base;  /* Неизменяемый общий пул */
+    KolibriPoolOverlay overlay;      /* Ассоциации и формулы этого контекста */
+    size_t symbol_mark;              /* Символы и страницы после инициализации */
+    size_t symbol_page_mark;
 } KolibriScript;
 
 /* Инициализирует интерпретатор и выделяет внутренний цифровой буфер. */
 int ks_init(KolibriScript *skript, KolibriFormulaPool *pool,
             KolibriGenome *genome);
 
+/* Инициализирует интерпретатор над общим пулом, который он не изменяет:
+ * обучение и эволюция пишут в оверлей контекста, base не копируется.
+ * base должен оставаться неизменным, пока контекст жив. */
+int ks_init_shared(KolibriScript *skript, const KolibriFormulaPool *base,
+                   KolibriGenome *genome);
+
+/* Сбрасывает состояние запроса: переменные, формулы, кристалл, режим и
+ * вывод. Контекст над общим пулом возвращается к base, новые символы без
+ * генома откатываются. Память оверлея сохраняется для повторного
+ * использования. */
+void ks_reset(KolibriScript *skript);
+
 /* Освобождает выделенные ресурсы интерпретатора. */
 void ks_free(KolibriScript *skript);
 
 /* Переназначает поток вывода интерпретатора (по умолчанию stdout). */
 void ks_set_output(KolibriScript *skript, FILE *vyvod);
 
+/* Направляет вывод в пользовательский приёмник (NULL - обратно в stdout). */
+void ks_set_sink(KolibriScript *skript, KolibriScriptWriteFn write, void *user);
+
+/* Направляет вывод во встроенный буфер в памяти и очищает его. Память
+ * буфера переиспользуется между запусками и освобождается в ks_free. */
+void ks_capture_output(KolibriScript *skript);
+
+/* Возвращает накопленный вывод без копирования. Указатель действителен до
+ * следующей записи, ks_capture_output или ks_free; NULL, если памяти не
+ * хватило и часть вывода потеряна. */
+const char *ks_output(const KolibriScript *skript, size_t *length);
+
 /* Загружает русскоязычный сценарий из текстовой строки. */
 int ks_load_text(KolibriScript *skript, const char *text);
 
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2025 Кочуров Владислав Евгеньевич
+ *
+ * KolibriScript Context Pool
+ * Набор заранее инициализированных интерпретаторов над одним общим
+ * неизменяемым пулом формул. Рабочий поток берёт контекст, выполняет
+ * сценарий и возвращает его; возврат сбрасывает только изменённое
+ * запросом состояние.
+ */
+
+#ifndef KOLIBRI_SCRIPT_POOL_H
+#define KOLIBRI_SCRIPT_POOL_H
+
+#include "kolibri/formula.h"
+#include "kolibri/script.h"
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct KolibriScriptContextPool KolibriScriptContextPool;
+
+/**
+ * Создание пула контекстов
+ *
+ * @param base Общий пул формул; не должен меняться, пока пул контекстов жив
+ * @param contexts Число контекстов (0 = по числу процессоров)
+ * @return Пул контекстов или NULL при ошибке
+ */
+KolibriScriptContextPool *ks_context_pool_create(const KolibriFormulaPool *base,
+                                                 size_t contexts);
+
+/**
+ * Уничтожение пула. Все контексты должны быть возвращены.
+ */
+void ks_context_pool_destroy(KolibriScriptContextPool *pool);
+
+/**
+ * Получение свободного контекста (ожидает, если все заняты). Вывод
+ * контекста направлен во встроенный буфер (ks_output).
+ */
+KolibriScript *ks_context_acquire(KolibriScriptContextPool *pool);
+
+/**
+ * Возврат контекста в пул со сбросом состояния запроса (ks_reset).
+ */
+void ks_context_release(KolibriScriptContextPool *pool, KolibriScript *script);
+
+/**
+ * Число контекстов в пуле
+ */
+size_t ks_context_pool_size(const KolibriScriptContextPool *pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KOLIBRI_SCRIPT_POOL_H */
@@ -35,6 +35,22 @@ typedef struct {
     char word[128];                                  /* Само слово (для отладки) */
 } KolibriSemanticPattern;
 
+/* Размер популяции эволюции по умолчанию */
+#define KOLIBRI_SEMANTIC_POPULATION 50
+#define KOLIBRI_SEMANTIC_POPULATION_MAX 256
+
+/**
+ * Параметры эволюционного обучения
+ */
+typedef struct {
+    size_t population;            /* Размер популяции (2..POPULATION_MAX) */
+    size_t generations;           /* Максимум поколений */
+    uint64_t seed;                /* Начальное значение генератора */
+    unsigned mutation_percent;    /* Вероятность мутации потомка, % */
+    size_t patience;              /* Остановка после N поколений без улучшения (0 = выкл.) */
+    double min_delta;             /* Минимальный прирост, считающийся улучшением */
+} KolibriEvolutionConfig;
+
 /**
  * Контекст для семантического обучения
  */
@@ -43,6 +59,8 @@ typedef struct {
     kolibri_potok_cifr context_words[KOLIBRI_SEMANTIC_CONTEXT_MAX]; /* Окружающие слова */
     size_t context_count;                            /* Количество слов в контексте */
     double relevance[KOLIBRI_SEMANTIC_CONTEXT_MAX]; /* Релевантность каждого слова */
+    /* Буферы context_words: fitness сравнивает не больше PATTERN_SIZE цифр */
+    uint8_t word_data[KOLIBRI_SEMANTIC_CONTEXT_MAX][KOLIBRI_SEMANTIC_PATTERN_SIZE];
 } KolibriSemanticContext;
 
 /**
@@ -94,6 +112,47 @@ int k_semantic_learn(const char *word,
                      size_t generations,
                      KolibriSemanticPattern *pattern);
 
+/**
+ * Эволюционное обучение с явным seed (воспроизводимый результат)
+ * 
+ * @param word Слово для обучения
+ * @param ctx Контекст (окружающие слова)
+ * @param generations Количество поколений эволюции
+ * @param seed Начальное значение генератора
+ * @param pattern Выходной паттерн
+ * @return 0 в случае успеха, -1 при ошибке
+ */
+int k_semantic_learn_seeded(const char *word,
+                            const KolibriSemanticContext *ctx,
+                            size_t generations,
+                            uint64_t seed,
+                            KolibriSemanticPattern *pattern);
+
+/**
+ * Параметры эволюции по умолчанию (популяция 50, мутация 10%,
+ * остановка после 50 поколений без улучшения)
+ */
+void k_semantic_evolution_config_default(KolibriEvolutionConfig *config);
+
+/**
+ * Эволюционное обучение с полной конфигурацией
+ * 
+ * Ранняя остановка: при достижении максимального fitness или когда
+ * лучший fitness не растёт config->patience поколений подряд.
+ * 
+ * @param word Слово для обучения
+ * @param ctx Контекст (окружающие слова)
+ * @param config Параметры эволюции (NULL = по умолчанию)
+ * @param pattern Выходной паттерн
+ * @param generations_run Выполнено поколений (может быть NULL)
+ * @return 0 в случае успеха, -1 при ошибке
+ */
+int k_semantic_learn_config(const char *word,
+                            const KolibriSemanticContext *ctx,
+                            const KolibriEvolutionConfig *config,
+                            KolibriSemanticPattern *pattern,
+                            size_t *generations_run);
+
 /**
  * Вычисление сходства между двумя паттернами
  * 
@@ -104,6 +163,32 @@ int k_semantic_learn(const char *word,
 double k_semantic_similarity(const KolibriSemanticPattern *p1,
                             const KolibriSemanticPattern *p2);
 
+/**
+ * Количество позиций, в которых два массива цифр совпадают
+ * (SSE2/AVX2/NEON сравнение + popcount, где доступно)
+ *
+ * @param a Первый массив
+ * @param b Второй массив
+ * @param length Длина сравниваемого участка
+ * @return Число совпадающих байт
+ */
+size_t k_semantic_count_equal(const uint8_t *a, const uint8_t *b, size_t length);
+
+/**
+ * Пакетный подсчёт совпадений запроса с паттернами в SoA-раскладке
+ * (count подряд идущих блоков по KOLIBRI_SEMANTIC_PATTERN_SIZE цифр).
+ * На x86 с AVX2 выбирается во время выполнения, иначе SSE2/NEON/скаляр.
+ *
+ * @param query Паттерн запроса (KOLIBRI_SEMANTIC_PATTERN_SIZE цифр)
+ * @param patterns Паттерны кандидатов
+ * @param count Количество кандидатов
+ * @param matches Выход: число совпадающих цифр для каждого кандидата
+ */
+void k_semantic_count_equal_batch(const uint8_t *query,
+                                  const uint8_t *patterns,
+                                  size_t count,
+                                  uint8_t *matches);
+
 /**
  * Поиск ближайшего паттерна из набора
  * 
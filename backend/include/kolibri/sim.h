@@ -12,6 +12,17 @@
 extern "C" {
 #endif
 
+/* Log records are fixed-size slots of a preallocated ring; longer
+ * strings are truncated. */
+#define KOLIBRI_SIM_LOG_CAPACITY 512
+#define KOLIBRI_SIM_LOG_TIP_MAX 16
+#define KOLIBRI_SIM_LOG_MESSAGE_MAX 160
+
+/* Upper bound for kolibri_sim_tick_many workers. */
+#define KOLIBRI_SIM_MAX_THREADS 64
+
+/* Every instance is independent and guarded by its own lock, so
+ * different instances may be used from different threads. */
 typedef struct KolibriSim KolibriSim;
 
 typedef struct {
@@ -48,6 +59,17 @@ void kolibri_sim_destroy(KolibriSim *sim);
 
 int kolibri_sim_tick(KolibriSim *sim);
 
+/* Advances each of the `count` instances by `steps` ticks on up to
+ * `threads` workers (0 = one per online CPU). Instances evolve only from
+ * their own seed, so the outcome does not depend on the thread count.
+ * Returns 0 on success, -1 on invalid arguments. */
+int kolibri_sim_tick_many(KolibriSim *const *sims,
+                          size_t count,
+                          size_t steps,
+                          size_t threads);
+
+/* The returned strings point into the log ring and stay valid until the
+ * next tick or reset of the same instance. */
 int kolibri_sim_get_logs(KolibriSim *sim,
                          KolibriSimLog *buffer,
                          size_t capacity,
@@ -10,8 +10,21 @@
 extern "C" {
 #endif
 
-#define KOLIBRI_SYMBOL_MAX 256
 #define KOLIBRI_SYMBOL_DIGITS 3
+/* Все 3-значные коды: 10^KOLIBRI_SYMBOL_DIGITS символов. */
+#define KOLIBRI_SYMBOL_MAX 1000
+
+/* Двухуровневая прямая таблица codepoint -> символ (весь диапазон Unicode).
+ * Когда страницы пула кончаются, новые записи ищутся линейным перебором. */
+#define KOLIBRI_SYMBOL_CODEPOINT_LIMIT 0x110000U
+#define KOLIBRI_SYMBOL_PAGE_BITS 8U
+#define KOLIBRI_SYMBOL_PAGE_SIZE (1U << KOLIBRI_SYMBOL_PAGE_BITS)
+#define KOLIBRI_SYMBOL_PAGE_COUNT (KOLIBRI_SYMBOL_CODEPOINT_LIMIT >> KOLIBRI_SYMBOL_PAGE_BITS)
+#define KOLIBRI_SYMBOL_PAGE_POOL 128
+
+/* Новые отображения копятся и пишутся в геном одним блоком SYMBOL_BATCH. */
+#define KOLIBRI_SYMBOL_BATCH_RECORD 10
+#define KOLIBRI_SYMBOL_BATCH_MAX ((KOLIBRI_PAYLOAD_SIZE - 1) / KOLIBRI_SYMBOL_BATCH_RECORD)
 
 typedef struct {
     uint32_t codepoint;
@@ -23,15 +36,46 @@ typedef struct {
     size_t count;
     uint64_t version;
     KolibriGenome *genome;
+    /* номер страницы + 1 для старших бит codepoint, 0 — страницы нет */
+    uint8_t page_index[KOLIBRI_SYMBOL_PAGE_COUNT];
+    /* индекс записи + 1 для младших бит codepoint */
+    uint16_t pages[KOLIBRI_SYMBOL_PAGE_POOL][KOLIBRI_SYMBOL_PAGE_SIZE];
+    size_t page_count;
+    /* записи, которым не хватило страницы пула: ищутся линейно */
+    uint16_t overflow[KOLIBRI_SYMBOL_MAX];
+    size_t overflow_count;
+    /* обратное отображение: код d0*100+d1*10+d2 -> индекс записи + 1 */
+    uint16_t by_code[KOLIBRI_SYMBOL_MAX];
+    uint16_t pending[KOLIBRI_SYMBOL_BATCH_MAX];
+    size_t pending_count;
 } KolibriSymbolTable;
 
 void kolibri_symbol_table_init(KolibriSymbolTable *table, KolibriGenome *genome);
 void kolibri_symbol_table_load(KolibriSymbolTable *table);
 void kolibri_symbol_table_seed_defaults(KolibriSymbolTable *table);
+/* Записывает накопленные отображения в геном. Возвращает 0 или -1. */
+int kolibri_symbol_table_flush(KolibriSymbolTable *table);
+/* Откатывает отображения, добавленные после отметки (count записей и
+ * page_count страниц). Стоимость пропорциональна числу новых записей. */
+void kolibri_symbol_table_rollback(KolibriSymbolTable *table, size_t count, size_t page_count);
 int kolibri_symbol_encode(KolibriSymbolTable *table, uint32_t codepoint, uint8_t out_digits[KOLIBRI_SYMBOL_DIGITS]);
 int kolibri_symbol_decode(const KolibriSymbolTable *table,
                           const uint8_t digits[KOLIBRI_SYMBOL_DIGITS],
                           uint32_t *out_codepoint);
+/*
+ * Кодирует UTF-8 строку в цифры (KOLIBRI_SYMBOL_DIGITS на символ).
+ * Некорректные байты кодируются как отдельные codepoint'ы.
+ * Кодирование останавливается, когда следующий символ не помещается в out.
+ * В *out_length - число записанных цифр. Возвращает -1, если для символа
+ * не нашлось кода (пространство кодов исчерпано или не удалось записать
+ * очередь в геном); *out_length тогда указывает на этот символ.
+ */
+int kolibri_symbol_encode_utf8(KolibriSymbolTable *table,
+                               const char *utf8,
+                               size_t length,
+                               uint8_t *out,
+                               size_t out_capacity,
+                               size_t *out_length);
 
 #ifdef __cplusplus
 }
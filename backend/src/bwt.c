@@ -0,0 +1,380 @@
+/*
+ * Kolibri OS Archiver - Burrows-Wheeler transform
+ * SA-IS suffix array construction (Nong, Zhang, Chan) and block BWT
+ */
+
+#include "kolibri/bwt.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define BWT_MAX_THREADS 64
+
+/*
+ * Text view for one SA-IS level. Level 0 reads bytes shifted by one
+ * with a virtual 0 terminator at n - 1; deeper levels read the reduced
+ * int32_t string, whose last symbol is already the unique minimum.
+ */
+typedef struct {
+    const uint8_t *bytes;
+    const int32_t *ints;
+    int32_t n;
+} SaisText;
+
+static inline int32_t sais_chr(const SaisText *s, int32_t i) {
+    if (s->ints) return s->ints[i];
+    return i == s->n - 1 ? 0 : (int32_t)s->bytes[i] + 1;
+}
+
+/* Type bits: 1 = S-type, 0 = L-type */
+static inline int sais_tget(const uint8_t *t, int32_t i) {
+    return (t[i >> 3] >> (i & 7)) & 1;
+}
+
+static inline void sais_tset(uint8_t *t, int32_t i, int value) {
+    if (value) {
+        t[i >> 3] |= (uint8_t)(1u << (i & 7));
+    } else {
+        t[i >> 3] &= (uint8_t)~(1u << (i & 7));
+    }
+}
+
+static inline int sais_is_lms(const uint8_t *t, int32_t i) {
+    return i > 0 && sais_tget(t, i) && !sais_tget(t, i - 1);
+}
+
+static void sais_buckets(const SaisText *s, int32_t *bkt, int32_t k, int end) {
+    memset(bkt, 0, (size_t)(k + 1) * sizeof(int32_t));
+    for (int32_t i = 0; i < s->n; i++) bkt[sais_chr(s, i)]++;
+    int32_t sum = 0;
+    for (int32_t i = 0; i <= k; i++) {
+        sum += bkt[i];
+        bkt[i] = end ? sum : sum - bkt[i];
+    }
+}
+
+static void sais_induce_l(const SaisText *s, const uint8_t *t, int32_t *sa,
+                          int32_t *bkt, int32_t k) {
+    sais_buckets(s, bkt, k, 0);
+    for (int32_t i = 0; i < s->n; i++) {
+        int32_t j = sa[i] - 1;
+        if (j >= 0 && !sais_tget(t, j)) sa[bkt[sais_chr(s, j)]++] = j;
+    }
+}
+
+static void sais_induce_s(const SaisText *s, const uint8_t *t, int32_t *sa,
+                          int32_t *bkt, int32_t k) {
+    sais_buckets(s, bkt, k, 1);
+    for (int32_t i = s->n - 1; i >= 0; i--) {
+        int32_t j = sa[i] - 1;
+        if (j >= 0 && sais_tget(t, j)) sa[--bkt[sais_chr(s, j)]] = j;
+    }
+}
+
+static int sais_level(const SaisText *s, int32_t *sa, int32_t k) {
+    int32_t n = s->n;
+    if (n == 1) {
+        sa[0] = 0;
+        return 0;
+    }
+
+    uint8_t *t = (uint8_t *)calloc((size_t)n / 8 + 1, 1);
+    int32_t *bkt = (int32_t *)malloc((size_t)(k + 1) * sizeof(int32_t));
+    if (!t || !bkt) {
+        free(t);
+        free(bkt);
+        return -1;
+    }
+
+    /* Classify suffixes; the terminator is S-type */
+    sais_tset(t, n - 1, 1);
+    sais_tset(t, n - 2, 0);
+    for (int32_t i = n - 3; i >= 0; i--) {
+        int32_t a = sais_chr(s, i), b = sais_chr(s, i + 1);
+        sais_tset(t, i, a < b || (a == b && sais_tget(t, i + 1)));
+    }
+
+    /* Stage 1: sort LMS substrings by induction */
+    sais_buckets(s, bkt, k, 1);
+    for (int32_t i = 0; i < n; i++) sa[i] = -1;
+    for (int32_t i = 1; i < n; i++) {
+        if (sais_is_lms(t, i)) sa[--bkt[sais_chr(s, i)]] = i;
+    }
+    sais_induce_l(s, t, sa, bkt, k);
+    sais_induce_s(s, t, sa, bkt, k);
+
+    /* Compact sorted LMS substrings into the first n1 slots */
+    int32_t n1 = 0;
+    for (int32_t i = 0; i < n; i++) {
+        if (sais_is_lms(t, sa[i])) sa[n1++] = sa[i];
+    }
+
+    /* Name LMS substrings; equal substrings share a name */
+    for (int32_t i = n1; i < n; i++) sa[i] = -1;
+    int32_t name = 0, prev = -1;
+    for (int32_t i = 0; i < n1; i++) {
+        int32_t pos = sa[i];
+        int diff = 0;
+        for (int32_t d = 0; d < n; d++) {
+            if (prev == -1 || sais_chr(s, pos + d) != sais_chr(s, prev + d) ||
+                sais_tget(t, pos + d) != sais_tget(t, prev + d)) {
+                diff = 1;
+                break;
+            }
+            if (d > 0 && (sais_is_lms(t, pos + d) || sais_is_lms(t, prev + d))) break;
+        }
+        if (diff) {
+            name++;
+            prev = pos;
+        }
+        sa[n1 + pos / 2] = name - 1;
+    }
+    for (int32_t i = n - 1, j = n - 1; i >= n1; i--) {
+        if (sa[i] >= 0) sa[j--] = sa[i];
+    }
+
+    /* Stage 2: sort the reduced string, recursing while names repeat */
+    int32_t *s1 = sa + n - n1;
+    int32_t *sa1 = sa;
+    if (name < n1) {
+        SaisText reduced = { NULL, s1, n1 };
+        if (sais_level(&reduced, sa1, name - 1) != 0) {
+            free(t);
+            free(bkt);
+            return -1;
+        }
+    } else {
+        for (int32_t i = 0; i < n1; i++) sa1[s1[i]] = i;
+    }
+
+    /* Stage 3: induce the full order from the sorted LMS suffixes */
+    sais_buckets(s, bkt, k, 1);
+    for (int32_t i = 1, j = 0; i < n; i++) {
+        if (sais_is_lms(t, i)) s1[j++] = i;
+    }
+    for (int32_t i = 0; i < n1; i++) sa1[i] = s1[sa1[i]];
+    for (int32_t i = n1; i < n; i++) sa[i] = -1;
+    for (int32_t i = n1 - 1; i >= 0; i--) {
+        int32_t j = sa[i];
+        sa[i] = -1;
+        sa[--bkt[sais_chr(s, j)]] = j;
+    }
+    sais_induce_l(s, t, sa, bkt, k);
+    sais_induce_s(s, t, sa, bkt, k);
+
+    free(t);
+    free(bkt);
+    return 0;
+}
+
+int kolibri_suffix_array(const uint8_t *text, size_t length, int32_t *sa) {
+    if ((!text && length > 0) || !sa || length > KOLIBRI_BWT_MAX_BLOCK) return -1;
+
+    SaisText s = { text, NULL, (int32_t)length + 1 };
+    return sais_level(&s, sa, 256);
+}
+
+int kolibri_bwt_encode(const uint8_t *input,
+                       size_t length,
+                       uint8_t *output,
+                       uint32_t *primary,
+                       int32_t *workspace) {
+    if (!input || !output || !primary || length == 0 || length > KOLIBRI_BWT_MAX_BLOCK) {
+        return -1;
+    }
+
+    int32_t *sa = workspace;
+    if (!sa) {
+        sa = (int32_t *)malloc((length + 1) * sizeof(int32_t));
+        if (!sa) return -1;
+    }
+    if (kolibri_suffix_array(input, length, sa) != 0) {
+        if (!workspace) free(sa);
+        return -1;
+    }
+
+    /* Row 0 is the empty suffix: its last column is input[length - 1].
+     * The terminator row (suffix 0) is dropped and its index recorded. */
+    size_t out = 0;
+    for (size_t row = 0; row <= length; row++) {
+        int32_t pos = sa[row];
+        if (pos == 0) {
+            *primary = (uint32_t)row;
+        } else {
+            output[out++] = input[pos - 1];
+        }
+    }
+
+    if (!workspace) free(sa);
+    return 0;
+}
+
+int kolibri_bwt_decode(const uint8_t *input,
+                       size_t length,
+                       uint32_t primary,
+                       uint8_t *output,
+                       uint32_t *workspace) {
+    if (!input || !output || length == 0 || length > KOLIBRI_BWT_MAX_BLOCK ||
+        primary == 0 || primary > length) {
+        return -1;
+    }
+
+    uint32_t *lf = workspace;
+    if (!lf) {
+        lf = (uint32_t *)malloc((length + 1) * sizeof(uint32_t));
+        if (!lf) return -1;
+    }
+
+    /* First column starts with the terminator, then bytes in order */
+    uint32_t base[256];
+    size_t counts[256] = {0};
+    for (size_t i = 0; i < length; i++) counts[input[i]]++;
+    uint32_t sum = 1;
+    for (int c = 0; c < 256; c++) {
+        base[c] = sum;
+        sum += (uint32_t)counts[c];
+    }
+
+    /* LF mapping over the full last column (terminator at primary) */
+    for (size_t row = 0, i = 0; row <= length; row++) {
+        if (row == primary) {
+            lf[row] = 0;
+            continue;
+        }
+        lf[row] = base[input[i++]]++;
+    }
+
+    /* Walk backwards from the terminator row */
+    size_t row = 0;
+    for (size_t k = length; k > 0; k--) {
+        size_t idx = row < primary ? row : row - 1;
+        output[k - 1] = input[idx];
+        row = lf[row];
+        if (row == primary && k > 1) {
+            if (!workspace) free(lf);
+            return -1;
+        }
+    }
+
+    if (!workspace) free(lf);
+    return 0;
+}
+
+size_t kolibri_bwt_block_count(size_t length, size_t block_size) {
+    if (block_size == 0) block_size = KOLIBRI_BWT_DEFAULT_BLOCK;
+    return (length + block_size - 1) / block_size;
+}
+
+/* Shared state for block workers */
+typedef struct {
+    const uint8_t *input;
+    uint8_t *output;
+    size_t length;
+    size_t block_size;
+    size_t blocks;
+    uint32_t *primaries;
+    const uint32_t *primaries_in;
+    int decode;
+    atomic_size_t next;
+    atomic_int failed;
+} BwtJob;
+
+static void *bwt_block_worker(void *arg) {
+    BwtJob *job = (BwtJob *)arg;
+
+    /* One workspace per worker, reused across blocks */
+    size_t span = job->block_size < job->length ? job->block_size : job->length;
+    void *workspace = malloc((span + 1) * sizeof(int32_t));
+    if (!workspace) {
+        atomic_store(&job->failed, 1);
+        return NULL;
+    }
+
+    for (;;) {
+        size_t b = atomic_fetch_add(&job->next, 1);
+        if (b >= job->blocks || atomic_load(&job->failed)) break;
+
+        size_t start = b * job->block_size;
+        size_t len = job->length - start < job->block_size ? job->length - start
+                                                            : job->block_size;
+        int rc = job->decode
+            ? kolibri_bwt_decode(job->input + start, len, job->primaries_in[b],
+                                 job->output + start, (uint32_t *)workspace)
+            : kolibri_bwt_encode(job->input + start, len, job->output + start,
+                                 &job->primaries[b], (int32_t *)workspace);
+        if (rc != 0) atomic_store(&job->failed, 1);
+    }
+
+    free(workspace);
+    return NULL;
+}
+
+static int bwt_run_blocks(BwtJob *job, size_t threads) {
+    if (job->block_size == 0) job->block_size = KOLIBRI_BWT_DEFAULT_BLOCK;
+    if (job->block_size > KOLIBRI_BWT_MAX_BLOCK) return -1;
+    job->blocks = kolibri_bwt_block_count(job->length, job->block_size);
+    atomic_init(&job->next, 0);
+    atomic_init(&job->failed, 0);
+
+    if (threads == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = online > 0 ? (size_t)online : 1;
+    }
+    if (threads > job->blocks) threads = job->blocks;
+    if (threads > BWT_MAX_THREADS) threads = BWT_MAX_THREADS;
+
+    /* The caller works as well; extra threads only for extra blocks */
+    pthread_t workers[BWT_MAX_THREADS];
+    size_t started = 0;
+    for (size_t i = 1; i < threads; i++) {
+        if (pthread_create(&workers[started], NULL, bwt_block_worker, job) != 0) break;
+        started++;
+    }
+    bwt_block_worker(job);
+    for (size_t i = 0; i < started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    return atomic_load(&job->failed) ? -1 : 0;
+}
+
+int kolibri_bwt_encode_blocks(const uint8_t *input,
+                              size_t length,
+                              size_t block_size,
+                              size_t threads,
+                              uint8_t *output,
+                              uint32_t *primaries) {
+    if (!input || !output || !primaries) return -1;
+    if (length == 0) return 0;
+
+    BwtJob job;
+    memset(&job, 0, sizeof(job));
+    job.input = input;
+    job.output = output;
+    job.length = length;
+    job.block_size = block_size;
+    job.primaries = primaries;
+    return bwt_run_blocks(&job, threads);
+}
+
+int kolibri_bwt_decode_blocks(const uint8_t *input,
+                              size_t length,
+                              size_t block_size,
+                              size_t threads,
+                              const uint32_t *primaries,
+                              uint8_t *output) {
+    if (!input || !output || !primaries) return -1;
+    if (length == 0) return 0;
+
+    BwtJob job;
+    memset(&job, 0, sizeof(job));
+    job.input = input;
+    job.output = output;
+    job.length = length;
+    job.block_size = block_size;
+    job.primaries_in = primaries;
+    job.decode = 1;
+    return bwt_run_blocks(&job, threads);
+}
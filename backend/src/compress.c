@@ -4,18 +4,25 @@
  */
 
 #include "kolibri/compress.h"
+#include "kolibri/bwt.h"
+#include "kolibri/ppm.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <time.h>
 #include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
 
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
 
 /* Magic number for compressed data format */
 #define KOLIBRI_COMPRESS_MAGIC 0x4B4C4252 /* "KLBR" */
-#define KOLIBRI_COMPRESS_VERSION 40
+#define KOLIBRI_COMPRESS_VERSION 41
+/* Stream container for kolibri_compress_stream */
+#define KOLIBRI_COMPRESS_STREAM_MAGIC 0x534C424B /* "KBLS" */
 
 /* Compression header */
 typedef struct {
@@ -29,10 +36,19 @@ typedef struct {
     uint8_t reserved[12];
 } KolibriCompressHeader;
 
+typedef struct BwtWorker BwtWorker;
+
 struct KolibriCompressor {
     uint32_t methods;
     uint8_t *temp_buffer;
     size_t temp_buffer_size;
+    /* Block codec: block size, worker count and per-worker model state */
+    size_t block_size;
+    size_t threads;
+    BwtWorker *workers;
+    /* PPM method: configuration and lazily created model */
+    KolibriPpmConfig ppm_config;
+    KolibriPpmModel *ppm;
 };
 
 /* Internal helper functions */
@@ -373,6 +389,974 @@ static size_t decompress_mathematical(const uint8_t *input, size_t input_size,
     return input_size;
 }
 
+/*
+ * Block codec (KOLIBRI_COMPRESS_BWT), promoted from tools/kolibri_v40.c:
+ * BWT -> MTF -> eight range-coded substreams with small context models.
+ *
+ * Payload: frames, then a u32 zero. Frame (little-endian):
+ *   u32 raw_len, u32 primary (BWT_FRAME_STORED = raw copy),
+ *   u32 sizes[8] and the substreams, or raw_len stored bytes.
+ * Blocks are independent, so they are coded in parallel and decoded
+ * without reading the rest of the stream.
+ */
+
+#define BWT_STREAMS 8
+#define BWT_FRAME_STORED 0xFFFFFFFFu
+#define BWT_FRAME_HEADER (8 + 4 * BWT_STREAMS)
+#define BWT_MAX_THREADS 64
+
+#define RC_TOP (1u << 24)
+#define RC_BOT (1u << 16)
+
+typedef struct {
+    uint32_t low, range, code;
+    const uint8_t *in_ptr;
+    const uint8_t *in_end;
+    uint8_t *out_ptr;
+    size_t out_size, out_cap;
+    int overflow;
+} RangeCoder;
+
+static void rc_enc_init(RangeCoder *rc, uint8_t *out, size_t cap) {
+    rc->low = 0;
+    rc->range = 0xFFFFFFFF;
+    rc->out_ptr = out;
+    rc->out_size = 0;
+    rc->out_cap = cap;
+    rc->overflow = 0;
+}
+
+static inline void rc_put(RangeCoder *rc, uint8_t byte) {
+    if (rc->out_size < rc->out_cap) {
+        rc->out_ptr[rc->out_size++] = byte;
+    } else {
+        rc->overflow = 1;
+    }
+}
+
+static inline void rc_enc_norm(RangeCoder *rc) {
+    while ((rc->low ^ (rc->low + rc->range)) < RC_TOP ||
+           (rc->range < RC_BOT && ((rc->range = (uint32_t)(-(int32_t)rc->low) & (RC_BOT - 1)), 1))) {
+        rc_put(rc, (uint8_t)(rc->low >> 24));
+        rc->low <<= 8;
+        rc->range <<= 8;
+    }
+}
+
+static void rc_enc_flush(RangeCoder *rc) {
+    for (int i = 0; i < 4; i++) {
+        rc_put(rc, (uint8_t)(rc->low >> 24));
+        rc->low <<= 8;
+    }
+}
+
+/* Reads past the end yield zeros; corrupt input is caught by the checksum */
+static inline uint8_t rc_next(RangeCoder *rc) {
+    return rc->in_ptr < rc->in_end ? *rc->in_ptr++ : 0;
+}
+
+static void rc_dec_init(RangeCoder *rc, const uint8_t *in, size_t size) {
+    rc->low = 0;
+    rc->range = 0xFFFFFFFF;
+    rc->code = 0;
+    rc->in_ptr = in;
+    rc->in_end = in + size;
+    for (int i = 0; i < 4; i++) rc->code = (rc->code << 8) | rc_next(rc);
+}
+
+static inline void rc_dec_norm(RangeCoder *rc) {
+    while ((rc->low ^ (rc->low + rc->range)) < RC_TOP ||
+           (rc->range < RC_BOT && ((rc->range = (uint32_t)(-(int32_t)rc->low) & (RC_BOT - 1)), 1))) {
+        rc->code = (rc->code << 8) | rc_next(rc);
+        rc->low <<= 8;
+        rc->range <<= 8;
+    }
+}
+
+/* Adaptive 12-bit binary probabilities; ctx_mask selects the table size */
+static inline void rc_enc_bit(RangeCoder *rc, uint16_t *prob, int bit) {
+    uint32_t bound = (rc->range >> 12) * *prob;
+    if (bit) {
+        rc->range = bound;
+        *prob += (uint16_t)((4096 - *prob) >> 5);
+    } else {
+        rc->low += bound;
+        rc->range -= bound;
+        *prob -= *prob >> 5;
+    }
+    rc_enc_norm(rc);
+}
+
+static inline int rc_dec_bit(RangeCoder *rc, uint16_t *prob) {
+    uint32_t bound = (rc->range >> 12) * *prob;
+    int bit = rc->code < rc->low + bound;
+    if (bit) {
+        rc->range = bound;
+        *prob += (uint16_t)((4096 - *prob) >> 5);
+    } else {
+        rc->low += bound;
+        rc->range -= bound;
+        *prob -= *prob >> 5;
+    }
+    rc_dec_norm(rc);
+    return bit;
+}
+
+/* Binary model with run-length context (64) and order-4 bit models (16) */
+typedef struct { uint16_t prob[64]; } BinModelRL;
+typedef struct { uint16_t prob[16]; } BinModel4;
+
+/* N-symbol order-2 model, up to 32 symbols; [32] holds the total */
+typedef struct {
+    uint16_t freq[64][33];
+    int nsym;
+} ModelN2;
+
+/* Order-1 model over 256 symbols; [256] holds the total */
+typedef struct { uint16_t freq[256][257]; } Model256;
+
+static void bin_models_init(uint16_t *prob, size_t count) {
+    for (size_t i = 0; i < count; i++) prob[i] = 2048;
+}
+
+static void mn2_init(ModelN2 *m, int nsym) {
+    m->nsym = nsym;
+    for (int c = 0; c < 64; c++) {
+        for (int s = 0; s < nsym; s++) m->freq[c][s] = 1;
+        m->freq[c][32] = (uint16_t)nsym;
+    }
+}
+
+static void mn2_update(ModelN2 *m, int ctx, int sym) {
+    m->freq[ctx][sym] += 16;
+    m->freq[ctx][32] += 16;
+    if (m->freq[ctx][32] > 0x3FFF) {
+        m->freq[ctx][32] = 0;
+        for (int i = 0; i < m->nsym; i++) {
+            m->freq[ctx][i] = (uint16_t)((m->freq[ctx][i] >> 1) | 1);
+            m->freq[ctx][32] += m->freq[ctx][i];
+        }
+    }
+}
+
+static void rc_enc_symN2(RangeCoder *rc, ModelN2 *m, int ctx, int sym) {
+    if (ctx >= 64) ctx = 63;
+    uint32_t cum = 0;
+    for (int i = 0; i < sym; i++) cum += m->freq[ctx][i];
+    rc->range /= m->freq[ctx][32];
+    rc->low += cum * rc->range;
+    rc->range *= m->freq[ctx][sym];
+    rc_enc_norm(rc);
+    mn2_update(m, ctx, sym);
+}
+
+static int rc_dec_symN2(RangeCoder *rc, ModelN2 *m, int ctx) {
+    if (ctx >= 64) ctx = 63;
+    rc->range /= m->freq[ctx][32];
+    uint32_t target = (rc->code - rc->low) / rc->range;
+    uint32_t cum = 0;
+    int sym = 0;
+    while (sym < m->nsym - 1 && cum + m->freq[ctx][sym] <= target) {
+        cum += m->freq[ctx][sym];
+        sym++;
+    }
+    rc->low += cum * rc->range;
+    rc->range *= m->freq[ctx][sym];
+    rc_dec_norm(rc);
+    mn2_update(m, ctx, sym);
+    return sym;
+}
+
+static void m256_init(Model256 *m) {
+    for (int c = 0; c < 256; c++) {
+        for (int s = 0; s < 256; s++) m->freq[c][s] = 1;
+        m->freq[c][256] = 256;
+    }
+}
+
+static void m256_update(Model256 *m, uint8_t c, uint8_t s) {
+    m->freq[c][s] += 8;
+    m->freq[c][256] += 8;
+    if (m->freq[c][256] > 0x3FFF) {
+        uint16_t t = 0;
+        for (int i = 0; i < 256; i++) {
+            m->freq[c][i] = (uint16_t)((m->freq[c][i] >> 1) | 1);
+            t += m->freq[c][i];
+        }
+        m->freq[c][256] = t;
+    }
+}
+
+static void rc_enc_sym256(RangeCoder *rc, Model256 *m, uint8_t ctx, uint8_t sym) {
+    uint32_t cum = 0;
+    for (int i = 0; i < sym; i++) cum += m->freq[ctx][i];
+    rc->range /= m->freq[ctx][256];
+    rc->low += cum * rc->range;
+    rc->range *= m->freq[ctx][sym];
+    rc_enc_norm(rc);
+    m256_update(m, ctx, sym);
+}
+
+static uint8_t rc_dec_sym256(RangeCoder *rc, Model256 *m, uint8_t ctx) {
+    rc->range /= m->freq[ctx][256];
+    uint32_t target = (rc->code - rc->low) / rc->range;
+    uint32_t cum = 0;
+    int sym = 0;
+    while (sym < 255 && cum + m->freq[ctx][sym] <= target) {
+        cum += m->freq[ctx][sym];
+        sym++;
+    }
+    rc->low += cum * rc->range;
+    rc->range *= m->freq[ctx][sym];
+    rc_dec_norm(rc);
+    m256_update(m, ctx, (uint8_t)sym);
+    return (uint8_t)sym;
+}
+
+static void mtf_encode(const uint8_t *in, size_t len, uint8_t *out) {
+    uint8_t tbl[256];
+    for (int i = 0; i < 256; i++) tbl[i] = (uint8_t)i;
+    for (size_t i = 0; i < len; i++) {
+        uint8_t c = in[i], r = 0;
+        while (tbl[r] != c) r++;
+        out[i] = r;
+        memmove(&tbl[1], &tbl[0], r);
+        tbl[0] = c;
+    }
+}
+
+static void mtf_decode(const uint8_t *in, size_t len, uint8_t *out) {
+    uint8_t tbl[256];
+    for (int i = 0; i < 256; i++) tbl[i] = (uint8_t)i;
+    for (size_t i = 0; i < len; i++) {
+        uint8_t r = in[i], c = tbl[r];
+        out[i] = c;
+        memmove(&tbl[1], &tbl[0], r);
+        tbl[0] = c;
+    }
+}
+
+static void put_u32le(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t get_u32le(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* Per-worker state, allocated once and reused across blocks and calls */
+struct BwtWorker {
+    int32_t *sa;            /* SA when encoding, LF table when decoding */
+    uint8_t *bwt;
+    uint8_t *mtf;
+    size_t capacity;        /* Block size the buffers fit */
+    BinModelRL rl;
+    BinModel4 bits[3];
+    ModelN2 n3, n6, n22;
+    Model256 m256;
+};
+
+static void bwt_worker_free(BwtWorker *w) {
+    if (!w) return;
+    free(w->sa);
+    free(w->bwt);
+    free(w->mtf);
+    w->sa = NULL;
+    w->bwt = NULL;
+    w->mtf = NULL;
+    w->capacity = 0;
+}
+
+static int bwt_worker_reserve(BwtWorker *w, size_t block_size) {
+    if (w->capacity >= block_size) return 0;
+    bwt_worker_free(w);
+    w->sa = (int32_t *)malloc((block_size + 1) * sizeof(int32_t));
+    w->bwt = (uint8_t *)malloc(block_size);
+    w->mtf = (uint8_t *)malloc(block_size);
+    if (!w->sa || !w->bwt || !w->mtf) {
+        bwt_worker_free(w);
+        return -1;
+    }
+    w->capacity = block_size;
+    return 0;
+}
+
+static void bwt_models_reset(BwtWorker *w) {
+    bin_models_init(w->rl.prob, 64);
+    for (int i = 0; i < 3; i++) bin_models_init(w->bits[i].prob, 16);
+    mn2_init(&w->n3, 3);
+    mn2_init(&w->n6, 6);
+    mn2_init(&w->n22, 22);
+    m256_init(&w->m256);
+}
+
+static inline int bwt_rl_context(int lastb, int run) {
+    int rl_class = (run == 0) ? 0 : (run < 4) ? 1 : (run < 16) ? 2 : 3;
+    return ((lastb & 15) << 2) | rl_class;
+}
+
+/* One substream of the MTF output; the same split as the v40 tool */
+static void bwt_encode_substream(BwtWorker *w, RangeCoder *rc, int stream,
+                                 const uint8_t *mtf, size_t len) {
+    int ctx = 0, run = 0, p1 = 0, p2 = 0;
+    uint8_t ctx32 = 0;
+    for (size_t i = 0; i < len; i++) {
+        uint8_t v = mtf[i];
+        switch (stream) {
+        case 0: { /* zero / non-zero, run-length context */
+            int b = v != 0;
+            rc_enc_bit(rc, &w->rl.prob[bwt_rl_context(ctx, run)], b);
+            ctx = (ctx << 1 | b) & 15;
+            run = b ? 0 : run + 1;
+            break;
+        }
+        case 1: case 2: case 3: { /* > 3, > 9, > 31 among the larger ranks */
+            static const uint8_t lower[3] = {0, 3, 9};
+            static const uint8_t upper[3] = {3, 9, 31};
+            if (v > lower[stream - 1]) {
+                int b = v > upper[stream - 1];
+                rc_enc_bit(rc, &w->bits[stream - 1].prob[ctx], b);
+                ctx = (ctx << 1 | b) & 15;
+            }
+            break;
+        }
+        case 4: /* 1..3, order-2 */
+            if (v >= 1 && v <= 3) {
+                rc_enc_symN2(rc, &w->n3, p2 * 3 + p1, v - 1);
+                p2 = p1;
+                p1 = v - 1;
+            }
+            break;
+        case 5: /* 4..9, order-2 */
+            if (v >= 4 && v <= 9) {
+                int c = p2 * 6 + p1;
+                rc_enc_symN2(rc, &w->n6, c >= 36 ? 35 : c, v - 4);
+                p2 = p1;
+                p1 = v - 4;
+            }
+            break;
+        case 6: /* 10..31, order-2 on folded history */
+            if (v >= 10 && v <= 31) {
+                rc_enc_symN2(rc, &w->n22, (p2 % 6) * 6 + (p1 % 6), v - 10);
+                p2 = p1;
+                p1 = v - 10;
+            }
+            break;
+        default: /* 32+, order-1 */
+            if (v >= 32) {
+                rc_enc_sym256(rc, &w->m256, ctx32, (uint8_t)(v - 32));
+                ctx32 = (uint8_t)(v - 32);
+            }
+            break;
+        }
+    }
+    rc_enc_flush(rc);
+}
+
+/* Encode one block into frame (capacity BWT_FRAME_HEADER + len); returns frame size */
+static size_t bwt_encode_block(BwtWorker *w, const uint8_t *in, size_t len, uint8_t *frame) {
+    uint32_t primary = 0;
+    put_u32le(frame, (uint32_t)len);
+
+    if (kolibri_bwt_encode(in, len, w->bwt, &primary, w->sa) == 0) {
+        mtf_encode(w->bwt, len, w->mtf);
+        bwt_models_reset(w);
+
+        /* Substreams one after another; anything not smaller than a
+         * stored block falls back to storing */
+        size_t pos = BWT_FRAME_HEADER;
+        size_t limit = 8 + len;
+        int ok = 1;
+        for (int s = 0; s < BWT_STREAMS && ok; s++) {
+            RangeCoder rc;
+            rc_enc_init(&rc, frame + pos, limit > pos ? limit - pos : 0);
+            bwt_encode_substream(w, &rc, s, w->mtf, len);
+            ok = !rc.overflow;
+            put_u32le(frame + 8 + 4 * s, (uint32_t)rc.out_size);
+            pos += rc.out_size;
+        }
+        if (ok && pos < limit) {
+            put_u32le(frame + 4, primary);
+            return pos;
+        }
+    }
+
+    put_u32le(frame + 4, BWT_FRAME_STORED);
+    memcpy(frame + 8, in, len);
+    return 8 + len;
+}
+
+/* Size of the frame at data, or 0 if it is truncated or malformed */
+static size_t bwt_frame_size(const uint8_t *data, size_t avail, size_t *raw_len) {
+    if (avail < 8) return 0;
+    *raw_len = get_u32le(data);
+    if (get_u32le(data + 4) == BWT_FRAME_STORED) {
+        return avail - 8 >= *raw_len ? 8 + *raw_len : 0;
+    }
+    if (avail < BWT_FRAME_HEADER) return 0;
+    size_t total = BWT_FRAME_HEADER;
+    for (int s = 0; s < BWT_STREAMS; s++) {
+        total += get_u32le(data + 8 + 4 * s);
+        if (total > avail) return 0;
+    }
+    return total;
+}
+
+/* Decode one frame of known size into out (raw_len bytes) */
+static int bwt_decode_block(BwtWorker *w, const uint8_t *frame, size_t raw_len, uint8_t *out) {
+    uint32_t primary = get_u32le(frame + 4);
+    if (primary == BWT_FRAME_STORED) {
+        memcpy(out, frame + 8, raw_len);
+        return 0;
+    }
+
+    RangeCoder rc[BWT_STREAMS];
+    size_t pos = BWT_FRAME_HEADER;
+    for (int s = 0; s < BWT_STREAMS; s++) {
+        size_t size = get_u32le(frame + 8 + 4 * s);
+        rc_dec_init(&rc[s], frame + pos, size);
+        pos += size;
+    }
+    bwt_models_reset(w);
+
+    /* All substreams in one interleaved pass, straight into MTF ranks */
+    int lastb = 0, run = 0, c1 = 0, c2 = 0, c3 = 0;
+    int a1 = 0, a2 = 0, b1 = 0, b2 = 0, d1 = 0, d2 = 0;
+    uint8_t ctx32 = 0;
+    for (size_t i = 0; i < raw_len; i++) {
+        int b = rc_dec_bit(&rc[0], &w->rl.prob[bwt_rl_context(lastb, run)]);
+        lastb = (lastb << 1 | b) & 15;
+        run = b ? 0 : run + 1;
+        if (!b) {
+            w->mtf[i] = 0;
+            continue;
+        }
+
+        b = rc_dec_bit(&rc[1], &w->bits[0].prob[c1]);
+        c1 = (c1 << 1 | b) & 15;
+        if (!b) {
+            int sym = rc_dec_symN2(&rc[4], &w->n3, a2 * 3 + a1);
+            a2 = a1;
+            a1 = sym;
+            w->mtf[i] = (uint8_t)(sym + 1);
+            continue;
+        }
+
+        b = rc_dec_bit(&rc[2], &w->bits[1].prob[c2]);
+        c2 = (c2 << 1 | b) & 15;
+        if (!b) {
+            int c = b2 * 6 + b1;
+            int sym = rc_dec_symN2(&rc[5], &w->n6, c >= 36 ? 35 : c);
+            b2 = b1;
+            b1 = sym;
+            w->mtf[i] = (uint8_t)(sym + 4);
+            continue;
+        }
+
+        b = rc_dec_bit(&rc[3], &w->bits[2].prob[c3]);
+        c3 = (c3 << 1 | b) & 15;
+        if (!b) {
+            int sym = rc_dec_symN2(&rc[6], &w->n22, (d2 % 6) * 6 + (d1 % 6));
+            d2 = d1;
+            d1 = sym;
+            w->mtf[i] = (uint8_t)(sym + 10);
+            continue;
+        }
+
+        uint8_t sym = rc_dec_sym256(&rc[7], &w->m256, ctx32);
+        ctx32 = sym;
+        w->mtf[i] = (uint8_t)(sym + 32 > 255 ? 255 : sym + 32);
+    }
+
+    mtf_decode(w->mtf, raw_len, w->bwt);
+    return kolibri_bwt_decode(w->bwt, raw_len, primary, out, (uint32_t *)w->sa);
+}
+
+/* A batch of blocks coded by a worker group */
+typedef struct {
+    BwtWorker *workers;
+    size_t block_size;
+    size_t count;
+    const uint8_t *const *in;   /* Block inputs (raw or frames) */
+    const size_t *in_len;       /* Raw block lengths */
+    uint8_t *const *out;        /* Frame slots or raw outputs */
+    size_t *out_len;            /* Encoded frame sizes */
+    int decode;
+    atomic_size_t next;
+    atomic_int failed;
+} BwtBatch;
+
+typedef struct {
+    BwtBatch *batch;
+    BwtWorker *worker;
+} BwtThreadArg;
+
+static void *bwt_batch_worker(void *arg) {
+    BwtThreadArg *t = (BwtThreadArg *)arg;
+    BwtBatch *batch = t->batch;
+    if (bwt_worker_reserve(t->worker, batch->block_size) != 0) {
+        atomic_store(&batch->failed, 1);
+        return NULL;
+    }
+    for (;;) {
+        size_t i = atomic_fetch_add(&batch->next, 1);
+        if (i >= batch->count || atomic_load(&batch->failed)) break;
+        if (batch->decode) {
+            if (bwt_decode_block(t->worker, batch->in[i], batch->in_len[i], batch->out[i]) != 0) {
+                atomic_store(&batch->failed, 1);
+            }
+        } else {
+            batch->out_len[i] = bwt_encode_block(t->worker, batch->in[i], batch->in_len[i],
+                                                 batch->out[i]);
+        }
+    }
+    return NULL;
+}
+
+static int bwt_batch_run(BwtBatch *batch, size_t threads) {
+    atomic_init(&batch->next, 0);
+    atomic_init(&batch->failed, 0);
+    if (threads > batch->count) threads = batch->count;
+    if (threads == 0) threads = 1;
+
+    pthread_t ids[BWT_MAX_THREADS];
+    BwtThreadArg args[BWT_MAX_THREADS];
+    size_t started = 0;
+    for (size_t i = 0; i < threads; i++) {
+        args[i].batch = batch;
+        args[i].worker = &batch->workers[i];
+    }
+    for (size_t i = 1; i < threads; i++) {
+        if (pthread_create(&ids[started], NULL, bwt_batch_worker, &args[i]) != 0) break;
+        started++;
+    }
+    bwt_batch_worker(&args[0]);
+    for (size_t i = 0; i < started; i++) {
+        pthread_join(ids[i], NULL);
+    }
+    return atomic_load(&batch->failed) ? -1 : 0;
+}
+
+static size_t bwt_resolve_threads(size_t threads) {
+    if (threads == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = online > 0 ? (size_t)online : 1;
+    }
+    return threads > BWT_MAX_THREADS ? BWT_MAX_THREADS : threads;
+}
+
+/* Worker states: the compressor keeps its own, decoding allocates per call */
+static BwtWorker *bwt_workers_alloc(size_t count) {
+    return (BwtWorker *)calloc(count, sizeof(BwtWorker));
+}
+
+static void bwt_workers_free(BwtWorker *workers, size_t count) {
+    if (!workers) return;
+    for (size_t i = 0; i < count; i++) bwt_worker_free(&workers[i]);
+    free(workers);
+}
+
+static size_t bwt_max_payload(size_t input_size, size_t block_size) {
+    size_t blocks = kolibri_bwt_block_count(input_size, block_size);
+    return input_size + blocks * BWT_FRAME_HEADER + 4;
+}
+
+/* Encode input as frames; out must hold bwt_max_payload bytes */
+static int bwt_encode_payload(KolibriCompressor *comp, const uint8_t *input, size_t input_size,
+                              uint8_t *out, size_t *out_size) {
+    size_t block = comp->block_size;
+    size_t blocks = kolibri_bwt_block_count(input_size, block);
+    const uint8_t **in = (const uint8_t **)malloc((blocks + 1) * sizeof(*in));
+    uint8_t **slots = (uint8_t **)malloc((blocks + 1) * sizeof(*slots));
+    size_t *in_len = (size_t *)malloc((blocks + 1) * sizeof(size_t));
+    size_t *out_len = (size_t *)malloc((blocks + 1) * sizeof(size_t));
+    int rc = -1;
+    if (!in || !slots || !in_len || !out_len) goto done;
+
+    /* Each frame is written at its worst-case offset, then compacted */
+    for (size_t b = 0; b < blocks; b++) {
+        in[b] = input + b * block;
+        in_len[b] = MIN(block, input_size - b * block);
+        slots[b] = out + b * (block + BWT_FRAME_HEADER);
+    }
+
+    BwtBatch batch;
+    memset(&batch, 0, sizeof(batch));
+    batch.workers = comp->workers;
+    batch.block_size = block;
+    batch.count = blocks;
+    batch.in = in;
+    batch.in_len = in_len;
+    batch.out = slots;
+    batch.out_len = out_len;
+    if (blocks > 0 && bwt_batch_run(&batch, comp->threads) != 0) goto done;
+
+    size_t pos = 0;
+    for (size_t b = 0; b < blocks; b++) {
+        memmove(out + pos, slots[b], out_len[b]);
+        pos += out_len[b];
+    }
+    put_u32le(out + pos, 0);
+    *out_size = pos + 4;
+    rc = 0;
+
+done:
+    free(in);
+    free(slots);
+    free(in_len);
+    free(out_len);
+    return rc;
+}
+
+static int bwt_decode_payload(const uint8_t *data, size_t size, uint8_t *output, size_t output_size) {
+    /* Locate frames sequentially, then decode them in parallel */
+    size_t capacity = 16, blocks = 0, pos = 0, produced = 0, max_block = 0;
+    const uint8_t **in = (const uint8_t **)malloc(capacity * sizeof(*in));
+    uint8_t **out = (uint8_t **)malloc(capacity * sizeof(*out));
+    size_t *in_len = (size_t *)malloc(capacity * sizeof(size_t));
+    int rc = -1;
+    BwtWorker *workers = NULL;
+    size_t threads = 0;
+    if (!in || !out || !in_len) goto done;
+
+    for (;;) {
+        if (size - pos < 4) goto done;
+        if (get_u32le(data + pos) == 0) break;
+        size_t raw_len = 0;
+        size_t frame = bwt_frame_size(data + pos, size - pos, &raw_len);
+        if (frame == 0 || raw_len > output_size - produced) goto done;
+
+        if (blocks == capacity) {
+            capacity *= 2;
+            const uint8_t **gi = (const uint8_t **)realloc(in, capacity * sizeof(*in));
+            if (gi) in = gi;
+            uint8_t **go = (uint8_t **)realloc(out, capacity * sizeof(*out));
+            if (go) out = go;
+            size_t *gl = (size_t *)realloc(in_len, capacity * sizeof(size_t));
+            if (gl) in_len = gl;
+            if (!gi || !go || !gl) goto done;
+        }
+        in[blocks] = data + pos;
+        in_len[blocks] = raw_len;
+        out[blocks] = output + produced;
+        blocks++;
+        produced += raw_len;
+        max_block = MAX(max_block, raw_len);
+        pos += frame;
+    }
+    if (produced != output_size) goto done;
+
+    threads = MIN(bwt_resolve_threads(0), MAX(blocks, 1));
+    workers = bwt_workers_alloc(threads);
+    if (!workers) goto done;
+
+    BwtBatch batch;
+    memset(&batch, 0, sizeof(batch));
+    batch.workers = workers;
+    batch.block_size = max_block;
+    batch.count = blocks;
+    batch.in = in;
+    batch.in_len = in_len;
+    batch.out = out;
+    batch.decode = 1;
+    rc = blocks > 0 ? bwt_batch_run(&batch, threads) : 0;
+
+done:
+    bwt_workers_free(workers, threads);
+    free(in);
+    free(out);
+    free(in_len);
+    return rc;
+}
+
+int kolibri_compressor_set_blocks(KolibriCompressor *comp, size_t block_size, size_t threads) {
+    if (!comp || block_size > KOLIBRI_BWT_MAX_BLOCK) return -1;
+
+    size_t resolved = bwt_resolve_threads(threads);
+    BwtWorker *workers = bwt_workers_alloc(resolved);
+    if (!workers) return -1;
+
+    bwt_workers_free(comp->workers, comp->threads);
+    comp->workers = workers;
+    comp->threads = resolved;
+    comp->block_size = block_size ? block_size : KOLIBRI_COMPRESS_BWT_BLOCK;
+    return 0;
+}
+
+/* ============================================================
+ * PPM method: u8 order, u8 stored flag, u16 zero, u32 memory limit,
+ * then the range-coded stream (or the raw bytes when stored)
+ * ============================================================ */
+
+#define PPM_PAYLOAD_HEADER 8
+
+int kolibri_compressor_set_ppm(KolibriCompressor *comp, unsigned order, size_t memory_limit) {
+    if (!comp || order > KOLIBRI_PPM_MAX_ORDER || memory_limit > KOLIBRI_PPM_MAX_MEMORY) return -1;
+
+    kolibri_ppm_destroy(comp->ppm);
+    comp->ppm = NULL;
+    comp->ppm_config.order = order;
+    comp->ppm_config.memory_limit = memory_limit;
+    return 0;
+}
+
+static int ppm_encode_payload(KolibriCompressor *comp, const uint8_t *input, size_t input_size,
+                              uint8_t *output, size_t *output_size) {
+    if (!comp->ppm) {
+        comp->ppm = kolibri_ppm_create(&comp->ppm_config);
+        if (!comp->ppm) return -1;
+    }
+    KolibriPpmConfig config;
+    kolibri_ppm_get_config(comp->ppm, &config);
+
+    output[0] = (uint8_t)config.order;
+    output[1] = 0;
+    output[2] = 0;
+    output[3] = 0;
+    put_u32le(output + 4, (uint32_t)config.memory_limit);
+
+    /* Output that would not beat the raw bytes is stored instead */
+    size_t coded = 0;
+    if (kolibri_ppm_encode(comp->ppm, input, input_size, output + PPM_PAYLOAD_HEADER,
+                           input_size, &coded) != 0) {
+        output[1] = 1;
+        memcpy(output + PPM_PAYLOAD_HEADER, input, input_size);
+        coded = input_size;
+    }
+    *output_size = PPM_PAYLOAD_HEADER + coded;
+    return 0;
+}
+
+static int ppm_decode_payload(const uint8_t *data, size_t size, uint8_t *output, size_t output_size) {
+    if (size < PPM_PAYLOAD_HEADER) return -1;
+    if (data[1]) {
+        if (size - PPM_PAYLOAD_HEADER != output_size) return -1;
+        memcpy(output, data + PPM_PAYLOAD_HEADER, output_size);
+        return 0;
+    }
+
+    KolibriPpmConfig config;
+    config.order = data[0];
+    config.memory_limit = get_u32le(data + 4);
+    if (config.order < 1 || config.order > KOLIBRI_PPM_MAX_ORDER ||
+        config.memory_limit < KOLIBRI_PPM_MIN_MEMORY || config.memory_limit > KOLIBRI_PPM_MAX_MEMORY) {
+        return -1;
+    }
+    KolibriPpmModel *model = kolibri_ppm_create(&config);
+    if (!model) return -1;
+    int rc = kolibri_ppm_decode(model, data + PPM_PAYLOAD_HEADER, size - PPM_PAYLOAD_HEADER,
+                                output, output_size);
+    kolibri_ppm_destroy(model);
+    return rc;
+}
+
+/* Read up to size bytes, retrying short reads; returns bytes read */
+static size_t stream_read(FILE *in, uint8_t *buffer, size_t size) {
+    size_t total = 0;
+    while (total < size) {
+        size_t got = fread(buffer + total, 1, size - total, in);
+        if (got == 0) break;
+        total += got;
+    }
+    return total;
+}
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        crc = (crc >> 8) ^ crc32_table[(crc ^ data[i]) & 0xFF];
+    }
+    return crc;
+}
+
+int kolibri_compress_stream(KolibriCompressor *comp, FILE *in, FILE *out,
+                            KolibriCompressStats *stats) {
+    if (!comp || !in || !out) return -1;
+
+    double start_time = get_time_ms();
+    size_t block = comp->block_size;
+    size_t round = block * comp->threads;
+    uint8_t *input = (uint8_t *)malloc(round);
+    uint8_t *frames = (uint8_t *)malloc(bwt_max_payload(round, block));
+    if (!input || !frames) {
+        free(input);
+        free(frames);
+        return -1;
+    }
+
+    uint8_t header[8];
+    put_u32le(header, KOLIBRI_COMPRESS_STREAM_MAGIC);
+    put_u32le(header + 4, KOLIBRI_COMPRESS_VERSION);
+    int rc = fwrite(header, 1, sizeof(header), out) == sizeof(header) ? 0 : -1;
+
+    /* One round = one block per worker, so memory stays bounded */
+    uint32_t crc = 0xFFFFFFFF;
+    size_t total_in = 0, total_out = sizeof(header);
+    while (rc == 0) {
+        size_t got = stream_read(in, input, round);
+        if (got == 0) break;
+        crc = crc32_update(crc, input, got);
+
+        size_t payload = 0;
+        rc = bwt_encode_payload(comp, input, got, frames, &payload);
+        if (rc != 0) break;
+        payload -= 4; /* The terminator is written once, at the end */
+        if (fwrite(frames, 1, payload, out) != payload) rc = -1;
+        total_in += got;
+        total_out += payload;
+        if (got < round) break;
+    }
+    if (rc == 0 && ferror(in)) rc = -1;
+
+    if (rc == 0) {
+        uint8_t trailer[8];
+        put_u32le(trailer, 0);
+        put_u32le(trailer + 4, crc ^ 0xFFFFFFFF);
+        if (fwrite(trailer, 1, sizeof(trailer), out) != sizeof(trailer)) rc = -1;
+        total_out += sizeof(trailer);
+    }
+
+    if (rc == 0 && stats) {
+        stats->original_size = total_in;
+        stats->compressed_size = total_out;
+        stats->compression_ratio = total_out ? (double)total_in / (double)total_out : 0.0;
+        stats->checksum = crc ^ 0xFFFFFFFF;
+        stats->file_type = KOLIBRI_FILE_UNKNOWN;
+        stats->methods_used = KOLIBRI_COMPRESS_BWT;
+        stats->compression_time_ms = get_time_ms() - start_time;
+        stats->decompression_time_ms = 0;
+    }
+
+    free(input);
+    free(frames);
+    return rc;
+}
+
+int kolibri_decompress_stream(FILE *in, FILE *out, size_t threads,
+                              KolibriCompressStats *stats) {
+    if (!in || !out) return -1;
+
+    double start_time = get_time_ms();
+    uint8_t header[8];
+    if (stream_read(in, header, sizeof(header)) != sizeof(header) ||
+        get_u32le(header) != KOLIBRI_COMPRESS_STREAM_MAGIC ||
+        get_u32le(header + 4) > KOLIBRI_COMPRESS_VERSION) {
+        return -1;
+    }
+
+    threads = bwt_resolve_threads(threads);
+    BwtWorker *workers = bwt_workers_alloc(threads);
+    const uint8_t **frame_ptr = (const uint8_t **)malloc(threads * sizeof(*frame_ptr));
+    uint8_t **out_ptr = (uint8_t **)malloc(threads * sizeof(*out_ptr));
+    size_t *raw_len = (size_t *)malloc(threads * sizeof(size_t));
+    uint8_t *frames = NULL, *output = NULL;
+    size_t frames_cap = 0, output_cap = 0;
+    uint32_t crc = 0xFFFFFFFF;
+    size_t total_in = sizeof(header), total_out = 0;
+    int rc = (workers && frame_ptr && out_ptr && raw_len) ? 0 : -1;
+    int done = 0;
+
+    while (rc == 0 && !done) {
+        /* Gather up to one frame per worker */
+        size_t count = 0, frames_len = 0, output_len = 0, max_block = 0;
+        size_t offsets[BWT_MAX_THREADS];
+        while (count < threads) {
+            uint8_t head[BWT_FRAME_HEADER];
+            if (stream_read(in, head, 4) != 4) { rc = -1; break; }
+            size_t len = get_u32le(head);
+            if (len == 0) { done = 1; break; }
+            if (stream_read(in, head + 4, 4) != 4) { rc = -1; break; }
+            size_t head_len = 8, body = len;
+            if (get_u32le(head + 4) != BWT_FRAME_STORED) {
+                if (stream_read(in, head + 8, BWT_FRAME_HEADER - 8) != BWT_FRAME_HEADER - 8) {
+                    rc = -1;
+                    break;
+                }
+                head_len = BWT_FRAME_HEADER;
+                body = 0;
+                for (int s = 0; s < BWT_STREAMS; s++) body += get_u32le(head + 8 + 4 * s);
+                if (body > len + BWT_FRAME_HEADER) { rc = -1; break; }
+            }
+            if (len > KOLIBRI_BWT_MAX_BLOCK) { rc = -1; break; }
+
+            size_t need = frames_len + head_len + body;
+            if (need > frames_cap) {
+                size_t cap = MAX(need, frames_cap * 2);
+                uint8_t *grown = (uint8_t *)realloc(frames, cap);
+                if (!grown) { rc = -1; break; }
+                frames = grown;
+                frames_cap = cap;
+            }
+            memcpy(frames + frames_len, head, head_len);
+            if (stream_read(in, frames + frames_len + head_len, body) != body) { rc = -1; break; }
+            offsets[count] = frames_len;
+            raw_len[count] = len;
+            frames_len = need;
+            output_len += len;
+            max_block = MAX(max_block, len);
+            total_in += head_len + body;
+            count++;
+        }
+        if (rc != 0 || count == 0) break;
+
+        if (output_len > output_cap) {
+            uint8_t *grown = (uint8_t *)realloc(output, output_len);
+            if (!grown) { rc = -1; break; }
+            output = grown;
+            output_cap = output_len;
+        }
+        for (size_t i = 0, pos = 0; i < count; i++) {
+            frame_ptr[i] = frames + offsets[i];
+            out_ptr[i] = output + pos;
+            pos += raw_len[i];
+        }
+
+        BwtBatch batch;
+        memset(&batch, 0, sizeof(batch));
+        batch.workers = workers;
+        batch.block_size = max_block;
+        batch.count = count;
+        batch.in = frame_ptr;
+        batch.in_len = raw_len;
+        batch.out = out_ptr;
+        batch.decode = 1;
+        rc = bwt_batch_run(&batch, threads);
+        if (rc == 0 && fwrite(output, 1, output_len, out) != output_len) rc = -1;
+        crc = crc32_update(crc, output, output_len);
+        total_out += output_len;
+    }
+
+    /* Trailer: checksum of everything written */
+    if (rc == 0) {
+        uint8_t trailer[4];
+        if (stream_read(in, trailer, 4) != 4 || get_u32le(trailer) != (crc ^ 0xFFFFFFFF)) {
+            rc = -1;
+        }
+        total_in += 8;
+    }
+
+    if (rc == 0 && stats) {
+        stats->original_size = total_out;
+        stats->compressed_size = total_in;
+        stats->compression_ratio = total_in ? (double)total_out / (double)total_in : 0.0;
+        stats->checksum = crc ^ 0xFFFFFFFF;
+        stats->file_type = KOLIBRI_FILE_UNKNOWN;
+        stats->methods_used = KOLIBRI_COMPRESS_BWT;
+        stats->compression_time_ms = 0;
+        stats->decompression_time_ms = get_time_ms() - start_time;
+    }
+
+    bwt_workers_free(workers, threads);
+    free(frame_ptr);
+    free(out_ptr);
+    free(raw_len);
+    free(frames);
+    free(output);
+    return rc;
+}
+
 /* Public API implementation */
 KolibriCompressor *kolibri_compressor_create(uint32_t methods) {
     KolibriCompressor *comp = (KolibriCompressor *)calloc(1, sizeof(KolibriCompressor));
@@ -382,15 +1366,56 @@ KolibriCompressor *kolibri_compressor_create(uint32_t methods) {
     comp->temp_buffer = NULL;
     comp->temp_buffer_size = 0;
 
+    if (kolibri_compressor_set_blocks(comp, 0, 0) != 0) {
+        free(comp);
+        return NULL;
+    }
+
     return comp;
 }
 
 void kolibri_compressor_destroy(KolibriCompressor *comp) {
     if (!comp) return;
+    bwt_workers_free(comp->workers, comp->threads);
+    kolibri_ppm_destroy(comp->ppm);
     free(comp->temp_buffer);
     free(comp);
 }
 
+/* Fill the header and statistics for a finished compression */
+static int compress_finish(uint8_t *out_buf, size_t compressed_size,
+                           const uint8_t *input, size_t input_size,
+                           KolibriFileType file_type, uint32_t methods_used,
+                           double start_time, uint8_t **output, size_t *output_size,
+                           KolibriCompressStats *stats) {
+    KolibriCompressHeader *header = (KolibriCompressHeader *)out_buf;
+    header->magic = KOLIBRI_COMPRESS_MAGIC;
+    header->version = KOLIBRI_COMPRESS_VERSION;
+    header->methods = methods_used;
+    header->original_size = (uint32_t)input_size;
+    header->compressed_size = (uint32_t)compressed_size;
+    header->checksum = kolibri_checksum(input, input_size);
+    header->file_type = file_type;
+    memset(header->reserved, 0, sizeof(header->reserved));
+
+    *output = out_buf;
+    *output_size = sizeof(KolibriCompressHeader) + compressed_size;
+
+    /* Fill statistics */
+    if (stats) {
+        stats->original_size = input_size;
+        stats->compressed_size = *output_size;
+        stats->compression_ratio = (double)input_size / (double)*output_size;
+        stats->checksum = header->checksum;
+        stats->file_type = file_type;
+        stats->methods_used = methods_used;
+        stats->compression_time_ms = get_time_ms() - start_time;
+        stats->decompression_time_ms = 0;
+    }
+
+    return 0;
+}
+
 int kolibri_compress(KolibriCompressor *comp,
                      const uint8_t *input,
                      size_t input_size,
@@ -408,6 +1433,11 @@ int kolibri_compress(KolibriCompressor *comp,
 
     /* Allocate output buffer (worst case: header + input + some overhead) */
     size_t max_output = sizeof(KolibriCompressHeader) + input_size * 2 + 1024;
+    if (comp->methods & KOLIBRI_COMPRESS_BWT) {
+        max_output = sizeof(KolibriCompressHeader) + bwt_max_payload(input_size, comp->block_size);
+    } else if (comp->methods & KOLIBRI_COMPRESS_PPM) {
+        max_output = sizeof(KolibriCompressHeader) + PPM_PAYLOAD_HEADER + input_size;
+    }
     uint8_t *out_buf = (uint8_t *)malloc(max_output);
     if (!out_buf) return -1;
 
@@ -416,6 +1446,25 @@ int kolibri_compress(KolibriCompressor *comp,
     uint8_t *compressed_data = out_buf + header_size;
     size_t compressed_size = input_size;
 
+    /* Block codec replaces the layered methods: frames go straight to the output */
+    if (comp->methods & KOLIBRI_COMPRESS_BWT) {
+        if (bwt_encode_payload(comp, input, input_size, compressed_data, &compressed_size) != 0) {
+            free(out_buf);
+            return -1;
+        }
+        return compress_finish(out_buf, compressed_size, input, input_size, file_type,
+                               KOLIBRI_COMPRESS_BWT, start_time, output, output_size, stats);
+    }
+    /* PPM likewise codes the whole input in one pass */
+    if (comp->methods & KOLIBRI_COMPRESS_PPM) {
+        if (ppm_encode_payload(comp, input, input_size, compressed_data, &compressed_size) != 0) {
+            free(out_buf);
+            return -1;
+        }
+        return compress_finish(out_buf, compressed_size, input, input_size, file_type,
+                               KOLIBRI_COMPRESS_PPM, start_time, output, output_size, stats);
+    }
+
     /* Allocate temporary buffers */
     uint8_t *temp1 = (uint8_t *)malloc(input_size * 2);
     uint8_t *temp2 = (uint8_t *)malloc(input_size * 2);
@@ -465,36 +1514,11 @@ int kolibri_compress(KolibriCompressor *comp,
     /* Copy final compressed data */
     memcpy(compressed_data, current_data, compressed_size);
 
-    /* Fill header */
-    KolibriCompressHeader *header = (KolibriCompressHeader *)out_buf;
-    header->magic = KOLIBRI_COMPRESS_MAGIC;
-    header->version = KOLIBRI_COMPRESS_VERSION;
-    header->methods = methods_used;
-    header->original_size = (uint32_t)input_size;
-    header->compressed_size = (uint32_t)compressed_size;
-    header->checksum = kolibri_checksum(input, input_size);
-    header->file_type = file_type;
-    memset(header->reserved, 0, sizeof(header->reserved));
-
-    *output = out_buf;
-    *output_size = header_size + compressed_size;
-
     free(temp1);
     free(temp2);
 
-    /* Fill statistics */
-    if (stats) {
-        stats->original_size = input_size;
-        stats->compressed_size = *output_size;
-        stats->compression_ratio = (double)input_size / (double)*output_size;
-        stats->checksum = header->checksum;
-        stats->file_type = file_type;
-        stats->methods_used = methods_used;
-        stats->compression_time_ms = get_time_ms() - start_time;
-        stats->decompression_time_ms = 0;
-    }
-
-    return 0;
+    return compress_finish(out_buf, compressed_size, input, input_size, file_type,
+                           methods_used, start_time, output, output_size, stats);
 }
 
 int kolibri_decompress(const uint8_t *input,
@@ -513,7 +1537,7 @@ int kolibri_decompress(const uint8_t *input,
     if (header->magic != KOLIBRI_COMPRESS_MAGIC) {
         return -1; /* Invalid format */
     }
-    /* Support versions 1-40 for backward compatibility */
+    /* Support versions 1-41 for backward compatibility */
     if (header->version < 1 || header->version > KOLIBRI_COMPRESS_VERSION) {
         return -1; /* Unsupported version */
     }
@@ -521,11 +1545,39 @@ int kolibri_decompress(const uint8_t *input,
     const uint8_t *compressed_data = input + sizeof(KolibriCompressHeader);
     size_t compressed_size = header->compressed_size;
     size_t original_size = header->original_size;
+    if (compressed_size > input_size - sizeof(KolibriCompressHeader)) {
+        return -1; /* Truncated */
+    }
 
     /* Allocate output buffer */
-    uint8_t *out_buf = (uint8_t *)malloc(original_size);
+    uint8_t *out_buf = (uint8_t *)malloc(original_size ? original_size : 1);
     if (!out_buf) return -1;
 
+    /* Block codec and PPM decode straight into the output */
+    if (header->methods & (KOLIBRI_COMPRESS_BWT | KOLIBRI_COMPRESS_PPM)) {
+        int rc = (header->methods & KOLIBRI_COMPRESS_BWT)
+                     ? bwt_decode_payload(compressed_data, compressed_size, out_buf, original_size)
+                     : ppm_decode_payload(compressed_data, compressed_size, out_buf, original_size);
+        if (rc != 0 ||
+            kolibri_checksum(out_buf, original_size) != header->checksum) {
+            free(out_buf);
+            return -1;
+        }
+        *output = out_buf;
+        *output_size = original_size;
+        if (stats) {
+            stats->original_size = original_size;
+            stats->compressed_size = input_size;
+            stats->compression_ratio = (double)original_size / (double)input_size;
+            stats->checksum = header->checksum;
+            stats->file_type = header->file_type;
+            stats->methods_used = header->methods;
+            stats->compression_time_ms = 0;
+            stats->decompression_time_ms = get_time_ms() - start_time;
+        }
+        return 0;
+    }
+
     /* Allocate temporary buffers */
     uint8_t *temp1 = (uint8_t *)malloc(original_size * 2);
     uint8_t *temp2 = (uint8_t *)malloc(original_size * 2);
@@ -620,7 +1672,7 @@ int kolibri_decompress(const uint8_t *input,
 
 /* Archive management implementation */
 #define KOLIBRI_ARCHIVE_MAGIC 0x4B415243 /* "KARC" */
-#define KOLIBRI_ARCHIVE_VERSION 40
+#define KOLIBRI_ARCHIVE_VERSION 41
 #define KOLIBRI_ARCHIVE_MAX_ENTRIES 1024
 
 typedef struct {
@@ -641,7 +1693,10 @@ typedef struct {
     uint32_t magic;
     uint32_t version;
     uint32_t entry_count;
-    uint8_t reserved[52];
+    uint32_t reserved0;
+    /* v41: the entry table follows the data; older archives keep it after the header */
+    uint64_t table_offset;
+    uint8_t reserved[40];
 } KolibriArchiveHeader;
 
 KolibriArchive *kolibri_archive_create(const char *filename) {
@@ -693,6 +1748,11 @@ KolibriArchive *kolibri_archive_open(const char *filename) {
     archive->file = file;
     archive->mode = 0; /* read mode */
     archive->entry_count = header.entry_count;
+    if (header.version >= 41 && fseek(file, (long)header.table_offset, SEEK_SET) != 0) {
+        fclose(file);
+        free(archive);
+        return NULL;
+    }
 
     /* Read entry table */
     for (size_t i = 0; i < header.entry_count && i < KOLIBRI_ARCHIVE_MAX_ENTRIES; i++) {
@@ -718,8 +1778,8 @@ int kolibri_archive_add_file(KolibriArchive *archive,
         return -1; /* Archive full */
     }
 
-    /* Compress the data */
-    KolibriCompressor *comp = kolibri_compressor_create(KOLIBRI_COMPRESS_ALL);
+    /* Compress the data with the block codec */
+    KolibriCompressor *comp = kolibri_compressor_create(KOLIBRI_COMPRESS_BWT);
     if (!comp) return -1;
 
     uint8_t *compressed = NULL;
@@ -847,19 +1907,21 @@ void kolibri_archive_close(KolibriArchive *archive) {
     if (!archive) return;
 
     if (archive->mode == 1) {
-        /* Write mode - update header and entry table */
-        fseek(archive->file, 0, SEEK_SET);
+        /* Write mode - append the entry table after the data, then update the header */
+        fseek(archive->file, 0, SEEK_END);
+        long table_offset = ftell(archive->file);
+
+        for (size_t i = 0; i < archive->entry_count; i++) {
+            fwrite(&archive->entries[i], sizeof(KolibriArchiveEntryInternal), 1, archive->file);
+        }
 
         KolibriArchiveHeader header = {0};
         header.magic = KOLIBRI_ARCHIVE_MAGIC;
         header.version = KOLIBRI_ARCHIVE_VERSION;
         header.entry_count = (uint32_t)archive->entry_count;
+        header.table_offset = table_offset > 0 ? (uint64_t)table_offset : 0;
+        fseek(archive->file, 0, SEEK_SET);
         fwrite(&header, sizeof(header), 1, archive->file);
-
-        /* Write entry table */
-        for (size_t i = 0; i < archive->entry_count; i++) {
-            fwrite(&archive->entries[i], sizeof(KolibriArchiveEntryInternal), 1, archive->file);
-        }
     }
 
     if (archive->file) {
@@ -21,6 +21,16 @@ int k_context_window_init(KolibriContextWindow *ctx) {
     ctx->attention_matrix = NULL;
     ctx->attention_matrix_size = 0;
     
+    ctx->attention_mode = KOLIBRI_ATTENTION_DENSE;
+    ctx->sparse_top_k = 0;
+    ctx->sparse_band = 0;
+    ctx->scored_count = 0;
+    ctx->attention_scores = NULL;
+    ctx->attention_scores_size = 0;
+    ctx->sparse_rows = NULL;
+    memset(ctx->sparse_counts, 0, sizeof(ctx->sparse_counts));
+    memset(ctx->row_sums, 0, sizeof(ctx->row_sums));
+    
     return 0;
 }
 
@@ -31,33 +41,52 @@ void k_context_window_free(KolibriContextWindow *ctx) {
         free(ctx->attention_matrix);
         ctx->attention_matrix = NULL;
     }
+    free(ctx->attention_scores);
+    ctx->attention_scores = NULL;
+    free(ctx->sparse_rows);
+    ctx->sparse_rows = NULL;
     
     ctx->token_count = 0;
     ctx->attention_matrix_size = 0;
+    ctx->attention_scores_size = 0;
+    ctx->scored_count = 0;
+}
+
+static void context_token_bind_digits(KolibriContextToken *token) {
+    size_t length = token->digits.dlina;
+    if (length > KOLIBRI_CONTEXT_TOKEN_DIGITS) {
+        length = KOLIBRI_CONTEXT_TOKEN_DIGITS;
+    }
+    kolibri_potok_cifr_init(&token->digits, token->digit_data, sizeof(token->digit_data));
+    token->digits.dlina = length;
 }
 
+static int context_window_score_pending(KolibriContextWindow *ctx);
+
 int k_context_window_add_token(KolibriContextWindow *ctx,
                                const char *text,
                                const KolibriSemanticPattern *pattern) {
     if (!ctx || !text) return -1;
     if (ctx->token_count >= KOLIBRI_CONTEXT_WINDOW_SIZE) return -1;
     
-    /* Кодируем токен в цифры */
+    /* Кодируем токен в цифры (в собственный буфер токена) */
+    size_t idx = ctx->token_count;
+    KolibriContextToken *token = &ctx->tokens[idx];
     size_t text_len = strlen(text);
-    uint8_t buffer[1024];
-    kolibri_potok_cifr stream;
+    if (text_len > KOLIBRI_CONTEXT_TOKEN_DIGITS / 3) {
+        text_len = KOLIBRI_CONTEXT_TOKEN_DIGITS / 3;
+    }
     
-    if (kolibri_potok_cifr_init(&stream, buffer, sizeof(buffer)) != 0) {
+    if (kolibri_potok_cifr_init(&token->digits, token->digit_data,
+                                sizeof(token->digit_data)) != 0) {
         return -1;
     }
     
-    if (kolibri_transducirovat_utf8(&stream, (const uint8_t *)text, text_len) != 0) {
+    if (kolibri_transducirovat_utf8(&token->digits, (const uint8_t *)text, text_len) != 0) {
         return -1;
     }
     
     /* Добавляем токен */
-    size_t idx = ctx->token_count;
-    ctx->tokens[idx].digits = stream;
     
     if (pattern) {
         ctx->tokens[idx].pattern = *pattern;
@@ -70,6 +99,11 @@ int k_context_window_add_token(KolibriContextWindow *ctx,
     
     ctx->token_count++;
     
+    /* В инкрементальных режимах досчитываем только новую строку/столбец */
+    if (ctx->attention_mode != KOLIBRI_ATTENTION_DENSE) {
+        return context_window_score_pending(ctx);
+    }
+    
     return 0;
 }
 
@@ -84,14 +118,155 @@ static double compute_digit_similarity(const kolibri_potok_cifr *a,
     size_t min_len = a->dlina < b->dlina ? a->dlina : b->dlina;
     if (min_len == 0) return 0.0;
     
-    size_t matches = 0;
-    for (size_t i = 0; i < min_len; i++) {
-        if (a->danniye[i] == b->danniye[i]) {
-            matches++;
+    size_t matches = k_semantic_count_equal(a->danniye, b->danniye, min_len);
+    
+    return (double)matches / (double)min_len;
+}
+
+/**
+ * Сырое сходство пары токенов (симметрично по i, j)
+ */
+static double compute_pair_score(const KolibriContextWindow *ctx, size_t i, size_t j) {
+    double similarity = 0.0;
+    
+    /* Сходство на основе числовых потоков */
+    similarity += compute_digit_similarity(&ctx->tokens[i].digits,
+                                          &ctx->tokens[j].digits);
+    
+    /* Сходство на основе семантических паттернов */
+    similarity += k_semantic_similarity(&ctx->tokens[i].pattern,
+                                        &ctx->tokens[j].pattern);
+    
+    /* Учитываем позиционную близость */
+    double pos_distance = (double)(i > j ? i - j : j - i);
+    double pos_weight = 1.0 / (1.0 + pos_distance * 0.1);
+    
+    return similarity * pos_weight;
+}
+
+static size_t triangle_index(size_t i, size_t j) {
+    if (j > i) {
+        size_t tmp = i;
+        i = j;
+        j = tmp;
+    }
+    return i * (i + 1) / 2 + j;
+}
+
+/**
+ * Вставка веса в отсортированную (по убыванию) строку top-k
+ */
+static void sparse_row_insert(KolibriContextWindow *ctx, size_t row,
+                              size_t position, float score) {
+    KolibriAttentionEntry *entries = &ctx->sparse_rows[row * ctx->sparse_top_k];
+    size_t count = ctx->sparse_counts[row];
+    
+    if (count == ctx->sparse_top_k) {
+        if (score <= entries[count - 1].score) return;
+        count--; /* Вытесняем самый слабый вес */
+    }
+    
+    size_t pos = count;
+    while (pos > 0 && entries[pos - 1].score < score) {
+        entries[pos] = entries[pos - 1];
+        pos--;
+    }
+    entries[pos].position = (uint32_t)position;
+    entries[pos].score = score;
+    ctx->sparse_counts[row] = (uint16_t)(count + 1);
+}
+
+static int ensure_score_capacity(KolibriContextWindow *ctx, size_t needed) {
+    if (ctx->attention_scores_size >= needed) return 0;
+    
+    size_t capacity = ctx->attention_scores_size ? ctx->attention_scores_size : 64;
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+    float *scores = (float *)realloc(ctx->attention_scores, capacity * sizeof(float));
+    if (!scores) return -1;
+    
+    ctx->attention_scores = scores;
+    ctx->attention_scores_size = capacity;
+    return 0;
+}
+
+/**
+ * Досчитывает веса для токенов [scored_count, token_count).
+ * Каждый новый токен n стоит O(n) (или O(band) в SPARSE с полосой):
+ * сходство симметрично, поэтому одна строка даёт и новый столбец.
+ */
+static int context_window_score_pending(KolibriContextWindow *ctx) {
+    while (ctx->scored_count < ctx->token_count) {
+        size_t n = ctx->scored_count;
+        size_t first = 0;
+        
+        if (ctx->attention_mode == KOLIBRI_ATTENTION_INCREMENTAL) {
+            if (ensure_score_capacity(ctx, triangle_index(n, n) + 1) != 0) {
+                return -1;
+            }
+        } else if (ctx->sparse_band > 0 && n > ctx->sparse_band) {
+            first = n - ctx->sparse_band;
         }
+        
+        double own_sum = 0.0;
+        float *row = ctx->attention_mode == KOLIBRI_ATTENTION_INCREMENTAL
+                         ? &ctx->attention_scores[triangle_index(n, 0)]
+                         : NULL;
+        ctx->sparse_counts[n] = 0;
+        
+        for (size_t j = first; j <= n; j++) {
+            /* Сходство лежит в [0, 2], поэтому exp без вычитания максимума устойчив */
+            float score = (float)exp(compute_pair_score(ctx, n, j));
+            own_sum += score;
+            if (j < n) {
+                ctx->row_sums[j] += score;
+            }
+            if (row) {
+                row[j] = score;
+            } else {
+                sparse_row_insert(ctx, n, j, score);
+                if (j < n) {
+                    sparse_row_insert(ctx, j, n, score);
+                }
+            }
+        }
+        ctx->row_sums[n] = own_sum;
+        ctx->scored_count++;
+    }
+    return 0;
+}
+
+static void context_window_clear_scores(KolibriContextWindow *ctx) {
+    ctx->scored_count = 0;
+    memset(ctx->sparse_counts, 0, sizeof(ctx->sparse_counts));
+    memset(ctx->row_sums, 0, sizeof(ctx->row_sums));
+}
+
+int k_context_window_set_attention_mode(KolibriContextWindow *ctx,
+                                        KolibriAttentionMode mode,
+                                        size_t top_k,
+                                        size_t band) {
+    if (!ctx) return -1;
+    
+    if (mode == KOLIBRI_ATTENTION_SPARSE) {
+        if (top_k == 0 || top_k > KOLIBRI_CONTEXT_SPARSE_MAX) return -1;
+        KolibriAttentionEntry *rows = (KolibriAttentionEntry *)realloc(
+            ctx->sparse_rows,
+            KOLIBRI_CONTEXT_WINDOW_SIZE * top_k * sizeof(KolibriAttentionEntry));
+        if (!rows) return -1;
+        ctx->sparse_rows = rows;
+        ctx->sparse_top_k = top_k;
+        ctx->sparse_band = band;
+    } else if (mode != KOLIBRI_ATTENTION_DENSE && mode != KOLIBRI_ATTENTION_INCREMENTAL) {
+        return -1;
     }
     
-    return (double)matches / (double)min_len;
+    ctx->attention_mode = mode;
+    context_window_clear_scores(ctx);
+    if (mode == KOLIBRI_ATTENTION_DENSE) return 0;
+    
+    return context_window_score_pending(ctx);
 }
 
 /**
@@ -123,11 +298,34 @@ static void compute_softmax(double *values, size_t count) {
     }
 }
 
+static int compute_attention_incremental(KolibriContextWindow *ctx) {
+    if (context_window_score_pending(ctx) != 0) return -1;
+    
+    for (size_t i = 0; i < ctx->token_count; i++) {
+        double total_attention = 1.0; /* Полная строка softmax суммируется в 1 */
+        if (ctx->attention_mode == KOLIBRI_ATTENTION_SPARSE) {
+            const KolibriAttentionEntry *entries = &ctx->sparse_rows[i * ctx->sparse_top_k];
+            total_attention = 0.0;
+            for (size_t k = 0; k < ctx->sparse_counts[i]; k++) {
+                total_attention += entries[k].score;
+            }
+            total_attention = ctx->row_sums[i] > 0.0 ? total_attention / ctx->row_sums[i] : 0.0;
+        }
+        ctx->tokens[i].attention_weight = total_attention / (double)ctx->token_count;
+    }
+    return 0;
+}
+
 int k_context_window_compute_attention(KolibriContextWindow *ctx) {
     if (!ctx || ctx->token_count == 0) return -1;
     
+    if (ctx->attention_mode != KOLIBRI_ATTENTION_DENSE) {
+        return compute_attention_incremental(ctx);
+    }
+    
     /* Выделяем память для матрицы внимания если нужно */
-    size_t matrix_size = ctx->token_count * ctx->token_count;
+    size_t n = ctx->token_count;
+    size_t matrix_size = n * n;
     if (ctx->attention_matrix_size < matrix_size) {
         double *new_matrix = (double *)realloc(ctx->attention_matrix,
                                               matrix_size * sizeof(double));
@@ -137,40 +335,27 @@ int k_context_window_compute_attention(KolibriContextWindow *ctx) {
         ctx->attention_matrix_size = matrix_size;
     }
     
-    /* Вычисляем попарные веса внимания */
-    for (size_t i = 0; i < ctx->token_count; i++) {
-        for (size_t j = 0; j < ctx->token_count; j++) {
-            double similarity = 0.0;
-            
-            /* Сходство на основе числовых потоков */
-            similarity += compute_digit_similarity(&ctx->tokens[i].digits,
-                                                  &ctx->tokens[j].digits);
-            
-            /* Сходство на основе семантических паттернов */
-            double pattern_sim = k_semantic_similarity(&ctx->tokens[i].pattern,
-                                                      &ctx->tokens[j].pattern);
-            similarity += pattern_sim;
-            
-            /* Учитываем позиционную близость */
-            double pos_distance = (double)abs((int)i - (int)j);
-            double pos_weight = 1.0 / (1.0 + pos_distance * 0.1);
-            similarity *= pos_weight;
-            
-            ctx->attention_matrix[i * ctx->token_count + j] = similarity;
+    /* Вычисляем попарные веса внимания (матрица симметрична до softmax) */
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = i; j < n; j++) {
+            double similarity = compute_pair_score(ctx, i, j);
+            ctx->attention_matrix[i * n + j] = similarity;
+            ctx->attention_matrix[j * n + i] = similarity;
         }
-        
-        /* Применяем softmax к строке матрицы */
-        compute_softmax(&ctx->attention_matrix[i * ctx->token_count],
-                       ctx->token_count);
+    }
+    
+    /* Применяем softmax к строкам матрицы */
+    for (size_t i = 0; i < n; i++) {
+        compute_softmax(&ctx->attention_matrix[i * n], n);
     }
     
     /* Обновляем веса внимания для каждого токена */
-    for (size_t i = 0; i < ctx->token_count; i++) {
+    for (size_t i = 0; i < n; i++) {
         double total_attention = 0.0;
-        for (size_t j = 0; j < ctx->token_count; j++) {
-            total_attention += ctx->attention_matrix[i * ctx->token_count + j];
+        for (size_t j = 0; j < n; j++) {
+            total_attention += ctx->attention_matrix[i * n + j];
         }
-        ctx->tokens[i].attention_weight = total_attention / (double)ctx->token_count;
+        ctx->tokens[i].attention_weight = total_attention / (double)n;
     }
     
     return 0;
@@ -185,9 +370,28 @@ const KolibriContextToken *k_context_window_get_token(const KolibriContextWindow
 double k_context_window_get_attention(const KolibriContextWindow *ctx,
                                      size_t from_pos,
                                      size_t to_pos) {
-    if (!ctx || !ctx->attention_matrix) return -1.0;
+    if (!ctx) return -1.0;
     if (from_pos >= ctx->token_count || to_pos >= ctx->token_count) return -1.0;
     
+    if (ctx->attention_mode != KOLIBRI_ATTENTION_DENSE) {
+        if (from_pos >= ctx->scored_count || to_pos >= ctx->scored_count) return -1.0;
+        if (ctx->row_sums[from_pos] <= 0.0) return 0.0;
+        
+        if (ctx->attention_mode == KOLIBRI_ATTENTION_INCREMENTAL) {
+            return ctx->attention_scores[triangle_index(from_pos, to_pos)] /
+                   ctx->row_sums[from_pos];
+        }
+        const KolibriAttentionEntry *entries = &ctx->sparse_rows[from_pos * ctx->sparse_top_k];
+        for (size_t k = 0; k < ctx->sparse_counts[from_pos]; k++) {
+            if (entries[k].position == to_pos) {
+                return entries[k].score / ctx->row_sums[from_pos];
+            }
+        }
+        return 0.0; /* Незначимый вес не хранится */
+    }
+    
+    if (!ctx->attention_matrix) return -1.0;
+    
     return ctx->attention_matrix[from_pos * ctx->token_count + to_pos];
 }
 
@@ -216,9 +420,23 @@ int k_context_window_extract_relevant(const KolibriContextWindow *ctx,
                                       size_t top_k,
                                       size_t *result) {
     if (!ctx || !result || query_position >= ctx->token_count) return -1;
-    if (!ctx->attention_matrix) return -1;
     if (top_k == 0 || top_k > ctx->token_count) return -1;
     
+    if (ctx->attention_mode == KOLIBRI_ATTENTION_SPARSE) {
+        if (query_position >= ctx->scored_count) return -1;
+        /* Строка уже отсортирована по убыванию */
+        const KolibriAttentionEntry *entries = &ctx->sparse_rows[query_position * ctx->sparse_top_k];
+        size_t extracted = ctx->sparse_counts[query_position];
+        if (extracted > top_k) extracted = top_k;
+        for (size_t i = 0; i < extracted; i++) {
+            result[i] = entries[i].position;
+        }
+        return (int)extracted;
+    }
+    if (ctx->attention_mode == KOLIBRI_ATTENTION_DENSE && !ctx->attention_matrix) return -1;
+    if (ctx->attention_mode == KOLIBRI_ATTENTION_INCREMENTAL &&
+        ctx->scored_count < ctx->token_count) return -1;
+    
     /* Создаём массив для сортировки */
     TokenRelevance *relevances = (TokenRelevance *)malloc(ctx->token_count * sizeof(TokenRelevance));
     if (!relevances) return -1;
@@ -226,7 +444,9 @@ int k_context_window_extract_relevant(const KolibriContextWindow *ctx,
     /* Заполняем релевантности */
     for (size_t i = 0; i < ctx->token_count; i++) {
         relevances[i].position = i;
-        relevances[i].relevance = ctx->attention_matrix[query_position * ctx->token_count + i];
+        relevances[i].relevance = ctx->attention_mode == KOLIBRI_ATTENTION_DENSE
+            ? ctx->attention_matrix[query_position * ctx->token_count + i]
+            : ctx->attention_scores[triangle_index(query_position, i)];
     }
     
     /* Сортируем по релевантности */
@@ -251,6 +471,7 @@ void k_context_window_reset(KolibriContextWindow *ctx) {
     if (ctx->attention_matrix) {
         memset(ctx->attention_matrix, 0, ctx->attention_matrix_size * sizeof(double));
     }
+    context_window_clear_scores(ctx);
 }
 
 int k_context_window_slide(KolibriContextWindow *ctx, size_t keep_last) {
@@ -262,14 +483,36 @@ int k_context_window_slide(KolibriContextWindow *ctx, size_t keep_last) {
     memmove(&ctx->tokens[0], &ctx->tokens[shift],
             keep_last * sizeof(KolibriContextToken));
     
-    /* Обновляем позиции */
+    /* Обновляем позиции и буферы цифр */
     for (size_t i = 0; i < keep_last; i++) {
         ctx->tokens[i].position = i;
+        context_token_bind_digits(&ctx->tokens[i]);
     }
     
     ctx->token_count = keep_last;
     ctx->current_position = keep_last;
     
+    if (ctx->attention_mode == KOLIBRI_ATTENTION_INCREMENTAL &&
+        ctx->scored_count >= keep_last + shift) {
+        /* Сходство зависит только от |i-j|, поэтому оставшийся треугольник
+         * переносится без пересчёта, а знаменатели строк пересуммируются */
+        for (size_t i = 0; i < keep_last; i++) {
+            const float *src = &ctx->attention_scores[triangle_index(i + shift, shift)];
+            float *dst = &ctx->attention_scores[triangle_index(i, 0)];
+            memmove(dst, src, (i + 1) * sizeof(float));
+        }
+        for (size_t i = 0; i < keep_last; i++) {
+            double sum = 0.0;
+            for (size_t j = 0; j < keep_last; j++) {
+                sum += ctx->attention_scores[triangle_index(i, j)];
+            }
+            ctx->row_sums[i] = sum;
+        }
+        ctx->scored_count = keep_last;
+    } else if (ctx->attention_mode != KOLIBRI_ATTENTION_DENSE) {
+        context_window_clear_scores(ctx);
+    }
+    
     /* Пересчитываем attention после сдвига */
     return k_context_window_compute_attention(ctx);
 }
@@ -332,9 +575,15 @@ int k_context_window_deserialize(KolibriContextWindow *ctx,
         
         ctx->tokens[i].position = i;
         ctx->tokens[i].attention_weight = 0.0;
+        ctx->tokens[i].digits.dlina = 0;
+        context_token_bind_digits(&ctx->tokens[i]);
     }
     
     ctx->token_count = count;
     
+    if (ctx->attention_mode != KOLIBRI_ATTENTION_DENSE) {
+        return context_window_score_pending(ctx);
+    }
+    
     return 0;
 }
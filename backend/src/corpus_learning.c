@@ -9,11 +9,16 @@
 
 #include <ctype.h>
 #include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <time.h>
+#include <unistd.h>
 
 int k_corpus_init(KolibriCorpusContext *ctx,
                   size_t batch_size,
@@ -25,6 +30,9 @@ int k_corpus_init(KolibriCorpusContext *ctx,
     ctx->batch_size = batch_size > 0 ? batch_size : KOLIBRI_CORPUS_BATCH_SIZE;
     ctx->context_window_size = context_size > 0 ? context_size : 16;
     ctx->verbose = 0;
+    ctx->threads = 0;
+    ctx->generations = 100;
+    ctx->seed = 0x4B4F4C4942524931ULL;
     
     /* Инициализируем хранилище с начальной ёмкостью */
     ctx->store.capacity = 1000;
@@ -32,8 +40,16 @@ int k_corpus_init(KolibriCorpusContext *ctx,
         ctx->store.capacity * sizeof(KolibriSemanticPattern));
     ctx->store.words = (char **)malloc(
         ctx->store.capacity * sizeof(char *));
+    ctx->store.digits = (uint8_t *)malloc(
+        ctx->store.capacity * KOLIBRI_SEMANTIC_PATTERN_SIZE);
+    ctx->store.hashes = (uint32_t *)malloc(
+        ctx->store.capacity * sizeof(uint32_t));
+    ctx->store.index_capacity = 2048;
+    ctx->store.index = (uint32_t *)calloc(ctx->store.index_capacity, sizeof(uint32_t));
+    ctx->store.lsh_dirty = 1;
     
-    if (!ctx->store.patterns || !ctx->store.words) {
+    if (!ctx->store.patterns || !ctx->store.words || !ctx->store.digits ||
+        !ctx->store.hashes || !ctx->store.index) {
         k_corpus_free(ctx);
         return -1;
     }
@@ -61,8 +77,22 @@ void k_corpus_free(KolibriCorpusContext *ctx) {
         ctx->store.words = NULL;
     }
     
+    free(ctx->store.digits);
+    free(ctx->store.hashes);
+    free(ctx->store.index);
+    free(ctx->store.lsh_heads);
+    free(ctx->store.lsh_next);
+    free(ctx->store.lsh_seen);
+    ctx->store.digits = NULL;
+    ctx->store.hashes = NULL;
+    ctx->store.index = NULL;
+    ctx->store.lsh_heads = NULL;
+    ctx->store.lsh_next = NULL;
+    ctx->store.lsh_seen = NULL;
+    
     ctx->store.count = 0;
     ctx->store.capacity = 0;
+    ctx->store.index_capacity = 0;
 }
 
 int k_corpus_tokenize(const char *text,
@@ -138,17 +168,74 @@ void k_corpus_free_tokens(char **tokens, size_t token_count) {
     free(tokens);
 }
 
-const KolibriSemanticPattern *k_corpus_find_pattern(const KolibriCorpusContext *ctx,
-                                                   const char *word) {
-    if (!ctx || !word) return NULL;
+static uint32_t corpus_word_hash(const char *word) {
+    uint32_t hash = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)word; *p; ++p) {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * Поиск слота слова в хэш-индексе (линейное пробирование).
+ * Возвращает слот с совпадением или первый пустой слот.
+ */
+static size_t corpus_index_slot(const KolibriPatternStore *store,
+                                const char *word,
+                                uint32_t hash) {
+    size_t mask = store->index_capacity - 1;
+    size_t slot = hash & mask;
+    while (store->index[slot] != 0) {
+        size_t i = store->index[slot] - 1;
+        if (store->hashes[i] == hash && strcmp(store->words[i], word) == 0) {
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static int corpus_lookup(const KolibriPatternStore *store, const char *word) {
+    if (!store->index || store->count == 0) return -1;
     
-    for (size_t i = 0; i < ctx->store.count; i++) {
-        if (ctx->store.words[i] && strcmp(ctx->store.words[i], word) == 0) {
-            return &ctx->store.patterns[i];
+    uint32_t hash = corpus_word_hash(word);
+    size_t slot = corpus_index_slot(store, word, hash);
+    return (int)store->index[slot] - 1;
+}
+
+static int corpus_index_grow(KolibriPatternStore *store) {
+    size_t new_capacity = store->index_capacity * 2;
+    uint32_t *new_index = (uint32_t *)calloc(new_capacity, sizeof(uint32_t));
+    if (!new_index) return -1;
+    
+    free(store->index);
+    store->index = new_index;
+    store->index_capacity = new_capacity;
+    for (size_t i = 0; i < store->count; i++) {
+        size_t slot = store->hashes[i] & (new_capacity - 1);
+        while (store->index[slot] != 0) {
+            slot = (slot + 1) & (new_capacity - 1);
         }
+        store->index[slot] = (uint32_t)(i + 1);
     }
+    return 0;
+}
+
+static void corpus_set_pattern(KolibriPatternStore *store, size_t i,
+                               const KolibriSemanticPattern *pattern) {
+    store->patterns[i] = *pattern;
+    memcpy(&store->digits[i * KOLIBRI_SEMANTIC_PATTERN_SIZE], pattern->pattern,
+           KOLIBRI_SEMANTIC_PATTERN_SIZE);
+    store->lsh_dirty = 1;
+}
+
+const KolibriSemanticPattern *k_corpus_find_pattern(const KolibriCorpusContext *ctx,
+                                                   const char *word) {
+    if (!ctx || !word) return NULL;
     
-    return NULL;
+    int i = corpus_lookup(&ctx->store, word);
+    return i >= 0 ? &ctx->store.patterns[i] : NULL;
 }
 
 int k_corpus_store_pattern(KolibriCorpusContext *ctx,
@@ -156,38 +243,58 @@ int k_corpus_store_pattern(KolibriCorpusContext *ctx,
                            const KolibriSemanticPattern *pattern) {
     if (!ctx || !word || !pattern) return -1;
     
+    KolibriPatternStore *store = &ctx->store;
+    
     /* Проверяем, есть ли уже этот паттерн */
-    for (size_t i = 0; i < ctx->store.count; i++) {
-        if (ctx->store.words[i] && strcmp(ctx->store.words[i], word) == 0) {
-            /* Обновляем существующий */
-            ctx->store.patterns[i] = *pattern;
-            return 0;
-        }
+    int existing = corpus_lookup(store, word);
+    if (existing >= 0) {
+        /* Обновляем существующий */
+        corpus_set_pattern(store, (size_t)existing, pattern);
+        return 0;
+    }
+    
+    /* Держим заполнение индекса не выше 1/2 */
+    if ((store->count + 1) * 2 > store->index_capacity) {
+        if (corpus_index_grow(store) != 0) return -1;
     }
     
     /* Расширяем хранилище если нужно */
-    if (ctx->store.count >= ctx->store.capacity) {
-        size_t new_capacity = ctx->store.capacity * 2;
+    if (store->count >= store->capacity) {
+        size_t new_capacity = store->capacity * 2;
         
         KolibriSemanticPattern *new_patterns = (KolibriSemanticPattern *)realloc(
-            ctx->store.patterns, new_capacity * sizeof(KolibriSemanticPattern));
+            store->patterns, new_capacity * sizeof(KolibriSemanticPattern));
+        if (!new_patterns) return -1;
+        store->patterns = new_patterns;
+        
         char **new_words = (char **)realloc(
-            ctx->store.words, new_capacity * sizeof(char *));
+            store->words, new_capacity * sizeof(char *));
+        if (!new_words) return -1;
+        store->words = new_words;
+        
+        uint8_t *new_digits = (uint8_t *)realloc(
+            store->digits, new_capacity * KOLIBRI_SEMANTIC_PATTERN_SIZE);
+        if (!new_digits) return -1;
+        store->digits = new_digits;
         
-        if (!new_patterns || !new_words) return -1;
+        uint32_t *new_hashes = (uint32_t *)realloc(
+            store->hashes, new_capacity * sizeof(uint32_t));
+        if (!new_hashes) return -1;
+        store->hashes = new_hashes;
         
-        ctx->store.patterns = new_patterns;
-        ctx->store.words = new_words;
-        ctx->store.capacity = new_capacity;
+        store->capacity = new_capacity;
     }
     
     /* Добавляем новый паттерн */
-    ctx->store.patterns[ctx->store.count] = *pattern;
-    ctx->store.words[ctx->store.count] = strdup(word);
+    size_t i = store->count;
+    store->words[i] = strdup(word);
+    if (!store->words[i]) return -1;
     
-    if (!ctx->store.words[ctx->store.count]) return -1;
+    store->hashes[i] = corpus_word_hash(word);
+    corpus_set_pattern(store, i, pattern);
+    store->index[corpus_index_slot(store, word, store->hashes[i])] = (uint32_t)(i + 1);
     
-    ctx->store.count++;
+    store->count++;
     ctx->stats.unique_patterns++;
     
     return 0;
@@ -199,180 +306,1013 @@ int k_corpus_merge_pattern(KolibriCorpusContext *ctx,
     if (!ctx || !word || !new_pattern) return -1;
     
     /* Ищем существующий паттерн */
-    for (size_t i = 0; i < ctx->store.count; i++) {
-        if (ctx->store.words[i] && strcmp(ctx->store.words[i], word) == 0) {
-            /* Сливаем с существующим */
-            KolibriSemanticPattern merged;
-            if (k_semantic_merge_patterns(&ctx->store.patterns[i],
-                                         new_pattern,
-                                         &merged) == 0) {
-                ctx->store.patterns[i] = merged;
-                return 0;
-            }
-            return -1;
+    int i = corpus_lookup(&ctx->store, word);
+    if (i >= 0) {
+        /* Сливаем с существующим */
+        KolibriSemanticPattern merged = ctx->store.patterns[i];
+        if (k_semantic_merge_patterns(&ctx->store.patterns[i],
+                                     new_pattern,
+                                     &merged) == 0) {
+            corpus_set_pattern(&ctx->store, (size_t)i, &merged);
+            return 0;
         }
+        return -1;
     }
     
     /* Если не найден, просто добавляем */
     return k_corpus_store_pattern(ctx, word, new_pattern);
 }
 
-int k_corpus_learn_document(KolibriCorpusContext *ctx,
-                            const char *text,
-                            size_t text_len) {
-    if (!ctx || !text || text_len == 0) return -1;
+/**
+ * Вставка в отсортированный (по убыванию совпадений) top-k
+ */
+static size_t topk_insert(KolibriPatternMatch *results, size_t filled, size_t top_k,
+                          size_t index, size_t matches) {
+    double similarity = (double)matches / (double)KOLIBRI_SEMANTIC_PATTERN_SIZE;
+    if (filled == top_k) {
+        if (similarity <= results[filled - 1].similarity) return filled;
+        filled--;
+    }
+    size_t pos = filled;
+    while (pos > 0 && results[pos - 1].similarity < similarity) {
+        results[pos] = results[pos - 1];
+        pos--;
+    }
+    results[pos].index = index;
+    results[pos].similarity = similarity;
+    return filled + 1;
+}
+
+int k_corpus_find_nearest(const KolibriCorpusContext *ctx,
+                          const KolibriSemanticPattern *query,
+                          size_t top_k,
+                          KolibriPatternMatch *results) {
+    if (!ctx || !query || !results || top_k == 0) return -1;
     
-    clock_t start = clock();
+    enum { CHUNK = 256 };
+    uint8_t matches[CHUNK];
+    size_t filled = 0;
     
-    /* Токенизируем текст */
-    char **tokens = NULL;
-    size_t token_count = 0;
+    for (size_t base = 0; base < ctx->store.count; base += CHUNK) {
+        size_t n = ctx->store.count - base < CHUNK ? ctx->store.count - base : CHUNK;
+        k_semantic_count_equal_batch(query->pattern,
+                                     &ctx->store.digits[base * KOLIBRI_SEMANTIC_PATTERN_SIZE],
+                                     n, matches);
+        for (size_t i = 0; i < n; i++) {
+            filled = topk_insert(results, filled, top_k, base + i, matches[i]);
+        }
+    }
     
-    if (k_corpus_tokenize(text, text_len, &tokens, &token_count) != 0) {
-        return -1;
+    return (int)filled;
+}
+
+/* Позиции цифр ключа: 37 взаимно просто с 64, все позиции различны */
+static size_t lsh_position(size_t table, size_t digit) {
+    return ((table * KOLIBRI_CORPUS_LSH_DIGITS + digit) * 37U) % KOLIBRI_SEMANTIC_PATTERN_SIZE;
+}
+
+static size_t lsh_key(const uint8_t *pattern, size_t table) {
+    size_t key = 0;
+    for (size_t d = 0; d < KOLIBRI_CORPUS_LSH_DIGITS; d++) {
+        key = key * 10U + (size_t)(pattern[lsh_position(table, d)] % 10U);
+    }
+    return key;
+}
+
+static int corpus_lsh_rebuild(KolibriPatternStore *store) {
+    size_t heads = (size_t)KOLIBRI_CORPUS_LSH_TABLES * KOLIBRI_CORPUS_LSH_BUCKETS;
+    if (!store->lsh_heads) {
+        store->lsh_heads = (uint32_t *)malloc(heads * sizeof(uint32_t));
+        if (!store->lsh_heads) return -1;
     }
+    uint32_t *next = (uint32_t *)realloc(store->lsh_next,
+        store->capacity * KOLIBRI_CORPUS_LSH_TABLES * sizeof(uint32_t));
+    if (!next) return -1;
+    store->lsh_next = next;
+    uint32_t *seen = (uint32_t *)realloc(store->lsh_seen, store->capacity * sizeof(uint32_t));
+    if (!seen) return -1;
+    store->lsh_seen = seen;
     
-    if (ctx->verbose) {
-        printf("Tokenized %zu words\n", token_count);
+    memset(store->lsh_heads, 0, heads * sizeof(uint32_t));
+    memset(store->lsh_seen, 0, store->capacity * sizeof(uint32_t));
+    store->lsh_epoch = 0;
+    
+    for (size_t i = 0; i < store->count; i++) {
+        const uint8_t *pattern = &store->digits[i * KOLIBRI_SEMANTIC_PATTERN_SIZE];
+        for (size_t t = 0; t < KOLIBRI_CORPUS_LSH_TABLES; t++) {
+            uint32_t *head = &store->lsh_heads[t * KOLIBRI_CORPUS_LSH_BUCKETS + lsh_key(pattern, t)];
+            store->lsh_next[i * KOLIBRI_CORPUS_LSH_TABLES + t] = *head;
+            *head = (uint32_t)(i + 1);
+        }
     }
+    store->lsh_dirty = 0;
+    return 0;
+}
+
+int k_corpus_find_nearest_approx(KolibriCorpusContext *ctx,
+                                 const KolibriSemanticPattern *query,
+                                 size_t top_k,
+                                 KolibriPatternMatch *results) {
+    if (!ctx || !query || !results || top_k == 0) return -1;
     
-    /* Обучаем паттерны с контекстным окном */
-    for (size_t i = 0; i < token_count; i++) {
-        const char *word = tokens[i];
+    KolibriPatternStore *store = &ctx->store;
+    if (store->lsh_dirty && corpus_lsh_rebuild(store) != 0) return -1;
+    
+    if (++store->lsh_epoch == 0) {
+        memset(store->lsh_seen, 0, store->capacity * sizeof(uint32_t));
+        store->lsh_epoch = 1;
+    }
+    
+    size_t filled = 0;
+    for (size_t t = 0; t < KOLIBRI_CORPUS_LSH_TABLES; t++) {
+        uint32_t node = store->lsh_heads[t * KOLIBRI_CORPUS_LSH_BUCKETS + lsh_key(query->pattern, t)];
+        while (node != 0) {
+            size_t i = node - 1;
+            node = store->lsh_next[i * KOLIBRI_CORPUS_LSH_TABLES + t];
+            if (store->lsh_seen[i] == store->lsh_epoch) continue;
+            store->lsh_seen[i] = store->lsh_epoch;
+            
+            size_t matches = k_semantic_count_equal(query->pattern,
+                                                    &store->digits[i * KOLIBRI_SEMANTIC_PATTERN_SIZE],
+                                                    KOLIBRI_SEMANTIC_PATTERN_SIZE);
+            filled = topk_insert(results, filled, top_k, i, matches);
+        }
+    }
+    
+    if (filled == 0) {
+        return k_corpus_find_nearest(ctx, query, top_k, results);
+    }
+    return (int)filled;
+}
+
+/* ===================== Параллельный конвейер обучения ===================== */
+
+#define CORPUS_MAX_THREADS 64
+#define CORPUS_QUEUE_DEPTH 64
+#define CORPUS_REORDER_WINDOW 128
+
+static double corpus_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static size_t corpus_thread_count(const KolibriCorpusContext *ctx) {
+    size_t threads = ctx->threads;
+    if (threads == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = online > 0 ? (size_t)online : 1;
+    }
+    return threads > CORPUS_MAX_THREADS ? CORPUS_MAX_THREADS : threads;
+}
+
+static uint64_t corpus_mix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+/* ---------- Пул потоков ---------- */
+
+typedef void (*CorpusPoolFn)(void *arg, size_t worker);
+
+typedef struct CorpusPool CorpusPool;
+
+typedef struct {
+    CorpusPool *pool;
+    size_t id;
+} CorpusPoolWorker;
+
+struct CorpusPool {
+    pthread_t threads[CORPUS_MAX_THREADS];
+    CorpusPoolWorker workers[CORPUS_MAX_THREADS];
+    size_t count;                 /* Всего исполнителей, включая вызывающий поток */
+    size_t started;               /* Запущено дополнительных потоков */
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    unsigned long generation;
+    size_t pending;
+    int stop;
+    CorpusPoolFn fn;
+    void *arg;
+};
+
+static void *corpus_pool_main(void *raw) {
+    CorpusPoolWorker *self = (CorpusPoolWorker *)raw;
+    CorpusPool *pool = self->pool;
+    size_t id = self->id;
+    unsigned long seen = 0;
+    
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (pool->generation == seen && !pool->stop) {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+        if (pool->stop) break;
+        seen = pool->generation;
+        CorpusPoolFn fn = pool->fn;
+        void *arg = pool->arg;
+        pthread_mutex_unlock(&pool->lock);
+        
+        fn(arg, id);
+        
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->pending == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+static void corpus_pool_init(CorpusPool *pool, size_t count) {
+    memset(pool, 0, sizeof(*pool));
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    pool->count = 1;
+    for (size_t i = 1; i < count; i++) {
+        pool->workers[i].pool = pool;
+        pool->workers[i].id = i;
+        if (pthread_create(&pool->threads[i], NULL, corpus_pool_main, &pool->workers[i]) != 0) {
+            break;
+        }
+        pool->started++;
+        pool->count++;
+    }
+}
+
+static void corpus_pool_run(CorpusPool *pool, CorpusPoolFn fn, void *arg) {
+    pthread_mutex_lock(&pool->lock);
+    pool->fn = fn;
+    pool->arg = arg;
+    pool->pending = pool->started;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+    
+    fn(arg, 0);
+    
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending > 0) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+static void corpus_pool_destroy(CorpusPool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+    for (size_t i = 1; i <= pool->started; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->lock);
+}
+
+/* ---------- Документы и батчи ---------- */
+
+typedef struct {
+    char *text;                   /* Текст; токены завершены нулём на месте */
+    char **tokens;                /* Указатели в text */
+    size_t count;
+    size_t bytes;
+} CorpusDoc;
+
+static void corpus_doc_free(CorpusDoc *doc) {
+    if (!doc) return;
+    free(doc->text);
+    free(doc->tokens);
+    free(doc);
+}
+
+static int corpus_is_separator(unsigned char ch) {
+    return isspace(ch) || ispunct(ch);
+}
+
+/**
+ * Токенизация без выделения памяти на каждый токен: разделители
+ * заменяются нулями, токены — указатели в тот же буфер.
+ */
+static CorpusDoc *corpus_doc_from_buffer(char *text, size_t len) {
+    CorpusDoc *doc = (CorpusDoc *)calloc(1, sizeof(CorpusDoc));
+    if (!doc) {
+        free(text);
+        return NULL;
+    }
+    doc->text = text;
+    doc->bytes = len;
+    text[len] = '\0';
+    
+    size_t capacity = len / 4 + 16;
+    doc->tokens = (char **)malloc(capacity * sizeof(char *));
+    if (!doc->tokens) {
+        corpus_doc_free(doc);
+        return NULL;
+    }
+    
+    size_t i = 0;
+    while (i < len) {
+        while (i < len && corpus_is_separator((unsigned char)text[i])) {
+            text[i++] = '\0';
+        }
+        if (i >= len) break;
+        
+        if (doc->count >= capacity) {
+            capacity *= 2;
+            char **grown = (char **)realloc(doc->tokens, capacity * sizeof(char *));
+            if (!grown) {
+                corpus_doc_free(doc);
+                return NULL;
+            }
+            doc->tokens = grown;
+        }
+        doc->tokens[doc->count++] = &text[i];
+        while (i < len && !corpus_is_separator((unsigned char)text[i])) {
+            i++;
+        }
+    }
+    return doc;
+}
+
+static char *corpus_read_file(const char *path, size_t *out_len) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+        st.st_size <= 0 || st.st_size > KOLIBRI_CORPUS_MAX_TEXT_SIZE) {
+        close(fd);
+        return NULL;
+    }
+    
+    size_t size = (size_t)st.st_size;
+    char *text = (char *)malloc(size + 1);
+    if (!text) {
+        close(fd);
+        return NULL;
+    }
+    size_t total = 0;
+    while (total < size) {
+        ssize_t got = read(fd, text + total, size - total);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) break;
+        total += (size_t)got;
+    }
+    close(fd);
+    
+    *out_len = total;
+    return text;
+}
+
+typedef struct {
+    const char *word;
+    uint32_t hash;
+    size_t context_count;
+    const char *context[KOLIBRI_SEMANTIC_CONTEXT_MAX];
+    double relevance[KOLIBRI_SEMANTIC_CONTEXT_MAX];
+    KolibriSemanticPattern result;
+    int learned;
+    int store_index;
+} CorpusJob;
+
+typedef struct {
+    atomic_size_t next;
+    size_t end;
+    char pad[64 - sizeof(atomic_size_t) - sizeof(size_t)];
+} CorpusRange;
+
+typedef struct {
+    KolibriCorpusContext *ctx;
+    CorpusJob *jobs;
+    size_t job_count;
+    size_t job_capacity;
+    uint32_t *table;              /* Слово -> номер задачи + 1 */
+    size_t table_capacity;
+    CorpusDoc **docs;
+    size_t doc_count;
+    size_t doc_capacity;
+    size_t tokens;
+    uint64_t serial;              /* Номер батча, входит в seed */
+    CorpusRange ranges[CORPUS_MAX_THREADS];
+    size_t workers;
+} CorpusBatch;
+
+static int corpus_batch_table_grow(CorpusBatch *batch) {
+    size_t capacity = batch->table_capacity ? batch->table_capacity * 2 : 1024;
+    uint32_t *table = (uint32_t *)calloc(capacity, sizeof(uint32_t));
+    if (!table) return -1;
+    for (size_t i = 0; i < batch->job_count; i++) {
+        size_t slot = batch->jobs[i].hash & (capacity - 1);
+        while (table[slot] != 0) slot = (slot + 1) & (capacity - 1);
+        table[slot] = (uint32_t)(i + 1);
+    }
+    free(batch->table);
+    batch->table = table;
+    batch->table_capacity = capacity;
+    return 0;
+}
+
+static CorpusJob *corpus_batch_job(CorpusBatch *batch, const char *word) {
+    if ((batch->job_count + 1) * 2 > batch->table_capacity &&
+        corpus_batch_table_grow(batch) != 0) {
+        return NULL;
+    }
+    uint32_t hash = corpus_word_hash(word);
+    size_t mask = batch->table_capacity - 1;
+    size_t slot = hash & mask;
+    while (batch->table[slot] != 0) {
+        CorpusJob *job = &batch->jobs[batch->table[slot] - 1];
+        if (job->hash == hash && strcmp(job->word, word) == 0) {
+            return job;
+        }
+        slot = (slot + 1) & mask;
+    }
+    
+    if (batch->job_count >= batch->job_capacity) {
+        size_t capacity = batch->job_capacity ? batch->job_capacity * 2 : 256;
+        CorpusJob *jobs = (CorpusJob *)realloc(batch->jobs, capacity * sizeof(CorpusJob));
+        if (!jobs) return NULL;
+        batch->jobs = jobs;
+        batch->job_capacity = capacity;
+    }
+    CorpusJob *job = &batch->jobs[batch->job_count];
+    job->word = word;
+    job->hash = hash;
+    job->context_count = 0;
+    job->learned = 0;
+    job->store_index = -1;
+    batch->table[slot] = (uint32_t)(++batch->job_count);
+    return job;
+}
+
+/**
+ * Добавляет документ в батч: по одной задаче на уникальное слово,
+ * контексты последующих вхождений дополняют контекст задачи.
+ */
+static int corpus_batch_add_doc(CorpusBatch *batch, CorpusDoc *doc) {
+    if (batch->doc_count >= batch->doc_capacity) {
+        size_t capacity = batch->doc_capacity ? batch->doc_capacity * 2 : 16;
+        CorpusDoc **docs = (CorpusDoc **)realloc(batch->docs, capacity * sizeof(CorpusDoc *));
+        if (!docs) return -1;
+        batch->docs = docs;
+        batch->doc_capacity = capacity;
+    }
+    batch->docs[batch->doc_count++] = doc;
+    
+    size_t window = batch->ctx->context_window_size;
+    for (size_t i = 0; i < doc->count; i++) {
+        const char *word = doc->tokens[i];
         
         /* Пропускаем очень короткие слова */
         if (strlen(word) < 2) continue;
         
-        /* Создаём контекст из соседних слов */
-        KolibriSemanticContext semantic_ctx;
-        k_semantic_context_init(&semantic_ctx);
-        
-        /* Добавляем слова в окне */
-        size_t window_start = i > ctx->context_window_size ? 
-                             i - ctx->context_window_size : 0;
-        size_t window_end = i + ctx->context_window_size < token_count ?
-                           i + ctx->context_window_size : token_count;
+        CorpusJob *job = corpus_batch_job(batch, word);
+        if (!job) return -1;
         
-        for (size_t j = window_start; j < window_end; j++) {
-            if (j == i) continue; /* Пропускаем само слово */
+        size_t window_start = i > window ? i - window : 0;
+        size_t window_end = i + window < doc->count ? i + window : doc->count;
+        for (size_t j = window_start; j < window_end &&
+             job->context_count < KOLIBRI_SEMANTIC_CONTEXT_MAX; j++) {
+            if (j == i) continue;
             
-            /* Вычисляем релевантность (убывает с расстоянием) */
-            double distance = (double)abs((int)j - (int)i);
-            double relevance = 1.0 / (1.0 + distance * 0.1);
-            
-            k_semantic_context_add_word(&semantic_ctx, tokens[j], relevance);
+            /* Релевантность убывает с расстоянием */
+            double distance = (double)(j > i ? j - i : i - j);
+            job->context[job->context_count] = doc->tokens[j];
+            job->relevance[job->context_count] = 1.0 / (1.0 + distance * 0.1);
+            job->context_count++;
+        }
+        batch->tokens++;
+    }
+    return 0;
+}
+
+static void corpus_learn_job(const KolibriCorpusContext *ctx, uint64_t serial, CorpusJob *job) {
+    KolibriSemanticContext semantic_ctx;
+    k_semantic_context_init(&semantic_ctx);
+    for (size_t k = 0; k < job->context_count; k++) {
+        k_semantic_context_add_word(&semantic_ctx, job->context[k], job->relevance[k]);
+    }
+    
+    /* Seed зависит только от слова и батча, а не от потока */
+    uint64_t seed = corpus_mix64(ctx->seed ^ corpus_mix64(((uint64_t)job->hash << 32) ^ serial));
+    job->learned = k_semantic_learn_seeded(job->word, &semantic_ctx,
+                                           ctx->generations, seed, &job->result) == 0;
+    k_semantic_context_free(&semantic_ctx);
+}
+
+static void corpus_learn_worker(void *arg, size_t worker) {
+    CorpusBatch *batch = (CorpusBatch *)arg;
+    
+    /* Сначала свой диапазон, затем перехват у соседей */
+    for (size_t k = 0; k < batch->workers; k++) {
+        CorpusRange *range = &batch->ranges[(worker + k) % batch->workers];
+        for (;;) {
+            size_t i = atomic_fetch_add(&range->next, 1);
+            if (i >= range->end) break;
+            corpus_learn_job(batch->ctx, batch->serial, &batch->jobs[i]);
         }
+    }
+}
+
+static void corpus_merge_worker(void *arg, size_t worker) {
+    CorpusBatch *batch = (CorpusBatch *)arg;
+    KolibriPatternStore *store = &batch->ctx->store;
+    
+    /* Шард = хэш слова по модулю числа исполнителей; каждое слово
+     * встречается в батче один раз, поэтому шарды не пересекаются */
+    for (size_t i = 0; i < batch->job_count; i++) {
+        CorpusJob *job = &batch->jobs[i];
+        if (job->store_index < 0 || job->hash % batch->workers != worker) continue;
         
-        /* Обучаем паттерн */
-        KolibriSemanticPattern pattern;
-        if (k_semantic_learn(word, &semantic_ctx, 100, &pattern) == 0) {
-            /* Сливаем с существующим или добавляем новый */
-            k_corpus_merge_pattern(ctx, word, &pattern);
-            
-            ctx->stats.avg_fitness += pattern.context_weight;
+        KolibriSemanticPattern merged = store->patterns[job->store_index];
+        if (k_semantic_merge_patterns(&store->patterns[job->store_index],
+                                      &job->result, &merged) == 0) {
+            store->patterns[job->store_index] = merged;
+            memcpy(&store->digits[(size_t)job->store_index * KOLIBRI_SEMANTIC_PATTERN_SIZE],
+                   merged.pattern, KOLIBRI_SEMANTIC_PATTERN_SIZE);
+        }
+    }
+}
+
+static void corpus_batch_process(CorpusBatch *batch, CorpusPool *pool) {
+    KolibriCorpusContext *ctx = batch->ctx;
+    if (batch->job_count > 0) {
+        size_t workers = pool ? pool->count : 1;
+        if (workers > batch->job_count) workers = batch->job_count;
+        batch->workers = workers;
+        for (size_t w = 0; w < workers; w++) {
+            atomic_store(&batch->ranges[w].next, batch->job_count * w / workers);
+            batch->ranges[w].end = batch->job_count * (w + 1) / workers;
+        }
+        
+        double start = corpus_now();
+        if (pool && workers > 1) {
+            corpus_pool_run(pool, corpus_learn_worker, batch);
         } else {
-            ctx->stats.failed_patterns++;
+            corpus_learn_worker(batch, 0);
         }
+        double learned_at = corpus_now();
         
-        k_semantic_context_free(&semantic_ctx);
-        ctx->stats.total_tokens++;
-    }
-    
-    /* Нормализуем средний fitness */
-    if (ctx->stats.total_tokens > 0) {
-        ctx->stats.avg_fitness /= (double)ctx->stats.total_tokens;
+        /* Новые слова добавляются последовательно (в порядке батча),
+         * существующие сливаются параллельно по шардам */
+        double fitness_sum = 0.0;
+        size_t learned = 0;
+        int need_parallel_merge = 0;
+        for (size_t i = 0; i < batch->job_count; i++) {
+            CorpusJob *job = &batch->jobs[i];
+            if (!job->learned) {
+                ctx->stats.failed_patterns++;
+                continue;
+            }
+            fitness_sum += job->result.context_weight;
+            learned++;
+            int existing = corpus_lookup(&ctx->store, job->word);
+            if (existing >= 0) {
+                job->store_index = existing;
+                need_parallel_merge = 1;
+            } else {
+                k_corpus_store_pattern(ctx, job->word, &job->result);
+            }
+        }
+        if (need_parallel_merge) {
+            batch->workers = pool ? pool->count : 1;
+            if (pool && batch->workers > 1) {
+                corpus_pool_run(pool, corpus_merge_worker, batch);
+            } else {
+                corpus_merge_worker(batch, 0);
+            }
+            ctx->store.lsh_dirty = 1;
+        }
+        
+        if (learned > 0) {
+            size_t previous = ctx->stats.learn_jobs;
+            ctx->stats.avg_fitness = (ctx->stats.avg_fitness * (double)previous + fitness_sum) /
+                                     (double)(previous + learned);
+            ctx->stats.learn_jobs += learned;
+        }
+        ctx->stats.learn_time_sec += learned_at - start;
+        ctx->stats.merge_time_sec += corpus_now() - learned_at;
     }
     
-    k_corpus_free_tokens(tokens, token_count);
-    
-    ctx->stats.total_documents++;
-    ctx->stats.learning_time_sec += (double)(clock() - start) / CLOCKS_PER_SEC;
+    ctx->stats.total_tokens += batch->tokens;
+    ctx->stats.total_documents += batch->doc_count;
+    ctx->stats.batches++;
     
-    return 0;
+    for (size_t i = 0; i < batch->doc_count; i++) {
+        corpus_doc_free(batch->docs[i]);
+    }
+    batch->doc_count = 0;
+    batch->job_count = 0;
+    batch->tokens = 0;
+    batch->serial++;
+    if (batch->table) {
+        memset(batch->table, 0, batch->table_capacity * sizeof(uint32_t));
+    }
 }
 
-int k_corpus_learn_file(KolibriCorpusContext *ctx,
-                        const char *filepath) {
-    if (!ctx || !filepath) return -1;
+static void corpus_batch_free(CorpusBatch *batch) {
+    for (size_t i = 0; i < batch->doc_count; i++) {
+        corpus_doc_free(batch->docs[i]);
+    }
+    free(batch->docs);
+    free(batch->jobs);
+    free(batch->table);
+}
+
+static void corpus_batch_init(CorpusBatch *batch, KolibriCorpusContext *ctx) {
+    memset(batch, 0, sizeof(*batch));
+    batch->ctx = ctx;
+    batch->serial = ctx->stats.batches;
+}
+
+int k_corpus_learn_document(KolibriCorpusContext *ctx,
+                            const char *text,
+                            size_t text_len) {
+    if (!ctx || !text || text_len == 0) return -1;
     
-    /* Открываем файл */
-    FILE *f = fopen(filepath, "r");
-    if (!f) return -1;
+    double start = corpus_now();
     
-    /* Определяем размер файла */
-    fseek(f, 0, SEEK_END);
-    long file_size = ftell(f);
-    fseek(f, 0, SEEK_SET);
+    /* Токенизируем копию текста */
+    char *copy = (char *)malloc(text_len + 1);
+    if (!copy) return -1;
+    memcpy(copy, text, text_len);
+    CorpusDoc *doc = corpus_doc_from_buffer(copy, text_len);
+    if (!doc) return -1;
+    double tokenized = corpus_now();
+    ctx->stats.tokenize_time_sec += tokenized - start;
+    ctx->stats.bytes_read += text_len;
     
-    if (file_size <= 0 || file_size > KOLIBRI_CORPUS_MAX_TEXT_SIZE) {
-        fclose(f);
-        return -1;
+    if (ctx->verbose) {
+        printf("Tokenized %zu words\n", doc->count);
     }
     
-    /* Читаем файл */
-    char *text = (char *)malloc(file_size + 1);
-    if (!text) {
-        fclose(f);
+    CorpusBatch batch;
+    corpus_batch_init(&batch, ctx);
+    if (corpus_batch_add_doc(&batch, doc) != 0) {
+        corpus_doc_free(doc);
+        batch.doc_count = 0;
+        corpus_batch_free(&batch);
         return -1;
     }
     
-    size_t read_size = fread(text, 1, file_size, f);
-    text[read_size] = '\0';
-    fclose(f);
+    size_t threads = corpus_thread_count(ctx);
+    if (threads > batch.job_count) threads = batch.job_count;
+    ctx->stats.threads = threads > 0 ? threads : 1;
+    
+    if (threads > 1) {
+        CorpusPool pool;
+        corpus_pool_init(&pool, threads);
+        corpus_batch_process(&batch, &pool);
+        corpus_pool_destroy(&pool);
+    } else {
+        corpus_batch_process(&batch, NULL);
+    }
+    corpus_batch_free(&batch);
+    
+    ctx->stats.learning_time_sec += corpus_now() - start;
+    
+    return 0;
+}
+
+int k_corpus_learn_file(KolibriCorpusContext *ctx,
+                        const char *filepath) {
+    if (!ctx || !filepath) return -1;
+    
+    size_t size = 0;
+    char *text = corpus_read_file(filepath, &size);
+    if (!text) return -1;
     
     if (ctx->verbose) {
-        printf("Learning from file: %s (%ld bytes)\n", filepath, file_size);
+        printf("Learning from file: %s (%zu bytes)\n", filepath, size);
     }
     
     /* Обучаем на документе */
-    int result = k_corpus_learn_document(ctx, text, read_size);
+    int result = size > 0 ? k_corpus_learn_document(ctx, text, size) : -1;
     free(text);
     
     return result;
 }
 
-int k_corpus_learn_directory(KolibriCorpusContext *ctx,
-                             const char *dirpath,
-                             int recursive) {
-    if (!ctx || !dirpath) return -1;
+/* ---------- Сканер и токенизаторы ---------- */
+
+typedef struct {
+    char *path;
+    size_t seq;
+} CorpusPathItem;
+
+typedef struct {
+    CorpusDoc *doc;
+    int filled;
+} CorpusReadySlot;
+
+typedef struct {
+    const char *root;
+    int recursive;
+    
+    pthread_mutex_t lock;
+    pthread_cond_t queue_not_empty;
+    pthread_cond_t queue_not_full;
+    pthread_cond_t doc_ready;
+    pthread_cond_t window_open;
+    
+    /* Ограниченная очередь путей */
+    CorpusPathItem queue[CORPUS_QUEUE_DEPTH];
+    size_t queue_head;
+    size_t queue_count;
+    size_t next_seq;
+    int scan_done;
     
+    /* Документы в порядке обхода */
+    CorpusReadySlot ready[CORPUS_REORDER_WINDOW];
+    size_t consumed;
+    
+    double scan_time;
+    double tokenize_time;
+    size_t bytes_read;
+} CorpusPipeline;
+
+static void corpus_pipeline_push(CorpusPipeline *pl, char *path) {
+    pthread_mutex_lock(&pl->lock);
+    while (pl->queue_count == CORPUS_QUEUE_DEPTH) {
+        pthread_cond_wait(&pl->queue_not_full, &pl->lock);
+    }
+    CorpusPathItem *item = &pl->queue[(pl->queue_head + pl->queue_count) % CORPUS_QUEUE_DEPTH];
+    item->path = path;
+    item->seq = pl->next_seq++;
+    pl->queue_count++;
+    pthread_cond_signal(&pl->queue_not_empty);
+    pthread_mutex_unlock(&pl->lock);
+}
+
+typedef struct {
+    char *name;
+    unsigned char type;
+} CorpusDirEntry;
+
+static int corpus_entry_cmp(const void *a, const void *b) {
+    return strcmp(((const CorpusDirEntry *)a)->name, ((const CorpusDirEntry *)b)->name);
+}
+
+/**
+ * Обход директории в отсортированном порядке: порядок файлов, а значит
+ * и состав батчей, не зависит от файловой системы и числа потоков.
+ */
+static void corpus_scan_dir(CorpusPipeline *pl, const char *dirpath) {
+    double start = corpus_now();
     DIR *dir = opendir(dirpath);
-    if (!dir) return -1;
+    if (!dir) return;
     
-    int files_processed = 0;
+    size_t count = 0;
+    size_t capacity = 64;
+    CorpusDirEntry *entries = (CorpusDirEntry *)malloc(capacity * sizeof(CorpusDirEntry));
     struct dirent *entry;
     
-    while ((entry = readdir(dir)) != NULL) {
+    while (entries && (entry = readdir(dir)) != NULL) {
         /* Пропускаем . и .. */
         if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
             continue;
         }
-        
-        /* Строим полный путь */
+        if (count >= capacity) {
+            CorpusDirEntry *grown = (CorpusDirEntry *)realloc(
+                entries, capacity * 2 * sizeof(CorpusDirEntry));
+            if (!grown) break;
+            entries = grown;
+            capacity *= 2;
+        }
+        entries[count].name = strdup(entry->d_name);
+        if (!entries[count].name) break;
+        entries[count].type = entry->d_type;
+        count++;
+    }
+    closedir(dir);
+    
+    if (!entries) return;
+    qsort(entries, count, sizeof(CorpusDirEntry), corpus_entry_cmp);
+    pl->scan_time += corpus_now() - start;
+    
+    for (size_t i = 0; i < count; i++) {
+        start = corpus_now();
         char fullpath[1024];
-        snprintf(fullpath, sizeof(fullpath), "%s/%s", dirpath, entry->d_name);
-        
-        struct stat st;
-        if (stat(fullpath, &st) != 0) continue;
-        
-        if (S_ISDIR(st.st_mode)) {
-            /* Рекурсивно обрабатываем поддиректории */
-            if (recursive) {
-                int subdir_files = k_corpus_learn_directory(ctx, fullpath, recursive);
-                if (subdir_files > 0) {
-                    files_processed += subdir_files;
-                }
+        int written = snprintf(fullpath, sizeof(fullpath), "%s/%s", dirpath, entries[i].name);
+        unsigned char type = entries[i].type;
+        free(entries[i].name);
+        if (written <= 0 || (size_t)written >= sizeof(fullpath)) continue;
+        
+        /* d_type избавляет от stat; DT_UNKNOWN и ссылки проверяем явно */
+        int is_dir = type == DT_DIR;
+        int is_reg = type == DT_REG;
+        if (type == DT_UNKNOWN || type == DT_LNK) {
+            struct stat st;
+            if (stat(fullpath, &st) != 0) continue;
+            is_dir = S_ISDIR(st.st_mode);
+            is_reg = S_ISREG(st.st_mode);
+        }
+        pl->scan_time += corpus_now() - start;
+        
+        if (is_dir) {
+            if (pl->recursive) {
+                corpus_scan_dir(pl, fullpath);
             }
-        } else if (S_ISREG(st.st_mode)) {
-            /* Обрабатываем текстовый файл */
-            if (k_corpus_learn_file(ctx, fullpath) == 0) {
-                files_processed++;
+        } else if (is_reg) {
+            char *path = strdup(fullpath);
+            if (path) {
+                corpus_pipeline_push(pl, path);
             }
         }
     }
+    free(entries);
+}
+
+static void *corpus_scanner_main(void *arg) {
+    CorpusPipeline *pl = (CorpusPipeline *)arg;
+    corpus_scan_dir(pl, pl->root);
     
-    closedir(dir);
-    return files_processed;
+    pthread_mutex_lock(&pl->lock);
+    pl->scan_done = 1;
+    pthread_cond_broadcast(&pl->queue_not_empty);
+    pthread_cond_broadcast(&pl->doc_ready);
+    pthread_mutex_unlock(&pl->lock);
+    return NULL;
+}
+
+static void *corpus_tokenizer_main(void *arg) {
+    CorpusPipeline *pl = (CorpusPipeline *)arg;
+    
+    pthread_mutex_lock(&pl->lock);
+    for (;;) {
+        while (pl->queue_count == 0 && !pl->scan_done) {
+            pthread_cond_wait(&pl->queue_not_empty, &pl->lock);
+        }
+        if (pl->queue_count == 0) break;
+        
+        CorpusPathItem item = pl->queue[pl->queue_head];
+        pl->queue_head = (pl->queue_head + 1) % CORPUS_QUEUE_DEPTH;
+        pl->queue_count--;
+        pthread_cond_signal(&pl->queue_not_full);
+        
+        /* Не убегаем дальше окна переупорядочивания */
+        while (item.seq >= pl->consumed + CORPUS_REORDER_WINDOW) {
+            pthread_cond_wait(&pl->window_open, &pl->lock);
+        }
+        pthread_mutex_unlock(&pl->lock);
+        
+        double start = corpus_now();
+        size_t size = 0;
+        char *text = corpus_read_file(item.path, &size);
+        CorpusDoc *doc = NULL;
+        if (text && size > 0) {
+            doc = corpus_doc_from_buffer(text, size);
+        } else {
+            free(text);
+        }
+        free(item.path);
+        double elapsed = corpus_now() - start;
+        
+        pthread_mutex_lock(&pl->lock);
+        pl->tokenize_time += elapsed;
+        pl->bytes_read += doc ? size : 0;
+        CorpusReadySlot *slot = &pl->ready[item.seq % CORPUS_REORDER_WINDOW];
+        slot->doc = doc;
+        slot->filled = 1;
+        pthread_cond_broadcast(&pl->doc_ready);
+    }
+    pthread_mutex_unlock(&pl->lock);
+    return NULL;
+}
+
+int k_corpus_learn_directory(KolibriCorpusContext *ctx,
+                             const char *dirpath,
+                             int recursive) {
+    if (!ctx || !dirpath) return -1;
+    
+    DIR *probe = opendir(dirpath);
+    if (!probe) return -1;
+    closedir(probe);
+    
+    double start = corpus_now();
+    
+    CorpusPipeline *pl = (CorpusPipeline *)calloc(1, sizeof(CorpusPipeline));
+    if (!pl) return -1;
+    pl->root = dirpath;
+    pl->recursive = recursive;
+    pthread_mutex_init(&pl->lock, NULL);
+    pthread_cond_init(&pl->queue_not_empty, NULL);
+    pthread_cond_init(&pl->queue_not_full, NULL);
+    pthread_cond_init(&pl->doc_ready, NULL);
+    pthread_cond_init(&pl->window_open, NULL);
+    
+    size_t threads = corpus_thread_count(ctx);
+    size_t tokenizer_count = threads / 4 > 0 ? threads / 4 : 1;
+    pthread_t scanner;
+    pthread_t tokenizers[CORPUS_MAX_THREADS];
+    size_t tokenizers_started = 0;
+    
+    for (size_t i = 0; i < tokenizer_count; i++) {
+        if (pthread_create(&tokenizers[i], NULL, corpus_tokenizer_main, pl) == 0) {
+            tokenizers_started++;
+        }
+    }
+    int scanner_started = tokenizers_started > 0 &&
+                          pthread_create(&scanner, NULL, corpus_scanner_main, pl) == 0;
+    if (!scanner_started) {
+        pthread_mutex_lock(&pl->lock);
+        pl->scan_done = 1;
+        pthread_cond_broadcast(&pl->queue_not_empty);
+        pthread_mutex_unlock(&pl->lock);
+    }
+    
+    CorpusPool pool;
+    corpus_pool_init(&pool, threads);
+    ctx->stats.threads = pool.count;
+    
+    CorpusBatch batch;
+    corpus_batch_init(&batch, ctx);
+    
+    int files_processed = 0;
+    int failed = !scanner_started;
+    for (size_t seq = 0; !failed; seq++) {
+        pthread_mutex_lock(&pl->lock);
+        CorpusReadySlot *slot = &pl->ready[seq % CORPUS_REORDER_WINDOW];
+        while (!slot->filled && !(pl->scan_done && seq >= pl->next_seq)) {
+            pthread_cond_wait(&pl->doc_ready, &pl->lock);
+        }
+        if (!slot->filled) {
+            pthread_mutex_unlock(&pl->lock);
+            break;
+        }
+        CorpusDoc *doc = slot->doc;
+        slot->doc = NULL;
+        slot->filled = 0;
+        pl->consumed++;
+        pthread_cond_broadcast(&pl->window_open);
+        pthread_mutex_unlock(&pl->lock);
+        
+        /* Нечитаемые и слишком большие файлы пропускаются */
+        if (!doc) continue;
+        files_processed++;
+        
+        if (corpus_batch_add_doc(&batch, doc) != 0) {
+            corpus_doc_free(doc);
+            failed = 1;
+            break;
+        }
+        if (batch.tokens >= ctx->batch_size) {
+            corpus_batch_process(&batch, &pool);
+        }
+    }
+    if (!failed && batch.doc_count > 0) {
+        corpus_batch_process(&batch, &pool);
+    }
+    
+    /* При ошибке дренируем очередь, чтобы потоки завершились */
+    pthread_mutex_lock(&pl->lock);
+    while (failed && scanner_started && !(pl->scan_done && pl->consumed >= pl->next_seq)) {
+        CorpusReadySlot *slot = &pl->ready[pl->consumed % CORPUS_REORDER_WINDOW];
+        if (slot->filled) {
+            corpus_doc_free(slot->doc);
+            slot->doc = NULL;
+            slot->filled = 0;
+            pl->consumed++;
+            pthread_cond_broadcast(&pl->window_open);
+        } else {
+            pthread_cond_wait(&pl->doc_ready, &pl->lock);
+        }
+    }
+    pthread_mutex_unlock(&pl->lock);
+    
+    if (scanner_started) {
+        pthread_join(scanner, NULL);
+    }
+    for (size_t i = 0; i < tokenizers_started; i++) {
+        pthread_join(tokenizers[i], NULL);
+    }
+    corpus_pool_destroy(&pool);
+    corpus_batch_free(&batch);
+    
+    ctx->stats.files_scanned += pl->next_seq;
+    ctx->stats.bytes_read += pl->bytes_read;
+    ctx->stats.scan_time_sec += pl->scan_time;
+    ctx->stats.tokenize_time_sec += pl->tokenize_time;
+    ctx->stats.learning_time_sec += corpus_now() - start;
+    
+    pthread_cond_destroy(&pl->window_open);
+    pthread_cond_destroy(&pl->doc_ready);
+    pthread_cond_destroy(&pl->queue_not_full);
+    pthread_cond_destroy(&pl->queue_not_empty);
+    pthread_mutex_destroy(&pl->lock);
+    free(pl);
+    
+    if (ctx->verbose) {
+        printf("Learned %d files from %s\n", files_processed, dirpath);
+    }
+    
+    return failed ? -1 : files_processed;
 }
 
 int k_corpus_save_patterns(const KolibriCorpusContext *ctx,
@@ -483,5 +1423,22 @@ void k_corpus_print_stats(const KolibriCorpusStats *stats) {
         printf("  Processing speed:     %.0f tokens/sec\n", tokens_per_sec);
     }
     
+    if (stats->batches > 0) {
+        printf("\n  Pipeline (%zu threads, %zu batches, %zu learn jobs):\n",
+               stats->threads, stats->batches, stats->learn_jobs);
+        printf("  Scan:                 %zu files in %.3f sec\n",
+               stats->files_scanned, stats->scan_time_sec);
+        if (stats->tokenize_time_sec > 0) {
+            printf("  Tokenize:             %.1f MB/s (%zu bytes)\n",
+                   (double)stats->bytes_read / 1e6 / stats->tokenize_time_sec,
+                   stats->bytes_read);
+        }
+        if (stats->learn_time_sec > 0) {
+            printf("  Learn:                %.0f words/sec\n",
+                   (double)stats->learn_jobs / stats->learn_time_sec);
+        }
+        printf("  Merge:                %.3f sec\n", stats->merge_time_sec);
+    }
+    
     printf("\n");
 }
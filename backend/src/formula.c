@@ -21,14 +21,14 @@
 
 /* ---------------------------- Утилиты ----------------------------- */
 
-static uint8_t random_digit(KolibriFormulaPool *pool) {
-    return (uint8_t)(k_rng_next(&pool->rng) % 10ULL);
+static uint8_t random_digit(KolibriRng *rng) {
+    return (uint8_t)(k_rng_next(rng) % 10ULL);
 }
 
-static void gene_randomize(KolibriFormulaPool *pool, KolibriGene *gene) {
+static void gene_randomize(KolibriRng *rng, KolibriGene *gene) {
     gene->length = sizeof(gene->digits);
     for (size_t i = 0; i < gene->length; ++i) {
-        gene->digits[i] = random_digit(pool);
+        gene->digits[i] = random_digit(rng);
     }
 }
 
@@ -63,78 +63,6 @@ static int kolibri_hash_to_int(uint32_t hash) {
     return (int)hash;
 }
 
-static int utf8_is_continuation(unsigned char byte) {
-    return (byte & 0xC0U) == 0x80U;
-}
-
-static size_t kolibri_utf8_decode_next(const unsigned char *text,
-                                       size_t length,
-                                       size_t offset,
-                                       uint32_t *out_codepoint) {
-    if (!text || !out_codepoint || offset >= length) {
-        return 0U;
-    }
-    unsigned char lead = text[offset];
-    if (lead < 0x80U) {
-        *out_codepoint = (uint32_t)lead;
-        return 1U;
-    }
-    if ((lead & 0xE0U) == 0xC0U) {
-        if (offset + 1U >= length) {
-            return 0U;
-        }
-        unsigned char b1 = text[offset + 1U];
-        if (!utf8_is_continuation(b1)) {
-            return 0U;
-        }
-        uint32_t codepoint = ((uint32_t)(lead & 0x1FU) << 6) | (uint32_t)(b1 & 0x3FU);
-        if (codepoint < 0x80U) {
-            return 0U;
-        }
-        *out_codepoint = codepoint;
-        return 2U;
-    }
-    if ((lead & 0xF0U) == 0xE0U) {
-        if (offset + 2U >= length) {
-            return 0U;
-        }
-        unsigned char b1 = text[offset + 1U];
-        unsigned char b2 = text[offset + 2U];
-        if (!utf8_is_continuation(b1) || !utf8_is_continuation(b2)) {
-            return 0U;
-        }
-        uint32_t codepoint = ((uint32_t)(lead & 0x0FU) << 12) |
-                             ((uint32_t)(b1 & 0x3FU) << 6) |
-                             (uint32_t)(b2 & 0x3FU);
-        if (codepoint < 0x800U || (codepoint >= 0xD800U && codepoint <= 0xDFFFU)) {
-            return 0U;
-        }
-        *out_codepoint = codepoint;
-        return 3U;
-    }
-    if ((lead & 0xF8U) == 0xF0U) {
-        if (offset + 3U >= length) {
-            return 0U;
-        }
-        unsigned char b1 = text[offset + 1U];
-        unsigned char b2 = text[offset + 2U];
-        unsigned char b3 = text[offset + 3U];
-        if (!utf8_is_continuation(b1) || !utf8_is_continuation(b2) || !utf8_is_continuation(b3)) {
-            return 0U;
-        }
-        uint32_t codepoint = ((uint32_t)(lead & 0x07U) << 18) |
-                             ((uint32_t)(b1 & 0x3FU) << 12) |
-                             ((uint32_t)(b2 & 0x3FU) << 6) |
-                             (uint32_t)(b3 & 0x3FU);
-        if (codepoint < 0x10000U || codepoint > 0x10FFFFU) {
-            return 0U;
-        }
-        *out_codepoint = codepoint;
-        return 4U;
-    }
-    return 0U;
-}
-
 int kf_hash_from_text(const char *text) {
     return kolibri_hash_to_int(fnv1a32(text));
 }
@@ -153,14 +81,16 @@ static void association_reset(KolibriAssociation *assoc) {
     assoc->source[0] = '\0';
 }
 
-static void association_set(KolibriAssociation *assoc,
-                            KolibriSymbolTable *symbols,
-                            const char *question,
-                            const char *answer,
-                            const char *source,
-                            uint64_t timestamp) {
+/* -1, если текст не удалось закодировать или записать новые символы
+ * в геном: такая ассоциация не сохраняется */
+static int association_set(KolibriAssociation *assoc,
+                           KolibriSymbolTable *symbols,
+                           const char *question,
+                           const char *answer,
+                           const char *source,
+                           uint64_t timestamp) {
     if (!assoc) {
-        return;
+        return -1;
     }
     association_reset(assoc);
     if (question) {
@@ -176,41 +106,25 @@ static void association_set(KolibriAssociation *assoc,
     assoc->input_hash = kolibri_hash_to_int(fnv1a32(assoc->question));
     assoc->output_hash = kolibri_hash_to_int(fnv1a32(assoc->answer));
     if (symbols) {
-        const unsigned char *qbytes = (const unsigned char *)assoc->question;
-        size_t qlen = strlen(assoc->question);
-        size_t qpos = 0U;
-        while (qpos < qlen && assoc->question_digits_length + KOLIBRI_SYMBOL_DIGITS <= KOLIBRI_ASSOC_DIGITS_MAX) {
-            uint32_t codepoint = 0U;
-            size_t consumed = kolibri_utf8_decode_next(qbytes, qlen, qpos, &codepoint);
-            if (consumed == 0U) {
-                codepoint = (uint32_t)qbytes[qpos];
-                consumed = 1U;
-            }
-            uint8_t digits[KOLIBRI_SYMBOL_DIGITS];
-            if (kolibri_symbol_encode(symbols, codepoint, digits) == 0) {
-                memcpy(&assoc->question_digits[assoc->question_digits_length], digits, KOLIBRI_SYMBOL_DIGITS);
-                assoc->question_digits_length += KOLIBRI_SYMBOL_DIGITS;
-            }
-            qpos += consumed;
+        if (kolibri_symbol_encode_utf8(symbols,
+                                       assoc->question,
+                                       strlen(assoc->question),
+                                       assoc->question_digits,
+                                       KOLIBRI_ASSOC_DIGITS_MAX,
+                                       &assoc->question_digits_length) != 0 ||
+            kolibri_symbol_encode_utf8(symbols,
+                                       assoc->answer,
+                                       strlen(assoc->answer),
+                                       assoc->answer_digits,
+                                       KOLIBRI_ASSOC_DIGITS_MAX,
+                                       &assoc->answer_digits_length) != 0) {
+            return -1;
         }
-        const unsigned char *abytes = (const unsigned char *)assoc->answer;
-        size_t alen = strlen(assoc->answer);
-        size_t apos = 0U;
-        while (apos < alen && assoc->answer_digits_length + KOLIBRI_SYMBOL_DIGITS <= KOLIBRI_ASSOC_DIGITS_MAX) {
-            uint32_t codepoint = 0U;
-            size_t consumed = kolibri_utf8_decode_next(abytes, alen, apos, &codepoint);
-            if (consumed == 0U) {
-                codepoint = (uint32_t)abytes[apos];
-                consumed = 1U;
-            }
-            uint8_t digits[KOLIBRI_SYMBOL_DIGITS];
-            if (kolibri_symbol_encode(symbols, codepoint, digits) == 0) {
-                memcpy(&assoc->answer_digits[assoc->answer_digits_length], digits, KOLIBRI_SYMBOL_DIGITS);
-                assoc->answer_digits_length += KOLIBRI_SYMBOL_DIGITS;
-            }
-            apos += consumed;
+        if (kolibri_symbol_table_flush(symbols) != 0) {
+            return -1;
         }
     }
+    return 0;
 }
 
 static int association_equals(const KolibriAssociation *a, const KolibriAssociation *b) {
@@ -273,18 +187,18 @@ static int decode_bias(const KolibriGene *gene, size_t offset, int *bias) {
     return 0;
 }
 
-static int formula_predict_numeric(const KolibriFormula *formula, int input, int *output) {
-    if (!formula || !output) {
+static int gene_predict_numeric(const KolibriGene *gene, int input, int *output) {
+    if (!gene || !output) {
         return -1;
     }
     int operation = 0;
     int slope = 0;
     int bias = 0;
     int auxiliary = 0;
-    if (decode_operation(&formula->gene, 0, &operation) != 0 ||
-        decode_signed(&formula->gene, 1, &slope) != 0 ||
-        decode_bias(&formula->gene, 4, &bias) != 0 ||
-        decode_signed(&formula->gene, 7, &auxiliary) != 0) {
+    if (decode_operation(gene, 0, &operation) != 0 ||
+        decode_signed(gene, 1, &slope) != 0 ||
+        decode_bias(gene, 4, &bias) != 0 ||
+        decode_signed(gene, 7, &auxiliary) != 0) {
         return -1;
     }
     long long result = 0;
@@ -329,29 +243,37 @@ static double complexity_penalty(const KolibriGene *gene) {
     return penalty;
 }
 
-static double evaluate_formula_numeric(const KolibriFormula *formula, const KolibriFormulaPool *pool) {
-    if (!formula || !pool || pool->examples == 0) {
+static double evaluate_gene_numeric(const KolibriGene *gene, const int *inputs,
+                                    const int *targets, size_t examples) {
+    if (!gene || examples == 0) {
         return 0.0;
     }
     double total_error = 0.0;
-    for (size_t i = 0; i < pool->examples; ++i) {
+    for (size_t i = 0; i < examples; ++i) {
         int prediction = 0;
-        if (formula_predict_numeric(formula, pool->inputs[i], &prediction) != 0) {
+        if (gene_predict_numeric(gene, inputs[i], &prediction) != 0) {
             return 0.0;
         }
-        int diff = pool->targets[i] - prediction;
+        int diff = targets[i] - prediction;
         total_error += fabs((double)diff);
     }
-    double penalty = complexity_penalty(&formula->gene);
+    double penalty = complexity_penalty(gene);
     double fitness = 1.0 / (1.0 + total_error + penalty);
     return fitness;
 }
 
-static void apply_feedback_bonus(KolibriFormula *formula, double *fitness) {
-    if (!formula || !fitness) {
+static double evaluate_formula_numeric(const KolibriFormula *formula, const KolibriFormulaPool *pool) {
+    if (!formula || !pool) {
+        return 0.0;
+    }
+    return evaluate_gene_numeric(&formula->gene, pool->inputs, pool->targets, pool->examples);
+}
+
+static void apply_feedback_bonus(double feedback, double *fitness) {
+    if (!fitness) {
         return;
     }
-    double adjusted = *fitness + formula->feedback;
+    double adjusted = *fitness + feedback;
     if (adjusted < 0.0) {
         adjusted = 0.0;
     }
@@ -361,17 +283,16 @@ static void apply_feedback_bonus(KolibriFormula *formula, double *fitness) {
     *fitness = adjusted;
 }
 
-static void mutate_gene(KolibriFormulaPool *pool, KolibriGene *gene) {
+static void mutate_gene(KolibriRng *rng, KolibriGene *gene) {
     if (!gene) {
         return;
     }
-    size_t index = (size_t)(k_rng_next(&pool->rng) % gene->length);
-    uint8_t delta = random_digit(pool);
+    size_t index = (size_t)(k_rng_next(rng) % gene->length);
+    uint8_t delta = random_digit(rng);
     gene->digits[index] = delta;
 }
 
-static void crossover(KolibriFormulaPool *pool, const KolibriGene *parent_a, const KolibriGene *parent_b, KolibriGene *child) {
-    (void)pool;
+static void crossover(const KolibriGene *parent_a, const KolibriGene *parent_b, KolibriGene *child) {
     if (!parent_a || !parent_b || !child) {
         return;
     }
@@ -407,9 +328,9 @@ static void reproduce(KolibriFormulaPool *pool) {
         size_t parent_a_index = i % elite;
         size_t parent_b_index = (i + 1) % elite;
         KolibriGene child;
-        crossover(pool, &pool->formulas[parent_a_index].gene,
+        crossover(&pool->formulas[parent_a_index].gene,
                   &pool->formulas[parent_b_index].gene, &child);
-        mutate_gene(pool, &child);
+        mutate_gene(&pool->rng, &child);
         gene_copy(&child, &pool->formulas[i].gene);
         pool->formulas[i].fitness = 0.0;
         pool->formulas[i].feedback = 0.0;
@@ -449,7 +370,7 @@ void kf_pool_init(KolibriFormulaPool *pool, uint64_t seed) {
     pool->association_count = 0;
     k_rng_seed(&pool->rng, seed);
     for (size_t i = 0; i < pool->count; ++i) {
-        gene_randomize(pool, &pool->formulas[i].gene);
+        gene_randomize(&pool->rng, &pool->formulas[i].gene);
         pool->formulas[i].fitness = 0.0;
         pool->formulas[i].feedback = 0.0;
         pool->formulas[i].association_count = 0;
@@ -493,14 +414,17 @@ int kf_pool_add_association(KolibriFormulaPool *pool,
         return -1;
     }
     KolibriAssociation assoc;
-    association_set(&assoc, symbols, question, answer, source, timestamp);
+    if (association_set(&assoc, symbols, question, answer, source, timestamp) != 0) {
+        return -1;
+    }
 
     /* Обновляем существующую запись, если такой вопрос уже был */
     for (size_t i = 0; i < pool->association_count; ++i) {
         if (pool->associations[i].input_hash == assoc.input_hash &&
             strcmp(pool->associations[i].question, assoc.question) == 0) {
             pool->associations[i] = assoc;
-            return kf_pool_add_example(pool, assoc.input_hash, assoc.output_hash);
+            (void)kf_pool_add_example(pool, assoc.input_hash, assoc.output_hash);
+            return 0;
         }
     }
 
@@ -509,11 +433,13 @@ int kf_pool_add_association(KolibriFormulaPool *pool,
         memmove(&pool->associations[0], &pool->associations[1],
                 (KOLIBRI_POOL_MAX_ASSOCIATIONS - 1U) * sizeof(KolibriAssociation));
         pool->associations[KOLIBRI_POOL_MAX_ASSOCIATIONS - 1U] = assoc;
-        return kf_pool_add_example(pool, assoc.input_hash, assoc.output_hash);
+        (void)kf_pool_add_example(pool, assoc.input_hash, assoc.output_hash);
+        return 0;
     }
 
     pool->associations[pool->association_count++] = assoc;
-    return kf_pool_add_example(pool, assoc.input_hash, assoc.output_hash);
+    (void)kf_pool_add_example(pool, assoc.input_hash, assoc.output_hash);
+    return 0;
 }
 
 void kf_pool_tick(KolibriFormulaPool *pool, size_t generations) {
@@ -528,7 +454,7 @@ void kf_pool_tick(KolibriFormulaPool *pool, size_t generations) {
     for (size_t g = 0; g < generations; ++g) {
         for (size_t i = 0; i < pool->count; ++i) {
             double fitness = evaluate_formula_numeric(&pool->formulas[i], pool);
-            apply_feedback_bonus(&pool->formulas[i], &fitness);
+            apply_feedback_bonus(pool->formulas[i].feedback, &fitness);
             pool->formulas[i].fitness = fitness;
         }
         qsort(pool->formulas, pool->count, sizeof(KolibriFormula), compare_formulas);
@@ -547,6 +473,439 @@ void kf_pool_tick(KolibriFormulaPool *pool, size_t generations) {
     }
 }
 
+/* --------------------- Компактный пул генов ----------------------- */
+
+static int compare_gene_slots(const void *lhs, const void *rhs) {
+    const KolibriGeneSlot *a = (const KolibriGeneSlot *)lhs;
+    const KolibriGeneSlot *b = (const KolibriGeneSlot *)rhs;
+    if (a->fitness < b->fitness) {
+        return 1;
+    }
+    if (a->fitness > b->fitness) {
+        return -1;
+    }
+    return 0;
+}
+
+static void reproduce_genes(KolibriGenePool *pool) {
+    size_t elite = pool->count / 3U;
+    if (elite == 0) {
+        elite = 1;
+    }
+    for (size_t i = elite; i < pool->count; ++i) {
+        KolibriGene child;
+        crossover(&pool->slots[i % elite].gene, &pool->slots[(i + 1) % elite].gene, &child);
+        mutate_gene(&pool->rng, &child);
+        gene_copy(&child, &pool->slots[i].gene);
+        pool->slots[i].fitness = 0.0;
+        pool->slots[i].feedback = 0.0;
+    }
+}
+
+void kf_gene_pool_init(KolibriGenePool *pool, uint64_t seed) {
+    if (!pool) {
+        return;
+    }
+    pool->count = sizeof(pool->slots) / sizeof(pool->slots[0]);
+    pool->examples = 0;
+    k_rng_seed(&pool->rng, seed);
+    for (size_t i = 0; i < pool->count; ++i) {
+        gene_randomize(&pool->rng, &pool->slots[i].gene);
+        pool->slots[i].fitness = 0.0;
+        pool->slots[i].feedback = 0.0;
+    }
+}
+
+int kf_gene_pool_add_example(KolibriGenePool *pool, int input, int target) {
+    if (!pool) {
+        return -1;
+    }
+    if (pool->examples >= sizeof(pool->inputs) / sizeof(pool->inputs[0])) {
+        return -1;
+    }
+    pool->inputs[pool->examples] = input;
+    pool->targets[pool->examples] = target;
+    pool->examples++;
+    return 0;
+}
+
+void kf_gene_pool_tick(KolibriGenePool *pool, size_t generations) {
+    if (!pool || pool->count == 0) {
+        return;
+    }
+    if (generations == 0) {
+        generations = 1;
+    }
+    for (size_t g = 0; g < generations; ++g) {
+        for (size_t i = 0; i < pool->count; ++i) {
+            KolibriGeneSlot *slot = &pool->slots[i];
+            double fitness = evaluate_gene_numeric(&slot->gene, pool->inputs,
+                                                   pool->targets, pool->examples);
+            apply_feedback_bonus(slot->feedback, &fitness);
+            slot->fitness = fitness;
+        }
+        qsort(pool->slots, pool->count, sizeof(KolibriGeneSlot), compare_gene_slots);
+        reproduce_genes(pool);
+    }
+}
+
+const KolibriGeneSlot *kf_gene_pool_best(const KolibriGenePool *pool) {
+    if (!pool || pool->count == 0) {
+        return NULL;
+    }
+    return &pool->slots[0];
+}
+
+/* ------------------- Оверлей запроса над пулом -------------------- */
+
+#define KOLIBRI_OVERLAY_EXAMPLES (sizeof(((KolibriFormulaPool *)0)->inputs) / sizeof(int))
+
+void kf_overlay_init(KolibriPoolOverlay *overlay, const KolibriFormulaPool *base) {
+    if (!overlay) {
+        return;
+    }
+    memset(overlay, 0, sizeof(*overlay));
+    overlay->base = base;
+}
+
+static void overlay_drop_snapshots(KolibriPoolOverlay *overlay) {
+    for (size_t i = 0; i < overlay->snapshot_count; ++i) {
+        free(overlay->snapshots[i]);
+    }
+    overlay->snapshot_count = 0;
+    overlay->snapshot_current = 0;
+}
+
+void kf_overlay_reset(KolibriPoolOverlay *overlay) {
+    if (!overlay) {
+        return;
+    }
+    overlay->fresh_count = 0;
+    overlay->replaced_count = 0;
+    overlay->examples = 0;
+    overlay->formula_count = 0;
+    overlay_drop_snapshots(overlay);
+}
+
+void kf_overlay_free(KolibriPoolOverlay *overlay) {
+    if (!overlay) {
+        return;
+    }
+    overlay_drop_snapshots(overlay);
+    free(overlay->snapshots);
+    free(overlay->fresh);
+    free(overlay->replaced);
+    free(overlay->replaced_index);
+    free(overlay->replaced_order);
+    kf_overlay_init(overlay, NULL);
+}
+
+/* Первая видимая ассоциация base: при переполнении пул вытесняет самые
+ * старые, оверлей просто перестаёт их показывать */
+static size_t overlay_first(const KolibriPoolOverlay *overlay) {
+    size_t total = overlay->base->association_count + overlay->fresh_count;
+    return total > KOLIBRI_POOL_MAX_ASSOCIATIONS ? total - KOLIBRI_POOL_MAX_ASSOCIATIONS : 0;
+}
+
+/* Запись replaced для ассоциации base с номером index или -1 */
+static long overlay_find_replaced(const KolibriPoolOverlay *overlay, size_t index) {
+    size_t lo = 0;
+    size_t hi = overlay->replaced_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2U;
+        size_t slot = overlay->replaced_order[mid];
+        if (overlay->replaced_index[slot] < index) {
+            lo = mid + 1U;
+        } else if (overlay->replaced_index[slot] > index) {
+            hi = mid;
+        } else {
+            return (long)slot;
+        }
+    }
+    return -1;
+}
+
+static int overlay_grow(void **data, size_t item, size_t count, size_t *capacity) {
+    if (count < *capacity) {
+        return 0;
+    }
+    size_t next = *capacity ? *capacity * 2U : 16U;
+    void *grown = realloc(*data, next * item);
+    if (!grown) {
+        return -1;
+    }
+    *data = grown;
+    return 0;
+}
+
+static int overlay_reserve_replaced(KolibriPoolOverlay *overlay) {
+    size_t capacity = overlay->replaced_capacity;
+    size_t count = overlay->replaced_count;
+    if (overlay_grow((void **)&overlay->replaced, sizeof(KolibriAssociation), count, &capacity) != 0 ||
+        overlay_grow((void **)&overlay->replaced_index, sizeof(size_t), count, &capacity) != 0 ||
+        overlay_grow((void **)&overlay->replaced_order, sizeof(size_t), count, &capacity) != 0) {
+        return -1;
+    }
+    if (count >= capacity) {
+        overlay->replaced_capacity = capacity ? capacity * 2U : 16U;
+    }
+    return 0;
+}
+
+static int overlay_add_replaced(KolibriPoolOverlay *overlay, size_t index,
+                                const KolibriAssociation *assoc) {
+    if (overlay_reserve_replaced(overlay) != 0) {
+        return -1;
+    }
+    size_t slot = overlay->replaced_count++;
+    overlay->replaced[slot] = *assoc;
+    overlay->replaced_index[slot] = index;
+    size_t pos = slot;
+    while (pos > 0 && overlay->replaced_index[overlay->replaced_order[pos - 1U]] > index) {
+        overlay->replaced_order[pos] = overlay->replaced_order[pos - 1U];
+        pos--;
+    }
+    overlay->replaced_order[pos] = slot;
+    return 0;
+}
+
+static int overlay_add_fresh(KolibriPoolOverlay *overlay, const KolibriAssociation *assoc) {
+    if (overlay->fresh_count >= KOLIBRI_POOL_MAX_ASSOCIATIONS) {
+        /* base уже не виден целиком: вытесняется самая старая новая запись */
+        memmove(&overlay->fresh[0], &overlay->fresh[1],
+                (KOLIBRI_POOL_MAX_ASSOCIATIONS - 1U) * sizeof(KolibriAssociation));
+        overlay->fresh[KOLIBRI_POOL_MAX_ASSOCIATIONS - 1U] = *assoc;
+        return 0;
+    }
+    if (overlay_grow((void **)&overlay->fresh, sizeof(KolibriAssociation),
+                     overlay->fresh_count, &overlay->fresh_capacity) != 0) {
+        return -1;
+    }
+    if (overlay->fresh_count >= overlay->fresh_capacity) {
+        overlay->fresh_capacity = overlay->fresh_capacity ? overlay->fresh_capacity * 2U : 16U;
+    }
+    overlay->fresh[overlay->fresh_count++] = *assoc;
+    return 0;
+}
+
+static int overlay_store(KolibriPoolOverlay *overlay, const KolibriAssociation *assoc) {
+    for (size_t i = 0; i < overlay->fresh_count; ++i) {
+        if (association_equals(&overlay->fresh[i], assoc)) {
+            overlay->fresh[i] = *assoc;
+            return 0;
+        }
+    }
+    size_t first = overlay_first(overlay);
+    for (size_t i = 0; i < overlay->replaced_count; ++i) {
+        if (overlay->replaced_index[i] >= first && association_equals(&overlay->replaced[i], assoc)) {
+            overlay->replaced[i] = *assoc;
+            return 0;
+        }
+    }
+    const KolibriFormulaPool *base = overlay->base;
+    for (size_t i = first; i < base->association_count; ++i) {
+        if (association_equals(&base->associations[i], assoc)) {
+            return overlay_add_replaced(overlay, i, assoc);
+        }
+    }
+    return overlay_add_fresh(overlay, assoc);
+}
+
+int kf_overlay_add_association(KolibriPoolOverlay *overlay,
+                               KolibriSymbolTable *symbols,
+                               const char *question,
+                               const char *answer,
+                               const char *source,
+                               uint64_t timestamp) {
+    if (!overlay || !overlay->base || !question || !answer) {
+        return -1;
+    }
+    KolibriAssociation assoc;
+    if (association_set(&assoc, symbols, question, answer, source, timestamp) != 0) {
+        return -1;
+    }
+    if (overlay_store(overlay, &assoc) != 0) {
+        return -1;
+    }
+    overlay->snapshot_current = 0;
+    if (overlay->base->examples + overlay->examples < KOLIBRI_OVERLAY_EXAMPLES) {
+        overlay->inputs[overlay->examples] = assoc.input_hash;
+        overlay->targets[overlay->examples] = assoc.output_hash;
+        overlay->examples++;
+    }
+    return 0;
+}
+
+size_t kf_overlay_association_count(const KolibriPoolOverlay *overlay) {
+    if (!overlay || !overlay->base) {
+        return 0;
+    }
+    return overlay->base->association_count + overlay->fresh_count - overlay_first(overlay);
+}
+
+const KolibriAssociation *kf_overlay_association(const KolibriPoolOverlay *overlay, size_t index) {
+    if (!overlay || !overlay->base) {
+        return NULL;
+    }
+    size_t base_count = overlay->base->association_count;
+    size_t position = overlay_first(overlay) + index;
+    if (position < base_count) {
+        long slot = overlay_find_replaced(overlay, position);
+        return slot >= 0 ? &overlay->replaced[slot] : &overlay->base->associations[position];
+    }
+    position -= base_count;
+    return position < overlay->fresh_count ? &overlay->fresh[position] : NULL;
+}
+
+/* Набор, который kf_pool_tick копирует лучшим формулам: первые
+ * ассоциации пула. Без изменений в этой части - ссылка на base */
+static const KolibriAssociation *overlay_dataset(KolibriPoolOverlay *overlay, size_t *count) {
+    size_t total = kf_overlay_association_count(overlay);
+    size_t limit = total < KOLIBRI_FORMULA_MAX_ASSOCIATIONS ? total : KOLIBRI_FORMULA_MAX_ASSOCIATIONS;
+    *count = limit;
+    const KolibriFormulaPool *base = overlay->base;
+    if (overlay_first(overlay) == 0 && base->association_count >= limit &&
+        (overlay->replaced_count == 0 ||
+         overlay->replaced_index[overlay->replaced_order[0]] >= limit)) {
+        return base->associations;
+    }
+    if (overlay->snapshot_current && overlay->snapshot_count > 0) {
+        return overlay->snapshots[overlay->snapshot_count - 1U];
+    }
+    if (overlay->snapshot_count >= overlay->snapshot_capacity) {
+        size_t next = overlay->snapshot_capacity ? overlay->snapshot_capacity * 2U : 4U;
+        KolibriAssociation **grown =
+            (KolibriAssociation **)realloc(overlay->snapshots, next * sizeof(KolibriAssociation *));
+        if (!grown) {
+            return NULL;
+        }
+        overlay->snapshots = grown;
+        overlay->snapshot_capacity = next;
+    }
+    /* Снимок живёт до сброса: на него могут ссылаться формулы прошлых тиков */
+    KolibriAssociation *snapshot = (KolibriAssociation *)malloc(limit * sizeof(KolibriAssociation));
+    if (!snapshot) {
+        return NULL;
+    }
+    for (size_t i = 0; i < limit; ++i) {
+        snapshot[i] = *kf_overlay_association(overlay, i);
+    }
+    overlay->snapshots[overlay->snapshot_count++] = snapshot;
+    overlay->snapshot_current = 1;
+    return snapshot;
+}
+
+static int compare_formula_views(const void *lhs, const void *rhs) {
+    const KolibriFormulaView *a = (const KolibriFormulaView *)lhs;
+    const KolibriFormulaView *b = (const KolibriFormulaView *)rhs;
+    if (a->fitness < b->fitness) {
+        return 1;
+    }
+    if (a->fitness > b->fitness) {
+        return -1;
+    }
+    return 0;
+}
+
+static void reproduce_views(KolibriPoolOverlay *overlay) {
+    size_t elite = overlay->formula_count / 3U;
+    if (elite == 0) {
+        elite = 1;
+    }
+    for (size_t i = elite; i < overlay->formula_count; ++i) {
+        KolibriGene child;
+        crossover(&overlay->formulas[i % elite].gene,
+                  &overlay->formulas[(i + 1) % elite].gene, &child);
+        mutate_gene(&overlay->rng, &child);
+        gene_copy(&child, &overlay->formulas[i].gene);
+        overlay->formulas[i].fitness = 0.0;
+        overlay->formulas[i].feedback = 0.0;
+        overlay->formulas[i].associations = NULL;
+        overlay->formulas[i].association_count = 0;
+    }
+}
+
+int kf_overlay_tick(KolibriPoolOverlay *overlay, size_t generations) {
+    if (!overlay || !overlay->base) {
+        return -1;
+    }
+    const KolibriFormulaPool *base = overlay->base;
+    if (base->count == 0) {
+        return 0;
+    }
+    size_t dataset_count = 0;
+    const KolibriAssociation *dataset = NULL;
+    if (kf_overlay_association_count(overlay) > 0) {
+        dataset = overlay_dataset(overlay, &dataset_count);
+        if (!dataset) {
+            return -1;
+        }
+    }
+    if (overlay->formula_count == 0) {
+        for (size_t i = 0; i < base->count; ++i) {
+            kf_formula_view_init(&overlay->formulas[i], &base->formulas[i]);
+        }
+        overlay->formula_count = base->count;
+        overlay->rng = base->rng;
+    }
+
+    int inputs[KOLIBRI_OVERLAY_EXAMPLES];
+    int targets[KOLIBRI_OVERLAY_EXAMPLES];
+    size_t examples = base->examples;
+    memcpy(inputs, base->inputs, examples * sizeof(int));
+    memcpy(targets, base->targets, examples * sizeof(int));
+    memcpy(inputs + examples, overlay->inputs, overlay->examples * sizeof(int));
+    memcpy(targets + examples, overlay->targets, overlay->examples * sizeof(int));
+    examples += overlay->examples;
+
+    if (generations == 0) {
+        generations = 1;
+    }
+    for (size_t g = 0; g < generations; ++g) {
+        for (size_t i = 0; i < overlay->formula_count; ++i) {
+            KolibriFormulaView *view = &overlay->formulas[i];
+            double fitness = evaluate_gene_numeric(&view->gene, inputs, targets, examples);
+            apply_feedback_bonus(view->feedback, &fitness);
+            view->fitness = fitness;
+        }
+        qsort(overlay->formulas, overlay->formula_count, sizeof(KolibriFormulaView),
+              compare_formula_views);
+        reproduce_views(overlay);
+    }
+
+    /* Лучшие формулы получают ассоциации - по ссылке */
+    if (dataset) {
+        size_t limit = overlay->formula_count < 3 ? overlay->formula_count : 3;
+        for (size_t i = 0; i < limit; ++i) {
+            overlay->formulas[i].associations = dataset;
+            overlay->formulas[i].association_count = dataset_count;
+            overlay->formulas[i].fitness = 1.0;
+        }
+        qsort(overlay->formulas, overlay->formula_count, sizeof(KolibriFormulaView),
+              compare_formula_views);
+    }
+    return 0;
+}
+
+size_t kf_overlay_formula_count(const KolibriPoolOverlay *overlay) {
+    if (!overlay || !overlay->base) {
+        return 0;
+    }
+    return overlay->formula_count ? overlay->formula_count : overlay->base->count;
+}
+
+int kf_overlay_formula(const KolibriPoolOverlay *overlay, size_t index, KolibriFormulaView *view) {
+    if (!view || index >= kf_overlay_formula_count(overlay)) {
+        return -1;
+    }
+    if (overlay->formula_count) {
+        *view = overlay->formulas[index];
+    } else {
+        kf_formula_view_init(view, &overlay->base->formulas[index]);
+    }
+    return 0;
+}
+
 const KolibriFormula *kf_pool_best(const KolibriFormulaPool *pool) {
     if (!pool || pool->count == 0) {
         return NULL;
@@ -554,14 +913,25 @@ const KolibriFormula *kf_pool_best(const KolibriFormulaPool *pool) {
     return &pool->formulas[0];
 }
 
-int kf_formula_lookup_answer(const KolibriFormula *formula, int input,
-                             char *buffer, size_t buffer_len) {
-    if (!formula || !buffer || buffer_len == 0) {
+void kf_formula_view_init(KolibriFormulaView *view, const KolibriFormula *formula) {
+    if (!view || !formula) {
+        return;
+    }
+    view->gene = formula->gene;
+    view->fitness = formula->fitness;
+    view->feedback = formula->feedback;
+    view->associations = formula->associations;
+    view->association_count = formula->association_count;
+}
+
+int kf_formula_view_lookup_answer(const KolibriFormulaView *view, int input,
+                                  char *buffer, size_t buffer_len) {
+    if (!view || !buffer || buffer_len == 0) {
         return -1;
     }
-    for (size_t i = 0; i < formula->association_count; ++i) {
-        const KolibriAssociation *assoc = &formula->associations[i];
-        if (assoc->input_hash == input && buffer) {
+    for (size_t i = 0; i < view->association_count; ++i) {
+        const KolibriAssociation *assoc = &view->associations[i];
+        if (assoc->input_hash == input) {
             strncpy(buffer, assoc->answer, buffer_len - 1U);
             buffer[buffer_len - 1U] = '\0';
             return 0;
@@ -570,32 +940,52 @@ int kf_formula_lookup_answer(const KolibriFormula *formula, int input,
     return -1;
 }
 
-int kf_formula_apply(const KolibriFormula *formula, int input, int *output) {
-    if (!formula || !output) {
+int kf_formula_lookup_answer(const KolibriFormula *formula, int input,
+                             char *buffer, size_t buffer_len) {
+    if (!formula) {
+        return -1;
+    }
+    KolibriFormulaView view;
+    kf_formula_view_init(&view, formula);
+    return kf_formula_view_lookup_answer(&view, input, buffer, buffer_len);
+}
+
+int kf_formula_view_apply(const KolibriFormulaView *view, int input, int *output) {
+    if (!view || !output) {
         return -1;
     }
-    for (size_t i = 0; i < formula->association_count; ++i) {
-        const KolibriAssociation *assoc = &formula->associations[i];
+    for (size_t i = 0; i < view->association_count; ++i) {
+        const KolibriAssociation *assoc = &view->associations[i];
         if (assoc->input_hash == input) {
             *output = assoc->output_hash;
             return 0;
         }
     }
-    return formula_predict_numeric(formula, input, output);
+    return gene_predict_numeric(&view->gene, input, output);
 }
 
-static size_t encode_associations_digits(const KolibriFormula *formula, uint8_t *out, size_t out_len) {
-    if (!formula || !out) {
+int kf_formula_apply(const KolibriFormula *formula, int input, int *output) {
+    if (!formula) {
+        return -1;
+    }
+    KolibriFormulaView view;
+    kf_formula_view_init(&view, formula);
+    return kf_formula_view_apply(&view, input, output);
+}
+
+static size_t encode_associations_digits(const KolibriAssociation *associations, size_t count,
+                                         uint8_t *out, size_t out_len) {
+    if (!associations || !out) {
         return 0;
     }
-    if (formula->association_count == 0) {
+    if (count == 0) {
         return 0;
     }
     char json_buffer[1024];
     size_t offset = 0;
     offset += snprintf(json_buffer + offset, sizeof(json_buffer) - offset, "{\"associations\":[");
-    for (size_t i = 0; i < formula->association_count && offset < sizeof(json_buffer); ++i) {
-        const KolibriAssociation *assoc = &formula->associations[i];
+    for (size_t i = 0; i < count && offset < sizeof(json_buffer); ++i) {
+        const KolibriAssociation *assoc = &associations[i];
         const char *q = assoc->question;
         const char *a = assoc->answer;
         if (!q) {
@@ -620,22 +1010,32 @@ static size_t encode_associations_digits(const KolibriFormula *formula, uint8_t
     return digits_len;
 }
 
-size_t kf_formula_digits(const KolibriFormula *formula, uint8_t *out, size_t out_len) {
-    if (!formula || !out) {
+size_t kf_formula_view_digits(const KolibriFormulaView *view, uint8_t *out, size_t out_len) {
+    if (!view || !out) {
         return 0;
     }
     size_t written = 0;
-    if (formula->gene.length <= out_len) {
-        memcpy(out, formula->gene.digits, formula->gene.length);
-        written = formula->gene.length;
+    if (view->gene.length <= out_len) {
+        memcpy(out, view->gene.digits, view->gene.length);
+        written = view->gene.length;
     }
     size_t remaining = out_len - written;
-    if (remaining > 32 && formula->association_count > 0) {
-        written += encode_associations_digits(formula, out + written, remaining);
+    if (remaining > 32 && view->association_count > 0) {
+        written += encode_associations_digits(view->associations, view->association_count,
+                                              out + written, remaining);
     }
     return written;
 }
 
+size_t kf_formula_digits(const KolibriFormula *formula, uint8_t *out, size_t out_len) {
+    if (!formula || !out) {
+        return 0;
+    }
+    KolibriFormulaView view;
+    kf_formula_view_init(&view, formula);
+    return kf_formula_view_digits(&view, out, out_len);
+}
+
 int kf_formula_describe(const KolibriFormula *formula, char *buffer, size_t buffer_len) {
     if (!formula || !buffer || buffer_len == 0) {
         return -1;
@@ -652,14 +1052,21 @@ int kf_formula_describe(const KolibriFormula *formula, char *buffer, size_t buff
         return 0;
     }
 
+    return kf_gene_describe(&formula->gene, formula->fitness, buffer, buffer_len);
+}
+
+int kf_gene_describe(const KolibriGene *gene, double fitness, char *buffer, size_t buffer_len) {
+    if (!gene || !buffer || buffer_len == 0) {
+        return -1;
+    }
     int operation = 0;
     int slope = 0;
     int bias = 0;
     int auxiliary = 0;
-    if (decode_operation(&formula->gene, 0, &operation) != 0 ||
-        decode_signed(&formula->gene, 1, &slope) != 0 ||
-        decode_bias(&formula->gene, 4, &bias) != 0 ||
-        decode_signed(&formula->gene, 7, &auxiliary) != 0) {
+    if (decode_operation(gene, 0, &operation) != 0 ||
+        decode_signed(gene, 1, &slope) != 0 ||
+        decode_bias(gene, 4, &bias) != 0 ||
+        decode_signed(gene, 7, &auxiliary) != 0) {
         return -1;
     }
     const char *operation_name = NULL;
@@ -682,7 +1089,7 @@ int kf_formula_describe(const KolibriFormula *formula, char *buffer, size_t buff
     }
     int written = snprintf(buffer, buffer_len,
                            "тип=%s k=%d b=%d aux=%d фитнес=%.6f",
-                           operation_name, slope, bias, auxiliary, formula->fitness);
+                           operation_name, slope, bias, auxiliary, fitness);
     if (written < 0 || (size_t)written >= buffer_len) {
         return -1;
     }
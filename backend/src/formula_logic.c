@@ -6,9 +6,12 @@
 
 #include "kolibri/logical_memory.h"
 #include "kolibri/formula_logic.h"
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <unistd.h>
 
 /* ========== ЖИЗНЕННЫЙ ЦИКЛ ========== */
 
@@ -126,134 +129,371 @@ MetaFormula* mf_create_relation_deriver(
     return meta;
 }
 
-/* ========== ВЫПОЛНЕНИЕ МЕТА-ФОРМУЛ ========== */
+/* ========== КОМПИЛЯЦИЯ ФОРМУЛ ========== */
 
-/* Вычислить простую формулу (константа или выражение) */
+/*
+ * Формула параметра ("10", "i*2+1", "(n-i)%7") разбирается один раз
+ * в обратную польскую запись; выполнение - проход по массиву без
+ * разбора текста. Переменные: i - номер ячейки в пакете, n - его размер.
+ */
+
+#define MF_MAX_OPS 32
+#define MF_MAX_THREADS 64
+#define MF_CELLS_PER_THREAD 32
+
+typedef enum {
+    MF_OP_CONST,
+    MF_OP_INDEX,
+    MF_OP_COUNT,
+    MF_OP_NEG,
+    MF_OP_ADD,
+    MF_OP_SUB,
+    MF_OP_MUL,
+    MF_OP_DIV,
+    MF_OP_MOD
+} MfOpCode;
+
+typedef struct {
+    MfOpCode code;
+    int64_t value;
+} MfOp;
+
+typedef struct {
+    MfOp ops[MF_MAX_OPS];
+    size_t count;
+} MfProgram;
+
+typedef struct {
+    const char *pos;
+    MfProgram *program;
+    int error;
+} MfParser;
+
+static void mf_emit(MfParser *p, MfOpCode code, int64_t value) {
+    if (p->program->count >= MF_MAX_OPS) {
+        p->error = 1;
+        return;
+    }
+    p->program->ops[p->program->count].code = code;
+    p->program->ops[p->program->count].value = value;
+    p->program->count++;
+}
+
+static char mf_peek(MfParser *p) {
+    while (*p->pos == ' ' || *p->pos == '\t') p->pos++;
+    return *p->pos;
+}
+
+static void mf_parse_sum(MfParser *p);
+
+static void mf_parse_factor(MfParser *p) {
+    char c = mf_peek(p);
+
+    if (c == '-') {
+        p->pos++;
+        mf_parse_factor(p);
+        mf_emit(p, MF_OP_NEG, 0);
+    } else if (c == '(') {
+        p->pos++;
+        mf_parse_sum(p);
+        if (mf_peek(p) != ')') {
+            p->error = 1;
+            return;
+        }
+        p->pos++;
+    } else if (c >= '0' && c <= '9') {
+        int64_t value = 0;
+        while (*p->pos >= '0' && *p->pos <= '9') {
+            value = value * 10 + (*p->pos - '0');
+            if (value > INT32_MAX) {
+                p->error = 1;
+                return;
+            }
+            p->pos++;
+        }
+        mf_emit(p, MF_OP_CONST, value);
+    } else if (c == 'i' || c == 'n') {
+        p->pos++;
+        mf_emit(p, c == 'i' ? MF_OP_INDEX : MF_OP_COUNT, 0);
+    } else {
+        p->error = 1;
+    }
+}
+
+static void mf_parse_product(MfParser *p) {
+    mf_parse_factor(p);
+    for (char c = mf_peek(p); !p->error && (c == '*' || c == '/' || c == '%'); c = mf_peek(p)) {
+        p->pos++;
+        mf_parse_factor(p);
+        mf_emit(p, c == '*' ? MF_OP_MUL : c == '/' ? MF_OP_DIV : MF_OP_MOD, 0);
+    }
+}
+
+static void mf_parse_sum(MfParser *p) {
+    mf_parse_product(p);
+    for (char c = mf_peek(p); !p->error && (c == '+' || c == '-'); c = mf_peek(p)) {
+        p->pos++;
+        mf_parse_product(p);
+        mf_emit(p, c == '+' ? MF_OP_ADD : MF_OP_SUB, 0);
+    }
+}
+
+static int mf_program_compile(const char *formula, MfProgram *program) {
+    MfParser parser = {formula, program, 0};
+    program->count = 0;
+    mf_parse_sum(&parser);
+    if (parser.error || mf_peek(&parser) != '\0') return -1;
+    return 0;
+}
+
+/* Выполнить программу; результат обязан помещаться в int */
+static int mf_program_eval(const MfProgram *program, size_t index, size_t count, int *result) {
+    int64_t stack[MF_MAX_OPS];
+    size_t top = 0;
+
+    for (size_t k = 0; k < program->count; k++) {
+        const MfOp *op = &program->ops[k];
+        switch (op->code) {
+            case MF_OP_CONST: stack[top++] = op->value; continue;
+            case MF_OP_INDEX: stack[top++] = (int64_t)index; continue;
+            case MF_OP_COUNT: stack[top++] = (int64_t)count; continue;
+            case MF_OP_NEG: stack[top - 1] = -stack[top - 1]; break;
+            default: {
+                int64_t b = stack[--top];
+                int64_t a = stack[top - 1];
+                if ((op->code == MF_OP_DIV || op->code == MF_OP_MOD) && b == 0) return -1;
+                switch (op->code) {
+                    case MF_OP_ADD: a += b; break;
+                    case MF_OP_SUB: a -= b; break;
+                    case MF_OP_MUL: a *= b; break;
+                    case MF_OP_DIV: a /= b; break;
+                    default: a %= b; break;
+                }
+                stack[top - 1] = a;
+                break;
+            }
+        }
+        /* Промежуточные значения держим в пределах int32: произведение
+         * двух таких значений не переполняет int64 */
+        if (stack[top - 1] > INT32_MAX || stack[top - 1] < INT32_MIN) return -1;
+    }
+
+    if (top != 1) return -1;
+    *result = (int)stack[0];
+    return 0;
+}
+
+/* Вычислить простую формулу без переменных пакета */
 static int evaluate_simple_formula(const char *formula, int *result) {
-    /* Простейший парсер: поддержка констант и простых операций */
-    if (sscanf(formula, "%d", result) == 1) {
-        return 0;  /* Константа */
+    MfProgram program;
+    if (mf_program_compile(formula, &program) != 0 ||
+        mf_program_eval(&program, 0, 1, result) != 0) {
+        *result = 0;
+        return -1;
     }
-    
-    /* TODO: Добавить поддержку выражений типа "10*2", "count+5" */
-    *result = 0;
-    return -1;
+    return 0;
 }
 
-LogicExpression* mf_execute(
-    MetaFormulaStore *store,
-    const MetaFormula *meta,
-    LogicalMemory *target_memory
-) {
-    if (!store || !meta || !target_memory) return NULL;
-    
-    LogicExpression *result = NULL;
-    
+/* ========== ПЛАН ВЫПОЛНЕНИЯ ========== */
+
+struct MfPlan {
+    MetaOperation operation;
+    char text[64];              /* Значение константы или паттерн repeat */
+    MfProgram count;
+    MfProgram start;
+    MfProgram step;
+    char input_id[64];          /* Вход трансформации / левая часть отношения */
+    char right_id[64];
+    int rule;                   /* Распознанное правило (1) или нет (0) */
+};
+
+MfPlan* mf_compile(const MetaFormula *meta) {
+    if (!meta) return NULL;
+
+    MfPlan *plan = (MfPlan*)calloc(1, sizeof(MfPlan));
+    if (!plan) return NULL;
+    plan->operation = meta->operation;
+
+    int rc = 0;
     switch (meta->operation) {
-        case META_GENERATE_CONSTANT: {
-            const char *value = meta->params.generate_constant.value;
-            result = lm_logic_constant(value);
-            printf("[META] Generated constant(\"%s\") from meta-formula\n", value);
+        case META_GENERATE_CONSTANT:
+            if (!meta->params.generate_constant.value) {
+                rc = -1;
+                break;
+            }
+            strncpy(plan->text, meta->params.generate_constant.value, sizeof(plan->text) - 1);
+            break;
+
+        case META_GENERATE_REPEAT:
+            strncpy(plan->text, meta->params.gen_repeat.pattern_formula, sizeof(plan->text) - 1);
+            rc = mf_program_compile(meta->params.gen_repeat.count_formula, &plan->count);
             break;
+
+        case META_GENERATE_SEQUENCE:
+            /* Неразборчивые параметры, как и раньше, считаются нулём */
+            if (mf_program_compile(meta->params.gen_sequence.start_formula, &plan->start) != 0) {
+                mf_program_compile("0", &plan->start);
+            }
+            if (mf_program_compile(meta->params.gen_sequence.step_formula, &plan->step) != 0) {
+                mf_program_compile("0", &plan->step);
+            }
+            if (mf_program_compile(meta->params.gen_sequence.count_formula, &plan->count) != 0) {
+                mf_program_compile("0", &plan->count);
+            }
+            break;
+
+        case META_TRANSFORM_LOGIC:
+            memcpy(plan->input_id, meta->params.transform.input_logic_id, sizeof(plan->input_id) - 1);
+            plan->rule = strcmp(meta->params.transform.transform_rule, "double_count") == 0;
+            break;
+
+        case META_DERIVE_RELATION:
+            memcpy(plan->input_id, meta->params.derive.left_logic_id, sizeof(plan->input_id) - 1);
+            memcpy(plan->right_id, meta->params.derive.right_logic_id, sizeof(plan->right_id) - 1);
+            plan->rule = strcmp(meta->params.derive.inference_rule, "transitive") == 0;
+            break;
+
+        default:
+            break;
+    }
+
+    if (rc != 0) {
+        free(plan);
+        return NULL;
+    }
+    return plan;
+}
+
+void mf_plan_destroy(MfPlan *plan) {
+    free(plan);
+}
+
+/* repeat(X, N) → repeat(X, 2N), sequence(a, d, N) → sequence(a, d, 2N) */
+static LogicExpression* transform_double_count(const LogicExpression *input) {
+    switch (input->type) {
+        case LOGIC_REPEAT: {
+            const LogicExpression *pattern = input->data.repeat.pattern;
+            if (!pattern || pattern->type != LOGIC_CONSTANT) return NULL;
+            if (input->data.repeat.count > SIZE_MAX / 2) return NULL;
+            return lm_logic_repeat(pattern->data.constant.value, input->data.repeat.count * 2);
         }
+        case LOGIC_SEQUENCE:
+            if (input->data.sequence.count > SIZE_MAX / 2) return NULL;
+            return lm_logic_sequence(input->data.sequence.start,
+                                     input->data.sequence.step,
+                                     input->data.sequence.count * 2);
+        default:
+            return NULL;
+    }
+}
+
+LogicExpression* mf_plan_execute(
+    const MfPlan *plan,
+    LogicalMemory *memory,
+    size_t index,
+    size_t count
+) {
+    if (!plan) return NULL;
+
+    switch (plan->operation) {
+        case META_GENERATE_CONSTANT:
+            return lm_logic_constant(plan->text);
 
         case META_GENERATE_REPEAT: {
-            /* Генерируем repeat() логику из формул */
-            const char *pattern = meta->params.gen_repeat.pattern_formula;
-            int count = 0;
-            
-            if (evaluate_simple_formula(meta->params.gen_repeat.count_formula, &count) != 0) {
+            int repeats = 0;
+            if (mf_program_eval(&plan->count, index, count, &repeats) != 0 || repeats <= 0) {
                 return NULL;
             }
-            
-            /* Создаём repeat логику */
-            result = lm_logic_repeat(pattern, count);
-            
-            printf("[META] Generated repeat(\"%s\", %d) from meta-formula\n", 
-                   pattern, count);
-            break;
-        }
-        
-        case META_GENERATE_COMPOSE: {
-            /* Композиция формул */
-            printf("[META] Generating composition (not implemented yet)\n");
-            break;
+            return lm_logic_repeat(plan->text, (size_t)repeats);
         }
-        
+
         case META_GENERATE_SEQUENCE: {
-            /* Генерируем sequence() логику */
-            int start = 0, step = 0, count = 0;
-            
-            evaluate_simple_formula(meta->params.gen_sequence.start_formula, &start);
-            evaluate_simple_formula(meta->params.gen_sequence.step_formula, &step);
-            evaluate_simple_formula(meta->params.gen_sequence.count_formula, &count);
-            
-            result = lm_logic_sequence(start, step, count);
-            
-            printf("[META] Generated sequence(%d, %d, %d) from meta-formula\n",
-                   start, step, count);
-            break;
+            int start = 0, step = 0, length = 0;
+            mf_program_eval(&plan->start, index, count, &start);
+            mf_program_eval(&plan->step, index, count, &step);
+            mf_program_eval(&plan->count, index, count, &length);
+            if (length <= 0) return NULL;
+            return lm_logic_sequence(start, step, (size_t)length);
         }
-        
+
         case META_TRANSFORM_LOGIC: {
-            /* Трансформируем существующую логику */
-            const char *input_id = meta->params.transform.input_logic_id;
-            const char *rule = meta->params.transform.transform_rule;
-            
-            /* Загружаем исходную логику */
-            size_t predicted = lm_predict_size(target_memory, input_id);
-            if (predicted == 0) {
-                return NULL;
-            }
-            
-            /* Простейшая трансформация: repeat(X, N) → repeat(X, N*2) */
-            if (strcmp(rule, "double_count") == 0) {
-                /* Создаём новую логику с удвоенным count */
-                result = lm_logic_repeat("X", 20);  /* TODO: правильная трансформация */
-                printf("[META] Transformed logic with rule: %s\n", rule);
-            }
-            break;
+            if (!memory || !plan->rule) return NULL;
+            const LogicExpression *input = lm_acquire_logic(memory, plan->input_id);
+            size_t size = 0;
+            if (input && lm_logic_size(input, &size) != 0) size = input->materialized_size;
+            LogicExpression *result = size > 0 ? transform_double_count(input) : NULL;
+            lm_release_logic(memory, input);
+            return result;
         }
-        
+
         case META_DERIVE_RELATION: {
-            /* Выводим новые отношения из существующих */
-            const char *left_id = meta->params.derive.left_logic_id;
-            const char *right_id = meta->params.derive.right_logic_id;
-            const char *rule = meta->params.derive.inference_rule;
-            
             /* Инференс: если A→B и B→C, то A→C */
-            if (strcmp(rule, "transitive") == 0) {
-                /* Загружаем логику A и B */
-                LogicExpression *left_expr = lm_logic_repeat("A", 1);  /* Заглушка */
-                LogicExpression *right_expr = lm_logic_repeat("C", 1);
-                
-                result = lm_logic_relation(left_expr, right_expr, "derives_from");
-                printf("[META] Derived relation: %s → %s (rule: %s)\n", 
-                       left_id, right_id, rule);
+            if (!plan->rule) return NULL;
+            LogicExpression *left_expr = lm_logic_repeat("A", 1);  /* Заглушка */
+            LogicExpression *right_expr = lm_logic_repeat("C", 1);
+            LogicExpression *relation = lm_logic_relation(left_expr, right_expr, "derives_from");
+            if (!relation) {
+                lm_destroy_logic(left_expr);
+                lm_destroy_logic(right_expr);
             }
-            break;
+            return relation;
         }
-        
-        case META_EVOLVE_PATTERN: {
-            /* Эволюционируем паттерн */
+
+        default:
+            return NULL;
+    }
+}
+
+LogicExpression* mf_execute(
+    MetaFormulaStore *store,
+    const MetaFormula *meta,
+    LogicalMemory *target_memory
+) {
+    if (!store || !meta || !target_memory) return NULL;
+
+    MfPlan *plan = mf_compile(meta);
+    LogicExpression *result = plan ? mf_plan_execute(plan, target_memory, 0, 1) : NULL;
+    mf_plan_destroy(plan);
+
+    char text[128];
+    switch (meta->operation) {
+        case META_GENERATE_COMPOSE:
+            printf("[META] Generating composition (not implemented yet)\n");
+            break;
+        case META_EVOLVE_PATTERN:
             printf("[META] Evolving pattern (not implemented yet)\n");
             break;
-        }
-        
-        case META_COMPRESS_LOGIC: {
-            /* Сжимаем логику в более компактную форму */
+        case META_COMPRESS_LOGIC:
             printf("[META] Compressing logic (not implemented yet)\n");
             break;
-        }
+        case META_TRANSFORM_LOGIC:
+            if (result) {
+                printf("[META] Transformed logic with rule: %s\n",
+                       meta->params.transform.transform_rule);
+            }
+            break;
+        case META_DERIVE_RELATION:
+            if (result) {
+                printf("[META] Derived relation: %s → %s (rule: %s)\n",
+                       meta->params.derive.left_logic_id,
+                       meta->params.derive.right_logic_id,
+                       meta->params.derive.inference_rule);
+            }
+            break;
+        default:
+            if (result && lm_logic_to_string(result, text, sizeof(text)) > 0) {
+                printf("[META] Generated %s from meta-formula\n", text);
+            }
+            break;
     }
-    
+
     /* Кэшируем результат */
     if (result && store->cache_count < 256) {
         store->generated_cache[store->cache_count] = result;
         snprintf(store->cache_ids[store->cache_count], 63, "meta_gen_%zu", store->cache_count);
         store->cache_count++;
     }
-    
+
     return result;
 }
 
@@ -435,6 +675,228 @@ int mf_auto_discover_patterns(
     return 1;  /* Количество найденных паттернов */
 }
 
+/* ---------- Пул потоков пакетного выполнения ---------- */
+
+typedef void (*MfPoolFn)(void *arg, size_t worker);
+
+typedef struct MfPool MfPool;
+
+typedef struct {
+    MfPool *pool;
+    size_t id;
+} MfPoolWorker;
+
+struct MfPool {
+    pthread_t threads[MF_MAX_THREADS];
+    MfPoolWorker workers[MF_MAX_THREADS];
+    size_t count;                 /* Всего исполнителей, включая вызывающий поток */
+    size_t started;               /* Запущено дополнительных потоков */
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    unsigned long generation;
+    size_t pending;
+    int stop;
+    MfPoolFn fn;
+    void *arg;
+};
+
+static void *mf_pool_main(void *raw) {
+    MfPoolWorker *self = (MfPoolWorker *)raw;
+    MfPool *pool = self->pool;
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (pool->generation == seen && !pool->stop) {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+        if (pool->stop) break;
+        seen = pool->generation;
+        MfPoolFn fn = pool->fn;
+        void *arg = pool->arg;
+        pthread_mutex_unlock(&pool->lock);
+
+        fn(arg, self->id);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->pending == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+static void mf_pool_init(MfPool *pool, size_t count) {
+    memset(pool, 0, sizeof(*pool));
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    pool->count = 1;
+    for (size_t i = 1; i < count; i++) {
+        pool->workers[i].pool = pool;
+        pool->workers[i].id = i;
+        if (pthread_create(&pool->threads[i], NULL, mf_pool_main, &pool->workers[i]) != 0) {
+            break;
+        }
+        pool->started++;
+        pool->count++;
+    }
+}
+
+static void mf_pool_run(MfPool *pool, MfPoolFn fn, void *arg) {
+    pthread_mutex_lock(&pool->lock);
+    pool->fn = fn;
+    pool->arg = arg;
+    pool->pending = pool->started;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    fn(arg, 0);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending > 0) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+static void mf_pool_destroy(MfPool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+    for (size_t i = 1; i <= pool->started; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->lock);
+}
+
+static size_t mf_thread_count(const MetaFormulaStore *store, size_t cells) {
+    size_t threads = store->threads;
+    if (threads == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = online > 0 ? (size_t)online : 1;
+    }
+    if (threads > MF_MAX_THREADS) threads = MF_MAX_THREADS;
+
+    /* Мелкие пакеты не стоят запуска потоков */
+    size_t useful = (cells + MF_CELLS_PER_THREAD - 1) / MF_CELLS_PER_THREAD;
+    if (threads > useful) threads = useful;
+    return threads ? threads : 1;
+}
+
+void mf_set_threads(MetaFormulaStore *store, size_t threads) {
+    if (store) store->threads = threads;
+}
+
+/* ---------- Порядок по зависимостям ---------- */
+
+/* Таблица ID пакета → первый индекс в cell_ids */
+typedef struct {
+    int32_t *slots;
+    size_t mask;
+    const char **ids;
+} MfIdTable;
+
+static uint32_t mf_hash_id(const char *id) {
+    uint32_t h = 2166136261u;
+    for (const unsigned char *p = (const unsigned char*)id; *p; p++) {
+        h ^= *p;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static int mf_id_table_init(MfIdTable *table, const char **ids, size_t count) {
+    size_t slots = 16;
+    while (slots < count * 2) slots *= 2;
+    table->slots = (int32_t*)malloc(slots * sizeof(int32_t));
+    if (!table->slots) return -1;
+    memset(table->slots, 0xff, slots * sizeof(int32_t));
+    table->mask = slots - 1;
+    table->ids = ids;
+
+    for (size_t i = 0; i < count; i++) {
+        if (!ids[i]) continue;
+        size_t slot = mf_hash_id(ids[i]) & table->mask;
+        while (table->slots[slot] >= 0 && strcmp(ids[table->slots[slot]], ids[i]) != 0) {
+            slot = (slot + 1) & table->mask;
+        }
+        if (table->slots[slot] < 0) table->slots[slot] = (int32_t)i;
+    }
+    return 0;
+}
+
+static int32_t mf_id_table_find(const MfIdTable *table, const char *id) {
+    size_t slot = mf_hash_id(id) & table->mask;
+    while (table->slots[slot] >= 0) {
+        if (strcmp(table->ids[table->slots[slot]], id) == 0) return table->slots[slot];
+        slot = (slot + 1) & table->mask;
+    }
+    return -1;
+}
+
+/* Рёбра j → i: ячейка i ждёт ячейку j. Возвращает число рёбер или -1 */
+static long mf_collect_edges(const MfPlan *plan, LogicalMemory *memory,
+                             const MfIdTable *table, const char **cell_ids,
+                             size_t count, int32_t *from, int32_t *to, size_t capacity) {
+    size_t edges = 0;
+    int32_t input = plan->operation == META_TRANSFORM_LOGIC
+                        ? mf_id_table_find(table, plan->input_id) : -1;
+
+    for (size_t i = 0; i < count; i++) {
+        if (!cell_ids[i]) continue;
+
+        if (input >= 0 && (size_t)input != i) {
+            if (edges < capacity) { from[edges] = input; to[edges] = (int32_t)i; }
+            edges++;
+        }
+
+        LogicCell *cell = lm_find_cell(memory, cell_ids[i]);
+        if (!cell) continue;
+        size_t deps = cell->dependency_count < 16 ? cell->dependency_count : 16;
+        for (size_t d = 0; d < deps; d++) {
+            char dependency[64];
+            memcpy(dependency, cell->dependencies[d], sizeof(dependency));
+            dependency[sizeof(dependency) - 1] = '\0';
+            int32_t j = mf_id_table_find(table, dependency);
+            if (j < 0 || (size_t)j == i) continue;
+            if (edges < capacity) { from[edges] = j; to[edges] = (int32_t)i; }
+            edges++;
+        }
+    }
+    return (long)edges;
+}
+
+/* ---------- Выполнение ---------- */
+
+typedef struct {
+    const MfPlan *plan;
+    LogicalMemory *memory;
+    const int32_t *order;         /* Ячейки текущего уровня */
+    size_t level_count;
+    size_t batch_count;
+    LogicExpression **results;
+    atomic_size_t next;
+} MfBatchLevel;
+
+static void mf_batch_worker(void *raw, size_t worker) {
+    MfBatchLevel *level = (MfBatchLevel *)raw;
+    (void)worker;
+
+    for (;;) {
+        size_t k = atomic_fetch_add(&level->next, 1);
+        if (k >= level->level_count) break;
+        size_t i = (size_t)level->order[k];
+        level->results[i] = mf_plan_execute(level->plan, level->memory, i, level->batch_count);
+    }
+}
+
 int mf_batch_execute(
     MetaFormulaStore *store,
     const MetaFormula *meta,
@@ -443,30 +905,113 @@ int mf_batch_execute(
     size_t cell_count
 ) {
     if (!store || !meta || !memory || !cell_ids) return -1;
-    
-    int success_count = 0;
-    
+
+    MfBatchStats *stats = &store->last_batch;
+    memset(stats, 0, sizeof(*stats));
+    stats->requested = cell_count;
+    if (cell_count == 0) return 0;
+    if (cell_count > INT32_MAX) return -1;
+
+    MfPlan *plan = mf_compile(meta);
+    if (!plan) {
+        stats->failed = cell_count;
+        return 0;
+    }
+
+    int rc = -1;
+    MfIdTable table = {0};
+    int32_t *from = NULL, *to = NULL, *first = NULL, *next_edge = NULL;
+    int32_t *indegree = NULL, *order = NULL;
+    LogicExpression **results = NULL;
+
+    if (mf_id_table_init(&table, cell_ids, cell_count) != 0) goto done;
+
+    /* Граф зависимостей внутри пакета */
+    long edges = mf_collect_edges(plan, memory, &table, cell_ids, cell_count, NULL, NULL, 0);
+    size_t edge_count = (size_t)edges;
+    from = (int32_t*)malloc((edge_count + 1) * sizeof(int32_t));
+    to = (int32_t*)malloc((edge_count + 1) * sizeof(int32_t));
+    next_edge = (int32_t*)malloc((edge_count + 1) * sizeof(int32_t));
+    first = (int32_t*)malloc(cell_count * sizeof(int32_t));
+    indegree = (int32_t*)calloc(cell_count, sizeof(int32_t));
+    order = (int32_t*)malloc(cell_count * sizeof(int32_t));
+    results = (LogicExpression**)calloc(cell_count, sizeof(LogicExpression*));
+    if (!from || !to || !next_edge || !first || !indegree || !order || !results) goto done;
+
+    mf_collect_edges(plan, memory, &table, cell_ids, cell_count, from, to, edge_count);
+    memset(first, 0xff, cell_count * sizeof(int32_t));
+    for (size_t e = 0; e < edge_count; e++) {
+        next_edge[e] = first[from[e]];
+        first[from[e]] = (int32_t)e;
+        indegree[to[e]]++;
+    }
+
+    /* Первый уровень - ячейки без входящих рёбер, в порядке cell_ids */
+    size_t level_start = 0, level_end = 0;
     for (size_t i = 0; i < cell_count; i++) {
-        LogicExpression *result = mf_execute(store, meta, memory);
-        if (result) {
-            /* Добавляем результат в ячейку памяти */
-            if (memory->cell_count < 1024) {
-                snprintf(memory->cells[memory->cell_count].id, 64, "%s", cell_ids[i]);
-                memory->cells[memory->cell_count].logic = result;
-                memory->cells[memory->cell_count].cached_data = NULL;
-                memory->cells[memory->cell_count].cache_valid = 0;
-                memory->cells[memory->cell_count].dependency_count = 0;
-                memory->cell_count++;
-                success_count++;
+        if (indegree[i] == 0) order[level_end++] = (int32_t)i;
+    }
+
+    MfPool pool;
+    mf_pool_init(&pool, mf_thread_count(store, cell_count));
+    stats->threads = pool.count;
+
+    while (level_start < level_end) {
+        MfBatchLevel level;
+        level.plan = plan;
+        level.memory = memory;
+        level.order = order + level_start;
+        level.level_count = level_end - level_start;
+        level.batch_count = cell_count;
+        level.results = results;
+        atomic_init(&level.next, 0);
+
+        if (level.level_count >= MF_CELLS_PER_THREAD && pool.count > 1) {
+            mf_pool_run(&pool, mf_batch_worker, &level);
+        } else {
+            mf_batch_worker(&level, 0);
+        }
+
+        /* Запись уровня в память в порядке cell_ids - до следующего уровня,
+         * чтобы зависимые ячейки видели результаты */
+        size_t next_end = level_end;
+        for (size_t k = level_start; k < level_end; k++) {
+            size_t i = (size_t)order[k];
+            if (!cell_ids[i]) {
+                stats->failed++;
+            } else if (results[i] && lm_put_logic(memory, cell_ids[i], results[i]) == 0) {
+                stats->executed++;
+            } else {
+                lm_destroy_logic(results[i]);
+                stats->failed++;
+            }
+            results[i] = NULL;
+
+            for (int32_t e = first[i]; e >= 0; e = next_edge[e]) {
+                if (--indegree[to[e]] == 0) order[next_end++] = to[e];
             }
-            /* Note: result ownership passed to memory */
         }
+        stats->levels++;
+        level_start = level_end;
+        level_end = next_end;
     }
-    
-    printf("[META] Batch executed meta-formula: %d/%zu cells\n", 
-           success_count, cell_count);
-    
-    return success_count;
+
+    mf_pool_destroy(&pool);
+
+    stats->blocked = cell_count - level_end;
+    rc = (int)stats->executed;
+
+done:
+    free(results);
+    free(order);
+    free(indegree);
+    free(first);
+    free(next_edge);
+    free(to);
+    free(from);
+    free(table.slots);
+    mf_plan_destroy(plan);
+    return rc;
 }
 
 MetaFormula* mf_infer_meta(
@@ -0,0 +1,495 @@
+/*
+ * Copyright (c) 2025 Кочуров Владислав Евгеньевич
+ * Formula Pool Snapshot
+ *
+ * Образ снимка - один блок: заголовок со смещениями секций, формулы
+ * (ген, фитнес, обратная связь, число ассоциаций), примеры, таблица
+ * уникальных ассоциаций, ссылки на неё (сначала пул, затем формулы по
+ * порядку) и данные ассоциаций: тексты без '\0' и цифры по две в байт.
+ * Формулы получают копии ассоциаций пула, поэтому дедупликация сжимает
+ * снимок в разы по сравнению с образом структуры в памяти.
+ */
+
+#include "kolibri/formula_snapshot.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SNAPSHOT_MAGIC 0x5350464Bu   /* "KFPS" */
+#define SNAPSHOT_VERSION 1u
+#define SNAPSHOT_MAX_FORMULAS (sizeof(((KolibriFormulaPool *)0)->formulas) / sizeof(KolibriFormula))
+#define SNAPSHOT_MAX_EXAMPLES (sizeof(((KolibriFormulaPool *)0)->inputs) / sizeof(int))
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t file_size;
+    uint64_t checksum;             /* FNV-1a 64 всего, что после заголовка */
+    uint64_t genome_index;
+    uint64_t rng_state;
+    uint32_t formula_count;
+    uint32_t example_count;
+    uint32_t pool_associations;    /* Первые ссылки - ассоциации пула */
+    uint32_t unique_associations;
+    uint64_t ref_count;
+    uint64_t formulas_offset;      /* SnapshotFormula[formula_count] */
+    uint64_t examples_offset;      /* int32_t inputs[], затем targets[] */
+    uint64_t associations_offset;  /* SnapshotAssociation[unique_associations] */
+    uint64_t refs_offset;          /* uint32_t[ref_count] */
+    uint64_t data_offset;
+    uint64_t data_size;
+} SnapshotHeader;
+
+typedef struct {
+    uint8_t digits[32];
+    uint32_t length;
+    uint32_t association_count;
+    double fitness;
+    double feedback;
+} SnapshotFormula;
+
+/* Данные: вопрос, ответ, источник, цифры вопроса, цифры ответа */
+typedef struct {
+    int32_t input_hash;
+    int32_t output_hash;
+    uint64_t timestamp;
+    uint64_t data;
+    uint16_t question_len;
+    uint16_t answer_len;
+    uint16_t source_len;
+    uint16_t question_digits;
+    uint16_t answer_digits;
+    uint16_t reserved[3];
+} SnapshotAssociation;
+
+static uint64_t align8(uint64_t value) {
+    return (value + 7u) & ~(uint64_t)7u;
+}
+
+static uint64_t fnv1a64(uint64_t hash, const void *data, size_t len) {
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+#define FNV64_BASIS 0xCBF29CE484222325ULL
+
+static size_t packed_size(size_t digits) {
+    return (digits + 1u) / 2u;
+}
+
+/* Поля могут быть заполнены до конца без '\0' */
+#define FIELD_LEN(a, field) strnlen((a)->field, sizeof((a)->field) - 1)
+
+static uint64_t association_data_size(const KolibriAssociation *a) {
+    return FIELD_LEN(a, question) + FIELD_LEN(a, answer) + FIELD_LEN(a, source) +
+           packed_size(a->question_digits_length) + packed_size(a->answer_digits_length);
+}
+
+/* Цифры сравниваются только при совпадении хэша текста */
+static uint64_t association_hash(const KolibriAssociation *a) {
+    uint64_t h = FNV64_BASIS;
+    h = fnv1a64(h, &a->input_hash, sizeof(a->input_hash));
+    h = fnv1a64(h, &a->output_hash, sizeof(a->output_hash));
+    h = fnv1a64(h, &a->timestamp, sizeof(a->timestamp));
+    size_t lengths[3] = {FIELD_LEN(a, question), FIELD_LEN(a, answer), FIELD_LEN(a, source)};
+    h = fnv1a64(h, lengths, sizeof(lengths));
+    h = fnv1a64(h, a->question, lengths[0]);
+    h = fnv1a64(h, a->answer, lengths[1]);
+    h = fnv1a64(h, a->source, lengths[2]);
+    return h;
+}
+
+static int field_same(const char *a, const char *b, size_t size) {
+    size_t len = strnlen(a, size - 1);
+    return len == strnlen(b, size - 1) && memcmp(a, b, len) == 0;
+}
+
+static int association_same(const KolibriAssociation *a, const KolibriAssociation *b) {
+    return a->input_hash == b->input_hash && a->output_hash == b->output_hash &&
+           a->timestamp == b->timestamp &&
+           a->question_digits_length == b->question_digits_length &&
+           a->answer_digits_length == b->answer_digits_length &&
+           field_same(a->question, b->question, sizeof(a->question)) &&
+           field_same(a->answer, b->answer, sizeof(a->answer)) &&
+           field_same(a->source, b->source, sizeof(a->source)) &&
+           memcmp(a->question_digits, b->question_digits, a->question_digits_length) == 0 &&
+           memcmp(a->answer_digits, b->answer_digits, a->answer_digits_length) == 0;
+}
+
+static int association_packable(const KolibriAssociation *a) {
+    if (a->question_digits_length > KOLIBRI_ASSOC_DIGITS_MAX ||
+        a->answer_digits_length > KOLIBRI_ASSOC_DIGITS_MAX) {
+        return 0;
+    }
+    for (size_t i = 0; i < a->question_digits_length; i++) {
+        if (a->question_digits[i] > 15) return 0;
+    }
+    for (size_t i = 0; i < a->answer_digits_length; i++) {
+        if (a->answer_digits[i] > 15) return 0;
+    }
+    return 1;
+}
+
+static uint8_t *pack_digits(uint8_t *out, const uint8_t *digits, size_t count) {
+    for (size_t i = 0; i < count; i += 2) {
+        uint8_t hi = i + 1 < count ? digits[i + 1] : 0;
+        *out++ = (uint8_t)(digits[i] | (hi << 4));
+    }
+    return out;
+}
+
+static const uint8_t *unpack_digits(const uint8_t *in, uint8_t *digits, size_t count) {
+    for (size_t i = 0; i < count; i += 2) {
+        uint8_t byte = *in++;
+        digits[i] = byte & 0x0F;
+        if (i + 1 < count) digits[i + 1] = byte >> 4;
+    }
+    return in;
+}
+
+static size_t formula_refs(const KolibriFormula *formula) {
+    return formula->association_count < KOLIBRI_FORMULA_MAX_ASSOCIATIONS
+               ? formula->association_count
+               : KOLIBRI_FORMULA_MAX_ASSOCIATIONS;
+}
+
+/* ---------- Запись ---------- */
+
+typedef struct {
+    const KolibriAssociation **unique;
+    size_t count;
+    uint32_t *slots;               /* Номер уникальной записи + 1 */
+    uint64_t *hashes;
+    size_t mask;
+} SnapshotDedup;
+
+static uint32_t dedup_add(SnapshotDedup *d, const KolibriAssociation *a) {
+    uint64_t hash = association_hash(a);
+    size_t slot = (size_t)hash & d->mask;
+    while (d->slots[slot]) {
+        uint32_t index = d->slots[slot] - 1;
+        if (d->hashes[index] == hash && association_same(d->unique[index], a)) return index;
+        slot = (slot + 1) & d->mask;
+    }
+    d->unique[d->count] = a;
+    d->hashes[d->count] = hash;
+    d->slots[slot] = (uint32_t)++d->count;
+    return (uint32_t)(d->count - 1);
+}
+
+static int write_image(const uint8_t *image, size_t size, const char *path) {
+    char tmp[4096];
+    if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp)) return -1;
+    FILE *f = fopen(tmp, "wb");
+    if (!f) return -1;
+    int ok = fwrite(image, 1, size, f) == size;
+    ok = fflush(f) == 0 && ok;
+    ok = fsync(fileno(f)) == 0 && ok;
+    ok = fclose(f) == 0 && ok;
+    if (!ok || rename(tmp, path) != 0) {
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+int kf_pool_snapshot_save(const KolibriFormulaPool *pool, uint64_t genome_index,
+                          const char *path, KolibriPoolSnapshotInfo *info) {
+    if (!pool || !path || pool->count > SNAPSHOT_MAX_FORMULAS ||
+        pool->examples > SNAPSHOT_MAX_EXAMPLES ||
+        pool->association_count > KOLIBRI_POOL_MAX_ASSOCIATIONS) {
+        return -1;
+    }
+
+    size_t refs = pool->association_count;
+    for (size_t i = 0; i < pool->count; i++) refs += formula_refs(&pool->formulas[i]);
+
+    SnapshotDedup d;
+    memset(&d, 0, sizeof(d));
+    size_t slots = 16;
+    while (slots < refs * 2) slots *= 2;
+    d.mask = slots - 1;
+    d.slots = (uint32_t *)calloc(slots, sizeof(uint32_t));
+    d.unique = (const KolibriAssociation **)malloc((refs + 1) * sizeof(*d.unique));
+    d.hashes = (uint64_t *)malloc((refs + 1) * sizeof(uint64_t));
+    uint32_t *ref = (uint32_t *)malloc((refs + 1) * sizeof(uint32_t));
+    uint8_t *image = NULL;
+    int status = -1;
+    if (!d.slots || !d.unique || !d.hashes || !ref) goto done;
+
+    size_t r = 0;
+    for (size_t i = 0; i < pool->association_count; i++) {
+        ref[r++] = dedup_add(&d, &pool->associations[i]);
+    }
+    for (size_t f = 0; f < pool->count; f++) {
+        const KolibriFormula *formula = &pool->formulas[f];
+        for (size_t i = 0; i < formula_refs(formula); i++) {
+            ref[r++] = dedup_add(&d, &formula->associations[i]);
+        }
+    }
+
+    uint64_t data_size = 0;
+    for (size_t i = 0; i < d.count; i++) {
+        if (!association_packable(d.unique[i])) goto done;
+        data_size += association_data_size(d.unique[i]);
+    }
+
+    /* Раскладка образа */
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = SNAPSHOT_MAGIC;
+    header.version = SNAPSHOT_VERSION;
+    header.genome_index = genome_index;
+    header.rng_state = pool->rng.state;
+    header.formula_count = (uint32_t)pool->count;
+    header.example_count = (uint32_t)pool->examples;
+    header.pool_associations = (uint32_t)pool->association_count;
+    header.unique_associations = (uint32_t)d.count;
+    header.ref_count = refs;
+
+    uint64_t offset = align8(sizeof(SnapshotHeader));
+    header.formulas_offset = offset;
+    offset = align8(offset + pool->count * sizeof(SnapshotFormula));
+    header.examples_offset = offset;
+    offset = align8(offset + 2 * pool->examples * sizeof(int32_t));
+    header.associations_offset = offset;
+    offset = align8(offset + d.count * sizeof(SnapshotAssociation));
+    header.refs_offset = offset;
+    offset = align8(offset + refs * sizeof(uint32_t));
+    header.data_offset = offset;
+    header.data_size = data_size;
+    offset = align8(offset + data_size);
+    header.file_size = offset;
+
+    image = (uint8_t *)calloc(1, (size_t)offset);
+    if (!image) goto done;
+
+    SnapshotFormula *formulas = (SnapshotFormula *)(image + header.formulas_offset);
+    for (size_t f = 0; f < pool->count; f++) {
+        const KolibriFormula *formula = &pool->formulas[f];
+        size_t length = formula->gene.length < sizeof(formula->gene.digits)
+                            ? formula->gene.length
+                            : sizeof(formula->gene.digits);
+        memcpy(formulas[f].digits, formula->gene.digits, length);
+        formulas[f].length = (uint32_t)length;
+        formulas[f].association_count = (uint32_t)formula_refs(formula);
+        formulas[f].fitness = formula->fitness;
+        formulas[f].feedback = formula->feedback;
+    }
+
+    int32_t *inputs = (int32_t *)(image + header.examples_offset);
+    for (size_t i = 0; i < pool->examples; i++) {
+        inputs[i] = pool->inputs[i];
+        inputs[pool->examples + i] = pool->targets[i];
+    }
+
+    SnapshotAssociation *table = (SnapshotAssociation *)(image + header.associations_offset);
+    uint8_t *data = image + header.data_offset;
+    uint8_t *cursor = data;
+    for (size_t i = 0; i < d.count; i++) {
+        const KolibriAssociation *a = d.unique[i];
+        SnapshotAssociation *s = &table[i];
+        s->input_hash = a->input_hash;
+        s->output_hash = a->output_hash;
+        s->timestamp = a->timestamp;
+        s->data = (uint64_t)(cursor - data);
+        s->question_len = (uint16_t)FIELD_LEN(a, question);
+        s->answer_len = (uint16_t)FIELD_LEN(a, answer);
+        s->source_len = (uint16_t)FIELD_LEN(a, source);
+        s->question_digits = (uint16_t)a->question_digits_length;
+        s->answer_digits = (uint16_t)a->answer_digits_length;
+        memcpy(cursor, a->question, s->question_len);
+        cursor += s->question_len;
+        memcpy(cursor, a->answer, s->answer_len);
+        cursor += s->answer_len;
+        memcpy(cursor, a->source, s->source_len);
+        cursor += s->source_len;
+        cursor = pack_digits(cursor, a->question_digits, a->question_digits_length);
+        cursor = pack_digits(cursor, a->answer_digits, a->answer_digits_length);
+    }
+    if (refs > 0) memcpy(image + header.refs_offset, ref, refs * sizeof(uint32_t));
+
+    header.checksum = fnv1a64(FNV64_BASIS, image + sizeof(header),
+                              (size_t)(offset - sizeof(header)));
+    memcpy(image, &header, sizeof(header));
+
+    if (write_image(image, (size_t)offset, path) != 0) goto done;
+    if (info) {
+        info->genome_index = genome_index;
+        info->formulas = pool->count;
+        info->examples = pool->examples;
+        info->associations = refs;
+        info->unique_associations = d.count;
+        info->bytes = (size_t)offset;
+    }
+    status = 0;
+
+done:
+    free(image);
+    free(ref);
+    free(d.hashes);
+    free(d.unique);
+    free(d.slots);
+    return status;
+}
+
+/* ---------- Загрузка ---------- */
+
+static int section_ok(const SnapshotHeader *h, uint64_t offset, uint64_t bytes) {
+    return (offset & 7) == 0 && offset <= h->file_size && bytes <= h->file_size - offset;
+}
+
+static int snapshot_valid(const uint8_t *base, size_t size) {
+    if (size < sizeof(SnapshotHeader)) return 0;
+    const SnapshotHeader *h = (const SnapshotHeader *)base;
+    if (h->magic != SNAPSHOT_MAGIC || h->version != SNAPSHOT_VERSION) return 0;
+    if (h->file_size != size || h->formula_count == 0 ||
+        h->formula_count > SNAPSHOT_MAX_FORMULAS || h->example_count > SNAPSHOT_MAX_EXAMPLES ||
+        h->pool_associations > KOLIBRI_POOL_MAX_ASSOCIATIONS ||
+        h->unique_associations > h->ref_count || h->pool_associations > h->ref_count ||
+        h->ref_count > (uint64_t)KOLIBRI_POOL_MAX_ASSOCIATIONS +
+                           SNAPSHOT_MAX_FORMULAS * KOLIBRI_FORMULA_MAX_ASSOCIATIONS) {
+        return 0;
+    }
+    if (!section_ok(h, h->formulas_offset, h->formula_count * sizeof(SnapshotFormula)) ||
+        !section_ok(h, h->examples_offset, 2ull * h->example_count * sizeof(int32_t)) ||
+        !section_ok(h, h->associations_offset,
+                    (uint64_t)h->unique_associations * sizeof(SnapshotAssociation)) ||
+        !section_ok(h, h->refs_offset, h->ref_count * sizeof(uint32_t)) ||
+        !section_ok(h, h->data_offset, h->data_size)) {
+        return 0;
+    }
+    if (fnv1a64(FNV64_BASIS, base + sizeof(SnapshotHeader), size - sizeof(SnapshotHeader)) !=
+        h->checksum) {
+        return 0;
+    }
+
+    const SnapshotFormula *formulas = (const SnapshotFormula *)(base + h->formulas_offset);
+    uint64_t refs = h->pool_associations;
+    for (uint32_t f = 0; f < h->formula_count; f++) {
+        if (formulas[f].length > sizeof(formulas[f].digits) ||
+            formulas[f].association_count > KOLIBRI_FORMULA_MAX_ASSOCIATIONS) {
+            return 0;
+        }
+        refs += formulas[f].association_count;
+    }
+    if (refs != h->ref_count) return 0;
+
+    const uint32_t *ref = (const uint32_t *)(base + h->refs_offset);
+    for (uint64_t i = 0; i < h->ref_count; i++) {
+        if (ref[i] >= h->unique_associations) return 0;
+    }
+
+    const SnapshotAssociation *table =
+        (const SnapshotAssociation *)(base + h->associations_offset);
+    for (uint32_t i = 0; i < h->unique_associations; i++) {
+        const SnapshotAssociation *s = &table[i];
+        uint64_t bytes = (uint64_t)s->question_len + s->answer_len + s->source_len +
+                         packed_size(s->question_digits) + packed_size(s->answer_digits);
+        if (s->question_len >= KOLIBRI_ASSOC_QUESTION_MAX ||
+            s->answer_len >= KOLIBRI_ASSOC_ANSWER_MAX || s->source_len >= 64 ||
+            s->question_digits > KOLIBRI_ASSOC_DIGITS_MAX ||
+            s->answer_digits > KOLIBRI_ASSOC_DIGITS_MAX || s->data > h->data_size ||
+            bytes > h->data_size - s->data) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void restore_association(const SnapshotAssociation *s, const uint8_t *data,
+                                KolibriAssociation *a) {
+    const uint8_t *p = data + s->data;
+    a->input_hash = s->input_hash;
+    a->output_hash = s->output_hash;
+    a->timestamp = s->timestamp;
+    memcpy(a->question, p, s->question_len);
+    a->question[s->question_len] = '\0';
+    p += s->question_len;
+    memcpy(a->answer, p, s->answer_len);
+    a->answer[s->answer_len] = '\0';
+    p += s->answer_len;
+    memcpy(a->source, p, s->source_len);
+    a->source[s->source_len] = '\0';
+    p += s->source_len;
+    p = unpack_digits(p, a->question_digits, s->question_digits);
+    a->question_digits_length = s->question_digits;
+    unpack_digits(p, a->answer_digits, s->answer_digits);
+    a->answer_digits_length = s->answer_digits;
+}
+
+int kf_pool_snapshot_load(KolibriFormulaPool *pool, const char *path,
+                          KolibriPoolSnapshotInfo *info) {
+    if (!pool || !path) return -1;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(SnapshotHeader)) {
+        close(fd);
+        return -1;
+    }
+    size_t size = (size_t)st.st_size;
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return -1;
+    madvise(map, size, MADV_SEQUENTIAL);
+
+    const uint8_t *base = (const uint8_t *)map;
+    if (!snapshot_valid(base, size)) {
+        munmap(map, size);
+        return -1;
+    }
+
+    const SnapshotHeader *h = (const SnapshotHeader *)base;
+    const SnapshotFormula *formulas = (const SnapshotFormula *)(base + h->formulas_offset);
+    const int32_t *examples = (const int32_t *)(base + h->examples_offset);
+    const SnapshotAssociation *table =
+        (const SnapshotAssociation *)(base + h->associations_offset);
+    const uint32_t *ref = (const uint32_t *)(base + h->refs_offset);
+    const uint8_t *data = base + h->data_offset;
+
+    pool->rng.state = h->rng_state;
+    pool->examples = h->example_count;
+    for (uint32_t i = 0; i < h->example_count; i++) {
+        pool->inputs[i] = examples[i];
+        pool->targets[i] = examples[h->example_count + i];
+    }
+    pool->association_count = h->pool_associations;
+    for (uint32_t i = 0; i < h->pool_associations; i++) {
+        restore_association(&table[*ref++], data, &pool->associations[i]);
+    }
+    pool->count = h->formula_count;
+    for (uint32_t f = 0; f < h->formula_count; f++) {
+        KolibriFormula *formula = &pool->formulas[f];
+        memset(&formula->gene, 0, sizeof(formula->gene));
+        memcpy(formula->gene.digits, formulas[f].digits, formulas[f].length);
+        formula->gene.length = formulas[f].length;
+        formula->fitness = formulas[f].fitness;
+        formula->feedback = formulas[f].feedback;
+        formula->association_count = formulas[f].association_count;
+        for (uint32_t i = 0; i < formulas[f].association_count; i++) {
+            restore_association(&table[*ref++], data, &formula->associations[i]);
+        }
+    }
+
+    if (info) {
+        info->genome_index = h->genome_index;
+        info->formulas = h->formula_count;
+        info->examples = h->example_count;
+        info->associations = (size_t)h->ref_count;
+        info->unique_associations = h->unique_associations;
+        info->bytes = size;
+    }
+    munmap(map, size);
+    return 0;
+}
@@ -6,18 +6,29 @@
 
 #include "kolibri/decimal.h"
 
+#include <openssl/crypto.h>
 #include <openssl/hmac.h>
 #include <openssl/sha.h>
 
 #include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <time.h>
+#include <unistd.h>
 
 #define KOLIBRI_HMAC_INPUT_SIZE                                                \
   (KOLIBRI_BLOCK_SIZE - KOLIBRI_HASH_SIZE)
 
+#define KG_VERIFY_MAX_THREADS 64
+#define KG_VERIFY_BLOCKS_PER_THREAD 1024
+
 static void reset_context(KolibriGenome *ctx) {
   if (!ctx) {
     return;
@@ -30,6 +41,8 @@ static void reset_context(KolibriGenome *ctx) {
   memset(ctx->path, 0, sizeof(ctx->path));
   ctx->next_index = 0;
   ctx->has_last_block = 0;
+  ctx->verified = 0;
+  ctx->tail_blocks = 0;
 }
 
 static void encode_u64_be(uint64_t value, unsigned char *out) {
@@ -161,13 +174,234 @@ static int parse_and_verify_block(const unsigned char *bytes,
   return 0;
 }
 
+/* ----------------------- Параллельная проверка ----------------------- */
+
+typedef struct {
+  const unsigned char *data;
+  const unsigned char *key;
+  size_t key_len;
+  uint64_t first;
+  uint64_t last;
+  atomic_int *failed;
+} VerifyRange;
+
+/* Блоки [first, last): индекс, ссылка на хэш предыдущего блока и HMAC.
+ * Каждый блок проверяется независимо, поэтому диапазоны параллельны. */
+static void *verify_range(void *raw) {
+  VerifyRange *range = (VerifyRange *)raw;
+  unsigned char prev[KOLIBRI_HASH_SIZE];
+  if (range->first == 0) {
+    memset(prev, 0, sizeof(prev));
+  } else if (!SHA256(range->data + (range->first - 1) * KOLIBRI_BLOCK_SIZE,
+                     KOLIBRI_BLOCK_SIZE, prev)) {
+    atomic_store(range->failed, 1);
+    return NULL;
+  }
+  for (uint64_t i = range->first; i < range->last; ++i) {
+    if ((i & 255U) == 0 && atomic_load_explicit(range->failed, memory_order_relaxed)) {
+      return NULL;
+    }
+    if (parse_and_verify_block(range->data + i * KOLIBRI_BLOCK_SIZE, range->key,
+                               range->key_len, i, prev, NULL, prev) != 0) {
+      atomic_store(range->failed, 1);
+      return NULL;
+    }
+  }
+  return NULL;
+}
+
+static size_t verify_thread_count(size_t threads, uint64_t blocks) {
+  if (threads == 0) {
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = online > 0 ? (size_t)online : 1U;
+  }
+  if (threads > KG_VERIFY_MAX_THREADS) {
+    threads = KG_VERIFY_MAX_THREADS;
+  }
+  /* Мелкие журналы не стоят запуска потоков */
+  uint64_t useful = (blocks + KG_VERIFY_BLOCKS_PER_THREAD - 1) / KG_VERIFY_BLOCKS_PER_THREAD;
+  if (threads > useful) {
+    threads = (size_t)useful;
+  }
+  return threads ? threads : 1U;
+}
+
+/* Полная проверка первых count блоков файла через mmap */
+static int verify_blocks(int fd, uint64_t count, const unsigned char *key,
+                         size_t key_len, size_t threads) {
+  if (count == 0) {
+    return 0;
+  }
+  size_t bytes = (size_t)(count * KOLIBRI_BLOCK_SIZE);
+  void *map = mmap(NULL, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (map == MAP_FAILED) {
+    return -1;
+  }
+  madvise(map, bytes, MADV_SEQUENTIAL);
+
+  atomic_int failed;
+  atomic_init(&failed, 0);
+  threads = verify_thread_count(threads, count);
+  VerifyRange ranges[KG_VERIFY_MAX_THREADS];
+  pthread_t workers[KG_VERIFY_MAX_THREADS];
+  size_t started = 0;
+  for (size_t t = 0; t < threads; ++t) {
+    ranges[t].data = (const unsigned char *)map;
+    ranges[t].key = key;
+    ranges[t].key_len = key_len;
+    ranges[t].first = count * t / threads;
+    ranges[t].last = count * (t + 1) / threads;
+    ranges[t].failed = &failed;
+  }
+  /* Вызывающий поток берёт первый диапазон */
+  for (size_t t = 1; t < threads; ++t) {
+    if (pthread_create(&workers[started], NULL, verify_range, &ranges[t]) != 0) {
+      verify_range(&ranges[t]);
+      continue;
+    }
+    started++;
+  }
+  verify_range(&ranges[0]);
+  for (size_t t = 0; t < started; ++t) {
+    pthread_join(workers[t], NULL);
+  }
+  munmap(map, bytes);
+  return atomic_load(&failed) ? -1 : 0;
+}
+
+/* ---------------------- Сохранённое состояние хвоста ---------------------- */
+
+#define KG_TAIL_MAGIC "KGTS"
+#define KG_TAIL_VERSION 1U
+#define KG_TAIL_BODY_SIZE (4 + 4 + 8 + KOLIBRI_HASH_SIZE)
+#define KG_TAIL_SIZE (KG_TAIL_BODY_SIZE + KOLIBRI_HASH_SIZE)
+
+static int tail_path(const KolibriGenome *ctx, char *out, size_t out_len) {
+  int written = snprintf(out, out_len, "%s.tail", ctx->path);
+  return written > 0 && (size_t)written < out_len ? 0 : -1;
+}
+
+static int tail_sign(const KolibriGenome *ctx, const unsigned char *body,
+                     unsigned char *mac) {
+  unsigned int mac_len = 0;
+  return HMAC(EVP_sha256(), ctx->hmac_key, (int)ctx->hmac_key_len, body,
+              KG_TAIL_BODY_SIZE, mac, &mac_len) && mac_len == KOLIBRI_HASH_SIZE
+             ? 0
+             : -1;
+}
+
+/* Записывает next_index и SHA-256 последнего блока, подписанные ключом
+ * генома; атомарно через временный файл. Ошибки не критичны. */
+static void tail_store(const KolibriGenome *ctx) {
+  char path[sizeof(ctx->path) + 16];
+  char tmp[sizeof(path) + 8];
+  if (tail_path(ctx, path, sizeof(path)) != 0) {
+    return;
+  }
+  unsigned char record[KG_TAIL_SIZE];
+  memcpy(record, KG_TAIL_MAGIC, 4);
+  record[4] = 0;
+  record[5] = 0;
+  record[6] = 0;
+  record[7] = (unsigned char)KG_TAIL_VERSION;
+  encode_u64_be(ctx->next_index, record + 8);
+  if (ctx->has_last_block) {
+    if (!SHA256(ctx->last_block, KOLIBRI_BLOCK_SIZE, record + 16)) {
+      return;
+    }
+  } else {
+    memset(record + 16, 0, KOLIBRI_HASH_SIZE);
+  }
+  if (tail_sign(ctx, record, record + KG_TAIL_BODY_SIZE) != 0) {
+    return;
+  }
+
+  snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+  FILE *file = fopen(tmp, "wb");
+  if (!file) {
+    return;
+  }
+  int ok = fwrite(record, 1, sizeof(record), file) == sizeof(record);
+  ok = fclose(file) == 0 && ok;
+  if (!ok || rename(tmp, path) != 0) {
+    unlink(tmp);
+  }
+}
+
+/* Загружает состояние хвоста и сверяет хэш покрытого блока с файлом.
+ * Возвращает число доверенных блоков или -1, если состояние непригодно. */
+static int64_t tail_load(const KolibriGenome *ctx, int fd, uint64_t count,
+                         unsigned char *last_hash) {
+  char path[sizeof(ctx->path) + 16];
+  if (tail_path(ctx, path, sizeof(path)) != 0) {
+    return -1;
+  }
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    return -1;
+  }
+  unsigned char record[KG_TAIL_SIZE];
+  size_t got = fread(record, 1, sizeof(record), file);
+  fclose(file);
+  if (got != sizeof(record) || memcmp(record, KG_TAIL_MAGIC, 4) != 0 ||
+      record[7] != KG_TAIL_VERSION) {
+    return -1;
+  }
+  unsigned char mac[KOLIBRI_HASH_SIZE];
+  if (tail_sign(ctx, record, mac) != 0 ||
+      CRYPTO_memcmp(mac, record + KG_TAIL_BODY_SIZE, KOLIBRI_HASH_SIZE) != 0) {
+    return -1;
+  }
+  uint64_t covered = decode_u64_be(record + 8);
+  if (covered > count || covered > (uint64_t)INT64_MAX) {
+    return -1;
+  }
+  if (covered > 0) {
+    unsigned char bytes[KOLIBRI_BLOCK_SIZE];
+    off_t offset = (off_t)((covered - 1) * KOLIBRI_BLOCK_SIZE);
+    unsigned char hash[KOLIBRI_HASH_SIZE];
+    if (pread(fd, bytes, sizeof(bytes), offset) != (ssize_t)sizeof(bytes) ||
+        !SHA256(bytes, sizeof(bytes), hash) ||
+        memcmp(hash, record + 16, KOLIBRI_HASH_SIZE) != 0) {
+      return -1;
+    }
+  }
+  memcpy(last_hash, record + 16, KOLIBRI_HASH_SIZE);
+  return (int64_t)covered;
+}
+
+/* Последовательная проверка блоков [first, count), дописанных после хвоста */
+static int verify_appended(const KolibriGenome *ctx, int fd, uint64_t first,
+                           uint64_t count, const unsigned char *prev_hash) {
+  unsigned char prev[KOLIBRI_HASH_SIZE];
+  unsigned char bytes[KOLIBRI_BLOCK_SIZE];
+  memcpy(prev, prev_hash, sizeof(prev));
+  for (uint64_t i = first; i < count; ++i) {
+    if (pread(fd, bytes, sizeof(bytes), (off_t)(i * KOLIBRI_BLOCK_SIZE)) !=
+            (ssize_t)sizeof(bytes) ||
+        parse_and_verify_block(bytes, ctx->hmac_key, ctx->hmac_key_len, i, prev,
+                               NULL, prev) != 0) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
 int kg_open(KolibriGenome *ctx, const char *path, const unsigned char *key,
             size_t key_len) {
+  return kg_open_ex(ctx, path, key, key_len, NULL);
+}
+
+int kg_open_ex(KolibriGenome *ctx, const char *path, const unsigned char *key,
+               size_t key_len, const KolibriGenomeOpenOptions *options) {
   if (!ctx || !path || !key || key_len == 0 ||
       key_len > sizeof(ctx->hmac_key)) {
     return -1;
   }
 
+  KolibriGenomeVerify mode = options ? options->verify : KG_VERIFY_FULL;
+  size_t threads = options ? options->threads : 0;
+
   reset_context(ctx);
 
   FILE *file = fopen(path, "r+b");
@@ -183,44 +417,64 @@ int kg_open(KolibriGenome *ctx, const char *path, const unsigned char *key,
   memcpy(ctx->hmac_key, key, key_len);
   ctx->hmac_key_len = key_len;
 
-  unsigned char expected_prev[KOLIBRI_HASH_SIZE];
-  memset(expected_prev, 0, sizeof(expected_prev));
-  uint64_t expected_index = 0;
+  int fd = fileno(file);
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size % KOLIBRI_BLOCK_SIZE != 0) {
+    kg_close(ctx);
+    return -1;
+  }
+  uint64_t count = (uint64_t)st.st_size / KOLIBRI_BLOCK_SIZE;
+
+  int verified = 0;
+  if (mode == KG_VERIFY_TAIL) {
+    unsigned char last_hash[KOLIBRI_HASH_SIZE];
+    int64_t covered = tail_load(ctx, fd, count, last_hash);
+    if (covered >= 0) {
+      if (verify_appended(ctx, fd, (uint64_t)covered, count, last_hash) != 0) {
+        kg_close(ctx);
+        return -1;
+      }
+      ctx->tail_blocks = (uint64_t)covered == count ? count : 0;
+      verified = 1;
+    }
+  }
+  if (mode == KG_VERIFY_FULL || (mode == KG_VERIFY_TAIL && !verified)) {
+    if (verify_blocks(fd, count, key, key_len, threads) != 0) {
+      kg_close(ctx);
+      return -1;
+    }
+    verified = 1;
+  }
 
-  unsigned char bytes[KOLIBRI_BLOCK_SIZE];
-  size_t read = 0;
-  while ((read = fread(bytes, 1, KOLIBRI_BLOCK_SIZE, ctx->file)) ==
-         KOLIBRI_BLOCK_SIZE) {
-    unsigned char block_hash[KOLIBRI_HASH_SIZE];
+  if (count > 0) {
     ReasonBlock block;
-    if (parse_and_verify_block(bytes, key, key_len, expected_index,
-                               expected_prev, &block, block_hash) != 0) {
+    off_t offset = (off_t)((count - 1) * KOLIBRI_BLOCK_SIZE);
+    if (pread(fd, ctx->last_block, KOLIBRI_BLOCK_SIZE, offset) !=
+        (ssize_t)KOLIBRI_BLOCK_SIZE) {
+      kg_close(ctx);
+      return -1;
+    }
+    deserialize_block(ctx->last_block, &block);
+    if (block.index != count - 1) {
       kg_close(ctx);
       return -1;
     }
-
     memcpy(ctx->last_hash, block.hmac, KOLIBRI_HASH_SIZE);
-    memcpy(ctx->last_block, bytes, KOLIBRI_BLOCK_SIZE);
     ctx->has_last_block = 1;
-    memcpy(expected_prev, block_hash, KOLIBRI_HASH_SIZE);
-    expected_index = block.index + 1;
   }
+  ctx->next_index = count;
+  ctx->verified = verified;
 
-  if (read != 0) {
-    kg_close(ctx);
-    return -1;
-  }
-
-  if (ferror(ctx->file)) {
+  if (fseek(ctx->file, 0, SEEK_END) != 0) {
     kg_close(ctx);
     return -1;
   }
 
-  ctx->next_index = expected_index;
-
-  if (fseek(ctx->file, 0, SEEK_END) != 0) {
-    kg_close(ctx);
-    return -1;
+  /* Без проверки состояние не подписываем: иначе непроверенные блоки
+   * стали бы доверенными при следующем открытии */
+  if (verified && ctx->tail_blocks != count) {
+    tail_store(ctx);
+    ctx->tail_blocks = count;
   }
 
   return 0;
@@ -230,6 +484,10 @@ void kg_close(KolibriGenome *ctx) {
   if (!ctx) {
     return;
   }
+  if (ctx->file && ctx->verified && ctx->tail_blocks != ctx->next_index &&
+      fflush(ctx->file) == 0) {
+    tail_store(ctx);
+  }
   if (ctx->file) {
     fclose(ctx->file);
     ctx->file = NULL;
@@ -241,6 +499,8 @@ void kg_close(KolibriGenome *ctx) {
   memset(ctx->path, 0, sizeof(ctx->path));
   ctx->next_index = 0;
   ctx->has_last_block = 0;
+  ctx->verified = 0;
+  ctx->tail_blocks = 0;
 }
 
 int kg_encode_payload(const char *utf8, char *out, size_t out_len) {
@@ -258,9 +518,12 @@ int kg_encode_payload(const char *utf8, char *out, size_t out_len) {
   return k_encode_text(utf8, out, out_len);
 }
 
-int kg_append(KolibriGenome *ctx, const char *event_type, const char *payload,
-              ReasonBlock *out_block) {
-  if (!ctx || !ctx->file || !event_type) {
+/* Builds and signs the block that follows prev_block (NULL for genesis) */
+static int seal_block(const KolibriGenome *ctx, uint64_t index,
+                      const unsigned char *prev_block, const char *event_type,
+                      const char *payload, ReasonBlock *block,
+                      unsigned char *bytes) {
+  if (!event_type) {
     return -1;
   }
 
@@ -274,39 +537,53 @@ int kg_append(KolibriGenome *ctx, const char *event_type, const char *payload,
     return -1;
   }
 
-  ReasonBlock block;
-  memset(&block, 0, sizeof(block));
+  memset(block, 0, sizeof(*block));
 
-  block.index = ctx->next_index;
-  block.timestamp = current_time_ns();
+  block->index = index;
+  block->timestamp = current_time_ns();
 
-  if (ctx->has_last_block) {
-    if (!SHA256(ctx->last_block, KOLIBRI_BLOCK_SIZE, block.prev_hash)) {
+  if (prev_block) {
+    if (!SHA256(prev_block, KOLIBRI_BLOCK_SIZE, block->prev_hash)) {
       return -1;
     }
   } else {
-    memset(block.prev_hash, 0, KOLIBRI_HASH_SIZE);
+    memset(block->prev_hash, 0, KOLIBRI_HASH_SIZE);
   }
 
-  memcpy(block.event_type, event_type, event_len);
+  memcpy(block->event_type, event_type, event_len);
   size_t payload_len = strnlen(digits, KOLIBRI_PAYLOAD_SIZE);
   if (payload_len >= KOLIBRI_PAYLOAD_SIZE) {
     return -1;
   }
-  memcpy(block.payload, digits, payload_len);
+  memcpy(block->payload, digits, payload_len);
 
   unsigned char message[KOLIBRI_HMAC_INPUT_SIZE];
-  build_hmac_message(&block, message);
+  build_hmac_message(block, message);
 
   unsigned int hmac_len = 0;
   if (!HMAC(EVP_sha256(), ctx->hmac_key, (int)ctx->hmac_key_len, message,
-            sizeof(message), block.hmac, &hmac_len) ||
+            sizeof(message), block->hmac, &hmac_len) ||
       hmac_len != KOLIBRI_HASH_SIZE) {
     return -1;
   }
 
+  serialize_block(block, bytes);
+  return 0;
+}
+
+int kg_append(KolibriGenome *ctx, const char *event_type, const char *payload,
+              ReasonBlock *out_block) {
+  if (!ctx || !ctx->file || !event_type) {
+    return -1;
+  }
+
+  ReasonBlock block;
   unsigned char bytes[KOLIBRI_BLOCK_SIZE];
-  serialize_block(&block, bytes);
+  if (seal_block(ctx, ctx->next_index,
+                 ctx->has_last_block ? ctx->last_block : NULL, event_type,
+                 payload, &block, bytes) != 0) {
+    return -1;
+  }
 
   if (fwrite(bytes, 1, KOLIBRI_BLOCK_SIZE, ctx->file) != KOLIBRI_BLOCK_SIZE) {
     return -1;
@@ -328,48 +605,99 @@ int kg_append(KolibriGenome *ctx, const char *event_type, const char *payload,
   return 0;
 }
 
-int kg_verify_file(const char *path, const unsigned char *key,
-                   size_t key_len) {
-  if (!path || !key || key_len == 0 || key_len > KOLIBRI_HMAC_KEY_SIZE) {
+int kg_append_batch(KolibriGenome *ctx, const char *const *event_types,
+                    const char *const *payloads, size_t count) {
+  if (!ctx || !ctx->file || (count > 0 && !event_types)) {
+    return -1;
+  }
+  if (count == 0) {
+    return 0;
+  }
+  if (count > SIZE_MAX / KOLIBRI_BLOCK_SIZE) {
     return -1;
   }
 
-  FILE *file = fopen(path, "rb");
-  if (!file) {
-    if (errno == ENOENT) {
-      return 1;
+  unsigned char *bytes = (unsigned char *)malloc(count * KOLIBRI_BLOCK_SIZE);
+  if (!bytes) {
+    return -1;
+  }
+
+  /* Все блоки подписываются заранее: цепочка продолжается в буфере */
+  ReasonBlock block;
+  const unsigned char *prev = ctx->has_last_block ? ctx->last_block : NULL;
+  for (size_t i = 0; i < count; ++i) {
+    unsigned char *out = bytes + i * KOLIBRI_BLOCK_SIZE;
+    if (seal_block(ctx, ctx->next_index + i, prev, event_types[i],
+                   payloads ? payloads[i] : NULL, &block, out) != 0) {
+      free(bytes);
+      return -1;
+    }
+    prev = out;
+  }
+
+  long start = ftell(ctx->file);
+  size_t total = count * KOLIBRI_BLOCK_SIZE;
+  if (start < 0 || fwrite(bytes, 1, total, ctx->file) != total ||
+      fflush(ctx->file) != 0) {
+    /* Откатываем частичную запись, чтобы цепочка осталась целой */
+    if (start >= 0) {
+      clearerr(ctx->file);
+      if (ftruncate(fileno(ctx->file), (off_t)start) == 0) {
+        fseek(ctx->file, start, SEEK_SET);
+      }
     }
+    free(bytes);
     return -1;
   }
 
-  unsigned char expected_prev[KOLIBRI_HASH_SIZE];
-  memset(expected_prev, 0, sizeof(expected_prev));
-  uint64_t expected_index = 0;
+  memcpy(ctx->last_hash, block.hmac, KOLIBRI_HASH_SIZE);
+  memcpy(ctx->last_block, bytes + (count - 1) * KOLIBRI_BLOCK_SIZE,
+         KOLIBRI_BLOCK_SIZE);
+  ctx->has_last_block = 1;
+  ctx->next_index += count;
+  free(bytes);
+  return 0;
+}
 
+int kg_read_block(KolibriGenome *ctx, uint64_t index, ReasonBlock *out_block) {
+  if (!ctx || !ctx->file || !out_block || index >= ctx->next_index) {
+    return -1;
+  }
   unsigned char bytes[KOLIBRI_BLOCK_SIZE];
-  size_t read = 0;
-  while ((read = fread(bytes, 1, KOLIBRI_BLOCK_SIZE, file)) ==
-         KOLIBRI_BLOCK_SIZE) {
-    unsigned char block_hash[KOLIBRI_HASH_SIZE];
-    if (parse_and_verify_block(bytes, key, key_len, expected_index,
-                               expected_prev, NULL, block_hash) != 0) {
-      fclose(file);
-      return -1;
-    }
-    memcpy(expected_prev, block_hash, KOLIBRI_HASH_SIZE);
-    expected_index += 1;
+  if (fflush(ctx->file) != 0 ||
+      pread(fileno(ctx->file), bytes, sizeof(bytes),
+            (off_t)(index * KOLIBRI_BLOCK_SIZE)) != (ssize_t)sizeof(bytes)) {
+    return -1;
   }
+  deserialize_block(bytes, out_block);
+  if (out_block->index != index ||
+      !memchr(out_block->event_type, '\0', KOLIBRI_EVENT_TYPE_SIZE) ||
+      !memchr(out_block->payload, '\0', KOLIBRI_PAYLOAD_SIZE)) {
+    return -1;
+  }
+  return 0;
+}
 
-  if (read != 0) {
-    fclose(file);
+int kg_verify_file(const char *path, const unsigned char *key,
+                   size_t key_len) {
+  if (!path || !key || key_len == 0 || key_len > KOLIBRI_HMAC_KEY_SIZE) {
     return -1;
   }
 
-  if (ferror(file)) {
-    fclose(file);
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    if (errno == ENOENT) {
+      return 1;
+    }
     return -1;
   }
 
-  fclose(file);
-  return 0;
+  struct stat st;
+  int status = -1;
+  if (fstat(fd, &st) == 0 && st.st_size % KOLIBRI_BLOCK_SIZE == 0) {
+    status = verify_blocks(fd, (uint64_t)st.st_size / KOLIBRI_BLOCK_SIZE, key,
+                           key_len, 0);
+  }
+  close(fd);
+  return status;
 }
@@ -0,0 +1,375 @@
+/*
+ * Copyright (c) 2025 Кочуров Владислав Евгеньевич
+ *
+ * Kolibri Knowledge Handle
+ * Текущая версия хранится указателем под коротким мьютексом: читатель
+ * только увеличивает счётчик ссылок, сборка идёт вне блокировки.
+ * Дескриптор сам держит одну ссылку на текущую версию и отдаёт её при
+ * замене. Слежение за каталогами - опрос: отпечаток из путей, размеров
+ * и времён изменения файлов сравнивается с отпечатком последней сборки.
+ */
+
+#include "kolibri/knowledge_handle.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define FNV64_BASIS 0xCBF29CE484222325ULL
+#define FNV64_PRIME 0x100000001B3ULL
+
+typedef struct {
+    KolibriKnowledgeVersion pub; /* первым полем: приводится к версии */
+    atomic_size_t refs;
+    KolibriKnowledgeHandle *owner;
+} KnowledgeVersionBox;
+
+struct KolibriKnowledgeHandle {
+    char **roots;
+    size_t root_count;
+    unsigned watch_ms;
+
+    pthread_mutex_t swap_lock; /* только указатель current */
+    KnowledgeVersionBox *current;
+    atomic_size_t live_versions;
+
+    pthread_mutex_t build_lock; /* одна сборка за раз */
+    unsigned long long next_version;
+    uint64_t fingerprint;
+    KolibriKnowledgePublishFn on_publish;
+    void *on_publish_user;
+
+    pthread_mutex_t lock; /* запросы к сборщику */
+    pthread_cond_t wake;
+    int reload_requested;
+    int stop;
+    pthread_t builder;
+    int builder_started;
+};
+
+static uint64_t fnv1a64(uint64_t hash, const void *data, size_t len) {
+    const unsigned char *bytes = (const unsigned char *)data;
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= bytes[i];
+        hash *= FNV64_PRIME;
+    }
+    return hash;
+}
+
+static int is_document_name(const char *name) {
+    const char *ext = strrchr(name, '.');
+    return ext && (strcmp(ext, ".md") == 0 || strcmp(ext, ".txt") == 0);
+}
+
+/* Порядок readdir не важен: вклады файлов складываются */
+static uint64_t fingerprint_directory(const char *path, int depth) {
+    DIR *dir = opendir(path);
+    if (!dir) {
+        return 0U;
+    }
+    uint64_t sum = 0U;
+    struct dirent *entry;
+    char child[1024];
+    while ((entry = readdir(dir)) != NULL) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+            continue;
+        }
+        snprintf(child, sizeof(child), "%s/%s", path, entry->d_name);
+        struct stat st;
+        if (stat(child, &st) != 0) {
+            continue;
+        }
+        if (S_ISDIR(st.st_mode)) {
+            if (depth < 64) {
+                sum += fingerprint_directory(child, depth + 1);
+            }
+            continue;
+        }
+        if (!is_document_name(entry->d_name)) {
+            continue;
+        }
+        long long stamp[3] = {(long long)st.st_size, (long long)st.st_mtim.tv_sec,
+                              (long long)st.st_mtim.tv_nsec};
+        uint64_t h = fnv1a64(FNV64_BASIS, child, strlen(child));
+        sum += fnv1a64(h, stamp, sizeof(stamp));
+    }
+    closedir(dir);
+    return sum;
+}
+
+static uint64_t knowledge_fingerprint(const KolibriKnowledgeHandle *handle) {
+    uint64_t sum = 0U;
+    for (size_t i = 0; i < handle->root_count; ++i) {
+        sum += fingerprint_directory(handle->roots[i], 0) * (uint64_t)(2U * i + 1U);
+    }
+    return sum;
+}
+
+static double elapsed_ms(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) * 1e3 + (double)(now.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+static void knowledge_version_free(KnowledgeVersionBox *box) {
+    KolibriKnowledgeHandle *owner = box->owner;
+    kolibri_knowledge_index_free(&box->pub.index);
+    free(box);
+    atomic_fetch_sub(&owner->live_versions, 1);
+}
+
+static void knowledge_version_unref(KnowledgeVersionBox *box) {
+    if (atomic_fetch_sub(&box->refs, 1) == 1) {
+        knowledge_version_free(box);
+    }
+}
+
+/* Сборка новой версии вне всех блокировок, кроме build_lock. Неудачная
+ * сборка и пустая сборка поверх непустой версии не публикуются. */
+static int knowledge_handle_rebuild(KolibriKnowledgeHandle *handle) {
+    pthread_mutex_lock(&handle->build_lock);
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    uint64_t fingerprint = knowledge_fingerprint(handle);
+
+    KnowledgeVersionBox *box = (KnowledgeVersionBox *)calloc(1, sizeof(KnowledgeVersionBox));
+    if (!box || kolibri_knowledge_index_init(&box->pub.index) != 0) {
+        free(box);
+        pthread_mutex_unlock(&handle->build_lock);
+        return -1;
+    }
+    int failed = 0;
+    for (size_t i = 0; i < handle->root_count && !failed; ++i) {
+        failed = kolibri_knowledge_index_load_directory(&box->pub.index, handle->roots[i]) != 0;
+    }
+    /* current меняется только под build_lock, который мы держим */
+    if (!failed && box->pub.index.count == 0U && handle->current &&
+        handle->current->pub.index.count > 0U) {
+        failed = 1;
+    }
+    if (failed) {
+        /* Отпечаток запоминается, чтобы наблюдатель не пересобирал
+         * тот же сбой каждый период */
+        handle->fingerprint = fingerprint;
+        kolibri_knowledge_index_free(&box->pub.index);
+        free(box);
+        pthread_mutex_unlock(&handle->build_lock);
+        return -1;
+    }
+    box->pub.version = ++handle->next_version;
+    box->pub.loaded_at = time(NULL);
+    box->pub.build_ms = elapsed_ms(&start);
+    box->owner = handle;
+    atomic_init(&box->refs, 1);
+    atomic_fetch_add(&handle->live_versions, 1);
+    handle->fingerprint = fingerprint;
+
+    /* Публикация: новые читатели видят новую версию, старые дорабатывают */
+    pthread_mutex_lock(&handle->swap_lock);
+    KnowledgeVersionBox *old = handle->current;
+    handle->current = box;
+    pthread_mutex_unlock(&handle->swap_lock);
+    /* Под build_lock: обработчики двух публикаций не пересекаются */
+    if (handle->on_publish) {
+        handle->on_publish(&box->pub, handle->on_publish_user);
+    }
+    pthread_mutex_unlock(&handle->build_lock);
+
+    if (old) {
+        knowledge_version_unref(old);
+    }
+    return 0;
+}
+
+static void *knowledge_builder_main(void *arg) {
+    KolibriKnowledgeHandle *handle = (KolibriKnowledgeHandle *)arg;
+    pthread_mutex_lock(&handle->lock);
+    while (!handle->stop) {
+        if (!handle->reload_requested) {
+            if (handle->watch_ms > 0U) {
+                struct timespec deadline;
+                clock_gettime(CLOCK_REALTIME, &deadline);
+                deadline.tv_sec += (time_t)(handle->watch_ms / 1000U);
+                deadline.tv_nsec += (long)(handle->watch_ms % 1000U) * 1000000L;
+                if (deadline.tv_nsec >= 1000000000L) {
+                    deadline.tv_sec += 1;
+                    deadline.tv_nsec -= 1000000000L;
+                }
+                pthread_cond_timedwait(&handle->wake, &handle->lock, &deadline);
+            } else {
+                pthread_cond_wait(&handle->wake, &handle->lock);
+            }
+        }
+        if (handle->stop) {
+            break;
+        }
+        int rebuild = handle->reload_requested;
+        handle->reload_requested = 0;
+        pthread_mutex_unlock(&handle->lock);
+
+        if (!rebuild && handle->watch_ms > 0U) {
+            pthread_mutex_lock(&handle->build_lock);
+            rebuild = knowledge_fingerprint(handle) != handle->fingerprint;
+            pthread_mutex_unlock(&handle->build_lock);
+        }
+        if (rebuild && knowledge_handle_rebuild(handle) == 0) {
+            const KolibriKnowledgeVersion *version = kolibri_knowledge_acquire(handle);
+            fprintf(stdout, "[kolibri-knowledge] index version %llu: %zu documents (%.1f ms)\n",
+                    version->version, version->index.count, version->build_ms);
+            fflush(stdout);
+            kolibri_knowledge_release(version);
+        } else if (rebuild) {
+            fprintf(stderr, "[kolibri-knowledge] rebuild failed, keeping version %llu\n",
+                    kolibri_knowledge_handle_version(handle));
+        }
+        pthread_mutex_lock(&handle->lock);
+    }
+    pthread_mutex_unlock(&handle->lock);
+    return NULL;
+}
+
+static void knowledge_handle_free(KolibriKnowledgeHandle *handle) {
+    for (size_t i = 0; i < handle->root_count; ++i) {
+        free(handle->roots[i]);
+    }
+    free(handle->roots);
+    pthread_cond_destroy(&handle->wake);
+    pthread_mutex_destroy(&handle->lock);
+    pthread_mutex_destroy(&handle->build_lock);
+    pthread_mutex_destroy(&handle->swap_lock);
+    free(handle);
+}
+
+KolibriKnowledgeHandle *kolibri_knowledge_handle_create(const char *const *roots,
+                                                        size_t root_count,
+                                                        unsigned watch_ms) {
+    if (!roots || root_count == 0U) {
+        return NULL;
+    }
+    KolibriKnowledgeHandle *handle = (KolibriKnowledgeHandle *)calloc(1, sizeof(KolibriKnowledgeHandle));
+    if (!handle) {
+        return NULL;
+    }
+    pthread_mutex_init(&handle->swap_lock, NULL);
+    pthread_mutex_init(&handle->build_lock, NULL);
+    pthread_mutex_init(&handle->lock, NULL);
+    pthread_cond_init(&handle->wake, NULL);
+    atomic_init(&handle->live_versions, 0);
+    handle->watch_ms = watch_ms;
+    handle->roots = (char **)calloc(root_count, sizeof(char *));
+    if (!handle->roots) {
+        knowledge_handle_free(handle);
+        return NULL;
+    }
+    for (size_t i = 0; i < root_count; ++i) {
+        handle->roots[i] = strdup(roots[i]);
+        if (!handle->roots[i]) {
+            knowledge_handle_free(handle);
+            return NULL;
+        }
+        handle->root_count = i + 1U;
+    }
+    if (knowledge_handle_rebuild(handle) != 0) {
+        knowledge_handle_free(handle);
+        return NULL;
+    }
+
+    /* Сигналы процесса достаются основному потоку, а не сборщику */
+    sigset_t all;
+    sigset_t previous;
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &previous);
+    handle->builder_started = pthread_create(&handle->builder, NULL, knowledge_builder_main, handle) == 0;
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+    if (!handle->builder_started) {
+        knowledge_version_unref(handle->current);
+        knowledge_handle_free(handle);
+        return NULL;
+    }
+    return handle;
+}
+
+void kolibri_knowledge_handle_destroy(KolibriKnowledgeHandle *handle) {
+    if (!handle) {
+        return;
+    }
+    pthread_mutex_lock(&handle->lock);
+    handle->stop = 1;
+    pthread_cond_signal(&handle->wake);
+    pthread_mutex_unlock(&handle->lock);
+    if (handle->builder_started) {
+        pthread_join(handle->builder, NULL);
+    }
+    if (handle->current) {
+        knowledge_version_unref(handle->current);
+    }
+    knowledge_handle_free(handle);
+}
+
+const KolibriKnowledgeVersion *kolibri_knowledge_acquire(KolibriKnowledgeHandle *handle) {
+    if (!handle) {
+        return NULL;
+    }
+    pthread_mutex_lock(&handle->swap_lock);
+    KnowledgeVersionBox *box = handle->current;
+    atomic_fetch_add(&box->refs, 1);
+    pthread_mutex_unlock(&handle->swap_lock);
+    return &box->pub;
+}
+
+void kolibri_knowledge_release(const KolibriKnowledgeVersion *version) {
+    if (!version) {
+        return;
+    }
+    knowledge_version_unref((KnowledgeVersionBox *)version);
+}
+
+void kolibri_knowledge_request_reload(KolibriKnowledgeHandle *handle) {
+    if (!handle) {
+        return;
+    }
+    pthread_mutex_lock(&handle->lock);
+    handle->reload_requested = 1;
+    pthread_cond_signal(&handle->wake);
+    pthread_mutex_unlock(&handle->lock);
+}
+
+void kolibri_knowledge_handle_on_publish(KolibriKnowledgeHandle *handle,
+                                         KolibriKnowledgePublishFn fn,
+                                         void *user) {
+    if (!handle) {
+        return;
+    }
+    pthread_mutex_lock(&handle->build_lock);
+    handle->on_publish = fn;
+    handle->on_publish_user = user;
+    pthread_mutex_unlock(&handle->build_lock);
+}
+
+int kolibri_knowledge_reload(KolibriKnowledgeHandle *handle) {
+    if (!handle) {
+        return -1;
+    }
+    return knowledge_handle_rebuild(handle);
+}
+
+unsigned long long kolibri_knowledge_handle_version(KolibriKnowledgeHandle *handle) {
+    if (!handle) {
+        return 0U;
+    }
+    pthread_mutex_lock(&handle->swap_lock);
+    unsigned long long version = handle->current->pub.version;
+    pthread_mutex_unlock(&handle->swap_lock);
+    return version;
+}
+
+size_t kolibri_knowledge_handle_live_versions(const KolibriKnowledgeHandle *handle) {
+    return handle ? atomic_load(&handle->live_versions) : 0U;
+}
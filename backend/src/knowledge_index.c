@@ -4,17 +4,31 @@
 #include <dirent.h>
 #include <errno.h>
 #include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 #define KOLIBRI_TOP_TERMS 32U
-
+#define KOLIBRI_INDEX_MAX_THREADS 64U
+#define KOLIBRI_VECTOR_CHUNK 64U
+#define KOLIBRI_MANIFEST_MAGIC 0x4D494B4BU /* "KKIM" */
+#define KOLIBRI_MANIFEST_VERSION 1U
+#define FNV64_BASIS 0xCBF29CE484222325ULL
+#define FNV64_PRIME 0x100000001B3ULL
+
+/* Leading fields mirror KolibriKnowledgeToken */
 typedef struct {
     char *token;
-    size_t df;
     float idf;
+    size_t df;
+    size_t *docs; /* posting list, df entries */
+    size_t doc_capacity;
+    int dirty;
 } GlobalToken;
 
 typedef struct {
@@ -22,6 +36,12 @@ typedef struct {
     size_t count;
 } DocToken;
 
+typedef struct {
+    size_t token;
+    size_t count;
+} DocTerm;
+
+/* Leading fields mirror KolibriKnowledgeDoc */
 typedef struct {
     char *id;
     char *title;
@@ -30,14 +50,42 @@ typedef struct {
     KolibriKnowledgeVectorItem *vector;
     size_t vector_size;
     float norm;
+    DocTerm *terms; /* sorted by token index */
+    size_t term_count;
+    long long mtime_ns;
+    unsigned long long size;
+    unsigned long long hash;
+    int dirty;
 } Document;
 
+typedef struct {
+    const char *key;
+    size_t value;
+} TokenSlot;
+
+/* Open-addressing string map; keys are borrowed from the owning arrays */
+typedef struct {
+    TokenSlot *slots;
+    size_t capacity;
+    size_t count;
+} TokenMap;
+
 struct KolibriKnowledgeIndex {
     Document *documents;
     size_t document_count;
+    size_t document_capacity;
     GlobalToken *tokens;
     size_t token_count;
     size_t token_capacity;
+    TokenMap token_map;
+    TokenMap path_map;
+    size_t *dirty_tokens;
+    size_t dirty_count;
+    size_t dirty_capacity;
+    char **roots;
+    size_t root_count;
+    size_t max_length;
+    size_t threads;
 };
 
 static void *kolibri_alloc(size_t size) {
@@ -49,6 +97,15 @@ static void *kolibri_alloc(size_t size) {
     return ptr;
 }
 
+static void *kolibri_realloc(void *ptr, size_t size) {
+    void *grown = realloc(ptr, size);
+    if (!grown) {
+        fprintf(stderr, "[kolibri-knowledge] realloc failure\n");
+        abort();
+    }
+    return grown;
+}
+
 static char *kolibri_strdup(const char *text) {
     if (!text) {
         return NULL;
@@ -63,43 +120,161 @@ static char *kolibri_strdup(const char *text) {
     return copy;
 }
 
+static uint64_t fnv1a64(uint64_t hash, const void *data, size_t len) {
+    const unsigned char *bytes = (const unsigned char *)data;
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= bytes[i];
+        hash *= FNV64_PRIME;
+    }
+    return hash;
+}
+
+static size_t token_map_find(const TokenMap *map, const char *key) {
+    if (map->capacity == 0U) {
+        return (size_t)-1;
+    }
+    size_t mask = map->capacity - 1U;
+    size_t slot = (size_t)fnv1a64(FNV64_BASIS, key, strlen(key)) & mask;
+    while (map->slots[slot].key) {
+        if (strcmp(map->slots[slot].key, key) == 0) {
+            return map->slots[slot].value;
+        }
+        slot = (slot + 1U) & mask;
+    }
+    return (size_t)-1;
+}
+
+static void token_map_insert(TokenSlot *slots, size_t capacity, const char *key, size_t value) {
+    size_t mask = capacity - 1U;
+    size_t slot = (size_t)fnv1a64(FNV64_BASIS, key, strlen(key)) & mask;
+    while (slots[slot].key && strcmp(slots[slot].key, key) != 0) {
+        slot = (slot + 1U) & mask;
+    }
+    slots[slot].key = key;
+    slots[slot].value = value;
+}
+
+static void token_map_put(TokenMap *map, const char *key, size_t value) {
+    if ((map->count + 1U) * 4U > map->capacity * 3U) {
+        size_t capacity = map->capacity == 0U ? 64U : map->capacity * 2U;
+        TokenSlot *slots = (TokenSlot *)kolibri_alloc(capacity * sizeof(TokenSlot));
+        for (size_t i = 0; i < map->capacity; ++i) {
+            if (map->slots[i].key) {
+                token_map_insert(slots, capacity, map->slots[i].key, map->slots[i].value);
+            }
+        }
+        free(map->slots);
+        map->slots = slots;
+        map->capacity = capacity;
+    }
+    if (token_map_find(map, key) == (size_t)-1) {
+        map->count++;
+    }
+    token_map_insert(map->slots, map->capacity, key, value);
+}
+
+static void token_map_clear(TokenMap *map) {
+    if (map->slots) {
+        memset(map->slots, 0, map->capacity * sizeof(TokenSlot));
+    }
+    map->count = 0U;
+}
+
+static void token_map_free(TokenMap *map) {
+    free(map->slots);
+    map->slots = NULL;
+    map->capacity = 0U;
+    map->count = 0U;
+}
+
+static size_t index_default_threads(void) {
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    if (online < 1) {
+        return 1U;
+    }
+    return (size_t)online < KOLIBRI_INDEX_MAX_THREADS ? (size_t)online : KOLIBRI_INDEX_MAX_THREADS;
+}
+
+/* Runs worker(arg) on up to `threads` threads; the caller is one of them */
+static void run_workers(void *(*worker)(void *), void *arg, size_t threads) {
+    if (threads > KOLIBRI_INDEX_MAX_THREADS) {
+        threads = KOLIBRI_INDEX_MAX_THREADS;
+    }
+    pthread_t workers[KOLIBRI_INDEX_MAX_THREADS];
+    size_t started = 0U;
+    for (size_t i = 1; i < threads; ++i) {
+        if (pthread_create(&workers[started], NULL, worker, arg) != 0) {
+            break;
+        }
+        started++;
+    }
+    worker(arg);
+    for (size_t i = 0; i < started; ++i) {
+        pthread_join(workers[i], NULL);
+    }
+}
+
 static int is_markdown_file(const char *path) {
     size_t len = strlen(path);
     return len > 3U && strcmp(path + len - 3U, ".md") == 0;
 }
 
+enum {
+    FILE_PENDING = 0,
+    FILE_UNCHANGED,
+    FILE_TOUCHED,
+    FILE_PARSED,
+    FILE_FAILED
+};
+
 typedef struct {
-    char **items;
+    char *path;
+    long long mtime_ns;
+    unsigned long long size;
+    size_t doc; /* matching document or (size_t)-1 */
+    int state;
+    unsigned long long hash;
+    char *id;
+    char *title;
+    char *content;
+    DocToken *tokens;
+    size_t token_count;
+} FileEntry;
+
+typedef struct {
+    FileEntry *items;
     size_t count;
     size_t capacity;
-} PathList;
+} FileList;
 
-static void path_list_init(PathList *list) {
-    list->items = NULL;
-    list->count = 0U;
-    list->capacity = 0U;
+static void file_list_push(FileList *list, const char *path, const struct stat *st) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity == 0U ? 64U : list->capacity * 2U;
+        list->items = (FileEntry *)kolibri_realloc(list->items, list->capacity * sizeof(FileEntry));
+    }
+    FileEntry *entry = &list->items[list->count++];
+    memset(entry, 0, sizeof(*entry));
+    entry->path = kolibri_strdup(path);
+    entry->mtime_ns = (long long)st->st_mtim.tv_sec * 1000000000LL + (long long)st->st_mtim.tv_nsec;
+    entry->size = (unsigned long long)st->st_size;
+    entry->doc = (size_t)-1;
 }
 
-static void path_list_push(PathList *list, const char *path) {
-    if (list->count == list->capacity) {
-        size_t new_capacity = list->capacity == 0U ? 16U : list->capacity * 2U;
-        char **new_items = (char **)realloc(list->items, new_capacity * sizeof(char *));
-        if (!new_items) {
-            fprintf(stderr, "[kolibri-knowledge] realloc failure\n");
-            abort();
-        }
-        list->items = new_items;
-        list->capacity = new_capacity;
+static void free_doc_tokens(DocToken *tokens, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        free(tokens[i].token);
     }
-    list->items[list->count++] = kolibri_strdup(path);
+    free(tokens);
 }
 
-static void path_list_free(PathList *list) {
-    if (!list) {
-        return;
-    }
+static void file_list_free(FileList *list) {
     for (size_t i = 0; i < list->count; ++i) {
-        free(list->items[i]);
+        FileEntry *entry = &list->items[i];
+        free(entry->path);
+        free(entry->id);
+        free(entry->title);
+        free(entry->content);
+        free_doc_tokens(entry->tokens, entry->token_count);
     }
     free(list->items);
     list->items = NULL;
@@ -107,40 +282,147 @@ static void path_list_free(PathList *list) {
     list->capacity = 0U;
 }
 
-static int path_is_directory(const char *path) {
-    struct stat st;
-    if (stat(path, &st) != 0) {
-        return 0;
+typedef struct {
+    char **items;
+    size_t count;
+    size_t capacity;
+} PathList;
+
+static void path_list_push_owned(PathList *list, char *path) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity == 0U ? 16U : list->capacity * 2U;
+        list->items = (char **)kolibri_realloc(list->items, list->capacity * sizeof(char *));
     }
-    return S_ISDIR(st.st_mode);
+    list->items[list->count++] = path;
 }
 
-static void collect_markdown_files(const char *root, PathList *list) {
-    if (path_is_directory(root)) {
-        DIR *dir = opendir(root);
-        if (!dir) {
-            return;
+/* Directories are shared through a stack; a worker exits once the stack
+ * is empty and no other worker can still push into it. */
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    PathList dirs;
+    size_t active;
+    FileList files;
+} CrawlJob;
+
+static void crawl_directory(const char *root, PathList *subdirs, FileList *files) {
+    DIR *dir = opendir(root);
+    if (!dir) {
+        return;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+            continue;
         }
-        struct dirent *entry;
-        while ((entry = readdir(dir)) != NULL) {
-            if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
-                continue;
+        char buffer[4096];
+        snprintf(buffer, sizeof(buffer), "%s/%s", root, entry->d_name);
+        int markdown = is_markdown_file(buffer);
+        if (entry->d_type == DT_REG && !markdown) {
+            continue;
+        }
+        struct stat st;
+        if (stat(buffer, &st) != 0) {
+            continue;
+        }
+        if (S_ISDIR(st.st_mode)) {
+            path_list_push_owned(subdirs, kolibri_strdup(buffer));
+        } else if (markdown && S_ISREG(st.st_mode)) {
+            file_list_push(files, buffer, &st);
+        }
+    }
+    closedir(dir);
+}
+
+static void *crawl_worker(void *arg) {
+    CrawlJob *job = (CrawlJob *)arg;
+    PathList subdirs = {NULL, 0U, 0U};
+    FileList files = {NULL, 0U, 0U};
+    pthread_mutex_lock(&job->lock);
+    for (;;) {
+        while (job->dirs.count == 0U && job->active > 0U) {
+            pthread_cond_wait(&job->wake, &job->lock);
+        }
+        if (job->dirs.count == 0U) {
+            break;
+        }
+        char *dir = job->dirs.items[--job->dirs.count];
+        job->active++;
+        pthread_mutex_unlock(&job->lock);
+
+        crawl_directory(dir, &subdirs, &files);
+        free(dir);
+
+        pthread_mutex_lock(&job->lock);
+        for (size_t i = 0; i < subdirs.count; ++i) {
+            path_list_push_owned(&job->dirs, subdirs.items[i]);
+        }
+        subdirs.count = 0U;
+        for (size_t i = 0; i < files.count; ++i) {
+            if (job->files.count == job->files.capacity) {
+                job->files.capacity = job->files.capacity == 0U ? 64U : job->files.capacity * 2U;
+                job->files.items = (FileEntry *)kolibri_realloc(job->files.items,
+                                                                job->files.capacity * sizeof(FileEntry));
             }
-            char buffer[4096];
-            snprintf(buffer, sizeof(buffer), "%s/%s", root, entry->d_name);
-            if (path_is_directory(buffer)) {
-                collect_markdown_files(buffer, list);
-            } else if (is_markdown_file(buffer)) {
-                path_list_push(list, buffer);
+            job->files.items[job->files.count++] = files.items[i];
+        }
+        files.count = 0U;
+        job->active--;
+        pthread_cond_broadcast(&job->wake);
+    }
+    pthread_cond_broadcast(&job->wake);
+    pthread_mutex_unlock(&job->lock);
+    free(subdirs.items);
+    free(files.items);
+    return NULL;
+}
+
+static int file_entry_compare(const void *a, const void *b) {
+    return strcmp(((const FileEntry *)a)->path, ((const FileEntry *)b)->path);
+}
+
+/* Collects Markdown files under the roots, sorted by path and deduplicated */
+static void crawl_roots(char *const *roots, size_t root_count, size_t threads, FileList *out) {
+    CrawlJob job;
+    memset(&job, 0, sizeof(job));
+    pthread_mutex_init(&job.lock, NULL);
+    pthread_cond_init(&job.wake, NULL);
+    for (size_t i = 0; i < root_count; ++i) {
+        struct stat st;
+        if (stat(roots[i], &st) != 0) {
+            continue;
+        }
+        if (S_ISDIR(st.st_mode)) {
+            path_list_push_owned(&job.dirs, kolibri_strdup(roots[i]));
+        } else if (S_ISREG(st.st_mode) && is_markdown_file(roots[i])) {
+            file_list_push(&job.files, roots[i], &st);
+        }
+    }
+    if (job.dirs.count > 0U) {
+        run_workers(crawl_worker, &job, threads);
+    }
+    free(job.dirs.items);
+    pthread_cond_destroy(&job.wake);
+    pthread_mutex_destroy(&job.lock);
+
+    FileList files = job.files;
+    if (files.count > 1U) {
+        qsort(files.items, files.count, sizeof(FileEntry), file_entry_compare);
+        size_t kept = 1U;
+        for (size_t i = 1; i < files.count; ++i) {
+            if (strcmp(files.items[i].path, files.items[kept - 1U].path) == 0) {
+                free(files.items[i].path);
+                continue;
             }
+            files.items[kept++] = files.items[i];
         }
-        closedir(dir);
-    } else if (is_markdown_file(root)) {
-        path_list_push(list, root);
+        files.count = kept;
     }
+    *out = files;
 }
 
-static char *read_file_utf8(const char *path) {
+static char *read_file_utf8(const char *path, size_t *out_length) {
     FILE *file = fopen(path, "rb");
     if (!file) {
         return NULL;
@@ -166,6 +448,9 @@ static char *read_file_utf8(const char *path) {
     size_t read = fread(buffer, 1, (size_t)size, file);
     fclose(file);
     buffer[read] = '\0';
+    if (out_length) {
+        *out_length = read;
+    }
     return buffer;
 }
 
@@ -235,300 +520,914 @@ static char *shorten_content(const char *content, size_t max_length) {
     return result;
 }
 
-static void doc_token_list_add(DocToken **tokens, size_t *count, size_t *capacity, const char *token) {
-    for (size_t i = 0; i < *count; ++i) {
-        if (strcmp((*tokens)[i].token, token) == 0) {
-            (*tokens)[i].count += 1U;
-            return;
-        }
+/* Per-worker term counter, reused across files */
+typedef struct {
+    DocToken *tokens;
+    size_t count;
+    size_t capacity;
+    TokenMap map;
+} TermCounter;
+
+static void term_counter_add(TermCounter *counter, const char *token) {
+    size_t idx = token_map_find(&counter->map, token);
+    if (idx != (size_t)-1) {
+        counter->tokens[idx].count += 1U;
+        return;
     }
-    if (*count == *capacity) {
-        size_t new_cap = (*capacity == 0U) ? 16U : (*capacity * 2U);
-        DocToken *new_tokens = (DocToken *)realloc(*tokens, new_cap * sizeof(DocToken));
-        if (!new_tokens) {
-            fprintf(stderr, "[kolibri-knowledge] realloc doc tokens failed\n");
-            abort();
-        }
-        *tokens = new_tokens;
-        *capacity = new_cap;
+    if (counter->count == counter->capacity) {
+        counter->capacity = counter->capacity == 0U ? 16U : counter->capacity * 2U;
+        counter->tokens = (DocToken *)kolibri_realloc(counter->tokens, counter->capacity * sizeof(DocToken));
     }
-    (*tokens)[*count].token = kolibri_strdup(token);
-    (*tokens)[*count].count = 1U;
-    *count += 1U;
+    DocToken *entry = &counter->tokens[counter->count];
+    entry->token = kolibri_strdup(token);
+    entry->count = 1U;
+    token_map_put(&counter->map, entry->token, counter->count);
+    counter->count += 1U;
 }
 
-static void global_register_tokens(GlobalToken **tokens, size_t *count, size_t *capacity, DocToken *doc_tokens, size_t doc_count) {
-    for (size_t i = 0; i < doc_count; ++i) {
-        const char *token = doc_tokens[i].token;
-        size_t j;
-        for (j = 0; j < *count; ++j) {
-            if (strcmp((*tokens)[j].token, token) == 0) {
-                (*tokens)[j].df += 1U;
-                break;
+static void parse_markdown_document(FileEntry *entry,
+                                    char *content,
+                                    size_t max_length,
+                                    TermCounter *counter) {
+    entry->title = extract_title(content);
+    entry->content = shorten_content(content, max_length);
+    if (!entry->content) {
+        entry->content = kolibri_strdup(content);
+    }
+    entry->id = derive_id_from_path(entry->path);
+
+    counter->tokens = NULL;
+    counter->count = 0U;
+    counter->capacity = 0U;
+    token_map_clear(&counter->map);
+
+    char buffer[128];
+    size_t buffer_len = 0U;
+    const unsigned char *cursor = (const unsigned char *)content;
+    while (*cursor != '\0') {
+        if (isalnum(*cursor)) {
+            if (buffer_len < sizeof(buffer) - 1U) {
+                buffer[buffer_len++] = (char)tolower(*cursor);
             }
-        }
-        if (j == *count) {
-            if (*count == *capacity) {
-                size_t new_cap = (*capacity == 0U) ? 64U : (*capacity * 2U);
-                GlobalToken *new_tokens = (GlobalToken *)realloc(*tokens, new_cap * sizeof(GlobalToken));
-                if (!new_tokens) {
-                    fprintf(stderr, "[kolibri-knowledge] realloc global tokens failed\n");
-                    abort();
-                }
-                *tokens = new_tokens;
-                *capacity = new_cap;
+        } else {
+            if (buffer_len > 0U) {
+                buffer[buffer_len] = '\0';
+                term_counter_add(counter, buffer);
+                buffer_len = 0U;
             }
-            (*tokens)[*count].token = kolibri_strdup(token);
-            (*tokens)[*count].df = 1U;
-            (*tokens)[*count].idf = 0.0f;
-            *count += 1U;
         }
+        cursor++;
     }
+    if (buffer_len > 0U) {
+        buffer[buffer_len] = '\0';
+        term_counter_add(counter, buffer);
+    }
+    entry->tokens = counter->tokens;
+    entry->token_count = counter->count;
 }
 
-static void free_doc_tokens(DocToken *tokens, size_t count) {
-    for (size_t i = 0; i < count; ++i) {
-        free(tokens[i].token);
+typedef struct {
+    FileEntry *files;
+    size_t count;
+    size_t max_length;
+    const Document *documents;
+    atomic_size_t next;
+} ParseJob;
+
+static void *parse_worker(void *arg) {
+    ParseJob *job = (ParseJob *)arg;
+    TermCounter counter;
+    memset(&counter, 0, sizeof(counter));
+    for (;;) {
+        size_t i = atomic_fetch_add(&job->next, 1);
+        if (i >= job->count) {
+            break;
+        }
+        FileEntry *entry = &job->files[i];
+        if (entry->state != FILE_PENDING) {
+            continue;
+        }
+        size_t length = 0U;
+        char *content = read_file_utf8(entry->path, &length);
+        if (!content) {
+            entry->state = FILE_FAILED;
+            continue;
+        }
+        entry->hash = fnv1a64(FNV64_BASIS, content, length);
+        /* Same bytes under a new mtime: keep the document as is */
+        if (entry->doc != (size_t)-1 && job->documents[entry->doc].hash == entry->hash) {
+            entry->state = FILE_TOUCHED;
+        } else {
+            parse_markdown_document(entry, content, job->max_length, &counter);
+            entry->state = FILE_PARSED;
+        }
+        free(content);
     }
-    free(tokens);
+    token_map_free(&counter.map);
+    return NULL;
 }
 
-static void compute_idf(GlobalToken *tokens, size_t token_count, size_t total_docs) {
-    for (size_t i = 0; i < token_count; ++i) {
-        tokens[i].idf = (float)(log((1.0 + (double)total_docs) / (1.0 + (double)tokens[i].df)) + 1.0);
+static KolibriKnowledgeIndex *knowledge_index_new(void) {
+    return (KolibriKnowledgeIndex *)kolibri_alloc(sizeof(KolibriKnowledgeIndex));
+}
+
+static void index_mark_token(KolibriKnowledgeIndex *index, size_t token) {
+    GlobalToken *entry = &index->tokens[token];
+    if (entry->dirty) {
+        return;
     }
+    entry->dirty = 1;
+    if (index->dirty_count == index->dirty_capacity) {
+        index->dirty_capacity = index->dirty_capacity == 0U ? 64U : index->dirty_capacity * 2U;
+        index->dirty_tokens = (size_t *)kolibri_realloc(index->dirty_tokens,
+                                                        index->dirty_capacity * sizeof(size_t));
+    }
+    index->dirty_tokens[index->dirty_count++] = token;
 }
 
-static size_t find_global_token(const GlobalToken *tokens, size_t token_count, const char *token) {
-    for (size_t i = 0; i < token_count; ++i) {
-        if (strcmp(tokens[i].token, token) == 0) {
-            return i;
-        }
+static size_t index_intern_token(KolibriKnowledgeIndex *index, const char *token) {
+    size_t idx = token_map_find(&index->token_map, token);
+    if (idx != (size_t)-1) {
+        return idx;
+    }
+    if (index->token_count == index->token_capacity) {
+        index->token_capacity = index->token_capacity == 0U ? 64U : index->token_capacity * 2U;
+        index->tokens = (GlobalToken *)kolibri_realloc(index->tokens,
+                                                       index->token_capacity * sizeof(GlobalToken));
+    }
+    idx = index->token_count++;
+    GlobalToken *entry = &index->tokens[idx];
+    memset(entry, 0, sizeof(*entry));
+    entry->token = kolibri_strdup(token);
+    token_map_put(&index->token_map, entry->token, idx);
+    return idx;
+}
+
+static void posting_add(KolibriKnowledgeIndex *index, size_t token, size_t doc) {
+    GlobalToken *entry = &index->tokens[token];
+    if (entry->df == entry->doc_capacity) {
+        entry->doc_capacity = entry->doc_capacity == 0U ? 4U : entry->doc_capacity * 2U;
+        entry->docs = (size_t *)kolibri_realloc(entry->docs, entry->doc_capacity * sizeof(size_t));
     }
-    return (size_t)-1;
+    entry->docs[entry->df++] = doc;
+    index_mark_token(index, token);
 }
 
-static int vector_compare(const void *a, const void *b) {
-    const KolibriKnowledgeVectorItem *va = (const KolibriKnowledgeVectorItem *)a;
-    const KolibriKnowledgeVectorItem *vb = (const KolibriKnowledgeVectorItem *)b;
-    if (va->weight > vb->weight) {
-        return -1;
+static void posting_remove(KolibriKnowledgeIndex *index, size_t token, size_t doc) {
+    GlobalToken *entry = &index->tokens[token];
+    for (size_t i = 0; i < entry->df; ++i) {
+        if (entry->docs[i] == doc) {
+            entry->docs[i] = entry->docs[--entry->df];
+            break;
+        }
     }
-    if (va->weight < vb->weight) {
-        return 1;
+    index_mark_token(index, token);
+}
+
+static void posting_replace(GlobalToken *entry, size_t from, size_t to) {
+    for (size_t i = 0; i < entry->df; ++i) {
+        if (entry->docs[i] == from) {
+            entry->docs[i] = to;
+            return;
+        }
     }
-    return 0;
 }
 
-static KolibriKnowledgeIndex *knowledge_index_new(void) {
-    KolibriKnowledgeIndex *index = (KolibriKnowledgeIndex *)kolibri_alloc(sizeof(KolibriKnowledgeIndex));
-    index->documents = NULL;
-    index->document_count = 0U;
-    index->tokens = NULL;
-    index->token_count = 0U;
-    index->token_capacity = 0U;
-    return index;
+static int doc_term_compare(const void *a, const void *b) {
+    const DocTerm *ta = (const DocTerm *)a;
+    const DocTerm *tb = (const DocTerm *)b;
+    return (ta->token > tb->token) - (ta->token < tb->token);
 }
 
-static int parse_markdown_document(const char *path,
-                                   size_t max_length,
-                                   Document *out_doc,
-                                   DocToken **out_tokens,
-                                   size_t *out_token_count) {
-    char *content = read_file_utf8(path);
-    if (!content) {
-        return -1;
+static DocTerm *index_intern_terms(KolibriKnowledgeIndex *index, const DocToken *tokens, size_t count) {
+    if (count == 0U) {
+        return NULL;
     }
-
-    char *title = extract_title(content);
-    char *short_content = shorten_content(content, max_length);
-    if (!short_content) {
-        short_content = kolibri_strdup(content);
+    DocTerm *terms = (DocTerm *)kolibri_alloc(count * sizeof(DocTerm));
+    for (size_t i = 0; i < count; ++i) {
+        terms[i].token = index_intern_token(index, tokens[i].token);
+        terms[i].count = tokens[i].count;
     }
+    qsort(terms, count, sizeof(DocTerm), doc_term_compare);
+    return terms;
+}
 
-    DocToken *doc_tokens = NULL;
-    size_t token_count = 0U;
-    size_t token_capacity = 0U;
-    size_t total_tokens = 0U;
-
-    char buffer[128];
-    size_t buffer_len = 0U;
-    const unsigned char *cursor = (const unsigned char *)content;
-    while (*cursor != '\0') {
-        if (isalnum(*cursor)) {
-            if (buffer_len < sizeof(buffer) - 1U) {
-                buffer[buffer_len++] = (char)tolower(*cursor);
-            }
+/* Updates postings for the tokens that entered or left the document */
+static void index_diff_terms(KolibriKnowledgeIndex *index,
+                             size_t doc,
+                             const DocTerm *old_terms,
+                             size_t old_count,
+                             const DocTerm *new_terms,
+                             size_t new_count) {
+    size_t i = 0U;
+    size_t j = 0U;
+    while (i < old_count || j < new_count) {
+        if (j == new_count || (i < old_count && old_terms[i].token < new_terms[j].token)) {
+            posting_remove(index, old_terms[i++].token, doc);
+        } else if (i == old_count || new_terms[j].token < old_terms[i].token) {
+            posting_add(index, new_terms[j++].token, doc);
         } else {
-            if (buffer_len > 0U) {
-                buffer[buffer_len] = '\0';
-                doc_token_list_add(&doc_tokens, &token_count, &token_capacity, buffer);
-                total_tokens += 1U;
-                buffer_len = 0U;
-            }
+            i++;
+            j++;
         }
-        cursor++;
     }
-    if (buffer_len > 0U) {
-        buffer[buffer_len] = '\0';
-        doc_token_list_add(&doc_tokens, &token_count, &token_capacity, buffer);
-        total_tokens += 1U;
+}
+
+static void document_free(Document *doc) {
+    free(doc->id);
+    free(doc->title);
+    free(doc->source);
+    free(doc->content);
+    free(doc->vector);
+    free(doc->terms);
+}
+
+static void index_remove_document(KolibriKnowledgeIndex *index, size_t doc) {
+    Document *removed = &index->documents[doc];
+    for (size_t i = 0; i < removed->term_count; ++i) {
+        posting_remove(index, removed->terms[i].token, doc);
+    }
+    document_free(removed);
+    size_t last = index->document_count - 1U;
+    if (doc != last) {
+        index->documents[doc] = index->documents[last];
+        const Document *moved = &index->documents[doc];
+        for (size_t i = 0; i < moved->term_count; ++i) {
+            posting_replace(&index->tokens[moved->terms[i].token], last, doc);
+        }
     }
+    index->document_count = last;
+}
 
-    free(content);
+static void index_rebuild_paths(KolibriKnowledgeIndex *index) {
+    token_map_clear(&index->path_map);
+    for (size_t i = 0; i < index->document_count; ++i) {
+        token_map_put(&index->path_map, index->documents[i].source, i);
+    }
+}
 
-    out_doc->id = derive_id_from_path(path);
-    out_doc->title = title;
-    out_doc->source = kolibri_strdup(path);
-    out_doc->content = short_content;
-    out_doc->vector = NULL;
-    out_doc->vector_size = 0U;
-    out_doc->norm = 0.0f;
+static float token_idf(size_t df, size_t total_docs) {
+    return (float)(log((1.0 + (double)total_docs) / (1.0 + (double)df)) + 1.0);
+}
 
-    *out_tokens = doc_tokens;
-    *out_token_count = token_count;
-    return (int)total_tokens;
+typedef struct {
+    KolibriKnowledgeVectorItem item;
+    const char *token;
+} RankedTerm;
+
+/* Ties are broken by token text so the top terms do not depend on the
+ * order in which tokens were first seen. */
+static int ranked_term_compare(const void *a, const void *b) {
+    const RankedTerm *ra = (const RankedTerm *)a;
+    const RankedTerm *rb = (const RankedTerm *)b;
+    if (ra->item.weight > rb->item.weight) {
+        return -1;
+    }
+    if (ra->item.weight < rb->item.weight) {
+        return 1;
+    }
+    return strcmp(ra->token, rb->token);
 }
 
-static void compute_document_vector(const GlobalToken *tokens,
-                                    size_t token_count,
-                                    const DocToken *doc_tokens,
-                                    size_t doc_token_count,
-                                    size_t total_docs,
-                                    Document *doc) {
-    if (doc_token_count == 0U) {
+static void compute_document_vector(const GlobalToken *tokens, Document *doc) {
+    free(doc->vector);
+    doc->vector = NULL;
+    doc->vector_size = 0U;
+    doc->norm = 0.0f;
+    if (doc->term_count == 0U) {
         return;
     }
     double total_terms = 0.0;
-    for (size_t i = 0; i < doc_token_count; ++i) {
-        total_terms += (double)doc_tokens[i].count;
+    for (size_t i = 0; i < doc->term_count; ++i) {
+        total_terms += (double)doc->terms[i].count;
     }
 
-    KolibriKnowledgeVectorItem *vector = NULL;
-    size_t vector_count = 0U;
-
-    vector = (KolibriKnowledgeVectorItem *)malloc(doc_token_count * sizeof(KolibriKnowledgeVectorItem));
-    if (!vector) {
+    RankedTerm *ranked = (RankedTerm *)malloc(doc->term_count * sizeof(RankedTerm));
+    if (!ranked) {
         fprintf(stderr, "[kolibri-knowledge] alloc vector failed\n");
         abort();
     }
-
     double norm = 0.0;
-    for (size_t i = 0; i < doc_token_count; ++i) {
-        size_t token_index = find_global_token(tokens, token_count, doc_tokens[i].token);
-        if (token_index == (size_t)-1) {
-            continue;
-        }
-        double tf = (double)doc_tokens[i].count / total_terms;
-        double weight = tf * (double)tokens[token_index].idf;
-        vector[vector_count].token_index = token_index;
-        vector[vector_count].weight = (float)weight;
+    for (size_t i = 0; i < doc->term_count; ++i) {
+        const GlobalToken *token = &tokens[doc->terms[i].token];
+        double tf = (double)doc->terms[i].count / total_terms;
+        double weight = tf * (double)token->idf;
+        ranked[i].item.token_index = doc->terms[i].token;
+        ranked[i].item.weight = (float)weight;
+        ranked[i].token = token->token;
         norm += weight * weight;
-        vector_count += 1U;
     }
 
-    if (vector_count == 0U) {
-        free(vector);
-        doc->vector = NULL;
-        doc->vector_size = 0U;
-        doc->norm = 0.0f;
-        return;
-    }
-
-    qsort(vector, vector_count, sizeof(KolibriKnowledgeVectorItem), vector_compare);
-    if (vector_count > KOLIBRI_TOP_TERMS) {
-        vector_count = KOLIBRI_TOP_TERMS;
-    }
+    qsort(ranked, doc->term_count, sizeof(RankedTerm), ranked_term_compare);
+    size_t vector_count = doc->term_count < KOLIBRI_TOP_TERMS ? doc->term_count : KOLIBRI_TOP_TERMS;
 
     doc->vector = (KolibriKnowledgeVectorItem *)malloc(vector_count * sizeof(KolibriKnowledgeVectorItem));
     if (!doc->vector) {
         fprintf(stderr, "[kolibri-knowledge] alloc doc vector failed\n");
         abort();
     }
-    memcpy(doc->vector, vector, vector_count * sizeof(KolibriKnowledgeVectorItem));
-    free(vector);
+    for (size_t i = 0; i < vector_count; ++i) {
+        doc->vector[i] = ranked[i].item;
+    }
+    free(ranked);
 
     doc->vector_size = vector_count;
     doc->norm = (float)(sqrt(norm) ?: 1e-6);
 }
 
-int kolibri_knowledge_index_create(const char *const *roots,
-                                   size_t root_count,
-                                   size_t max_length,
-                                   KolibriKnowledgeIndex **out_index) {
-    if (!roots || root_count == 0U || !out_index) {
-        return EINVAL;
+typedef struct {
+    KolibriKnowledgeIndex *index;
+    const size_t *docs;
+    size_t count;
+    atomic_size_t next;
+} VectorJob;
+
+static void *vector_worker(void *arg) {
+    VectorJob *job = (VectorJob *)arg;
+    for (;;) {
+        size_t start = atomic_fetch_add(&job->next, KOLIBRI_VECTOR_CHUNK);
+        if (start >= job->count) {
+            break;
+        }
+        size_t end = start + KOLIBRI_VECTOR_CHUNK < job->count ? start + KOLIBRI_VECTOR_CHUNK : job->count;
+        for (size_t i = start; i < end; ++i) {
+            compute_document_vector(job->index->tokens, &job->index->documents[job->docs[i]]);
+        }
     }
+    return NULL;
+}
 
-    PathList paths;
-    path_list_init(&paths);
-    for (size_t i = 0; i < root_count; ++i) {
-        collect_markdown_files(roots[i], &paths);
+/* Recomputes IDF and vectors after postings changed. When the document
+ * count is unchanged only the touched tokens get a new IDF and only the
+ * documents containing them are re-weighted; otherwise every IDF moves. */
+static size_t index_update_weights(KolibriKnowledgeIndex *index, int all) {
+    size_t *docs = (size_t *)malloc((index->document_count + 1U) * sizeof(size_t));
+    if (!docs) {
+        fprintf(stderr, "[kolibri-knowledge] alloc update list failed\n");
+        abort();
     }
-    if (paths.count == 0U) {
-        path_list_free(&paths);
-        *out_index = NULL;
-        return ENOENT;
+    size_t count = 0U;
+    if (all) {
+        for (size_t i = 0; i < index->token_count; ++i) {
+            index->tokens[i].idf = token_idf(index->tokens[i].df, index->document_count);
+        }
+        for (size_t i = 0; i < index->document_count; ++i) {
+            docs[count++] = i;
+        }
+    } else {
+        for (size_t i = 0; i < index->dirty_count; ++i) {
+            GlobalToken *token = &index->tokens[index->dirty_tokens[i]];
+            token->idf = token_idf(token->df, index->document_count);
+            for (size_t j = 0; j < token->df; ++j) {
+                index->documents[token->docs[j]].dirty = 1;
+            }
+        }
+        for (size_t i = 0; i < index->document_count; ++i) {
+            if (index->documents[i].dirty) {
+                docs[count++] = i;
+            }
+        }
+    }
+    for (size_t i = 0; i < index->dirty_count; ++i) {
+        index->tokens[index->dirty_tokens[i]].dirty = 0;
     }
+    index->dirty_count = 0U;
+    for (size_t i = 0; i < count; ++i) {
+        index->documents[docs[i]].dirty = 0;
+    }
+
+    VectorJob job;
+    job.index = index;
+    job.docs = docs;
+    job.count = count;
+    atomic_init(&job.next, 0);
+    size_t chunks = (count + KOLIBRI_VECTOR_CHUNK - 1U) / KOLIBRI_VECTOR_CHUNK;
+    run_workers(vector_worker, &job, chunks < index->threads ? chunks : index->threads);
+    free(docs);
+    return count;
+}
 
-    KolibriKnowledgeIndex *index = knowledge_index_new();
-    index->documents = (Document *)kolibri_alloc(paths.count * sizeof(Document));
-    index->document_count = paths.count;
+/* Drops tokens no document uses any more so the table matches a fresh
+ * build. Indices keep their order, so sorted term lists stay sorted. */
+static void index_compact_tokens(KolibriKnowledgeIndex *index) {
+    size_t live = 0U;
+    for (size_t i = 0; i < index->token_count; ++i) {
+        live += index->tokens[i].df > 0U;
+    }
+    if (live == index->token_count) {
+        return;
+    }
+    size_t *remap = (size_t *)kolibri_alloc((index->token_count + 1U) * sizeof(size_t));
+    live = 0U;
+    for (size_t i = 0; i < index->token_count; ++i) {
+        GlobalToken *token = &index->tokens[i];
+        if (token->df == 0U) {
+            free(token->token);
+            free(token->docs);
+            continue;
+        }
+        remap[i] = live;
+        index->tokens[live++] = *token;
+    }
+    index->token_count = live;
+    for (size_t i = 0; i < index->document_count; ++i) {
+        Document *doc = &index->documents[i];
+        for (size_t j = 0; j < doc->term_count; ++j) {
+            doc->terms[j].token = remap[doc->terms[j].token];
+        }
+        for (size_t j = 0; j < doc->vector_size; ++j) {
+            doc->vector[j].token_index = remap[doc->vector[j].token_index];
+        }
+    }
+    free(remap);
+    token_map_clear(&index->token_map);
+    for (size_t i = 0; i < index->token_count; ++i) {
+        token_map_put(&index->token_map, index->tokens[i].token, i);
+    }
+}
+
+static void index_apply_file(KolibriKnowledgeIndex *index, FileEntry *entry) {
+    Document *doc;
+    size_t doc_index = entry->doc;
+    if (doc_index == (size_t)-1) {
+        if (index->document_count == index->document_capacity) {
+            index->document_capacity = index->document_capacity == 0U ? 64U : index->document_capacity * 2U;
+            index->documents = (Document *)kolibri_realloc(index->documents,
+                                                           index->document_capacity * sizeof(Document));
+        }
+        doc_index = index->document_count++;
+        doc = &index->documents[doc_index];
+        memset(doc, 0, sizeof(*doc));
+        doc->source = entry->path;
+        entry->path = NULL;
+        token_map_put(&index->path_map, doc->source, doc_index);
+    } else {
+        doc = &index->documents[doc_index];
+        free(doc->id);
+        free(doc->title);
+        free(doc->content);
+    }
+    DocTerm *terms = index_intern_terms(index, entry->tokens, entry->token_count);
+    /* Interning grows only the token table, so doc stays valid */
+    index_diff_terms(index, doc_index, doc->terms, doc->term_count, terms, entry->token_count);
+    free(doc->terms);
+    doc->terms = terms;
+    doc->term_count = entry->token_count;
+    doc->id = entry->id;
+    doc->title = entry->title;
+    doc->content = entry->content;
+    doc->mtime_ns = entry->mtime_ns;
+    doc->size = entry->size;
+    doc->hash = entry->hash;
+    doc->dirty = 1;
+    entry->id = NULL;
+    entry->title = NULL;
+    entry->content = NULL;
+}
+
+static int knowledge_index_sync(KolibriKnowledgeIndex *index, int rebuild_all, KolibriKnowledgeBuildStats *stats) {
+    KolibriKnowledgeBuildStats local;
+    memset(&local, 0, sizeof(local));
+
+    FileList files;
+    crawl_roots(index->roots, index->root_count, index->threads, &files);
+    local.files_seen = files.count;
+
+    size_t old_count = index->document_count;
+    size_t *file_of_doc = (size_t *)malloc((old_count + 1U) * sizeof(size_t));
+    if (!file_of_doc) {
+        file_list_free(&files);
+        return ENOMEM;
+    }
+    for (size_t i = 0; i < old_count; ++i) {
+        file_of_doc[i] = (size_t)-1;
+    }
+    for (size_t i = 0; i < files.count; ++i) {
+        FileEntry *entry = &files.items[i];
+        size_t doc = token_map_find(&index->path_map, entry->path);
+        if (doc == (size_t)-1) {
+            continue;
+        }
+        entry->doc = doc;
+        file_of_doc[doc] = i;
+        const Document *existing = &index->documents[doc];
+        if (existing->mtime_ns == entry->mtime_ns && existing->size == entry->size) {
+            entry->state = FILE_UNCHANGED;
+        }
+    }
+
+    ParseJob job;
+    job.files = files.items;
+    job.count = files.count;
+    job.max_length = index->max_length;
+    job.documents = index->documents;
+    atomic_init(&job.next, 0);
+    run_workers(parse_worker, &job, files.count < index->threads ? files.count : index->threads);
+
+    for (size_t i = 0; i < files.count; ++i) {
+        if (files.items[i].state == FILE_FAILED && files.items[i].doc != (size_t)-1) {
+            file_of_doc[files.items[i].doc] = (size_t)-1;
+        }
+    }
+    /* From the top down: the document swapped into a freed slot is always kept */
+    for (size_t doc = old_count; doc-- > 0U;) {
+        if (file_of_doc[doc] != (size_t)-1) {
+            continue;
+        }
+        size_t last = index->document_count - 1U;
+        index_remove_document(index, doc);
+        if (doc != last) {
+            file_of_doc[doc] = file_of_doc[last];
+            files.items[file_of_doc[doc]].doc = doc;
+        }
+        local.files_removed++;
+    }
+    free(file_of_doc);
+    if (local.files_removed > 0U) {
+        index_rebuild_paths(index);
+    }
+
+    for (size_t i = 0; i < files.count; ++i) {
+        FileEntry *entry = &files.items[i];
+        switch (entry->state) {
+        case FILE_PARSED:
+            index_apply_file(index, entry);
+            local.files_parsed++;
+            break;
+        case FILE_TOUCHED:
+            index->documents[entry->doc].mtime_ns = entry->mtime_ns;
+            index->documents[entry->doc].size = entry->size;
+            local.files_unchanged++;
+            break;
+        case FILE_UNCHANGED:
+            local.files_unchanged++;
+            break;
+        default:
+            break;
+        }
+    }
+    file_list_free(&files);
+
+    local.vectors_updated =
+        index_update_weights(index, rebuild_all || index->document_count != old_count);
+    index_compact_tokens(index);
+    if (stats) {
+        *stats = local;
+    }
+    return 0;
+}
+
+typedef struct {
+    unsigned char *data;
+    size_t length;
+    size_t capacity;
+} ManifestWriter;
+
+static void manifest_put(ManifestWriter *writer, const void *data, size_t length) {
+    if (writer->length + length > writer->capacity) {
+        size_t capacity = writer->capacity == 0U ? 4096U : writer->capacity;
+        while (capacity < writer->length + length) {
+            capacity *= 2U;
+        }
+        writer->data = (unsigned char *)kolibri_realloc(writer->data, capacity);
+        writer->capacity = capacity;
+    }
+    memcpy(writer->data + writer->length, data, length);
+    writer->length += length;
+}
 
-    GlobalToken *global_tokens = NULL;
-    size_t global_token_count = 0U;
-    size_t global_token_capacity = 0U;
+static void manifest_put_u32(ManifestWriter *writer, uint32_t value) {
+    manifest_put(writer, &value, sizeof(value));
+}
 
-    DocToken **all_doc_tokens = (DocToken **)kolibri_alloc(paths.count * sizeof(DocToken *));
-    size_t *doc_token_counts = (size_t *)kolibri_alloc(paths.count * sizeof(size_t));
+static void manifest_put_u64(ManifestWriter *writer, uint64_t value) {
+    manifest_put(writer, &value, sizeof(value));
+}
 
-    for (size_t i = 0; i < paths.count; ++i) {
-        size_t doc_token_count = 0U;
-        DocToken *doc_tokens = NULL;
-        int total_tokens = parse_markdown_document(paths.items[i], max_length, &index->documents[i], &doc_tokens, &doc_token_count);
-        (void)total_tokens;
-        all_doc_tokens[i] = doc_tokens;
-        doc_token_counts[i] = doc_token_count;
-        if (doc_token_count > 0U) {
-            global_register_tokens(&global_tokens, &global_token_count, &global_token_capacity, doc_tokens, doc_token_count);
+static void manifest_put_string(ManifestWriter *writer, const char *text) {
+    uint32_t length = text ? (uint32_t)strlen(text) : 0U;
+    manifest_put_u32(writer, length);
+    manifest_put(writer, text ? text : "", length);
+}
+
+/* Layout: magic, version, max_length, token and document counts, tokens
+ * (text, idf), documents (path, id, title, content, mtime, size, hash,
+ * terms, vector, norm), then an FNV-1a 64 checksum of everything above.
+ * Tokens no document uses any more are dropped and indices renumbered. */
+int kolibri_knowledge_index_save_manifest(const KolibriKnowledgeIndex *index, const char *path) {
+    if (!index || !path) {
+        return EINVAL;
+    }
+    uint32_t *remap = (uint32_t *)malloc((index->token_count + 1U) * sizeof(uint32_t));
+    if (!remap) {
+        return ENOMEM;
+    }
+    uint64_t live = 0U;
+    for (size_t i = 0; i < index->token_count; ++i) {
+        remap[i] = (uint32_t)live;
+        live += index->tokens[i].df > 0U;
+    }
+
+    ManifestWriter writer = {NULL, 0U, 0U};
+    manifest_put_u32(&writer, KOLIBRI_MANIFEST_MAGIC);
+    manifest_put_u32(&writer, KOLIBRI_MANIFEST_VERSION);
+    manifest_put_u64(&writer, (uint64_t)index->max_length);
+    manifest_put_u64(&writer, live);
+    manifest_put_u64(&writer, (uint64_t)index->document_count);
+    for (size_t i = 0; i < index->token_count; ++i) {
+        if (index->tokens[i].df == 0U) {
+            continue;
         }
+        manifest_put_string(&writer, index->tokens[i].token);
+        manifest_put(&writer, &index->tokens[i].idf, sizeof(float));
     }
+    for (size_t i = 0; i < index->document_count; ++i) {
+        const Document *doc = &index->documents[i];
+        manifest_put_string(&writer, doc->source);
+        manifest_put_string(&writer, doc->id);
+        manifest_put_string(&writer, doc->title);
+        manifest_put_string(&writer, doc->content);
+        manifest_put_u64(&writer, (uint64_t)doc->mtime_ns);
+        manifest_put_u64(&writer, doc->size);
+        manifest_put_u64(&writer, doc->hash);
+        manifest_put_u32(&writer, (uint32_t)doc->term_count);
+        for (size_t j = 0; j < doc->term_count; ++j) {
+            manifest_put_u32(&writer, remap[doc->terms[j].token]);
+            manifest_put_u32(&writer, (uint32_t)doc->terms[j].count);
+        }
+        manifest_put_u32(&writer, (uint32_t)doc->vector_size);
+        for (size_t j = 0; j < doc->vector_size; ++j) {
+            manifest_put_u32(&writer, remap[doc->vector[j].token_index]);
+            manifest_put(&writer, &doc->vector[j].weight, sizeof(float));
+        }
+        manifest_put(&writer, &doc->norm, sizeof(float));
+    }
+    free(remap);
+    manifest_put_u64(&writer, fnv1a64(FNV64_BASIS, writer.data, writer.length));
 
-    compute_idf(global_tokens, global_token_count, index->document_count);
+    char tmp[4096];
+    if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp)) {
+        free(writer.data);
+        return ENAMETOOLONG;
+    }
+    FILE *file = fopen(tmp, "wb");
+    if (!file) {
+        int err = errno;
+        free(writer.data);
+        return err;
+    }
+    int ok = fwrite(writer.data, 1U, writer.length, file) == writer.length;
+    ok = fflush(file) == 0 && ok;
+    ok = fsync(fileno(file)) == 0 && ok;
+    ok = fclose(file) == 0 && ok;
+    free(writer.data);
+    if (!ok || rename(tmp, path) != 0) {
+        int err = errno ? errno : EIO;
+        unlink(tmp);
+        return err;
+    }
+    return 0;
+}
 
-    index->tokens = global_tokens;
-    index->token_count = global_token_count;
-    index->token_capacity = global_token_capacity;
+typedef struct {
+    const unsigned char *cursor;
+    const unsigned char *end;
+    int failed;
+} ManifestReader;
+
+static void manifest_get(ManifestReader *reader, void *out, size_t length) {
+    if (reader->failed || (size_t)(reader->end - reader->cursor) < length) {
+        reader->failed = 1;
+        memset(out, 0, length);
+        return;
+    }
+    memcpy(out, reader->cursor, length);
+    reader->cursor += length;
+}
+
+static uint32_t manifest_get_u32(ManifestReader *reader) {
+    uint32_t value;
+    manifest_get(reader, &value, sizeof(value));
+    return value;
+}
+
+static uint64_t manifest_get_u64(ManifestReader *reader) {
+    uint64_t value;
+    manifest_get(reader, &value, sizeof(value));
+    return value;
+}
+
+static char *manifest_get_string(ManifestReader *reader) {
+    uint32_t length = manifest_get_u32(reader);
+    if (reader->failed || (size_t)(reader->end - reader->cursor) < length) {
+        reader->failed = 1;
+        return NULL;
+    }
+    char *text = (char *)kolibri_alloc((size_t)length + 1U);
+    memcpy(text, reader->cursor, length);
+    reader->cursor += length;
+    return text;
+}
 
-    for (size_t i = 0; i < paths.count; ++i) {
-        compute_document_vector(global_tokens, global_token_count, all_doc_tokens[i], doc_token_counts[i], index->document_count, &index->documents[i]);
-        free_doc_tokens(all_doc_tokens[i], doc_token_counts[i]);
+/* Returns NULL when the manifest is missing, damaged or was built with
+ * another max_length: the caller then indexes from scratch. */
+static KolibriKnowledgeIndex *knowledge_index_load_manifest(const char *path, size_t max_length) {
+    size_t length = 0U;
+    char *data = read_file_utf8(path, &length);
+    if (!data) {
+        return NULL;
+    }
+    if (length < 40U) {
+        free(data);
+        return NULL;
+    }
+    uint64_t checksum;
+    memcpy(&checksum, data + length - sizeof(checksum), sizeof(checksum));
+    ManifestReader reader = {(const unsigned char *)data,
+                             (const unsigned char *)data + length - sizeof(checksum), 0};
+    if (fnv1a64(FNV64_BASIS, data, length - sizeof(checksum)) != checksum ||
+        manifest_get_u32(&reader) != KOLIBRI_MANIFEST_MAGIC ||
+        manifest_get_u32(&reader) != KOLIBRI_MANIFEST_VERSION ||
+        manifest_get_u64(&reader) != (uint64_t)max_length) {
+        free(data);
+        return NULL;
+    }
+    uint64_t token_count = manifest_get_u64(&reader);
+    uint64_t document_count = manifest_get_u64(&reader);
+    /* Every entry takes at least a few bytes: reject absurd counts early */
+    size_t remaining = (size_t)(reader.end - reader.cursor);
+    if (token_count > remaining || document_count > remaining) {
+        free(data);
+        return NULL;
+    }
+
+    KolibriKnowledgeIndex *index = knowledge_index_new();
+    for (uint64_t i = 0; i < token_count && !reader.failed; ++i) {
+        char *token = manifest_get_string(&reader);
+        float idf;
+        manifest_get(&reader, &idf, sizeof(idf));
+        if (reader.failed || token_map_find(&index->token_map, token) != (size_t)-1) {
+            free(token);
+            reader.failed = 1;
+            break;
+        }
+        size_t idx = index_intern_token(index, token);
+        index->tokens[idx].idf = idf;
+        free(token);
+    }
+    if (!reader.failed && document_count > 0U) {
+        index->documents = (Document *)kolibri_alloc((size_t)document_count * sizeof(Document));
+        index->document_capacity = (size_t)document_count;
+    }
+    for (uint64_t i = 0; i < document_count && !reader.failed; ++i) {
+        Document *doc = &index->documents[index->document_count++];
+        doc->source = manifest_get_string(&reader);
+        doc->id = manifest_get_string(&reader);
+        doc->title = manifest_get_string(&reader);
+        doc->content = manifest_get_string(&reader);
+        doc->mtime_ns = (long long)manifest_get_u64(&reader);
+        doc->size = manifest_get_u64(&reader);
+        doc->hash = manifest_get_u64(&reader);
+        uint32_t term_count = manifest_get_u32(&reader);
+        if (reader.failed || term_count > (size_t)(reader.end - reader.cursor) / 8U) {
+            reader.failed = 1;
+            break;
+        }
+        if (term_count > 0U) {
+            doc->terms = (DocTerm *)kolibri_alloc(term_count * sizeof(DocTerm));
+        }
+        for (uint32_t j = 0; j < term_count; ++j) {
+            doc->terms[j].token = manifest_get_u32(&reader);
+            doc->terms[j].count = manifest_get_u32(&reader);
+            if (doc->terms[j].token >= index->token_count ||
+                (j > 0U && doc->terms[j].token <= doc->terms[j - 1U].token)) {
+                reader.failed = 1;
+                break;
+            }
+        }
+        doc->term_count = term_count;
+        uint32_t vector_size = manifest_get_u32(&reader);
+        if (reader.failed || vector_size > term_count) {
+            reader.failed = 1;
+            break;
+        }
+        if (vector_size > 0U) {
+            doc->vector = (KolibriKnowledgeVectorItem *)kolibri_alloc(vector_size * sizeof(KolibriKnowledgeVectorItem));
+        }
+        for (uint32_t j = 0; j < vector_size; ++j) {
+            doc->vector[j].token_index = manifest_get_u32(&reader);
+            manifest_get(&reader, &doc->vector[j].weight, sizeof(float));
+            if (doc->vector[j].token_index >= index->token_count) {
+                reader.failed = 1;
+                break;
+            }
+        }
+        doc->vector_size = vector_size;
+        manifest_get(&reader, &doc->norm, sizeof(float));
+        if (!reader.failed && (!doc->source || token_map_find(&index->path_map, doc->source) != (size_t)-1)) {
+            reader.failed = 1;
+        }
+        if (!reader.failed) {
+            token_map_put(&index->path_map, doc->source, index->document_count - 1U);
+        }
+    }
+    free(data);
+    if (reader.failed || reader.cursor != reader.end) {
+        kolibri_knowledge_index_destroy(index);
+        return NULL;
+    }
+    for (size_t i = 0; i < index->document_count; ++i) {
+        const Document *doc = &index->documents[i];
+        for (size_t j = 0; j < doc->term_count; ++j) {
+            posting_add(index, doc->terms[j].token, i);
+        }
     }
+    for (size_t i = 0; i < index->dirty_count; ++i) {
+        index->tokens[index->dirty_tokens[i]].dirty = 0;
+    }
+    index->dirty_count = 0U;
+    return index;
+}
 
-    free(all_doc_tokens);
-    free(doc_token_counts);
-    path_list_free(&paths);
+int kolibri_knowledge_index_build(const char *const *roots,
+                                  size_t root_count,
+                                  size_t max_length,
+                                  const KolibriKnowledgeBuildOptions *options,
+                                  KolibriKnowledgeIndex **out_index,
+                                  KolibriKnowledgeBuildStats *out_stats) {
+    if (!roots || root_count == 0U || !out_index) {
+        return EINVAL;
+    }
+    *out_index = NULL;
+    const char *manifest_path = options ? options->manifest_path : NULL;
+    KolibriKnowledgeIndex *index = NULL;
+    if (manifest_path) {
+        index = knowledge_index_load_manifest(manifest_path, max_length);
+    }
+    int loaded = index != NULL;
+    if (!index) {
+        index = knowledge_index_new();
+    }
+    index->roots = (char **)kolibri_alloc(root_count * sizeof(char *));
+    for (size_t i = 0; i < root_count; ++i) {
+        index->roots[i] = kolibri_strdup(roots[i]);
+    }
+    index->root_count = root_count;
+    index->max_length = max_length;
+    index->threads = options && options->threads > 0U ? options->threads : index_default_threads();
+    if (index->threads > KOLIBRI_INDEX_MAX_THREADS) {
+        index->threads = KOLIBRI_INDEX_MAX_THREADS;
+    }
 
+    int err = knowledge_index_sync(index, !loaded, out_stats);
+    if (err == 0 && index->document_count == 0U) {
+        err = ENOENT;
+    }
+    if (err == 0 && manifest_path) {
+        err = kolibri_knowledge_index_save_manifest(index, manifest_path);
+    }
+    if (err != 0) {
+        kolibri_knowledge_index_destroy(index);
+        return err;
+    }
     *out_index = index;
     return 0;
 }
 
+int kolibri_knowledge_index_create(const char *const *roots,
+                                   size_t root_count,
+                                   size_t max_length,
+                                   KolibriKnowledgeIndex **out_index) {
+    return kolibri_knowledge_index_build(roots, root_count, max_length, NULL, out_index, NULL);
+}
+
+int kolibri_knowledge_index_refresh(KolibriKnowledgeIndex *index, KolibriKnowledgeBuildStats *out_stats) {
+    if (!index) {
+        return EINVAL;
+    }
+    return knowledge_index_sync(index, 0, out_stats);
+}
+
 void kolibri_knowledge_index_destroy(KolibriKnowledgeIndex *index) {
     if (!index) {
         return;
     }
     for (size_t i = 0; i < index->document_count; ++i) {
-        free(index->documents[i].id);
-        free(index->documents[i].title);
-        free(index->documents[i].source);
-        free(index->documents[i].content);
-        free(index->documents[i].vector);
+        document_free(&index->documents[i]);
     }
     free(index->documents);
     for (size_t i = 0; i < index->token_count; ++i) {
         free(index->tokens[i].token);
+        free(index->tokens[i].docs);
     }
     free(index->tokens);
+    token_map_free(&index->token_map);
+    token_map_free(&index->path_map);
+    free(index->dirty_tokens);
+    for (size_t i = 0; i < index->root_count; ++i) {
+        free(index->roots[i]);
+    }
+    free(index->roots);
     free(index);
 }
 
@@ -556,12 +1455,13 @@ const KolibriKnowledgeToken *kolibri_knowledge_index_token(const KolibriKnowledg
     return (const KolibriKnowledgeToken *)&index->tokens[idx];
 }
 
-static void tokenize_query(const char *query,
-                           const GlobalToken *tokens,
-                           size_t token_count,
+static void tokenize_query(const KolibriKnowledgeIndex *index,
+                           const char *query,
                            float **out_weights,
                            float *out_norm) {
-    float *weights = (float *)calloc(token_count, sizeof(float));
+    const GlobalToken *tokens = index->tokens;
+    size_t token_count = index->token_count;
+    float *weights = (float *)calloc(token_count + 1U, sizeof(float));
     if (!weights) {
         fprintf(stderr, "[kolibri-knowledge] alloc query weights failed\n");
         abort();
@@ -579,7 +1479,7 @@ static void tokenize_query(const char *query,
         } else {
             if (buffer_len > 0U) {
                 buffer[buffer_len] = '\0';
-                size_t idx = find_global_token(tokens, token_count, buffer);
+                size_t idx = token_map_find(&index->token_map, buffer);
                 if (idx != (size_t)-1) {
                     weights[idx] += 1.0f;
                     total_tokens += 1U;
@@ -591,7 +1491,7 @@ static void tokenize_query(const char *query,
     }
     if (buffer_len > 0U) {
         buffer[buffer_len] = '\0';
-        size_t idx = find_global_token(tokens, token_count, buffer);
+        size_t idx = token_map_find(&index->token_map, buffer);
         if (idx != (size_t)-1) {
             weights[idx] += 1.0f;
             total_tokens += 1U;
@@ -629,7 +1529,7 @@ int kolibri_knowledge_search(const KolibriKnowledgeIndex *index,
     }
     float *query_weights = NULL;
     float query_norm = 0.0f;
-    tokenize_query(query, index->tokens, index->token_count, &query_weights, &query_norm);
+    tokenize_query(index, query, &query_weights, &query_norm);
     if (query_norm == 0.0f) {
         free(query_weights);
         *out_result_count = 0U;
@@ -752,7 +1652,11 @@ int kolibri_knowledge_index_write_json(const KolibriKnowledgeIndex *index,
 
     fprintf(index_file, "{\n");
     fprintf(index_file, "  \"document_count\": %zu,\n", index->document_count);
-    fprintf(index_file, "  \"tokens\": %zu,\n", index->token_count);
+    size_t live_tokens = 0U;
+    for (size_t i = 0; i < index->token_count; ++i) {
+        live_tokens += index->tokens[i].df > 0U;
+    }
+    fprintf(index_file, "  \"tokens\": %zu,\n", live_tokens);
     fprintf(index_file, "  \"documents\": [\n");
     for (size_t i = 0; i < index->document_count; ++i) {
         const Document *doc = &index->documents[i];
@@ -3,6 +3,7 @@
 #include <dirent.h>
 #include <errno.h>
 #include <sqlite3.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -16,8 +17,34 @@
 #define kolibri_mkdir(path) mkdir(path, 0777)
 #endif
 
+enum {
+    QUEUE_STMT_INSERT,
+    QUEUE_STMT_FETCH,
+    QUEUE_STMT_MODERATE,
+    QUEUE_STMT_BEGIN,
+    QUEUE_STMT_COMMIT,
+    QUEUE_STMT_ROLLBACK,
+    QUEUE_STMT_JSON_VALID,
+    QUEUE_STMT_COUNT
+};
+
+static const char *const QUEUE_SQL[QUEUE_STMT_COUNT] = {
+    "INSERT INTO submissions (created_at, title, content, source, metadata, status) "
+    "VALUES (?, ?, ?, ?, ?, 'pending')",
+    "SELECT id, created_at, title, content, source, metadata, status, "
+    "moderator, moderation_note, moderated_at "
+    "FROM submissions WHERE status = ? ORDER BY created_at ASC LIMIT ?",
+    "UPDATE submissions SET status = ?, moderator = ?, moderation_note = ?, moderated_at = ? "
+    "WHERE id = ?",
+    "BEGIN IMMEDIATE",
+    "COMMIT",
+    "ROLLBACK",
+    "SELECT json_valid(?)",
+};
+
 struct KolibriQueue {
     sqlite3 *db;
+    sqlite3_stmt *stmts[QUEUE_STMT_COUNT];
 };
 
 static const char *QUEUE_SCHEMA =
@@ -33,7 +60,16 @@ static const char *QUEUE_SCHEMA =
     "moderation_note TEXT,"
     "moderated_at TEXT"
     ");"
-    "CREATE INDEX IF NOT EXISTS submissions_status_idx ON submissions(status);";
+    "DROP INDEX IF EXISTS submissions_status_idx;"
+    "CREATE INDEX IF NOT EXISTS submissions_status_id_idx ON submissions(status, id);";
+
+/* WAL lets readers run alongside the writer. With synchronous=NORMAL a
+ * commit is not fsynced: a power loss may drop the latest transactions
+ * but never corrupts the database. */
+static const char *QUEUE_PRAGMAS =
+    "PRAGMA journal_mode=WAL;"
+    "PRAGMA synchronous=NORMAL;"
+    "PRAGMA busy_timeout=5000;";
 
 static const char *STATUS_PENDING = "pending";
 static const char *STATUS_APPROVED = "approved";
@@ -70,19 +106,6 @@ int kolibri_queue_status_from_string(const char *text, KolibriQueueStatus *out_s
     return 1;
 }
 
-static char *kolibri_strdup(const char *text) {
-    if (!text) {
-        return NULL;
-    }
-    size_t len = strlen(text);
-    char *copy = (char *)malloc(len + 1U);
-    if (!copy) {
-        return NULL;
-    }
-    memcpy(copy, text, len + 1U);
-    return copy;
-}
-
 static int ensure_directory(const char *path) {
     struct stat st;
     if (stat(path, &st) == 0) {
@@ -111,7 +134,10 @@ int kolibri_queue_open(const char *database_path, KolibriQueue **out_queue) {
         free(queue);
         return rc;
     }
-    rc = sqlite3_exec(queue->db, QUEUE_SCHEMA, NULL, NULL, NULL);
+    rc = sqlite3_exec(queue->db, QUEUE_PRAGMAS, NULL, NULL, NULL);
+    if (rc == SQLITE_OK) {
+        rc = sqlite3_exec(queue->db, QUEUE_SCHEMA, NULL, NULL, NULL);
+    }
     if (rc != SQLITE_OK) {
         sqlite3_close(queue->db);
         free(queue);
@@ -125,11 +151,14 @@ void kolibri_queue_close(KolibriQueue *queue) {
     if (!queue) {
         return;
     }
+    for (size_t i = 0; i < QUEUE_STMT_COUNT; ++i) {
+        sqlite3_finalize(queue->stmts[i]);
+    }
     sqlite3_close(queue->db);
     free(queue);
 }
 
-static char *current_iso8601(void) {
+static void current_iso8601(char buffer[32]) {
     time_t now = time(NULL);
     struct tm t;
 #ifdef _WIN32
@@ -137,9 +166,97 @@ static char *current_iso8601(void) {
 #else
     gmtime_r(&now, &t);
 #endif
-    char buffer[32];
-    strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", &t);
-    return kolibri_strdup(buffer);
+    strftime(buffer, 32, "%Y-%m-%dT%H:%M:%SZ", &t);
+}
+
+/* Returns the cached statement, preparing it on first use. */
+static sqlite3_stmt *queue_statement(KolibriQueue *queue, int which, int *out_rc) {
+    sqlite3_stmt *stmt = queue->stmts[which];
+    if (!stmt) {
+        int rc = sqlite3_prepare_v3(queue->db, QUEUE_SQL[which], -1, SQLITE_PREPARE_PERSISTENT,
+                                    &stmt, NULL);
+        if (rc != SQLITE_OK) {
+            *out_rc = rc;
+            return NULL;
+        }
+        queue->stmts[which] = stmt;
+    }
+    return stmt;
+}
+
+static void queue_statement_done(sqlite3_stmt *stmt) {
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+}
+
+static int queue_exec(KolibriQueue *queue, int which) {
+    int rc = SQLITE_OK;
+    sqlite3_stmt *stmt = queue_statement(queue, which, &rc);
+    if (!stmt) {
+        return rc;
+    }
+    rc = sqlite3_step(stmt);
+    sqlite3_reset(stmt);
+    return rc == SQLITE_DONE ? SQLITE_OK : rc;
+}
+
+static void bind_optional_text(sqlite3_stmt *stmt, int index, const char *text) {
+    if (text) {
+        sqlite3_bind_text(stmt, index, text, -1, SQLITE_STATIC);
+    } else {
+        sqlite3_bind_null(stmt, index);
+    }
+}
+
+/* 1 if text is valid JSON, 0 if not, -1 on SQLite error (*out_rc set) */
+static int queue_json_valid(KolibriQueue *queue, const char *text, int *out_rc) {
+    sqlite3_stmt *stmt = queue_statement(queue, QUEUE_STMT_JSON_VALID, out_rc);
+    if (!stmt) {
+        return -1;
+    }
+    sqlite3_bind_text(stmt, 1, text, -1, SQLITE_STATIC);
+    int rc = sqlite3_step(stmt);
+    int valid = rc == SQLITE_ROW ? sqlite3_column_int(stmt, 0) != 0 : -1;
+    queue_statement_done(stmt);
+    if (valid < 0) {
+        *out_rc = rc;
+    }
+    return valid;
+}
+
+static int queue_insert(KolibriQueue *queue,
+                        const KolibriQueueSubmission *submission,
+                        const char *created,
+                        long long *out_submission_id) {
+    if (!submission->title || !submission->content) {
+        return SQLITE_MISUSE;
+    }
+    int rc = SQLITE_OK;
+    /* Export embeds metadata as JSON: reject anything else up front */
+    if (submission->metadata_json) {
+        int valid = queue_json_valid(queue, submission->metadata_json, &rc);
+        if (valid <= 0) {
+            return valid < 0 ? rc : SQLITE_CONSTRAINT;
+        }
+    }
+    sqlite3_stmt *stmt = queue_statement(queue, QUEUE_STMT_INSERT, &rc);
+    if (!stmt) {
+        return rc;
+    }
+    sqlite3_bind_text(stmt, 1, created, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, submission->title, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, submission->content, -1, SQLITE_STATIC);
+    bind_optional_text(stmt, 4, submission->source);
+    bind_optional_text(stmt, 5, submission->metadata_json);
+    rc = sqlite3_step(stmt);
+    queue_statement_done(stmt);
+    if (rc != SQLITE_DONE) {
+        return rc;
+    }
+    if (out_submission_id) {
+        *out_submission_id = sqlite3_last_insert_rowid(queue->db);
+    }
+    return SQLITE_OK;
 }
 
 int kolibri_queue_enqueue(KolibriQueue *queue,
@@ -151,42 +268,98 @@ int kolibri_queue_enqueue(KolibriQueue *queue,
     if (!queue || !title || !content) {
         return SQLITE_MISUSE;
     }
-    char *created = current_iso8601();
-    const char *sql =
-        "INSERT INTO submissions (created_at, title, content, source, metadata, status) "
-        "VALUES (?, ?, ?, ?, ?, ?)";
-    sqlite3_stmt *stmt = NULL;
-    int rc = sqlite3_prepare_v2(queue->db, sql, -1, &stmt, NULL);
+    char created[32];
+    current_iso8601(created);
+    KolibriQueueSubmission submission = {title, content, source, metadata_json};
+    return queue_insert(queue, &submission, created, out_submission_id);
+}
+
+int kolibri_queue_enqueue_batch(KolibriQueue *queue,
+                                const KolibriQueueSubmission *submissions,
+                                size_t count,
+                                long long *out_submission_ids) {
+    if (!queue || (!submissions && count > 0U)) {
+        return SQLITE_MISUSE;
+    }
+    if (count == 0U) {
+        return SQLITE_OK;
+    }
+    char created[32];
+    current_iso8601(created);
+    int rc = queue_exec(queue, QUEUE_STMT_BEGIN);
     if (rc != SQLITE_OK) {
-        free(created);
         return rc;
     }
-    sqlite3_bind_text(stmt, 1, created, -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 2, title, -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 3, content, -1, SQLITE_TRANSIENT);
-    if (source) {
-        sqlite3_bind_text(stmt, 4, source, -1, SQLITE_TRANSIENT);
-    } else {
-        sqlite3_bind_null(stmt, 4);
+    for (size_t i = 0; i < count; ++i) {
+        rc = queue_insert(queue, &submissions[i], created,
+                          out_submission_ids ? &out_submission_ids[i] : NULL);
+        if (rc != SQLITE_OK) {
+            queue_exec(queue, QUEUE_STMT_ROLLBACK);
+            return rc;
+        }
     }
-    if (metadata_json) {
-        sqlite3_bind_text(stmt, 5, metadata_json, -1, SQLITE_TRANSIENT);
-    } else {
-        sqlite3_bind_null(stmt, 5);
+    rc = queue_exec(queue, QUEUE_STMT_COMMIT);
+    if (rc != SQLITE_OK) {
+        queue_exec(queue, QUEUE_STMT_ROLLBACK);
     }
-    sqlite3_bind_text(stmt, 6, STATUS_PENDING, -1, SQLITE_TRANSIENT);
+    return rc;
+}
 
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
-    if (rc != SQLITE_DONE) {
-        free(created);
-        return rc;
+/* Fetch builds the record array and a string arena side by side; string
+ * fields hold arena offsets until both are merged into one block. */
+#define QUEUE_NULL_OFFSET ((uintptr_t)-1)
+#define QUEUE_RECORD_FIELDS 8
+
+static char **record_field(KolibriQueueRecord *record, size_t field) {
+    switch (field) {
+    case 0:
+        return &record->created_at;
+    case 1:
+        return &record->title;
+    case 2:
+        return &record->content;
+    case 3:
+        return &record->source;
+    case 4:
+        return &record->metadata;
+    case 5:
+        return &record->moderator;
+    case 6:
+        return &record->moderation_note;
+    default:
+        return &record->moderated_at;
     }
-    if (out_submission_id) {
-        *out_submission_id = sqlite3_last_insert_rowid(queue->db);
+}
+
+static const int RECORD_FIELD_COLUMNS[QUEUE_RECORD_FIELDS] = {1, 2, 3, 4, 5, 7, 8, 9};
+
+typedef struct {
+    char *data;
+    size_t length;
+    size_t capacity;
+} QueueArena;
+
+static int arena_append(QueueArena *arena, const unsigned char *text, size_t length,
+                        uintptr_t *out_offset) {
+    if (arena->length + length + 1U > arena->capacity) {
+        size_t capacity = arena->capacity ? arena->capacity : 4096U;
+        while (capacity < arena->length + length + 1U) {
+            capacity *= 2U;
+        }
+        char *data = (char *)realloc(arena->data, capacity);
+        if (!data) {
+            return -1;
+        }
+        arena->data = data;
+        arena->capacity = capacity;
     }
-    free(created);
-    return SQLITE_OK;
+    *out_offset = (uintptr_t)arena->length;
+    if (length > 0U) {
+        memcpy(arena->data + arena->length, text, length);
+    }
+    arena->data[arena->length + length] = '\0';
+    arena->length += length + 1U;
+    return 0;
 }
 
 int kolibri_queue_fetch(KolibriQueue *queue,
@@ -199,76 +372,116 @@ int kolibri_queue_fetch(KolibriQueue *queue,
     }
     *out_records = NULL;
     *out_count = 0U;
-    const char *sql =
-        "SELECT id, created_at, title, content, source, metadata, status, "
-        "moderator, moderation_note, moderated_at "
-        "FROM submissions WHERE status = ? ORDER BY created_at ASC LIMIT ?";
-    sqlite3_stmt *stmt = NULL;
-    int rc = sqlite3_prepare_v2(queue->db, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
+    int rc = SQLITE_OK;
+    sqlite3_stmt *stmt = queue_statement(queue, QUEUE_STMT_FETCH, &rc);
+    if (!stmt) {
         return rc;
     }
-    sqlite3_bind_text(stmt, 1, kolibri_queue_status_to_string(status), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_int(stmt, 2, (int)limit);
+    sqlite3_bind_text(stmt, 1, kolibri_queue_status_to_string(status), -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 2, (sqlite3_int64)limit);
 
     KolibriQueueRecord *records = NULL;
     size_t capacity = 0U;
     size_t count = 0U;
+    QueueArena arena = {NULL, 0U, 0U};
 
     while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
         if (count == capacity) {
             size_t new_cap = capacity == 0U ? 16U : capacity * 2U;
             KolibriQueueRecord *new_records = (KolibriQueueRecord *)realloc(records, new_cap * sizeof(KolibriQueueRecord));
             if (!new_records) {
-                sqlite3_finalize(stmt);
-                free(records);
-                return SQLITE_NOMEM;
+                rc = SQLITE_NOMEM;
+                break;
             }
             records = new_records;
             capacity = new_cap;
         }
-        KolibriQueueRecord *rec = &records[count++];
+        KolibriQueueRecord *rec = &records[count];
         rec->submission_id = sqlite3_column_int64(stmt, 0);
-        rec->created_at = kolibri_strdup((const char *)sqlite3_column_text(stmt, 1));
-        rec->title = kolibri_strdup((const char *)sqlite3_column_text(stmt, 2));
-        rec->content = kolibri_strdup((const char *)sqlite3_column_text(stmt, 3));
-        rec->source = kolibri_strdup((const char *)sqlite3_column_text(stmt, 4));
-        rec->metadata = kolibri_strdup((const char *)sqlite3_column_text(stmt, 5));
         KolibriQueueStatus st;
         if (kolibri_queue_status_from_string((const char *)sqlite3_column_text(stmt, 6), &st) != 0) {
             st = KOLIBRI_QUEUE_STATUS_PENDING;
         }
         rec->status = st;
-        rec->moderator = kolibri_strdup((const char *)sqlite3_column_text(stmt, 7));
-        rec->moderation_note = kolibri_strdup((const char *)sqlite3_column_text(stmt, 8));
-        rec->moderated_at = kolibri_strdup((const char *)sqlite3_column_text(stmt, 9));
+        int failed = 0;
+        for (size_t f = 0; f < QUEUE_RECORD_FIELDS && !failed; ++f) {
+            int column = RECORD_FIELD_COLUMNS[f];
+            const unsigned char *text = sqlite3_column_text(stmt, column);
+            uintptr_t offset = QUEUE_NULL_OFFSET;
+            if (text && arena_append(&arena, text, (size_t)sqlite3_column_bytes(stmt, column),
+                                     &offset) != 0) {
+                failed = 1;
+            }
+            *record_field(rec, f) = (char *)offset;
+        }
+        if (failed) {
+            rc = SQLITE_NOMEM;
+            break;
+        }
+        count++;
     }
-
-    sqlite3_finalize(stmt);
+    queue_statement_done(stmt);
     if (rc != SQLITE_DONE) {
-        kolibri_queue_free_records(records, count);
+        free(records);
+        free(arena.data);
         return rc;
     }
-    *out_records = records;
+    if (count == 0U) {
+        free(records);
+        free(arena.data);
+        return SQLITE_OK;
+    }
+
+    size_t records_size = count * sizeof(KolibriQueueRecord);
+    KolibriQueueRecord *block = (KolibriQueueRecord *)malloc(records_size + arena.length);
+    if (!block) {
+        free(records);
+        free(arena.data);
+        return SQLITE_NOMEM;
+    }
+    memcpy(block, records, records_size);
+    char *strings = (char *)block + records_size;
+    memcpy(strings, arena.data, arena.length);
+    for (size_t i = 0; i < count; ++i) {
+        for (size_t f = 0; f < QUEUE_RECORD_FIELDS; ++f) {
+            char **field = record_field(&block[i], f);
+            uintptr_t offset = (uintptr_t)*field;
+            *field = offset == QUEUE_NULL_OFFSET ? NULL : strings + offset;
+        }
+    }
+    free(records);
+    free(arena.data);
+    *out_records = block;
     *out_count = count;
     return SQLITE_OK;
 }
 
 void kolibri_queue_free_records(KolibriQueueRecord *records, size_t count) {
-    if (!records) {
-        return;
+    (void)count;
+    free(records);
+}
+
+static int queue_update(KolibriQueue *queue,
+                        const KolibriQueueModeration *moderation,
+                        const char *timestamp,
+                        int *out_changed) {
+    int rc = SQLITE_OK;
+    sqlite3_stmt *stmt = queue_statement(queue, QUEUE_STMT_MODERATE, &rc);
+    if (!stmt) {
+        return rc;
     }
-    for (size_t i = 0; i < count; ++i) {
-        free(records[i].created_at);
-        free(records[i].title);
-        free(records[i].content);
-        free(records[i].source);
-        free(records[i].metadata);
-        free(records[i].moderator);
-        free(records[i].moderation_note);
-        free(records[i].moderated_at);
+    sqlite3_bind_text(stmt, 1, kolibri_queue_status_to_string(moderation->status), -1, SQLITE_STATIC);
+    bind_optional_text(stmt, 2, moderation->moderator);
+    bind_optional_text(stmt, 3, moderation->note);
+    sqlite3_bind_text(stmt, 4, timestamp, -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 5, moderation->submission_id);
+    rc = sqlite3_step(stmt);
+    queue_statement_done(stmt);
+    if (rc != SQLITE_DONE) {
+        return rc;
     }
-    free(records);
+    *out_changed = sqlite3_changes(queue->db) > 0;
+    return SQLITE_OK;
 }
 
 int kolibri_queue_moderate(KolibriQueue *queue,
@@ -279,42 +492,174 @@ int kolibri_queue_moderate(KolibriQueue *queue,
     if (!queue) {
         return SQLITE_MISUSE;
     }
-    char *timestamp = current_iso8601();
-    const char *sql =
-        "UPDATE submissions SET status = ?, moderator = ?, moderation_note = ?, moderated_at = ? "
-        "WHERE id = ?";
-    sqlite3_stmt *stmt = NULL;
-    int rc = sqlite3_prepare_v2(queue->db, sql, -1, &stmt, NULL);
+    char timestamp[32];
+    current_iso8601(timestamp);
+    KolibriQueueModeration moderation = {submission_id, status, moderator, note};
+    int changed = 0;
+    int rc = queue_update(queue, &moderation, timestamp, &changed);
     if (rc != SQLITE_OK) {
-        free(timestamp);
         return rc;
     }
-    sqlite3_bind_text(stmt, 1, kolibri_queue_status_to_string(status), -1, SQLITE_TRANSIENT);
-    if (moderator) {
-        sqlite3_bind_text(stmt, 2, moderator, -1, SQLITE_TRANSIENT);
-    } else {
-        sqlite3_bind_null(stmt, 2);
+    return changed ? SQLITE_OK : SQLITE_NOTFOUND;
+}
+
+int kolibri_queue_moderate_batch(KolibriQueue *queue,
+                                 const KolibriQueueModeration *moderations,
+                                 size_t count,
+                                 size_t *out_updated) {
+    if (out_updated) {
+        *out_updated = 0U;
+    }
+    if (!queue || (!moderations && count > 0U)) {
+        return SQLITE_MISUSE;
     }
-    if (note) {
-        sqlite3_bind_text(stmt, 3, note, -1, SQLITE_TRANSIENT);
-    } else {
-        sqlite3_bind_null(stmt, 3);
+    if (count == 0U) {
+        return SQLITE_OK;
     }
-    sqlite3_bind_text(stmt, 4, timestamp, -1, SQLITE_TRANSIENT);
-    sqlite3_bind_int64(stmt, 5, submission_id);
-
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
-    free(timestamp);
-    if (rc != SQLITE_DONE) {
+    char timestamp[32];
+    current_iso8601(timestamp);
+    int rc = queue_exec(queue, QUEUE_STMT_BEGIN);
+    if (rc != SQLITE_OK) {
+        return rc;
+    }
+    size_t updated = 0U;
+    for (size_t i = 0; i < count; ++i) {
+        int changed = 0;
+        rc = queue_update(queue, &moderations[i], timestamp, &changed);
+        if (rc != SQLITE_OK) {
+            queue_exec(queue, QUEUE_STMT_ROLLBACK);
+            return rc;
+        }
+        updated += changed ? 1U : 0U;
+    }
+    rc = queue_exec(queue, QUEUE_STMT_COMMIT);
+    if (rc != SQLITE_OK) {
+        queue_exec(queue, QUEUE_STMT_ROLLBACK);
         return rc;
     }
-    if (sqlite3_changes(queue->db) == 0) {
-        return SQLITE_NOTFOUND;
+    if (out_updated) {
+        *out_updated = updated;
+    }
+    return SQLITE_OK;
+}
+
+#define QUEUE_CURSOR_PAGE 256U
+
+/* Rows are read in pages with "id > last": the statement is reset between
+ * pages, so a long scan never pins a WAL snapshot. */
+static const char *QUEUE_CURSOR_SQL =
+    "SELECT id, created_at, title, content, source, metadata, status, "
+    "moderator, moderation_note, moderated_at "
+    "FROM submissions WHERE status = ? AND id > ? ORDER BY id LIMIT ?";
+
+static const char *QUEUE_CURSOR_LIGHT_SQL =
+    "SELECT id, created_at, title, NULL, source, metadata, status, "
+    "moderator, moderation_note, moderated_at "
+    "FROM submissions WHERE status = ? AND id > ? ORDER BY id LIMIT ?";
+
+struct KolibriQueueCursor {
+    sqlite3_stmt *stmt;
+    KolibriQueueStatus status;
+    long long last_id;
+    size_t page_size;
+    size_t page_rows;
+    int exhausted;
+    KolibriQueueRecord record;
+};
+
+int kolibri_queue_cursor_open(KolibriQueue *queue,
+                              KolibriQueueStatus status,
+                              long long after_id,
+                              int include_content,
+                              size_t page_size,
+                              KolibriQueueCursor **out_cursor) {
+    if (!queue || !out_cursor) {
+        return SQLITE_MISUSE;
+    }
+    *out_cursor = NULL;
+    KolibriQueueCursor *cursor = (KolibriQueueCursor *)calloc(1, sizeof(KolibriQueueCursor));
+    if (!cursor) {
+        return SQLITE_NOMEM;
     }
+    int rc = sqlite3_prepare_v3(queue->db,
+                                include_content ? QUEUE_CURSOR_SQL : QUEUE_CURSOR_LIGHT_SQL,
+                                -1, SQLITE_PREPARE_PERSISTENT, &cursor->stmt, NULL);
+    if (rc != SQLITE_OK) {
+        free(cursor);
+        return rc;
+    }
+    cursor->status = status;
+    cursor->last_id = after_id;
+    cursor->page_size = page_size ? page_size : QUEUE_CURSOR_PAGE;
+    sqlite3_bind_text(cursor->stmt, 1, kolibri_queue_status_to_string(status), -1, SQLITE_STATIC);
+    sqlite3_bind_int64(cursor->stmt, 2, after_id);
+    sqlite3_bind_int64(cursor->stmt, 3, (sqlite3_int64)cursor->page_size);
+    *out_cursor = cursor;
     return SQLITE_OK;
 }
 
+static char *cursor_text(sqlite3_stmt *stmt, int column) {
+    return (char *)sqlite3_column_text(stmt, column);
+}
+
+int kolibri_queue_cursor_next(KolibriQueueCursor *cursor,
+                              const KolibriQueueRecord **out_record) {
+    if (!cursor || !out_record) {
+        return SQLITE_MISUSE;
+    }
+    *out_record = NULL;
+    if (cursor->exhausted) {
+        return SQLITE_DONE;
+    }
+    int rc = sqlite3_step(cursor->stmt);
+    if (rc == SQLITE_DONE && cursor->page_rows == cursor->page_size) {
+        /* Page was full: continue after the last id */
+        sqlite3_reset(cursor->stmt);
+        sqlite3_bind_int64(cursor->stmt, 2, cursor->last_id);
+        cursor->page_rows = 0U;
+        rc = sqlite3_step(cursor->stmt);
+    }
+    if (rc == SQLITE_DONE) {
+        cursor->exhausted = 1;
+        sqlite3_reset(cursor->stmt);
+        return SQLITE_DONE;
+    }
+    if (rc != SQLITE_ROW) {
+        sqlite3_reset(cursor->stmt);
+        return rc;
+    }
+    cursor->page_rows++;
+    sqlite3_stmt *stmt = cursor->stmt;
+    KolibriQueueRecord *rec = &cursor->record;
+    rec->submission_id = sqlite3_column_int64(stmt, 0);
+    rec->created_at = cursor_text(stmt, 1);
+    rec->title = cursor_text(stmt, 2);
+    rec->content = cursor_text(stmt, 3);
+    rec->source = cursor_text(stmt, 4);
+    rec->metadata = cursor_text(stmt, 5);
+    if (kolibri_queue_status_from_string((const char *)sqlite3_column_text(stmt, 6), &rec->status) != 0) {
+        rec->status = cursor->status;
+    }
+    rec->moderator = cursor_text(stmt, 7);
+    rec->moderation_note = cursor_text(stmt, 8);
+    rec->moderated_at = cursor_text(stmt, 9);
+    cursor->last_id = rec->submission_id;
+    *out_record = rec;
+    return SQLITE_ROW;
+}
+
+long long kolibri_queue_cursor_position(const KolibriQueueCursor *cursor) {
+    return cursor ? cursor->last_id : 0;
+}
+
+void kolibri_queue_cursor_close(KolibriQueueCursor *cursor) {
+    if (!cursor) {
+        return;
+    }
+    sqlite3_finalize(cursor->stmt);
+    free(cursor);
+}
+
 static void delete_markdown_files(const char *dir) {
     DIR *d = opendir(dir);
     if (!d) {
@@ -372,16 +717,126 @@ int kolibri_queue_export_markdown(KolibriQueue *queue,
         return SQLITE_ERROR;
     }
     delete_markdown_files(destination_dir);
-    KolibriQueueRecord *records = NULL;
+    KolibriQueueCursor *cursor = NULL;
+    int rc = kolibri_queue_cursor_open(queue, status, 0, 1, 0U, &cursor);
+    if (rc != SQLITE_OK) {
+        return rc;
+    }
     size_t count = 0U;
-    int rc = kolibri_queue_fetch(queue, status, 10000U, &records, &count);
+    const KolibriQueueRecord *record = NULL;
+    while ((rc = kolibri_queue_cursor_next(cursor, &record)) == SQLITE_ROW) {
+        write_markdown_file(record, destination_dir, count++);
+    }
+    kolibri_queue_cursor_close(cursor);
+    if (rc != SQLITE_DONE) {
+        return rc;
+    }
+    if (out_exported) {
+        *out_exported = count;
+    }
+    return SQLITE_OK;
+}
+
+static void write_json_string(FILE *out, const char *text) {
+    if (!text) {
+        fputs("null", out);
+        return;
+    }
+    fputc('"', out);
+    const char *run = text;
+    for (const unsigned char *c = (const unsigned char *)text; *c; ++c) {
+        const char *escape = NULL;
+        char control[8];
+        switch (*c) {
+        case '"':
+            escape = "\\\"";
+            break;
+        case '\\':
+            escape = "\\\\";
+            break;
+        case '\n':
+            escape = "\\n";
+            break;
+        case '\r':
+            escape = "\\r";
+            break;
+        case '\t':
+            escape = "\\t";
+            break;
+        default:
+            if (*c < 0x20U) {
+                snprintf(control, sizeof(control), "\\u%04x", (unsigned int)*c);
+                escape = control;
+            }
+            break;
+        }
+        if (escape) {
+            fwrite(run, 1U, (size_t)((const char *)c - run), out);
+            fputs(escape, out);
+            run = (const char *)c + 1;
+        }
+    }
+    fputs(run, out);
+    fputc('"', out);
+}
+
+int kolibri_queue_export_jsonl(KolibriQueue *queue,
+                               KolibriQueueStatus status,
+                               FILE *out,
+                               size_t *out_exported) {
+    if (!queue || !out) {
+        return SQLITE_MISUSE;
+    }
+    KolibriQueueCursor *cursor = NULL;
+    int rc = kolibri_queue_cursor_open(queue, status, 0, 1, 0U, &cursor);
     if (rc != SQLITE_OK) {
         return rc;
     }
-    for (size_t i = 0; i < count; ++i) {
-        write_markdown_file(&records[i], destination_dir, i);
+    size_t count = 0U;
+    const KolibriQueueRecord *record = NULL;
+    while ((rc = kolibri_queue_cursor_next(cursor, &record)) == SQLITE_ROW) {
+        fprintf(out, "{\"id\":%lld,\"created_at\":", record->submission_id);
+        write_json_string(out, record->created_at);
+        fputs(",\"status\":", out);
+        write_json_string(out, kolibri_queue_status_to_string(record->status));
+        fputs(",\"title\":", out);
+        write_json_string(out, record->title);
+        fputs(",\"content\":", out);
+        write_json_string(out, record->content);
+        fputs(",\"source\":", out);
+        write_json_string(out, record->source);
+        /* metadata is embedded as JSON; rows stored before enqueue checked
+         * it may hold other text, which is exported as a string */
+        fputs(",\"metadata\":", out);
+        if (!record->metadata || !record->metadata[0]) {
+            fputs("null", out);
+        } else {
+            int valid = queue_json_valid(queue, record->metadata, &rc);
+            if (valid < 0) {
+                break;
+            }
+            if (valid) {
+                fputs(record->metadata, out);
+            } else {
+                write_json_string(out, record->metadata);
+            }
+        }
+        fputs(",\"moderator\":", out);
+        write_json_string(out, record->moderator);
+        fputs(",\"moderation_note\":", out);
+        write_json_string(out, record->moderation_note);
+        fputs(",\"moderated_at\":", out);
+        write_json_string(out, record->moderated_at);
+        fputs("}\n", out);
+        count++;
+    }
+    kolibri_queue_cursor_close(cursor);
+    if (rc != SQLITE_DONE) {
+        return rc;
+    }
+    if (ferror(out)) {
+        return SQLITE_IOERR;
     }
-    kolibri_queue_free_records(records, count);
     if (out_exported) {
         *out_exported = count;
     }
@@ -1,13 +1,19 @@
-#include "kolibri/knowledge.h"
+#include "kolibri/knowledge_handle.h"
 #include "kolibri/genome.h"
 
 #include <arpa/inet.h>
 #include <errno.h>
 #include <netinet/in.h>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
 #include <signal.h>
+#include <stdarg.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <time.h>
@@ -20,24 +26,44 @@
 #define KOLIBRI_RESPONSE_BUFFER 32768
 #define KOLIBRI_BOOTSTRAP_SCRIPT "knowledge_bootstrap.ks"
 #define KOLIBRI_KNOWLEDGE_GENOME ".kolibri/knowledge_genome.dat"
+#define KOLIBRI_WATCH_MS 2000U
+/* Допустимое расхождение часов для подписанных админ-запросов, с */
+#define KOLIBRI_ADMIN_SKEW_S 300
+#define KOLIBRI_ADMIN_RELOAD "/api/knowledge/admin/reload"
 
 static volatile sig_atomic_t kolibri_server_running = 1;
+static volatile sig_atomic_t kolibri_reload_signal = 0;
+static KolibriKnowledgeHandle *kolibri_knowledge = NULL;
 static size_t kolibri_requests_total = 0U;
 static size_t kolibri_search_hits = 0U;
 static size_t kolibri_search_misses = 0U;
-static time_t kolibri_bootstrap_timestamp = 0;
+/* Пишется потоком сборки при публикации версии */
+static atomic_llong kolibri_bootstrap_timestamp = 0;
 
 static KolibriGenome kolibri_genome;
 static int kolibri_genome_ready = 0;
 static unsigned char kolibri_hmac_key[KOLIBRI_HMAC_KEY_SIZE];
 static size_t kolibri_hmac_key_len = 0U;
 static char kolibri_hmac_key_origin[128];
+static int kolibri_hmac_key_from_file = 0;
 
 static void handle_signal(int sig) {
-    (void)sig;
+    if (sig == SIGHUP) {
+        kolibri_reload_signal = 1;
+        return;
+    }
     kolibri_server_running = 0;
 }
 
+/* Без SA_RESTART: accept прерывается и цикл сразу видит флаги */
+static void install_signal(int sig) {
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = handle_signal;
+    sigemptyset(&action.sa_mask);
+    sigaction(sig, &action, NULL);
+}
+
 static void escape_script_string(const char *input, char *output, size_t out_size) {
     if (!output || out_size == 0) {
         return;
@@ -124,7 +150,9 @@ static void kolibri_genome_init_or_open(void) {
     /* Try to load key from root.key, fallback to default literal */
     kolibri_hmac_key_len = 0U;
     kolibri_hmac_key_origin[0] = '\0';
+    kolibri_hmac_key_from_file = 0;
     if (load_hmac_key_from_file("root.key", kolibri_hmac_key, &kolibri_hmac_key_len) == 0) {
+        kolibri_hmac_key_from_file = 1;
         snprintf(kolibri_hmac_key_origin, sizeof(kolibri_hmac_key_origin), "root.key (%zu байт)", kolibri_hmac_key_len);
     } else {
         const char *def = "kolibri-secret-key";
@@ -138,7 +166,10 @@ static void kolibri_genome_init_or_open(void) {
     }
 
     ensure_dir_exists(".kolibri");
-    if (kg_open(&kolibri_genome, KOLIBRI_KNOWLEDGE_GENOME, kolibri_hmac_key, kolibri_hmac_key_len) == 0) {
+    /* Цепочка до сохранённого хвоста уже проверена прошлым запуском */
+    KolibriGenomeOpenOptions open_options = {KG_VERIFY_TAIL, 0};
+    if (kg_open_ex(&kolibri_genome, KOLIBRI_KNOWLEDGE_GENOME, kolibri_hmac_key, kolibri_hmac_key_len,
+                   &open_options) == 0) {
         kolibri_genome_ready = 1;
         char payload[128];
         snprintf(payload, sizeof(payload), "knowledge_server стартовал (ключ: %s)", kolibri_hmac_key_origin);
@@ -206,7 +237,14 @@ static void write_bootstrap_script(const KolibriKnowledgeIndex *index, const cha
     fprintf(file, "конец.\n");
     fclose(file);
     fprintf(stdout, "[kolibri-knowledge] bootstrap script written to %s\n", path);
-    kolibri_bootstrap_timestamp = time(NULL);
+    atomic_store(&kolibri_bootstrap_timestamp, (long long)time(NULL));
+}
+
+static void knowledge_on_publish(const KolibriKnowledgeVersion *version, void *user) {
+    (void)user;
+    if (version->index.count > 0) {
+        write_bootstrap_script(&version->index, KOLIBRI_BOOTSTRAP_SCRIPT);
+    }
 }
 
 static int starts_with(const char *text, const char *prefix) {
@@ -351,7 +389,95 @@ static void json_escape(const char *input, char *output, size_t out_size) {
     output[out_index] = '\0';
 }
 
-static void handle_client(int client_fd, const KolibriKnowledgeIndex *index) {
+/* Строка под результат форматирования любой длины; NULL при ошибке */
+static char *format_alloc(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    va_list copy;
+    va_copy(copy, args);
+    int len = vsnprintf(NULL, 0, format, copy);
+    va_end(copy);
+    char *text = len < 0 ? NULL : (char *)malloc((size_t)len + 1U);
+    if (text) {
+        vsnprintf(text, (size_t)len + 1U, format, args);
+    }
+    va_end(args);
+    return text;
+}
+
+/* Значение заголовка name в сыром запросе, без пробелов вокруг */
+static int request_header(const char *request, const char *name, char *out, size_t out_size) {
+    size_t name_len = strlen(name);
+    for (const char *line = strstr(request, "\r\n"); line; line = strstr(line, "\r\n")) {
+        line += 2;
+        if (line[0] == '\r' && line[1] == '\n') {
+            break;
+        }
+        if (strncasecmp(line, name, name_len) != 0 || line[name_len] != ':') {
+            continue;
+        }
+        const char *value = line + name_len + 1;
+        while (*value == ' ' || *value == '\t') {
+            ++value;
+        }
+        size_t len = strcspn(value, "\r\n");
+        while (len > 0 && (value[len - 1U] == ' ' || value[len - 1U] == '\t')) {
+            --len;
+        }
+        if (len >= out_size) {
+            return -1;
+        }
+        memcpy(out, value, len);
+        out[len] = '\0';
+        return 0;
+    }
+    return -1;
+}
+
+/* Админ-запрос подписан ключом генома из root.key: X-Kolibri-Signature =
+ * hex(HMAC-SHA256(ключ, "POST <путь>\n<X-Kolibri-Timestamp>")), метка
+ * времени не дальше KOLIBRI_ADMIN_SKEW_S от часов сервера. Встроенный
+ * ключ общеизвестен, с ним админ-запросы отклоняются. */
+static int admin_request_authorized(const char *request) {
+    if (!kolibri_hmac_key_from_file || kolibri_hmac_key_len == 0U) {
+        return 0;
+    }
+    char timestamp[32];
+    char signature[2U * EVP_MAX_MD_SIZE + 1U];
+    if (request_header(request, "X-Kolibri-Timestamp", timestamp, sizeof(timestamp)) != 0 ||
+        request_header(request, "X-Kolibri-Signature", signature, sizeof(signature)) != 0) {
+        return 0;
+    }
+    char *end = NULL;
+    long long when = strtoll(timestamp, &end, 10);
+    long long skew = (long long)time(NULL) - when;
+    if (end == timestamp || *end != '\0' || skew > KOLIBRI_ADMIN_SKEW_S || skew < -KOLIBRI_ADMIN_SKEW_S) {
+        return 0;
+    }
+    char message[96];
+    int message_len = snprintf(message, sizeof(message), "POST %s\n%s", KOLIBRI_ADMIN_RELOAD, timestamp);
+    unsigned char mac[EVP_MAX_MD_SIZE];
+    unsigned int mac_len = 0U;
+    if (message_len < 0 || (size_t)message_len >= sizeof(message) ||
+        !HMAC(EVP_sha256(), kolibri_hmac_key, (int)kolibri_hmac_key_len,
+              (const unsigned char *)message, (size_t)message_len, mac, &mac_len)) {
+        return 0;
+    }
+    char expected[2U * EVP_MAX_MD_SIZE + 1U];
+    for (unsigned int i = 0; i < mac_len; ++i) {
+        snprintf(expected + 2U * i, 3U, "%02x", mac[i]);
+    }
+    for (char *c = signature; *c; ++c) {
+        if (*c >= 'A' && *c <= 'F') {
+            *c = (char)(*c - 'A' + 'a');
+        }
+    }
+    return strlen(signature) == 2U * mac_len &&
+           CRYPTO_memcmp(signature, expected, 2U * mac_len) == 0;
+}
+
+static void handle_client(int client_fd, const KolibriKnowledgeVersion *version) {
+    const KolibriKnowledgeIndex *index = &version->index;
     char buffer[KOLIBRI_REQUEST_BUFFER];
     kolibri_requests_total += 1U;
     ssize_t received = recv(client_fd, buffer, sizeof(buffer) - 1U, 0);
@@ -359,6 +485,20 @@ static void handle_client(int client_fd, const KolibriKnowledgeIndex *index) {
         return;
     }
     buffer[received] = '\0';
+    /* Перезагрузка меняет состояние: только подписанный POST */
+    if (starts_with(buffer, "POST " KOLIBRI_ADMIN_RELOAD " ") ||
+        starts_with(buffer, "POST " KOLIBRI_ADMIN_RELOAD "?")) {
+        if (!admin_request_authorized(buffer)) {
+            send_response(client_fd, 401, "application/json", "{\"error\":\"unauthorized\"}");
+            return;
+        }
+        /* Сборка идёт в фоне; ответ сразу, с версией, которая сейчас отвечает */
+        kolibri_knowledge_request_reload(kolibri_knowledge);
+        char body[128];
+        snprintf(body, sizeof(body), "{\"status\":\"reload scheduled\",\"version\":%llu}", version->version);
+        send_response(client_fd, 200, "application/json", body);
+        return;
+    }
     if (!starts_with(buffer, "GET ")) {
         send_response(client_fd, 405, "application/json", "{\"error\":\"method not allowed\"}");
         return;
@@ -374,19 +514,31 @@ static void handle_client(int client_fd, const KolibriKnowledgeIndex *index) {
     if (strcmp(path_start, "/healthz") == 0 ||
         starts_with(path_start, "/api/knowledge/healthz")) {
         char body[128];
-        snprintf(body, sizeof(body), "{\"status\":\"ok\",\"documents\":%zu}", index->count);
+        snprintf(body, sizeof(body), "{\"status\":\"ok\",\"documents\":%zu,\"version\":%llu}", index->count,
+                 version->version);
         send_response(client_fd, 200, "application/json", body);
         return;
     }
 
+    if (starts_with(path_start, KOLIBRI_ADMIN_RELOAD)) {
+        send_response(client_fd, 405, "application/json", "{\"error\":\"method not allowed\"}");
+        return;
+    }
+
     if (strcmp(path_start, "/metrics") == 0 ||
         starts_with(path_start, "/api/knowledge/metrics")) {
-        char body[512];
-        int len = snprintf(body,
-                           sizeof(body),
-                           "# HELP kolibri_knowledge_documents Number of documents in knowledge index\n"
+        char *body = format_alloc("# HELP kolibri_knowledge_documents Number of documents in knowledge index\n"
                            "# TYPE kolibri_knowledge_documents gauge\n"
                            "kolibri_knowledge_documents %zu\n"
+                           "# HELP kolibri_knowledge_index_version Version of the index serving requests\n"
+                           "# TYPE kolibri_knowledge_index_version gauge\n"
+                           "kolibri_knowledge_index_version %llu\n"
+                           "# HELP kolibri_knowledge_index_build_ms Build time of the serving index version\n"
+                           "# TYPE kolibri_knowledge_index_build_ms gauge\n"
+                           "kolibri_knowledge_index_build_ms %.1f\n"
+                           "# HELP kolibri_knowledge_index_versions Index versions still held by readers\n"
+                           "# TYPE kolibri_knowledge_index_versions gauge\n"
+                           "kolibri_knowledge_index_versions %zu\n"
                            "# HELP kolibri_requests_total Total HTTP requests handled\n"
                            "# TYPE kolibri_requests_total counter\n"
                            "kolibri_requests_total %zu\n"
@@ -400,15 +552,19 @@ static void handle_client(int client_fd, const KolibriKnowledgeIndex *index) {
                            "# TYPE kolibri_bootstrap_generated_unixtime gauge\n"
                            "kolibri_bootstrap_generated_unixtime %.0f\n",
                            index->count,
+                           version->version,
+                           version->build_ms,
+                           kolibri_knowledge_handle_live_versions(kolibri_knowledge),
                            kolibri_requests_total,
                            kolibri_search_hits,
                            kolibri_search_misses,
-                           kolibri_bootstrap_timestamp > 0 ? (double)kolibri_bootstrap_timestamp : 0.0);
-        if (len < 0) {
+                           (double)atomic_load(&kolibri_bootstrap_timestamp));
+        if (!body) {
             send_response(client_fd, 500, "text/plain", "error");
             return;
         }
         send_response(client_fd, 200, "text/plain; version=0.0.4", body);
+        free(body);
         return;
     }
 
@@ -564,28 +720,56 @@ static void handle_client(int client_fd, const KolibriKnowledgeIndex *index) {
     }
 }
 
-int main(void) {
-    KolibriKnowledgeIndex index;
-    if (kolibri_knowledge_index_init(&index) != 0) {
+static void print_usage(void) {
+    fprintf(stderr,
+            "Usage: kolibri_knowledge_server [--port N] [--watch-ms N]\n"
+            "  --watch-ms N  проверять docs и data на изменения каждые N мс (0 = только SIGHUP\n"
+            "                и подписанный POST /api/knowledge/admin/reload)\n");
+}
+
+int main(int argc, char **argv) {
+    int port = KOLIBRI_SERVER_PORT;
+    unsigned watch_ms = KOLIBRI_WATCH_MS;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--watch-ms") == 0 && i + 1 < argc) {
+            watch_ms = (unsigned)strtoul(argv[++i], NULL, 10);
+        } else {
+            print_usage();
+            return strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+    }
+    if (port <= 0 || port > 65535) {
+        print_usage();
+        return 1;
+    }
+
+    const char *roots[] = {"docs", "data"};
+    kolibri_knowledge = kolibri_knowledge_handle_create(roots, 2U, watch_ms);
+    if (!kolibri_knowledge) {
         fprintf(stderr, "[kolibri-knowledge] failed to init index\n");
         return 1;
     }
-    kolibri_knowledge_index_load_directory(&index, "docs");
-    kolibri_knowledge_index_load_directory(&index, "data");
-    fprintf(stdout, "[kolibri-knowledge] loaded %zu documents\n", index.count);
-    if (index.count > 0) {
-        write_bootstrap_script(&index, KOLIBRI_BOOTSTRAP_SCRIPT);
+    const KolibriKnowledgeVersion *initial = kolibri_knowledge_acquire(kolibri_knowledge);
+    fprintf(stdout, "[kolibri-knowledge] loaded %zu documents\n", initial->index.count);
+    if (initial->index.count > 0) {
+        write_bootstrap_script(&initial->index, KOLIBRI_BOOTSTRAP_SCRIPT);
     }
+    kolibri_knowledge_release(initial);
+    kolibri_knowledge_handle_on_publish(kolibri_knowledge, knowledge_on_publish, NULL);
 
     kolibri_genome_init_or_open();
 
-    signal(SIGINT, handle_signal);
-    signal(SIGTERM, handle_signal);
+    install_signal(SIGINT);
+    install_signal(SIGTERM);
+    install_signal(SIGHUP);
 
     int server_fd = socket(AF_INET, SOCK_STREAM, 0);
     if (server_fd < 0) {
         perror("socket");
-        kolibri_knowledge_index_free(&index);
+        kolibri_genome_close();
+        kolibri_knowledge_handle_destroy(kolibri_knowledge);
         return 1;
     }
     int reuse = 1;
@@ -595,22 +779,30 @@ int main(void) {
     memset(&addr, 0, sizeof(addr));
     addr.sin_family = AF_INET;
     addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
-    addr.sin_port = htons(KOLIBRI_SERVER_PORT);
+    addr.sin_port = htons((uint16_t)port);
     if (bind(server_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
         perror("bind");
         close(server_fd);
-        kolibri_knowledge_index_free(&index);
+        kolibri_genome_close();
+        kolibri_knowledge_handle_destroy(kolibri_knowledge);
         return 1;
     }
     if (listen(server_fd, KOLIBRI_SERVER_BACKLOG) != 0) {
         perror("listen");
         close(server_fd);
-        kolibri_knowledge_index_free(&index);
+        kolibri_genome_close();
+        kolibri_knowledge_handle_destroy(kolibri_knowledge);
         return 1;
     }
 
-    fprintf(stdout, "[kolibri-knowledge] listening on http://127.0.0.1:%d\n", KOLIBRI_SERVER_PORT);
+    fprintf(stdout, "[kolibri-knowledge] listening on http://127.0.0.1:%d\n", port);
+    fflush(stdout);
     while (kolibri_server_running) {
+        if (kolibri_reload_signal) {
+            kolibri_reload_signal = 0;
+            fprintf(stdout, "[kolibri-knowledge] SIGHUP: reloading index\n");
+            kolibri_knowledge_request_reload(kolibri_knowledge);
+        }
         struct sockaddr_in client_addr;
         socklen_t client_len = sizeof(client_addr);
         int client_fd = accept(server_fd, (struct sockaddr *)&client_addr, &client_len);
@@ -621,13 +813,16 @@ int main(void) {
             perror("accept");
             break;
         }
-        handle_client(client_fd, &index);
+        /* Запрос целиком обслуживается одной версией индекса */
+        const KolibriKnowledgeVersion *version = kolibri_knowledge_acquire(kolibri_knowledge);
+        handle_client(client_fd, version);
+        kolibri_knowledge_release(version);
         close(client_fd);
     }
 
     close(server_fd);
     kolibri_genome_close();
-    kolibri_knowledge_index_free(&index);
+    kolibri_knowledge_handle_destroy(kolibri_knowledge);
     fprintf(stdout, "[kolibri-knowledge] shutdown\n");
     return 0;
 }
@@ -6,20 +6,34 @@
  */
 
 #include "kolibri/logical_memory.h"
+#include <limits.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 
+static int sequence_size(const LogicExpression *expr, size_t *size);
+
 /* ========== СОЗДАНИЕ/УНИЧТОЖЕНИЕ ========== */
 
 LogicalMemory* lm_create(void) {
     LogicalMemory *mem = (LogicalMemory*)calloc(1, sizeof(LogicalMemory));
     if (!mem) return NULL;
     
+    mem->directory_slots = 2 * LM_INLINE_CELLS;
+    mem->directory = (uint32_t*)calloc(mem->directory_slots, sizeof(uint32_t));
+    if (!mem->directory) {
+        free(mem);
+        return NULL;
+    }
+    
     mem->cell_count = 0;
     mem->total_logic_size = 0;
     mem->total_materialized_size = 0;
     mem->compression_ratio = 1.0;
+    mem->cache_budget = LM_DEFAULT_CACHE_BUDGET;
+    mem->lru_head = -1;
+    mem->lru_tail = -1;
+    pthread_mutex_init(&mem->lock, NULL);
     
     return mem;
 }
@@ -29,7 +43,7 @@ void lm_destroy(LogicalMemory *mem) {
     
     /* Освобождаем все ячейки */
     for (size_t i = 0; i < mem->cell_count; i++) {
-        LogicCell *cell = &mem->cells[i];
+        LogicCell *cell = lm_cell_at(mem, i);
         
         /* Освобождаем логику */
         if (cell->logic) {
@@ -44,6 +58,11 @@ void lm_destroy(LogicalMemory *mem) {
         }
     }
     
+    for (size_t i = 0; i < LM_MAX_SEGMENTS; i++) {
+        free(mem->segments[i]);
+    }
+    free(mem->directory);
+    pthread_mutex_destroy(&mem->lock);
     free(mem);
 }
 
@@ -101,7 +120,7 @@ LogicExpression* lm_logic_constant(const char *value) {
 
     expr->type = LOGIC_CONSTANT;
     strncpy(expr->data.constant.value, value, sizeof(expr->data.constant.value) - 1);
-    expr->data.constant.length = strlen(value);
+    expr->data.constant.length = strlen(expr->data.constant.value);
 
     expr->complexity = 0.1;
     expr->materialized_size = expr->data.constant.length;
@@ -126,7 +145,7 @@ LogicExpression* lm_logic_repeat(const char *pattern, size_t count) {
     
     pattern_expr->type = LOGIC_CONSTANT;
     strncpy(pattern_expr->data.constant.value, pattern, sizeof(pattern_expr->data.constant.value) - 1);
-    pattern_expr->data.constant.length = strlen(pattern);
+    pattern_expr->data.constant.length = strlen(pattern_expr->data.constant.value);
     
     expr->data.repeat.pattern = pattern_expr;
     expr->data.repeat.count = count;
@@ -134,7 +153,7 @@ LogicExpression* lm_logic_repeat(const char *pattern, size_t count) {
     /* Метаданные */
     expr->creation_time = 0; /* TODO: timestamp */
     expr->complexity = 1.0;
-    expr->materialized_size = strlen(pattern) * count;
+    expr->materialized_size = pattern_expr->data.constant.length * count;
     
     return expr;
 }
@@ -151,7 +170,10 @@ LogicExpression* lm_logic_sequence(int start, int step, size_t count) {
     expr->data.sequence.count = count;
     
     expr->complexity = 1.0;
-    expr->materialized_size = count * 4; /* Примерно 4 байта на число */
+    if (sequence_size(expr, &expr->materialized_size) != 0) {
+        free(expr);
+        return NULL;
+    }
     
     return expr;
 }
@@ -190,208 +212,698 @@ LogicExpression* lm_logic_relation(LogicExpression *left, LogicExpression *right
     return expr;
 }
 
+/* ========== ХРАНИЛИЩЕ ЯЧЕЕК И ХЭШ-КАТАЛОГ ========== */
+
+LogicCell* lm_cell_at(LogicalMemory *mem, size_t index) {
+    if (!mem || index >= mem->cell_count) return NULL;
+    if (index < LM_INLINE_CELLS) return &mem->cells[index];
+    index -= LM_INLINE_CELLS;
+    return &mem->segments[index / LM_SEGMENT_CELLS][index % LM_SEGMENT_CELLS];
+}
+
+static int32_t cell_index(LogicalMemory *mem, const LogicCell *cell) {
+    if (cell >= mem->cells && cell < mem->cells + LM_INLINE_CELLS) {
+        return (int32_t)(cell - mem->cells);
+    }
+    for (size_t s = 0; s < LM_MAX_SEGMENTS && mem->segments[s]; s++) {
+        const LogicCell *base = mem->segments[s];
+        if (cell >= base && cell < base + LM_SEGMENT_CELLS) {
+            return (int32_t)(LM_INLINE_CELLS + s * LM_SEGMENT_CELLS + (size_t)(cell - base));
+        }
+    }
+    return -1;
+}
+
+/* Свободная ячейка в конце хранилища; сегмент выделяется при первом
+ * обращении. Вызывается под mem->lock */
+static LogicCell* append_slot(LogicalMemory *mem) {
+    size_t index = mem->cell_count;
+    if (index >= LM_MAX_CELLS) return NULL;
+    if (index < LM_INLINE_CELLS) return &mem->cells[index];
+
+    size_t segment = (index - LM_INLINE_CELLS) / LM_SEGMENT_CELLS;
+    if (!mem->segments[segment]) {
+        mem->segments[segment] = (LogicCell*)calloc(LM_SEGMENT_CELLS, sizeof(LogicCell));
+        if (!mem->segments[segment]) return NULL;
+    }
+    return &mem->segments[segment][(index - LM_INLINE_CELLS) % LM_SEGMENT_CELLS];
+}
+
+static uint32_t hash_id(const char *id) {
+    uint32_t h = 2166136261u;  /* FNV-1a */
+    for (const unsigned char *p = (const unsigned char*)id; *p; p++) {
+        h ^= *p;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/* Вставить ячейку index; при повторном ID побеждает первая ячейка,
+ * как при линейном поиске */
+static void directory_insert(LogicalMemory *mem, size_t index) {
+    LogicCell *cell = lm_cell_at(mem, index);
+    size_t mask = mem->directory_slots - 1;
+    size_t slot = cell->id_hash & mask;
+
+    while (mem->directory[slot]) {
+        LogicCell *other = lm_cell_at(mem, mem->directory[slot] - 1);
+        if (other->id_hash == cell->id_hash && strcmp(other->id, cell->id) == 0) return;
+        slot = (slot + 1) & mask;
+    }
+    mem->directory[slot] = (uint32_t)(index + 1);
+}
+
+/* Проиндексировать ячейки, дописанные после последнего поиска.
+ * Каталог заполняется не больше чем наполовину. Вызывается под mem->lock */
+static void directory_sync(LogicalMemory *mem) {
+    if (mem->indexed_count >= mem->cell_count) return;
+
+    size_t slots = mem->directory_slots;
+    while (mem->cell_count * 2 > slots) slots *= 2;
+
+    if (slots != mem->directory_slots) {
+        uint32_t *grown = (uint32_t*)calloc(slots, sizeof(uint32_t));
+        if (grown) {
+            free(mem->directory);
+            mem->directory = grown;
+            mem->directory_slots = slots;
+            mem->indexed_count = 0;
+        } else if (mem->cell_count >= mem->directory_slots) {
+            return;  /* Некуда вставлять - остаётся линейный поиск */
+        }
+    }
+
+    for (size_t i = mem->indexed_count; i < mem->cell_count; i++) {
+        LogicCell *cell = lm_cell_at(mem, i);
+        cell->id_hash = hash_id(cell->id);
+        directory_insert(mem, i);
+    }
+    mem->indexed_count = mem->cell_count;
+}
+
+static LogicCell* find_locked(LogicalMemory *mem, const char *id) {
+    directory_sync(mem);
+
+    uint32_t h = hash_id(id);
+    if (mem->indexed_count == mem->cell_count) {
+        size_t mask = mem->directory_slots - 1;
+        size_t slot = h & mask;
+        while (mem->directory[slot]) {
+            LogicCell *cell = lm_cell_at(mem, mem->directory[slot] - 1);
+            if (cell->id_hash == h && strcmp(cell->id, id) == 0) return cell;
+            slot = (slot + 1) & mask;
+        }
+        return NULL;
+    }
+
+    for (size_t i = 0; i < mem->cell_count; i++) {
+        LogicCell *cell = lm_cell_at(mem, i);
+        if (strcmp(cell->id, id) == 0) return cell;
+    }
+    return NULL;
+}
+
+LogicCell* lm_find_cell(LogicalMemory *mem, const char *id) {
+    if (!mem || !id) return NULL;
+
+    pthread_mutex_lock(&mem->lock);
+    LogicCell *cell = find_locked(mem, id);
+    pthread_mutex_unlock(&mem->lock);
+    return cell;
+}
+
 /* ========== ХРАНЕНИЕ И МАТЕРИАЛИЗАЦИЯ ========== */
 
-int lm_store_logic(LogicalMemory *mem, const char *id, LogicExpression *logic) {
-    if (!mem || !id || !logic) return -1;
-    if (mem->cell_count >= 1024) return -1;
-    
-    LogicCell *cell = &mem->cells[mem->cell_count];
-    
-    strncpy(cell->id, id, sizeof(cell->id) - 1);
-    cell->logic = logic;
-    cell->cached_data = NULL;
-    cell->cached_size = 0;
-    cell->cache_valid = 0;
-    cell->dependency_count = 0;
-    
+static void account_logic(LogicalMemory *mem, LogicExpression *logic) {
+    size_t size = 0;
+    if (lm_logic_size(logic, &size) == 0) {
+        logic->materialized_size = size;
+    }
+
     mem->total_logic_size += sizeof(LogicExpression);
     mem->total_materialized_size += logic->materialized_size;
-    
+
     if (mem->total_materialized_size > 0) {
         mem->compression_ratio = (double)mem->total_materialized_size / mem->total_logic_size;
     }
-    
+}
+
+/* Вызывается под mem->lock */
+static int store_locked(LogicalMemory *mem, const char *id, LogicExpression *logic) {
+    LogicCell *cell = append_slot(mem);
+    if (!cell) return -1;
+
+    memset(cell, 0, sizeof(*cell));
+    strncpy(cell->id, id, sizeof(cell->id) - 1);
+    cell->logic = logic;
+    cell->lru_prev = -1;
+    cell->lru_next = -1;
+
+    account_logic(mem, logic);
+
     mem->cell_count++;
+    directory_sync(mem);
     return 0;
 }
 
-/* Материализация LOGIC_REPEAT */
-static int materialize_repeat(LogicExpression *expr, char *output, size_t output_size) {
-    if (expr->type != LOGIC_REPEAT) return -1;
-    
-    LogicExpression *pattern = expr->data.repeat.pattern;
-    if (pattern->type != LOGIC_CONSTANT) return -1;
-    
-    const char *pat = pattern->data.constant.value;
-    size_t pat_len = pattern->data.constant.length;
-    size_t count = expr->data.repeat.count;
-    
-    size_t required = pat_len * count;
-    if (output_size < required + 1) return -1;
-    
-    size_t pos = 0;
-    for (size_t i = 0; i < count; i++) {
-        memcpy(output + pos, pat, pat_len);
-        pos += pat_len;
+int lm_store_logic(LogicalMemory *mem, const char *id, LogicExpression *logic) {
+    if (!mem || !id || !logic) return -1;
+
+    pthread_mutex_lock(&mem->lock);
+    int rc = store_locked(mem, id, logic);
+    pthread_mutex_unlock(&mem->lock);
+    return rc;
+}
+
+static void cache_drop(LogicalMemory *mem, LogicCell *cell);
+
+/* Закрепление логики: читатель вне блокировки держит pins, а замена в
+ * ячейке только помечает выражение, пока его кто-то читает. Пока выражение
+ * закреплено, его адрес не может достаться новому. Вызываются под mem->lock */
+static void logic_unpin_locked(LogicExpression *logic) {
+    if (--logic->pins == 0 && logic->retired) lm_destroy_logic(logic);
+}
+
+static void logic_retire_locked(LogicExpression *logic) {
+    if (logic->pins > 0) logic->retired = 1;
+    else lm_destroy_logic(logic);
+}
+
+const LogicExpression* lm_acquire_logic(LogicalMemory *mem, const char *id) {
+    if (!mem || !id) return NULL;
+
+    pthread_mutex_lock(&mem->lock);
+    LogicCell *cell = find_locked(mem, id);
+    LogicExpression *logic = cell ? cell->logic : NULL;
+    if (logic) logic->pins++;
+    pthread_mutex_unlock(&mem->lock);
+    return logic;
+}
+
+void lm_release_logic(LogicalMemory *mem, const LogicExpression *logic) {
+    if (!mem || !logic) return;
+
+    pthread_mutex_lock(&mem->lock);
+    logic_unpin_locked((LogicExpression*)logic);
+    pthread_mutex_unlock(&mem->lock);
+}
+
+int lm_put_logic(LogicalMemory *mem, const char *id, LogicExpression *logic) {
+    if (!mem || !id || !logic) return -1;
+
+    pthread_mutex_lock(&mem->lock);
+    LogicCell *cell = find_locked(mem, id);
+    int rc = 0;
+    if (!cell) {
+        rc = store_locked(mem, id, logic);
+    } else if (cell->logic != logic) {
+        cache_drop(mem, cell);
+        if (cell->logic) {
+            mem->total_logic_size -= sizeof(LogicExpression);
+            mem->total_materialized_size -= cell->logic->materialized_size;
+            logic_retire_locked(cell->logic);
+        }
+        cell->logic = logic;
+        account_logic(mem, logic);
     }
-    output[pos] = '\0';
-    
-    return (int)pos;
+    pthread_mutex_unlock(&mem->lock);
+    return rc;
 }
 
-/* Материализация LOGIC_SEQUENCE */
-static int materialize_sequence(LogicExpression *expr, char *output, size_t output_size) {
-    if (expr->type != LOGIC_SEQUENCE) return -1;
-    
-    int value = expr->data.sequence.start;
-    int step = expr->data.sequence.step;
+int lm_add_dependency(LogicalMemory *mem, const char *id, const char *dependency_id) {
+    if (!mem || !id || !dependency_id) return -1;
+
+    pthread_mutex_lock(&mem->lock);
+    LogicCell *cell = find_locked(mem, id);
+    int rc = -1;
+    if (cell && cell->dependency_count < 16) {
+        strncpy(cell->dependencies[cell->dependency_count], dependency_id,
+                sizeof(cell->dependencies[0]) - 1);
+        cell->dependency_count++;
+        rc = 0;
+    }
+    pthread_mutex_unlock(&mem->lock);
+    return rc;
+}
+
+/* ---------- Быстрое форматирование чисел ---------- */
+
+static const char digit_pairs[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/* Число десятичных разрядов |v| */
+static size_t count_digits(uint64_t u) {
+    size_t digits = 1;
+    while (u >= 10000) { u /= 10000; digits += 4; }
+    if (u >= 1000) return digits + 3;
+    if (u >= 100) return digits + 2;
+    if (u >= 10) return digits + 1;
+    return digits;
+}
+
+/* Десятичная запись без snprintf, по две цифры за шаг; out >= 21 байт */
+static size_t format_int64(int64_t value, char *out) {
+    uint64_t u = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+    size_t len = count_digits(u) + (value < 0);
+    char *p = out + len;
+
+    while (u >= 100) {
+        size_t pair = (size_t)(u % 100) * 2;
+        u /= 100;
+        *--p = digit_pairs[pair + 1];
+        *--p = digit_pairs[pair];
+    }
+    if (u >= 10) {
+        *--p = digit_pairs[u * 2 + 1];
+        *--p = digit_pairs[u * 2];
+    } else {
+        *--p = (char)('0' + u);
+    }
+    if (value < 0) *--p = '-';
+
+    return len;
+}
+
+/* ---------- Арифметика LOGIC_SEQUENCE ---------- */
+
+/*
+ * Элемент i равен start + i*step, его длина кусочно-постоянна: она
+ * меняется только на границах 10^k и в нуле. Последовательность монотонна,
+ * поэтому она проходит не более ~40 таких "полос", и размер, и поиск
+ * элемента по смещению считаются по полосам, без перебора элементов.
+ */
+
+typedef struct {
+    size_t index;      /* Первый элемент полосы */
+    int64_t value;     /* Его значение */
+    size_t count;      /* Элементов в полосе */
+    size_t length;     /* Длина каждого элемента */
+} SequenceRun;
+
+static int sequence_valid(const LogicExpression *expr) {
+    int64_t step = expr->data.sequence.step;
+    uint64_t magnitude = step < 0 ? 0 - (uint64_t)step : (uint64_t)step;
     size_t count = expr->data.sequence.count;
-    
-    size_t pos = 0;
-    for (size_t i = 0; i < count; i++) {
-        int written = snprintf(output + pos, output_size - pos, "%d", value);
-        if (written < 0 || (size_t)written >= output_size - pos) return -1;
-        pos += written;
-        value += step;
+
+    /* start + (count-1)*step должно помещаться в int64 с запасом */
+    return count == 0 || magnitude == 0 || (uint64_t)(count - 1) <= (UINT64_C(1) << 61) / magnitude;
+}
+
+static void sequence_run(const LogicExpression *expr, size_t index, SequenceRun *run) {
+    int64_t step = expr->data.sequence.step;
+    int64_t value = (int64_t)expr->data.sequence.start + (int64_t)index * step;
+    size_t remaining = expr->data.sequence.count - index;
+
+    uint64_t u = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+    size_t digits = count_digits(u);
+
+    /* Полоса [lo, hi] значений той же длины */
+    int64_t lo, hi;
+    uint64_t low_magnitude = 1;
+    for (size_t i = 1; i < digits; i++) low_magnitude *= 10;
+    uint64_t high_magnitude = digits >= 19 ? (uint64_t)INT64_MAX : low_magnitude * 10 - 1;
+
+    if (value > 0) {
+        lo = (int64_t)low_magnitude;
+        hi = (int64_t)high_magnitude;
+    } else if (value == 0) {
+        lo = hi = 0;
+    } else {
+        lo = -(int64_t)high_magnitude;
+        hi = -(int64_t)low_magnitude;
     }
-    
-    return (int)pos;
+
+    size_t in_band = remaining;
+    if (step > 0) {
+        uint64_t steps = (uint64_t)(hi - value) / (uint64_t)step + 1;
+        if (steps < in_band) in_band = (size_t)steps;
+    } else if (step < 0) {
+        uint64_t steps = (uint64_t)(value - lo) / (0 - (uint64_t)step) + 1;
+        if (steps < in_band) in_band = (size_t)steps;
+    }
+
+    run->index = index;
+    run->value = value;
+    run->count = in_band;
+    run->length = digits + (value < 0);
 }
 
-/* Материализация LOGIC_COMPOSITION */
-static int materialize_composition(LogicExpression *expr, char *output, size_t output_size) {
-    if (expr->type != LOGIC_COMPOSITION) return -1;
-    
-    size_t pos = 0;
-    for (size_t i = 0; i < expr->data.composition.count; i++) {
-        LogicExpression *sub = expr->data.composition.expressions[i];
-        
-        int result;
-        switch (sub->type) {
-            case LOGIC_REPEAT:
-                result = materialize_repeat(sub, output + pos, output_size - pos);
-                break;
-            case LOGIC_SEQUENCE:
-                result = materialize_sequence(sub, output + pos, output_size - pos);
-                break;
-            case LOGIC_CONSTANT:
-                result = snprintf(output + pos, output_size - pos, "%s", sub->data.constant.value);
-                break;
-            default:
-                return -1;
-        }
-        
-        if (result < 0) return -1;
-        pos += result;
+static int sequence_size(const LogicExpression *expr, size_t *size) {
+    if (!sequence_valid(expr)) return -1;
+
+    size_t total = 0;
+    SequenceRun run;
+    for (size_t index = 0; index < expr->data.sequence.count; index += run.count) {
+        sequence_run(expr, index, &run);
+        if (run.count > (SIZE_MAX - total) / run.length) return -1;
+        total += run.count * run.length;
     }
-    
-    return (int)pos;
+
+    *size = total;
+    return 0;
 }
 
-int lm_materialize(LogicalMemory *mem, const char *id, void *output, size_t output_size) {
-    if (!mem || !id || !output) return -1;
-    
-    /* Найти ячейку */
-    LogicCell *cell = NULL;
-    for (size_t i = 0; i < mem->cell_count; i++) {
-        if (strcmp(mem->cells[i].id, id) == 0) {
-            cell = &mem->cells[i];
-            break;
-        }
+static size_t read_sequence(const LogicExpression *expr, size_t offset, char *out, size_t len) {
+    /* Найти элемент, содержащий offset */
+    SequenceRun run;
+    size_t index = 0;
+    for (;;) {
+        sequence_run(expr, index, &run);
+        size_t bytes = run.count * run.length;
+        if (offset < bytes) break;
+        offset -= bytes;
+        index += run.count;
     }
-    
-    if (!cell || !cell->logic) return -1;
-    
-    /* Проверить кэш */
-    if (cell->cache_valid && cell->cached_data) {
-        size_t copy_size = cell->cached_size < output_size ? cell->cached_size : output_size;
-        memcpy(output, cell->cached_data, copy_size);
-        return (int)copy_size;
+
+    int64_t value = run.value + (int64_t)(offset / run.length) * expr->data.sequence.step;
+    size_t skip = offset % run.length;
+
+    /* Дальше - последовательная запись элементов */
+    size_t pos = 0;
+    char digits[24];
+    while (pos < len) {
+        size_t n = format_int64(value, digits) - skip;
+        if (n > len - pos) n = len - pos;
+        memcpy(out + pos, digits + skip, n);
+        pos += n;
+        skip = 0;
+        value += expr->data.sequence.step;
     }
-    
-    /* Материализация в зависимости от типа */
-    int result = -1;
-    switch (cell->logic->type) {
-        case LOGIC_REPEAT:
-            result = materialize_repeat(cell->logic, (char*)output, output_size);
-            break;
-        case LOGIC_SEQUENCE:
-            result = materialize_sequence(cell->logic, (char*)output, output_size);
-            break;
-        case LOGIC_COMPOSITION:
-            result = materialize_composition(cell->logic, (char*)output, output_size);
-            break;
+
+    return pos;
+}
+
+/* ---------- Размер и чтение произвольного выражения ---------- */
+
+static size_t constant_length(const LogicExpression *expr) {
+    /* Значение хранится в массиве фиксированной длины и может быть обрезано */
+    size_t stored = strnlen(expr->data.constant.value, sizeof(expr->data.constant.value));
+    return expr->data.constant.length < stored ? expr->data.constant.length : stored;
+}
+
+int lm_logic_size(const LogicExpression *logic, size_t *size) {
+    if (!logic || !size) return -1;
+
+    switch (logic->type) {
         case LOGIC_CONSTANT:
-            result = snprintf((char*)output, output_size, "%s", cell->logic->data.constant.value);
-            break;
+            *size = constant_length(logic);
+            return 0;
+
+        case LOGIC_VARIABLE:
+            return lm_logic_size(logic->data.variable.binding, size);
+
+        case LOGIC_REPEAT: {
+            size_t pattern_size;
+            if (lm_logic_size(logic->data.repeat.pattern, &pattern_size) != 0) return -1;
+            size_t count = logic->data.repeat.count;
+            if (pattern_size && count > SIZE_MAX / pattern_size) return -1;
+            *size = pattern_size * count;
+            return 0;
+        }
+
+        case LOGIC_SEQUENCE:
+            return sequence_size(logic, size);
+
+        case LOGIC_COMPOSITION: {
+            size_t total = 0;
+            if (logic->data.composition.count > 8) return -1;
+            for (size_t i = 0; i < logic->data.composition.count; i++) {
+                size_t part;
+                if (lm_logic_size(logic->data.composition.expressions[i], &part) != 0) return -1;
+                if (part > SIZE_MAX - total) return -1;
+                total += part;
+            }
+            *size = total;
+            return 0;
+        }
+
         default:
             return -1;
     }
-    
-    /* Кэшируем результат */
-    if (result > 0) {
-        cell->cached_data = malloc(result);
-        if (cell->cached_data) {
-            memcpy(cell->cached_data, output, result);
-            cell->cached_size = result;
-            cell->cache_valid = 1;
+}
+
+/* Записать len байт материализации начиная с offset.
+ * Вызывающий гарантирует offset + len <= размер и материализуемость */
+static size_t logic_read(const LogicExpression *expr, size_t offset, char *out, size_t len) {
+    if (len == 0) return 0;
+
+    switch (expr->type) {
+        case LOGIC_CONSTANT:
+            memcpy(out, expr->data.constant.value + offset, len);
+            return len;
+
+        case LOGIC_VARIABLE:
+            return logic_read(expr->data.variable.binding, offset, out, len);
+
+        case LOGIC_REPEAT: {
+            const LogicExpression *pattern = expr->data.repeat.pattern;
+            size_t period = 0;
+            lm_logic_size(pattern, &period);
+
+            /* Первый период читаем из паттерна (с переносом через его конец) */
+            size_t start = offset % period;
+            size_t first = len < period ? len : period;
+            size_t head = period - start < first ? period - start : first;
+            logic_read(pattern, start, out, head);
+            logic_read(pattern, 0, out + head, first - head);
+
+            /* Остальное периодично: удваиваем уже записанное */
+            size_t pos = first;
+            while (pos < len) {
+                size_t n = len - pos < pos ? len - pos : pos;
+                memcpy(out + pos, out, n);
+                pos += n;
+            }
+            return len;
+        }
+
+        case LOGIC_SEQUENCE:
+            return read_sequence(expr, offset, out, len);
+
+        case LOGIC_COMPOSITION: {
+            size_t pos = 0;
+            for (size_t i = 0; i < expr->data.composition.count && pos < len; i++) {
+                const LogicExpression *sub = expr->data.composition.expressions[i];
+                size_t part = 0;
+                lm_logic_size(sub, &part);
+                if (offset >= part) {
+                    offset -= part;
+                    continue;
+                }
+                size_t n = part - offset < len - pos ? part - offset : len - pos;
+                pos += logic_read(sub, offset, out + pos, n);
+                offset = 0;
+            }
+            return pos;
         }
+
+        default:
+            return 0;
     }
-    
-    return result;
 }
 
-char* lm_materialize_logic(LogicExpression* logic) {
-    if (!logic) return NULL;
+/* ---------- LRU-кэш материализаций ---------- */
+
+static LogicCell* lru_cell(LogicalMemory *mem, int32_t index) {
+    return lm_cell_at(mem, (size_t)index);
+}
+
+static void lru_unlink(LogicalMemory *mem, LogicCell *cell) {
+    if (cell->lru_prev >= 0) lru_cell(mem, cell->lru_prev)->lru_next = cell->lru_next;
+    else mem->lru_head = cell->lru_next;
+    if (cell->lru_next >= 0) lru_cell(mem, cell->lru_next)->lru_prev = cell->lru_prev;
+    else mem->lru_tail = cell->lru_prev;
+}
+
+static void lru_push_front(LogicalMemory *mem, LogicCell *cell) {
+    int32_t index = cell_index(mem, cell);
+    cell->lru_prev = -1;
+    cell->lru_next = mem->lru_head;
+    if (mem->lru_head >= 0) lru_cell(mem, mem->lru_head)->lru_prev = index;
+    else mem->lru_tail = index;
+    mem->lru_head = index;
+}
+
+/* Выбросить материализацию ячейки из кэша. Вызывается под mem->lock */
+static void cache_drop(LogicalMemory *mem, LogicCell *cell) {
+    if (!cell->cache_valid) return;
+    lru_unlink(mem, cell);
+    mem->cache_bytes -= cell->cached_size;
+    free(cell->cached_data);
+    cell->cached_data = NULL;
+    cell->cached_size = 0;
+    cell->cache_valid = 0;
+}
+
+static void cache_evict_until(LogicalMemory *mem, size_t limit) {
+    while (mem->cache_bytes > limit && mem->lru_tail >= 0) {
+        cache_drop(mem, lru_cell(mem, mem->lru_tail));
+        mem->cache_evictions++;
+    }
+}
+
+void lm_set_cache_budget(LogicalMemory *mem, size_t budget) {
+    if (!mem) return;
+    pthread_mutex_lock(&mem->lock);
+    mem->cache_budget = budget;
+    cache_evict_until(mem, budget);
+    pthread_mutex_unlock(&mem->lock);
+}
+
+/* Вызывается под mem->lock */
+static void cache_store(LogicalMemory *mem, LogicCell *cell, const void *data, size_t size) {
+    if (cell->cache_valid || size == 0 || size > mem->cache_budget) return;
+
+    cache_evict_until(mem, mem->cache_budget - size);
+
+    cell->cached_data = malloc(size);
+    if (!cell->cached_data) return;
+    memcpy(cell->cached_data, data, size);
+    cell->cached_size = size;
+    cell->cache_timestamp = mem->cache_hits + mem->cache_misses;
+    cell->cache_valid = 1;
+    mem->cache_bytes += size;
+    lru_push_front(mem, cell);
+}
+
+int lm_materialize(LogicalMemory *mem, const char *id, void *output, size_t output_size) {
+    if (!mem || !id || !output) return -1;
 
-    size_t predicted_size = logic->materialized_size;
-    if (predicted_size == 0) { // Fallback for relations or un-sized logic
-        predicted_size = 4096;
+    pthread_mutex_lock(&mem->lock);
+    LogicCell *cell = find_locked(mem, id);
+    if (!cell || !cell->logic) {
+        pthread_mutex_unlock(&mem->lock);
+        return -1;
     }
 
-    char* buffer = malloc(predicted_size + 1);
-    if (!buffer) return NULL;
+    /* Проверить кэш */
+    if (cell->cache_valid && cell->cached_data) {
+        int result = -1;
+        if (output_size >= cell->cached_size + 1) {
+            memcpy(output, cell->cached_data, cell->cached_size);
+            ((char*)output)[cell->cached_size] = '\0';
+            result = (int)cell->cached_size;
+
+            mem->cache_hits++;
+            cell->cache_timestamp = mem->cache_hits + mem->cache_misses;
+            lru_unlink(mem, cell);
+            lru_push_front(mem, cell);
+        }
+        pthread_mutex_unlock(&mem->lock);
+        return result;
+    }
+    mem->cache_misses++;
+    LogicExpression *logic = cell->logic;
+    logic->pins++;
+    pthread_mutex_unlock(&mem->lock);
 
+    /* Материализация - вне блокировки, выражение закреплено */
+    size_t size;
     int result = -1;
-    switch (logic->type) {
-        case LOGIC_REPEAT:
-            result = materialize_repeat(logic, buffer, predicted_size + 1);
-            break;
-        case LOGIC_SEQUENCE:
-            result = materialize_sequence(logic, buffer, predicted_size + 1);
-            break;
-        case LOGIC_COMPOSITION:
-            result = materialize_composition(logic, buffer, predicted_size + 1);
-            break;
-        case LOGIC_CONSTANT:
-            result = snprintf(buffer, predicted_size + 1, "%s", logic->data.constant.value);
-            break;
-        default:
-            free(buffer);
-            return NULL;
+    if (lm_logic_size(logic, &size) == 0 && size <= INT_MAX && output_size >= size + 1) {
+        logic_read(logic, 0, (char*)output, size);
+        ((char*)output)[size] = '\0';
+        result = (int)size;
     }
 
-    if (result < 0) {
-        free(buffer);
-        return NULL;
-    }
+    /* Кэшируем результат в пределах бюджета, если ячейку не перезаписали */
+    pthread_mutex_lock(&mem->lock);
+    if (result >= 0 && cell->logic == logic) cache_store(mem, cell, output, size);
+    logic_unpin_locked(logic);
+    pthread_mutex_unlock(&mem->lock);
+
+    return result;
+}
 
+char* lm_materialize_logic(LogicExpression* logic) {
+    size_t size;
+    if (lm_logic_size(logic, &size) != 0 || size == SIZE_MAX) return NULL;
+
+    char* buffer = malloc(size + 1);
+    if (!buffer) return NULL;
+
+    logic_read(logic, 0, buffer, size);
+    buffer[size] = '\0';
     return buffer;
 }
 
 size_t lm_predict_size(LogicalMemory *mem, const char *id) {
     if (!mem || !id) return 0;
-    
-    for (size_t i = 0; i < mem->cell_count; i++) {
-        if (strcmp(mem->cells[i].id, id) == 0) {
-            return mem->cells[i].logic->materialized_size;
-        }
+
+    pthread_mutex_lock(&mem->lock);
+    LogicCell *cell = find_locked(mem, id);
+    size_t size = 0;
+    if (cell && cell->logic && lm_logic_size(cell->logic, &size) != 0) {
+        size = cell->logic->materialized_size;
     }
-    
+    pthread_mutex_unlock(&mem->lock);
+    return size;
+}
+
+/* ========== ПОТОКОВАЯ МАТЕРИАЛИЗАЦИЯ ========== */
+
+int lm_cursor_open_logic(const LogicExpression *logic, LogicCursor *cursor) {
+    if (!logic || !cursor) return -1;
+
+    size_t size;
+    if (lm_logic_size(logic, &size) != 0) return -1;
+
+    cursor->mem = NULL;
+    cursor->logic = logic;
+    cursor->size = size;
+    cursor->offset = 0;
+    return 0;
+}
+
+int lm_cursor_open(LogicalMemory *mem, const char *id, LogicCursor *cursor) {
+    if (!cursor) return -1;
+
+    const LogicExpression *logic = lm_acquire_logic(mem, id);
+    if (lm_cursor_open_logic(logic, cursor) != 0) {
+        lm_release_logic(mem, logic);
+        return -1;
+    }
+    cursor->mem = mem;
+    return 0;
+}
+
+void lm_cursor_close(LogicCursor *cursor) {
+    if (!cursor) return;
+    lm_release_logic(cursor->mem, cursor->logic);
+    cursor->mem = NULL;
+    cursor->logic = NULL;
+    cursor->size = 0;
+    cursor->offset = 0;
+}
+
+size_t lm_cursor_read(LogicCursor *cursor, void *buffer, size_t size) {
+    if (!cursor || !cursor->logic || !buffer) return 0;
+    if (cursor->offset >= cursor->size) return 0;
+
+    size_t n = cursor->size - cursor->offset;
+    if (n > size) n = size;
+
+    n = logic_read(cursor->logic, cursor->offset, (char*)buffer, n);
+    cursor->offset += n;
+    return n;
+}
+
+int lm_cursor_seek(LogicCursor *cursor, size_t offset) {
+    if (!cursor || offset > cursor->size) return -1;
+    cursor->offset = offset;
     return 0;
 }
 
+size_t lm_cursor_tell(const LogicCursor *cursor) {
+    return cursor ? cursor->offset : 0;
+}
+
+size_t lm_cursor_size(const LogicCursor *cursor) {
+    return cursor ? cursor->size : 0;
+}
+
 /* ========== УТИЛИТЫ ========== */
 
 double lm_compute_complexity(LogicExpression *logic) {
@@ -434,6 +946,7 @@ int lm_logic_to_string(LogicExpression *logic, char *output, size_t output_size)
 int lm_get_stats(LogicalMemory *mem, LogicalMemoryStats *stats) {
     if (!mem || !stats) return -1;
     
+    pthread_mutex_lock(&mem->lock);
     stats->total_cells = mem->cell_count;
     stats->logic_size_bytes = mem->total_logic_size;
     stats->predicted_data_size = mem->total_materialized_size;
@@ -441,14 +954,19 @@ int lm_get_stats(LogicalMemory *mem, LogicalMemoryStats *stats) {
     
     stats->cached_cells = 0;
     for (size_t i = 0; i < mem->cell_count; i++) {
-        if (mem->cells[i].cache_valid) {
+        if (lm_cell_at(mem, i)->cache_valid) {
             stats->cached_cells++;
         }
     }
     
-    stats->cache_hit_rate = mem->cell_count > 0 
-        ? (double)stats->cached_cells / mem->cell_count 
-        : 0.0;
+    size_t lookups = mem->cache_hits + mem->cache_misses;
+    stats->cache_hit_rate = lookups > 0 ? mem->cache_hits * 100 / lookups : 0;
+    stats->cache_bytes = mem->cache_bytes;
+    stats->cache_budget = mem->cache_budget;
+    stats->cache_hits = mem->cache_hits;
+    stats->cache_misses = mem->cache_misses;
+    stats->cache_evictions = mem->cache_evictions;
+    pthread_mutex_unlock(&mem->lock);
     
     return 0;
 }
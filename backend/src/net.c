@@ -156,6 +156,24 @@ size_t kn_message_encode_ack(uint8_t *buffer, size_t buffer_len,
   return header + sizeof(payload);
 }
 
+int kn_message_frame_size(const uint8_t *buffer, size_t buffer_len,
+                          size_t *out_size) {
+  if (!buffer || !out_size) {
+    return -1;
+  }
+  if (buffer_len < KOLIBRI_HEADER_SIZE) {
+    return 0;
+  }
+  uint16_t payload_len;
+  memcpy(&payload_len, &buffer[1], sizeof(payload_len));
+  payload_len = ntohs(payload_len);
+  if (payload_len > KOLIBRI_MAX_PAYLOAD) {
+    return -1;
+  }
+  *out_size = KOLIBRI_HEADER_SIZE + payload_len;
+  return 1;
+}
+
 int kn_message_decode(const uint8_t *buffer, size_t buffer_len,
                       KolibriNetMessage *out_message) {
   if (!buffer || buffer_len < KOLIBRI_HEADER_SIZE || !out_message) {
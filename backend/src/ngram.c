@@ -0,0 +1,963 @@
+/*
+ * Copyright (c) 2025 Кочуров Владислав Евгеньевич
+ * N-gram Language Model
+ *
+ * Образ модели - один непрерывный блок: заголовок со смещениями секций,
+ * словарь (строки, смещения, хэш-таблица), униграммы и для каждого
+ * порядка k >= 2 отсортированные по ключу контексты с преемниками.
+ * Вероятности хранятся как 10-битные -log2(p) * 32, поэтому одна
+ * n-грамма занимает 4 байта, а контекст - 16. Один и тот же образ
+ * либо строится в памяти, либо отображается из файла без копирования.
+ */
+
+#include "kolibri/ngram.h"
+
+#include <ctype.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define NGRAM_MAGIC 0x4D474E4Bu   /* "KNGM" */
+#define NGRAM_VERSION 1u
+#define NGRAM_Q_SCALE 32.0
+#define NGRAM_Q_MAX 1023u
+#define NGRAM_Q_BITS 10u
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t order;
+    uint32_t vocab_size;
+    uint32_t hash_slots;
+    uint32_t reserved;
+    uint64_t total_tokens;
+    uint64_t file_size;
+    uint64_t strings_offset;       /* Слова через '\0' */
+    uint64_t strings_size;
+    uint64_t offsets_offset;       /* uint32_t[vocab_size + 1] */
+    uint64_t hash_offset;          /* uint32_t[hash_slots]: номер + 1 */
+    uint64_t unigram_offset;       /* uint16_t[vocab_size]: q */
+    uint64_t rank_offset;          /* uint32_t[vocab_size]: по убыванию частоты */
+    uint64_t histogram_offset;     /* uint32_t[NGRAM_Q_MAX + 1]: слов с данным q */
+    uint64_t context_offset[KOLIBRI_NGRAM_MAX_ORDER + 1];
+    uint64_t context_count[KOLIBRI_NGRAM_MAX_ORDER + 1];
+    uint64_t successor_offset[KOLIBRI_NGRAM_MAX_ORDER + 1];
+    uint64_t successor_count[KOLIBRI_NGRAM_MAX_ORDER + 1];
+} NgramHeader;
+
+/* Контекст: первые преемники, их число (22 бита) и q ухода (10 бит) */
+typedef struct {
+    uint64_t key;
+    uint32_t first;
+    uint32_t packed;
+} NgramContext;
+
+struct KolibriNgramModel {
+    const uint8_t *base;
+    size_t size;
+    int mapped;
+    unsigned order;
+    uint32_t vocab;
+    uint32_t hash_mask;
+    uint64_t total_tokens;
+    const char *strings;
+    size_t strings_size;
+    const uint32_t *offsets;
+    const uint32_t *hash;
+    const uint16_t *unigram;
+    const uint32_t *rank;
+    const uint32_t *histogram;
+    const NgramContext *contexts[KOLIBRI_NGRAM_MAX_ORDER + 1];
+    size_t context_count[KOLIBRI_NGRAM_MAX_ORDER + 1];
+    const uint32_t *successors[KOLIBRI_NGRAM_MAX_ORDER + 1];
+    size_t successor_count[KOLIBRI_NGRAM_MAX_ORDER + 1];
+    double prob[NGRAM_Q_MAX + 1];  /* q -> вероятность */
+};
+
+/* Счётчик n-граммы в построителе; count == 0 - пустой слот */
+typedef struct {
+    uint64_t key;
+    uint32_t word;
+    uint32_t count;
+} NgramCount;
+
+typedef struct {
+    NgramCount *slots;
+    size_t capacity;
+    size_t used;
+} NgramTable;
+
+struct KolibriNgramBuilder {
+    unsigned order;
+    char *strings;
+    size_t strings_size;
+    size_t strings_capacity;
+    uint32_t *offsets;             /* vocab + 1 */
+    uint64_t *counts;
+    size_t vocab;
+    size_t vocab_capacity;
+    uint32_t *hash;                /* номер + 1 */
+    size_t hash_slots;
+    uint64_t total_tokens;
+    NgramTable tables[KOLIBRI_NGRAM_MAX_ORDER + 1];
+};
+
+/* ---------- Хэши и токенизация ---------- */
+
+static uint32_t ngram_hash_word(const char *word, size_t len) {
+    uint32_t h = 2166136261u;  /* FNV-1a */
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)word[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static uint64_t ngram_mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+    return x;
+}
+
+/* Ключ контекста из n последних слов; порядок входит в ключ */
+static uint64_t ngram_context_key(const uint32_t *words, size_t n) {
+    uint64_t h = (uint64_t)n;
+    for (size_t i = 0; i < n; i++) {
+        h = ngram_mix(h * 0x9E3779B97F4A7C15ULL + words[i] + 1);
+    }
+    return h;
+}
+
+static int ngram_separator(unsigned char c) {
+    return isspace(c) || ispunct(c);
+}
+
+/* Следующее слово текста начиная с *pos; 0 - слов больше нет */
+static int ngram_next_word(const char *text, size_t text_len, size_t *pos,
+                           const char **word, size_t *len) {
+    size_t i = *pos;
+    while (i < text_len && ngram_separator((unsigned char)text[i])) i++;
+    if (i >= text_len) {
+        *pos = i;
+        return 0;
+    }
+    size_t start = i;
+    while (i < text_len && !ngram_separator((unsigned char)text[i])) i++;
+    *pos = i;
+    *word = text + start;
+    *len = i - start;
+    if (*len > KOLIBRI_NGRAM_MAX_WORD) *len = KOLIBRI_NGRAM_MAX_WORD;
+    return 1;
+}
+
+static unsigned ngram_quantize(double p) {
+    if (!(p > 0.0)) return NGRAM_Q_MAX;
+    double q = -log2(p) * NGRAM_Q_SCALE + 0.5;
+    if (q < 0.0) return 0;
+    if (q >= (double)NGRAM_Q_MAX) return NGRAM_Q_MAX;
+    return (unsigned)q;
+}
+
+static uint64_t ngram_random(uint64_t *state) {
+    uint64_t x = *state ? *state : 0x9E3779B97F4A7C15ULL;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+static double ngram_uniform(uint64_t *state) {
+    return (double)(ngram_random(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* ---------- Построитель ---------- */
+
+static int builder_grow_hash(KolibriNgramBuilder *b) {
+    size_t slots = b->hash_slots ? b->hash_slots * 2 : 1024;
+    uint32_t *hash = (uint32_t *)calloc(slots, sizeof(uint32_t));
+    if (!hash) return -1;
+    for (size_t id = 1; id < b->vocab; id++) {
+        const char *word = b->strings + b->offsets[id];
+        size_t len = b->offsets[id + 1] - b->offsets[id] - 1;
+        size_t slot = ngram_hash_word(word, len) & (slots - 1);
+        while (hash[slot]) slot = (slot + 1) & (slots - 1);
+        hash[slot] = (uint32_t)id + 1;
+    }
+    free(b->hash);
+    b->hash = hash;
+    b->hash_slots = slots;
+    return 0;
+}
+
+static uint32_t builder_find(const KolibriNgramBuilder *b, const char *word, size_t len,
+                             size_t *slot_out) {
+    size_t mask = b->hash_slots - 1;
+    size_t slot = ngram_hash_word(word, len) & mask;
+    while (b->hash[slot]) {
+        uint32_t id = b->hash[slot] - 1;
+        if (b->offsets[id + 1] - b->offsets[id] - 1 == len &&
+            memcmp(b->strings + b->offsets[id], word, len) == 0) {
+            return id;
+        }
+        slot = (slot + 1) & mask;
+    }
+    *slot_out = slot;
+    return KOLIBRI_NGRAM_UNK;
+}
+
+/* Номер слова, новое слово добавляется; UNK при переполнении */
+static uint32_t builder_intern(KolibriNgramBuilder *b, const char *word, size_t len) {
+    size_t slot = 0;
+    uint32_t id = builder_find(b, word, len, &slot);
+    if (id != KOLIBRI_NGRAM_UNK) return id;
+    if (b->vocab > KOLIBRI_NGRAM_MAX_VOCAB) return KOLIBRI_NGRAM_UNK;
+
+    if (b->vocab + 1 >= b->vocab_capacity) {
+        size_t capacity = b->vocab_capacity * 2;
+        uint32_t *offsets = (uint32_t *)realloc(b->offsets, (capacity + 1) * sizeof(uint32_t));
+        if (!offsets) return KOLIBRI_NGRAM_UNK;
+        b->offsets = offsets;
+        uint64_t *counts = (uint64_t *)realloc(b->counts, capacity * sizeof(uint64_t));
+        if (!counts) return KOLIBRI_NGRAM_UNK;
+        b->counts = counts;
+        b->vocab_capacity = capacity;
+    }
+    if (b->strings_size + len + 1 > b->strings_capacity) {
+        size_t capacity = b->strings_capacity * 2;
+        while (capacity < b->strings_size + len + 1) capacity *= 2;
+        if (capacity > UINT32_MAX) return KOLIBRI_NGRAM_UNK;
+        char *strings = (char *)realloc(b->strings, capacity);
+        if (!strings) return KOLIBRI_NGRAM_UNK;
+        b->strings = strings;
+        b->strings_capacity = capacity;
+    }
+
+    id = (uint32_t)b->vocab++;
+    memcpy(b->strings + b->strings_size, word, len);
+    b->strings[b->strings_size + len] = '\0';
+    b->strings_size += len + 1;
+    b->offsets[id + 1] = (uint32_t)b->strings_size;
+    b->counts[id] = 0;
+
+    if (b->vocab * 2 > b->hash_slots) {
+        if (builder_grow_hash(b) != 0) {
+            b->vocab--;
+            b->strings_size -= len + 1;
+            return KOLIBRI_NGRAM_UNK;
+        }
+    } else {
+        b->hash[slot] = id + 1;
+    }
+    return id;
+}
+
+static size_t table_slot(const NgramTable *table, uint64_t key, uint32_t word) {
+    return (size_t)ngram_mix(key ^ ((uint64_t)word * 0x9E3779B97F4A7C15ULL)) & (table->capacity - 1);
+}
+
+static int table_add(NgramTable *table, uint64_t key, uint32_t word, uint32_t count) {
+    if ((table->used + 1) * 2 > table->capacity) {
+        size_t capacity = table->capacity ? table->capacity * 2 : 4096;
+        NgramCount *slots = (NgramCount *)calloc(capacity, sizeof(NgramCount));
+        if (!slots) return -1;
+        NgramTable grown = {slots, capacity, table->used};
+        for (size_t i = 0; i < table->capacity; i++) {
+            const NgramCount *e = &table->slots[i];
+            if (!e->count) continue;
+            size_t slot = table_slot(&grown, e->key, e->word);
+            while (slots[slot].count) slot = (slot + 1) & (capacity - 1);
+            slots[slot] = *e;
+        }
+        free(table->slots);
+        *table = grown;
+    }
+
+    size_t slot = table_slot(table, key, word);
+    while (table->slots[slot].count) {
+        NgramCount *e = &table->slots[slot];
+        if (e->key == key && e->word == word) {
+            e->count = e->count + count < e->count ? UINT32_MAX : e->count + count;
+            return 0;
+        }
+        slot = (slot + 1) & (table->capacity - 1);
+    }
+    table->slots[slot].key = key;
+    table->slots[slot].word = word;
+    table->slots[slot].count = count;
+    table->used++;
+    return 0;
+}
+
+KolibriNgramBuilder *k_ngram_builder_create(unsigned order) {
+    if (order == 0) order = KOLIBRI_NGRAM_DEFAULT_ORDER;
+    if (order > KOLIBRI_NGRAM_MAX_ORDER) return NULL;
+
+    KolibriNgramBuilder *b = (KolibriNgramBuilder *)calloc(1, sizeof(*b));
+    if (!b) return NULL;
+    b->order = order;
+    b->vocab_capacity = 1024;
+    b->strings_capacity = 16384;
+    b->offsets = (uint32_t *)malloc((b->vocab_capacity + 1) * sizeof(uint32_t));
+    b->counts = (uint64_t *)malloc(b->vocab_capacity * sizeof(uint64_t));
+    b->strings = (char *)malloc(b->strings_capacity);
+    if (!b->offsets || !b->counts || !b->strings || builder_grow_hash(b) != 0) {
+        k_ngram_builder_destroy(b);
+        return NULL;
+    }
+
+    /* Номер 0 - <unk>, в хэш-таблицу не попадает */
+    memcpy(b->strings, "<unk>", 6);
+    b->strings_size = 6;
+    b->offsets[0] = 0;
+    b->offsets[1] = 6;
+    b->counts[0] = 0;
+    b->vocab = 1;
+    return b;
+}
+
+void k_ngram_builder_destroy(KolibriNgramBuilder *b) {
+    if (!b) return;
+    for (unsigned k = 0; k <= KOLIBRI_NGRAM_MAX_ORDER; k++) free(b->tables[k].slots);
+    free(b->hash);
+    free(b->counts);
+    free(b->offsets);
+    free(b->strings);
+    free(b);
+}
+
+int k_ngram_builder_add_corpus(KolibriNgramBuilder *b, const KolibriCorpusContext *corpus) {
+    if (!b || !corpus) return -1;
+    for (size_t i = 0; i < corpus->store.count; i++) {
+        const char *word = corpus->store.words[i];
+        if (!word || !*word) continue;
+        size_t len = strlen(word);
+        if (len > KOLIBRI_NGRAM_MAX_WORD) len = KOLIBRI_NGRAM_MAX_WORD;
+        uint32_t id = builder_intern(b, word, len);
+        if (id == KOLIBRI_NGRAM_UNK) return -1;
+        size_t usage = corpus->store.patterns[i].usage_count;
+        b->counts[id] += usage ? usage : 1;
+        b->total_tokens += usage ? usage : 1;
+    }
+    return 0;
+}
+
+int k_ngram_builder_add_text(KolibriNgramBuilder *b, const char *text, size_t text_len) {
+    if (!b || (!text && text_len)) return -1;
+
+    uint32_t history[KOLIBRI_NGRAM_MAX_ORDER];
+    size_t history_len = 0;
+    size_t pos = 0, len;
+    const char *word;
+
+    while (ngram_next_word(text, text_len, &pos, &word, &len)) {
+        uint32_t id = builder_intern(b, word, len);
+        b->counts[id]++;
+        b->total_tokens++;
+
+        for (unsigned k = 2; k <= b->order && k - 1 <= history_len; k++) {
+            uint64_t key = ngram_context_key(history + history_len - (k - 1), k - 1);
+            if (table_add(&b->tables[k], key, id, 1) != 0) return -1;
+        }
+
+        if (b->order > 1) {
+            if (history_len == b->order - 1) {
+                memmove(history, history + 1, (history_len - 1) * sizeof(uint32_t));
+                history_len--;
+            }
+            history[history_len++] = id;
+        }
+    }
+    return 0;
+}
+
+static int compare_counts(const void *a, const void *b) {
+    const NgramCount *x = (const NgramCount *)a;
+    const NgramCount *y = (const NgramCount *)b;
+    if (x->key != y->key) return x->key < y->key ? -1 : 1;
+    return (x->word > y->word) - (x->word < y->word);
+}
+
+/* Пара (счётчик, номер) для ранжирования униграмм */
+typedef struct {
+    uint64_t count;
+    uint32_t id;
+} NgramRank;
+
+static int compare_rank(const void *a, const void *b) {
+    const NgramRank *x = (const NgramRank *)a;
+    const NgramRank *y = (const NgramRank *)b;
+    if (x->count != y->count) return x->count > y->count ? -1 : 1;
+    return (x->id > y->id) - (x->id < y->id);
+}
+
+static uint64_t align8(uint64_t offset) {
+    return (offset + 7) & ~(uint64_t)7;
+}
+
+static KolibriNgramModel *ngram_open(const uint8_t *base, size_t size, int mapped);
+
+KolibriNgramModel *k_ngram_build(const KolibriNgramBuilder *b) {
+    if (!b) return NULL;
+
+    uint32_t vocab = (uint32_t)b->vocab;
+    uint32_t hash_slots = 16;
+    while (hash_slots < vocab * 2) hash_slots *= 2;
+
+    /* n-граммы каждого порядка, отсортированные по (ключ, слово) */
+    NgramCount *sorted[KOLIBRI_NGRAM_MAX_ORDER + 1] = {0};
+    size_t ngrams[KOLIBRI_NGRAM_MAX_ORDER + 1] = {0};
+    size_t contexts[KOLIBRI_NGRAM_MAX_ORDER + 1] = {0};
+    NgramRank *rank = (NgramRank *)malloc(vocab * sizeof(NgramRank));
+    uint8_t *base = NULL;
+    KolibriNgramModel *model = NULL;
+    if (!rank) return NULL;
+
+    for (unsigned k = 2; k <= b->order; k++) {
+        const NgramTable *table = &b->tables[k];
+        sorted[k] = (NgramCount *)malloc((table->used + 1) * sizeof(NgramCount));
+        if (!sorted[k]) goto done;
+        for (size_t i = 0; i < table->capacity; i++) {
+            if (table->slots[i].count) sorted[k][ngrams[k]++] = table->slots[i];
+        }
+        qsort(sorted[k], ngrams[k], sizeof(NgramCount), compare_counts);
+        for (size_t i = 0; i < ngrams[k]; i++) {
+            if (i == 0 || sorted[k][i].key != sorted[k][i - 1].key) contexts[k]++;
+        }
+    }
+
+    /* Раскладка образа */
+    NgramHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = NGRAM_MAGIC;
+    header.version = NGRAM_VERSION;
+    header.order = b->order;
+    header.vocab_size = vocab;
+    header.hash_slots = hash_slots;
+    header.total_tokens = b->total_tokens;
+
+    uint64_t offset = align8(sizeof(NgramHeader));
+    header.strings_offset = offset;
+    header.strings_size = b->strings_size;
+    offset = align8(offset + b->strings_size);
+    header.offsets_offset = offset;
+    offset = align8(offset + (uint64_t)(vocab + 1) * sizeof(uint32_t));
+    header.hash_offset = offset;
+    offset = align8(offset + (uint64_t)hash_slots * sizeof(uint32_t));
+    header.unigram_offset = offset;
+    offset = align8(offset + (uint64_t)vocab * sizeof(uint16_t));
+    header.rank_offset = offset;
+    offset = align8(offset + (uint64_t)vocab * sizeof(uint32_t));
+    header.histogram_offset = offset;
+    offset = align8(offset + (NGRAM_Q_MAX + 1) * sizeof(uint32_t));
+    for (unsigned k = 2; k <= b->order; k++) {
+        header.context_offset[k] = offset;
+        header.context_count[k] = contexts[k];
+        offset = align8(offset + contexts[k] * sizeof(NgramContext));
+        header.successor_offset[k] = offset;
+        header.successor_count[k] = ngrams[k];
+        offset = align8(offset + ngrams[k] * sizeof(uint32_t));
+    }
+    header.file_size = offset;
+
+    base = (uint8_t *)calloc(1, offset);
+    if (!base) goto done;
+    memcpy(base, &header, sizeof(header));
+    memcpy(base + header.strings_offset, b->strings, b->strings_size);
+    memcpy(base + header.offsets_offset, b->offsets, (vocab + 1) * sizeof(uint32_t));
+
+    uint32_t *hash = (uint32_t *)(base + header.hash_offset);
+    for (uint32_t id = 1; id < vocab; id++) {
+        size_t len = b->offsets[id + 1] - b->offsets[id] - 1;
+        size_t slot = ngram_hash_word(b->strings + b->offsets[id], len) & (hash_slots - 1);
+        while (hash[slot]) slot = (slot + 1) & (hash_slots - 1);
+        hash[slot] = id + 1;
+    }
+
+    /* Униграммы со сглаживанием Лапласа: (c + 1) / (N + V) */
+    uint16_t *unigram = (uint16_t *)(base + header.unigram_offset);
+    uint32_t *histogram = (uint32_t *)(base + header.histogram_offset);
+    double denominator = (double)b->total_tokens + (double)vocab;
+    for (uint32_t id = 0; id < vocab; id++) {
+        unigram[id] = (uint16_t)ngram_quantize(((double)b->counts[id] + 1.0) / denominator);
+        if (id != KOLIBRI_NGRAM_UNK) histogram[unigram[id]]++;
+        rank[id].count = id == KOLIBRI_NGRAM_UNK ? 0 : b->counts[id] + 1;
+        rank[id].id = id;
+    }
+    qsort(rank, vocab, sizeof(NgramRank), compare_rank);
+    uint32_t *rank_out = (uint32_t *)(base + header.rank_offset);
+    for (uint32_t i = 0; i < vocab; i++) rank_out[i] = rank[i].id;
+
+    /* Контексты: Виттен-Белл, P(w|h) = c(h,w) / (N + T), уход T / (N + T) */
+    for (unsigned k = 2; k <= b->order; k++) {
+        NgramContext *ctx = (NgramContext *)(base + header.context_offset[k]);
+        uint32_t *successors = (uint32_t *)(base + header.successor_offset[k]);
+        size_t c = 0;
+        for (size_t i = 0; i < ngrams[k];) {
+            size_t end = i;
+            uint64_t total = 0;
+            while (end < ngrams[k] && sorted[k][end].key == sorted[k][i].key) {
+                total += sorted[k][end].count;
+                end++;
+            }
+            size_t types = end - i;
+            double denom = (double)total + (double)types;
+            for (size_t j = i; j < end; j++) {
+                unsigned q = ngram_quantize((double)sorted[k][j].count / denom);
+                successors[j] = (sorted[k][j].word << NGRAM_Q_BITS) | q;
+            }
+            ctx[c].key = sorted[k][i].key;
+            ctx[c].first = (uint32_t)i;
+            ctx[c].packed = ((uint32_t)types << NGRAM_Q_BITS) |
+                            ngram_quantize((double)types / denom);
+            c++;
+            i = end;
+        }
+    }
+
+    model = ngram_open(base, (size_t)offset, 0);
+    if (model) base = NULL;
+
+done:
+    free(base);
+    for (unsigned k = 0; k <= KOLIBRI_NGRAM_MAX_ORDER; k++) free(sorted[k]);
+    free(rank);
+    return model;
+}
+
+/* ---------- Образ модели ---------- */
+
+static int section_ok(const NgramHeader *h, uint64_t offset, uint64_t bytes) {
+    return (offset & 7) == 0 && offset <= h->file_size && bytes <= h->file_size - offset;
+}
+
+/* Содержимое секций проверяется один раз при открытии: запросы
+ * индексируют по нему prob[], successors[] и strings без проверок */
+static int entries_ok(const NgramHeader *h, const uint8_t *base) {
+    uint32_t vocab = h->vocab_size;
+    const char *strings = (const char *)(base + h->strings_offset);
+    const uint32_t *offsets = (const uint32_t *)(base + h->offsets_offset);
+    const uint16_t *unigram = (const uint16_t *)(base + h->unigram_offset);
+
+    for (uint32_t id = 0; id < vocab; id++) {
+        uint32_t end = offsets[id + 1];
+        if (offsets[id] >= end || end > h->strings_size || strings[end - 1] != '\0') return 0;
+        if (unigram[id] > NGRAM_Q_MAX) return 0;
+    }
+    for (unsigned k = 2; k <= h->order; k++) {
+        const NgramContext *ctx = (const NgramContext *)(base + h->context_offset[k]);
+        const uint32_t *successors = (const uint32_t *)(base + h->successor_offset[k]);
+        for (uint64_t c = 0; c < h->context_count[k]; c++) {
+            uint64_t count = ctx[c].packed >> NGRAM_Q_BITS;
+            if ((uint64_t)ctx[c].first + count > h->successor_count[k]) return 0;
+        }
+        for (uint64_t i = 0; i < h->successor_count[k]; i++) {
+            if ((successors[i] >> NGRAM_Q_BITS) >= vocab) return 0;
+        }
+    }
+    return 1;
+}
+
+static KolibriNgramModel *ngram_open(const uint8_t *base, size_t size, int mapped) {
+    if (size < sizeof(NgramHeader)) return NULL;
+    const NgramHeader *h = (const NgramHeader *)base;
+    if (h->magic != NGRAM_MAGIC || h->version != NGRAM_VERSION) return NULL;
+    if (h->order < 1 || h->order > KOLIBRI_NGRAM_MAX_ORDER) return NULL;
+    if (h->vocab_size < 1 || h->vocab_size > KOLIBRI_NGRAM_MAX_VOCAB + 1) return NULL;
+    if (h->hash_slots < h->vocab_size || (h->hash_slots & (h->hash_slots - 1))) return NULL;
+    if (h->file_size != size || h->strings_size == 0 || h->strings_size > UINT32_MAX) return NULL;
+
+    uint64_t vocab = h->vocab_size;
+    if (!section_ok(h, h->strings_offset, h->strings_size) ||
+        !section_ok(h, h->offsets_offset, (vocab + 1) * sizeof(uint32_t)) ||
+        !section_ok(h, h->hash_offset, (uint64_t)h->hash_slots * sizeof(uint32_t)) ||
+        !section_ok(h, h->unigram_offset, vocab * sizeof(uint16_t)) ||
+        !section_ok(h, h->rank_offset, vocab * sizeof(uint32_t)) ||
+        !section_ok(h, h->histogram_offset, (NGRAM_Q_MAX + 1) * sizeof(uint32_t))) {
+        return NULL;
+    }
+    if (base[h->strings_offset + h->strings_size - 1] != '\0') return NULL;
+    for (unsigned k = 2; k <= h->order; k++) {
+        if (h->context_count[k] > h->successor_count[k] ||
+            h->successor_count[k] > UINT32_MAX ||
+            !section_ok(h, h->context_offset[k], h->context_count[k] * sizeof(NgramContext)) ||
+            !section_ok(h, h->successor_offset[k], h->successor_count[k] * sizeof(uint32_t))) {
+            return NULL;
+        }
+    }
+    if (!entries_ok(h, base)) return NULL;
+
+    KolibriNgramModel *m = (KolibriNgramModel *)calloc(1, sizeof(*m));
+    if (!m) return NULL;
+    m->base = base;
+    m->size = size;
+    m->mapped = mapped;
+    m->order = h->order;
+    m->vocab = h->vocab_size;
+    m->hash_mask = h->hash_slots - 1;
+    m->total_tokens = h->total_tokens;
+    m->strings = (const char *)(base + h->strings_offset);
+    m->strings_size = (size_t)h->strings_size;
+    m->offsets = (const uint32_t *)(base + h->offsets_offset);
+    m->hash = (const uint32_t *)(base + h->hash_offset);
+    m->unigram = (const uint16_t *)(base + h->unigram_offset);
+    m->rank = (const uint32_t *)(base + h->rank_offset);
+    m->histogram = (const uint32_t *)(base + h->histogram_offset);
+    for (unsigned k = 2; k <= m->order; k++) {
+        m->contexts[k] = (const NgramContext *)(base + h->context_offset[k]);
+        m->context_count[k] = (size_t)h->context_count[k];
+        m->successors[k] = (const uint32_t *)(base + h->successor_offset[k]);
+        m->successor_count[k] = (size_t)h->successor_count[k];
+    }
+    for (unsigned q = 0; q <= NGRAM_Q_MAX; q++) {
+        m->prob[q] = exp2(-(double)q / NGRAM_Q_SCALE);
+    }
+    return m;
+}
+
+int k_ngram_save(const KolibriNgramModel *model, const char *path) {
+    if (!model || !path) return -1;
+
+    char tmp[4096];
+    if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp)) return -1;
+    FILE *f = fopen(tmp, "wb");
+    if (!f) return -1;
+    int ok = fwrite(model->base, 1, model->size, f) == model->size;
+    ok = fflush(f) == 0 && ok;
+    ok = fsync(fileno(f)) == 0 && ok;
+    ok = fclose(f) == 0 && ok;
+    if (!ok || rename(tmp, path) != 0) {
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+KolibriNgramModel *k_ngram_load(const char *path) {
+    if (!path) return NULL;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(NgramHeader)) {
+        close(fd);
+        return NULL;
+    }
+    size_t size = (size_t)st.st_size;
+    void *base = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return NULL;
+
+    KolibriNgramModel *model = ngram_open((const uint8_t *)base, size, 1);
+    if (!model) munmap(base, size);
+    return model;
+}
+
+void k_ngram_free(KolibriNgramModel *model) {
+    if (!model) return;
+    if (model->mapped) {
+        munmap((void *)model->base, model->size);
+    } else {
+        free((void *)model->base);
+    }
+    free(model);
+}
+
+void k_ngram_get_info(const KolibriNgramModel *model, KolibriNgramInfo *info) {
+    if (!info) return;
+    memset(info, 0, sizeof(*info));
+    if (!model) return;
+    info->order = model->order;
+    info->vocab_size = model->vocab;
+    info->total_tokens = model->total_tokens;
+    info->contexts[1] = model->vocab > 0 ? 1 : 0;
+    info->ngrams[1] = model->vocab;
+    for (unsigned k = 2; k <= model->order; k++) {
+        info->contexts[k] = model->context_count[k];
+        info->ngrams[k] = model->successor_count[k];
+    }
+    info->bytes = model->size;
+    info->mapped = model->mapped;
+}
+
+/* ---------- Словарь ---------- */
+
+uint32_t k_ngram_lookup(const KolibriNgramModel *model, const char *word, size_t len) {
+    if (!model || !word) return KOLIBRI_NGRAM_UNK;
+    if (len > KOLIBRI_NGRAM_MAX_WORD) len = KOLIBRI_NGRAM_MAX_WORD;
+
+    size_t slot = ngram_hash_word(word, len) & model->hash_mask;
+    for (size_t probes = 0; probes <= model->hash_mask && model->hash[slot]; probes++) {
+        uint32_t id = model->hash[slot] - 1;
+        if (id < model->vocab) {
+            uint32_t start = model->offsets[id];
+            uint32_t end = model->offsets[id + 1];
+            if (start < end && end <= model->strings_size && end - start - 1 == len &&
+                memcmp(model->strings + start, word, len) == 0) {
+                return id;
+            }
+        }
+        slot = (slot + 1) & model->hash_mask;
+    }
+    return KOLIBRI_NGRAM_UNK;
+}
+
+const char *k_ngram_word(const KolibriNgramModel *model, uint32_t word) {
+    if (!model || word >= model->vocab) return NULL;
+    uint32_t start = model->offsets[word];
+    return start < model->strings_size ? model->strings + start : NULL;
+}
+
+size_t k_ngram_tokenize(const KolibriNgramModel *model, const char *text, size_t text_len,
+                        uint32_t *ids, size_t max_ids) {
+    if (!model || !text) return 0;
+    size_t count = 0, pos = 0, len;
+    const char *word;
+    while (ngram_next_word(text, text_len, &pos, &word, &len)) {
+        if (count < max_ids && ids) ids[count] = k_ngram_lookup(model, word, len);
+        count++;
+    }
+    return count;
+}
+
+/* ---------- Запросы ---------- */
+
+static const NgramContext *find_context(const KolibriNgramModel *m, unsigned k, uint64_t key) {
+    const NgramContext *ctx = m->contexts[k];
+    size_t lo = 0, hi = m->context_count[k];
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (ctx[mid].key < key) lo = mid + 1; else hi = mid;
+    }
+    return lo < m->context_count[k] && ctx[lo].key == key ? &ctx[lo] : NULL;
+}
+
+/* Цепочка контекстов порядков 2..top для истории; возвращает top.
+ * Если контекста порядка k нет, то нет и более длинных */
+static unsigned context_chain(const KolibriNgramModel *m, const uint32_t *history,
+                              size_t history_len, const NgramContext **chain) {
+    unsigned top = 1;
+    for (unsigned k = 2; k <= m->order && k - 1 <= history_len; k++) {
+        uint64_t key = ngram_context_key(history + history_len - (k - 1), k - 1);
+        const NgramContext *ctx = find_context(m, k, key);
+        if (!ctx) break;
+        chain[k] = ctx;
+        top = k;
+    }
+    return top;
+}
+
+static double successor_prob(const KolibriNgramModel *m, unsigned k,
+                             const NgramContext *ctx, uint32_t word) {
+    const uint32_t *s = m->successors[k] + ctx->first;
+    size_t lo = 0, hi = ctx->packed >> NGRAM_Q_BITS;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if ((s[mid] >> NGRAM_Q_BITS) < word) lo = mid + 1; else hi = mid;
+    }
+    if (lo < (ctx->packed >> NGRAM_Q_BITS) && (s[lo] >> NGRAM_Q_BITS) == word) {
+        return m->prob[s[lo] & NGRAM_Q_MAX];
+    }
+    return 0.0;
+}
+
+static double chain_prob(const KolibriNgramModel *m, const NgramContext **chain,
+                         unsigned top, uint32_t word) {
+    if (word >= m->vocab) word = KOLIBRI_NGRAM_UNK;
+    double p = m->prob[m->unigram[word]];
+    for (unsigned k = 2; k <= top; k++) {
+        p = successor_prob(m, k, chain[k], word) + m->prob[chain[k]->packed & NGRAM_Q_MAX] * p;
+    }
+    return p;
+}
+
+double k_ngram_logprob(const KolibriNgramModel *model, const uint32_t *history,
+                       size_t history_len, uint32_t word) {
+    if (!model) return -INFINITY;
+    if (!history) history_len = 0;
+    const NgramContext *chain[KOLIBRI_NGRAM_MAX_ORDER + 1];
+    unsigned top = context_chain(model, history, history_len, chain);
+    return log2(chain_prob(model, chain, top, word));
+}
+
+/* Минимальная куча по logprob: в корне худший из лучших */
+static void heap_offer(KolibriNgramChoice *heap, size_t *size, size_t capacity,
+                       KolibriNgramChoice item) {
+    size_t i;
+    if (*size < capacity) {
+        i = (*size)++;
+        while (i > 0 && heap[(i - 1) / 2].logprob > item.logprob) {
+            heap[i] = heap[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+        heap[i] = item;
+        return;
+    }
+    if (capacity == 0 || item.logprob <= heap[0].logprob) return;
+
+    i = 0;
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= *size) break;
+        if (child + 1 < *size && heap[child + 1].logprob < heap[child].logprob) child++;
+        if (heap[child].logprob >= item.logprob) break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = item;
+}
+
+static int compare_choice(const void *a, const void *b) {
+    const KolibriNgramChoice *x = (const KolibriNgramChoice *)a;
+    const KolibriNgramChoice *y = (const KolibriNgramChoice *)b;
+    if (x->logprob != y->logprob) return x->logprob > y->logprob ? -1 : 1;
+    return (x->word > y->word) - (x->word < y->word);
+}
+
+static int compare_choice_word(const void *a, const void *b) {
+    const KolibriNgramChoice *x = (const KolibriNgramChoice *)a;
+    const KolibriNgramChoice *y = (const KolibriNgramChoice *)b;
+    return (x->word > y->word) - (x->word < y->word);
+}
+
+/* Кандидаты - лучшие k каждого уровня цепочки; точная оценка
+ * интерполированной вероятностью, отбор ограниченной кучей */
+size_t k_ngram_top(const KolibriNgramModel *model, const uint32_t *history,
+                   size_t history_len, KolibriNgramChoice *out, size_t k) {
+    if (!model || !out || k == 0) return 0;
+    if (k > KOLIBRI_NGRAM_MAX_TOP) k = KOLIBRI_NGRAM_MAX_TOP;
+    if (!history) history_len = 0;
+
+    const NgramContext *chain[KOLIBRI_NGRAM_MAX_ORDER + 1];
+    unsigned top = context_chain(model, history, history_len, chain);
+
+    KolibriNgramChoice candidates[KOLIBRI_NGRAM_MAX_TOP * KOLIBRI_NGRAM_MAX_ORDER];
+    size_t count = 0;
+
+    for (unsigned level = 2; level <= top; level++) {
+        const uint32_t *s = model->successors[level] + chain[level]->first;
+        size_t n = chain[level]->packed >> NGRAM_Q_BITS;
+        size_t heap_size = 0;
+        for (size_t i = 0; i < n; i++) {
+            uint32_t word = s[i] >> NGRAM_Q_BITS;
+            if (word == KOLIBRI_NGRAM_UNK) continue;
+            KolibriNgramChoice c = {word, -(double)(s[i] & NGRAM_Q_MAX)};
+            heap_offer(candidates + count, &heap_size, k, c);
+        }
+        count += heap_size;
+    }
+    for (uint32_t i = 0, taken = 0; i < model->vocab && taken < k; i++) {
+        if (model->rank[i] == KOLIBRI_NGRAM_UNK || model->rank[i] >= model->vocab) continue;
+        candidates[count].word = model->rank[i];
+        count++;
+        taken++;
+    }
+    if (count == 0) return 0;
+
+    qsort(candidates, count, sizeof(KolibriNgramChoice), compare_choice_word);
+    size_t result = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (i > 0 && candidates[i].word == candidates[i - 1].word) continue;
+        KolibriNgramChoice c = {candidates[i].word,
+                                log2(chain_prob(model, chain, top, candidates[i].word))};
+        heap_offer(out, &result, k, c);
+    }
+    qsort(out, result, sizeof(KolibriNgramChoice), compare_choice);
+    return result;
+}
+
+/* Выборка на уровне контекста с весами p^(1/T); уход - оставшаяся масса.
+ * Возвращает UNK, если выпал уход, и обновляет u для нижнего уровня */
+static uint32_t sample_context(const KolibriNgramModel *m, unsigned k, const NgramContext *ctx,
+                               double inverse_t, double *u) {
+    const uint32_t *s = m->successors[k] + ctx->first;
+    size_t n = ctx->packed >> NGRAM_Q_BITS;
+    double escape = m->prob[ctx->packed & NGRAM_Q_MAX];
+
+    if (inverse_t == 1.0) {
+        double acc = 0.0;
+        for (size_t i = 0; i < n; i++) {
+            acc += m->prob[s[i] & NGRAM_Q_MAX];
+            if (*u < acc && (s[i] >> NGRAM_Q_BITS) != KOLIBRI_NGRAM_UNK) {
+                return s[i] >> NGRAM_Q_BITS;
+            }
+        }
+        double rest = 1.0 - acc;
+        *u = rest > 1e-12 ? (*u - acc) / rest : 0.0;
+    } else {
+        double total = pow(escape, inverse_t);
+        for (size_t i = 0; i < n; i++) {
+            total += exp2(-(double)(s[i] & NGRAM_Q_MAX) / NGRAM_Q_SCALE * inverse_t);
+        }
+        double target = *u * total, acc = 0.0;
+        for (size_t i = 0; i < n; i++) {
+            acc += exp2(-(double)(s[i] & NGRAM_Q_MAX) / NGRAM_Q_SCALE * inverse_t);
+            if (target < acc && (s[i] >> NGRAM_Q_BITS) != KOLIBRI_NGRAM_UNK) {
+                return s[i] >> NGRAM_Q_BITS;
+            }
+        }
+        double rest = total - acc;
+        *u = rest > 1e-300 ? (target - acc) / rest : 0.0;
+    }
+    if (*u >= 1.0) *u = 0.999999999;
+    if (*u < 0.0) *u = 0.0;
+    return KOLIBRI_NGRAM_UNK;
+}
+
+uint32_t k_ngram_sample(const KolibriNgramModel *model, const uint32_t *history,
+                        size_t history_len, double temperature, uint64_t *rng) {
+    if (!model || !rng || model->vocab < 2) return KOLIBRI_NGRAM_UNK;
+    if (!history) history_len = 0;
+
+    if (!(temperature > 0.0)) {
+        KolibriNgramChoice best;
+        return k_ngram_top(model, history, history_len, &best, 1) ? best.word : KOLIBRI_NGRAM_UNK;
+    }
+    double inverse_t = 1.0 / temperature;
+
+    const NgramContext *chain[KOLIBRI_NGRAM_MAX_ORDER + 1];
+    unsigned top = context_chain(model, history, history_len, chain);
+    double u = ngram_uniform(rng);
+
+    for (unsigned k = top; k >= 2; k--) {
+        uint32_t word = sample_context(model, k, chain[k], inverse_t, &u);
+        if (word != KOLIBRI_NGRAM_UNK) return word;
+    }
+
+    /* Униграммы: список по убыванию частоты - обычно ранний выход.
+     * Для T != 1 нормировка берётся из гистограммы q за O(1024) */
+    double target;
+    if (inverse_t != 1.0) {
+        double total = 0.0;
+        for (unsigned q = 0; q <= NGRAM_Q_MAX; q++) {
+            if (model->histogram[q]) {
+                total += model->histogram[q] * exp2(-(double)q / NGRAM_Q_SCALE * inverse_t);
+            }
+        }
+        target = u * total;
+    } else {
+        double total = 1.0 - model->prob[model->unigram[KOLIBRI_NGRAM_UNK]];
+        target = u * total;
+    }
+
+    uint32_t last = KOLIBRI_NGRAM_UNK;
+    double acc = 0.0;
+    for (uint32_t i = 0; i < model->vocab; i++) {
+        uint32_t id = model->rank[i];
+        if (id == KOLIBRI_NGRAM_UNK || id >= model->vocab) continue;
+        unsigned q = model->unigram[id];
+        acc += inverse_t == 1.0 ? model->prob[q]
+                                : exp2(-(double)q / NGRAM_Q_SCALE * inverse_t);
+        last = id;
+        if (target < acc) return id;
+    }
+    return last;
+}
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2025 Кочуров Владислав Евгеньевич
+ * Pattern Dictionary
+ */
+
+#include "kolibri/pattern_dict.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define PATTERN_DICT_DEFAULT_CAPACITY 256
+
+static size_t slot_of(int32_t hash, size_t mask) {
+    uint32_t h = (uint32_t)hash;
+    h ^= h >> 16;
+    h *= 0x7FEB352Du;
+    h ^= h >> 15;
+    h *= 0x846CA68Bu;
+    h ^= h >> 16;
+    return h & mask;
+}
+
+static int rehash(KolibriPatternDict *dict, size_t slot_count) {
+    uint32_t *slots = (uint32_t *)calloc(slot_count, sizeof(uint32_t));
+    if (!slots) return -1;
+    for (size_t i = 0; i < dict->count; i++) {
+        size_t slot = slot_of(dict->entries[i].hash, slot_count - 1);
+        while (slots[slot]) slot = (slot + 1) & (slot_count - 1);
+        slots[slot] = (uint32_t)i + 1;
+    }
+    free(dict->slots);
+    dict->slots = slots;
+    dict->slot_count = slot_count;
+    return 0;
+}
+
+int k_pattern_dict_init(KolibriPatternDict *dict, size_t capacity) {
+    if (!dict) return -1;
+    memset(dict, 0, sizeof(*dict));
+    if (capacity == 0) capacity = PATTERN_DICT_DEFAULT_CAPACITY;
+
+    dict->entries = (KolibriPatternEntry *)malloc(capacity * sizeof(KolibriPatternEntry));
+    if (!dict->entries) return -1;
+    dict->capacity = capacity;
+
+    size_t slot_count = 16;
+    while (slot_count < capacity * 2) slot_count *= 2;
+    if (rehash(dict, slot_count) != 0) {
+        free(dict->entries);
+        dict->entries = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+void k_pattern_dict_free(KolibriPatternDict *dict) {
+    if (!dict) return;
+    free(dict->entries);
+    free(dict->slots);
+    memset(dict, 0, sizeof(*dict));
+}
+
+static void pack(const uint8_t *pattern, uint8_t *digits) {
+    for (size_t i = 0; i < KOLIBRI_PATTERN_DICT_PACKED; i++) {
+        digits[i] = (uint8_t)((pattern[2 * i] & 0x0F) | (pattern[2 * i + 1] << 4));
+    }
+}
+
+int k_pattern_dict_put(KolibriPatternDict *dict, int32_t hash,
+                       const uint8_t pattern[KOLIBRI_SEMANTIC_PATTERN_SIZE]) {
+    if (!dict || !dict->slots || !pattern) return -1;
+
+    uint8_t digits[KOLIBRI_PATTERN_DICT_PACKED];
+    pack(pattern, digits);
+
+    size_t mask = dict->slot_count - 1;
+    size_t slot = slot_of(hash, mask);
+    while (dict->slots[slot]) {
+        KolibriPatternEntry *entry = &dict->entries[dict->slots[slot] - 1];
+        if (entry->hash == hash) {
+            if (memcmp(entry->digits, digits, sizeof(digits)) != 0) {
+                memcpy(entry->digits, digits, sizeof(digits));
+                if (!entry->pending) {
+                    entry->pending = 1;
+                    dict->pending++;
+                }
+            }
+            return 0;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    if (dict->count >= UINT32_MAX - 1) return -1;
+    if (dict->count == dict->capacity) {
+        size_t capacity = dict->capacity * 2;
+        KolibriPatternEntry *entries =
+            (KolibriPatternEntry *)realloc(dict->entries, capacity * sizeof(KolibriPatternEntry));
+        if (!entries) return -1;
+        dict->entries = entries;
+        dict->capacity = capacity;
+    }
+    if ((dict->count + 1) * 2 > dict->slot_count) {
+        if (rehash(dict, dict->slot_count * 2) != 0) return -1;
+        mask = dict->slot_count - 1;
+        slot = slot_of(hash, mask);
+        while (dict->slots[slot]) slot = (slot + 1) & mask;
+    }
+
+    KolibriPatternEntry *entry = &dict->entries[dict->count];
+    entry->hash = hash;
+    entry->pending = 1;
+    memcpy(entry->digits, digits, sizeof(digits));
+    dict->slots[slot] = (uint32_t)(++dict->count);
+    dict->pending++;
+    dict->inserted++;
+    return 1;
+}
+
+const KolibriPatternEntry *k_pattern_dict_find(const KolibriPatternDict *dict, int32_t hash) {
+    if (!dict || !dict->slots) return NULL;
+    size_t mask = dict->slot_count - 1;
+    size_t slot = slot_of(hash, mask);
+    while (dict->slots[slot]) {
+        const KolibriPatternEntry *entry = &dict->entries[dict->slots[slot] - 1];
+        if (entry->hash == hash) return entry;
+        slot = (slot + 1) & mask;
+    }
+    return NULL;
+}
+
+void k_pattern_dict_unpack(const KolibriPatternEntry *entry,
+                           uint8_t pattern[KOLIBRI_SEMANTIC_PATTERN_SIZE]) {
+    if (!entry || !pattern) return;
+    for (size_t i = 0; i < KOLIBRI_PATTERN_DICT_PACKED; i++) {
+        pattern[2 * i] = entry->digits[i] & 0x0F;
+        pattern[2 * i + 1] = entry->digits[i] >> 4;
+    }
+}
+
+void k_pattern_dict_clear_pending(KolibriPatternDict *dict) {
+    if (!dict) return;
+    if (dict->pending) {
+        for (size_t i = 0; i < dict->count; i++) dict->entries[i].pending = 0;
+    }
+    dict->pending = 0;
+    dict->inserted = 0;
+}
@@ -0,0 +1,511 @@
+/*
+ * Kolibri OS Archiver - PPM context model
+ *
+ * Contexts of every order live in one open-addressed hash table with
+ * 4-slot buckets (one cache line each). A slot points to a compact
+ * symbol list in a pool carved from the same arena; lists grow by
+ * powers of two and freed lists are recycled through per-size free
+ * lists. A full bucket evicts its weakest context, a full pool flushes
+ * the model. Nothing is allocated while coding, and encoder and decoder
+ * make identical decisions, so the budget never affects correctness.
+ *
+ * Coding is PPM with full exclusion, escape frequency equal to the
+ * number of distinct symbols in the context (method D with doubled
+ * counts) and an adaptive order-0 fallback.
+ */
+
+#include "kolibri/ppm.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define PPM_BUCKET 4
+#define PPM_CLASSES 9              /* list capacities 1, 2, 4, ..., 256 */
+#define PPM_NO_LIST 0xFFFFFFFFu
+#define PPM_INC 2
+#define PPM_MAX_TOTAL 8000         /* rescale threshold of a context */
+#define PPM_MAX_TOTAL0 16000       /* rescale threshold of order 0 */
+
+#define RC_TOP (1u << 24)
+#define RC_BOT (1u << 16)
+
+typedef struct {
+    uint16_t freq;
+    uint8_t sym;
+    uint8_t reserved;
+} PpmSymbol;
+
+typedef struct {
+    uint32_t check;                /* hash tag, 0 = empty slot */
+    uint32_t list;                 /* pool index of the symbol list */
+    uint16_t total;                /* sum of frequencies */
+    uint16_t count;                /* distinct symbols */
+    uint8_t cap_class;             /* list capacity is 1 << cap_class */
+    uint8_t reserved;
+    uint16_t stamp;                /* symbol that last touched the slot */
+} PpmContext;
+
+struct KolibriPpmModel {
+    unsigned order;
+    size_t memory_limit;
+    void *arena;
+    PpmContext *table;
+    size_t bucket_mask;
+    PpmSymbol *pool;
+    uint32_t pool_size;
+    uint32_t pool_top;
+    uint32_t free_list[PPM_CLASSES];
+    uint16_t order0[256];
+    uint32_t total0;
+    uint16_t stamp;
+    uint64_t excluded[4];
+    KolibriPpmStats stats;
+};
+
+/* Carryless range coder (Subbotin); totals stay below RC_BOT */
+typedef struct {
+    uint32_t low;
+    uint32_t range;
+    uint32_t code;
+    uint8_t *out;
+    const uint8_t *in;
+    size_t pos;
+    size_t size;
+    int overflow;
+} PpmCoder;
+
+static void coder_enc_init(PpmCoder *rc, uint8_t *out, size_t cap) {
+    memset(rc, 0, sizeof(*rc));
+    rc->range = 0xFFFFFFFFu;
+    rc->out = out;
+    rc->size = cap;
+}
+
+static inline void coder_put(PpmCoder *rc, uint8_t byte) {
+    if (rc->pos < rc->size) {
+        rc->out[rc->pos++] = byte;
+    } else {
+        rc->overflow = 1;
+    }
+}
+
+static inline void coder_enc_norm(PpmCoder *rc) {
+    while ((rc->low ^ (rc->low + rc->range)) < RC_TOP ||
+           (rc->range < RC_BOT && ((rc->range = (0u - rc->low) & (RC_BOT - 1)), 1))) {
+        coder_put(rc, (uint8_t)(rc->low >> 24));
+        rc->low <<= 8;
+        rc->range <<= 8;
+    }
+}
+
+static inline void coder_encode(PpmCoder *rc, uint32_t cum, uint32_t freq, uint32_t total) {
+    rc->range /= total;
+    rc->low += cum * rc->range;
+    rc->range *= freq;
+    coder_enc_norm(rc);
+}
+
+static void coder_enc_flush(PpmCoder *rc) {
+    for (int i = 0; i < 4; i++) {
+        coder_put(rc, (uint8_t)(rc->low >> 24));
+        rc->low <<= 8;
+    }
+}
+
+static inline uint8_t coder_next(PpmCoder *rc) {
+    return rc->pos < rc->size ? rc->in[rc->pos++] : 0;
+}
+
+static void coder_dec_init(PpmCoder *rc, const uint8_t *in, size_t size) {
+    memset(rc, 0, sizeof(*rc));
+    rc->range = 0xFFFFFFFFu;
+    rc->in = in;
+    rc->size = size;
+    for (int i = 0; i < 4; i++) rc->code = (rc->code << 8) | coder_next(rc);
+}
+
+static inline uint32_t coder_get(PpmCoder *rc, uint32_t total) {
+    rc->range /= total;
+    return (rc->code - rc->low) / rc->range;
+}
+
+static inline void coder_decode(PpmCoder *rc, uint32_t cum, uint32_t freq) {
+    rc->low += cum * rc->range;
+    rc->range *= freq;
+    while ((rc->low ^ (rc->low + rc->range)) < RC_TOP ||
+           (rc->range < RC_BOT && ((rc->range = (0u - rc->low) & (RC_BOT - 1)), 1))) {
+        rc->code = (rc->code << 8) | coder_next(rc);
+        rc->low <<= 8;
+        rc->range <<= 8;
+    }
+}
+
+/* Model */
+
+static inline uint64_t ppm_mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDULL;
+    x ^= x >> 33;
+    x *= 0xC4CEB9FE1A85EC53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+static void ppm_flush(KolibriPpmModel *m) {
+    memset(m->table, 0, (m->bucket_mask + 1) * PPM_BUCKET * sizeof(PpmContext));
+    m->pool_top = 0;
+    for (int c = 0; c < PPM_CLASSES; c++) m->free_list[c] = PPM_NO_LIST;
+    m->stats.contexts = 0;
+}
+
+static uint32_t ppm_alloc(KolibriPpmModel *m, unsigned cls) {
+    uint32_t idx = m->free_list[cls];
+    if (idx != PPM_NO_LIST) {
+        memcpy(&m->free_list[cls], &m->pool[idx], sizeof(uint32_t));
+        return idx;
+    }
+    uint32_t need = 1u << cls;
+    if (m->pool_size - m->pool_top < need) return PPM_NO_LIST;
+    idx = m->pool_top;
+    m->pool_top += need;
+    return idx;
+}
+
+static void ppm_release(KolibriPpmModel *m, uint32_t idx, unsigned cls) {
+    memcpy(&m->pool[idx], &m->free_list[cls], sizeof(uint32_t));
+    m->free_list[cls] = idx;
+}
+
+/* Find or insert the context of the given order; NULL when its bucket
+ * is pinned by contexts of the current symbol */
+static PpmContext *ppm_lookup(KolibriPpmModel *m, uint64_t history, unsigned order) {
+    uint64_t key = order >= 8 ? history : history & ((1ULL << (8 * order)) - 1);
+    uint64_t h = ppm_mix64(key ^ ((uint64_t)order * 0x9E3779B97F4A7C15ULL));
+    uint32_t check = (uint32_t)(h >> 32) | 1u;
+    PpmContext *bucket = m->table + (size_t)(h & m->bucket_mask) * PPM_BUCKET;
+
+    PpmContext *victim = NULL;
+    for (int i = 0; i < PPM_BUCKET; i++) {
+        PpmContext *c = &bucket[i];
+        if (c->check == check) {
+            c->stamp = m->stamp;
+            return c;
+        }
+        if (c->check == 0) {
+            if (!victim || victim->check != 0) victim = c;
+        } else if (c->stamp != m->stamp && (!victim || (victim->check != 0 && c->total < victim->total))) {
+            victim = c;
+        }
+    }
+    if (!victim) return NULL;
+
+    if (victim->check != 0) {
+        if (victim->list != PPM_NO_LIST) ppm_release(m, victim->list, victim->cap_class);
+        m->stats.evictions++;
+    } else {
+        m->stats.contexts++;
+    }
+    victim->check = check;
+    victim->list = PPM_NO_LIST;
+    victim->total = 0;
+    victim->count = 0;
+    victim->cap_class = 0;
+    victim->stamp = m->stamp;
+    return victim;
+}
+
+/* Add one occurrence of sym; -1 when the pool is exhausted and the model
+ * was flushed (all context pointers are then stale) */
+static int ppm_update(KolibriPpmModel *m, PpmContext *c, uint8_t sym) {
+    PpmSymbol *list = c->list != PPM_NO_LIST ? m->pool + c->list : NULL;
+    for (uint32_t i = 0; i < c->count; i++) {
+        if (list[i].sym != sym) continue;
+        list[i].freq += PPM_INC;
+        c->total += PPM_INC;
+        /* Keep frequent symbols near the front for shorter scans */
+        if (i > 0 && list[i].freq > list[i - 1].freq) {
+            PpmSymbol t = list[i];
+            list[i] = list[i - 1];
+            list[i - 1] = t;
+        }
+        goto rescale;
+    }
+
+    if (!list || c->count == (1u << c->cap_class)) {
+        unsigned cls = list ? c->cap_class + 1u : 0u;
+        uint32_t idx = ppm_alloc(m, cls);
+        if (idx == PPM_NO_LIST) {
+            m->stats.restarts++;
+            ppm_flush(m);
+            return -1;
+        }
+        if (list) {
+            memcpy(m->pool + idx, list, c->count * sizeof(PpmSymbol));
+            ppm_release(m, c->list, c->cap_class);
+        }
+        c->list = idx;
+        c->cap_class = (uint8_t)cls;
+        list = m->pool + idx;
+    }
+    list[c->count].sym = sym;
+    list[c->count].freq = PPM_INC;
+    list[c->count].reserved = 0;
+    c->count++;
+    c->total += PPM_INC;
+
+rescale:
+    if (c->total > PPM_MAX_TOTAL) {
+        uint32_t total = 0;
+        for (uint32_t i = 0; i < c->count; i++) {
+            list[i].freq = (uint16_t)((list[i].freq + 1) >> 1);
+            total += list[i].freq;
+        }
+        c->total = (uint16_t)total;
+    }
+    return 0;
+}
+
+static void ppm_update0(KolibriPpmModel *m, uint8_t sym) {
+    m->order0[sym] += PPM_INC;
+    m->total0 += PPM_INC;
+    if (m->total0 > PPM_MAX_TOTAL0) {
+        m->total0 = 0;
+        for (int i = 0; i < 256; i++) {
+            m->order0[i] = (uint16_t)((m->order0[i] >> 1) | 1);
+            m->total0 += m->order0[i];
+        }
+    }
+}
+
+static inline int ppm_is_excluded(const KolibriPpmModel *m, uint8_t sym) {
+    return (int)((m->excluded[sym >> 6] >> (sym & 63)) & 1u);
+}
+
+static inline void ppm_exclude(KolibriPpmModel *m, uint8_t sym) {
+    m->excluded[sym >> 6] |= 1ULL << (sym & 63);
+}
+
+/* Update every visited context from the highest order down to the coding one */
+static void ppm_update_visited(KolibriPpmModel *m, PpmContext **visited, unsigned count, uint8_t sym) {
+    for (unsigned i = 0; i < count; i++) {
+        if (visited[i] && ppm_update(m, visited[i], sym) != 0) return;
+    }
+}
+
+KolibriPpmModel *kolibri_ppm_create(const KolibriPpmConfig *config) {
+    KolibriPpmModel *m = (KolibriPpmModel *)calloc(1, sizeof(KolibriPpmModel));
+    if (!m) return NULL;
+
+    unsigned order = config && config->order ? config->order : KOLIBRI_PPM_DEFAULT_ORDER;
+    size_t limit = config && config->memory_limit ? config->memory_limit : KOLIBRI_PPM_DEFAULT_MEMORY;
+    if (order > KOLIBRI_PPM_MAX_ORDER) order = KOLIBRI_PPM_MAX_ORDER;
+    if (limit < KOLIBRI_PPM_MIN_MEMORY) limit = KOLIBRI_PPM_MIN_MEMORY;
+    if (limit > KOLIBRI_PPM_MAX_MEMORY) limit = KOLIBRI_PPM_MAX_MEMORY;
+
+    /* A quarter of the budget for the table, the rest for symbol lists */
+    size_t bucket_bytes = PPM_BUCKET * sizeof(PpmContext);
+    size_t buckets = 1;
+    while (buckets * 2 * bucket_bytes <= limit / 4) buckets *= 2;
+    size_t table_bytes = buckets * bucket_bytes;
+    size_t pool_entries = (limit - table_bytes) / sizeof(PpmSymbol);
+    if (pool_entries > 0xFFFFFFF0u) pool_entries = 0xFFFFFFF0u;
+
+    /* The clamped budget, not the carved size, is reported so that a model
+     * created from kolibri_ppm_get_config has the same layout */
+    m->order = order;
+    m->memory_limit = limit;
+    size_t arena_bytes = table_bytes + pool_entries * sizeof(PpmSymbol);
+    m->arena = aligned_alloc(64, (arena_bytes + 63) & ~(size_t)63);
+    if (!m->arena) {
+        free(m);
+        return NULL;
+    }
+    m->table = (PpmContext *)m->arena;
+    m->bucket_mask = buckets - 1;
+    m->pool = (PpmSymbol *)((uint8_t *)m->arena + table_bytes);
+    m->pool_size = (uint32_t)pool_entries;
+
+    kolibri_ppm_reset(m);
+    return m;
+}
+
+void kolibri_ppm_destroy(KolibriPpmModel *model) {
+    if (!model) return;
+    free(model->arena);
+    free(model);
+}
+
+void kolibri_ppm_reset(KolibriPpmModel *model) {
+    if (!model) return;
+    ppm_flush(model);
+    for (int i = 0; i < 256; i++) model->order0[i] = 1;
+    model->total0 = 256;
+    model->stamp = 0;
+    memset(&model->stats, 0, sizeof(model->stats));
+    model->stats.memory_limit = model->memory_limit;
+}
+
+void kolibri_ppm_get_config(const KolibriPpmModel *model, KolibriPpmConfig *config) {
+    if (!model || !config) return;
+    config->order = model->order;
+    config->memory_limit = model->memory_limit;
+}
+
+void kolibri_ppm_get_stats(const KolibriPpmModel *model, KolibriPpmStats *stats) {
+    if (!model || !stats) return;
+    *stats = model->stats;
+    stats->memory_used = (model->bucket_mask + 1) * PPM_BUCKET * sizeof(PpmContext) +
+                         (size_t)model->pool_top * sizeof(PpmSymbol);
+    stats->memory_limit = model->memory_limit;
+}
+
+int kolibri_ppm_encode(KolibriPpmModel *model,
+                       const uint8_t *input,
+                       size_t length,
+                       uint8_t *output,
+                       size_t capacity,
+                       size_t *output_size) {
+    if (!model || (!input && length) || !output || !output_size) return -1;
+
+    kolibri_ppm_reset(model);
+    PpmCoder rc;
+    coder_enc_init(&rc, output, capacity);
+    uint64_t history = 0;
+    PpmContext *visited[KOLIBRI_PPM_MAX_ORDER];
+
+    for (size_t pos = 0; pos < length && !rc.overflow; pos++) {
+        uint8_t sym = input[pos];
+        unsigned nvisited = 0;
+        int found = 0;
+        model->stamp++;
+        memset(model->excluded, 0, sizeof(model->excluded));
+
+        for (unsigned k = model->order; k >= 1 && !found; k--) {
+            PpmContext *c = ppm_lookup(model, history, k);
+            visited[nvisited++] = c;
+            if (!c || c->count == 0) continue;
+
+            const PpmSymbol *list = model->pool + c->list;
+            uint32_t total = 0, distinct = 0, cum = 0, freq = 0;
+            for (uint32_t i = 0; i < c->count; i++) {
+                if (ppm_is_excluded(model, list[i].sym)) continue;
+                if (list[i].sym == sym) {
+                    cum = total;
+                    freq = list[i].freq;
+                }
+                total += list[i].freq;
+                distinct++;
+            }
+            if (distinct == 0) continue;
+
+            if (freq) {
+                coder_encode(&rc, cum, freq, total + distinct);
+                found = 1;
+            } else {
+                coder_encode(&rc, total, distinct, total + distinct);
+                for (uint32_t i = 0; i < c->count; i++) ppm_exclude(model, list[i].sym);
+            }
+        }
+
+        if (!found) {
+            uint32_t total = 0, cum = 0;
+            for (int s = 0; s < 256; s++) {
+                if (ppm_is_excluded(model, (uint8_t)s)) continue;
+                if (s == sym) cum = total;
+                total += model->order0[s];
+            }
+            coder_encode(&rc, cum, model->order0[sym], total);
+            ppm_update0(model, sym);
+        }
+
+        ppm_update_visited(model, visited, nvisited, sym);
+        history = (history << 8) | sym;
+    }
+
+    coder_enc_flush(&rc);
+    if (rc.overflow) return -1;
+    *output_size = rc.pos;
+    return 0;
+}
+
+int kolibri_ppm_decode(KolibriPpmModel *model,
+                       const uint8_t *input,
+                       size_t input_size,
+                       uint8_t *output,
+                       size_t length) {
+    if (!model || (!input && input_size) || (!output && length)) return -1;
+
+    kolibri_ppm_reset(model);
+    PpmCoder rc;
+    coder_dec_init(&rc, input, input_size);
+    uint64_t history = 0;
+    PpmContext *visited[KOLIBRI_PPM_MAX_ORDER];
+
+    for (size_t pos = 0; pos < length; pos++) {
+        unsigned nvisited = 0;
+        int found = 0;
+        uint8_t sym = 0;
+        model->stamp++;
+        memset(model->excluded, 0, sizeof(model->excluded));
+
+        for (unsigned k = model->order; k >= 1 && !found; k--) {
+            PpmContext *c = ppm_lookup(model, history, k);
+            visited[nvisited++] = c;
+            if (!c || c->count == 0) continue;
+
+            const PpmSymbol *list = model->pool + c->list;
+            uint32_t total = 0, distinct = 0;
+            for (uint32_t i = 0; i < c->count; i++) {
+                if (ppm_is_excluded(model, list[i].sym)) continue;
+                total += list[i].freq;
+                distinct++;
+            }
+            if (distinct == 0) continue;
+
+            uint32_t target = coder_get(&rc, total + distinct);
+            if (target >= total + distinct) return -1;
+            if (target < total) {
+                uint32_t cum = 0;
+                for (uint32_t i = 0; i < c->count; i++) {
+                    if (ppm_is_excluded(model, list[i].sym)) continue;
+                    if (cum + list[i].freq > target) {
+                        sym = list[i].sym;
+                        coder_decode(&rc, cum, list[i].freq);
+                        break;
+                    }
+                    cum += list[i].freq;
+                }
+                found = 1;
+            } else {
+                coder_decode(&rc, total, distinct);
+                for (uint32_t i = 0; i < c->count; i++) ppm_exclude(model, list[i].sym);
+            }
+        }
+
+        if (!found) {
+            uint32_t total = 0;
+            for (int s = 0; s < 256; s++) {
+                if (!ppm_is_excluded(model, (uint8_t)s)) total += model->order0[s];
+            }
+            if (total == 0) return -1;
+            uint32_t target = coder_get(&rc, total);
+            if (target >= total) return -1;
+            uint32_t cum = 0;
+            int s = 0;
+            for (; s < 256; s++) {
+                if (ppm_is_excluded(model, (uint8_t)s)) continue;
+                if (cum + model->order0[s] > target) break;
+                cum += model->order0[s];
+            }
+            sym = (uint8_t)s;
+            coder_decode(&rc, cum, model->order0[sym]);
+            ppm_update0(model, sym);
+        }
+
+        output[pos] = sym;
+        ppm_update_visited(model, visited, nvisited, sym);
+        history = (history << 8) | sym;
+    }
+
+    return 0;
+}
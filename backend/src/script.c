@@ -8,6 +8,7 @@
 
 #include <ctype.h>
 #include <errno.h>
+#include <stdarg.h>
 #include <openssl/sha.h>
 #include <math.h>
 #include <stdbool.h>
@@ -301,6 +302,10 @@ static const char *const KOLIBRI_KEYWORDS[] = {
 static void kolibri_to_lower_ascii(const char *src, char *dst, size_t dst_len);
 static void kolibri_script_set_mode(KolibriScript *script, const char *mode);
 static void kolibri_apply_mode(KolibriScript *script, char *answer);
+static int kolibri_script_learn(KolibriScript *script, const char *question, const char *answer,
+                                const char *source, uint64_t timestamp);
+static size_t kolibri_script_association_count(const KolibriScript *script);
+static const KolibriAssociation *kolibri_script_association(const KolibriScript *script, size_t index);
 
 static size_t kolibri_keyword_count(void) {
     return sizeof(KOLIBRI_KEYWORDS) / sizeof(KOLIBRI_KEYWORDS[0]);
@@ -329,7 +334,7 @@ static bool kolibri_is_word_delimiter(unsigned char ch) {
     }
 }
 
-static void kolibri_generate_text_from_gene(const KolibriFormula *formula,
+static void kolibri_generate_text_from_gene(const KolibriGene *gene,
                                             const char *question,
                                             int numeric_answer,
                                             char *buffer,
@@ -338,7 +343,7 @@ static void kolibri_generate_text_from_gene(const KolibriFormula *formula,
         return;
     }
     buffer[0] = '\0';
-    if (!formula || formula->gene.length == 0) {
+    if (!gene || gene->length == 0) {
         return;
     }
     static const char alphabet[] = "abcdefghijklmnopqrstuvwxyz";
@@ -350,8 +355,8 @@ static void kolibri_generate_text_from_gene(const KolibriFormula *formula,
     if (seed == 0) {
         seed = 1U;
     }
-    for (size_t i = 0; i < formula->gene.length; ++i) {
-        seed = seed * 1315423911ULL + (uint64_t)(formula->gene.digits[i] + 1U);
+    for (size_t i = 0; i < gene->length; ++i) {
+        seed = seed * 1315423911ULL + (uint64_t)(gene->digits[i] + 1U);
     }
     if (question) {
         for (const unsigned char *p = (const unsigned char *)question; *p; ++p) {
@@ -1139,17 +1144,18 @@ static void kolibri_to_lower_ascii(const char *src, char *dst, size_t dst_len) {
     dst[i] = '\0';
 }
 
-static const KolibriAssociation *kolibri_find_partial_association(const KolibriFormulaPool *pool,
+static const KolibriAssociation *kolibri_find_partial_association(const KolibriScript *script,
                                                                   const char *question) {
-    if (!pool || !question) {
+    if (!script->pool || !question) {
         return NULL;
     }
     char lowered_question[256];
     kolibri_to_lower_ascii(question, lowered_question, sizeof(lowered_question));
     size_t best_len = 0U;
     const KolibriAssociation *best = NULL;
-    for (size_t i = 0; i < pool->association_count; ++i) {
-        const KolibriAssociation *assoc = &pool->associations[i];
+    size_t count = kolibri_script_association_count(script);
+    for (size_t i = 0; i < count; ++i) {
+        const KolibriAssociation *assoc = kolibri_script_association(script, i);
         char lowered_assoc[256];
         kolibri_to_lower_ascii(assoc->question, lowered_assoc, sizeof(lowered_assoc));
         if (strstr(lowered_question, lowered_assoc) || strstr(lowered_assoc, lowered_question)) {
@@ -1204,20 +1210,20 @@ static bool kolibri_try_calculate(const char *question, char *buffer, size_t buf
     return false;
 }
 
-static void kolibri_record_ngrams(KolibriScript *script,
-                                  const char *question,
-                                  const char *answer,
-                                  const char *source,
-                                  uint64_t timestamp) {
+static int kolibri_record_ngrams(KolibriScript *script,
+                                 const char *question,
+                                 const char *answer,
+                                 const char *source,
+                                 uint64_t timestamp) {
     if (!script || !script->pool || !question || !answer) {
-        return;
+        return 0;
     }
     char copy[256];
     strncpy(copy, question, sizeof(copy) - 1U);
     copy[sizeof(copy) - 1U] = '\0';
     kolibri_trim_spaces(copy);
     if (copy[0] == '\0') {
-        return;
+        return 0;
     }
     char *tokens[32];
     size_t token_count = 0;
@@ -1228,7 +1234,7 @@ static void kolibri_record_ngrams(KolibriScript *script,
         tokens[token_count++] = tok;
     }
     if (token_count < 2) {
-        return;
+        return 0;
     }
     char recorded[64][256];
     size_t recorded_count = 0;
@@ -1258,14 +1264,12 @@ static void kolibri_record_ngrams(KolibriScript *script,
             strncpy(recorded[recorded_count], ngram, sizeof(recorded[recorded_count]) - 1U);
             recorded[recorded_count][sizeof(recorded[recorded_count]) - 1U] = '\0';
             recorded_count++;
-            (void)kf_pool_add_association(script->pool,
-                                          &script->symbol_table,
-                                          ngram,
-                                          answer,
-                                          source ? source : "ngram",
-                                          timestamp);
+            if (kolibri_script_learn(script, ngram, answer, source ? source : "ngram", timestamp) != 0) {
+                return -1;
+            }
         }
     }
+    return 0;
 }
 
 static bool kolibri_token_is_terminator(const KolibriToken *token, const char *const *keywords, size_t keyword_count,
@@ -2297,6 +2301,127 @@ static void kolibri_script_log(KolibriScript *script, const char *event, const c
     kg_append(script->genome, event, digits_payload, NULL);
 }
 
+/* ===================== Output ===================== */
+
+#define KOLIBRI_OUTPUT_INITIAL_CAPACITY 256U
+#define KOLIBRI_OUTPUT_STACK_SIZE 512U
+
+static int kolibri_buffer_reserve(KolibriScriptBuffer *buffer, size_t extra) {
+    if (buffer->failed) {
+        return -1;
+    }
+    size_t need = buffer->length + extra + 1U;
+    if (need <= buffer->capacity) {
+        return 0;
+    }
+    size_t capacity = buffer->capacity ? buffer->capacity : KOLIBRI_OUTPUT_INITIAL_CAPACITY;
+    while (capacity < need) {
+        capacity *= KOLIBRI_ARRAY_GROWTH_FACTOR;
+    }
+    char *data = (char *)realloc(buffer->data, capacity);
+    if (!data) {
+        buffer->failed = 1;
+        return -1;
+    }
+    buffer->data = data;
+    buffer->capacity = capacity;
+    return 0;
+}
+
+static int kolibri_buffer_write(void *user, const char *data, size_t length) {
+    KolibriScriptBuffer *buffer = (KolibriScriptBuffer *)user;
+    if (kolibri_buffer_reserve(buffer, length) != 0) {
+        return -1;
+    }
+    memcpy(buffer->data + buffer->length, data, length);
+    buffer->length += length;
+    buffer->data[buffer->length] = '\0';
+    return 0;
+}
+
+/* Единая точка вывода интерпретатора. Встроенный буфер форматируется на
+ * месте, пользовательский приёмник получает готовый фрагмент. */
+static void kolibri_script_emit(KolibriScript *script, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    if (!script->sink.write) {
+        vfprintf(script->vyvod ? script->vyvod : stdout, format, args);
+        va_end(args);
+        return;
+    }
+
+    va_list copy;
+    va_copy(copy, args);
+    if (script->sink.write == kolibri_buffer_write) {
+        KolibriScriptBuffer *buffer = (KolibriScriptBuffer *)script->sink.user;
+        size_t room = buffer->capacity > buffer->length ? buffer->capacity - buffer->length : 0U;
+        int needed = vsnprintf(room ? buffer->data + buffer->length : NULL, room, format, args);
+        if (needed >= 0 && (size_t)needed >= room &&
+            kolibri_buffer_reserve(buffer, (size_t)needed) == 0) {
+            vsnprintf(buffer->data + buffer->length, (size_t)needed + 1U, format, copy);
+        }
+        if (needed >= 0 && !buffer->failed) {
+            buffer->length += (size_t)needed;
+        } else if (buffer->data && buffer->length < buffer->capacity) {
+            buffer->data[buffer->length] = '\0';
+        }
+    } else {
+        char stack[KOLIBRI_OUTPUT_STACK_SIZE];
+        int needed = vsnprintf(stack, sizeof(stack), format, args);
+        if (needed >= 0 && (size_t)needed < sizeof(stack)) {
+            (void)script->sink.write(script->sink.user, stack, (size_t)needed);
+        } else if (needed >= 0) {
+            char *heap = (char *)malloc((size_t)needed + 1U);
+            if (heap) {
+                vsnprintf(heap, (size_t)needed + 1U, format, copy);
+                (void)script->sink.write(script->sink.user, heap, (size_t)needed);
+                free(heap);
+            }
+        }
+    }
+    va_end(copy);
+    va_end(args);
+}
+
+/* ===================== Общий пул ===================== */
+
+/* Контекст над общим пулом (ks_init_shared) пишет в свой оверлей, base
+ * не меняется; чтение объединяет оба. */
+static int kolibri_script_learn(KolibriScript *script, const char *question, const char *answer,
+                                const char *source, uint64_t timestamp) {
+    if (script->base) {
+        return kf_overlay_add_association(&script->overlay, &script->symbol_table,
+                                          question, answer, source, timestamp);
+    }
+    return kf_pool_add_association(script->pool, &script->symbol_table, question, answer, source, timestamp);
+}
+
+static size_t kolibri_script_association_count(const KolibriScript *script) {
+    if (script->base) {
+        return kf_overlay_association_count(&script->overlay);
+    }
+    return script->pool->association_count;
+}
+
+static const KolibriAssociation *kolibri_script_association(const KolibriScript *script, size_t index) {
+    if (script->base) {
+        return kf_overlay_association(&script->overlay, index);
+    }
+    return &script->pool->associations[index];
+}
+
+static int kolibri_script_formula(const KolibriScript *script, size_t index, KolibriFormulaView *view) {
+    if (script->base) {
+        size_t count = kf_overlay_formula_count(&script->overlay);
+        return count ? kf_overlay_formula(&script->overlay, index % count, view) : -1;
+    }
+    if (script->pool->count == 0) {
+        return -1;
+    }
+    kf_formula_view_init(view, &script->pool->formulas[index % script->pool->count]);
+    return 0;
+}
+
 /* ===================== Interpreter ===================== */
 
 static int kolibri_execute_show(KolibriScript *script, const KolibriStatement *stmt) {
@@ -2310,10 +2435,7 @@ static int kolibri_execute_show(KolibriScript *script, const KolibriStatement *s
         kolibri_value_free(&value);
         return -1;
     }
-    if (!script->vyvod) {
-        script->vyvod = stdout;
-    }
-    fprintf(script->vyvod, "%s\n", text);
+    kolibri_script_emit(script, "%s\n", text);
     kolibri_script_log(script, "SCRIPT_SHOW", text);
     free(text);
     kolibri_value_free(&value);
@@ -2348,8 +2470,8 @@ static int kolibri_execute_mode(KolibriScript *script, const KolibriStatement *s
     char log_payload[128];
     snprintf(log_payload, sizeof(log_payload), "mode=%s", script->mode);
     kolibri_script_log(script, "SCRIPT_MODE", log_payload);
-    if (script->vyvod) {
-        fprintf(script->vyvod, "[Колибри] Режим установлен: %s\n", script->mode);
+    if (script->vyvod || script->sink.write) {
+        kolibri_script_emit(script, "[Колибри] Режим установлен: %s\n", script->mode);
     }
     free(text);
     kolibri_value_free(&value);
@@ -2400,8 +2522,8 @@ static int kolibri_execute_verify(KolibriScript *script, const KolibriStatement
     kolibri_script_log(script, "SCRIPT_VERIFY", expected_text);
     kolibri_script_log(script, "CRYSTAL_VERIFY", status_buffer);
 
-    if (script->vyvod) {
-        fprintf(script->vyvod, "[Колибри] Верификация: %s\n", match ? "успешна" : "ошибка");
+    if (script->vyvod || script->sink.write) {
+        kolibri_script_emit(script, "[Колибри] Верификация: %s\n", match ? "успешна" : "ошибка");
     }
 
     free(expected_text);
@@ -2469,14 +2591,18 @@ static int kolibri_execute_teach(KolibriScript *script, const KolibriStatement *
         kolibri_script_log(script, "SCRIPT_ERROR", "Кристалл не смог зафиксировать обучение");
     }
 
+    int status = 0;
     if (script->pool) {
         uint64_t now = (uint64_t)time(NULL);
-        (void)kf_pool_add_association(script->pool, &script->symbol_table, left_text, right_text, "teach", now);
-        kolibri_record_ngrams(script, left_text, right_text, "teach", now);
+        if (kolibri_script_learn(script, left_text, right_text, "teach", now) != 0 ||
+            kolibri_record_ngrams(script, left_text, right_text, "teach", now) != 0) {
+            kolibri_script_log(script, "SCRIPT_ERROR", "Не удалось сохранить ассоциацию");
+            status = -1;
+        }
     }
     kolibri_value_free(&left);
     kolibri_value_free(&right);
-    return 0;
+    return status;
 }
 
 static int kolibri_execute_create_formula(KolibriScript *script, const KolibriStatement *stmt) {
@@ -2511,9 +2637,10 @@ static int kolibri_execute_evaluate_formula(KolibriScript *script, const Kolibri
         return -1;
     }
     int task_int = kf_hash_from_text(task_text);
-    KolibriFormula *formula = &script->pool->formulas[binding->pool_index % script->pool->count];
+    KolibriFormulaView formula;
     int output = 0;
-    if (kf_formula_apply(formula, task_int, &output) != 0) {
+    if (kolibri_script_formula(script, binding->pool_index, &formula) != 0 ||
+        kf_formula_view_apply(&formula, task_int, &output) != 0) {
         free(task_text);
         kolibri_value_free(&task_value);
         kolibri_script_log(script, "SCRIPT_ERROR", "Формула вернула ошибку");
@@ -2521,11 +2648,11 @@ static int kolibri_execute_evaluate_formula(KolibriScript *script, const Kolibri
     }
     char answer_buffer[512];
     bool answer_generated = false;
-    if (kf_formula_lookup_answer(formula, task_int, answer_buffer, sizeof(answer_buffer)) == 0) {
+    if (kf_formula_view_lookup_answer(&formula, task_int, answer_buffer, sizeof(answer_buffer)) == 0) {
         answer_generated = true;
     }
     if (!answer_generated) {
-        const KolibriAssociation *partial = kolibri_find_partial_association(script->pool, task_text);
+        const KolibriAssociation *partial = kolibri_find_partial_association(script, task_text);
         if (partial) {
             strncpy(answer_buffer, partial->answer, sizeof(answer_buffer) - 1U);
             answer_buffer[sizeof(answer_buffer) - 1U] = '\0';
@@ -2539,15 +2666,18 @@ static int kolibri_execute_evaluate_formula(KolibriScript *script, const Kolibri
     }
     if (!answer_generated) {
         char synthesized[256];
-        kolibri_generate_text_from_gene(formula, task_text, output, synthesized, sizeof(synthesized));
+        kolibri_generate_text_from_gene(&formula.gene, task_text, output, synthesized, sizeof(synthesized));
         if (synthesized[0] != '\0') {
             strncpy(answer_buffer, synthesized, sizeof(answer_buffer) - 1U);
             answer_buffer[sizeof(answer_buffer) - 1U] = '\0';
             answer_generated = true;
-            if (script->pool) {
-                uint64_t now = (uint64_t)time(NULL);
-                (void)kf_pool_add_association(script->pool, &script->symbol_table, task_text, answer_buffer, "auto", now);
-                kolibri_record_ngrams(script, task_text, answer_buffer, "auto", now);
+            uint64_t now = (uint64_t)time(NULL);
+            if (kolibri_script_learn(script, task_text, answer_buffer, "auto", now) != 0 ||
+                kolibri_record_ngrams(script, task_text, answer_buffer, "auto", now) != 0) {
+                free(task_text);
+                kolibri_value_free(&task_value);
+                kolibri_script_log(script, "SCRIPT_ERROR", "Не удалось сохранить ассоциацию");
+                return -1;
             }
         }
     }
@@ -2560,7 +2690,7 @@ static int kolibri_execute_evaluate_formula(KolibriScript *script, const Kolibri
             answer_buffer[sizeof(answer_buffer) - 1U] = '\0';
         }
     }
-    double fitness = formula->fitness;
+    double fitness = formula.fitness;
     binding->last_fitness = fitness;
     kolibri_script_log(script, "SCRIPT_EVALUATE", task_text);
     kolibri_clean_answer(answer_buffer);
@@ -2599,9 +2729,12 @@ static int kolibri_execute_save_formula(KolibriScript *script, const KolibriStat
         kolibri_script_log(script, "SCRIPT_ERROR", "Формула не найдена для сохранения");
         return -1;
     }
-    KolibriFormula *formula = &script->pool->formulas[binding->pool_index % script->pool->count];
+    KolibriFormulaView formula;
     uint8_t digits[128];
-    size_t len = kf_formula_digits(formula, digits, sizeof(digits));
+    size_t len = 0;
+    if (kolibri_script_formula(script, binding->pool_index, &formula) == 0) {
+        len = kf_formula_view_digits(&formula, digits, sizeof(digits));
+    }
     if (len == 0 || len >= sizeof(digits)) {
         kolibri_script_log(script, "SCRIPT_ERROR", "Не удалось сериализовать формулу");
         return -1;
@@ -2628,21 +2761,23 @@ static int kolibri_execute_call_evolution(KolibriScript *script) {
     if (!script->pool) {
         return 0;
     }
-    kf_pool_tick(script->pool, 1U);
-    const KolibriFormula *best = kf_pool_best(script->pool);
-    if (best) {
+    if (!script->base) {
+        kf_pool_tick(script->pool, 1U);
+    } else if (kf_overlay_tick(&script->overlay, 1U) != 0) {
+        kolibri_script_log(script, "SCRIPT_ERROR", "Не хватило памяти для эволюции");
+        return -1;
+    }
+    KolibriFormulaView best;
+    if (kolibri_script_formula(script, 0, &best) == 0) {
         char buffer[64];
-        snprintf(buffer, sizeof(buffer), "%.6f", best->fitness);
+        snprintf(buffer, sizeof(buffer), "%.6f", best.fitness);
         kolibri_script_log(script, "SCRIPT_TICK", buffer);
     }
     return 0;
 }
 
 static int kolibri_execute_print_canvas(KolibriScript *script) {
-    if (!script->vyvod) {
-        script->vyvod = stdout;
-    }
-    fprintf(script->vyvod, "[Kolibri] визуализация памяти пока не реализована\n");
+    kolibri_script_emit(script, "[Kolibri] визуализация памяти пока не реализована\n");
     kolibri_script_log(script, "SCRIPT_CANVAS", "недоступно");
     return 0;
 }
@@ -2762,16 +2897,58 @@ int ks_init(KolibriScript *skript, KolibriFormulaPool *pool, KolibriGenome *geno
     kolibri_symbol_table_load(&skript->symbol_table);
     kolibri_symbol_table_seed_defaults(&skript->symbol_table);
     kolibri_script_set_mode(skript, "neutral");
+    skript->symbol_mark = skript->symbol_table.count;
+    skript->symbol_page_mark = skript->symbol_table.page_count;
+    return 0;
+}
+
+int ks_init_shared(KolibriScript *skript, const KolibriFormulaPool *base,
+                   KolibriGenome *genome) {
+    if (!skript || !base) {
+        return -1;
+    }
+    /* Запись в base не происходит: все изменения идут в оверлей */
+    if (ks_init(skript, (KolibriFormulaPool *)base, genome) != 0) {
+        return -1;
+    }
+    skript->base = base;
+    kf_overlay_init(&skript->overlay, base);
     return 0;
 }
 
+void ks_reset(KolibriScript *skript) {
+    if (!skript) {
+        return;
+    }
+    kolibri_script_reset(skript);
+    if (skript->base) {
+        kf_overlay_reset(&skript->overlay);
+        if (!skript->genome) {
+            kolibri_symbol_table_rollback(&skript->symbol_table, skript->symbol_mark,
+                                          skript->symbol_page_mark);
+        }
+    }
+    skript->buffer.length = 0U;
+    skript->buffer.failed = 0;
+    if (skript->buffer.data) {
+        skript->buffer.data[0] = '\0';
+    }
+}
+
 void ks_free(KolibriScript *skript) {
     if (!skript) {
         return;
     }
+    kolibri_symbol_table_flush(&skript->symbol_table);
     kolibri_script_reset(skript);
     kolibri_digit_text_free(&skript->source_stream);
     kolibri_crystal_free(&skript->crystal_core);
+    free(skript->buffer.data);
+    memset(&skript->buffer, 0, sizeof(skript->buffer));
+    kf_overlay_free(&skript->overlay);
+    skript->base = NULL;
+    skript->sink.write = NULL;
+    skript->sink.user = NULL;
     skript->pool = NULL;
     skript->genome = NULL;
     skript->vyvod = NULL;
@@ -2782,6 +2959,46 @@ void ks_set_output(KolibriScript *skript, FILE *vyvod) {
         return;
     }
     skript->vyvod = vyvod ? vyvod : stdout;
+    skript->sink.write = NULL;
+    skript->sink.user = NULL;
+}
+
+void ks_set_sink(KolibriScript *skript, KolibriScriptWriteFn write, void *user) {
+    if (!skript) {
+        return;
+    }
+    if (!write) {
+        ks_set_output(skript, stdout);
+        return;
+    }
+    skript->sink.write = write;
+    skript->sink.user = user;
+}
+
+void ks_capture_output(KolibriScript *skript) {
+    if (!skript) {
+        return;
+    }
+    skript->buffer.length = 0U;
+    skript->buffer.failed = 0;
+    if (skript->buffer.data) {
+        skript->buffer.data[0] = '\0';
+    }
+    skript->sink.write = kolibri_buffer_write;
+    skript->sink.user = &skript->buffer;
+}
+
+const char *ks_output(const KolibriScript *skript, size_t *length) {
+    if (length) {
+        *length = 0U;
+    }
+    if (!skript || skript->buffer.failed) {
+        return NULL;
+    }
+    if (length) {
+        *length = skript->buffer.length;
+    }
+    return skript->buffer.data ? skript->buffer.data : "";
 }
 
 int ks_load_text(KolibriScript *skript, const char *text) {
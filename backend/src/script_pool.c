@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2025 Кочуров Владислав Евгеньевич
+ *
+ * KolibriScript Context Pool
+ * Контексты создаются один раз (таблица символов, буферы), общий пул
+ * формул только читается. Свободные контексты хранятся стеком индексов
+ * под мьютексом: последний возвращённый контекст выдаётся первым, пока
+ * его память ещё в кэше.
+ */
+
+#include "kolibri/script_pool.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define KS_CONTEXT_POOL_MAX 64
+
+struct KolibriScriptContextPool {
+    pthread_mutex_t lock;
+    pthread_cond_t available;
+    KolibriScript *contexts;
+    size_t count;
+    size_t *free_slots;
+    size_t free_count;
+};
+
+static size_t context_pool_default_size(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus < 1) {
+        return 1U;
+    }
+    return (size_t)cpus < KS_CONTEXT_POOL_MAX ? (size_t)cpus : KS_CONTEXT_POOL_MAX;
+}
+
+KolibriScriptContextPool *ks_context_pool_create(const KolibriFormulaPool *base,
+                                                 size_t contexts) {
+    if (!base) {
+        return NULL;
+    }
+    if (contexts == 0U) {
+        contexts = context_pool_default_size();
+    }
+    KolibriScriptContextPool *pool =
+        (KolibriScriptContextPool *)calloc(1, sizeof(KolibriScriptContextPool));
+    if (!pool) {
+        return NULL;
+    }
+    pool->contexts = (KolibriScript *)calloc(contexts, sizeof(KolibriScript));
+    pool->free_slots = (size_t *)calloc(contexts, sizeof(size_t));
+    if (!pool->contexts || !pool->free_slots) {
+        free(pool->contexts);
+        free(pool->free_slots);
+        free(pool);
+        return NULL;
+    }
+    for (size_t i = 0; i < contexts; ++i) {
+        if (ks_init_shared(&pool->contexts[i], base, NULL) != 0) {
+            for (size_t j = 0; j < i; ++j) {
+                ks_free(&pool->contexts[j]);
+            }
+            free(pool->contexts);
+            free(pool->free_slots);
+            free(pool);
+            return NULL;
+        }
+        pool->free_slots[i] = contexts - 1U - i;
+    }
+    pool->count = contexts;
+    pool->free_count = contexts;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->available, NULL);
+    return pool;
+}
+
+void ks_context_pool_destroy(KolibriScriptContextPool *pool) {
+    if (!pool) {
+        return;
+    }
+    for (size_t i = 0; i < pool->count; ++i) {
+        ks_free(&pool->contexts[i]);
+    }
+    pthread_cond_destroy(&pool->available);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->contexts);
+    free(pool->free_slots);
+    free(pool);
+}
+
+KolibriScript *ks_context_acquire(KolibriScriptContextPool *pool) {
+    if (!pool) {
+        return NULL;
+    }
+    pthread_mutex_lock(&pool->lock);
+    while (pool->free_count == 0U) {
+        pthread_cond_wait(&pool->available, &pool->lock);
+    }
+    size_t slot = pool->free_slots[--pool->free_count];
+    pthread_mutex_unlock(&pool->lock);
+
+    KolibriScript *script = &pool->contexts[slot];
+    ks_capture_output(script);
+    return script;
+}
+
+void ks_context_release(KolibriScriptContextPool *pool, KolibriScript *script) {
+    if (!pool || !script || script < pool->contexts ||
+        script >= pool->contexts + pool->count) {
+        return;
+    }
+    /* Сброс вне блокировки: другие потоки не ждут чужой очистки */
+    ks_reset(script);
+    pthread_mutex_lock(&pool->lock);
+    pool->free_slots[pool->free_count++] = (size_t)(script - pool->contexts);
+    pthread_cond_signal(&pool->available);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+size_t ks_context_pool_size(const KolibriScriptContextPool *pool) {
+    return pool ? pool->count : 0U;
+}
@@ -14,6 +14,25 @@
 #include <string.h>
 #include <time.h>
 
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+static inline size_t count_bits64(uint64_t value) {
+#if defined(__GNUC__)
+    return (size_t)__builtin_popcountll(value);
+#else
+    size_t count = 0;
+    while (value) {
+        value &= value - 1U;
+        count++;
+    }
+    return count;
+#endif
+}
+
 void k_semantic_pattern_init(KolibriSemanticPattern *pattern) {
     if (!pattern) return;
     
@@ -48,9 +67,11 @@ int k_semantic_context_add_word(KolibriSemanticContext *ctx,
     if (!ctx || !word) return -1;
     if (ctx->context_count >= KOLIBRI_SEMANTIC_CONTEXT_MAX) return -1;
     
-    /* Кодируем слово в цифры */
+    /* Кодируем слово в цифры (3 цифры на байт, нужны первые PATTERN_SIZE) */
     size_t word_len = strlen(word);
-    uint8_t buffer[1024];
+    size_t take = (KOLIBRI_SEMANTIC_PATTERN_SIZE + 2) / 3;
+    if (word_len > take) word_len = take;
+    uint8_t buffer[KOLIBRI_SEMANTIC_PATTERN_SIZE + 2];
     kolibri_potok_cifr stream;
     
     if (kolibri_potok_cifr_init(&stream, buffer, sizeof(buffer)) != 0) {
@@ -61,9 +82,14 @@ int k_semantic_context_add_word(KolibriSemanticContext *ctx,
         return -1;
     }
     
-    /* Сохраняем в контекст */
+    /* Сохраняем в контекст (поток указывает на собственный буфер контекста) */
     size_t idx = ctx->context_count;
-    ctx->context_words[idx] = stream;
+    size_t digits = stream.dlina < KOLIBRI_SEMANTIC_PATTERN_SIZE ? stream.dlina
+                                                                 : KOLIBRI_SEMANTIC_PATTERN_SIZE;
+    memcpy(ctx->word_data[idx], buffer, digits);
+    kolibri_potok_cifr_init(&ctx->context_words[idx], ctx->word_data[idx],
+                            sizeof(ctx->word_data[idx]));
+    ctx->context_words[idx].dlina = digits;
     ctx->relevance[idx] = relevance;
     ctx->context_count++;
     
@@ -71,66 +97,77 @@ int k_semantic_context_add_word(KolibriSemanticContext *ctx,
 }
 
 /**
- * Внутренняя функция: вычисление fitness паттерна
- * Чем лучше паттерн связывает слово с контекстом, тем выше fitness
+ * Внутренняя структура: контекст, подготовленный для оценки fitness.
+ * Длины и веса считаются один раз, а не для каждой особи.
  */
-static double compute_pattern_fitness(const uint8_t *pattern,
-                                     size_t pattern_len,
-                                     const kolibri_potok_cifr *word_digits,
-                                     const KolibriSemanticContext *ctx) {
-    if (!pattern || !word_digits || !ctx) return 0.0;
-    
-    double total_fitness = 0.0;
-    
-    /* Для каждого слова в контексте */
+typedef struct {
+    const uint8_t *digits[KOLIBRI_SEMANTIC_CONTEXT_MAX];
+    size_t length[KOLIBRI_SEMANTIC_CONTEXT_MAX];
+    double weight[KOLIBRI_SEMANTIC_CONTEXT_MAX]; /* relevance / (min_len * count) */
+    size_t count;
+    double max_fitness;                          /* Достижимый максимум */
+} KolibriFitnessPlan;
+
+static void fitness_plan_init(KolibriFitnessPlan *plan,
+                              const KolibriSemanticContext *ctx,
+                              size_t pattern_len) {
+    plan->count = 0;
+    plan->max_fitness = 0.0;
     for (size_t i = 0; i < ctx->context_count; i++) {
         const kolibri_potok_cifr *context_word = &ctx->context_words[i];
-        double relevance = ctx->relevance[i];
-        
-        /* Вычисляем, насколько паттерн связывает основное слово с контекстным */
-        double match_score = 0.0;
-        
-        /* Простая метрика: совпадение паттерна с началом контекстного слова */
         size_t min_len = pattern_len < context_word->dlina ? pattern_len : context_word->dlina;
-        size_t matches = 0;
+        /* Пустое слово ничего не добавляет (раньше давало 0/0) */
+        if (min_len == 0) continue;
         
-        for (size_t j = 0; j < min_len; j++) {
-            if (pattern[j] == context_word->danniye[j]) {
-                matches++;
-            }
-        }
-        
-        match_score = (double)matches / (double)min_len;
-        total_fitness += match_score * relevance;
+        double weight = ctx->relevance[i] / ((double)min_len * (double)ctx->context_count);
+        plan->digits[plan->count] = context_word->danniye;
+        plan->length[plan->count] = min_len;
+        plan->weight[plan->count] = weight;
+        plan->max_fitness += weight * (double)min_len;
+        plan->count++;
     }
-    
-    /* Нормализуем */
-    if (ctx->context_count > 0) {
-        total_fitness /= (double)ctx->context_count;
+}
+
+/**
+ * Внутренняя функция: вычисление fitness паттерна
+ * Чем лучше паттерн связывает слово с контекстом, тем выше fitness:
+ * доля совпадений с началом каждого контекстного слова, взвешенная
+ * релевантностью и нормированная на размер контекста.
+ */
+static double compute_pattern_fitness(const uint8_t *pattern,
+                                      const KolibriFitnessPlan *plan) {
+    double total_fitness = 0.0;
+    for (size_t i = 0; i < plan->count; i++) {
+        size_t matches = k_semantic_count_equal(pattern, plan->digits[i], plan->length[i]);
+        total_fitness += (double)matches * plan->weight[i];
     }
-    
     return total_fitness;
 }
 
 /**
  * Внутренняя функция: мутация паттерна
+ * Возвращает 1, если паттерн изменился
  */
-static void mutate_pattern(uint8_t *pattern, size_t len, KolibriRng *rng) {
-    if (!pattern || !rng || len == 0) return;
+static int mutate_pattern(uint8_t *pattern, size_t len, KolibriRng *rng) {
+    if (!pattern || !rng || len == 0) return 0;
     
     /* Выбираем случайную позицию */
     size_t pos = k_rng_next(rng) % len;
     
     /* Меняем цифру на случайную 0-9 */
-    pattern[pos] = (uint8_t)(k_rng_next(rng) % 10);
+    uint8_t digit = (uint8_t)(k_rng_next(rng) % 10);
+    int changed = pattern[pos] != digit;
+    pattern[pos] = digit;
+    return changed;
 }
 
 /**
  * Внутренняя функция: кроссовер двух паттернов
+ * Возвращает точку разреза (0 — потомок совпадает с p2)
  */
-static void crossover_patterns(const uint8_t *p1, const uint8_t *p2,
-                              uint8_t *offspring, size_t len, KolibriRng *rng) {
-    if (!p1 || !p2 || !offspring || !rng || len == 0) return;
+static size_t crossover_patterns(const uint8_t *p1, const uint8_t *p2,
+                                 uint8_t *offspring, size_t len, KolibriRng *rng) {
+    if (!p1 || !p2 || !offspring || !rng || len == 0) return 0;
     
     /* Точка разреза */
     size_t crossover_point = k_rng_next(rng) % len;
@@ -138,110 +175,286 @@ static void crossover_patterns(const uint8_t *p1, const uint8_t *p2,
     /* Копируем части */
     memcpy(offspring, p1, crossover_point);
     memcpy(offspring + crossover_point, p2 + crossover_point, len - crossover_point);
+    return crossover_point;
+}
+
+/* Порядок особей: выше fitness, при равенстве — меньший индекс */
+static inline int evolution_better(const double *fitness, uint16_t a, uint16_t b) {
+    return fitness[a] > fitness[b] || (fitness[a] == fitness[b] && a < b);
+}
+
+/**
+ * Внутренняя функция: частичный отбор (как nth_element) — после вызова
+ * order[0..k) содержит k лучших особей в произвольном порядке.
+ * Переставляются только индексы, паттерны остаются на месте.
+ */
+static void evolution_select(uint16_t *order, size_t count, size_t k, const double *fitness) {
+    size_t lo = 0;
+    size_t hi = count;
+    while (hi - lo > 1) {
+        /* Медиана трёх в качестве опорного */
+        size_t mid = lo + (hi - lo) / 2;
+        uint16_t a = order[lo], b = order[mid], c = order[hi - 1];
+        uint16_t pivot;
+        if (evolution_better(fitness, a, b)) {
+            pivot = evolution_better(fitness, b, c) ? b : (evolution_better(fitness, a, c) ? c : a);
+        } else {
+            pivot = evolution_better(fitness, a, c) ? a : (evolution_better(fitness, b, c) ? c : b);
+        }
+        
+        /* Трёхчастное разбиение: [лучше | pivot | хуже] */
+        size_t store = lo;
+        for (size_t i = lo; i < hi; i++) {
+            if (evolution_better(fitness, order[i], pivot)) {
+                uint16_t tmp = order[i];
+                order[i] = order[store];
+                order[store] = tmp;
+                store++;
+            }
+        }
+        size_t pivot_pos = store;
+        for (size_t i = store; i < hi; i++) {
+            if (order[i] == pivot) {
+                order[i] = order[pivot_pos];
+                order[pivot_pos] = pivot;
+                break;
+            }
+        }
+        
+        if (pivot_pos == k || pivot_pos + 1 == k) return;
+        if (pivot_pos > k) {
+            hi = pivot_pos;
+        } else {
+            lo = pivot_pos + 1;
+        }
+    }
+}
+
+void k_semantic_evolution_config_default(KolibriEvolutionConfig *config) {
+    if (!config) return;
+    config->population = KOLIBRI_SEMANTIC_POPULATION;
+    config->generations = 1000;
+    config->seed = (uint64_t)time(NULL);
+    config->mutation_percent = 10;
+    config->patience = 50;
+    config->min_delta = 1e-12;
 }
 
 int k_semantic_learn(const char *word,
                      const KolibriSemanticContext *ctx,
                      size_t generations,
                      KolibriSemanticPattern *pattern) {
+    return k_semantic_learn_seeded(word, ctx, generations, (uint64_t)time(NULL), pattern);
+}
+
+int k_semantic_learn_seeded(const char *word,
+                            const KolibriSemanticContext *ctx,
+                            size_t generations,
+                            uint64_t seed,
+                            KolibriSemanticPattern *pattern) {
+    KolibriEvolutionConfig config;
+    k_semantic_evolution_config_default(&config);
+    if (generations > 0) config.generations = generations; /* 0 = по умолчанию */
+    config.seed = seed;
+    return k_semantic_learn_config(word, ctx, &config, pattern, NULL);
+}
+
+int k_semantic_learn_config(const char *word,
+                            const KolibriSemanticContext *ctx,
+                            const KolibriEvolutionConfig *config,
+                            KolibriSemanticPattern *pattern,
+                            size_t *generations_run) {
     if (!word || !ctx || !pattern) return -1;
-    if (generations == 0) generations = 1000; /* По умолчанию */
+    
+    KolibriEvolutionConfig defaults;
+    if (!config) {
+        k_semantic_evolution_config_default(&defaults);
+        config = &defaults;
+    }
+    size_t population_size = config->population;
+    if (population_size < 2 || population_size > KOLIBRI_SEMANTIC_POPULATION_MAX) return -1;
+    size_t generations = config->generations > 0 ? config->generations : 1;
     
     /* Инициализируем паттерн */
     k_semantic_pattern_init(pattern);
     strncpy(pattern->word, word, sizeof(pattern->word) - 1);
     
-    /* Кодируем слово в цифры */
-    size_t word_len = strlen(word);
-    uint8_t word_buffer[1024];
-    kolibri_potok_cifr word_stream;
+    KolibriFitnessPlan plan;
+    fitness_plan_init(&plan, ctx, KOLIBRI_SEMANTIC_PATTERN_SIZE);
     
-    if (kolibri_potok_cifr_init(&word_stream, word_buffer, sizeof(word_buffer)) != 0) {
-        return -1;
-    }
-    
-    if (kolibri_transducirovat_utf8(&word_stream, (const uint8_t *)word, word_len) != 0) {
-        return -1;
-    }
-    
-    /* Инициализируем популяцию паттернов */
-    #define POPULATION_SIZE 50
-    uint8_t population[POPULATION_SIZE][KOLIBRI_SEMANTIC_PATTERN_SIZE];
-    double fitness[POPULATION_SIZE];
+    /* Популяция и кэш fitness: пересчитываются только изменённые особи */
+    uint8_t population[KOLIBRI_SEMANTIC_POPULATION_MAX][KOLIBRI_SEMANTIC_PATTERN_SIZE];
+    double fitness[KOLIBRI_SEMANTIC_POPULATION_MAX];
+    uint16_t order[KOLIBRI_SEMANTIC_POPULATION_MAX];
     
     KolibriRng rng;
-    k_rng_seed(&rng, (uint64_t)time(NULL));
+    k_rng_seed(&rng, config->seed);
     
     /* Случайная инициализация популяции */
-    for (size_t i = 0; i < POPULATION_SIZE; i++) {
+    for (size_t i = 0; i < population_size; i++) {
         for (size_t j = 0; j < KOLIBRI_SEMANTIC_PATTERN_SIZE; j++) {
             population[i][j] = (uint8_t)(k_rng_next(&rng) % 10);
         }
+        fitness[i] = compute_pattern_fitness(population[i], &plan);
+        order[i] = (uint16_t)i;
     }
     
+    size_t elite_size = population_size / 2;
+    size_t best = 0;
+    for (size_t i = 1; i < population_size; i++) {
+        if (evolution_better(fitness, (uint16_t)i, (uint16_t)best)) best = i;
+    }
+    double best_fitness = fitness[best];
+    size_t stale = 0;
+    size_t gen = 0;
+    
     /* Эволюция */
-    for (size_t gen = 0; gen < generations; gen++) {
-        /* Оцениваем fitness каждого паттерна */
-        for (size_t i = 0; i < POPULATION_SIZE; i++) {
-            fitness[i] = compute_pattern_fitness(population[i],
-                                                 KOLIBRI_SEMANTIC_PATTERN_SIZE,
-                                                 &word_stream, ctx);
-        }
+    while (gen < generations) {
+        gen++;
         
-        /* Сортируем по fitness (простая сортировка пузырьком) */
-        for (size_t i = 0; i < POPULATION_SIZE - 1; i++) {
-            for (size_t j = 0; j < POPULATION_SIZE - i - 1; j++) {
-                if (fitness[j] < fitness[j + 1]) {
-                    /* Меняем местами */
-                    double temp_fitness = fitness[j];
-                    fitness[j] = fitness[j + 1];
-                    fitness[j + 1] = temp_fitness;
-                    
-                    uint8_t temp_pattern[KOLIBRI_SEMANTIC_PATTERN_SIZE];
-                    memcpy(temp_pattern, population[j], KOLIBRI_SEMANTIC_PATTERN_SIZE);
-                    memcpy(population[j], population[j + 1], KOLIBRI_SEMANTIC_PATTERN_SIZE);
-                    memcpy(population[j + 1], temp_pattern, KOLIBRI_SEMANTIC_PATTERN_SIZE);
-                }
-            }
-        }
+        /* Отбор: верхняя половина по индексам, без сортировки паттернов */
+        evolution_select(order, population_size, elite_size, fitness);
         
-        /* Размножение: верхняя половина создаёт потомков */
-        size_t elite_size = POPULATION_SIZE / 2;
-        for (size_t i = elite_size; i < POPULATION_SIZE; i++) {
-            /* Выбираем двух родителей из элиты */
-            size_t parent1 = k_rng_next(&rng) % elite_size;
-            size_t parent2 = k_rng_next(&rng) % elite_size;
+        /* Размножение: элита создаёт потомков на месте остальных */
+        for (size_t i = elite_size; i < population_size; i++) {
+            uint16_t slot = order[i];
+            uint16_t parent1 = order[k_rng_next(&rng) % elite_size];
+            uint16_t parent2 = order[k_rng_next(&rng) % elite_size];
             
             /* Кроссовер */
-            crossover_patterns(population[parent1], population[parent2],
-                             population[i], KOLIBRI_SEMANTIC_PATTERN_SIZE, &rng);
+            size_t cut = crossover_patterns(population[parent1], population[parent2],
+                                            population[slot], KOLIBRI_SEMANTIC_PATTERN_SIZE, &rng);
+            
+            /* Мутация с заданной вероятностью */
+            int mutated = 0;
+            if ((k_rng_next(&rng) % 100) < config->mutation_percent) {
+                mutated = mutate_pattern(population[slot], KOLIBRI_SEMANTIC_PATTERN_SIZE, &rng);
+            }
             
-            /* Мутация с вероятностью 10% */
-            if ((k_rng_next(&rng) % 100) < 10) {
-                mutate_pattern(population[i], KOLIBRI_SEMANTIC_PATTERN_SIZE, &rng);
+            /* Точная копия родителя наследует его fitness */
+            if (cut == 0 && !mutated) {
+                fitness[slot] = fitness[parent2];
+            } else {
+                fitness[slot] = compute_pattern_fitness(population[slot], &plan);
             }
+            if (evolution_better(fitness, slot, (uint16_t)best)) best = slot;
+        }
+        
+        /* Сходимость: максимум достигнут или нет прироста patience поколений */
+        if (fitness[best] > best_fitness + config->min_delta) {
+            best_fitness = fitness[best];
+            stale = 0;
+        } else if (config->patience > 0 && ++stale >= config->patience) {
+            break;
         }
+        if (fitness[best] >= plan.max_fitness) break;
     }
     
     /* Лучший паттерн - это результат */
-    memcpy(pattern->pattern, population[0], KOLIBRI_SEMANTIC_PATTERN_SIZE);
-    pattern->context_weight = fitness[0];
+    memcpy(pattern->pattern, population[best], KOLIBRI_SEMANTIC_PATTERN_SIZE);
+    pattern->context_weight = fitness[best];
     pattern->usage_count = 1;
+    if (generations_run) *generations_run = gen;
     
     return 0;
 }
 
-double k_semantic_similarity(const KolibriSemanticPattern *p1,
-                            const KolibriSemanticPattern *p2) {
-    if (!p1 || !p2) return 0.0;
+size_t k_semantic_count_equal(const uint8_t *a, const uint8_t *b, size_t length) {
+    if (!a || !b) return 0;
     
-    /* Вычисляем процент совпадающих цифр */
     size_t matches = 0;
-    for (size_t i = 0; i < KOLIBRI_SEMANTIC_PATTERN_SIZE; i++) {
-        if (p1->pattern[i] == p2->pattern[i]) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 32 <= length; i += 32) {
+        __m256i va = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i *)(b + i));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb));
+        matches += count_bits64(mask);
+    }
+#endif
+#if defined(__SSE2__)
+    for (; i + 16 <= length; i += 16) {
+        __m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb));
+        matches += count_bits64(mask);
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 16 <= length; i += 16) {
+        uint8x16_t eq = vceqq_u8(vld1q_u8(a + i), vld1q_u8(b + i));
+        /* 0xFF -> 1 и горизонтальная сумма */
+        matches += vaddvq_u8(vshrq_n_u8(eq, 7));
+    }
+#endif
+    /* SWAR по 8 байт: нулевой байт XOR означает совпадение */
+    for (; i + 8 <= length; i += 8) {
+        uint64_t wa;
+        uint64_t wb;
+        memcpy(&wa, a + i, sizeof(wa));
+        memcpy(&wb, b + i, sizeof(wb));
+        uint64_t x = wa ^ wb;
+        uint64_t nonzero = ((x & 0x7F7F7F7F7F7F7F7FULL) + 0x7F7F7F7F7F7F7F7FULL) | x;
+        matches += 8U - count_bits64(nonzero & 0x8080808080808080ULL);
+    }
+    for (; i < length; i++) {
+        if (a[i] == b[i]) {
             matches++;
         }
     }
+    return matches;
+}
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) && !defined(__AVX2__)
+#define KOLIBRI_SEMANTIC_AVX2_DISPATCH 1
+
+__attribute__((target("avx2")))
+static void count_equal_batch_avx2(const uint8_t *query,
+                                   const uint8_t *patterns,
+                                   size_t count,
+                                   uint8_t *matches) {
+    __m256i q0 = _mm256_loadu_si256((const __m256i *)query);
+    __m256i q1 = _mm256_loadu_si256((const __m256i *)(query + 32));
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t *p = patterns + i * KOLIBRI_SEMANTIC_PATTERN_SIZE;
+        uint32_t m0 = (uint32_t)_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(q0, _mm256_loadu_si256((const __m256i *)p)));
+        uint32_t m1 = (uint32_t)_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(q1, _mm256_loadu_si256((const __m256i *)(p + 32))));
+        matches[i] = (uint8_t)count_bits64(((uint64_t)m1 << 32) | m0);
+    }
+}
+#endif
+
+void k_semantic_count_equal_batch(const uint8_t *query,
+                                  const uint8_t *patterns,
+                                  size_t count,
+                                  uint8_t *matches) {
+    if (!query || !patterns || !matches) return;
+    
+#if defined(KOLIBRI_SEMANTIC_AVX2_DISPATCH)
+    static int avx2_state = -1;
+    if (avx2_state < 0) {
+        avx2_state = __builtin_cpu_supports("avx2") ? 1 : 0;
+    }
+    if (avx2_state) {
+        count_equal_batch_avx2(query, patterns, count, matches);
+        return;
+    }
+#endif
+    for (size_t i = 0; i < count; i++) {
+        matches[i] = (uint8_t)k_semantic_count_equal(query,
+                                                     patterns + i * KOLIBRI_SEMANTIC_PATTERN_SIZE,
+                                                     KOLIBRI_SEMANTIC_PATTERN_SIZE);
+    }
+}
+
+double k_semantic_similarity(const KolibriSemanticPattern *p1,
+                            const KolibriSemanticPattern *p2) {
+    if (!p1 || !p2) return 0.0;
+    
+    /* Вычисляем процент совпадающих цифр */
+    size_t matches = k_semantic_count_equal(p1->pattern, p2->pattern,
+                                            KOLIBRI_SEMANTIC_PATTERN_SIZE);
     
     return (double)matches / (double)KOLIBRI_SEMANTIC_PATTERN_SIZE;
 }
@@ -252,13 +465,15 @@ int k_semantic_find_nearest(const KolibriSemanticPattern *pattern,
     if (!pattern || !candidates || count == 0) return -1;
     
     int best_idx = -1;
-    double best_similarity = -1.0;
+    size_t best_matches = 0;
     
     for (size_t i = 0; i < count; i++) {
-        double sim = k_semantic_similarity(pattern, &candidates[i]);
-        if (sim > best_similarity) {
-            best_similarity = sim;
+        size_t matches = k_semantic_count_equal(pattern->pattern, candidates[i].pattern,
+                                                KOLIBRI_SEMANTIC_PATTERN_SIZE);
+        if (best_idx < 0 || matches > best_matches) {
+            best_matches = matches;
             best_idx = (int)i;
+            if (matches == KOLIBRI_SEMANTIC_PATTERN_SIZE) break; /* Лучше не бывает */
         }
     }
     
@@ -288,20 +503,7 @@ double k_semantic_validate(const KolibriSemanticPattern *pattern,
     if (!pattern || !ctx) return 0.0;
     
     /* Пересчитываем fitness паттерна с текущим контекстом */
-    uint8_t word_buffer[1024];
-    kolibri_potok_cifr word_stream;
-    
-    if (kolibri_potok_cifr_init(&word_stream, word_buffer, sizeof(word_buffer)) != 0) {
-        return 0.0;
-    }
-    
-    /* Кодируем слово из паттерна */
-    if (kolibri_transducirovat_utf8(&word_stream, (const uint8_t *)pattern->word,
-                                    strlen(pattern->word)) != 0) {
-        return 0.0;
-    }
-    
-    return compute_pattern_fitness(pattern->pattern,
-                                   KOLIBRI_SEMANTIC_PATTERN_SIZE,
-                                   &word_stream, ctx);
+    KolibriFitnessPlan plan;
+    fitness_plan_init(&plan, ctx, KOLIBRI_SEMANTIC_PATTERN_SIZE);
+    return compute_pattern_fitness(pattern->pattern, &plan);
 }
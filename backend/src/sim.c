@@ -4,87 +4,82 @@
 #include "kolibri/random.h"
 
 #include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <unistd.h>
 
-#define KOLIBRI_SIM_LOG_CAPACITY 512
 #define KOLIBRI_SIM_POP_SIZE 24
 
 typedef struct {
-    char *tip;
-    char *soobshenie;
+    char tip[KOLIBRI_SIM_LOG_TIP_MAX];
+    char soobshenie[KOLIBRI_SIM_LOG_MESSAGE_MAX];
     double metka;
 } LogItem;
 
 struct KolibriSim {
+    pthread_mutex_t lock;
     KolibriSimConfig config;
     KolibriRng rng;
-    KolibriFormulaPool pool;
+    KolibriGenePool pool;
     LogItem logs[KOLIBRI_SIM_LOG_CAPACITY];
     size_t log_head;
     size_t log_count;
     size_t log_offset;
 };
 
-static void log_item_free(LogItem *item) {
-    free(item->tip);
-    free(item->soobshenie);
-    item->tip = NULL;
-    item->soobshenie = NULL;
-}
-
-static char *kolibri_sim_strdup(const char *text) {
-    if (!text) {
-        return NULL;
+static void log_copy(char *dst, size_t dst_len, const char *src) {
+    size_t len = src ? strlen(src) : 0U;
+    if (len >= dst_len) {
+        len = dst_len - 1U;
     }
-    size_t len = strlen(text);
-    char *copy = (char *)malloc(len + 1U);
-    if (!copy) {
-        return NULL;
+    if (len > 0U) {
+        memcpy(dst, src, len);
     }
-    memcpy(copy, text, len + 1U);
-    return copy;
+    dst[len] = '\0';
 }
 
 static void log_push(KolibriSim *sim, const char *tip, const char *message) {
     size_t index = (sim->log_head + sim->log_count) % KOLIBRI_SIM_LOG_CAPACITY;
     if (sim->log_count == KOLIBRI_SIM_LOG_CAPACITY) {
-        log_item_free(&sim->logs[sim->log_head]);
         sim->log_head = (sim->log_head + 1U) % KOLIBRI_SIM_LOG_CAPACITY;
         sim->log_offset += 1U;
         sim->log_count -= 1U;
     }
     LogItem *item = &sim->logs[index];
-    item->tip = kolibri_sim_strdup(tip);
-    item->soobshenie = kolibri_sim_strdup(message);
+    log_copy(item->tip, sizeof(item->tip), tip);
+    log_copy(item->soobshenie, sizeof(item->soobshenie), message);
     item->metka = (double)time(NULL);
     sim->log_count += 1U;
 }
 
 static void sim_reset_logs(KolibriSim *sim) {
-    for (size_t i = 0; i < sim->log_count; ++i) {
-        size_t index = (sim->log_head + i) % KOLIBRI_SIM_LOG_CAPACITY;
-        log_item_free(&sim->logs[index]);
-    }
     sim->log_head = 0U;
     sim->log_count = 0U;
     sim->log_offset = 0U;
 }
 
 static void sim_init_pool(KolibriSim *sim) {
-    kf_pool_init(&sim->pool, (uint64_t)sim->config.seed);
-    kf_pool_clear_examples(&sim->pool);
+    kf_gene_pool_init(&sim->pool, (uint64_t)sim->config.seed);
     const int inputs[] = {0, 1, 2, 3};
     const int targets[] = {1, 3, 5, 7};
     for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); ++i) {
-        kf_pool_add_example(&sim->pool, inputs[i], targets[i]);
+        kf_gene_pool_add_example(&sim->pool, inputs[i], targets[i]);
     }
 }
 
 static KolibriSim *kolibri_sim_alloc(void) {
     KolibriSim *sim = (KolibriSim *)calloc(1, sizeof(KolibriSim));
+    if (!sim) {
+        return NULL;
+    }
+    if (pthread_mutex_init(&sim->lock, NULL) != 0) {
+        free(sim);
+        return NULL;
+    }
     return sim;
 }
 
@@ -92,7 +87,7 @@ static void kolibri_sim_free(KolibriSim *sim) {
     if (!sim) {
         return;
     }
-    sim_reset_logs(sim);
+    pthread_mutex_destroy(&sim->lock);
     free(sim);
 }
 
@@ -119,27 +114,110 @@ int kolibri_sim_reset(KolibriSim *sim, const KolibriSimConfig *config) {
     if (!sim || !config) {
         return -1;
     }
+    pthread_mutex_lock(&sim->lock);
     sim_reset_logs(sim);
     sim->config = *config;
     k_rng_seed(&sim->rng, (uint64_t)config->seed);
     sim_init_pool(sim);
     log_push(sim, "reset", "KolibriSim reset");
+    pthread_mutex_unlock(&sim->lock);
     return 0;
 }
 
+static void sim_tick_locked(KolibriSim *sim) {
+    kf_gene_pool_tick(&sim->pool, KOLIBRI_SIM_POP_SIZE);
+    const KolibriGeneSlot *best = kf_gene_pool_best(&sim->pool);
+    if (!best) {
+        log_push(sim, "pool", "empty");
+        return;
+    }
+    char description[KOLIBRI_SIM_LOG_MESSAGE_MAX];
+    if (kf_gene_describe(&best->gene, best->fitness, description, sizeof(description)) == 0) {
+        log_push(sim, "best", description);
+    }
+}
+
 int kolibri_sim_tick(KolibriSim *sim) {
     if (!sim) {
         return -1;
     }
-    kf_pool_tick(&sim->pool, KOLIBRI_SIM_POP_SIZE);
-    const KolibriFormula *best = kf_pool_best(&sim->pool);
-    if (!best) {
-        log_push(sim, "pool", "empty");
+    pthread_mutex_lock(&sim->lock);
+    sim_tick_locked(sim);
+    pthread_mutex_unlock(&sim->lock);
+    return 0;
+}
+
+/* ---------------------- Пакетный шаг экземпляров ---------------------- */
+
+typedef struct {
+    KolibriSim *const *sims;
+    size_t count;
+    size_t steps;
+    atomic_size_t next;
+} SimBatch;
+
+static void *sim_batch_worker(void *raw) {
+    SimBatch *batch = (SimBatch *)raw;
+    for (;;) {
+        size_t i = atomic_fetch_add_explicit(&batch->next, 1, memory_order_relaxed);
+        if (i >= batch->count) {
+            break;
+        }
+        KolibriSim *sim = batch->sims[i];
+        pthread_mutex_lock(&sim->lock);
+        for (size_t s = 0; s < batch->steps; ++s) {
+            sim_tick_locked(sim);
+        }
+        pthread_mutex_unlock(&sim->lock);
+    }
+    return NULL;
+}
+
+int kolibri_sim_tick_many(KolibriSim *const *sims,
+                          size_t count,
+                          size_t steps,
+                          size_t threads) {
+    if (!sims && count > 0U) {
+        return -1;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (!sims[i]) {
+            return -1;
+        }
+    }
+    if (count == 0U || steps == 0U) {
         return 0;
     }
-    char description[128];
-    if (kf_formula_describe(best, description, sizeof(description)) == 0) {
-        log_push(sim, "best", description);
+
+    if (threads == 0U) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = online > 0 ? (size_t)online : 1U;
+    }
+    if (threads > KOLIBRI_SIM_MAX_THREADS) {
+        threads = KOLIBRI_SIM_MAX_THREADS;
+    }
+    if (threads > count) {
+        threads = count;
+    }
+
+    SimBatch batch;
+    batch.sims = sims;
+    batch.count = count;
+    batch.steps = steps;
+    atomic_init(&batch.next, 0);
+
+    /* Вызывающий поток работает наравне с остальными */
+    pthread_t workers[KOLIBRI_SIM_MAX_THREADS];
+    size_t started = 0;
+    for (size_t i = 1; i < threads; ++i) {
+        if (pthread_create(&workers[started], NULL, sim_batch_worker, &batch) != 0) {
+            break;
+        }
+        started++;
+    }
+    sim_batch_worker(&batch);
+    for (size_t i = 0; i < started; ++i) {
+        pthread_join(workers[i], NULL);
     }
     return 0;
 }
@@ -152,6 +230,7 @@ int kolibri_sim_get_logs(KolibriSim *sim,
     if (!sim || !buffer || !out_count || !out_offset) {
         return -1;
     }
+    pthread_mutex_lock(&sim->lock);
     size_t count = sim->log_count < capacity ? sim->log_count : capacity;
     for (size_t i = 0; i < count; ++i) {
         size_t index = (sim->log_head + i) % KOLIBRI_SIM_LOG_CAPACITY;
@@ -161,6 +240,7 @@ int kolibri_sim_get_logs(KolibriSim *sim,
     }
     *out_count = count;
     *out_offset = sim->log_offset;
+    pthread_mutex_unlock(&sim->lock);
     return 0;
 }
 
@@ -171,18 +251,19 @@ int kolibri_sim_get_formulas(KolibriSim *sim,
     if (!sim || !buffer || !out_count) {
         return -1;
     }
+    pthread_mutex_lock(&sim->lock);
     size_t count = sim->pool.count;
     if (count > capacity) {
         count = capacity;
     }
     for (size_t i = 0; i < count; ++i) {
-        KolibriFormula *formula = &sim->pool.formulas[i];
-        buffer[i].fitness = formula->fitness;
+        buffer[i].fitness = sim->pool.slots[i].fitness;
         buffer[i].context = NULL;
         buffer[i].parents = NULL;
         buffer[i].kod = NULL;
     }
     *out_count = count;
+    pthread_mutex_unlock(&sim->lock);
     return 0;
 }
 
@@ -4,33 +4,68 @@
 #include <stdlib.h>
 #include <string.h>
 
-static void kolibri_symbol_table_next_digits(KolibriSymbolTable *table,
-                                             uint8_t out_digits[KOLIBRI_SYMBOL_DIGITS]);
+static int kolibri_symbol_table_next_digits(const KolibriSymbolTable *table,
+                                            uint8_t out_digits[KOLIBRI_SYMBOL_DIGITS]);
+
+static size_t symbol_code(const uint8_t digits[KOLIBRI_SYMBOL_DIGITS]) {
+    return (size_t)digits[0] * 100U + (size_t)digits[1] * 10U + (size_t)digits[2];
+}
+
+static int symbol_digits_valid(const uint8_t digits[KOLIBRI_SYMBOL_DIGITS]) {
+    return digits[0] <= 9U && digits[1] <= 9U && digits[2] <= 9U;
+}
+
+/* Возвращает индекс записи + 1 или 0, если codepoint не отображён. */
+static inline size_t kolibri_symbol_table_lookup(const KolibriSymbolTable *table,
+                                                 uint32_t codepoint) {
+    if (codepoint >= KOLIBRI_SYMBOL_CODEPOINT_LIMIT) {
+        return 0U;
+    }
+    uint8_t page = table->page_index[codepoint >> KOLIBRI_SYMBOL_PAGE_BITS];
+    if (page != 0U) {
+        uint16_t slot = table->pages[page - 1U][codepoint & (KOLIBRI_SYMBOL_PAGE_SIZE - 1U)];
+        if (slot != 0U) {
+            return slot;
+        }
+    }
+    /* Записи без страницы; список пуст, пока пул не исчерпан */
+    for (size_t i = 0; i < table->overflow_count; ++i) {
+        if (table->entries[table->overflow[i]].codepoint == codepoint) {
+            return (size_t)table->overflow[i] + 1U;
+        }
+    }
+    return 0U;
+}
 
 static int kolibri_symbol_table_find(const KolibriSymbolTable *table,
                                      uint32_t codepoint) {
     if (!table) {
         return -1;
     }
-    for (size_t i = 0; i < table->count; ++i) {
-        if (table->entries[i].codepoint == codepoint) {
-            return (int)i;
-        }
-    }
-    return -1;
+    return (int)kolibri_symbol_table_lookup(table, codepoint) - 1;
 }
 
 static int kolibri_symbol_table_find_digits(const KolibriSymbolTable *table,
                                             const uint8_t digits[KOLIBRI_SYMBOL_DIGITS]) {
-    if (!table || !digits) {
+    if (!table || !digits || !symbol_digits_valid(digits)) {
         return -1;
     }
-    for (size_t i = 0; i < table->count; ++i) {
-        if (memcmp(table->entries[i].digits, digits, KOLIBRI_SYMBOL_DIGITS) == 0) {
-            return (int)i;
+    return (int)table->by_code[symbol_code(digits)] - 1;
+}
+
+static uint16_t *kolibri_symbol_table_slot(KolibriSymbolTable *table, uint32_t codepoint) {
+    if (codepoint >= KOLIBRI_SYMBOL_CODEPOINT_LIMIT) {
+        return NULL;
+    }
+    size_t page_id = codepoint >> KOLIBRI_SYMBOL_PAGE_BITS;
+    if (table->page_index[page_id] == 0U) {
+        if (table->page_count >= KOLIBRI_SYMBOL_PAGE_POOL) {
+            return NULL;
         }
+        memset(table->pages[table->page_count], 0, sizeof(table->pages[0]));
+        table->page_index[page_id] = (uint8_t)(++table->page_count);
     }
-    return -1;
+    return &table->pages[table->page_index[page_id] - 1U][codepoint & (KOLIBRI_SYMBOL_PAGE_SIZE - 1U)];
 }
 
 static uint64_t decode_u64_be_symbol(const unsigned char *data) {
@@ -51,41 +86,121 @@ static void symbol_deserialize(const unsigned char *bytes, ReasonBlock *block) {
     memcpy(block->payload, bytes + 16 + KOLIBRI_HASH_SIZE * 2 + KOLIBRI_EVENT_TYPE_SIZE, KOLIBRI_PAYLOAD_SIZE);
 }
 
-static void kolibri_symbol_table_log_add(KolibriSymbolTable *table,
-                                         uint32_t codepoint,
-                                         const uint8_t digits[KOLIBRI_SYMBOL_DIGITS]) {
-    if (!table || !table->genome) {
-        return;
+int kolibri_symbol_table_flush(KolibriSymbolTable *table) {
+    if (!table) {
+        return -1;
+    }
+    if (table->pending_count == 0U) {
+        return 0;
+    }
+    if (!table->genome || !table->genome->file) {
+        table->pending_count = 0U;
+        return 0;
     }
+    /* payload только из цифр: 7 цифр codepoint + 3 цифры кода на запись */
     char payload[KOLIBRI_PAYLOAD_SIZE];
-    memset(payload, 0, sizeof(payload));
-    int written = snprintf(payload,
-                           sizeof(payload),
-                           "%06u|%u%u%u",
-                           (unsigned int)codepoint,
-                           digits[0],
-                           digits[1],
-                           digits[2]);
-    if (written <= 0 || (size_t)written >= sizeof(payload)) {
-        return;
+    size_t offset = 0U;
+    for (size_t i = 0; i < table->pending_count; ++i) {
+        const KolibriSymbolEntry *entry = &table->entries[table->pending[i]];
+        int written = snprintf(payload + offset,
+                               sizeof(payload) - offset,
+                               "%07u%u%u%u",
+                               (unsigned int)entry->codepoint,
+                               entry->digits[0],
+                               entry->digits[1],
+                               entry->digits[2]);
+        if (written != KOLIBRI_SYMBOL_BATCH_RECORD) {
+            table->pending_count = 0U;
+            return -1;
+        }
+        offset += (size_t)written;
+    }
+    /* При ошибке записи блок остаётся в очереди до следующего flush */
+    if (kg_append(table->genome, "SYMBOL_BATCH", payload, NULL) != 0) {
+        return -1;
     }
-    kg_append(table->genome, "SYMBOL_MAP", payload, NULL);
+    table->pending_count = 0U;
+    return 0;
 }
 
-static void kolibri_symbol_table_add_entry(KolibriSymbolTable *table,
-                                           uint32_t codepoint,
-                                           const uint8_t digits[KOLIBRI_SYMBOL_DIGITS],
-                                           int log_event) {
-    if (!table || table->count >= KOLIBRI_SYMBOL_MAX) {
+void kolibri_symbol_table_rollback(KolibriSymbolTable *table, size_t count, size_t page_count) {
+    if (!table || count >= table->count) {
         return;
     }
-    KolibriSymbolEntry *entry = &table->entries[table->count++];
+    while (table->count > count) {
+        size_t index = --table->count;
+        const KolibriSymbolEntry *entry = &table->entries[index];
+        size_t page_id = entry->codepoint >> KOLIBRI_SYMBOL_PAGE_BITS;
+        uint8_t page = table->page_index[page_id];
+        if (page != 0U) {
+            table->pages[page - 1U][entry->codepoint & (KOLIBRI_SYMBOL_PAGE_SIZE - 1U)] = 0U;
+            if (page > page_count) {
+                table->page_index[page_id] = 0U;
+            }
+        }
+        size_t code = symbol_code(entry->digits);
+        if (table->by_code[code] == (uint16_t)(index + 1U)) {
+            table->by_code[code] = 0U;
+        }
+    }
+    /* overflow заполняется по возрастанию индексов */
+    while (table->overflow_count > 0U && table->overflow[table->overflow_count - 1U] >= count) {
+        table->overflow_count--;
+    }
+    if (table->page_count > page_count) {
+        table->page_count = page_count;
+    }
+    size_t kept = 0U;
+    for (size_t i = 0; i < table->pending_count; ++i) {
+        if (table->pending[i] < count) {
+            table->pending[kept++] = table->pending[i];
+        }
+    }
+    table->pending_count = kept;
+    table->version += 1U;
+}
+
+static int kolibri_symbol_table_add_entry(KolibriSymbolTable *table,
+                                          uint32_t codepoint,
+                                          const uint8_t digits[KOLIBRI_SYMBOL_DIGITS],
+                                          int log_event) {
+    if (!table || table->count >= KOLIBRI_SYMBOL_MAX || !symbol_digits_valid(digits) ||
+        codepoint >= KOLIBRI_SYMBOL_CODEPOINT_LIMIT) {
+        return -1;
+    }
+    /* Полную очередь сбрасываем до вставки: запись без места в очереди
+     * не попала бы в геном */
+    if (log_event && table->genome && table->pending_count >= KOLIBRI_SYMBOL_BATCH_MAX &&
+        kolibri_symbol_table_flush(table) != 0) {
+        return -1;
+    }
+    uint16_t *slot = kolibri_symbol_table_slot(table, codepoint);
+    size_t index = table->count++;
+    KolibriSymbolEntry *entry = &table->entries[index];
     entry->codepoint = codepoint;
     memcpy(entry->digits, digits, KOLIBRI_SYMBOL_DIGITS);
+    if (slot) {
+        *slot = (uint16_t)(index + 1U);
+    } else {
+        table->overflow[table->overflow_count++] = (uint16_t)index;
+    }
+    size_t code = symbol_code(digits);
+    if (table->by_code[code] == 0U) {
+        table->by_code[code] = (uint16_t)(index + 1U);
+    }
     table->version += 1U;
-    if (log_event) {
-        kolibri_symbol_table_log_add(table, codepoint, digits);
+    if (log_event && table->genome) {
+        table->pending[table->pending_count++] = (uint16_t)index;
+    }
+    return (int)index;
+}
+
+static int kolibri_symbol_table_insert(KolibriSymbolTable *table, uint32_t codepoint) {
+    uint8_t digits[KOLIBRI_SYMBOL_DIGITS];
+    if (kolibri_symbol_table_next_digits(table, digits) != 0) {
+        return -1;
     }
+    return kolibri_symbol_table_add_entry(table, codepoint, digits, 1);
 }
 
 static void kolibri_symbol_table_seed_entry(KolibriSymbolTable *table, uint32_t codepoint) {
@@ -95,9 +210,7 @@ static void kolibri_symbol_table_seed_entry(KolibriSymbolTable *table, uint32_t
     if (kolibri_symbol_table_find(table, codepoint) >= 0) {
         return;
     }
-    uint8_t digits[KOLIBRI_SYMBOL_DIGITS];
-    kolibri_symbol_table_next_digits(table, digits);
-    kolibri_symbol_table_add_entry(table, codepoint, digits, 1);
+    kolibri_symbol_table_insert(table, codepoint);
 }
 
 void kolibri_symbol_table_init(KolibriSymbolTable *table, KolibriGenome *genome) {
@@ -108,6 +221,76 @@ void kolibri_symbol_table_init(KolibriSymbolTable *table, KolibriGenome *genome)
     table->genome = genome;
 }
 
+static int parse_symbol_digits(const char *text, size_t count, unsigned long *out_value) {
+    unsigned long value = 0UL;
+    for (size_t i = 0; i < count; ++i) {
+        if (text[i] < '0' || text[i] > '9') {
+            return -1;
+        }
+        value = value * 10UL + (unsigned long)(text[i] - '0');
+    }
+    *out_value = value;
+    return 0;
+}
+
+static void kolibri_symbol_table_load_record(KolibriSymbolTable *table,
+                                             unsigned long codepoint,
+                                             const char *digits_str) {
+    if (codepoint >= KOLIBRI_SYMBOL_CODEPOINT_LIMIT) {
+        return;
+    }
+    if (digits_str[0] < '0' || digits_str[0] > '9' ||
+        digits_str[1] < '0' || digits_str[1] > '9' ||
+        digits_str[2] < '0' || digits_str[2] > '9') {
+        return;
+    }
+    if (kolibri_symbol_table_find(table, (uint32_t)codepoint) >= 0) {
+        return;
+    }
+    uint8_t digits[KOLIBRI_SYMBOL_DIGITS] = {
+        (uint8_t)(digits_str[0] - '0'),
+        (uint8_t)(digits_str[1] - '0'),
+        (uint8_t)(digits_str[2] - '0')
+    };
+    kolibri_symbol_table_add_entry(table, (uint32_t)codepoint, digits, 0);
+}
+
+static void kolibri_symbol_table_load_batch(KolibriSymbolTable *table, const char *payload) {
+    size_t length = strlen(payload);
+    for (size_t offset = 0; offset + KOLIBRI_SYMBOL_BATCH_RECORD <= length;
+         offset += KOLIBRI_SYMBOL_BATCH_RECORD) {
+        unsigned long codepoint = 0UL;
+        if (parse_symbol_digits(payload + offset, 7U, &codepoint) != 0) {
+            return;
+        }
+        kolibri_symbol_table_load_record(table, codepoint, payload + offset + 7U);
+    }
+}
+
+static void kolibri_symbol_table_load_single(KolibriSymbolTable *table, const char *payload) {
+    const char *separator = strchr(payload, '|');
+    if (separator) {
+        size_t cp_len = (size_t)(separator - payload);
+        if (cp_len == 0U || cp_len >= 16U) {
+            return;
+        }
+        unsigned long value = 0UL;
+        if (parse_symbol_digits(payload, cp_len, &value) != 0) {
+            return;
+        }
+        if (strlen(separator + 1) < 3U) {
+            return;
+        }
+        kolibri_symbol_table_load_record(table, value, separator + 1);
+        return;
+    }
+    unsigned long ascii = 0UL;
+    if (strlen(payload) < 6U || parse_symbol_digits(payload, 3U, &ascii) != 0) {
+        return;
+    }
+    kolibri_symbol_table_load_record(table, ascii, payload + 3U);
+}
+
 void kolibri_symbol_table_load(KolibriSymbolTable *table) {
     if (!table || !table->genome || !table->genome->file) {
         return;
@@ -124,55 +307,18 @@ void kolibri_symbol_table_load(KolibriSymbolTable *table) {
     while (fread(bytes, 1, KOLIBRI_BLOCK_SIZE, ctx->file) == KOLIBRI_BLOCK_SIZE) {
         ReasonBlock block;
         symbol_deserialize(bytes, &block);
-        if (strncmp(block.event_type, "SYMBOL_MAP", KOLIBRI_EVENT_TYPE_SIZE) != 0) {
+        int batch = strncmp(block.event_type, "SYMBOL_BATCH", KOLIBRI_EVENT_TYPE_SIZE) == 0;
+        if (!batch && strncmp(block.event_type, "SYMBOL_MAP", KOLIBRI_EVENT_TYPE_SIZE) != 0) {
             continue;
         }
         char payload[KOLIBRI_PAYLOAD_SIZE + 1];
         memcpy(payload, block.payload, KOLIBRI_PAYLOAD_SIZE);
         payload[KOLIBRI_PAYLOAD_SIZE] = '\0';
-        unsigned int d0 = 0U;
-        unsigned int d1 = 0U;
-        unsigned int d2 = 0U;
-        uint32_t codepoint = 0U;
-        const char *separator = strchr(payload, '|');
-        if (separator) {
-            size_t cp_len = (size_t)(separator - payload);
-            if (cp_len == 0U || cp_len >= 16U) {
-                continue;
-            }
-            char buffer[16];
-            memcpy(buffer, payload, cp_len);
-            buffer[cp_len] = '\0';
-            char *endptr = NULL;
-            unsigned long value = strtoul(buffer, &endptr, 10);
-            if (!endptr || *endptr != '\0' || value > 0x10FFFFUL) {
-                continue;
-            }
-            if (strlen(separator + 1) < 3U) {
-                continue;
-            }
-            const char *digits_str = separator + 1;
-            if (digits_str[0] < '0' || digits_str[0] > '9' ||
-                digits_str[1] < '0' || digits_str[1] > '9' ||
-                digits_str[2] < '0' || digits_str[2] > '9') {
-                continue;
-            }
-            d0 = (unsigned int)(digits_str[0] - '0');
-            d1 = (unsigned int)(digits_str[1] - '0');
-            d2 = (unsigned int)(digits_str[2] - '0');
-            codepoint = (uint32_t)value;
+        if (batch) {
+            kolibri_symbol_table_load_batch(table, payload);
         } else {
-            unsigned int ascii = 0U;
-            if (sscanf(payload, "%03u%1u%1u%1u", &ascii, &d0, &d1, &d2) != 4) {
-                continue;
-            }
-            codepoint = (uint32_t)ascii;
-        }
-        uint8_t digits[KOLIBRI_SYMBOL_DIGITS] = { (uint8_t)d0, (uint8_t)d1, (uint8_t)d2 };
-        if (kolibri_symbol_table_find(table, codepoint) >= 0) {
-            continue;
+            kolibri_symbol_table_load_single(table, payload);
         }
-        kolibri_symbol_table_add_entry(table, codepoint, digits, 0);
     }
     fseek(ctx->file, original_pos, SEEK_SET);
 }
@@ -208,15 +354,23 @@ void kolibri_symbol_table_seed_defaults(KolibriSymbolTable *table) {
     for (uint32_t letter = 0x0436; letter <= 0x044F; ++letter) {
         kolibri_symbol_table_seed_entry(table, letter);
     }
+    kolibri_symbol_table_flush(table);
 }
 
-static void kolibri_symbol_table_next_digits(KolibriSymbolTable *table,
-                                             uint8_t out_digits[KOLIBRI_SYMBOL_DIGITS]) {
-    size_t index = table->count;
-    /* простое последовательное распределение */
-    out_digits[0] = (uint8_t)((index / 100U) % 10U);
-    out_digits[1] = (uint8_t)((index / 10U) % 10U);
-    out_digits[2] = (uint8_t)(index % 10U);
+static int kolibri_symbol_table_next_digits(const KolibriSymbolTable *table,
+                                            uint8_t out_digits[KOLIBRI_SYMBOL_DIGITS]) {
+    /* простое последовательное распределение, занятые коды пропускаются */
+    for (size_t probe = 0; probe < KOLIBRI_SYMBOL_MAX; ++probe) {
+        size_t index = (table->count + probe) % KOLIBRI_SYMBOL_MAX;
+        if (table->by_code[index] != 0U) {
+            continue;
+        }
+        out_digits[0] = (uint8_t)((index / 100U) % 10U);
+        out_digits[1] = (uint8_t)((index / 10U) % 10U);
+        out_digits[2] = (uint8_t)(index % 10U);
+        return 0;
+    }
+    return -1;
 }
 
 int kolibri_symbol_encode(KolibriSymbolTable *table,
@@ -226,14 +380,13 @@ int kolibri_symbol_encode(KolibriSymbolTable *table,
         return -1;
     }
     int index = kolibri_symbol_table_find(table, codepoint);
-    if (index >= 0) {
-        memcpy(out_digits, table->entries[index].digits, KOLIBRI_SYMBOL_DIGITS);
-        return 0;
+    if (index < 0) {
+        index = kolibri_symbol_table_insert(table, codepoint);
+        if (index < 0) {
+            return -1;
+        }
     }
-    uint8_t digits[KOLIBRI_SYMBOL_DIGITS];
-    kolibri_symbol_table_next_digits(table, digits);
-    kolibri_symbol_table_add_entry(table, codepoint, digits, 1);
-    memcpy(out_digits, digits, KOLIBRI_SYMBOL_DIGITS);
+    memcpy(out_digits, table->entries[index].digits, KOLIBRI_SYMBOL_DIGITS);
     return 0;
 }
 
@@ -250,3 +403,116 @@ int kolibri_symbol_decode(const KolibriSymbolTable *table,
     *out_codepoint = table->entries[index].codepoint;
     return 0;
 }
+
+static int utf8_is_continuation(unsigned char byte) {
+    return (byte & 0xC0U) == 0x80U;
+}
+
+static size_t kolibri_utf8_decode_next(const unsigned char *text,
+                                       size_t length,
+                                       size_t offset,
+                                       uint32_t *out_codepoint) {
+    if (!text || !out_codepoint || offset >= length) {
+        return 0U;
+    }
+    unsigned char lead = text[offset];
+    if (lead < 0x80U) {
+        *out_codepoint = (uint32_t)lead;
+        return 1U;
+    }
+    if ((lead & 0xE0U) == 0xC0U) {
+        if (offset + 1U >= length) {
+            return 0U;
+        }
+        unsigned char b1 = text[offset + 1U];
+        if (!utf8_is_continuation(b1)) {
+            return 0U;
+        }
+        uint32_t codepoint = ((uint32_t)(lead & 0x1FU) << 6) | (uint32_t)(b1 & 0x3FU);
+        if (codepoint < 0x80U) {
+            return 0U;
+        }
+        *out_codepoint = codepoint;
+        return 2U;
+    }
+    if ((lead & 0xF0U) == 0xE0U) {
+        if (offset + 2U >= length) {
+            return 0U;
+        }
+        unsigned char b1 = text[offset + 1U];
+        unsigned char b2 = text[offset + 2U];
+        if (!utf8_is_continuation(b1) || !utf8_is_continuation(b2)) {
+            return 0U;
+        }
+        uint32_t codepoint = ((uint32_t)(lead & 0x0FU) << 12) |
+                             ((uint32_t)(b1 & 0x3FU) << 6) |
+                             (uint32_t)(b2 & 0x3FU);
+        if (codepoint < 0x800U || (codepoint >= 0xD800U && codepoint <= 0xDFFFU)) {
+            return 0U;
+        }
+        *out_codepoint = codepoint;
+        return 3U;
+    }
+    if ((lead & 0xF8U) == 0xF0U) {
+        if (offset + 3U >= length) {
+            return 0U;
+        }
+        unsigned char b1 = text[offset + 1U];
+        unsigned char b2 = text[offset + 2U];
+        unsigned char b3 = text[offset + 3U];
+        if (!utf8_is_continuation(b1) || !utf8_is_continuation(b2) || !utf8_is_continuation(b3)) {
+            return 0U;
+        }
+        uint32_t codepoint = ((uint32_t)(lead & 0x07U) << 18) |
+                             ((uint32_t)(b1 & 0x3FU) << 12) |
+                             ((uint32_t)(b2 & 0x3FU) << 6) |
+                             (uint32_t)(b3 & 0x3FU);
+        if (codepoint < 0x10000U || codepoint > 0x10FFFFU) {
+            return 0U;
+        }
+        *out_codepoint = codepoint;
+        return 4U;
+    }
+    return 0U;
+}
+
+int kolibri_symbol_encode_utf8(KolibriSymbolTable *table,
+                               const char *utf8,
+                               size_t length,
+                               uint8_t *out,
+                               size_t out_capacity,
+                               size_t *out_length) {
+    if (out_length) {
+        *out_length = 0U;
+    }
+    if (!table || !utf8 || !out || !out_length) {
+        return -1;
+    }
+    const unsigned char *bytes = (const unsigned char *)utf8;
+    size_t pos = 0U;
+    size_t written = 0U;
+    while (pos < length && written + KOLIBRI_SYMBOL_DIGITS <= out_capacity) {
+        uint32_t codepoint = 0U;
+        size_t consumed = 1U;
+        if (bytes[pos] < 0x80U) {
+            codepoint = (uint32_t)bytes[pos];
+        } else {
+            consumed = kolibri_utf8_decode_next(bytes, length, pos, &codepoint);
+            if (consumed == 0U) {
+                codepoint = (uint32_t)bytes[pos];
+                consumed = 1U;
+            }
+        }
+        size_t slot = kolibri_symbol_table_lookup(table, codepoint);
+        if (slot != 0U) {
+            memcpy(&out[written], table->entries[slot - 1U].digits, KOLIBRI_SYMBOL_DIGITS);
+        } else if (kolibri_symbol_encode(table, codepoint, &out[written]) != 0) {
+            *out_length = written;
+            return -1;
+        }
+        written += KOLIBRI_SYMBOL_DIGITS;
+        pos += consumed;
+    }
+    *out_length = written;
+    return 0;
+}
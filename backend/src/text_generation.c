@@ -10,6 +10,9 @@
 #include <string.h>
 #include <time.h>
 
+/* Seed выборки по умолчанию: генерация воспроизводима без k_gen_set_seed */
+#define GEN_DEFAULT_SEED 0x4B4F4C4942524931ULL
+
 int k_gen_init(KolibriGenerationContext *ctx,
                KolibriCorpusContext *corpus,
                KolibriGenerationStrategy strategy) {
@@ -21,6 +24,7 @@ int k_gen_init(KolibriGenerationContext *ctx,
     ctx->temperature = 1.0;
     ctx->beam_size = KOLIBRI_BEAM_SIZE;
     ctx->max_length = KOLIBRI_MAX_GENERATION_LENGTH;
+    ctx->rng_state = GEN_DEFAULT_SEED;
     
     ctx->formula_pool = calloc(1, sizeof(KolibriFormulaPool));
     if (!ctx->formula_pool) return -1;
@@ -39,6 +43,13 @@ int k_gen_init(KolibriGenerationContext *ctx,
         return -1;
     }
     
+    if (k_pattern_dict_init(&ctx->patterns, 0) != 0) {
+        k_context_window_free(ctx->context);
+        free(ctx->context);
+        free(ctx->formula_pool);
+        return -1;
+    }
+    
     return 0;
 }
 
@@ -49,6 +60,108 @@ void k_gen_free(KolibriGenerationContext *ctx) {
         free(ctx->context);
     }
     if (ctx->formula_pool) free(ctx->formula_pool);
+    if (ctx->owns_model) k_ngram_free(ctx->model);
+    ctx->model = NULL;
+    ctx->owns_model = 0;
+    k_pattern_dict_free(&ctx->patterns);
+    free(ctx->assoc_index);
+    ctx->assoc_index = NULL;
+    ctx->assoc_index_slots = 0;
+    ctx->assoc_indexed = 0;
+}
+
+/* ---------- Индекс ассоциаций пула ---------- */
+
+static size_t assoc_slot(int hash, size_t mask) {
+    uint32_t h = (uint32_t)hash * 0x9E3779B1u;
+    return (h ^ (h >> 15)) & mask;
+}
+
+/* Дописать в индекс ассоциации, добавленные после последнего поиска.
+ * Индекс строится заново, если пул стал короче проиндексированного или слот
+ * указывает за его конец. Замену input_hash на месте индекс не замечает */
+static int assoc_index_sync(KolibriGenerationContext *ctx) {
+    const KolibriFormulaPool *pool = ctx->formula_pool;
+    size_t count = pool->association_count;
+    if (ctx->assoc_indexed > count) ctx->assoc_indexed = 0;
+    if (ctx->assoc_indexed == count && ctx->assoc_index) return 0;
+
+    size_t slots = ctx->assoc_index_slots ? ctx->assoc_index_slots : 256;
+    while (slots < count * 2) slots *= 2;
+    if (slots != ctx->assoc_index_slots || ctx->assoc_indexed == 0) {
+        uint32_t *index = (uint32_t *)calloc(slots, sizeof(uint32_t));
+        if (!index) return -1;
+        free(ctx->assoc_index);
+        ctx->assoc_index = index;
+        ctx->assoc_index_slots = slots;
+        ctx->assoc_indexed = 0;
+    }
+
+    size_t mask = ctx->assoc_index_slots - 1;
+    for (size_t i = ctx->assoc_indexed; i < count; i++) {
+        int hash = pool->associations[i].input_hash;
+        size_t slot = assoc_slot(hash, mask);
+        int seen = 0;
+        while (ctx->assoc_index[slot]) {
+            if (pool->associations[ctx->assoc_index[slot] - 1].input_hash == hash) {
+                seen = 1;  /* Как при линейном поиске, побеждает первая */
+                break;
+            }
+            slot = (slot + 1) & mask;
+        }
+        if (!seen) ctx->assoc_index[slot] = (uint32_t)i + 1;
+    }
+    ctx->assoc_indexed = count;
+    return 0;
+}
+
+static void assoc_index_reset(KolibriGenerationContext *ctx) {
+    ctx->assoc_indexed = 0;
+}
+
+/* Номер ассоциации пула с данным input_hash или -1 */
+static long assoc_find(KolibriGenerationContext *ctx, int hash) {
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (assoc_index_sync(ctx) != 0) break;
+        const KolibriFormulaPool *pool = ctx->formula_pool;
+        size_t mask = ctx->assoc_index_slots - 1;
+        size_t slot = assoc_slot(hash, mask);
+        int stale = 0;
+        while (ctx->assoc_index[slot]) {
+            size_t i = ctx->assoc_index[slot] - 1;
+            if (i >= pool->association_count) {
+                stale = 1;
+                break;
+            }
+            if (pool->associations[i].input_hash == hash) return (long)i;
+            slot = (slot + 1) & mask;
+        }
+        if (!stale) return -1;
+        assoc_index_reset(ctx);
+    }
+
+    /* Индекс недоступен - линейный поиск */
+    for (size_t i = 0; i < ctx->formula_pool->association_count; i++) {
+        if (ctx->formula_pool->associations[i].input_hash == hash) return (long)i;
+    }
+    return -1;
+}
+
+/* Заполнить ассоциацию на месте: сбрасываются только заголовочные поля,
+ * как в association_reset пула */
+static void gen_write_association(KolibriAssociation *assoc, int hash, const char *question,
+                                  const char *answer, size_t answer_len, const char *source,
+                                  uint64_t timestamp) {
+    assoc->input_hash = hash;
+    assoc->output_hash = hash; /* Для простоты используем тот же хеш */
+    snprintf(assoc->question, sizeof(assoc->question), "%s", question);
+    if (answer_len >= sizeof(assoc->answer)) answer_len = sizeof(assoc->answer) - 1;
+    memcpy(assoc->answer, answer, answer_len);
+    assoc->answer[answer_len] = '\0';
+    assoc->question_digits_length = 0;
+    assoc->answer_digits_length = 0;
+    assoc->timestamp = timestamp;
+    snprintf(assoc->source, sizeof(assoc->source), "%s", source);
 }
 
 /**
@@ -89,28 +202,11 @@ double k_gen_compress_text(KolibriGenerationContext *ctx,
     char question[32];
     snprintf(question, sizeof(question), "%d", text_hash);
     
-    /* Создаём ассоциацию напрямую (БЕЗ examples) */
-    KolibriAssociation assoc;
-    memset(&assoc, 0, sizeof(assoc));
-    assoc.input_hash = text_hash;
-    assoc.output_hash = text_hash;
-    strncpy(assoc.question, question, sizeof(assoc.question) - 1);
-    strncpy(assoc.answer, text, sizeof(assoc.answer) - 1);
-    strncpy(assoc.source, "text_compress", sizeof(assoc.source) - 1);
-    assoc.timestamp = (uint64_t)time(NULL);
-    
-    /* Проверяем дубликаты */
-    int found = 0;
-    for (size_t i = 0; i < ctx->formula_pool->association_count; i++) {
-        if (ctx->formula_pool->associations[i].input_hash == text_hash) {
-            found = 1;
-            break;
-        }
-    }
-    
-    /* Добавляем если уникальный */
-    if (!found && ctx->formula_pool->association_count < KOLIBRI_POOL_MAX_ASSOCIATIONS) {
-        ctx->formula_pool->associations[ctx->formula_pool->association_count++] = assoc;
+    /* Проверяем дубликаты через индекс и добавляем если уникальный */
+    KolibriFormulaPool *pool = ctx->formula_pool;
+    if (assoc_find(ctx, text_hash) < 0 && pool->association_count < KOLIBRI_POOL_MAX_ASSOCIATIONS) {
+        gen_write_association(&pool->associations[pool->association_count++], text_hash,
+                              question, text, text_len, "text_compress", (uint64_t)time(NULL));
     }
     
     return (double)ctx->formula_pool->association_count;
@@ -124,82 +220,101 @@ double k_gen_compress_text(KolibriGenerationContext *ctx,
  * 
  * Это НАСТОЯЩЕЕ изобретение: 64 байта сжимаются до 4 байт = 16x минимум!
  * С эволюцией формул можно достичь 100x-1000x через оптимальные хеши!
+ * 
+ * Паттерн сначала попадает в упакованный словарь (O(1), 40 байт);
+ * полные ассоциации пула создаются пакетно при выгрузке.
  */
 double k_gen_compress_pattern(KolibriGenerationContext *ctx,
                               const KolibriSemanticPattern *pattern,
                               KolibriFormula *formula) {
     if (!ctx || !pattern || !formula || !ctx->formula_pool) return -1.0;
     
-    /* Преобразуем паттерн в строку цифр для создания ассоциации */
-    char pattern_str[KOLIBRI_SEMANTIC_PATTERN_SIZE * 2 + 1];
-    char *p = pattern_str;
+    /* Преобразуем паттерн в строку цифр - её хеш будет "вопросом" */
+    char pattern_str[KOLIBRI_SEMANTIC_PATTERN_SIZE + 1];
     for (size_t i = 0; i < KOLIBRI_SEMANTIC_PATTERN_SIZE; i++) {
-        *p++ = '0' + pattern->pattern[i];
+        pattern_str[i] = (char)('0' + pattern->pattern[i]);
     }
-    *p = '\0';
-    
-    /* Вычисляем хеш паттерна (это будет "вопрос") */
+    pattern_str[KOLIBRI_SEMANTIC_PATTERN_SIZE] = '\0';
     int pattern_hash = kf_hash_from_text(pattern_str);
     
-    /* DEBUG: Проверяем уникальность хеша */
-    static int debug_counter = 0;
-    if (debug_counter < 40) {
-        printf("[#%02d] Hash=%d Assocs=%zu\n", 
-               debug_counter, pattern_hash, ctx->formula_pool->association_count);
-        debug_counter++;
-    }
+    if (k_pattern_dict_put(&ctx->patterns, pattern_hash, pattern->pattern) < 0) return -1.0;
     
-    /* Создаём минимальный "вопрос" - просто число */
-    char question[32];
-    snprintf(question, sizeof(question), "%d", pattern_hash);
+    /* НЕ вызываем kf_pool_tick здесь! Это уничтожит накопленные ассоциации!
+       Вызываем его только ОДИН РАЗ после добавления ВСЕХ паттернов. */
     
-    /* Добавляем ассоциацию напрямую в пул, БЕЗ вызова kf_pool_add_example
-       Причина: kf_pool_add_example ограничен 64 примерами, а нам нужно больше!
-       
-       Копируем код из kf_pool_add_association, но БЕЗ examples */
-    
-    /* Создаём ассоциацию */
-    KolibriAssociation assoc;
-    memset(&assoc, 0, sizeof(assoc));
-    assoc.input_hash = pattern_hash;
-    assoc.output_hash = pattern_hash; /* Для простоты используем тот же хеш */
-    strncpy(assoc.question, question, sizeof(assoc.question) - 1);
-    strncpy(assoc.answer, pattern_str, sizeof(assoc.answer) - 1);
-    strncpy(assoc.source, "compress", sizeof(assoc.source) - 1);
-    assoc.timestamp = (uint64_t)time(NULL);
-    
-    /* Проверяем дубликаты */
-    int found = 0;
-    for (size_t i = 0; i < ctx->formula_pool->association_count; i++) {
-        if (ctx->formula_pool->associations[i].input_hash == assoc.input_hash) {
-            /* Обновляем существующую */
-            ctx->formula_pool->associations[i] = assoc;
-            found = 1;
-            break;
+    /* Метрика прогресса: ассоциации пула плюс ещё не выгруженные паттерны */
+    size_t assoc_count = ctx->formula_pool->association_count + ctx->patterns.inserted;
+    if (assoc_count > KOLIBRI_POOL_MAX_ASSOCIATIONS) assoc_count = KOLIBRI_POOL_MAX_ASSOCIATIONS;
+    return (double)assoc_count;
+}
+
+int k_gen_flush_patterns(KolibriGenerationContext *ctx) {
+    if (!ctx || !ctx->formula_pool) return -1;
+    
+    KolibriPatternDict *dict = &ctx->patterns;
+    KolibriFormulaPool *pool = ctx->formula_pool;
+    if (dict->pending == 0) return 0;
+    
+    /* Сколько ассоциаций добавится; место освобождается одним сдвигом */
+    size_t fresh = 0;
+    for (size_t i = 0; i < dict->count; i++) {
+        if (dict->entries[i].pending && assoc_find(ctx, dict->entries[i].hash) < 0) fresh++;
+    }
+    size_t skip = 0;
+    if (pool->association_count + fresh > KOLIBRI_POOL_MAX_ASSOCIATIONS) {
+        size_t evict = pool->association_count + fresh - KOLIBRI_POOL_MAX_ASSOCIATIONS;
+        if (evict > pool->association_count) {
+            skip = evict - pool->association_count;
+            evict = pool->association_count;
         }
+        memmove(&pool->associations[0], &pool->associations[evict],
+                (pool->association_count - evict) * sizeof(KolibriAssociation));
+        pool->association_count -= evict;
+        assoc_index_reset(ctx);
     }
     
-    /* Добавляем новую если не найдена */
-    if (!found) {
-        if (ctx->formula_pool->association_count < KOLIBRI_POOL_MAX_ASSOCIATIONS) {
-            ctx->formula_pool->associations[ctx->formula_pool->association_count++] = assoc;
+    uint64_t timestamp = (uint64_t)time(NULL);
+    int written = 0;
+    for (size_t i = 0; i < dict->count; i++) {
+        const KolibriPatternEntry *entry = &dict->entries[i];
+        if (!entry->pending) continue;
+        
+        uint8_t digits[KOLIBRI_SEMANTIC_PATTERN_SIZE];
+        char answer[KOLIBRI_SEMANTIC_PATTERN_SIZE];
+        char question[16];
+        k_pattern_dict_unpack(entry, digits);
+        for (size_t d = 0; d < KOLIBRI_SEMANTIC_PATTERN_SIZE; d++) answer[d] = (char)('0' + digits[d]);
+        snprintf(question, sizeof(question), "%d", entry->hash);
+        
+        long existing = assoc_find(ctx, entry->hash);
+        KolibriAssociation *assoc;
+        if (existing >= 0) {
+            assoc = &pool->associations[existing];
+        } else if (skip > 0) {
+            skip--;  /* Вытеснено бы более новыми паттернами того же пакета */
+            continue;
+        } else if (pool->association_count < KOLIBRI_POOL_MAX_ASSOCIATIONS) {
+            assoc = &pool->associations[pool->association_count++];
         } else {
-            /* Вытесняем старую (циклический буфер) */
-            memmove(&ctx->formula_pool->associations[0], 
-                   &ctx->formula_pool->associations[1],
-                   (KOLIBRI_POOL_MAX_ASSOCIATIONS - 1) * sizeof(KolibriAssociation));
-            ctx->formula_pool->associations[KOLIBRI_POOL_MAX_ASSOCIATIONS - 1] = assoc;
+            continue;
         }
+        gen_write_association(assoc, entry->hash, question, answer, sizeof(answer),
+                              "compress", timestamp);
+        written++;
     }
     
-    /* НЕ вызываем kf_pool_tick здесь! Это уничтожит накопленные ассоциации!
-       Вызываем его только ОДИН РАЗ после добавления ВСЕХ паттернов. */
-    
-    /* Возвращаем текущее количество ассоциаций как метрику прогресса */
-    size_t assoc_count = ctx->formula_pool->association_count;
-    
-    /* Для отображения прогресса возвращаем количество ассоциаций */
-    return (double)assoc_count;
+    k_pattern_dict_clear_pending(dict);
+    return written;
+}
+
+int k_gen_lookup_pattern(const KolibriGenerationContext *ctx, int hash,
+                         KolibriSemanticPattern *pattern) {
+    if (!ctx || !pattern) return -1;
+    const KolibriPatternEntry *entry = k_pattern_dict_find(&ctx->patterns, hash);
+    if (!entry) return -1;
+    k_semantic_pattern_init(pattern);
+    k_pattern_dict_unpack(entry, pattern->pattern);
+    return 0;
 }
 
 /**
@@ -213,6 +328,9 @@ double k_gen_compress_pattern(KolibriGenerationContext *ctx,
 int k_gen_finalize_compression(KolibriGenerationContext *ctx, size_t generations) {
     if (!ctx || !ctx->formula_pool) return -1;
     
+    /* Паттерны словаря становятся ассоциациями пула одним пакетом */
+    if (k_gen_flush_patterns(ctx) < 0) return -1;
+    
     /* Запускаем эволюцию со всеми накопленными ассоциациями */
     kf_pool_tick(ctx->formula_pool, generations);
     
@@ -287,32 +405,15 @@ int k_gen_compress_formula(KolibriGenerationContext *ctx,
     char question[32];
     snprintf(question, sizeof(question), "F%d", formula_hash);
     
-    /* Создаём мета-ассоциацию */
-    KolibriAssociation meta_assoc;
-    memset(&meta_assoc, 0, sizeof(meta_assoc));
-    meta_assoc.input_hash = formula_hash;
-    meta_assoc.output_hash = formula_hash;
-    strncpy(meta_assoc.question, question, sizeof(meta_assoc.question) - 1);
-    strncpy(meta_assoc.answer, formula_str, sizeof(meta_assoc.answer) - 1);
-    strncpy(meta_assoc.source, "meta_compress", sizeof(meta_assoc.source) - 1);
-    meta_assoc.timestamp = (uint64_t)time(NULL);
-    
-    /* Проверяем дубликаты */
-    int found = 0;
-    for (size_t i = 0; i < ctx->formula_pool->association_count; i++) {
-        if (ctx->formula_pool->associations[i].input_hash == formula_hash) {
-            found = 1;
-            break;
-        }
-    }
+    /* Проверяем дубликаты через индекс и добавляем если уникальный */
+    KolibriFormulaPool *pool = ctx->formula_pool;
+    if (assoc_find(ctx, formula_hash) >= 0) return 1;
+    if (pool->association_count >= KOLIBRI_POOL_MAX_ASSOCIATIONS) return -1;
     
-    /* Добавляем если уникальный */
-    if (!found && ctx->formula_pool->association_count < KOLIBRI_POOL_MAX_ASSOCIATIONS) {
-        ctx->formula_pool->associations[ctx->formula_pool->association_count++] = meta_assoc;
-        return 0;
-    }
-    
-    return found ? 1 : -1;
+    gen_write_association(&pool->associations[pool->association_count++], formula_hash,
+                          question, formula_str, (size_t)(p - formula_str), "meta_compress",
+                          (uint64_t)time(NULL));
+    return 0;
 }
 
 /**
@@ -351,23 +452,310 @@ int k_gen_decompress_pattern(KolibriGenerationContext *ctx,
     return 0;
 }
 
+/* ---------- n-граммная модель ---------- */
+
+static double gen_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/* Модель контекста; собственная перестраивается, если корпус вырос */
+static const KolibriNgramModel *gen_model(KolibriGenerationContext *ctx) {
+    if (ctx->model && (!ctx->owns_model || ctx->model_corpus_count == ctx->corpus->store.count)) {
+        return ctx->model;
+    }
+    if (ctx->owns_model) {
+        k_ngram_free(ctx->model);
+        ctx->model = NULL;
+        ctx->owns_model = 0;
+    }
+
+    KolibriNgramBuilder *builder = k_ngram_builder_create(1);
+    if (!builder) return NULL;
+    if (k_ngram_builder_add_corpus(builder, ctx->corpus) == 0) {
+        ctx->model = k_ngram_build(builder);
+    }
+    k_ngram_builder_destroy(builder);
+
+    if (ctx->model) {
+        ctx->owns_model = 1;
+        ctx->model_corpus_count = ctx->corpus->store.count;
+    }
+    return ctx->model;
+}
+
+static void gen_push(KolibriGenerationContext *ctx, uint32_t word) {
+    if (ctx->history_len == KOLIBRI_NGRAM_MAX_ORDER) {
+        memmove(ctx->history, ctx->history + 1, (KOLIBRI_NGRAM_MAX_ORDER - 1) * sizeof(uint32_t));
+        ctx->history_len--;
+    }
+    ctx->history[ctx->history_len++] = word;
+}
+
+static double gen_temperature(const KolibriGenerationContext *ctx) {
+    return ctx->strategy == KOLIBRI_GEN_SAMPLING || ctx->strategy == KOLIBRI_GEN_FORMULA
+               ? ctx->temperature : 0.0;
+}
+
+static size_t gen_beam_width(const KolibriGenerationContext *ctx) {
+    size_t width = ctx->beam_size;
+    if (width < 1) width = 1;
+    if (width > KOLIBRI_BEAM_SIZE) width = KOLIBRI_BEAM_SIZE;
+    return width;
+}
+
+/* Дописать слово через пробел; -1, если не помещается */
+/* Слова без строки в модели (NULL от k_ngram_word) останавливают вывод */
+static int gen_append(char *output, size_t output_size, size_t *pos, const char *word) {
+    if (!word) return -1;
+    size_t len = strlen(word);
+    size_t need = len + (*pos > 0 ? 1 : 0);
+    if (*pos + need >= output_size) return -1;
+    if (*pos > 0) output[(*pos)++] = ' ';
+    memcpy(output + *pos, word, len);
+    *pos += len;
+    output[*pos] = '\0';
+    return 0;
+}
+
+void k_gen_set_model(KolibriGenerationContext *ctx, KolibriNgramModel *model) {
+    if (!ctx) return;
+    if (ctx->owns_model) k_ngram_free(ctx->model);
+    ctx->model = model;
+    ctx->owns_model = 0;
+    ctx->history_len = 0;
+}
+
+void k_gen_set_seed(KolibriGenerationContext *ctx, uint64_t seed) {
+    if (ctx) ctx->rng_state = seed ? seed : GEN_DEFAULT_SEED;
+}
+
 int k_gen_next_token(KolibriGenerationContext *ctx, char *output, size_t output_size) {
     if (!ctx || !output || output_size == 0) return -1;
     output[0] = '\0';
+
+    double start = gen_now();
+    const KolibriNgramModel *model = gen_model(ctx);
+    if (!model) return -1;
+
+    uint32_t word = k_ngram_sample(model, ctx->history, ctx->history_len,
+                                   gen_temperature(ctx), &ctx->rng_state);
+    if (word == KOLIBRI_NGRAM_UNK) return -1;
+
+    const char *text = k_ngram_word(model, word);
+    if (!text) return -1;
+    size_t len = strlen(text);
+    if (len >= output_size) len = output_size - 1;
+    memcpy(output, text, len);
+    output[len] = '\0';
+
+    gen_push(ctx, word);
+    ctx->tokens_generated++;
+    ctx->generation_time_sec += gen_now() - start;
     return 0;
 }
 
+/* Луч: накопленный log2 вероятности и хвост истории */
+typedef struct {
+    double score;
+    uint32_t history[KOLIBRI_NGRAM_MAX_ORDER];
+    size_t history_len;
+} GenBeam;
+
+/* Продолжение луча в ограниченной куче шага */
+typedef struct {
+    double score;
+    uint32_t parent;
+    uint32_t word;
+} GenBeamStep;
+
+static void gen_step_offer(GenBeamStep *heap, size_t *size, size_t capacity, GenBeamStep item) {
+    size_t i;
+    if (*size < capacity) {
+        i = (*size)++;
+        while (i > 0 && heap[(i - 1) / 2].score > item.score) {
+            heap[i] = heap[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+        heap[i] = item;
+        return;
+    }
+    if (item.score <= heap[0].score) return;
+
+    i = 0;
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= *size) break;
+        if (child + 1 < *size && heap[child + 1].score < heap[child].score) child++;
+        if (heap[child].score >= item.score) break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = item;
+}
+
+/* Beam search по последовательности: лучи и их токены выделяются
+ * один раз на вызов, каждый шаг отбирает width продолжений из
+ * width * width кандидатов */
+static int gen_beam_sequence(KolibriGenerationContext *ctx, const KolibriNgramModel *model,
+                             size_t num_tokens, char *output, size_t output_size) {
+    size_t width = gen_beam_width(ctx);
+    GenBeam beams[KOLIBRI_BEAM_SIZE], next[KOLIBRI_BEAM_SIZE];
+    GenBeamStep heap[KOLIBRI_BEAM_SIZE];
+    KolibriNgramChoice choices[KOLIBRI_BEAM_SIZE];
+
+    uint32_t *tokens = (uint32_t *)malloc(2 * width * (num_tokens + 1) * sizeof(uint32_t));
+    if (!tokens) return -1;
+    uint32_t *rows = tokens, *next_rows = tokens + width * (num_tokens + 1);
+
+    beams[0].score = 0.0;
+    memcpy(beams[0].history, ctx->history, sizeof(ctx->history));
+    beams[0].history_len = ctx->history_len;
+    size_t live = 1, steps = 0;
+
+    while (steps < num_tokens) {
+        size_t heap_size = 0;
+        for (size_t b = 0; b < live; b++) {
+            size_t n = k_ngram_top(model, beams[b].history, beams[b].history_len, choices, width);
+            for (size_t c = 0; c < n; c++) {
+                GenBeamStep step = {beams[b].score + choices[c].logprob, (uint32_t)b, choices[c].word};
+                gen_step_offer(heap, &heap_size, width, step);
+            }
+        }
+        if (heap_size == 0) break;
+
+        /* Лучший первым; при равенстве - меньший родитель и слово */
+        for (size_t i = 1; i < heap_size; i++) {
+            GenBeamStep item = heap[i];
+            size_t j = i;
+            while (j > 0 && (heap[j - 1].score < item.score ||
+                             (heap[j - 1].score == item.score &&
+                              (heap[j - 1].parent > item.parent ||
+                               (heap[j - 1].parent == item.parent && heap[j - 1].word > item.word))))) {
+                heap[j] = heap[j - 1];
+                j--;
+            }
+            heap[j] = item;
+        }
+
+        for (size_t i = 0; i < heap_size; i++) {
+            const GenBeam *parent = &beams[heap[i].parent];
+            GenBeam *beam = &next[i];
+            beam->score = heap[i].score;
+            memcpy(beam->history, parent->history, sizeof(beam->history));
+            beam->history_len = parent->history_len;
+            if (beam->history_len == KOLIBRI_NGRAM_MAX_ORDER) {
+                memmove(beam->history, beam->history + 1,
+                        (KOLIBRI_NGRAM_MAX_ORDER - 1) * sizeof(uint32_t));
+                beam->history_len--;
+            }
+            beam->history[beam->history_len++] = heap[i].word;
+
+            memcpy(next_rows + i * (num_tokens + 1), rows + heap[i].parent * (num_tokens + 1),
+                   steps * sizeof(uint32_t));
+            next_rows[i * (num_tokens + 1) + steps] = heap[i].word;
+        }
+        memcpy(beams, next, heap_size * sizeof(GenBeam));
+        uint32_t *swap = rows;
+        rows = next_rows;
+        next_rows = swap;
+        live = heap_size;
+        steps++;
+    }
+
+    /* Лучший луч - первый после сортировки шага */
+    size_t pos = 0, written = 0;
+    output[0] = '\0';
+    for (size_t i = 0; i < steps; i++) {
+        uint32_t word = rows[i];
+        if (gen_append(output, output_size, &pos, k_ngram_word(model, word)) != 0) break;
+        gen_push(ctx, word);
+        written++;
+    }
+    free(tokens);
+    return (int)written;
+}
+
 int k_gen_generate(KolibriGenerationContext *ctx, const char *prompt, size_t num_tokens,
                   char *output, size_t output_size) {
     if (!ctx || !output || output_size == 0) return -1;
     output[0] = '\0';
-    return 0;
+
+    double start = gen_now();
+    const KolibriNgramModel *model = gen_model(ctx);
+    if (!model) return -1;
+    if (num_tokens > ctx->max_length) num_tokens = ctx->max_length;
+
+    /* История из последних слов подсказки */
+    ctx->history_len = 0;
+    if (prompt) {
+        size_t len = strlen(prompt);
+        uint32_t local[64];
+        uint32_t *ids = local;
+        size_t count = k_ngram_tokenize(model, prompt, len, NULL, 0);
+        if (count > 64) {
+            ids = (uint32_t *)malloc(count * sizeof(uint32_t));
+            if (!ids) return -1;
+        }
+        k_ngram_tokenize(model, prompt, len, ids, count);
+        size_t from = count > KOLIBRI_NGRAM_MAX_ORDER ? count - KOLIBRI_NGRAM_MAX_ORDER : 0;
+        for (size_t i = from; i < count; i++) gen_push(ctx, ids[i]);
+        if (ids != local) free(ids);
+    }
+
+    int generated = 0;
+    if (ctx->strategy == KOLIBRI_GEN_BEAM) {
+        generated = gen_beam_sequence(ctx, model, num_tokens, output, output_size);
+        if (generated < 0) return -1;
+    } else {
+        double temperature = gen_temperature(ctx);
+        size_t pos = 0;
+        for (size_t i = 0; i < num_tokens; i++) {
+            uint32_t word = k_ngram_sample(model, ctx->history, ctx->history_len,
+                                           temperature, &ctx->rng_state);
+            if (word == KOLIBRI_NGRAM_UNK) break;
+            if (gen_append(output, output_size, &pos, k_ngram_word(model, word)) != 0) break;
+            gen_push(ctx, word);
+            generated++;
+        }
+    }
+
+    ctx->tokens_generated += (size_t)generated;
+    ctx->generation_time_sec += gen_now() - start;
+    return generated;
 }
 
 int k_gen_beam_search(KolibriGenerationContext *ctx, KolibriGenerationCandidate *candidates,
                       size_t *num_candidates) {
     if (!ctx || !candidates || !num_candidates) return -1;
     *num_candidates = 0;
+
+    const KolibriNgramModel *model = gen_model(ctx);
+    if (!model) return -1;
+
+    KolibriNgramChoice choices[KOLIBRI_BEAM_SIZE];
+    size_t n = k_ngram_top(model, ctx->history, ctx->history_len, choices, gen_beam_width(ctx));
+    size_t count = 0;
+    for (size_t i = 0; i < n; i++) {
+        const char *word = k_ngram_word(model, choices[i].word);
+        if (!word) continue;
+        KolibriGenerationCandidate *candidate = &candidates[count++];
+        size_t len = strlen(word);
+        if (len >= sizeof(candidate->token)) len = sizeof(candidate->token) - 1;
+        memcpy(candidate->token, word, len);
+        candidate->token[len] = '\0';
+
+        const KolibriSemanticPattern *pattern = k_corpus_find_pattern(ctx->corpus, candidate->token);
+        if (pattern) {
+            candidate->pattern = *pattern;
+        } else {
+            k_semantic_pattern_init(&candidate->pattern);
+        }
+        candidate->score = choices[i].logprob;
+        candidate->formula_compression = 0.0;
+    }
+    *num_candidates = count;
     return 0;
 }
 
@@ -380,7 +768,27 @@ int k_gen_evolve_text(KolibriGenerationContext *ctx, size_t generations,
 
 double k_gen_perplexity(KolibriGenerationContext *ctx, const char *text, size_t text_len) {
     if (!ctx || !text) return -1.0;
-    return 1.0;
+
+    const KolibriNgramModel *model = gen_model(ctx);
+    if (!model) return -1.0;
+
+    size_t count = k_ngram_tokenize(model, text, text_len, NULL, 0);
+    if (count == 0) return -1.0;
+    uint32_t *ids = (uint32_t *)malloc(count * sizeof(uint32_t));
+    if (!ids) return -1.0;
+    k_ngram_tokenize(model, text, text_len, ids, count);
+
+    KolibriNgramInfo info;
+    k_ngram_get_info(model, &info);
+    size_t context = info.order - 1;
+
+    double total = 0.0;
+    for (size_t i = 0; i < count; i++) {
+        size_t history = i < context ? i : context;
+        total += k_ngram_logprob(model, ids + i - history, history, ids[i]);
+    }
+    free(ids);
+    return exp2(-total / (double)count);
 }
 
 double k_gen_coherence(KolibriGenerationContext *ctx, const char *text, size_t text_len) {
@@ -393,7 +801,10 @@ void k_gen_set_temperature(KolibriGenerationContext *ctx, double temperature) {
 }
 
 void k_gen_set_beam_size(KolibriGenerationContext *ctx, size_t beam_size) {
-    if (ctx) ctx->beam_size = beam_size;
+    if (!ctx) return;
+    if (beam_size < 1) beam_size = 1;
+    if (beam_size > KOLIBRI_BEAM_SIZE) beam_size = KOLIBRI_BEAM_SIZE;
+    ctx->beam_size = beam_size;
 }
 
 void k_gen_get_stats(const KolibriGenerationContext *ctx, size_t *tokens_generated,
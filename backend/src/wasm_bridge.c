@@ -1,5 +1,3 @@
-#define _GNU_SOURCE
-
 #include "kolibri/formula.h"
 #include "kolibri/script.h"
 
@@ -7,8 +5,12 @@
 #include <stdlib.h>
 #include <string.h>
 
-static KolibriFormulaPool g_pool;
+/* Базовый пул создаётся один раз и не меняется: обучение копится в
+ * оверлее интерпретатора (KolibriPoolOverlay) поверх базы, сброс
+ * очищает оверлей. */
+static KolibriFormulaPool g_base;
 static KolibriScript g_script;
+static int g_base_ready = 0;
 static int g_bridge_ready = 0;
 
 static int bridge_ensure_initialized(void) {
@@ -16,8 +18,11 @@ static int bridge_ensure_initialized(void) {
         return 0;
     }
 
-    kf_pool_init(&g_pool, 424242ULL);
-    if (ks_init(&g_script, &g_pool, NULL) != 0) {
+    if (!g_base_ready) {
+        kf_pool_init(&g_base, 424242ULL);
+        g_base_ready = 1;
+    }
+    if (ks_init_shared(&g_script, &g_base, NULL) != 0) {
         return -1;
     }
 
@@ -26,14 +31,17 @@ static int bridge_ensure_initialized(void) {
 }
 
 int kolibri_bridge_init(void) {
-    g_bridge_ready = 0;
+    if (g_bridge_ready) {
+        ks_reset(&g_script);
+        return 0;
+    }
     return bridge_ensure_initialized();
 }
 
 int kolibri_bridge_reset(void) {
     if (g_bridge_ready) {
-        ks_free(&g_script);
-        g_bridge_ready = 0;
+        ks_reset(&g_script);
+        return 0;
     }
     return bridge_ensure_initialized();
 }
@@ -48,69 +56,34 @@ int kolibri_bridge_execute(const char *program_utf8, char *out_buffer, size_t ou
         return -1;
     }
 
-    FILE *sink = NULL;
-#if defined(__EMSCRIPTEN__)
-    char *sink_buffer = NULL;
-    size_t sink_size = 0U;
-    sink = open_memstream(&sink_buffer, &sink_size);
-#else
-    sink = tmpfile();
-#endif
-    if (!sink) {
-        out_buffer[0] = '\0';
-        return -2;
-    }
-
-    ks_set_output(&g_script, sink);
+    /* Вывод копится во встроенном буфере сценария: без файлов и потоков */
+    ks_capture_output(&g_script);
     if (ks_load_text(&g_script, program_utf8) != 0) {
-        fclose(sink);
-#if defined(__EMSCRIPTEN__)
-        free(sink_buffer);
-#endif
         ks_set_output(&g_script, stdout);
         out_buffer[0] = '\0';
         return -3;
     }
 
     if (ks_execute(&g_script) != 0) {
-        fclose(sink);
-#if defined(__EMSCRIPTEN__)
-        free(sink_buffer);
-#endif
         ks_set_output(&g_script, stdout);
         out_buffer[0] = '\0';
         return -4;
     }
 
-    fflush(sink);
-#if defined(__EMSCRIPTEN__)
-    fclose(sink);
+    size_t length = 0U;
+    const char *output = ks_output(&g_script, &length);
     ks_set_output(&g_script, stdout);
+    if (!output) {
+        out_buffer[0] = '\0';
+        return -2;
+    }
 
-    size_t copy = sink_size < (out_capacity - 1U) ? sink_size : (out_capacity - 1U);
+    size_t copy = length < (out_capacity - 1U) ? length : (out_capacity - 1U);
     if (copy > 0U) {
-        memcpy(out_buffer, sink_buffer, copy);
+        memcpy(out_buffer, output, copy);
     }
     out_buffer[copy] = '\0';
-    free(sink_buffer);
-
     return (int)copy;
-#else
-    if (fseek(sink, 0L, SEEK_SET) != 0) {
-        fclose(sink);
-        ks_set_output(&g_script, stdout);
-        out_buffer[0] = '\0';
-        return -2;
-    }
-
-    size_t written = fread(out_buffer, 1U, out_capacity - 1U, sink);
-    out_buffer[written] = '\0';
-
-    fclose(sink);
-    ks_set_output(&g_script, stdout);
-
-    return (int)written;
-#endif
 }
 
 /* Compression WASM exports */
@@ -26,10 +26,32 @@ int kg_open(KolibriGenome *ctx, const char *path, const unsigned char *key, size
     return -1;
 }
 
+int kg_open_ex(KolibriGenome *ctx, const char *path, const unsigned char *key, size_t key_len,
+               const KolibriGenomeOpenOptions *options) {
+    (void)options;
+    return kg_open(ctx, path, key, key_len);
+}
+
+int kg_append_batch(KolibriGenome *ctx, const char *const *event_types, const char *const *payloads,
+                    size_t count) {
+    (void)ctx;
+    (void)event_types;
+    (void)payloads;
+    (void)count;
+    return 0;
+}
+
 void kg_close(KolibriGenome *ctx) {
     (void)ctx;
 }
 
+int kg_read_block(KolibriGenome *ctx, uint64_t index, ReasonBlock *out_block) {
+    (void)ctx;
+    (void)index;
+    (void)out_block;
+    return -1;
+}
+
 int kg_verify_file(const char *path, const unsigned char *key, size_t key_len) {
     (void)path;
     (void)key;
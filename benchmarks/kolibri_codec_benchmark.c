@@ -0,0 +1,796 @@
+/*
+ * Kolibri Codec Benchmark v1.0
+ * Compression benchmark for kolibri_core codecs and the archive API
+ *
+ * Features:
+ * - Deterministic generated corpus: text, source, logs, binary, repetitive, random
+ * - Every method and level of kolibri_compress plus the archive API
+ * - MB/s, ratio, peak RSS and per-stage time (compress, decompress, verify)
+ * - Each run in a forked child: isolated peak RSS, timeouts for slow methods
+ * - JSON and Markdown output for regression tracking
+ * - Optional system zlib / xz / zstd for comparison (when found at build time)
+ *
+ * Copyright (c) 2025 Kolibri Project
+ * Licensed under MIT License
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "kolibri/compress.h"
+#include "kolibri/ppm.h"
+
+#ifdef KOLIBRI_BENCH_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef KOLIBRI_BENCH_HAVE_LZMA
+#include <lzma.h>
+#endif
+#ifdef KOLIBRI_BENCH_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+/* Benchmark configuration */
+#define DEFAULT_CORPUS_SIZE (4u << 20)
+#define QUICK_CORPUS_SIZE (1u << 20)
+#define FULL_CORPUS_SIZE (32u << 20)
+#define DEFAULT_ITERATIONS 3
+#define DEFAULT_TIMEOUT_S 120
+#define DEFAULT_SEED 0x4B4F4C49ULL
+#define MAX_RESULTS 256
+
+/* ============================================================
+ * Corpus generation
+ * ============================================================ */
+
+typedef struct {
+    uint64_t state;
+} BenchRng;
+
+static uint64_t rng_next(BenchRng *rng) {
+    rng->state ^= rng->state << 13;
+    rng->state ^= rng->state >> 7;
+    rng->state ^= rng->state << 17;
+    return rng->state;
+}
+
+/* Skewed pick: small indices are much more frequent (roughly Zipf) */
+static size_t rng_skewed(BenchRng *rng, size_t n) {
+    uint64_t a = rng_next(rng) % n;
+    uint64_t b = rng_next(rng) % n;
+    return (size_t)(a < b ? a : b) * (size_t)(rng_next(rng) % n) / n;
+}
+
+typedef struct {
+    uint8_t *data;
+    size_t size;
+    size_t pos;
+} CorpusWriter;
+
+static void put_bytes(CorpusWriter *w, const void *bytes, size_t len) {
+    if (len > w->size - w->pos) len = w->size - w->pos;
+    memcpy(w->data + w->pos, bytes, len);
+    w->pos += len;
+}
+
+static void put_str(CorpusWriter *w, const char *s) {
+    put_bytes(w, s, strlen(s));
+}
+
+static const char *WORDS[] = {
+    "the", "of", "and", "to", "in", "a", "is", "that", "for", "it", "as", "was", "with",
+    "be", "by", "on", "not", "he", "this", "are", "or", "his", "from", "at", "which",
+    "but", "have", "an", "had", "they", "you", "were", "their", "one", "all", "we",
+    "can", "her", "has", "there", "been", "if", "more", "when", "will", "would", "who",
+    "so", "no", "memory", "kolibri", "archive", "context", "number", "digit", "formula",
+    "system", "language", "evolution", "pattern", "compression", "genome", "knowledge",
+    "block", "stream", "model", "reason", "signal", "structure", "between", "through"};
+#define WORD_COUNT (sizeof(WORDS) / sizeof(WORDS[0]))
+
+static void gen_text(CorpusWriter *w, BenchRng *rng) {
+    while (w->pos < w->size) {
+        size_t words = 6 + rng_next(rng) % 14;
+        for (size_t i = 0; i < words; i++) {
+            const char *word = WORDS[rng_skewed(rng, WORD_COUNT)];
+            if (i == 0) {
+                char first[32];
+                snprintf(first, sizeof(first), "%s", word);
+                if (first[0] >= 'a' && first[0] <= 'z') first[0] = (char)(first[0] - 32);
+                put_str(w, first);
+            } else {
+                put_str(w, " ");
+                put_str(w, word);
+            }
+        }
+        put_str(w, rng_next(rng) % 5 == 0 ? ".\n\n" : ". ");
+    }
+}
+
+static const char *IDENTS[] = {"size", "count", "buffer", "result", "index", "node",
+                               "ctx", "state", "length", "offset", "value", "entry"};
+static const char *TYPES[] = {"int", "size_t", "uint8_t *", "uint32_t", "const char *", "double"};
+
+static void gen_source(CorpusWriter *w, BenchRng *rng) {
+    char line[256];
+    unsigned fn = 0;
+    while (w->pos < w->size) {
+        const char *type = TYPES[rng_next(rng) % 6];
+        snprintf(line, sizeof(line), "\nstatic %s kolibri_%s_%u(%s %s, size_t %s) {\n", type,
+                 IDENTS[rng_next(rng) % 12], fn++, TYPES[rng_next(rng) % 6],
+                 IDENTS[rng_next(rng) % 12], IDENTS[rng_next(rng) % 12]);
+        put_str(w, line);
+        size_t body = 3 + rng_next(rng) % 10;
+        for (size_t i = 0; i < body && w->pos < w->size; i++) {
+            const char *a = IDENTS[rng_skewed(rng, 12)], *b = IDENTS[rng_skewed(rng, 12)];
+            switch (rng_next(rng) % 5) {
+            case 0: snprintf(line, sizeof(line), "    if (!%s) {\n        return -1;\n    }\n", a); break;
+            case 1: snprintf(line, sizeof(line), "    for (size_t i = 0; i < %s; i++) {\n        %s[i] = %s[i];\n    }\n", a, b, a); break;
+            case 2: snprintf(line, sizeof(line), "    %s += %s * %u;\n", a, b, (unsigned)(rng_next(rng) % 64)); break;
+            case 3: snprintf(line, sizeof(line), "    /* update %s from %s */\n", a, b); break;
+            default: snprintf(line, sizeof(line), "    %s = kolibri_%s(%s, %s);\n", a, b, a, b); break;
+            }
+            put_str(w, line);
+        }
+        put_str(w, "    return 0;\n}\n");
+    }
+}
+
+static void gen_logs(CorpusWriter *w, BenchRng *rng) {
+    static const char *levels[] = {"INFO", "INFO", "INFO", "DEBUG", "WARN", "ERROR"};
+    static const char *modules[] = {"node", "queue", "relay", "indexer", "archive", "sim"};
+    static const char *events[] = {"request served", "block flushed", "peer connected",
+                                   "cache miss", "formula accepted", "checksum verified"};
+    char line[256];
+    uint64_t ts = 1735689600000ULL;
+    while (w->pos < w->size) {
+        ts += rng_next(rng) % 250;
+        time_t secs = (time_t)(ts / 1000);
+        struct tm tm;
+        gmtime_r(&secs, &tm);
+        snprintf(line, sizeof(line),
+                 "%04d-%02d-%02dT%02d:%02d:%02d.%03uZ %-5s [%s] %s id=%08x took=%ums\n",
+                 tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec,
+                 (unsigned)(ts % 1000), levels[rng_next(rng) % 6], modules[rng_skewed(rng, 6)],
+                 events[rng_skewed(rng, 6)], (unsigned)(rng_next(rng) & 0xFFFFF),
+                 (unsigned)(rng_next(rng) % 40));
+        put_str(w, line);
+    }
+}
+
+/* Fixed-size records with counters, small deltas and sensor floats */
+static void gen_binary(CorpusWriter *w, BenchRng *rng) {
+    uint32_t counter = 0, sensor = 20000;
+    while (w->pos < w->size) {
+        uint8_t record[32];
+        counter += 1 + (uint32_t)(rng_next(rng) % 3);
+        sensor += (uint32_t)(rng_next(rng) % 21) - 10;
+        float reading = (float)sensor / 100.0f;
+        uint16_t flags = (uint16_t)(rng_next(rng) % 8 == 0 ? 0x8001 : 0x0001);
+        memset(record, 0, sizeof(record));
+        memcpy(record, &counter, 4);
+        memcpy(record + 4, &sensor, 4);
+        memcpy(record + 8, &reading, 4);
+        memcpy(record + 12, &flags, 2);
+        record[14] = (uint8_t)(counter % 7);
+        uint64_t noise = rng_next(rng);
+        memcpy(record + 24, &noise, 4);
+        put_bytes(w, record, sizeof(record));
+    }
+}
+
+static void gen_repetitive(CorpusWriter *w, BenchRng *rng) {
+    uint8_t unit[1024];
+    for (size_t i = 0; i < sizeof(unit); i++) unit[i] = (uint8_t)('a' + rng_next(rng) % 16);
+    while (w->pos < w->size) {
+        if (rng_next(rng) % 16 == 0) unit[rng_next(rng) % sizeof(unit)] = (uint8_t)rng_next(rng);
+        put_bytes(w, unit, sizeof(unit));
+    }
+}
+
+static void gen_random(CorpusWriter *w, BenchRng *rng) {
+    while (w->pos < w->size) {
+        uint64_t v = rng_next(rng);
+        put_bytes(w, &v, sizeof(v));
+    }
+}
+
+typedef struct {
+    const char *name;
+    void (*generate)(CorpusWriter *w, BenchRng *rng);
+} CorpusKind;
+
+static const CorpusKind CORPORA[] = {
+    {"text", gen_text},
+    {"source", gen_source},
+    {"logs", gen_logs},
+    {"binary", gen_binary},
+    {"repetitive", gen_repetitive},
+    {"random", gen_random},
+};
+#define CORPUS_COUNT (sizeof(CORPORA) / sizeof(CORPORA[0]))
+
+/* ============================================================
+ * Codecs
+ * ============================================================ */
+
+typedef enum {
+    CODEC_KOLIBRI,
+    CODEC_ARCHIVE,
+    CODEC_ZLIB,
+    CODEC_XZ,
+    CODEC_ZSTD
+} CodecKind;
+
+typedef struct {
+    const char *name;
+    const char *level;
+    CodecKind kind;
+    uint32_t methods;     /* kolibri method flags */
+    size_t param;         /* block size, PPM order or external level */
+    size_t max_input;     /* input is truncated to this size, 0 = no limit */
+    int external;
+} CodecSpec;
+
+static const CodecSpec CODECS[] = {
+    {"kolibri-rle", "default", CODEC_KOLIBRI, KOLIBRI_COMPRESS_RLE, 0, 0, 0},
+    /* LZ77 scans its whole window per byte: keep the input small */
+    {"kolibri-layered", "lz77+rle", CODEC_KOLIBRI, KOLIBRI_COMPRESS_LZ77 | KOLIBRI_COMPRESS_RLE, 0, 256u << 10, 0},
+    {"kolibri-bwt", "block=256K", CODEC_KOLIBRI, KOLIBRI_COMPRESS_BWT, 256u << 10, 0, 0},
+    {"kolibri-bwt", "block=1M", CODEC_KOLIBRI, KOLIBRI_COMPRESS_BWT, 1u << 20, 0, 0},
+    {"kolibri-bwt", "block=4M", CODEC_KOLIBRI, KOLIBRI_COMPRESS_BWT, 4u << 20, 0, 0},
+    {"kolibri-ppm", "order=2", CODEC_KOLIBRI, KOLIBRI_COMPRESS_PPM, 2, 0, 0},
+    {"kolibri-ppm", "order=4", CODEC_KOLIBRI, KOLIBRI_COMPRESS_PPM, 4, 0, 0},
+    {"kolibri-ppm", "order=6", CODEC_KOLIBRI, KOLIBRI_COMPRESS_PPM, 6, 0, 0},
+    {"kolibri-archive", "8 entries", CODEC_ARCHIVE, 0, 8, 0, 0},
+#ifdef KOLIBRI_BENCH_HAVE_ZLIB
+    {"zlib", "1", CODEC_ZLIB, 0, 1, 0, 1},
+    {"zlib", "6", CODEC_ZLIB, 0, 6, 0, 1},
+    {"zlib", "9", CODEC_ZLIB, 0, 9, 0, 1},
+#endif
+#ifdef KOLIBRI_BENCH_HAVE_LZMA
+    {"xz", "1", CODEC_XZ, 0, 1, 0, 1},
+    {"xz", "6", CODEC_XZ, 0, 6, 0, 1},
+#endif
+#ifdef KOLIBRI_BENCH_HAVE_ZSTD
+    {"zstd", "1", CODEC_ZSTD, 0, 1, 0, 1},
+    {"zstd", "3", CODEC_ZSTD, 0, 3, 0, 1},
+    {"zstd", "19", CODEC_ZSTD, 0, 19, 0, 1},
+#endif
+};
+#define CODEC_COUNT (sizeof(CODECS) / sizeof(CODECS[0]))
+
+typedef struct {
+    const char *corpus;
+    const CodecSpec *codec;
+    int status;               /* 0 ok, 1 failed, 2 timeout, 3 crashed */
+    size_t input_size;
+    size_t compressed_size;
+    double compress_ms;       /* best of the iterations */
+    double decompress_ms;
+    double verify_ms;
+    long peak_rss_kb;         /* peak RSS of the run */
+    long base_rss_kb;         /* RSS before the run (corpus included) */
+} BenchResult;
+
+static BenchResult results[MAX_RESULTS];
+static int num_results = 0;
+
+static size_t g_threads = 0;
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+/* Read a "Key:   123 kB" line from /proc/self/status, -1 if unavailable */
+static long proc_status_kb(const char *key) {
+    FILE *f = fopen("/proc/self/status", "r");
+    if (!f) return -1;
+    char line[256];
+    long value = -1;
+    size_t key_len = strlen(key);
+    while (fgets(line, sizeof(line), f)) {
+        if (strncmp(line, key, key_len) == 0 && line[key_len] == ':') {
+            value = strtol(line + key_len + 1, NULL, 10);
+            break;
+        }
+    }
+    fclose(f);
+    return value;
+}
+
+/* Reset the peak RSS counter so the child only reports its own run */
+static void reset_peak_rss(void) {
+    FILE *f = fopen("/proc/self/clear_refs", "w");
+    if (f) {
+        fputs("5", f);
+        fclose(f);
+    }
+}
+
+static long peak_rss_kb(void) {
+    long hwm = proc_status_kb("VmHWM");
+    if (hwm >= 0) return hwm;
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+/* One compress/decompress pass; returns 0 on success */
+typedef struct {
+    uint8_t *packed;
+    size_t packed_size;
+    uint8_t *unpacked;
+    size_t unpacked_size;
+} CodecBuffers;
+
+static void buffers_release(CodecBuffers *b) {
+    free(b->packed);
+    free(b->unpacked);
+    memset(b, 0, sizeof(*b));
+}
+
+static int kolibri_pass(const CodecSpec *codec, const uint8_t *input, size_t size,
+                        CodecBuffers *b, double *compress_ms, double *decompress_ms) {
+    KolibriCompressor *comp = kolibri_compressor_create(codec->methods);
+    if (!comp) return -1;
+    if (codec->methods & KOLIBRI_COMPRESS_BWT) {
+        kolibri_compressor_set_blocks(comp, codec->param, g_threads);
+    } else if (codec->methods & KOLIBRI_COMPRESS_PPM) {
+        kolibri_compressor_set_ppm(comp, (unsigned)codec->param, 0);
+    }
+
+    double t0 = now_ms();
+    int rc = kolibri_compress(comp, input, size, &b->packed, &b->packed_size, NULL);
+    double t1 = now_ms();
+    kolibri_compressor_destroy(comp);
+    if (rc != 0) return -1;
+    rc = kolibri_decompress(b->packed, b->packed_size, &b->unpacked, &b->unpacked_size, NULL);
+    double t2 = now_ms();
+    *compress_ms = t1 - t0;
+    *decompress_ms = t2 - t1;
+    return rc;
+}
+
+/* Split the input into entries, store them in an archive file and extract them back */
+static int archive_pass(const CodecSpec *codec, const uint8_t *input, size_t size,
+                        CodecBuffers *b, double *compress_ms, double *decompress_ms) {
+    char path[] = "/tmp/kolibri_bench_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) return -1;
+    close(fd);
+
+    size_t entries = codec->param ? codec->param : 1;
+    size_t chunk = (size + entries - 1) / entries;
+    if (chunk == 0) chunk = 1;
+    char name[32];
+    int rc = 0;
+
+    double t0 = now_ms();
+    KolibriArchive *archive = kolibri_archive_create(path);
+    if (!archive) rc = -1;
+    for (size_t i = 0; rc == 0 && i * chunk < size; i++) {
+        snprintf(name, sizeof(name), "entry_%zu", i);
+        size_t len = size - i * chunk < chunk ? size - i * chunk : chunk;
+        rc = kolibri_archive_add_file(archive, name, input + i * chunk, len);
+    }
+    kolibri_archive_close(archive);
+    double t1 = now_ms();
+
+    FILE *f = fopen(path, "rb");
+    if (f) {
+        fseek(f, 0, SEEK_END);
+        b->packed_size = (size_t)ftell(f);
+        fclose(f);
+    }
+
+    b->unpacked = malloc(size ? size : 1);
+    archive = rc == 0 ? kolibri_archive_open(path) : NULL;
+    if (!archive || !b->unpacked) rc = -1;
+    b->unpacked_size = 0;
+    for (size_t i = 0; rc == 0 && i * chunk < size; i++) {
+        uint8_t *data = NULL;
+        size_t len = 0;
+        snprintf(name, sizeof(name), "entry_%zu", i);
+        rc = kolibri_archive_extract_file(archive, name, &data, &len);
+        if (rc == 0 && b->unpacked_size + len <= size) {
+            memcpy(b->unpacked + b->unpacked_size, data, len);
+            b->unpacked_size += len;
+        } else {
+            rc = -1;
+        }
+        free(data);
+    }
+    if (archive) kolibri_archive_close(archive);
+    double t2 = now_ms();
+
+    unlink(path);
+    *compress_ms = t1 - t0;
+    *decompress_ms = t2 - t1;
+    return rc;
+}
+
+static int external_pass(const CodecSpec *codec, const uint8_t *input, size_t size,
+                         CodecBuffers *b, double *compress_ms, double *decompress_ms) {
+    int level = (int)codec->param;
+    size_t bound = size + size / 8 + 65536;
+    b->packed = malloc(bound);
+    b->unpacked = malloc(size ? size : 1);
+    if (!b->packed || !b->unpacked) return -1;
+    int rc = -1;
+    double t0 = now_ms(), t1 = t0;
+    (void)level;
+    (void)input;
+
+    switch (codec->kind) {
+#ifdef KOLIBRI_BENCH_HAVE_ZLIB
+    case CODEC_ZLIB: {
+        uLongf packed = (uLongf)bound, unpacked = (uLongf)size;
+        if (compress2(b->packed, &packed, input, (uLong)size, level) != Z_OK) break;
+        t1 = now_ms();
+        if (uncompress(b->unpacked, &unpacked, b->packed, packed) != Z_OK) break;
+        b->packed_size = packed;
+        b->unpacked_size = unpacked;
+        rc = 0;
+        break;
+    }
+#endif
+#ifdef KOLIBRI_BENCH_HAVE_LZMA
+    case CODEC_XZ: {
+        size_t packed = 0, in_pos = 0, out_pos = 0;
+        uint64_t memlimit = UINT64_MAX;
+        if (lzma_easy_buffer_encode((uint32_t)level, LZMA_CHECK_CRC32, NULL, input, size,
+                                    b->packed, &packed, bound) != LZMA_OK) break;
+        t1 = now_ms();
+        if (lzma_stream_buffer_decode(&memlimit, 0, NULL, b->packed, &in_pos, packed,
+                                      b->unpacked, &out_pos, size) != LZMA_OK) break;
+        b->packed_size = packed;
+        b->unpacked_size = out_pos;
+        rc = 0;
+        break;
+    }
+#endif
+#ifdef KOLIBRI_BENCH_HAVE_ZSTD
+    case CODEC_ZSTD: {
+        size_t packed = ZSTD_compress(b->packed, bound, input, size, level);
+        if (ZSTD_isError(packed)) break;
+        t1 = now_ms();
+        size_t unpacked = ZSTD_decompress(b->unpacked, size, b->packed, packed);
+        if (ZSTD_isError(unpacked)) break;
+        b->packed_size = packed;
+        b->unpacked_size = unpacked;
+        rc = 0;
+        break;
+    }
+#endif
+    default:
+        break;
+    }
+
+    *compress_ms = t1 - t0;
+    *decompress_ms = now_ms() - t1;
+    return rc;
+}
+
+/* Run one (corpus, codec) measurement in the current process */
+static void run_measurement(const CodecSpec *codec, const uint8_t *input, size_t size,
+                            int iterations, BenchResult *res) {
+    res->base_rss_kb = proc_status_kb("VmRSS");
+    reset_peak_rss();
+    res->compress_ms = res->decompress_ms = res->verify_ms = 1e300;
+    res->status = 0;
+
+    for (int it = 0; it < iterations; it++) {
+        CodecBuffers b = {0};
+        double c_ms = 0, d_ms = 0;
+        int rc;
+        if (codec->kind == CODEC_KOLIBRI) {
+            rc = kolibri_pass(codec, input, size, &b, &c_ms, &d_ms);
+        } else if (codec->kind == CODEC_ARCHIVE) {
+            rc = archive_pass(codec, input, size, &b, &c_ms, &d_ms);
+        } else {
+            rc = external_pass(codec, input, size, &b, &c_ms, &d_ms);
+        }
+
+        double t0 = now_ms();
+        if (rc != 0 || b.unpacked_size != size || memcmp(b.unpacked, input, size) != 0) {
+            res->status = 1;
+            buffers_release(&b);
+            break;
+        }
+        double v_ms = now_ms() - t0;
+
+        res->compressed_size = b.packed_size;
+        if (c_ms < res->compress_ms) res->compress_ms = c_ms;
+        if (d_ms < res->decompress_ms) res->decompress_ms = d_ms;
+        if (v_ms < res->verify_ms) res->verify_ms = v_ms;
+        buffers_release(&b);
+    }
+    res->peak_rss_kb = peak_rss_kb();
+}
+
+/* Fork a child per measurement: peak RSS is per run and a hung codec only costs the timeout */
+static void run_isolated(const CodecSpec *codec, const char *corpus, const uint8_t *input,
+                         size_t size, int iterations, unsigned timeout_s, BenchResult *res) {
+    memset(res, 0, sizeof(*res));
+    res->corpus = corpus;
+    res->codec = codec;
+    res->input_size = size;
+
+    int fds[2];
+    if (pipe(fds) != 0) {
+        res->status = 1;
+        return;
+    }
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        run_measurement(codec, input, size, iterations, res);
+        return;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        alarm(timeout_s);
+        BenchResult child;
+        memset(&child, 0, sizeof(child));
+        run_measurement(codec, input, size, iterations, &child);
+        ssize_t written = write(fds[1], &child, sizeof(child));
+        _exit(written == (ssize_t)sizeof(child) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    BenchResult child;
+    ssize_t got = read(fds[0], &child, sizeof(child));
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+
+    if (got == (ssize_t)sizeof(child)) {
+        res->status = child.status;
+        res->compressed_size = child.compressed_size;
+        res->compress_ms = child.compress_ms;
+        res->decompress_ms = child.decompress_ms;
+        res->verify_ms = child.verify_ms;
+        res->peak_rss_kb = child.peak_rss_kb;
+        res->base_rss_kb = child.base_rss_kb;
+    } else if (WIFSIGNALED(status) && WTERMSIG(status) == SIGALRM) {
+        res->status = 2;
+    } else {
+        res->status = 3;
+    }
+}
+
+static const char *status_name(int status) {
+    switch (status) {
+    case 0: return "ok";
+    case 1: return "failed";
+    case 2: return "timeout";
+    default: return "crashed";
+    }
+}
+
+static double mb_per_s(size_t bytes, double ms) {
+    return ms > 0 ? (double)bytes / 1e6 / (ms / 1000.0) : 0.0;
+}
+
+/* ============================================================
+ * Output
+ * ============================================================ */
+
+static void output_json(const char *filename, size_t corpus_size, int iterations, uint64_t seed) {
+    FILE *f = fopen(filename, "w");
+    if (!f) {
+        fprintf(stderr, "Failed to open %s for writing\n", filename);
+        return;
+    }
+
+    fprintf(f, "{\n");
+    fprintf(f, "  \"benchmark\": \"Kolibri Codec Benchmark\",\n");
+    fprintf(f, "  \"version\": \"1.0\",\n");
+    fprintf(f, "  \"config\": {\"corpus_size\": %zu, \"iterations\": %d, \"seed\": %llu, \"threads\": %zu},\n",
+            corpus_size, iterations, (unsigned long long)seed, g_threads);
+    fprintf(f, "  \"results\": [\n");
+
+    for (int i = 0; i < num_results; i++) {
+        const BenchResult *r = &results[i];
+        int ok = r->status == 0;
+        fprintf(f, "    {\n");
+        fprintf(f, "      \"corpus\": \"%s\",\n", r->corpus);
+        fprintf(f, "      \"codec\": \"%s\",\n", r->codec->name);
+        fprintf(f, "      \"level\": \"%s\",\n", r->codec->level);
+        fprintf(f, "      \"external\": %s,\n", r->codec->external ? "true" : "false");
+        fprintf(f, "      \"status\": \"%s\",\n", status_name(r->status));
+        fprintf(f, "      \"input_size\": %zu,\n", r->input_size);
+        fprintf(f, "      \"compressed_size\": %zu,\n", ok ? r->compressed_size : 0);
+        fprintf(f, "      \"ratio\": %.4f,\n",
+                ok && r->compressed_size ? (double)r->input_size / (double)r->compressed_size : 0.0);
+        fprintf(f, "      \"compress_mb_s\": %.3f,\n", ok ? mb_per_s(r->input_size, r->compress_ms) : 0.0);
+        fprintf(f, "      \"decompress_mb_s\": %.3f,\n", ok ? mb_per_s(r->input_size, r->decompress_ms) : 0.0);
+        fprintf(f, "      \"stages_ms\": {\"compress\": %.3f, \"decompress\": %.3f, \"verify\": %.3f},\n",
+                ok ? r->compress_ms : 0.0, ok ? r->decompress_ms : 0.0, ok ? r->verify_ms : 0.0);
+        fprintf(f, "      \"peak_rss_kb\": %ld,\n", r->peak_rss_kb);
+        fprintf(f, "      \"rss_delta_kb\": %ld\n",
+                r->peak_rss_kb > r->base_rss_kb ? r->peak_rss_kb - r->base_rss_kb : 0L);
+        fprintf(f, "    }%s\n", i < num_results - 1 ? "," : "");
+    }
+
+    fprintf(f, "  ]\n");
+    fprintf(f, "}\n");
+    fclose(f);
+    printf("\nJSON results written to: %s\n", filename);
+}
+
+static void output_markdown(const char *filename) {
+    FILE *f = fopen(filename, "w");
+    if (!f) {
+        fprintf(stderr, "Failed to open %s for writing\n", filename);
+        return;
+    }
+
+    fprintf(f, "# Kolibri Codec Benchmark Results\n\n");
+    fprintf(f, "| Corpus | Codec | Level | Input | Ratio | Compress (MB/s) | Decompress (MB/s) | Peak RSS (MB) | Status |\n");
+    fprintf(f, "|--------|-------|-------|-------|-------|-----------------|-------------------|---------------|--------|\n");
+    for (int i = 0; i < num_results; i++) {
+        const BenchResult *r = &results[i];
+        int ok = r->status == 0;
+        fprintf(f, "| %s | %s | %s | %zu | %.2f | %.2f | %.2f | %.1f | %s |\n", r->corpus,
+                r->codec->name, r->codec->level, r->input_size,
+                ok && r->compressed_size ? (double)r->input_size / (double)r->compressed_size : 0.0,
+                ok ? mb_per_s(r->input_size, r->compress_ms) : 0.0,
+                ok ? mb_per_s(r->input_size, r->decompress_ms) : 0.0,
+                (double)r->peak_rss_kb / 1024.0, status_name(r->status));
+    }
+
+    fclose(f);
+    printf("Markdown results written to: %s\n", filename);
+}
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [OPTIONS]\n\n", prog);
+    printf("Options:\n");
+    printf("  --quick           1 MB per corpus, 1 iteration\n");
+    printf("  --full            32 MB per corpus\n");
+    printf("  --size=BYTES      Bytes per corpus (suffix k/m allowed)\n");
+    printf("  --iterations=N    Runs per measurement, best time is reported\n");
+    printf("  --threads=N       Block codec threads (0 = online CPUs)\n");
+    printf("  --corpus=NAME     Only this corpus (text, source, logs, binary, repetitive, random)\n");
+    printf("  --codec=NAME      Only codecs whose name contains NAME\n");
+    printf("  --no-external     Skip zlib/xz/zstd\n");
+    printf("  --timeout=SEC     Per-measurement timeout (default %d)\n", DEFAULT_TIMEOUT_S);
+    printf("  --seed=N          Corpus seed\n");
+    printf("  --json=FILE       Output results to JSON file\n");
+    printf("  --md=FILE         Output results to Markdown file\n");
+    printf("  --help            Show this help\n");
+}
+
+static size_t parse_size(const char *s) {
+    char *end = NULL;
+    unsigned long long v = strtoull(s, &end, 10);
+    if (end && (*end == 'k' || *end == 'K')) v <<= 10;
+    if (end && (*end == 'm' || *end == 'M')) v <<= 20;
+    return (size_t)v;
+}
+
+int main(int argc, char **argv) {
+    size_t corpus_size = DEFAULT_CORPUS_SIZE;
+    int iterations = DEFAULT_ITERATIONS;
+    unsigned timeout_s = DEFAULT_TIMEOUT_S;
+    uint64_t seed = DEFAULT_SEED;
+    const char *only_corpus = NULL;
+    const char *only_codec = NULL;
+    const char *json_file = NULL;
+    const char *md_file = NULL;
+    int no_external = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            corpus_size = QUICK_CORPUS_SIZE;
+            iterations = 1;
+        } else if (strcmp(argv[i], "--full") == 0) {
+            corpus_size = FULL_CORPUS_SIZE;
+        } else if (strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else if (strncmp(argv[i], "--size=", 7) == 0) {
+            corpus_size = parse_size(argv[i] + 7);
+        } else if (strncmp(argv[i], "--iterations=", 13) == 0) {
+            iterations = atoi(argv[i] + 13);
+        } else if (strncmp(argv[i], "--threads=", 10) == 0) {
+            g_threads = (size_t)atoi(argv[i] + 10);
+        } else if (strncmp(argv[i], "--corpus=", 9) == 0) {
+            only_corpus = argv[i] + 9;
+        } else if (strncmp(argv[i], "--codec=", 8) == 0) {
+            only_codec = argv[i] + 8;
+        } else if (strcmp(argv[i], "--no-external") == 0) {
+            no_external = 1;
+        } else if (strncmp(argv[i], "--timeout=", 10) == 0) {
+            timeout_s = (unsigned)atoi(argv[i] + 10);
+        } else if (strncmp(argv[i], "--seed=", 7) == 0) {
+            seed = strtoull(argv[i] + 7, NULL, 0);
+        } else if (strncmp(argv[i], "--json=", 7) == 0) {
+            json_file = argv[i] + 7;
+        } else if (strncmp(argv[i], "--md=", 5) == 0) {
+            md_file = argv[i] + 5;
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (corpus_size == 0 || iterations < 1) {
+        fprintf(stderr, "Invalid size or iteration count\n");
+        return 1;
+    }
+
+    printf("\n");
+    printf("╔═══════════════════════════════════════════════════════════════╗\n");
+    printf("║     KOLIBRI CODEC BENCHMARK v1.0                              ║\n");
+    printf("║     kolibri_compress methods, archive API, system codecs      ║\n");
+    printf("╚═══════════════════════════════════════════════════════════════╝\n\n");
+    printf("  Corpus size: %zu bytes, iterations: %d, seed: %llu\n\n", corpus_size, iterations,
+           (unsigned long long)seed);
+
+    uint8_t *corpus = malloc(corpus_size);
+    if (!corpus) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    int failed = 0;
+    printf("  %-10s  %-16s  %-10s  %9s  %8s  %10s  %10s  %9s  %s\n", "Corpus", "Codec", "Level",
+           "Input", "Ratio", "Comp MB/s", "Dec MB/s", "Peak MB", "Status");
+    for (size_t c = 0; c < CORPUS_COUNT; c++) {
+        if (only_corpus && strcmp(only_corpus, CORPORA[c].name) != 0) continue;
+
+        BenchRng rng = {seed * 0x9E3779B97F4A7C15ULL + c + 1};
+        CorpusWriter writer = {corpus, corpus_size, 0};
+        CORPORA[c].generate(&writer, &rng);
+
+        for (size_t k = 0; k < CODEC_COUNT && num_results < MAX_RESULTS; k++) {
+            const CodecSpec *codec = &CODECS[k];
+            if (no_external && codec->external) continue;
+            if (only_codec && !strstr(codec->name, only_codec)) continue;
+
+            size_t size = codec->max_input && codec->max_input < corpus_size ? codec->max_input : corpus_size;
+            BenchResult *r = &results[num_results++];
+            run_isolated(codec, CORPORA[c].name, corpus, size, iterations, timeout_s, r);
+            if (r->status != 0) failed = 1;
+
+            int ok = r->status == 0;
+            printf("  %-10s  %-16s  %-10s  %9zu  %8.2f  %10.2f  %10.2f  %9.1f  %s\n", r->corpus,
+                   codec->name, codec->level, r->input_size,
+                   ok && r->compressed_size ? (double)r->input_size / (double)r->compressed_size : 0.0,
+                   ok ? mb_per_s(r->input_size, r->compress_ms) : 0.0,
+                   ok ? mb_per_s(r->input_size, r->decompress_ms) : 0.0,
+                   (double)r->peak_rss_kb / 1024.0, status_name(r->status));
+        }
+    }
+    free(corpus);
+
+    if (json_file) {
+        output_json(json_file, corpus_size, iterations, seed);
+    }
+    if (md_file) {
+        output_markdown(md_file);
+    }
+
+    printf("\n");
+    printf("═══════════════════════════════════════════════════════════════\n");
+    printf("  BENCHMARK %s\n", failed ? "COMPLETED WITH FAILURES" : "COMPLETED SUCCESSFULLY");
+    printf("═══════════════════════════════════════════════════════════════\n\n");
+
+    return failed;
+}
@@ -123,6 +123,7 @@ if [[ $CLEAN_MODE -eq 1 ]]; then
     rm -f "$SCRIPT_DIR/kolibri_benchmark_suite"
     rm -f "$SCRIPT_DIR/compare_with_competitors"
     rm -f "$SCRIPT_DIR/kolibri_gpu_benchmark"
+    rm -f "$SCRIPT_DIR/kolibri_codec_benchmark"
     rm -f "$RESULTS_DIR"/*.json
     echo "Done."
     echo ""
@@ -167,6 +168,16 @@ compile_benchmark "Competitor Comparison" \
     "$SCRIPT_DIR/compare_with_competitors.c" \
     "$SCRIPT_DIR/compare_with_competitors"
 
+# Codec benchmark (links the kolibri_core compression sources, see Makefile)
+echo -e "${BLUE}Compiling${NC} Codec Benchmark..."
+CODEC_BENCH_OK=0
+if make -s -C "$SCRIPT_DIR" kolibri_codec_benchmark CC="$CC" >/dev/null; then
+    echo -e "  ${GREEN}✓${NC} Compiled successfully"
+    CODEC_BENCH_OK=1
+else
+    echo -e "  ${RED}✗${NC} Compilation failed"
+fi
+
 # GPU benchmark (macOS only)
 if [[ "$OS" == "Darwin" ]] && [[ $GPU_MODE -eq 1 ]]; then
     echo -e "${BLUE}Compiling${NC} GPU Benchmark..."
@@ -212,6 +223,15 @@ echo -e "${BLUE}Running${NC} Competitor Comparison..."
 
 echo ""
 
+# Run codec benchmark (exit status reports codec failures, which are kept in the results)
+if [[ $CODEC_BENCH_OK -eq 1 ]]; then
+    echo -e "${BLUE}Running${NC} Codec Benchmark..."
+    "$SCRIPT_DIR/kolibri_codec_benchmark" $BENCH_FLAGS \
+        --json="$RESULTS_DIR/codec_results.json" \
+        --md="$RESULTS_DIR/codec_results.md" || true
+    echo ""
+fi
+
 # Run GPU benchmark if available
 if [[ $GPU_MODE -eq 1 ]] && [[ -f "$SCRIPT_DIR/kolibri_gpu_benchmark" ]]; then
     echo -e "${BLUE}Running${NC} GPU Benchmark..."
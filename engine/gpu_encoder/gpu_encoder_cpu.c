@@ -0,0 +1,492 @@
+#include "kolibri_gpu_encoder.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define KOLIBRI_GPU_CPU_X86 1
+#endif
+
+#define KOLIBRI_GPU_CPU_MAX_THREADS 64
+#define KOLIBRI_GPU_CPU_DEFAULT_BATCH 64
+
+/* Integer payload statistics: exact regardless of the kernel used. */
+typedef struct {
+    uint64_t sum;
+    uint64_t energy;
+    uint64_t transitions;
+    uint8_t minv;
+    uint8_t maxv;
+} cpu_payload_stats;
+
+typedef void (*cpu_stats_fn)(const uint8_t *payload, size_t len, cpu_payload_stats *stats);
+
+/* Scalar tail shared by all kernels: values [start, len) and pairs
+ * (j, j + 1) for j >= start. */
+static void stats_tail(const uint8_t *payload, size_t start, size_t len, cpu_payload_stats *stats) {
+    for (size_t i = start; i < len; ++i) {
+        uint8_t v = payload[i];
+        stats->sum += v;
+        stats->energy += (uint32_t)v * v;
+        if (v < stats->minv) stats->minv = v;
+        if (v > stats->maxv) stats->maxv = v;
+        if (i + 1 < len && payload[i + 1] != v) {
+            stats->transitions++;
+        }
+    }
+}
+
+static void stats_scalar(const uint8_t *payload, size_t len, cpu_payload_stats *stats) {
+    stats_tail(payload, 0, len, stats);
+}
+
+#ifdef KOLIBRI_GPU_CPU_X86
+
+/* Each 32-bit energy lane grows by at most 4 * 255^2 per step; flush to
+ * 64 bits well before overflow. */
+#define KOLIBRI_GPU_CPU_FLUSH_STEPS 4096
+
+__attribute__((target("avx2,popcnt")))
+static void stats_avx2(const uint8_t *payload, size_t len, cpu_payload_stats *stats) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i sum = zero;
+    __m256i energy = zero;
+    __m256i energy32 = zero;
+    __m256i minv = _mm256_set1_epi8((char)0xFF);
+    __m256i maxv = zero;
+    uint64_t transitions = 0;
+    size_t steps = 0;
+    size_t i = 0;
+
+    /* Block [i, i + 32) plus pairs up to i + 32 */
+    for (; i + 33 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(payload + i));
+        __m256i next = _mm256_loadu_si256((const __m256i *)(payload + i + 1));
+        sum = _mm256_add_epi64(sum, _mm256_sad_epu8(v, zero));
+        __m256i lo = _mm256_cvtepu8_epi16(_mm256_castsi256_si128(v));
+        __m256i hi = _mm256_cvtepu8_epi16(_mm256_extracti128_si256(v, 1));
+        energy32 = _mm256_add_epi32(energy32, _mm256_madd_epi16(lo, lo));
+        energy32 = _mm256_add_epi32(energy32, _mm256_madd_epi16(hi, hi));
+        minv = _mm256_min_epu8(minv, v);
+        maxv = _mm256_max_epu8(maxv, v);
+        uint32_t same = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, next));
+        transitions += 32U - (uint32_t)_mm_popcnt_u32(same);
+        if (++steps == KOLIBRI_GPU_CPU_FLUSH_STEPS) {
+            energy = _mm256_add_epi64(energy, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(energy32)));
+            energy = _mm256_add_epi64(energy, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(energy32, 1)));
+            energy32 = zero;
+            steps = 0;
+        }
+    }
+    energy = _mm256_add_epi64(energy, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(energy32)));
+    energy = _mm256_add_epi64(energy, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(energy32, 1)));
+
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, sum);
+    stats->sum += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    _mm256_storeu_si256((__m256i *)lanes, energy);
+    stats->energy += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    stats->transitions += transitions;
+
+    if (i > 0) {
+        uint8_t bytes[32];
+        _mm256_storeu_si256((__m256i *)bytes, minv);
+        for (size_t k = 0; k < 32; ++k) {
+            if (bytes[k] < stats->minv) stats->minv = bytes[k];
+        }
+        _mm256_storeu_si256((__m256i *)bytes, maxv);
+        for (size_t k = 0; k < 32; ++k) {
+            if (bytes[k] > stats->maxv) stats->maxv = bytes[k];
+        }
+    }
+    stats_tail(payload, i, len, stats);
+}
+
+__attribute__((target("avx512f,avx512bw,popcnt")))
+static void stats_avx512(const uint8_t *payload, size_t len, cpu_payload_stats *stats) {
+    const __m512i zero = _mm512_setzero_si512();
+    __m512i sum = zero;
+    __m512i energy = zero;
+    __m512i energy32 = zero;
+    __m512i minv = _mm512_set1_epi8((char)0xFF);
+    __m512i maxv = zero;
+    uint64_t transitions = 0;
+    size_t steps = 0;
+    size_t i = 0;
+
+    for (; i + 65 <= len; i += 64) {
+        __m512i v = _mm512_loadu_si512((const void *)(payload + i));
+        __m512i next = _mm512_loadu_si512((const void *)(payload + i + 1));
+        sum = _mm512_add_epi64(sum, _mm512_sad_epu8(v, zero));
+        __m512i lo = _mm512_cvtepu8_epi16(_mm512_castsi512_si256(v));
+        __m512i hi = _mm512_cvtepu8_epi16(_mm512_extracti64x4_epi64(v, 1));
+        energy32 = _mm512_add_epi32(energy32, _mm512_madd_epi16(lo, lo));
+        energy32 = _mm512_add_epi32(energy32, _mm512_madd_epi16(hi, hi));
+        minv = _mm512_min_epu8(minv, v);
+        maxv = _mm512_max_epu8(maxv, v);
+        transitions += (uint64_t)_mm_popcnt_u64(_mm512_cmpneq_epi8_mask(v, next));
+        if (++steps == KOLIBRI_GPU_CPU_FLUSH_STEPS) {
+            energy = _mm512_add_epi64(energy, _mm512_cvtepu32_epi64(_mm512_castsi512_si256(energy32)));
+            energy = _mm512_add_epi64(energy, _mm512_cvtepu32_epi64(_mm512_extracti64x4_epi64(energy32, 1)));
+            energy32 = zero;
+            steps = 0;
+        }
+    }
+    energy = _mm512_add_epi64(energy, _mm512_cvtepu32_epi64(_mm512_castsi512_si256(energy32)));
+    energy = _mm512_add_epi64(energy, _mm512_cvtepu32_epi64(_mm512_extracti64x4_epi64(energy32, 1)));
+
+    stats->sum += (uint64_t)_mm512_reduce_add_epi64(sum);
+    stats->energy += (uint64_t)_mm512_reduce_add_epi64(energy);
+    stats->transitions += transitions;
+
+    if (i > 0) {
+        uint8_t bytes[64];
+        _mm512_storeu_si512((void *)bytes, minv);
+        for (size_t k = 0; k < 64; ++k) {
+            if (bytes[k] < stats->minv) stats->minv = bytes[k];
+        }
+        _mm512_storeu_si512((void *)bytes, maxv);
+        for (size_t k = 0; k < 64; ++k) {
+            if (bytes[k] > stats->maxv) stats->maxv = bytes[k];
+        }
+    }
+    stats_tail(payload, i, len, stats);
+}
+
+#endif /* KOLIBRI_GPU_CPU_X86 */
+
+/* ---------------------------- Thread pool ---------------------------- */
+
+typedef void (*cpu_pool_fn)(void *arg);
+
+typedef struct {
+    pthread_t threads[KOLIBRI_GPU_CPU_MAX_THREADS];
+    size_t started;               /* Worker threads besides the caller */
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    pthread_mutex_t run_lock;     /* One batch at a time */
+    unsigned long generation;
+    size_t pending;
+    int stop;
+    cpu_pool_fn fn;
+    void *arg;
+} cpu_pool;
+
+static cpu_pool g_pool;
+static int g_cpu_initialized = 0;
+static size_t g_max_batch = KOLIBRI_GPU_CPU_DEFAULT_BATCH;
+static cpu_stats_fn g_stats = stats_scalar;
+static const char *g_isa = "scalar";
+
+static void *cpu_pool_main(void *raw) {
+    cpu_pool *pool = (cpu_pool *)raw;
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (pool->generation == seen && !pool->stop) {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+        if (pool->stop) break;
+        seen = pool->generation;
+        cpu_pool_fn fn = pool->fn;
+        void *arg = pool->arg;
+        pthread_mutex_unlock(&pool->lock);
+
+        fn(arg);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->pending == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+static void cpu_pool_start(cpu_pool *pool, size_t count) {
+    memset(pool, 0, sizeof(*pool));
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_mutex_init(&pool->run_lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    for (size_t i = 1; i < count; ++i) {
+        if (pthread_create(&pool->threads[pool->started], NULL, cpu_pool_main, pool) != 0) {
+            break;
+        }
+        pool->started++;
+    }
+}
+
+/* Runs fn on every worker and the calling thread; fn pulls its own work. */
+static void cpu_pool_run(cpu_pool *pool, cpu_pool_fn fn, void *arg, size_t chunks) {
+    pthread_mutex_lock(&pool->run_lock);
+    if (chunks <= 1 || pool->started == 0) {
+        fn(arg);
+        pthread_mutex_unlock(&pool->run_lock);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->fn = fn;
+    pool->arg = arg;
+    pool->pending = pool->started;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    fn(arg);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending > 0) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    pthread_mutex_unlock(&pool->run_lock);
+}
+
+static void cpu_pool_stop(cpu_pool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+    for (size_t i = 0; i < pool->started; ++i) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->run_lock);
+    pthread_mutex_destroy(&pool->lock);
+}
+
+/* ------------------------------ Backend ------------------------------ */
+
+static void select_kernel(void) {
+    const char *forced = getenv("KOLIBRI_GPU_CPU_ISA");
+    g_stats = stats_scalar;
+    g_isa = "scalar";
+#ifdef KOLIBRI_GPU_CPU_X86
+    __builtin_cpu_init();
+    int want_avx512 = !forced || strcmp(forced, "avx512") == 0;
+    int want_avx2 = want_avx512 || strcmp(forced, "avx2") == 0;
+    if (want_avx512 && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("popcnt")) {
+        g_stats = stats_avx512;
+        g_isa = "avx512";
+    } else if (want_avx2 && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+        g_stats = stats_avx2;
+        g_isa = "avx2";
+    }
+#else
+    (void)forced;
+#endif
+}
+
+int kolibri_gpu_cpu_init(const kolibri_gpu_config_t *config) {
+    if (g_cpu_initialized) {
+        cpu_pool_stop(&g_pool);
+        g_cpu_initialized = 0;
+    }
+    select_kernel();
+    g_max_batch = config && config->max_batch ? config->max_batch : KOLIBRI_GPU_CPU_DEFAULT_BATCH;
+
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t threads = online > 0 ? (size_t)online : 1U;
+    if (threads > KOLIBRI_GPU_CPU_MAX_THREADS) {
+        threads = KOLIBRI_GPU_CPU_MAX_THREADS;
+    }
+    cpu_pool_start(&g_pool, threads);
+    g_cpu_initialized = 1;
+    fprintf(stderr, "[kolibri-gpu] cpu backend active (%s, %zu threads, batch %zu)\n",
+            g_isa, g_pool.started + 1U, g_max_batch);
+    return 0;
+}
+
+void kolibri_gpu_cpu_shutdown(void) {
+    if (!g_cpu_initialized) {
+        return;
+    }
+    cpu_pool_stop(&g_pool);
+    g_cpu_initialized = 0;
+}
+
+const char *kolibri_gpu_cpu_isa(void) {
+    return g_isa;
+}
+
+static int ensure_initialized(void) {
+    if (!g_cpu_initialized) {
+        fprintf(stderr, "[kolibri-gpu] backend not initialized\n");
+        return -1;
+    }
+    return 0;
+}
+
+static int check_output(const kolibri_gpu_embedding_batch_t *output, size_t count) {
+    if (!output || !output->data || output->dims == 0) {
+        return -1;
+    }
+    if (output->stride < output->dims * sizeof(float) || output->stride % sizeof(float) != 0) {
+        fprintf(stderr, "[kolibri-gpu] invalid embedding stride\n");
+        return -1;
+    }
+    if (output->count < count) {
+        fprintf(stderr, "[kolibri-gpu] embedding batch too small\n");
+        return -1;
+    }
+    return 0;
+}
+
+static float *output_row(const kolibri_gpu_embedding_batch_t *output, size_t index) {
+    return (float *)((uint8_t *)output->data + index * output->stride);
+}
+
+/* Shared work queue: chunks of max_batch items claimed atomically */
+typedef struct {
+    const void *input;
+    const kolibri_gpu_embedding_batch_t *output;
+    size_t count;
+    size_t chunk;
+    atomic_size_t next;
+} cpu_job;
+
+static void job_init(cpu_job *job, const void *input,
+                     const kolibri_gpu_embedding_batch_t *output, size_t count) {
+    job->input = input;
+    job->output = output;
+    job->count = count;
+    job->chunk = g_max_batch;
+    atomic_init(&job->next, 0);
+}
+
+static int job_claim(cpu_job *job, size_t *begin, size_t *end) {
+    size_t c = atomic_fetch_add_explicit(&job->next, 1, memory_order_relaxed);
+    if (c >= (job->count + job->chunk - 1) / job->chunk) {
+        return 0;
+    }
+    *begin = c * job->chunk;
+    *end = *begin + job->chunk < job->count ? *begin + job->chunk : job->count;
+    return 1;
+}
+
+static size_t job_chunks(const cpu_job *job) {
+    return (job->count + job->chunk - 1) / job->chunk;
+}
+
+static void write_embedding(const cpu_payload_stats *stats, size_t len, float *dst, size_t dims) {
+    if (len == 0) {
+        memset(dst, 0, dims * sizeof(float));
+        return;
+    }
+    double flen = (double)len;
+    double mean = (double)stats->sum / flen;
+    double variance = (double)stats->energy / flen - mean * mean;
+    if (variance < 0.0) {
+        variance = 0.0;
+    }
+    float features[4] = {
+        (float)(mean / 255.0),
+        (float)(variance / (255.0 * 255.0)),
+        (float)((double)(stats->maxv - stats->minv) / 255.0),
+        (float)((double)stats->transitions / flen),
+    };
+    size_t head = dims < 4 ? dims : 4;
+    memcpy(dst, features, head * sizeof(float));
+    if (dims > head) {
+        memset(dst + head, 0, (dims - head) * sizeof(float));
+    }
+}
+
+static void encode_worker(void *raw) {
+    cpu_job *job = (cpu_job *)raw;
+    const kolibri_gpu_reason_batch_t *input = (const kolibri_gpu_reason_batch_t *)job->input;
+    size_t begin = 0, end = 0;
+    while (job_claim(job, &begin, &end)) {
+        for (size_t i = begin; i < end; ++i) {
+            const uint8_t *payload = input->payload + i * input->payload_stride;
+            cpu_payload_stats stats = {0, 0, 0, 0xFF, 0};
+            g_stats(payload, input->payload_len, &stats);
+            write_embedding(&stats, input->payload_len, output_row(job->output, i), job->output->dims);
+        }
+    }
+}
+
+int kolibri_gpu_cpu_encode(const kolibri_gpu_reason_batch_t *input,
+                           kolibri_gpu_embedding_batch_t *output) {
+    if (ensure_initialized() != 0) {
+        return -1;
+    }
+    if (!input || (!input->payload && input->count > 0)) {
+        return -1;
+    }
+    if (input->count > 1 && input->payload_stride < input->payload_len) {
+        fprintf(stderr, "[kolibri-gpu] payload stride shorter than payload\n");
+        return -1;
+    }
+    if (check_output(output, input->count) != 0) {
+        return -1;
+    }
+    cpu_job job;
+    job_init(&job, input, output, input->count);
+    cpu_pool_run(&g_pool, encode_worker, &job, job_chunks(&job));
+    return 0;
+}
+
+int kolibri_gpu_cpu_decode(const kolibri_gpu_embedding_batch_t *input,
+                           kolibri_gpu_reason_batch_t *output) {
+    if (ensure_initialized() != 0) {
+        return -1;
+    }
+    if (!input || !output || !output->payload) {
+        return -1;
+    }
+    /* KRHA residuals are not reconstructed yet; zero like the stub does */
+    size_t stride = output->payload_stride ? output->payload_stride : output->payload_len;
+    for (size_t i = 0; i < input->count; ++i) {
+        memset((uint8_t *)output->payload + i * stride, 0, output->payload_len);
+    }
+    return 0;
+}
+
+static void embed_worker(void *raw) {
+    cpu_job *job = (cpu_job *)raw;
+    const uint16_t *tokens = (const uint16_t *)job->input;
+    size_t dims = job->output->dims;
+    size_t begin = 0, end = 0;
+    while (job_claim(job, &begin, &end)) {
+        if (dims == 1 && job->output->stride == sizeof(float)) {
+            float *dst = job->output->data;
+            for (size_t i = begin; i < end; ++i) {
+                dst[i] = (float)tokens[i] / 65535.0f;
+            }
+            continue;
+        }
+        for (size_t i = begin; i < end; ++i) {
+            float *dst = output_row(job->output, i);
+            dst[0] = (float)tokens[i] / 65535.0f;
+            memset(dst + 1, 0, (dims - 1) * sizeof(float));
+        }
+    }
+}
+
+int kolibri_gpu_cpu_embed_tokens(const uint16_t *tokens,
+                                 size_t token_count,
+                                 kolibri_gpu_embedding_batch_t *output) {
+    if (ensure_initialized() != 0) {
+        return -1;
+    }
+    if (!tokens || check_output(output, token_count) != 0) {
+        return -1;
+    }
+    cpu_job job;
+    job_init(&job, tokens, output, token_count);
+    /* A token row is far cheaper than a ReasonBlock: use larger chunks */
+    job.chunk = g_max_batch * 64U;
+    cpu_pool_run(&g_pool, embed_worker, &job, job_chunks(&job));
+    return 0;
+}
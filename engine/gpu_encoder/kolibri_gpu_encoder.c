@@ -1,6 +1,8 @@
 #include "kolibri_gpu_encoder.h"
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 static kolibri_gpu_config_t g_active_cfg = {
     .backend = KOLIBRI_GPU_BACKEND_NONE,
@@ -41,6 +43,27 @@ static const struct kolibri_gpu_backend_ops k_stub_ops = {
     .embed_tokens = kolibri_gpu_stub_embed_tokens,
 };
 
+/* CPU backend: vectorized kernels on a worker pool */
+int kolibri_gpu_cpu_init(const kolibri_gpu_config_t *config);
+void kolibri_gpu_cpu_shutdown(void);
+int kolibri_gpu_cpu_encode(const kolibri_gpu_reason_batch_t *input,
+                           kolibri_gpu_embedding_batch_t *output);
+int kolibri_gpu_cpu_decode(const kolibri_gpu_embedding_batch_t *input,
+                           kolibri_gpu_reason_batch_t *output);
+int kolibri_gpu_cpu_embed_tokens(const uint16_t *tokens,
+                                 size_t token_count,
+                                 kolibri_gpu_embedding_batch_t *output);
+
+static const struct kolibri_gpu_backend_ops k_cpu_ops = {
+    .name = "cpu",
+    .init = kolibri_gpu_cpu_init,
+    .shutdown = kolibri_gpu_cpu_shutdown,
+    .encode = kolibri_gpu_cpu_encode,
+    .decode = kolibri_gpu_cpu_decode,
+    .embed_tokens = kolibri_gpu_cpu_embed_tokens,
+};
+
+#ifdef KOLIBRI_GPU_HAVE_CUDA
 /* CUDA backend (not yet implemented) */
 int kolibri_gpu_cuda_init(const kolibri_gpu_config_t *config);
 void kolibri_gpu_cuda_shutdown(void);
@@ -60,6 +83,7 @@ static const struct kolibri_gpu_backend_ops k_cuda_ops = {
     .decode = kolibri_gpu_cuda_decode,
     .embed_tokens = kolibri_gpu_cuda_embed_tokens,
 };
+#endif
 
 #ifdef __APPLE__
 int kolibri_gpu_metal_init(const kolibri_gpu_config_t *config);
@@ -94,10 +118,19 @@ int kolibri_gpu_encoder_init(const kolibri_gpu_config_t *config) {
     }
     g_active_cfg = *config;
 
-    const struct kolibri_gpu_backend_ops *target = &k_stub_ops;
+    if (g_ops && g_ops->shutdown) {
+        g_ops->shutdown();
+    }
+    g_ops = NULL;
+
+    const struct kolibri_gpu_backend_ops *target = &k_cpu_ops;
     switch (config->backend) {
         case KOLIBRI_GPU_BACKEND_CUDA:
+#ifdef KOLIBRI_GPU_HAVE_CUDA
             target = &k_cuda_ops;
+#else
+            fprintf(stderr, "[kolibri-gpu] CUDA backend requested but not built in\n");
+#endif
             break;
         case KOLIBRI_GPU_BACKEND_METAL:
 #ifdef __APPLE__
@@ -106,9 +139,10 @@ int kolibri_gpu_encoder_init(const kolibri_gpu_config_t *config) {
             fprintf(stderr, "[kolibri-gpu] Metal backend requested but unavailable on this platform\n");
 #endif
             break;
+        case KOLIBRI_GPU_BACKEND_CPU:
         case KOLIBRI_GPU_BACKEND_NONE:
         default:
-            target = &k_stub_ops;
+            target = &k_cpu_ops;
             break;
     }
 
@@ -117,6 +151,15 @@ int kolibri_gpu_encoder_init(const kolibri_gpu_config_t *config) {
         return 0;
     }
 
+    if (target != &k_cpu_ops) {
+        fprintf(stderr, "[kolibri-gpu] Failed to initialize backend '%s', falling back to cpu\n",
+                target->name);
+        if (k_cpu_ops.init(config) == 0) {
+            select_backend(&k_cpu_ops);
+            return 0;
+        }
+    }
+
     fprintf(stderr, "[kolibri-gpu] Failed to initialize backend '%s', falling back to stub\n",
             target->name);
     k_stub_ops.init(config);
@@ -132,6 +175,42 @@ void kolibri_gpu_encoder_shutdown(void) {
     g_active_cfg.backend = KOLIBRI_GPU_BACKEND_NONE;
 }
 
+const char *kolibri_gpu_backend_name(void) {
+    return g_ops ? g_ops->name : NULL;
+}
+
+int kolibri_gpu_embedding_batch_alloc(kolibri_gpu_embedding_batch_t *batch,
+                                      size_t count,
+                                      size_t dims) {
+    if (!batch || count == 0 || dims == 0) {
+        return -1;
+    }
+    size_t row = dims * sizeof(float);
+    size_t stride = (row + KOLIBRI_GPU_ROW_ALIGN - 1) / KOLIBRI_GPU_ROW_ALIGN * KOLIBRI_GPU_ROW_ALIGN;
+    if (count > SIZE_MAX / stride) {
+        return -1;
+    }
+    float *data = (float *)aligned_alloc(KOLIBRI_GPU_ROW_ALIGN, count * stride);
+    if (!data) {
+        return -1;
+    }
+    memset(data, 0, count * stride);
+    batch->data = data;
+    batch->dims = dims;
+    batch->stride = stride;
+    batch->count = count;
+    return 0;
+}
+
+void kolibri_gpu_embedding_batch_free(kolibri_gpu_embedding_batch_t *batch) {
+    if (!batch) {
+        return;
+    }
+    free(batch->data);
+    batch->data = NULL;
+    batch->count = 0;
+}
+
 static int ensure_ops(void) {
     if (!g_ops) {
         fprintf(stderr, "[kolibri-gpu] backend not initialized\n");
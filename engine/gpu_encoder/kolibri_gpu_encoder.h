@@ -11,7 +11,8 @@ extern "C" {
 typedef enum {
     KOLIBRI_GPU_BACKEND_NONE = 0,
     KOLIBRI_GPU_BACKEND_CUDA = 1,
-    KOLIBRI_GPU_BACKEND_METAL = 2
+    KOLIBRI_GPU_BACKEND_METAL = 2,
+    KOLIBRI_GPU_BACKEND_CPU = 3
 } kolibri_gpu_backend_t;
 
 /**
@@ -22,7 +23,7 @@ typedef enum {
 typedef struct {
     kolibri_gpu_backend_t backend;
     int device_index;
-    size_t max_batch;
+    size_t max_batch;         /* Items per dispatched chunk (0 = backend default) */
 } kolibri_gpu_config_t;
 
 /**
@@ -41,10 +42,13 @@ typedef struct {
 typedef struct {
     float *data;
     size_t dims;
-    size_t stride;
+    size_t stride;            /* Bytes between rows, at least dims * sizeof(float) */
     size_t count;
 } kolibri_gpu_embedding_batch_t;
 
+/* Row alignment used by kolibri_gpu_embedding_batch_alloc. */
+#define KOLIBRI_GPU_ROW_ALIGN 64
+
 /**
  * Initializes the GPU encoder. Returns 0 on success.
  */
@@ -55,6 +59,30 @@ int kolibri_gpu_encoder_init(const kolibri_gpu_config_t *config);
  */
 void kolibri_gpu_encoder_shutdown(void);
 
+/**
+ * Name of the active backend ("cpu", "cuda", "metal", "stub") or NULL.
+ */
+const char *kolibri_gpu_backend_name(void);
+
+/**
+ * Kernel chosen by the CPU backend: "scalar", "avx2" or "avx512".
+ * KOLIBRI_GPU_CPU_ISA in the environment caps the choice at init.
+ */
+const char *kolibri_gpu_cpu_isa(void);
+
+/**
+ * Allocates `count` zeroed rows of `dims` floats, each starting on a
+ * KOLIBRI_GPU_ROW_ALIGN boundary. Returns 0 on success.
+ */
+int kolibri_gpu_embedding_batch_alloc(kolibri_gpu_embedding_batch_t *batch,
+                                      size_t count,
+                                      size_t dims);
+
+/**
+ * Releases a batch allocated by kolibri_gpu_embedding_batch_alloc.
+ */
+void kolibri_gpu_embedding_batch_free(kolibri_gpu_embedding_batch_t *batch);
+
 /**
  * Encodes ReasonBlocks into embeddings via the configured GPU backend.
  * Returns 0 on success.
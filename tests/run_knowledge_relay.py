@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+"""Сквозная проверка kolibri_knowledge_relay: пакетная и инкрементальная
+репликация, догон по смещению и режим наблюдения (--watch)."""
+from __future__ import annotations
+
+import hashlib
+import hmac
+import signal
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+from pathlib import Path
+
+HASH = 32
+TYPE = 32
+PAYLOAD = 256
+BLOCK = 16 + HASH * 2 + TYPE + PAYLOAD
+TARGET_KEY = b"relay-target-key"
+
+
+def make_block(index: int, event_type: str, payload: str) -> bytes:
+    # Релей не проверяет подпись источника: достаточно индекса и полей
+    return (
+        struct.pack(">QQ", index, 1)
+        + bytes(HASH * 2)
+        + event_type.encode().ljust(TYPE, b"\0")
+        + payload.encode().ljust(PAYLOAD, b"\0")
+    )
+
+
+def append_source(path: Path, start: int, count: int) -> None:
+    with path.open("ab") as handle:
+        for i in range(start, start + count):
+            event = "TEACH" if i % 3 != 2 else "NOISE"
+            handle.write(make_block(i, event, str(i)))
+
+
+def read_target(path: Path) -> list[tuple[str, str]]:
+    """Проверяет цепочку HMAC/SHA-256 и возвращает (тип, полезная нагрузка)."""
+    data = path.read_bytes()
+    assert len(data) % BLOCK == 0, "неполный блок в цели"
+    prev = bytes(HASH)
+    events = []
+    for n in range(len(data) // BLOCK):
+        block = data[n * BLOCK:(n + 1) * BLOCK]
+        index = struct.unpack(">Q", block[:8])[0]
+        assert index == n, f"индекс {index} вместо {n}"
+        assert block[16:16 + HASH] == prev, "разрыв цепочки"
+        message = block[:16 + HASH] + block[16 + HASH * 2:]
+        expected = hmac.new(TARGET_KEY, message, hashlib.sha256).digest()
+        assert block[16 + HASH:16 + HASH * 2] == expected, "неверная подпись"
+        prev = hashlib.sha256(block).digest()
+        event = block[16 + HASH * 2:16 + HASH * 2 + TYPE].rstrip(b"\0").decode()
+        payload = block[16 + HASH * 2 + TYPE:].rstrip(b"\0").decode()
+        events.append((event, payload))
+    return events
+
+
+def expected_events(count: int) -> list[tuple[str, str]]:
+    return [("TEACH", str(i)) for i in range(count) if i % 3 != 2]
+
+
+def wait_for(predicate, timeout: float = 10.0) -> bool:
+    deadline = time.time() + timeout
+    while time.time() < deadline:
+        if predicate():
+            return True
+        time.sleep(0.05)
+    return False
+
+
+def main() -> None:
+    if len(sys.argv) != 2:
+        raise SystemExit("использование: run_knowledge_relay.py <binary>")
+    binary = sys.argv[1]
+
+    with tempfile.TemporaryDirectory() as tmp_dir:
+        tmp = Path(tmp_dir)
+        source = tmp / "knowledge.dat"
+        targets = tmp / "cluster"
+        targets.mkdir()
+        offset = tmp / "relay.offset"
+        base = [
+            binary,
+            "--source", str(source),
+            "--targets-dir", str(targets),
+            "--target-key-inline", TARGET_KEY.decode(),
+            "--offset", str(offset),
+            "--batch", "64",
+        ]
+        for name in ("node1.dat", "node2.dat"):
+            (targets / name).touch()
+
+        # Однократный запуск: больше событий, чем помещается в пакет
+        append_source(source, 0, 300)
+        subprocess.run(base, check=True, capture_output=True)
+        for name in ("node1.dat", "node2.dat"):
+            assert read_target(targets / name) == expected_events(300)
+        assert offset.read_text().strip() == "300"
+
+        # Повторный запуск догоняет только новые блоки
+        append_source(source, 300, 30)
+        run = subprocess.run(base, check=True, capture_output=True, text=True)
+        assert "processed 20 events" in run.stdout, run.stdout
+        assert read_target(targets / "node1.dat") == expected_events(330)
+
+        # Наблюдение: новые блоки и новые цели подхватываются без перезапуска
+        proc = subprocess.Popen(base + ["--watch", "--interval-ms", "200"],
+                                stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True)
+        try:
+            time.sleep(0.3)
+            append_source(source, 330, 15)
+            ok = wait_for(lambda: len(read_target(targets / "node1.dat")) == len(expected_events(345)))
+            assert ok, "watch не доставил новые события"
+            (targets / "node3.dat").touch()
+            append_source(source, 345, 3)
+            ok = wait_for(lambda: len(read_target(targets / "node3.dat")) == 2)
+            assert ok, "новая цель не подхвачена"
+        finally:
+            proc.send_signal(signal.SIGTERM)
+            stdout, stderr = proc.communicate(timeout=10)
+        assert proc.returncode == 0, stderr
+        assert read_target(targets / "node2.dat") == expected_events(348)
+        assert offset.read_text().strip() == "348"
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,202 @@
+#!/usr/bin/env python3
+"""Сквозная проверка режима демона kolibri_node: RPC по сокету Unix."""
+from __future__ import annotations
+
+import signal
+import socket
+import struct
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+from pathlib import Path
+
+STATUS_OK = 0
+STATUS_UNKNOWN = 1
+STATUS_BAD_FRAME = 2
+STATUS_STOPPING = 3
+
+
+def send_request(sock: socket.socket, line: str) -> None:
+    data = line.encode("utf-8")
+    sock.sendall(struct.pack(">I", len(data)) + data)
+
+
+def recv_exact(sock: socket.socket, size: int) -> bytes:
+    chunks = bytearray()
+    while len(chunks) < size:
+        chunk = sock.recv(size - len(chunks))
+        if not chunk:
+            raise SystemExit("демон закрыл соединение раньше ответа")
+        chunks.extend(chunk)
+    return bytes(chunks)
+
+
+def recv_reply(sock: socket.socket) -> tuple[int, str]:
+    (length,) = struct.unpack(">I", recv_exact(sock, 4))
+    body = recv_exact(sock, length)
+    return body[0], body[1:].decode("utf-8")
+
+
+def connect(path: Path) -> socket.socket:
+    deadline = time.monotonic() + 10.0
+    while True:
+        sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        try:
+            sock.connect(str(path))
+            sock.settimeout(30.0)
+            return sock
+        except OSError:
+            sock.close()
+            if time.monotonic() > deadline:
+                raise SystemExit("RPC-сокет демона не появился")
+            time.sleep(0.05)
+
+
+def start_daemon(binary: str, tmp_path: Path, rpc_path: Path) -> subprocess.Popen:
+    return subprocess.Popen(
+        [
+            binary,
+            "--genome",
+            str(tmp_path / "genome.dat"),
+            "--rpc",
+            str(rpc_path),
+            "--auto-evolve-ms",
+            "20",
+        ],
+        stdin=subprocess.DEVNULL,
+        stdout=subprocess.PIPE,
+        stderr=subprocess.PIPE,
+        text=True,
+    )
+
+
+def check_basic(sock: socket.socket) -> None:
+    send_request(sock, ":teach 1->3")
+    status, text = recv_reply(sock)
+    if status != STATUS_OK or "поколений" not in text:
+        raise SystemExit(f"неожиданный ответ на teach: {status} {text!r}")
+
+    # Несколько запросов подряд: ответы в порядке отправки
+    send_request(sock, ":teach 2->5")
+    send_request(sock, ":ask 4")
+    send_request(sock, ":nope")
+    send_request(sock, "")
+    replies = [recv_reply(sock) for _ in range(4)]
+    if replies[0][0] != STATUS_OK or "f(4)" not in replies[1][1]:
+        raise SystemExit(f"неожиданные ответы: {replies!r}")
+    if replies[2][0] != STATUS_UNKNOWN or "nope" not in replies[2][1]:
+        raise SystemExit(f"неизвестная команда не распознана: {replies[2]!r}")
+    if replies[3][0] != STATUS_UNKNOWN:
+        raise SystemExit(f"пустой запрос не отвергнут: {replies[3]!r}")
+
+    # Большой :tick не занимает цикл событий: число поколений ограничено
+    send_request(sock, ":tick 2000000000")
+    status, text = recv_reply(sock)
+    if status != STATUS_OK or "выполнено поколений: 64" not in text:
+        raise SystemExit(f"поколения в запросе не ограничены: {status} {text!r}")
+
+
+def check_concurrency(rpc_path: Path) -> None:
+    clients = 16
+    requests = 40
+    errors: list[str] = []
+    latencies: list[float] = []
+    lock = threading.Lock()
+
+    def worker(index: int) -> None:
+        try:
+            with connect(rpc_path) as sock:
+                for i in range(requests):
+                    start = time.monotonic()
+                    send_request(sock, f":ask {index * requests + i}")
+                    status, text = recv_reply(sock)
+                    elapsed = time.monotonic() - start
+                    if status != STATUS_OK or "[Ответ]" not in text:
+                        raise RuntimeError(f"клиент {index}: {status} {text!r}")
+                    with lock:
+                        latencies.append(elapsed)
+        except Exception as exc:  # noqa: BLE001
+            with lock:
+                errors.append(str(exc))
+
+    threads = [threading.Thread(target=worker, args=(i,)) for i in range(clients)]
+    start = time.monotonic()
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    elapsed = time.monotonic() - start
+    if errors:
+        raise SystemExit("ошибки клиентов: " + "; ".join(errors[:3]))
+    latencies.sort()
+    p99 = latencies[int(len(latencies) * 0.99) - 1]
+    print(f"{clients * requests / elapsed:.0f} запросов/с, p99 {p99 * 1e3:.1f} мс")
+
+
+def check_bad_frame(rpc_path: Path) -> None:
+    with connect(rpc_path) as sock:
+        sock.sendall(struct.pack(">I", 1 << 20))
+        status, _ = recv_reply(sock)
+        if status != STATUS_BAD_FRAME:
+            raise SystemExit(f"слишком длинный кадр принят: {status}")
+        if sock.recv(1) != b"":
+            raise SystemExit("соединение с испорченным кадром не закрыто")
+
+
+def main() -> None:
+    if len(sys.argv) != 2:
+        raise SystemExit("использование: run_kolibri_node_daemon.py <kolibri_node>")
+    binary = sys.argv[1]
+    with tempfile.TemporaryDirectory() as tmp_dir:
+        tmp_path = Path(tmp_dir)
+        rpc_path = tmp_path / "node.sock"
+
+        process = start_daemon(binary, tmp_path, rpc_path)
+        try:
+            with connect(rpc_path) as sock:
+                check_basic(sock)
+            check_concurrency(rpc_path)
+            check_bad_frame(rpc_path)
+            with connect(rpc_path) as sock:
+                send_request(sock, ":quit")
+                status, _ = recv_reply(sock)
+                if status != STATUS_STOPPING:
+                    raise SystemExit(f"неожиданный статус :quit: {status}")
+            stdout, stderr = process.communicate(timeout=30)
+        finally:
+            if process.poll() is None:
+                process.kill()
+                process.communicate()
+        if process.returncode != 0:
+            sys.stdout.write(stdout)
+            sys.stderr.write(stderr)
+            raise SystemExit(f"демон завершился с кодом {process.returncode}")
+        if rpc_path.exists():
+            raise SystemExit("RPC-сокет не удалён при остановке")
+        if not (tmp_path / "genome.dat.pool").exists():
+            raise SystemExit("снимок пула не записан при остановке")
+
+        # SIGTERM завершает демон штатно, журнал остаётся целым
+        process = start_daemon(binary, tmp_path, rpc_path)
+        try:
+            with connect(rpc_path) as sock:
+                send_request(sock, ":verify")
+                status, text = recv_reply(sock)
+                if status != STATUS_OK or "успехом" not in text:
+                    raise SystemExit(f"геном не прошёл проверку: {text!r}")
+            process.send_signal(signal.SIGTERM)
+            stdout, _ = process.communicate(timeout=30)
+        finally:
+            if process.poll() is None:
+                process.kill()
+                process.communicate()
+        if process.returncode != 0 or "завершил работу" not in stdout:
+            raise SystemExit(f"SIGTERM не обработан: код {process.returncode}")
+        if "пул восстановлен" not in stdout:
+            raise SystemExit("пул не восстановлен из снимка при перезапуске")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,263 @@
+/*
+ * Tests for the SA-IS suffix array and block BWT
+ */
+
+#include "kolibri/bwt.h"
+#include "kolibri/compress.h"
+#include "test_util.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ULL;
+
+static uint64_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static const uint8_t *g_text;
+static size_t g_len;
+
+static int naive_cmp(const void *a, const void *b) {
+    size_t i = (size_t)*(const int32_t *)a, j = (size_t)*(const int32_t *)b;
+    size_t li = g_len - i, lj = g_len - j;
+    int c = memcmp(g_text + i, g_text + j, li < lj ? li : lj);
+    if (c != 0) return c;
+    return li < lj ? -1 : (li > lj ? 1 : 0);
+}
+
+static void test_suffix_array_matches_naive(void) {
+    printf("test_suffix_array_matches_naive... ");
+
+    uint8_t text[300];
+    int32_t sa[301], naive[301];
+    for (int round = 0; round < 200; round++) {
+        size_t len = (size_t)(next_random() % 300);
+        /* Маленькие алфавиты дают длинные повторы и глубокую рекурсию */
+        unsigned alphabet = round % 4 == 0 ? 1 : (round % 4 == 1 ? 2 : (round % 4 == 2 ? 4 : 256));
+        for (size_t i = 0; i < len; i++) text[i] = (uint8_t)(next_random() % alphabet);
+
+        assert(kolibri_suffix_array(text, len, sa) == 0);
+        assert(sa[0] == (int32_t)len);
+        for (size_t i = 0; i < len; i++) naive[i] = (int32_t)i;
+        g_text = text;
+        g_len = len;
+        qsort(naive, len, sizeof(int32_t), naive_cmp);
+        assert(memcmp(sa + 1, naive, len * sizeof(int32_t)) == 0);
+    }
+
+    printf("OK\n");
+}
+
+static void test_bwt_roundtrip(void) {
+    printf("test_bwt_roundtrip... ");
+
+    const char *samples[] = {"a", "banana", "abracadabra", "aaaaaaaaaa", "abababab", "\0\0\1\0"};
+    size_t lengths[] = {1, 6, 11, 10, 8, 4};
+    uint8_t encoded[32], decoded[32];
+    for (size_t s = 0; s < sizeof(lengths) / sizeof(lengths[0]); s++) {
+        uint32_t primary = 0;
+        assert(kolibri_bwt_encode((const uint8_t *)samples[s], lengths[s], encoded, &primary, NULL) == 0);
+        assert(kolibri_bwt_decode(encoded, lengths[s], primary, decoded, NULL) == 0);
+        assert(memcmp(decoded, samples[s], lengths[s]) == 0);
+    }
+
+    /* banana$ -> строки: $banana a$banan ana$ban anana$b banana$ na$bana nana$ba */
+    uint32_t primary = 0;
+    assert(kolibri_bwt_encode((const uint8_t *)"banana", 6, encoded, &primary, NULL) == 0);
+    assert(memcmp(encoded, "annbaa", 6) == 0 && primary == 4);
+
+    assert(kolibri_bwt_decode(encoded, 6, 0, decoded, NULL) == -1);
+    assert(kolibri_bwt_decode(encoded, 6, 7, decoded, NULL) == -1);
+
+    printf("OK\n");
+}
+
+static void test_bwt_blocks_redundant_input(void) {
+    printf("test_bwt_blocks_redundant_input... ");
+
+    /* 8 МБ почти периодического текста: qsort-BWT здесь квадратичен */
+    size_t len = 8u << 20;
+    uint8_t *input = malloc(len);
+    uint8_t *encoded = malloc(len);
+    uint8_t *decoded = malloc(len);
+    assert(input && encoded && decoded);
+    const char *line = "2025-01-01 INFO kolibri: request served in 12 ms\n";
+    size_t line_len = strlen(line);
+    for (size_t i = 0; i < len; i++) input[i] = (uint8_t)line[i % line_len];
+    input[len / 3] = 'X';
+
+    size_t block = 1u << 20;
+    size_t blocks = kolibri_bwt_block_count(len, block);
+    assert(blocks == 8);
+    uint32_t *primaries = calloc(blocks, sizeof(uint32_t));
+    assert(primaries);
+
+    clock_t start = clock();
+    assert(kolibri_bwt_encode_blocks(input, len, block, 4, encoded, primaries) == 0);
+    assert(kolibri_bwt_decode_blocks(encoded, len, block, 4, primaries, decoded) == 0);
+    double elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+    assert(memcmp(input, decoded, len) == 0);
+    printf("%.2f s cpu... ", elapsed);
+
+    /* Последний неполный блок */
+    assert(kolibri_bwt_encode_blocks(input, len - 12345, block, 0, encoded, primaries) == 0);
+    assert(kolibri_bwt_decode_blocks(encoded, len - 12345, block, 0, primaries, decoded) == 0);
+    assert(memcmp(input, decoded, len - 12345) == 0);
+
+    free(primaries);
+    free(decoded);
+    free(encoded);
+    free(input);
+
+    printf("OK\n");
+}
+
+static void test_block_codec_roundtrip(void) {
+    printf("test_block_codec_roundtrip... ");
+
+    /* Текст, шум (хранимые блоки) и граничные размеры */
+    size_t len = 700000;
+    uint8_t *input = malloc(len);
+    assert(input);
+    for (size_t i = 0; i < len; i++) {
+        input[i] = i < len / 2 ? (uint8_t)("kolibri codec block "[i % 20] + (i / 5000) % 3)
+                               : (uint8_t)next_random();
+    }
+
+    KolibriCompressor *comp = kolibri_compressor_create(KOLIBRI_COMPRESS_BWT);
+    assert(comp);
+    assert(kolibri_compressor_set_blocks(comp, 64 * 1024, 3) == 0);
+
+    size_t sizes[] = {1, 2, 65536, 65537, len};
+    for (size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+        uint8_t *packed = NULL, *unpacked = NULL;
+        size_t packed_size = 0, unpacked_size = 0;
+        KolibriCompressStats stats;
+        assert(kolibri_compress(comp, input, sizes[k], &packed, &packed_size, &stats) == 0);
+        assert(stats.methods_used == KOLIBRI_COMPRESS_BWT);
+        assert(kolibri_decompress(packed, packed_size, &unpacked, &unpacked_size, NULL) == 0);
+        assert(unpacked_size == sizes[k] && memcmp(unpacked, input, sizes[k]) == 0);
+        if (sizes[k] == len) {
+            /* Шумовая половина хранится как есть, текстовая сжимается */
+            assert(packed_size < len * 6 / 10);
+
+            /* Порча данных обнаруживается */
+            packed[packed_size / 4] ^= 0x55;
+            free(unpacked);
+            unpacked = NULL;
+            assert(kolibri_decompress(packed, packed_size, &unpacked, &unpacked_size, NULL) != 0);
+            assert(kolibri_decompress(packed, packed_size / 2, &unpacked, &unpacked_size, NULL) != 0);
+        }
+        free(packed);
+        free(unpacked);
+    }
+
+    kolibri_compressor_destroy(comp);
+    free(input);
+
+    printf("OK\n");
+}
+
+static void test_block_codec_stream(void) {
+    printf("test_block_codec_stream... ");
+
+    FILE *in = tmpfile();
+    FILE *packed = tmpfile();
+    FILE *out = tmpfile();
+    assert(in && packed && out);
+    for (int i = 0; i < 40000; i++) {
+        fprintf(in, "line %d: kolibri stream %d\n", i, i % 17);
+    }
+    long size = ftell(in);
+    rewind(in);
+
+    KolibriCompressor *comp = kolibri_compressor_create(KOLIBRI_COMPRESS_BWT);
+    assert(comp);
+    assert(kolibri_compressor_set_blocks(comp, 100000, 2) == 0);
+    KolibriCompressStats stats;
+    assert(kolibri_compress_stream(comp, in, packed, &stats) == 0);
+    assert(stats.original_size == (size_t)size);
+    assert(stats.compressed_size < (size_t)size / 4);
+    kolibri_compressor_destroy(comp);
+
+    rewind(packed);
+    assert(kolibri_decompress_stream(packed, out, 0, &stats) == 0);
+    assert(stats.original_size == (size_t)size);
+
+    rewind(in);
+    rewind(out);
+    int a, b;
+    do {
+        a = fgetc(in);
+        b = fgetc(out);
+        assert(a == b);
+    } while (a != EOF);
+
+    fclose(in);
+    fclose(packed);
+    fclose(out);
+
+    printf("OK\n");
+}
+
+static void test_archive_roundtrip(void) {
+    printf("test_archive_roundtrip... ");
+
+    /* Таблица записей пишется после данных и не затирает их */
+    char path[] = "/tmp/kolibri_bwt_archive_XXXXXX";
+    temp_path(path);
+
+    size_t len = 200000;
+    uint8_t *data = malloc(len);
+    assert(data);
+    for (size_t i = 0; i < len; i++) data[i] = (uint8_t)("archive entry "[i % 14] ^ (i / 4096));
+
+    KolibriArchive *archive = kolibri_archive_create(path);
+    assert(archive);
+    assert(kolibri_archive_add_file(archive, "first", data, len) == 0);
+    assert(kolibri_archive_add_file(archive, "second", data + 1000, 5000) == 0);
+    kolibri_archive_close(archive);
+
+    archive = kolibri_archive_open(path);
+    assert(archive);
+    KolibriArchiveEntry *entries = NULL;
+    size_t count = 0;
+    assert(kolibri_archive_list(archive, &entries, &count) == 0 && count == 2);
+    free(entries);
+    uint8_t *out = NULL;
+    size_t out_len = 0;
+    assert(kolibri_archive_extract_file(archive, "second", &out, &out_len) == 0);
+    assert(out_len == 5000 && memcmp(out, data + 1000, 5000) == 0);
+    free(out);
+    assert(kolibri_archive_extract_file(archive, "first", &out, &out_len) == 0);
+    assert(out_len == len && memcmp(out, data, len) == 0);
+    free(out);
+    kolibri_archive_close(archive);
+
+    unlink(path);
+    free(data);
+
+    printf("OK\n");
+}
+
+int main(void) {
+    printf("=== BWT / SA-IS tests ===\n");
+
+    test_suffix_array_matches_naive();
+    test_bwt_roundtrip();
+    test_bwt_blocks_redundant_input();
+    test_block_codec_roundtrip();
+    test_block_codec_stream();
+    test_archive_roundtrip();
+
+    printf("\n✓ All BWT tests passed!\n");
+    return 0;
+}
@@ -8,7 +8,10 @@
 
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 static void test_corpus_init(void) {
     printf("test_corpus_init... ");
@@ -205,6 +208,138 @@ static void test_get_stats(void) {
     printf("OK\n");
 }
 
+static void test_find_nearest(void) {
+    printf("test_find_nearest... ");
+    
+    KolibriCorpusContext ctx;
+    k_corpus_init(&ctx, 0, 0);
+    
+    /* Больше начальной ёмкости, чтобы проверить рост индекса */
+    KolibriSemanticPattern pattern;
+    char word[32];
+    uint64_t state = 88172645463325252ULL;
+    for (size_t i = 0; i < 3000; i++) {
+        k_semantic_pattern_init(&pattern);
+        for (size_t j = 0; j < KOLIBRI_SEMANTIC_PATTERN_SIZE; j++) {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            pattern.pattern[j] = (uint8_t)(state % 10);
+        }
+        snprintf(word, sizeof(word), "w%zu", i);
+        assert(k_corpus_store_pattern(&ctx, word, &pattern) == 0);
+    }
+    assert(ctx.store.count == 3000);
+    
+    const KolibriSemanticPattern *found = k_corpus_find_pattern(&ctx, "w2999");
+    assert(found != NULL);
+    assert(k_corpus_find_pattern(&ctx, "w3000") == NULL);
+    
+    /* Запрос — копия паттерна 1234 с одной изменённой цифрой */
+    KolibriSemanticPattern query = ctx.store.patterns[1234];
+    query.pattern[5] = (uint8_t)((query.pattern[5] + 1) % 10);
+    
+    KolibriPatternMatch exact[4];
+    int count = k_corpus_find_nearest(&ctx, &query, 4, exact);
+    assert(count == 4);
+    assert(exact[0].index == 1234);
+    assert(exact[0].similarity > 0.98);
+    for (int i = 1; i < count; i++) {
+        assert(exact[i - 1].similarity >= exact[i].similarity);
+    }
+    
+    KolibriPatternMatch approx[4];
+    count = k_corpus_find_nearest_approx(&ctx, &query, 4, approx);
+    assert(count > 0);
+    assert(approx[0].index == 1234);
+    
+    /* После обновления LSH перестраивается */
+    k_corpus_store_pattern(&ctx, "w1234", &query);
+    count = k_corpus_find_nearest_approx(&ctx, &query, 1, approx);
+    assert(count == 1 && approx[0].similarity == 1.0);
+    
+    k_corpus_free(&ctx);
+    
+    printf("OK\n");
+}
+
+static void assert_same_store(const KolibriCorpusContext *a, const KolibriCorpusContext *b) {
+    assert(a->store.count == b->store.count);
+    for (size_t i = 0; i < a->store.count; i++) {
+        assert(strcmp(a->store.words[i], b->store.words[i]) == 0);
+        assert(memcmp(a->store.patterns[i].pattern, b->store.patterns[i].pattern,
+                      KOLIBRI_SEMANTIC_PATTERN_SIZE) == 0);
+    }
+}
+
+static void test_parallel_determinism(void) {
+    printf("test_parallel_determinism... ");
+    
+    char root[] = "/tmp/kolibri_corpus_XXXXXX";
+    assert(mkdtemp(root) != NULL);
+    char sub[512];
+    snprintf(sub, sizeof(sub), "%s/sub", root);
+    assert(mkdir(sub, 0700) == 0);
+    
+    const char *words[] = {"кот", "кошка", "дом", "крыша", "спит", "сидит",
+                           "рядом", "солнце", "лето", "река", "лес", "поле"};
+    char path[600];
+    for (int f = 0; f < 12; f++) {
+        snprintf(path, sizeof(path), "%s/doc%02d.txt", f % 3 == 0 ? sub : root, f);
+        FILE *out = fopen(path, "w");
+        assert(out);
+        for (int w = 0; w < 60; w++) {
+            fprintf(out, "%s ", words[(f * 7 + w * (f + 1)) % 12]);
+        }
+        fclose(out);
+    }
+    
+    KolibriCorpusContext serial, parallel;
+    k_corpus_init(&serial, 200, 4);
+    k_corpus_init(&parallel, 200, 4);
+    serial.threads = 1;
+    parallel.threads = 4;
+    serial.generations = parallel.generations = 20;
+    
+    assert(k_corpus_learn_directory(&serial, root, 1) == 12);
+    assert(k_corpus_learn_directory(&parallel, root, 1) == 12);
+    assert(serial.stats.total_tokens == 12 * 60);
+    assert(serial.stats.files_scanned == 12);
+    assert(serial.stats.batches > 1);
+    assert_same_store(&serial, &parallel);
+    
+    /* Без рекурсии поддиректория пропускается */
+    KolibriCorpusContext flat;
+    k_corpus_init(&flat, 0, 4);
+    flat.generations = 5;
+    assert(k_corpus_learn_directory(&flat, root, 0) == 8);
+    k_corpus_free(&flat);
+    
+    const char *text = "Кот сидит на крыше. Кошка спит рядом с котом. Кот спит.";
+    KolibriCorpusContext doc_serial, doc_parallel;
+    k_corpus_init(&doc_serial, 0, 4);
+    k_corpus_init(&doc_parallel, 0, 4);
+    doc_serial.threads = 1;
+    doc_parallel.threads = 3;
+    assert(k_corpus_learn_document(&doc_serial, text, strlen(text)) == 0);
+    assert(k_corpus_learn_document(&doc_parallel, text, strlen(text)) == 0);
+    assert_same_store(&doc_serial, &doc_parallel);
+    
+    k_corpus_free(&doc_parallel);
+    k_corpus_free(&doc_serial);
+    k_corpus_free(&parallel);
+    k_corpus_free(&serial);
+    
+    for (int f = 0; f < 12; f++) {
+        snprintf(path, sizeof(path), "%s/doc%02d.txt", f % 3 == 0 ? sub : root, f);
+        unlink(path);
+    }
+    rmdir(sub);
+    rmdir(root);
+    
+    printf("OK\n");
+}
+
 int main(void) {
     printf("╔════════════════════════════════════════════════════════════╗\n");
     printf("║       CORPUS LEARNING TESTS (v2.0 Phase 1.3)             ║\n");
@@ -219,6 +354,8 @@ int main(void) {
     test_learn_document();
     test_save_load_patterns();
     test_get_stats();
+    test_find_nearest();
+    test_parallel_determinism();
     
     printf("\n✓ All corpus learning tests passed!\n");
     printf("\nSTATUS: Phase 1.3 (Corpus Learning) - INITIAL IMPLEMENTATION\n");
@@ -0,0 +1,169 @@
+/*
+ * Tests for compiled meta-formula plans and the parallel batch executor
+ */
+
+#include "kolibri/formula_logic.h"
+#include "test_util.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static char **make_ids(const char *prefix, size_t count) {
+    char **ids = malloc(count * sizeof(char*));
+    assert(ids);
+    for (size_t i = 0; i < count; i++) {
+        ids[i] = malloc(32);
+        assert(ids[i]);
+        snprintf(ids[i], 32, "%s%zu", prefix, i);
+    }
+    return ids;
+}
+
+static void free_ids(char **ids, size_t count) {
+    for (size_t i = 0; i < count; i++) free(ids[i]);
+    free(ids);
+}
+
+static void test_plan_formulas(void) {
+    printf("test_plan_formulas... ");
+
+    MetaFormula *meta = mf_create_sequence_generator("i*10 - 5", "(n - i) % 3 + 1", "2");
+    assert(meta);
+    MfPlan *plan = mf_compile(meta);
+    assert(plan);
+
+    LogicExpression *logic = mf_plan_execute(plan, NULL, 4, 10);
+    assert(logic && logic->type == LOGIC_SEQUENCE);
+    assert(logic->data.sequence.start == 35);
+    assert(logic->data.sequence.step == 1);
+    assert(logic->data.sequence.count == 2);
+    lm_destroy_logic(logic);
+    mf_plan_destroy(plan);
+    mf_destroy_meta_formula(meta);
+
+    /* Ошибки разбора и вычисления */
+    meta = mf_create_repeat_generator("ab", "3 +");
+    assert(mf_compile(meta) == NULL);
+    mf_destroy_meta_formula(meta);
+
+    meta = mf_create_repeat_generator("ab", "6 / (i - 1)");
+    plan = mf_compile(meta);
+    assert(plan);
+    assert(mf_plan_execute(plan, NULL, 1, 3) == NULL);
+    logic = mf_plan_execute(plan, NULL, 3, 3);
+    assert(logic && logic->data.repeat.count == 3);
+    lm_destroy_logic(logic);
+    mf_plan_destroy(plan);
+    mf_destroy_meta_formula(meta);
+
+    printf("OK\n");
+}
+
+static void test_batch_large(void) {
+    printf("test_batch_large... ");
+
+    size_t count = 20000;
+    char **ids = make_ids("seq_", count);
+    LogicalMemory *memory = lm_create_memory();
+    MetaFormulaStore *store = mf_create_store();
+    MetaFormula *meta = mf_create_sequence_generator("i", "1", "i % 7 + 1");
+    assert(memory && store && meta);
+
+    double start = now_seconds();
+    int written = mf_batch_execute(store, meta, memory, (const char**)ids, count);
+    double elapsed = now_seconds() - start;
+    assert(written == (int)count);
+    assert(memory->cell_count == count);
+    assert(store->last_batch.executed == count && store->last_batch.levels == 1);
+    assert(store->cache_count == 0);
+
+    /* Результаты записаны в порядке cell_ids и верно материализуются */
+    char out[128], expected[128];
+    for (size_t i = 0; i < count; i += 997) {
+        assert(strcmp(lm_cell_at(memory, i)->id, ids[i]) == 0);
+        size_t pos = 0;
+        for (size_t k = 0; k <= i % 7; k++) {
+            pos += (size_t)snprintf(expected + pos, sizeof(expected) - pos, "%zu", i + k);
+        }
+        assert(lm_materialize(memory, ids[i], out, sizeof(out)) == (int)pos);
+        assert(strcmp(out, expected) == 0);
+    }
+
+    /* Несколько потоков дают тот же результат */
+    LogicalMemory *parallel = lm_create_memory();
+    assert(parallel);
+    mf_set_threads(store, 4);
+    assert(mf_batch_execute(store, meta, parallel, (const char**)ids, count) == (int)count);
+    assert(store->last_batch.threads == 4);
+    for (size_t i = 0; i < count; i += 1013) {
+        assert(lm_predict_size(parallel, ids[i]) == lm_predict_size(memory, ids[i]));
+        assert(strcmp(lm_cell_at(parallel, i)->id, ids[i]) == 0);
+    }
+
+    printf("%.0f cells/s... ", count / elapsed);
+
+    lm_destroy_memory(parallel);
+    mf_destroy_meta_formula(meta);
+    mf_destroy_store(store);
+    lm_destroy_memory(memory);
+    free_ids(ids, count);
+    printf("OK\n");
+}
+
+static void test_batch_dependencies(void) {
+    printf("test_batch_dependencies... ");
+
+    LogicalMemory *memory = lm_create_memory();
+    MetaFormulaStore *store = mf_create_store();
+    assert(memory && store);
+
+    /* a зависит от b через вход трансформации: b удваивается первым,
+     * a получает удвоение уже нового b */
+    assert(lm_store_logic(memory, "b", lm_logic_repeat("x", 5)) == 0);
+    MetaFormula *meta = mf_create_transformer("b", "double_count");
+    const char *ids[] = {"a", "b"};
+    assert(mf_batch_execute(store, meta, memory, ids, 2) == 2);
+    assert(store->last_batch.levels == 2);
+    assert(lm_predict_size(memory, "b") == 10);
+    assert(lm_predict_size(memory, "a") == 20);
+    mf_destroy_meta_formula(meta);
+
+    /* Явные зависимости ячеек: цепочка c0 ← c1 ← ... ← c9 в обратном порядке */
+    char **chain = make_ids("c", 10);
+    for (size_t i = 0; i < 10; i++) {
+        assert(lm_store_logic(memory, chain[i], lm_logic_constant("old")) == 0);
+        if (i > 0) assert(lm_add_dependency(memory, chain[i], chain[i - 1]) == 0);
+    }
+    const char *reversed[10];
+    for (size_t i = 0; i < 10; i++) reversed[i] = chain[9 - i];
+    meta = mf_create_repeat_generator("z", "i + 1");
+    assert(mf_batch_execute(store, meta, memory, reversed, 10) == 10);
+    assert(store->last_batch.levels == 10);
+    for (size_t i = 0; i < 10; i++) {
+        assert(lm_predict_size(memory, chain[i]) == 10 - i);
+    }
+
+    /* Цикл не выполняется */
+    assert(lm_add_dependency(memory, chain[0], chain[9]) == 0);
+    assert(mf_batch_execute(store, meta, memory, reversed, 10) == 0);
+    assert(store->last_batch.blocked == 10);
+
+    mf_destroy_meta_formula(meta);
+    free_ids(chain, 10);
+    mf_destroy_store(store);
+    lm_destroy_memory(memory);
+    printf("OK\n");
+}
+
+int main(void) {
+    printf("Running meta-formula batch tests...\n\n");
+
+    test_plan_formulas();
+    test_batch_large();
+    test_batch_dependencies();
+
+    printf("\n✓ All meta-formula batch tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,202 @@
+/*
+ * Tests for formula pool snapshots: round trip, deduplication, corruption
+ */
+
+#include "kolibri/formula_snapshot.h"
+#include "kolibri/symbol_table.h"
+#include "test_util.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static KolibriFormulaPool *make_pool(size_t associations) {
+    KolibriFormulaPool *pool = (KolibriFormulaPool *)calloc(1, sizeof(KolibriFormulaPool));
+    assert(pool);
+    kf_pool_init(pool, 1234);
+    KolibriSymbolTable symbols;
+    kolibri_symbol_table_init(&symbols, NULL);
+    for (size_t i = 0; i < associations; ++i) {
+        char question[64];
+        char answer[64];
+        snprintf(question, sizeof(question), "вопрос %zu", i);
+        snprintf(answer, sizeof(answer), "ответ %zu", i * 7U);
+        /* Буфер примеров заполняется раньше ассоциаций */
+        (void)kf_pool_add_association(pool, &symbols, question, answer, "test", 1000U + i);
+    }
+    assert(pool->association_count == associations);
+    for (int i = 0; i < 5; ++i) {
+        (void)kf_pool_add_example(pool, i, 2 * i + 1);
+    }
+    kf_pool_tick(pool, 16);
+    return pool;
+}
+
+static void assert_same_assoc(const KolibriAssociation *a, const KolibriAssociation *b) {
+    assert(a->input_hash == b->input_hash);
+    assert(a->output_hash == b->output_hash);
+    assert(strcmp(a->question, b->question) == 0);
+    assert(strcmp(a->answer, b->answer) == 0);
+    assert(strcmp(a->source, b->source) == 0);
+    assert(a->timestamp == b->timestamp);
+    assert(a->question_digits_length == b->question_digits_length);
+    assert(a->answer_digits_length == b->answer_digits_length);
+    assert(memcmp(a->question_digits, b->question_digits, a->question_digits_length) == 0);
+    assert(memcmp(a->answer_digits, b->answer_digits, a->answer_digits_length) == 0);
+}
+
+static void assert_same_pool(const KolibriFormulaPool *a, const KolibriFormulaPool *b) {
+    assert(a->count == b->count);
+    assert(a->rng.state == b->rng.state);
+    assert(a->examples == b->examples);
+    assert(memcmp(a->inputs, b->inputs, a->examples * sizeof(int)) == 0);
+    assert(memcmp(a->targets, b->targets, a->examples * sizeof(int)) == 0);
+    for (size_t i = 0; i < a->count; ++i) {
+        const KolibriFormula *fa = &a->formulas[i];
+        const KolibriFormula *fb = &b->formulas[i];
+        assert(fa->gene.length == fb->gene.length);
+        assert(memcmp(fa->gene.digits, fb->gene.digits, fa->gene.length) == 0);
+        assert(fa->fitness == fb->fitness);
+        assert(fa->feedback == fb->feedback);
+        assert(fa->association_count == fb->association_count);
+        for (size_t j = 0; j < fa->association_count; ++j) {
+            assert_same_assoc(&fa->associations[j], &fb->associations[j]);
+        }
+    }
+    assert(a->association_count == b->association_count);
+    for (size_t i = 0; i < a->association_count; ++i) {
+        assert_same_assoc(&a->associations[i], &b->associations[i]);
+    }
+}
+
+static void test_round_trip(void) {
+    printf("test_round_trip... ");
+    char path[] = "/tmp/kolibri_snapshotXXXXXX";
+    temp_path(path);
+
+    KolibriFormulaPool *pool = make_pool(40);
+    KolibriPoolSnapshotInfo saved;
+    assert(kf_pool_snapshot_save(pool, 77, path, &saved) == 0);
+    assert(saved.genome_index == 77);
+    assert(saved.formulas == pool->count);
+
+    KolibriFormulaPool *restored = (KolibriFormulaPool *)calloc(1, sizeof(KolibriFormulaPool));
+    assert(restored);
+    kf_pool_init(restored, 99);
+    KolibriPoolSnapshotInfo loaded;
+    assert(kf_pool_snapshot_load(restored, path, &loaded) == 0);
+    assert(loaded.genome_index == 77);
+    assert(loaded.bytes == saved.bytes);
+    assert_same_pool(pool, restored);
+
+    /* Восстановленный пул эволюционирует так же, как исходный */
+    kf_pool_tick(pool, 4);
+    kf_pool_tick(restored, 4);
+    assert_same_pool(pool, restored);
+
+    free(pool);
+    free(restored);
+    unlink(path);
+    printf("OK\n");
+}
+
+static void test_dedup_size(void) {
+    printf("test_dedup_size... ");
+    char path[] = "/tmp/kolibri_snapshotXXXXXX";
+    temp_path(path);
+
+    KolibriFormulaPool *pool = make_pool(200);
+    KolibriPoolSnapshotInfo info;
+    assert(kf_pool_snapshot_save(pool, 0, path, &info) == 0);
+    /* Лучшие формулы несут копии ассоциаций пула: в файле по одной записи */
+    assert(info.associations > info.unique_associations);
+    assert(info.unique_associations == pool->association_count);
+    struct stat st;
+    assert(stat(path, &st) == 0);
+    assert((size_t)st.st_size == info.bytes);
+    assert(info.bytes * 100U < sizeof(KolibriFormulaPool));
+    printf("%zu байт против %zu в памяти... ", info.bytes, sizeof(KolibriFormulaPool));
+
+    free(pool);
+    unlink(path);
+    printf("OK\n");
+}
+
+static void test_corruption_keeps_pool(void) {
+    printf("test_corruption_keeps_pool... ");
+    char path[] = "/tmp/kolibri_snapshotXXXXXX";
+    temp_path(path);
+
+    KolibriFormulaPool *pool = make_pool(10);
+    KolibriPoolSnapshotInfo info;
+    assert(kf_pool_snapshot_save(pool, 5, path, &info) == 0);
+
+    KolibriFormulaPool *target = make_pool(3);
+    KolibriFormulaPool *before = (KolibriFormulaPool *)malloc(sizeof(KolibriFormulaPool));
+    assert(before);
+    memcpy(before, target, sizeof(KolibriFormulaPool));
+
+    /* Испорченный байт в теле: контрольная сумма не сходится */
+    FILE *file = fopen(path, "r+b");
+    assert(file);
+    assert(fseek(file, (long)(info.bytes - 3U), SEEK_SET) == 0);
+    int byte = fgetc(file);
+    assert(fseek(file, (long)(info.bytes - 3U), SEEK_SET) == 0);
+    fputc(byte ^ 0x5A, file);
+    fclose(file);
+    assert(kf_pool_snapshot_load(target, path, NULL) == -1);
+    assert_same_pool(before, target);
+
+    /* Обрезанный файл */
+    assert(truncate(path, (off_t)(info.bytes / 2U)) == 0);
+    assert(kf_pool_snapshot_load(target, path, NULL) == -1);
+    assert_same_pool(before, target);
+
+    /* Отсутствующий файл */
+    unlink(path);
+    assert(kf_pool_snapshot_load(target, path, NULL) == -1);
+    assert_same_pool(before, target);
+
+    free(pool);
+    free(target);
+    free(before);
+    printf("OK\n");
+}
+
+static void test_timing(void) {
+    printf("test_timing... ");
+    char path[] = "/tmp/kolibri_snapshotXXXXXX";
+    temp_path(path);
+
+    KolibriFormulaPool *pool = make_pool(KOLIBRI_POOL_MAX_ASSOCIATIONS);
+    KolibriFormulaPool *restored = (KolibriFormulaPool *)calloc(1, sizeof(KolibriFormulaPool));
+    assert(restored);
+    KolibriPoolSnapshotInfo info;
+
+    double start = now_seconds();
+    assert(kf_pool_snapshot_save(pool, 1, path, &info) == 0);
+    double saved = now_seconds();
+    assert(kf_pool_snapshot_load(restored, path, NULL) == 0);
+    double loaded = now_seconds();
+    assert_same_pool(pool, restored);
+    printf("%zu байт, запись %.1f мс, загрузка %.1f мс... ", info.bytes,
+           (saved - start) * 1e3, (loaded - saved) * 1e3);
+
+    free(pool);
+    free(restored);
+    unlink(path);
+    printf("OK\n");
+}
+
+int main(void) {
+    printf("Running formula snapshot tests...\n\n");
+    test_round_trip();
+    test_dedup_size();
+    test_corruption_keeps_pool();
+    test_timing();
+    printf("\n✓ All formula snapshot tests passed!\n");
+    return 0;
+}
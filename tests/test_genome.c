@@ -155,6 +155,9 @@ void test_genome(void) {
   assert(rc == -1);
 
   remove(template);
+  char tail_path[sizeof(template) + 8];
+  snprintf(tail_path, sizeof(tail_path), "%s.tail", template);
+  remove(tail_path);
 
   rc = kg_verify_file(template, key, sizeof(key) - 1);
   assert(rc == 1);
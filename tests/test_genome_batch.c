@@ -0,0 +1,118 @@
+/*
+ * Tests for batched genome appends
+ */
+
+#include "kolibri/genome.h"
+#include "test_util.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const unsigned char key[] = "batch-key";
+
+/* Геном и его сохранённое состояние хвоста */
+static void remove_genome(const char *path) {
+  char tail[512];
+  snprintf(tail, sizeof(tail), "%s.tail", path);
+  unlink(path);
+  unlink(tail);
+}
+
+static long file_size(const char *path) {
+  struct stat st;
+  assert(stat(path, &st) == 0);
+  return (long)st.st_size;
+}
+
+static void test_batch_chain(void) {
+  printf("test_batch_chain... ");
+  char path[] = "/tmp/kolibri_genome_batchXXXXXX";
+  temp_path(path);
+
+  KolibriGenome g;
+  assert(kg_open(&g, path, key, sizeof(key) - 1) == 0);
+  assert(kg_append(&g, "TEACH", "123", NULL) == 0);
+
+  const char *types[3] = {"TEACH", "USER_FEEDBACK", "TEACH"};
+  const char *payloads[3] = {"1", "22", "333"};
+  assert(kg_append_batch(&g, types, payloads, 3) == 0);
+  assert(g.next_index == 4);
+  assert(kg_append_batch(&g, types, NULL, 1) == 0);
+  assert(kg_append_batch(&g, types, payloads, 0) == 0);
+  assert(kg_append(&g, "TEACH", "4", NULL) == 0);
+  assert(g.next_index == 6);
+  kg_close(&g);
+
+  /* Цепочка цела: открытие и полная проверка проходят */
+  assert(kg_verify_file(path, key, sizeof(key) - 1) == 0);
+  assert(kg_open(&g, path, key, sizeof(key) - 1) == 0);
+  assert(g.next_index == 6);
+
+  /* Ошибка в середине пакета: файл и контекст не меняются */
+  long before = file_size(path);
+  unsigned char last[KOLIBRI_BLOCK_SIZE];
+  memcpy(last, g.last_block, sizeof(last));
+  const char *bad[3] = {"1", "not digits", "3"};
+  assert(kg_append_batch(&g, types, bad, 3) == -1);
+  assert(file_size(path) == before && g.next_index == 6);
+  assert(memcmp(last, g.last_block, sizeof(last)) == 0);
+  const char *long_type[1] = {"EVENT_TYPE_THAT_IS_FAR_TOO_LONG_FOR_A_BLOCK"};
+  assert(kg_append_batch(&g, long_type, NULL, 1) == -1);
+  assert(kg_append_batch(&g, types, payloads, 2) == 0);
+  kg_close(&g);
+  assert(kg_verify_file(path, key, sizeof(key) - 1) == 0);
+
+  remove_genome(path);
+  printf("OK\n");
+}
+
+static void test_batch_throughput(void) {
+  printf("test_batch_throughput... ");
+  char single_path[] = "/tmp/kolibri_genome_singleXXXXXX";
+  char batch_path[] = "/tmp/kolibri_genome_batchXXXXXX";
+  temp_path(single_path);
+  temp_path(batch_path);
+
+  enum { EVENTS = 5000, CHUNK = 250 };
+  const char *types[CHUNK];
+  const char *payloads[CHUNK];
+  for (size_t i = 0; i < CHUNK; i++) {
+    types[i] = "TEACH";
+    payloads[i] = "0123456789";
+  }
+
+  KolibriGenome g;
+  assert(kg_open(&g, single_path, key, sizeof(key) - 1) == 0);
+  double start = now_seconds();
+  for (size_t i = 0; i < EVENTS; i++) assert(kg_append(&g, "TEACH", "0123456789", NULL) == 0);
+  double single = now_seconds() - start;
+  kg_close(&g);
+
+  assert(kg_open(&g, batch_path, key, sizeof(key) - 1) == 0);
+  start = now_seconds();
+  for (size_t i = 0; i < EVENTS; i += CHUNK) assert(kg_append_batch(&g, types, payloads, CHUNK) == 0);
+  double batched = now_seconds() - start;
+  kg_close(&g);
+
+  assert(file_size(single_path) == file_size(batch_path));
+  assert(kg_verify_file(batch_path, key, sizeof(key) - 1) == 0);
+  printf("single %.0f blocks/s, batch %.0f blocks/s... ", EVENTS / single, EVENTS / batched);
+
+  remove_genome(single_path);
+  remove_genome(batch_path);
+  printf("OK\n");
+}
+
+int main(void) {
+  printf("Running genome batch tests...\n\n");
+
+  test_batch_chain();
+  test_batch_throughput();
+
+  printf("\n✓ All genome batch tests passed!\n");
+  return 0;
+}
@@ -0,0 +1,207 @@
+/*
+ * Tests for genome open verification modes and the signed tail state
+ */
+
+#include "kolibri/genome.h"
+#include "test_util.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static const unsigned char key[] = "open-key";
+
+static void tail_of(const char *path, char *out, size_t out_len) {
+  snprintf(out, out_len, "%s.tail", path);
+}
+
+static void remove_genome(const char *path) {
+  char tail[512];
+  tail_of(path, tail, sizeof(tail));
+  unlink(path);
+  unlink(tail);
+}
+
+static int open_mode(KolibriGenome *g, const char *path, KolibriGenomeVerify mode,
+                     size_t threads) {
+  KolibriGenomeOpenOptions options = {mode, threads};
+  return kg_open_ex(g, path, key, sizeof(key) - 1, &options);
+}
+
+static void fill_genome(const char *path, size_t count) {
+  KolibriGenome g;
+  assert(open_mode(&g, path, KG_VERIFY_NONE, 0) == 0);
+  const char *types[64];
+  const char *payloads[64];
+  char digits[64][8];
+  size_t done = 0;
+  while (done < count) {
+    size_t n = count - done < 64 ? count - done : 64;
+    for (size_t i = 0; i < n; i++) {
+      snprintf(digits[i], sizeof(digits[i]), "%zu", (done + i) % 1000);
+      types[i] = "TEACH";
+      payloads[i] = digits[i];
+    }
+    assert(kg_append_batch(&g, types, payloads, n) == 0);
+    done += n;
+  }
+  kg_close(&g);
+}
+
+static void flip_byte(const char *path, long offset) {
+  FILE *file = fopen(path, "r+b");
+  assert(file);
+  assert(fseek(file, offset, SEEK_SET) == 0);
+  int c = fgetc(file);
+  assert(c != EOF);
+  assert(fseek(file, offset, SEEK_SET) == 0);
+  fputc(c ^ 0x01, file);
+  fclose(file);
+}
+
+static void test_modes(void) {
+  printf("test_modes... ");
+  char path[] = "/tmp/kolibri_genome_openXXXXXX";
+  temp_path(path);
+  fill_genome(path, 3000);
+
+  /* NONE не подписывает хвост: проверки не было */
+  char tail[512];
+  tail_of(path, tail, sizeof(tail));
+  assert(access(tail, F_OK) != 0);
+
+  KolibriGenome full;
+  KolibriGenome g;
+  for (size_t threads = 1; threads <= 4; threads++) {
+    assert(open_mode(&g, path, KG_VERIFY_FULL, threads) == 0);
+    assert(g.next_index == 3000 && g.verified);
+    kg_close(&g);
+  }
+  assert(access(tail, F_OK) == 0);
+  assert(kg_open(&full, path, key, sizeof(key) - 1) == 0);
+
+  /* Все режимы восстанавливают одинаковое состояние хвоста */
+  KolibriGenomeVerify modes[] = {KG_VERIFY_TAIL, KG_VERIFY_NONE};
+  for (size_t m = 0; m < 2; m++) {
+    assert(open_mode(&g, path, modes[m], 0) == 0);
+    assert(g.next_index == full.next_index);
+    assert(memcmp(g.last_hash, full.last_hash, sizeof(g.last_hash)) == 0);
+    assert(memcmp(g.last_block, full.last_block, sizeof(g.last_block)) == 0);
+    assert(g.verified == (modes[m] == KG_VERIFY_TAIL));
+    kg_close(&g);
+  }
+  kg_close(&full);
+
+  /* Дописанные после закрытия блоки продолжают цепочку */
+  assert(open_mode(&g, path, KG_VERIFY_TAIL, 0) == 0);
+  assert(kg_append(&g, "TEACH", "7", NULL) == 0);
+  kg_close(&g);
+  assert(kg_verify_file(path, key, sizeof(key) - 1) == 0);
+  assert(open_mode(&g, path, KG_VERIFY_FULL, 0) == 0 && g.next_index == 3001);
+  kg_close(&g);
+
+  /* Пустой и отсутствующий журналы */
+  remove_genome(path);
+  assert(kg_verify_file(path, key, sizeof(key) - 1) == 1);
+  assert(open_mode(&g, path, KG_VERIFY_TAIL, 0) == 0 && g.next_index == 0);
+  kg_close(&g);
+  assert(kg_verify_file(path, key, sizeof(key) - 1) == 0);
+  remove_genome(path);
+  printf("OK\n");
+}
+
+static void test_tail_state(void) {
+  printf("test_tail_state... ");
+  char path[] = "/tmp/kolibri_genome_tailXXXXXX";
+  temp_path(path);
+  fill_genome(path, 500);
+  char tail[512];
+  tail_of(path, tail, sizeof(tail));
+
+  KolibriGenome g;
+  assert(open_mode(&g, path, KG_VERIFY_FULL, 0) == 0);
+  kg_close(&g);
+
+  /* Другой писатель дописал блоки, не обновив хвост */
+  char saved[80];
+  FILE *file = fopen(tail, "rb");
+  assert(file);
+  size_t saved_len = fread(saved, 1, sizeof(saved), file);
+  fclose(file);
+  assert(open_mode(&g, path, KG_VERIFY_NONE, 0) == 0);
+  assert(kg_append(&g, "TEACH", "1", NULL) == 0);
+  assert(kg_append(&g, "TEACH", "2", NULL) == 0);
+  kg_close(&g);
+  assert(open_mode(&g, path, KG_VERIFY_TAIL, 0) == 0 && g.next_index == 502);
+  kg_close(&g);
+
+  /* Испорченный дописанный блок ловится даже при верном хвосте */
+  file = fopen(tail, "wb");
+  assert(file);
+  assert(fwrite(saved, 1, saved_len, file) == saved_len);
+  fclose(file);
+  flip_byte(path, 501L * KOLIBRI_BLOCK_SIZE + 40);
+  assert(open_mode(&g, path, KG_VERIFY_TAIL, 0) == -1);
+  flip_byte(path, 501L * KOLIBRI_BLOCK_SIZE + 40);
+
+  /* Подделанный хвост отвергается: полная проверка находит порчу в начале */
+  flip_byte(path, 10L * KOLIBRI_BLOCK_SIZE + 40);
+  assert(open_mode(&g, path, KG_VERIFY_TAIL, 0) == 0);
+  kg_close(&g);
+  flip_byte(tail, 20);
+  assert(open_mode(&g, path, KG_VERIFY_TAIL, 0) == -1);
+  assert(open_mode(&g, path, KG_VERIFY_FULL, 0) == -1);
+  assert(kg_verify_file(path, key, sizeof(key) - 1) == -1);
+
+  /* Обрезанный блок и чужой ключ */
+  flip_byte(path, 10L * KOLIBRI_BLOCK_SIZE + 40);
+  assert(truncate(path, 502L * KOLIBRI_BLOCK_SIZE - 5) == 0);
+  assert(open_mode(&g, path, KG_VERIFY_NONE, 0) == -1);
+  assert(truncate(path, 400L * KOLIBRI_BLOCK_SIZE) == 0);
+  assert(open_mode(&g, path, KG_VERIFY_TAIL, 0) == 0 && g.next_index == 400);
+  kg_close(&g);
+  KolibriGenomeOpenOptions options = {KG_VERIFY_TAIL, 0};
+  const unsigned char other[] = "other-key";
+  assert(kg_open_ex(&g, path, other, sizeof(other) - 1, &options) == -1);
+
+  remove_genome(path);
+  printf("OK\n");
+}
+
+/* Время открытия; цепочка проверена и хвост покрывает все блоки */
+static double open_time(const char *path, KolibriGenomeVerify mode, uint64_t blocks) {
+  KolibriGenome g;
+  double start = now_seconds();
+  assert(open_mode(&g, path, mode, 0) == 0);
+  double elapsed = now_seconds() - start;
+  assert(g.verified && g.next_index == blocks && g.tail_blocks == blocks);
+  kg_close(&g);
+  return elapsed;
+}
+
+static void test_reopen_speed(void) {
+  printf("test_reopen_speed... ");
+  char path[] = "/tmp/kolibri_genome_speedXXXXXX";
+  temp_path(path);
+  fill_genome(path, 50000);
+
+  double full = open_time(path, KG_VERIFY_FULL, 50000);
+  double tail = open_time(path, KG_VERIFY_TAIL, 50000);
+  printf("full %.1f ms, tail %.3f ms... ", full * 1e3, tail * 1e3);
+
+  remove_genome(path);
+  printf("OK\n");
+}
+
+int main(void) {
+  printf("Running genome open tests...\n\n");
+
+  test_modes();
+  test_tail_state();
+  test_reopen_speed();
+
+  printf("\n✓ All genome open tests passed!\n");
+  return 0;
+}
@@ -0,0 +1,189 @@
+/*
+ * Tests for the CPU embedding backend of the gpu_encoder interface
+ */
+
+#include "kolibri_gpu_encoder.h"
+#include "test_util.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void init_cpu(const char *isa, size_t max_batch) {
+    if (isa) {
+        setenv("KOLIBRI_GPU_CPU_ISA", isa, 1);
+    } else {
+        unsetenv("KOLIBRI_GPU_CPU_ISA");
+    }
+    kolibri_gpu_config_t cfg = {
+        .backend = KOLIBRI_GPU_BACKEND_CPU,
+        .device_index = 0,
+        .max_batch = max_batch,
+    };
+    assert(kolibri_gpu_encoder_init(&cfg) == 0);
+    assert(strcmp(kolibri_gpu_backend_name(), "cpu") == 0);
+}
+
+/* Эталон: целочисленная статистика, те же формулы признаков */
+static void reference_embedding(const uint8_t *payload, size_t len, float *dst, size_t dims) {
+    memset(dst, 0, dims * sizeof(float));
+    if (len == 0) return;
+    uint64_t sum = 0, energy = 0, transitions = 0;
+    uint8_t minv = 255, maxv = 0;
+    for (size_t i = 0; i < len; i++) {
+        sum += payload[i];
+        energy += (uint64_t)payload[i] * payload[i];
+        if (payload[i] < minv) minv = payload[i];
+        if (payload[i] > maxv) maxv = payload[i];
+        if (i > 0 && payload[i] != payload[i - 1]) transitions++;
+    }
+    double mean = (double)sum / (double)len;
+    double variance = (double)energy / (double)len - mean * mean;
+    if (variance < 0.0) variance = 0.0;
+    float features[4] = {
+        (float)(mean / 255.0),
+        (float)(variance / (255.0 * 255.0)),
+        (float)((double)(maxv - minv) / 255.0),
+        (float)((double)transitions / (double)len),
+    };
+    memcpy(dst, features, (dims < 4 ? dims : 4) * sizeof(float));
+}
+
+static void fill_payload(uint8_t *data, size_t len, uint64_t seed) {
+    for (size_t i = 0; i < len; i++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        /* Серии одинаковых байтов, чтобы переходы были не в каждой позиции */
+        data[i] = (seed >> 60) < 4 && i > 0 ? data[i - 1] : (uint8_t)(seed >> 33);
+    }
+}
+
+static void test_kernels(void) {
+    printf("test_kernels... ");
+
+    static const size_t lengths[] = {0, 1, 2, 31, 32, 33, 63, 64, 65, 129, 1000, 300000};
+    const size_t count = sizeof(lengths) / sizeof(lengths[0]);
+    const char *isas[] = {"scalar", "avx2", "avx512"};
+
+    for (size_t k = 0; k < 3; k++) {
+        init_cpu(isas[k], 3);
+        const char *active = kolibri_gpu_cpu_isa();
+        assert(k == 0 ? strcmp(active, "scalar") == 0 : active != NULL);
+
+        for (size_t l = 0; l < count; l++) {
+            size_t len = lengths[l];
+            size_t stride = len + 7;  /* Полезная нагрузка не вплотную */
+            size_t blocks = 9;
+            uint8_t *payload = malloc(stride * blocks + 1);
+            assert(payload);
+            for (size_t b = 0; b < blocks; b++) fill_payload(payload + b * stride, len, b * 31 + len);
+
+            kolibri_gpu_embedding_batch_t out;
+            assert(kolibri_gpu_embedding_batch_alloc(&out, blocks, 6) == 0);
+            assert(out.stride % KOLIBRI_GPU_ROW_ALIGN == 0 &&
+                   (uintptr_t)out.data % KOLIBRI_GPU_ROW_ALIGN == 0);
+            kolibri_gpu_reason_batch_t in = {payload, stride, len, blocks};
+            assert(kolibri_gpu_encode_reason_blocks(&in, &out) == 0);
+
+            for (size_t b = 0; b < blocks; b++) {
+                float expected[6];
+                reference_embedding(payload + b * stride, len, expected, 6);
+                const float *row = (const float *)((const uint8_t *)out.data + b * out.stride);
+                assert(memcmp(row, expected, sizeof(expected)) == 0);
+            }
+            kolibri_gpu_embedding_batch_free(&out);
+            free(payload);
+        }
+    }
+    kolibri_gpu_encoder_shutdown();
+    printf("OK\n");
+}
+
+static void test_tokens_and_validation(void) {
+    printf("test_tokens_and_validation... ");
+    init_cpu(NULL, 0);
+
+    size_t count = 100000;
+    uint16_t *tokens = malloc(count * sizeof(uint16_t));
+    assert(tokens);
+    for (size_t i = 0; i < count; i++) tokens[i] = (uint16_t)(i * 37);
+
+    kolibri_gpu_embedding_batch_t out;
+    assert(kolibri_gpu_embedding_batch_alloc(&out, count, 3) == 0);
+    for (size_t i = 0; i < count; i++) ((float *)((uint8_t *)out.data + i * out.stride))[2] = 9.0f;
+    assert(kolibri_gpu_embed_tokens(tokens, count, &out) == 0);
+    for (size_t i = 0; i < count; i += 997) {
+        const float *row = (const float *)((const uint8_t *)out.data + i * out.stride);
+        assert(row[0] == (float)tokens[i] / 65535.0f && row[1] == 0.0f && row[2] == 0.0f);
+    }
+
+    /* Плотный одномерный выход */
+    float dense[5];
+    kolibri_gpu_embedding_batch_t flat = {dense, 1, sizeof(float), 5};
+    assert(kolibri_gpu_embed_tokens(tokens, 5, &flat) == 0);
+    assert(dense[4] == (float)tokens[4] / 65535.0f);
+
+    /* Неверный шаг, короткий выход и шаг полезной нагрузки */
+    kolibri_gpu_embedding_batch_t bad = {dense, 2, sizeof(float), 2};
+    assert(kolibri_gpu_embed_tokens(tokens, 2, &bad) == -1);
+    bad.stride = 2 * sizeof(float) + 1;
+    assert(kolibri_gpu_embed_tokens(tokens, 2, &bad) == -1);
+    assert(kolibri_gpu_embed_tokens(tokens, 6, &flat) == -1);
+    uint8_t payload[8] = {0};
+    kolibri_gpu_reason_batch_t in = {payload, 2, 4, 2};
+    assert(kolibri_gpu_encode_reason_blocks(&in, &out) == -1);
+    assert(kolibri_gpu_embedding_batch_alloc(&bad, 0, 4) == -1);
+
+    kolibri_gpu_embedding_batch_free(&out);
+    free(tokens);
+
+    /* Недоступный GPU переключается на CPU, а не на заглушку */
+    kolibri_gpu_config_t cuda = {KOLIBRI_GPU_BACKEND_CUDA, 0, 16};
+    assert(kolibri_gpu_encoder_init(&cuda) == 0);
+    assert(strcmp(kolibri_gpu_backend_name(), "cpu") == 0);
+    kolibri_gpu_encoder_shutdown();
+    assert(kolibri_gpu_backend_name() == NULL);
+    printf("OK\n");
+}
+
+static double encode_rate(const char *isa, const kolibri_gpu_reason_batch_t *in,
+                          kolibri_gpu_embedding_batch_t *out) {
+    init_cpu(isa, 64);
+    double start = now_seconds();
+    for (int r = 0; r < 5; r++) assert(kolibri_gpu_encode_reason_blocks(in, out) == 0);
+    double elapsed = now_seconds() - start;
+    return 5.0 * (double)(in->count * in->payload_len) / elapsed / 1e9;
+}
+
+static void test_throughput(void) {
+    printf("test_throughput... ");
+
+    size_t blocks = 4096, len = 4096;
+    uint8_t *payload = malloc(blocks * len);
+    assert(payload);
+    fill_payload(payload, blocks * len, 7);
+    kolibri_gpu_embedding_batch_t out;
+    assert(kolibri_gpu_embedding_batch_alloc(&out, blocks, 8) == 0);
+    kolibri_gpu_reason_batch_t in = {payload, len, len, blocks};
+
+    double scalar = encode_rate("scalar", &in, &out);
+    double best = encode_rate(NULL, &in, &out);
+    printf("scalar %.2f GB/s, %s %.2f GB/s... ", scalar, kolibri_gpu_cpu_isa(), best);
+
+    kolibri_gpu_encoder_shutdown();
+    kolibri_gpu_embedding_batch_free(&out);
+    free(payload);
+    printf("OK\n");
+}
+
+int main(void) {
+    printf("Running GPU encoder CPU backend tests...\n\n");
+
+    test_kernels();
+    test_tokens_and_validation();
+    test_throughput();
+
+    printf("\n✓ All GPU encoder tests passed!\n");
+    return 0;
+}
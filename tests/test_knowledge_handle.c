@@ -0,0 +1,227 @@
+/*
+ * Tests for the versioned knowledge handle: swap, reader lifetime, reload triggers
+ */
+
+#include "kolibri/knowledge_handle.h"
+#include "test_util.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static void write_doc(const char *root, const char *name, const char *text) {
+    char path[600];
+    snprintf(path, sizeof(path), "%s/%s", root, name);
+    FILE *file = fopen(path, "wb");
+    assert(file);
+    fputs(text, file);
+    fclose(file);
+}
+
+static int wait_for_version(KolibriKnowledgeHandle *handle, unsigned long long version, double timeout) {
+    double deadline = now_seconds() + timeout;
+    while (now_seconds() < deadline) {
+        if (kolibri_knowledge_handle_version(handle) >= version) {
+            return 1;
+        }
+        usleep(10000);
+    }
+    return 0;
+}
+
+static void test_swap_keeps_readers(void) {
+    printf("test_swap_keeps_readers... ");
+    char root[] = "/tmp/kolibri_handleXXXXXX";
+    assert(mkdtemp(root));
+    write_doc(root, "alpha.md", "# Альфа\nkolibri alpha\n");
+    write_doc(root, "beta.md", "# Бета\nkolibri beta\n");
+    const char *roots[1] = {root};
+    KolibriKnowledgeHandle *handle = kolibri_knowledge_handle_create(roots, 1U, 0U);
+    assert(handle);
+    assert(kolibri_knowledge_handle_version(handle) == 1U);
+
+    const KolibriKnowledgeVersion *old = kolibri_knowledge_acquire(handle);
+    assert(old->version == 1U && old->index.count == 2U);
+
+    write_doc(root, "gamma.md", "# Гамма\nkolibri gamma\n");
+    assert(kolibri_knowledge_reload(handle) == 0);
+    assert(kolibri_knowledge_handle_version(handle) == 2U);
+    assert(kolibri_knowledge_handle_live_versions(handle) == 2U);
+
+    /* Старая версия доступна, пока её держат */
+    const KolibriKnowledgeDocument *results[4];
+    double scores[4];
+    assert(old->index.count == 2U);
+    assert(kolibri_knowledge_search_legacy(&old->index, "gamma", 4U, results, scores) == 0U);
+
+    const KolibriKnowledgeVersion *fresh = kolibri_knowledge_acquire(handle);
+    assert(fresh->version == 2U && fresh->index.count == 3U);
+    assert(kolibri_knowledge_search_legacy(&fresh->index, "gamma", 4U, results, scores) == 1U);
+    kolibri_knowledge_release(fresh);
+
+    kolibri_knowledge_release(old);
+    assert(kolibri_knowledge_handle_live_versions(handle) == 1U);
+
+    kolibri_knowledge_handle_destroy(handle);
+    remove_tree(root);
+    printf("OK\n");
+}
+
+static void count_publish(const KolibriKnowledgeVersion *version, void *user) {
+    unsigned long long *last = (unsigned long long *)user;
+    *last = version->version;
+}
+
+static void test_failed_rebuild_keeps_version(void) {
+    printf("test_failed_rebuild_keeps_version... ");
+    char root[] = "/tmp/kolibri_handleXXXXXX";
+    assert(mkdtemp(root));
+    write_doc(root, "alpha.md", "# Альфа\nkolibri alpha\n");
+    write_doc(root, "beta.md", "# Бета\nkolibri beta\n");
+    const char *roots[1] = {root};
+    KolibriKnowledgeHandle *handle = kolibri_knowledge_handle_create(roots, 1U, 0U);
+    assert(handle);
+    unsigned long long published = 0U;
+    kolibri_knowledge_handle_on_publish(handle, count_publish, &published);
+
+    /* Пустая сборка не заменяет непустую версию */
+    char path[600];
+    snprintf(path, sizeof(path), "%s/alpha.md", root);
+    assert(unlink(path) == 0);
+    snprintf(path, sizeof(path), "%s/beta.md", root);
+    assert(unlink(path) == 0);
+    assert(kolibri_knowledge_reload(handle) == -1);
+    assert(kolibri_knowledge_handle_version(handle) == 1U);
+    assert(published == 0U);
+    assert(kolibri_knowledge_handle_live_versions(handle) == 1U);
+    const KolibriKnowledgeVersion *version = kolibri_knowledge_acquire(handle);
+    assert(version->index.count == 2U);
+    kolibri_knowledge_release(version);
+
+    write_doc(root, "gamma.md", "# Гамма\nkolibri gamma\n");
+    assert(kolibri_knowledge_reload(handle) == 0);
+    assert(kolibri_knowledge_handle_version(handle) == 2U);
+    assert(published == 2U);
+
+    kolibri_knowledge_handle_destroy(handle);
+    remove_tree(root);
+    printf("OK\n");
+}
+
+typedef struct {
+    KolibriKnowledgeHandle *handle;
+    atomic_int *stop;
+    size_t requests;
+    int failures;
+} Reader;
+
+static void *reader_main(void *arg) {
+    Reader *reader = (Reader *)arg;
+    unsigned long long last = 0U;
+    while (!atomic_load(reader->stop)) {
+        const KolibriKnowledgeVersion *version = kolibri_knowledge_acquire(reader->handle);
+        const KolibriKnowledgeDocument *results[4];
+        double scores[4];
+        /* Версии только растут, а документы версии не меняются под читателем */
+        size_t before = version->index.count;
+        size_t found = kolibri_knowledge_search_legacy(&version->index, "kolibri", 4U, results, scores);
+        if (version->version < last || found == 0U || version->index.count != before) {
+            reader->failures++;
+        }
+        last = version->version;
+        kolibri_knowledge_release(version);
+        reader->requests++;
+    }
+    return NULL;
+}
+
+static void test_reload_under_load(void) {
+    printf("test_reload_under_load... ");
+    char root[] = "/tmp/kolibri_handleXXXXXX";
+    assert(mkdtemp(root));
+    for (int i = 0; i < 20; ++i) {
+        char name[32];
+        char text[64];
+        snprintf(name, sizeof(name), "doc%d.md", i);
+        snprintf(text, sizeof(text), "# Документ %d\nkolibri doc%d\n", i, i);
+        write_doc(root, name, text);
+    }
+    const char *roots[1] = {root};
+    KolibriKnowledgeHandle *handle = kolibri_knowledge_handle_create(roots, 1U, 0U);
+    assert(handle);
+
+    enum { READERS = 4, RELOADS = 30 };
+    atomic_int stop;
+    atomic_init(&stop, 0);
+    pthread_t threads[READERS];
+    Reader readers[READERS];
+    for (int t = 0; t < READERS; ++t) {
+        readers[t].handle = handle;
+        readers[t].stop = &stop;
+        readers[t].requests = 0U;
+        readers[t].failures = 0;
+        assert(pthread_create(&threads[t], NULL, reader_main, &readers[t]) == 0);
+    }
+    for (int i = 0; i < RELOADS; ++i) {
+        assert(kolibri_knowledge_reload(handle) == 0);
+    }
+    atomic_store(&stop, 1);
+    size_t requests = 0U;
+    for (int t = 0; t < READERS; ++t) {
+        pthread_join(threads[t], NULL);
+        assert(readers[t].failures == 0);
+        requests += readers[t].requests;
+    }
+    assert(kolibri_knowledge_handle_version(handle) == 1U + RELOADS);
+    /* Все устаревшие версии освобождены последними читателями */
+    assert(kolibri_knowledge_handle_live_versions(handle) == 1U);
+    printf("%zu запросов во время %d перезагрузок... ", requests, RELOADS);
+
+    kolibri_knowledge_handle_destroy(handle);
+    remove_tree(root);
+    printf("OK\n");
+}
+
+static void test_background_triggers(void) {
+    printf("test_background_triggers... ");
+    char root[] = "/tmp/kolibri_handleXXXXXX";
+    assert(mkdtemp(root));
+    write_doc(root, "alpha.md", "# Альфа\nkolibri alpha\n");
+    const char *roots[1] = {root};
+
+    /* Запрос через API: сборка в фоне, вызывающий не ждёт */
+    KolibriKnowledgeHandle *handle = kolibri_knowledge_handle_create(roots, 1U, 0U);
+    assert(handle);
+    kolibri_knowledge_request_reload(handle);
+    assert(wait_for_version(handle, 2U, 5.0));
+    kolibri_knowledge_handle_destroy(handle);
+
+    /* Слежение за каталогом: новая версия без явного запроса */
+    handle = kolibri_knowledge_handle_create(roots, 1U, 50U);
+    assert(handle);
+    usleep(150000);
+    assert(kolibri_knowledge_handle_version(handle) == 1U);
+    write_doc(root, "beta.txt", "kolibri beta\n");
+    assert(wait_for_version(handle, 2U, 5.0));
+    const KolibriKnowledgeVersion *version = kolibri_knowledge_acquire(handle);
+    assert(version->index.count == 2U);
+    kolibri_knowledge_release(version);
+    kolibri_knowledge_handle_destroy(handle);
+
+    remove_tree(root);
+    printf("OK\n");
+}
+
+int main(void) {
+    printf("Running knowledge handle tests...\n\n");
+    test_swap_keeps_readers();
+    test_failed_rebuild_keeps_version();
+    test_reload_under_load();
+    test_background_triggers();
+    printf("\n✓ All knowledge handle tests passed!\n");
+    return 0;
+}
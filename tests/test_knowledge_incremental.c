@@ -0,0 +1,261 @@
+/*
+ * Tests for incremental knowledge indexing: parallel build, manifest reuse,
+ * refresh after edits, additions and removals
+ */
+
+#include "kolibri/knowledge_index.h"
+#include "test_util.h"
+
+#include <assert.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+static const char *WORDS[] = {"kolibri", "formula", "genome", "swarm", "digit", "memory",
+                              "index", "search", "vector", "token", "query", "node",
+                              "queue", "script", "pool", "relay"};
+
+static void write_doc(const char *root, size_t n, const char *extra) {
+    char dir[512];
+    char path[600];
+    snprintf(dir, sizeof(dir), "%s/part%zu", root, n % 7U);
+    mkdir(dir, 0777);
+    snprintf(path, sizeof(path), "%s/doc%zu.md", dir, n);
+    FILE *file = fopen(path, "wb");
+    assert(file);
+    fprintf(file, "# Document %zu\n", n);
+    /* Меньше 32 разных слов: вектор не зависит от отсечения */
+    for (size_t i = 0; i < 6U; ++i) {
+        fprintf(file, "%s ", WORDS[(n * 3U + i * i) % 16U]);
+    }
+    fprintf(file, "unique%zu %s\n", n, extra ? extra : "");
+    fclose(file);
+}
+
+static void doc_path(const char *root, size_t n, char *path, size_t size) {
+    snprintf(path, size, "%s/part%zu/doc%zu.md", root, n % 7U, n);
+}
+
+static void make_corpus(char *root, size_t docs) {
+    assert(mkdtemp(root));
+    for (size_t i = 0; i < docs; ++i) {
+        write_doc(root, i, NULL);
+    }
+}
+
+static const KolibriKnowledgeDoc *find_doc(const KolibriKnowledgeIndex *index, const char *source) {
+    for (size_t i = 0; i < kolibri_knowledge_index_document_count(index); ++i) {
+        const KolibriKnowledgeDoc *doc = kolibri_knowledge_index_document(index, i);
+        if (strcmp(doc->source, source) == 0) {
+            return doc;
+        }
+    }
+    return NULL;
+}
+
+/* Индексы токенов различаются между сборками: сравниваем по тексту */
+static void assert_same_index(const KolibriKnowledgeIndex *a, const KolibriKnowledgeIndex *b) {
+    assert(kolibri_knowledge_index_document_count(a) == kolibri_knowledge_index_document_count(b));
+    assert(kolibri_knowledge_index_token_count(a) == kolibri_knowledge_index_token_count(b));
+    for (size_t i = 0; i < kolibri_knowledge_index_document_count(a); ++i) {
+        const KolibriKnowledgeDoc *da = kolibri_knowledge_index_document(a, i);
+        const KolibriKnowledgeDoc *db = find_doc(b, da->source);
+        assert(db);
+        assert(strcmp(da->id, db->id) == 0);
+        assert(strcmp(da->title, db->title) == 0);
+        assert(strcmp(da->content, db->content) == 0);
+        assert(da->vector_size == db->vector_size);
+        assert(fabsf(da->norm - db->norm) < 1e-5f);
+        for (size_t j = 0; j < da->vector_size; ++j) {
+            const KolibriKnowledgeToken *ta = kolibri_knowledge_index_token(a, da->vector[j].token_index);
+            const KolibriKnowledgeToken *tb = kolibri_knowledge_index_token(b, db->vector[j].token_index);
+            assert(strcmp(ta->token, tb->token) == 0);
+            assert(fabsf(ta->idf - tb->idf) < 1e-5f);
+            assert(fabsf(da->vector[j].weight - db->vector[j].weight) < 1e-6f);
+        }
+    }
+}
+
+static KolibriKnowledgeIndex *fresh_build(const char *root, size_t threads) {
+    const char *roots[1] = {root};
+    KolibriKnowledgeBuildOptions options = {threads, NULL};
+    KolibriKnowledgeIndex *index = NULL;
+    assert(kolibri_knowledge_index_build(roots, 1U, 256U, &options, &index, NULL) == 0);
+    return index;
+}
+
+static void test_parallel_matches_serial(void) {
+    printf("test_parallel_matches_serial... ");
+    char root[] = "/tmp/kolibri_indexXXXXXX";
+    make_corpus(root, 300U);
+
+    KolibriKnowledgeIndex *serial = fresh_build(root, 1U);
+    KolibriKnowledgeIndex *parallel = fresh_build(root, 4U);
+    assert(kolibri_knowledge_index_document_count(serial) == 300U);
+    assert_same_index(serial, parallel);
+    for (size_t i = 0; i < 300U; ++i) {
+        const KolibriKnowledgeDoc *a = kolibri_knowledge_index_document(serial, i);
+        const KolibriKnowledgeDoc *b = kolibri_knowledge_index_document(parallel, i);
+        assert(strcmp(a->source, b->source) == 0);
+    }
+
+    size_t indices[3];
+    float scores[3];
+    size_t found = 0U;
+    assert(kolibri_knowledge_search(parallel, "unique42", 3U, indices, scores, &found) == 0);
+    assert(found == 1U);
+    assert(strcmp(kolibri_knowledge_index_document(parallel, indices[0])->id, "doc42") == 0);
+
+    kolibri_knowledge_index_destroy(serial);
+    kolibri_knowledge_index_destroy(parallel);
+    remove_tree(root);
+    printf("OK\n");
+}
+
+static void test_refresh_matches_rebuild(void) {
+    printf("test_refresh_matches_rebuild... ");
+    char root[] = "/tmp/kolibri_indexXXXXXX";
+    make_corpus(root, 200U);
+    const char *roots[1] = {root};
+    KolibriKnowledgeBuildOptions options = {2U, NULL};
+    KolibriKnowledgeIndex *index = NULL;
+    KolibriKnowledgeBuildStats stats;
+    assert(kolibri_knowledge_index_build(roots, 1U, 256U, &options, &index, &stats) == 0);
+    assert(stats.files_parsed == 200U);
+
+    assert(kolibri_knowledge_index_refresh(index, &stats) == 0);
+    assert(stats.files_seen == 200U && stats.files_parsed == 0U && stats.files_unchanged == 200U);
+    assert(stats.vectors_updated == 0U);
+
+    /* Правка одного файла: число документов то же, пересчёт локальный */
+    write_doc(root, 17U, "freshword freshword");
+    assert(kolibri_knowledge_index_refresh(index, &stats) == 0);
+    assert(stats.files_parsed == 1U && stats.files_removed == 0U);
+    assert(stats.vectors_updated < 200U);
+    KolibriKnowledgeIndex *rebuilt = fresh_build(root, 1U);
+    assert_same_index(index, rebuilt);
+    kolibri_knowledge_index_destroy(rebuilt);
+
+    /* Новое время без изменения содержимого: файл не разбирается */
+    char path[600];
+    doc_path(root, 17U, path, sizeof(path));
+    struct timespec times[2] = {{0, UTIME_OMIT}, {12345, 0}};
+    assert(utimensat(AT_FDCWD, path, times, 0) == 0);
+    assert(kolibri_knowledge_index_refresh(index, &stats) == 0);
+    assert(stats.files_parsed == 0U && stats.files_unchanged == 200U);
+
+    /* Добавление и удаление */
+    write_doc(root, 500U, NULL);
+    write_doc(root, 501U, "freshword");
+    doc_path(root, 3U, path, sizeof(path));
+    assert(unlink(path) == 0);
+    doc_path(root, 199U, path, sizeof(path));
+    assert(unlink(path) == 0);
+    assert(kolibri_knowledge_index_refresh(index, &stats) == 0);
+    assert(stats.files_parsed == 2U && stats.files_removed == 2U);
+    rebuilt = fresh_build(root, 3U);
+    assert_same_index(index, rebuilt);
+    kolibri_knowledge_index_destroy(rebuilt);
+
+    size_t indices[4];
+    float scores[4];
+    size_t found = 0U;
+    assert(kolibri_knowledge_search(index, "freshword", 4U, indices, scores, &found) == 0);
+    assert(found == 2U);
+
+    kolibri_knowledge_index_destroy(index);
+    remove_tree(root);
+    printf("OK\n");
+}
+
+static void test_manifest_reuse(void) {
+    printf("test_manifest_reuse... ");
+    char root[] = "/tmp/kolibri_indexXXXXXX";
+    make_corpus(root, 120U);
+    char manifest[] = "/tmp/kolibri_manifestXXXXXX";
+    temp_name(manifest);
+
+    const char *roots[1] = {root};
+    KolibriKnowledgeBuildOptions options = {0U, manifest};
+    KolibriKnowledgeIndex *first = NULL;
+    KolibriKnowledgeBuildStats stats;
+    assert(kolibri_knowledge_index_build(roots, 1U, 256U, &options, &first, &stats) == 0);
+    assert(stats.files_parsed == 120U);
+    kolibri_knowledge_index_destroy(first);
+
+    /* Повторный запуск: всё берётся из манифеста */
+    KolibriKnowledgeIndex *second = NULL;
+    assert(kolibri_knowledge_index_build(roots, 1U, 256U, &options, &second, &stats) == 0);
+    assert(stats.files_parsed == 0U && stats.files_unchanged == 120U && stats.vectors_updated == 0U);
+    KolibriKnowledgeIndex *rebuilt = fresh_build(root, 1U);
+    assert_same_index(second, rebuilt);
+    kolibri_knowledge_index_destroy(second);
+
+    write_doc(root, 5U, "changed");
+    KolibriKnowledgeIndex *third = NULL;
+    assert(kolibri_knowledge_index_build(roots, 1U, 256U, &options, &third, &stats) == 0);
+    assert(stats.files_parsed == 1U);
+    kolibri_knowledge_index_destroy(rebuilt);
+    rebuilt = fresh_build(root, 1U);
+    assert_same_index(third, rebuilt);
+    kolibri_knowledge_index_destroy(third);
+
+    /* Испорченный манифест: полная сборка вместо ошибки */
+    FILE *file = fopen(manifest, "r+b");
+    assert(file);
+    assert(fseek(file, 64L, SEEK_SET) == 0);
+    fputc('!', file);
+    fclose(file);
+    KolibriKnowledgeIndex *fourth = NULL;
+    assert(kolibri_knowledge_index_build(roots, 1U, 256U, &options, &fourth, &stats) == 0);
+    assert(stats.files_parsed == 120U);
+    assert_same_index(fourth, rebuilt);
+    kolibri_knowledge_index_destroy(fourth);
+    kolibri_knowledge_index_destroy(rebuilt);
+
+    unlink(manifest);
+    remove_tree(root);
+    printf("OK\n");
+}
+
+static void test_refresh_speed(void) {
+    printf("test_refresh_speed... ");
+    char root[] = "/tmp/kolibri_indexXXXXXX";
+    enum { DOCS = 5000 };
+    make_corpus(root, DOCS);
+    const char *roots[1] = {root};
+    KolibriKnowledgeIndex *index = NULL;
+
+    double start = now_seconds();
+    assert(kolibri_knowledge_index_build(roots, 1U, 256U, NULL, &index, NULL) == 0);
+    double built = now_seconds();
+
+    write_doc(root, 1234U, "rareword");
+    KolibriKnowledgeBuildStats stats;
+    double refresh_start = now_seconds();
+    assert(kolibri_knowledge_index_refresh(index, &stats) == 0);
+    double refreshed = now_seconds();
+    assert(stats.files_parsed == 1U);
+    assert(stats.vectors_updated < 10U);
+    printf("сборка %.1f мс, обновление %.1f мс (в %.1f раз быстрее)... ", (built - start) * 1e3,
+           (refreshed - refresh_start) * 1e3, (built - start) / (refreshed - refresh_start));
+
+    kolibri_knowledge_index_destroy(index);
+    remove_tree(root);
+    printf("OK\n");
+}
+
+int main(void) {
+    printf("Running incremental knowledge index tests...\n\n");
+    test_parallel_matches_serial();
+    test_refresh_matches_rebuild();
+    test_manifest_reuse();
+    test_refresh_speed();
+    printf("\n✓ All incremental knowledge index tests passed!\n");
+    return 0;
+}
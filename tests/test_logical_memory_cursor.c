@@ -0,0 +1,354 @@
+/*
+ * Tests for streaming materialization, the cell directory and the
+ * byte-budgeted cache of LogicalMemory, and replacing cells under readers
+ */
+
+#include "kolibri/logical_memory.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ULL;
+
+static uint64_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+/* Эталон: последовательность через snprintf */
+static size_t reference_sequence(int start, int step, size_t count, char *out, size_t cap) {
+    size_t pos = 0;
+    long long value = start;
+    for (size_t i = 0; i < count; i++) {
+        int n = snprintf(out + pos, cap - pos, "%lld", value);
+        assert(n > 0 && (size_t)n < cap - pos);
+        pos += (size_t)n;
+        value += step;
+    }
+    return pos;
+}
+
+/* Прочитать курсор кусками случайного размера */
+static void read_in_chunks(LogicCursor *cursor, char *out, size_t expected) {
+    size_t pos = 0, n;
+    char chunk[97];
+    while ((n = lm_cursor_read(cursor, chunk, 1 + next_random() % sizeof(chunk))) > 0) {
+        assert(pos + n <= expected);
+        memcpy(out + pos, chunk, n);
+        pos += n;
+    }
+    assert(pos == expected);
+}
+
+static void test_sequence_cursor(void) {
+    printf("test_sequence_cursor... ");
+
+    static const int cases[][3] = {
+        {1, 1, 1000}, {-50, 3, 400}, {1000, -7, 500}, {0, 0, 10},
+        {2147483000, 1, 600}, {-2147483647, 99999999, 40}, {5, -1000000, 50},
+    };
+    size_t cap = 1 << 16;
+    char *expected = malloc(cap);
+    char *actual = malloc(cap);
+    assert(expected && actual);
+
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        LogicExpression *seq = lm_logic_sequence(cases[c][0], cases[c][1], (size_t)cases[c][2]);
+        assert(seq);
+        size_t len = reference_sequence(cases[c][0], cases[c][1], (size_t)cases[c][2], expected, cap);
+        assert(seq->materialized_size == len);
+
+        LogicCursor cursor;
+        assert(lm_cursor_open_logic(seq, &cursor) == 0);
+        assert(lm_cursor_size(&cursor) == len);
+        read_in_chunks(&cursor, actual, len);
+        assert(memcmp(actual, expected, len) == 0);
+
+        /* Произвольный доступ */
+        for (int i = 0; i < 200; i++) {
+            size_t offset = next_random() % (len + 1);
+            assert(lm_cursor_seek(&cursor, offset) == 0);
+            char buf[40];
+            size_t n = lm_cursor_read(&cursor, buf, sizeof(buf));
+            size_t want = len - offset < sizeof(buf) ? len - offset : sizeof(buf);
+            assert(n == want && memcmp(buf, expected + offset, n) == 0);
+            assert(lm_cursor_tell(&cursor) == offset + n);
+        }
+        assert(lm_cursor_seek(&cursor, len + 1) == -1);
+
+        lm_destroy_logic(seq);
+    }
+
+    free(expected);
+    free(actual);
+    printf("OK\n");
+}
+
+static void test_large_cells(void) {
+    printf("test_large_cells... ");
+
+    /* ~1 ТБ материализации: доступ без развёртывания в память */
+    LogicExpression *big = lm_logic_repeat("kolibri", (size_t)150000000000ULL);
+    assert(big);
+    LogicCursor cursor;
+    assert(lm_cursor_open_logic(big, &cursor) == 0);
+    assert(lm_cursor_size(&cursor) == (size_t)1050000000000ULL);
+    assert(lm_cursor_seek(&cursor, lm_cursor_size(&cursor) - 5) == 0);
+    char buf[64];
+    assert(lm_cursor_read(&cursor, buf, sizeof(buf)) == 5 && memcmp(buf, "libri", 5) == 0);
+    assert(lm_cursor_seek(&cursor, 12) == 0);
+    assert(lm_cursor_read(&cursor, buf, 10) == 10 && memcmp(buf, "rikolibrik", 10) == 0);
+
+    /* Миллиард чисел: точный размер и элемент по смещению */
+    LogicExpression *seq = lm_logic_sequence(0, 1, 1000000000);
+    assert(seq);
+    assert(lm_cursor_open_logic(seq, &cursor) == 0);
+    /* 10*1 + 90*2 + 900*3 + ... + 900000000*9 */
+    assert(lm_cursor_size(&cursor) == 8888888890ULL);
+    assert(lm_cursor_seek(&cursor, lm_cursor_size(&cursor) - 18) == 0);
+    assert(lm_cursor_read(&cursor, buf, sizeof(buf)) == 18);
+    assert(memcmp(buf, "999999998999999999", 18) == 0);
+
+    /* Композиция из больших частей */
+    LogicExpression *tail = lm_logic_constant("END");
+    LogicExpression *comp = lm_logic_compose(seq, tail);
+    assert(comp);
+    assert(lm_cursor_open_logic(comp, &cursor) == 0);
+    assert(lm_cursor_size(&cursor) == 8888888893ULL);
+    assert(lm_cursor_seek(&cursor, 8888888890ULL - 9) == 0);
+    assert(lm_cursor_read(&cursor, buf, sizeof(buf)) == 12);
+    assert(memcmp(buf, "999999999END", 12) == 0);
+
+    /* Целиком в буфер такие ячейки не материализуются */
+    LogicalMemory *mem = lm_create_memory();
+    assert(mem);
+    assert(lm_store_logic(mem, "big", big) == 0);
+    assert(lm_predict_size(mem, "big") == (size_t)1050000000000ULL);
+    assert(lm_materialize(mem, "big", buf, sizeof(buf)) == -1);
+    assert(lm_cursor_open(mem, "big", &cursor) == 0);
+    assert(lm_cursor_read(&cursor, buf, 7) == 7 && memcmp(buf, "kolibri", 7) == 0);
+    lm_cursor_close(&cursor);
+
+    lm_destroy_memory(mem);
+    lm_destroy_logic(comp);
+    printf("OK\n");
+}
+
+static void test_directory(void) {
+    printf("test_directory... ");
+
+    LogicalMemory *mem = lm_create_memory();
+    assert(mem);
+
+    char id[64];
+    for (int i = 0; i < LM_INLINE_CELLS - 1; i++) {
+        snprintf(id, sizeof(id), "cell_%d", i);
+        assert(lm_store_logic(mem, id, lm_logic_sequence(i, 1, 3)) == 0);
+    }
+
+    /* Ячейка, дописанная в cells[] напрямую, тоже находится */
+    LogicCell *direct = &mem->cells[mem->cell_count];
+    snprintf(direct->id, sizeof(direct->id), "direct");
+    direct->logic = lm_logic_constant("direct-value");
+    mem->cell_count++;
+
+    /* Дальше память растёт сегментами */
+    for (int i = 0; i < 3 * LM_SEGMENT_CELLS; i++) {
+        snprintf(id, sizeof(id), "grown_%d", i);
+        assert(lm_store_logic(mem, id, lm_logic_repeat("g", (size_t)i + 1)) == 0);
+    }
+    assert(mem->cell_count == LM_INLINE_CELLS + 3 * LM_SEGMENT_CELLS);
+
+    char out[64];
+    for (int i = 0; i < LM_INLINE_CELLS - 1; i += 37) {
+        snprintf(id, sizeof(id), "cell_%d", i);
+        char expected[64];
+        snprintf(expected, sizeof(expected), "%d%d%d", i, i + 1, i + 2);
+        assert(lm_materialize(mem, id, out, sizeof(out)) == (int)strlen(expected));
+        assert(strcmp(out, expected) == 0);
+    }
+    assert(lm_materialize(mem, "direct", out, sizeof(out)) == 12);
+    assert(strcmp(out, "direct-value") == 0);
+    for (int i = 0; i < 3 * LM_SEGMENT_CELLS; i += 101) {
+        snprintf(id, sizeof(id), "grown_%d", i);
+        assert(lm_predict_size(mem, id) == (size_t)i + 1);
+        assert(lm_find_cell(mem, id) == lm_cell_at(mem, LM_INLINE_CELLS + (size_t)i));
+    }
+    assert(lm_find_cell(mem, "missing") == NULL);
+
+    /* Замена логики и зависимости */
+    assert(lm_materialize(mem, "grown_2", out, sizeof(out)) == 3);
+    assert(lm_put_logic(mem, "grown_2", lm_logic_constant("replaced")) == 0);
+    assert(lm_materialize(mem, "grown_2", out, sizeof(out)) == 8 && strcmp(out, "replaced") == 0);
+    assert(lm_add_dependency(mem, "grown_2", "cell_0") == 0);
+    assert(lm_find_cell(mem, "grown_2")->dependency_count == 1);
+    assert(lm_add_dependency(mem, "missing", "cell_0") == -1);
+    assert(lm_materialize(mem, "missing", out, sizeof(out)) == -1);
+
+    lm_destroy_memory(mem);
+    printf("OK\n");
+}
+
+static void test_cache_budget(void) {
+    printf("test_cache_budget... ");
+
+    LogicalMemory *mem = lm_create_memory();
+    assert(mem);
+    lm_set_cache_budget(mem, 2500);
+
+    char id[16];
+    for (int i = 0; i < 4; i++) {
+        snprintf(id, sizeof(id), "r%d", i);
+        assert(lm_store_logic(mem, id, lm_logic_repeat("ab", 500)) == 0);
+    }
+
+    char *out = malloc(2048);
+    assert(out);
+    LogicalMemoryStats stats;
+
+    /* Бюджет вмещает две ячейки по 1000 байт */
+    assert(lm_materialize(mem, "r0", out, 2048) == 1000);
+    assert(lm_materialize(mem, "r1", out, 2048) == 1000);
+    assert(lm_materialize(mem, "r0", out, 2048) == 1000);  /* r0 свежее r1 */
+    assert(lm_materialize(mem, "r2", out, 2048) == 1000);  /* вытесняет r1 */
+    lm_get_stats(mem, &stats);
+    assert(stats.cache_hits == 1 && stats.cache_misses == 3);
+    assert(stats.cache_evictions == 1 && stats.cache_bytes == 2000);
+    assert(mem->cells[0].cache_valid && !mem->cells[1].cache_valid && mem->cells[2].cache_valid);
+
+    /* Результат из кэша совпадает с материализацией */
+    assert(lm_materialize(mem, "r2", out, 2048) == 1000);
+    assert(strlen(out) == 1000 && memcmp(out, "abab", 4) == 0 && memcmp(out + 996, "abab", 4) == 0);
+    assert(lm_materialize(mem, "r2", out, 1000) == -1);
+
+    /* Уменьшение бюджета вытесняет сразу; ноль отключает кэш */
+    lm_set_cache_budget(mem, 1000);
+    lm_get_stats(mem, &stats);
+    assert(stats.cache_bytes == 1000 && stats.cached_cells == 1);
+    lm_set_cache_budget(mem, 0);
+    assert(lm_materialize(mem, "r3", out, 2048) == 1000);
+    lm_get_stats(mem, &stats);
+    assert(stats.cache_bytes == 0 && stats.cached_cells == 0);
+    assert(stats.cache_hit_rate == 100 * stats.cache_hits / (stats.cache_hits + stats.cache_misses));
+
+    free(out);
+    lm_destroy_memory(mem);
+    printf("OK\n");
+}
+
+static void test_replace_under_cursor(void) {
+    printf("test_replace_under_cursor... ");
+
+    LogicalMemory *mem = lm_create_memory();
+    assert(mem);
+    assert(lm_store_logic(mem, "cell", lm_logic_repeat("old", 1000)) == 0);
+
+    /* Курсор держит старую логику после замены ячейки */
+    LogicCursor cursor;
+    assert(lm_cursor_open(mem, "cell", &cursor) == 0);
+    assert(lm_put_logic(mem, "cell", lm_logic_constant("new")) == 0);
+    char buf[8];
+    assert(lm_cursor_seek(&cursor, 2997) == 0);
+    assert(lm_cursor_read(&cursor, buf, sizeof(buf)) == 3 && memcmp(buf, "old", 3) == 0);
+    lm_cursor_close(&cursor);
+    assert(lm_cursor_read(&cursor, buf, sizeof(buf)) == 0);
+
+    assert(lm_materialize(mem, "cell", buf, sizeof(buf)) == 3 && strcmp(buf, "new") == 0);
+
+    lm_destroy_memory(mem);
+    printf("OK\n");
+}
+
+typedef struct {
+    LogicalMemory *mem;
+    atomic_int *stop;
+    int failures;
+} ReplaceReader;
+
+/* Любое прочитанное значение - целиком одна из записанных версий */
+static int valid_version(const char *data, size_t len) {
+    if (len != 400) return 0;
+    for (size_t i = 1; i < len; i++) {
+        if (data[i] != data[0]) return 0;
+    }
+    return data[0] >= 'a' && data[0] <= 'z';
+}
+
+static void *replace_reader_main(void *arg) {
+    ReplaceReader *reader = (ReplaceReader *)arg;
+    char buf[512];
+    size_t round = 0;
+    while (!atomic_load(reader->stop)) {
+        if (round++ % 2 == 0) {
+            int n = lm_materialize(reader->mem, "hot", buf, sizeof(buf));
+            if (n < 0 || !valid_version(buf, (size_t)n)) reader->failures++;
+        } else {
+            LogicCursor cursor;
+            if (lm_cursor_open(reader->mem, "hot", &cursor) != 0) {
+                reader->failures++;
+                continue;
+            }
+            size_t len = 0, n;
+            while ((n = lm_cursor_read(&cursor, buf + len, 64)) > 0) len += n;
+            if (!valid_version(buf, len)) reader->failures++;
+            lm_cursor_close(&cursor);
+        }
+    }
+    return NULL;
+}
+
+static void test_concurrent_replace(void) {
+    printf("test_concurrent_replace... ");
+
+    LogicalMemory *mem = lm_create_memory();
+    assert(mem);
+    assert(lm_store_logic(mem, "hot", lm_logic_repeat("a", 400)) == 0);
+
+    enum { READERS = 4, PUTS = 20000 };
+    atomic_int stop;
+    atomic_init(&stop, 0);
+    pthread_t threads[READERS];
+    ReplaceReader readers[READERS];
+    for (int t = 0; t < READERS; t++) {
+        readers[t].mem = mem;
+        readers[t].stop = &stop;
+        readers[t].failures = 0;
+        assert(pthread_create(&threads[t], NULL, replace_reader_main, &readers[t]) == 0);
+    }
+    for (int i = 0; i < PUTS; i++) {
+        char pattern[2] = {(char)('a' + i % 26), '\0'};
+        assert(lm_put_logic(mem, "hot", lm_logic_repeat(pattern, 400)) == 0);
+    }
+    atomic_store(&stop, 1);
+    for (int t = 0; t < READERS; t++) {
+        pthread_join(threads[t], NULL);
+        assert(readers[t].failures == 0);
+    }
+
+    LogicalMemoryStats stats;
+    assert(lm_get_stats(mem, &stats) == 0);
+    assert(stats.total_cells == 1 && stats.predicted_data_size == 400);
+
+    lm_destroy_memory(mem);
+    printf("OK\n");
+}
+
+int main(void) {
+    printf("Running logical memory cursor tests...\n\n");
+
+    test_sequence_cursor();
+    test_large_cells();
+    test_directory();
+    test_cache_budget();
+    test_replace_under_cursor();
+    test_concurrent_replace();
+
+    printf("\n✓ All logical memory cursor tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,364 @@
+/*
+ * Tests for the n-gram language model and the generator built on it
+ */
+
+#include "kolibri/generation.h"
+#include "kolibri/ngram.h"
+#include "test_util.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static const char *training[] = {
+    "кот сидит на ковре.",
+    "кот сидит на ковре и спит",
+    "собака сидит у двери",
+    "кот спит на диване, собака спит у двери",
+};
+
+static KolibriNgramModel *build_model(unsigned order) {
+    KolibriNgramBuilder *builder = k_ngram_builder_create(order);
+    assert(builder);
+    for (size_t i = 0; i < sizeof(training) / sizeof(training[0]); i++) {
+        assert(k_ngram_builder_add_text(builder, training[i], strlen(training[i])) == 0);
+    }
+    KolibriNgramModel *model = k_ngram_build(builder);
+    assert(model);
+    k_ngram_builder_destroy(builder);
+    return model;
+}
+
+static uint32_t id_of(const KolibriNgramModel *model, const char *word) {
+    uint32_t id = k_ngram_lookup(model, word, strlen(word));
+    assert(id != KOLIBRI_NGRAM_UNK);
+    return id;
+}
+
+static void test_build_and_query(void) {
+    printf("test_build_and_query... ");
+
+    KolibriNgramModel *model = build_model(3);
+    KolibriNgramInfo info;
+    k_ngram_get_info(model, &info);
+    assert(info.order == 3);
+    assert(info.vocab_size == 11);  /* 10 слов + <unk> */
+    assert(info.total_tokens == 22);
+    assert(info.ngrams[2] > 0 && info.ngrams[3] > 0 && !info.mapped);
+
+    assert(strcmp(k_ngram_word(model, id_of(model, "ковре")), "ковре") == 0);
+    assert(k_ngram_lookup(model, "мышь", 8) == KOLIBRI_NGRAM_UNK);
+    assert(k_ngram_word(model, 1000) == NULL);
+
+    /* Токенизация по правилам корпуса */
+    uint32_t ids[8];
+    const char *text = "Кот, сидит! на ковре";
+    assert(k_ngram_tokenize(model, text, strlen(text), ids, 8) == 4);
+    assert(ids[0] == KOLIBRI_NGRAM_UNK && ids[1] == id_of(model, "сидит"));
+    assert(k_ngram_tokenize(model, text, strlen(text), NULL, 0) == 4);
+
+    /* Контекст важнее частоты: после "сидит" чаще "на", после "кот сидит" - тоже */
+    uint32_t history[2] = {id_of(model, "кот"), id_of(model, "сидит")};
+    double p_na = k_ngram_logprob(model, history, 2, id_of(model, "на"));
+    double p_u = k_ngram_logprob(model, history, 2, id_of(model, "у"));
+    double p_na_unigram = k_ngram_logprob(model, NULL, 0, id_of(model, "на"));
+    assert(p_na > p_u && p_na > p_na_unigram);
+
+    /* Распределение нормировано с точностью квантования */
+    double sum = 0.0;
+    for (uint32_t w = 0; w < info.vocab_size; w++) sum += exp2(k_ngram_logprob(model, history, 2, w));
+    assert(sum > 0.95 && sum < 1.05);
+
+    KolibriNgramChoice top[KOLIBRI_NGRAM_MAX_TOP];
+    size_t n = k_ngram_top(model, history, 2, top, 3);
+    assert(n == 3 && top[0].word == id_of(model, "на"));
+    assert(top[0].logprob >= top[1].logprob && top[1].logprob >= top[2].logprob);
+    assert(k_ngram_top(model, history, 2, top, 100) == info.vocab_size - 1);
+
+    k_ngram_free(model);
+    printf("OK\n");
+}
+
+static void test_save_load(void) {
+    printf("test_save_load... ");
+
+    char path[] = "/tmp/kolibri_ngram_XXXXXX";
+    temp_path(path);
+
+    KolibriNgramModel *built = build_model(4);
+    assert(k_ngram_save(built, path) == 0);
+    KolibriNgramModel *loaded = k_ngram_load(path);
+    assert(loaded);
+
+    KolibriNgramInfo a, b;
+    k_ngram_get_info(built, &a);
+    k_ngram_get_info(loaded, &b);
+    assert(b.mapped && a.bytes == b.bytes && a.vocab_size == b.vocab_size);
+
+    uint32_t history[3] = {id_of(loaded, "собака"), id_of(loaded, "спит"), id_of(loaded, "у")};
+    for (uint32_t w = 0; w < a.vocab_size; w++) {
+        assert(k_ngram_logprob(built, history, 3, w) == k_ngram_logprob(loaded, history, 3, w));
+    }
+
+    /* Одинаковый seed - одинаковая выборка в обеих копиях */
+    uint64_t s1 = 42, s2 = 42;
+    for (int i = 0; i < 100; i++) {
+        assert(k_ngram_sample(built, history, 3, 1.0, &s1) ==
+               k_ngram_sample(loaded, history, 3, 1.0, &s2));
+    }
+    k_ngram_free(loaded);
+
+    /* Обрезанный и испорченный файлы не загружаются */
+    assert(truncate(path, (off_t)(a.bytes - 8)) == 0);
+    assert(k_ngram_load(path) == NULL);
+    FILE *f = fopen(path, "wb");
+    assert(f);
+    fputs("not a model", f);
+    fclose(f);
+    assert(k_ngram_load(path) == NULL);
+    assert(k_ngram_load("/nonexistent/model.kngm") == NULL);
+
+    unlink(path);
+    k_ngram_free(built);
+    printf("OK\n");
+}
+
+/* Смещения полей заголовка .kngm (см. NgramHeader в ngram.c) */
+#define HDR_OFFSETS_OFFSET 56
+#define HDR_UNIGRAM_OFFSET 72
+#define HDR_CONTEXT_OFFSET(k) (96 + 8 * (k))
+#define HDR_SUCCESSOR_OFFSET(k) (96 + 8 * (2 * (KOLIBRI_NGRAM_MAX_ORDER + 1) + (k)))
+
+static uint64_t header_field(const uint8_t *image, size_t field) {
+    uint64_t value;
+    memcpy(&value, image + field, sizeof(value));
+    return value;
+}
+
+/* Записывает образ с одним изменённым uint32/uint16 и пробует загрузить */
+static int loads_with_patch(const char *path, const uint8_t *image, size_t size,
+                            uint64_t at, uint32_t value, size_t width) {
+    uint8_t *copy = (uint8_t *)malloc(size);
+    assert(copy);
+    memcpy(copy, image, size);
+    if (width == sizeof(uint16_t)) {
+        uint16_t narrow = (uint16_t)value;
+        memcpy(copy + at, &narrow, sizeof(narrow));
+    } else {
+        memcpy(copy + at, &value, sizeof(value));
+    }
+    FILE *f = fopen(path, "wb");
+    assert(f);
+    assert(fwrite(copy, 1, size, f) == size);
+    fclose(f);
+    free(copy);
+
+    KolibriNgramModel *model = k_ngram_load(path);
+    k_ngram_free(model);
+    return model != NULL;
+}
+
+static void test_corrupt_entries(void) {
+    printf("test_corrupt_entries... ");
+
+    char path[] = "/tmp/kolibri_ngram_XXXXXX";
+    temp_path(path);
+
+    KolibriNgramModel *built = build_model(3);
+    assert(k_ngram_save(built, path) == 0);
+    KolibriNgramInfo info;
+    k_ngram_get_info(built, &info);
+    k_ngram_free(built);
+
+    size_t size = info.bytes;
+    uint8_t *image = (uint8_t *)malloc(size);
+    assert(image);
+    FILE *f = fopen(path, "rb");
+    assert(f && fread(image, 1, size, f) == size);
+    fclose(f);
+
+    uint64_t offsets = header_field(image, HDR_OFFSETS_OFFSET);
+    uint64_t unigram = header_field(image, HDR_UNIGRAM_OFFSET);
+    uint64_t context = header_field(image, HDR_CONTEXT_OFFSET(2));
+    uint64_t successor = header_field(image, HDR_SUCCESSOR_OFFSET(2));
+
+    /* Неизменённый образ загружается */
+    uint16_t q;
+    memcpy(&q, image + unigram, sizeof(q));
+    assert(loads_with_patch(path, image, size, unigram, q, sizeof(uint16_t)));
+    /* q униграммы вне таблицы вероятностей */
+    assert(!loads_with_patch(path, image, size, unigram, 0xFFFF, sizeof(uint16_t)));
+    /* Смещение слова за пределами строк */
+    assert(!loads_with_patch(path, image, size, offsets + sizeof(uint32_t), 0xFFFFFFF0u,
+                             sizeof(uint32_t)));
+    /* Контекст, чьи преемники выходят за секцию */
+    assert(!loads_with_patch(path, image, size, context + sizeof(uint64_t), 0xFFFFFF00u,
+                             sizeof(uint32_t)));
+    /* Преемник с номером слова вне словаря */
+    assert(!loads_with_patch(path, image, size, successor, 0xFFFFFC00u, sizeof(uint32_t)));
+
+    free(image);
+    unlink(path);
+    printf("OK\n");
+}
+
+static void test_sampling(void) {
+    printf("test_sampling... ");
+
+    KolibriNgramModel *model = build_model(3);
+    uint32_t history[2] = {id_of(model, "сидит"), id_of(model, "на")};
+
+    /* Жадный выбор следует обучающему тексту */
+    uint64_t rng = 1;
+    assert(k_ngram_sample(model, history, 2, 0.0, &rng) == id_of(model, "ковре"));
+
+    /* Частоты выборки следуют вероятностям, низкая температура обостряет */
+    size_t hits = 0, cold_hits = 0, trials = 20000;
+    uint32_t target = id_of(model, "ковре");
+    for (size_t i = 0; i < trials; i++) {
+        if (k_ngram_sample(model, history, 2, 1.0, &rng) == target) hits++;
+        if (k_ngram_sample(model, history, 2, 0.3, &rng) == target) cold_hits++;
+    }
+    double expected = exp2(k_ngram_logprob(model, history, 2, target));
+    double observed = (double)hits / (double)trials;
+    assert(fabs(observed - expected) < 0.03);
+    assert(cold_hits > hits);
+
+    k_ngram_free(model);
+    printf("OK\n");
+}
+
+static void test_generation_context(void) {
+    printf("test_generation_context... ");
+
+    KolibriCorpusContext corpus;
+    assert(k_corpus_init(&corpus, 0, 0) == 0);
+    KolibriNgramModel *model = build_model(3);
+
+    KolibriGenerationContext ctx;
+    assert(k_gen_init(&ctx, &corpus, KOLIBRI_GEN_GREEDY) == 0);
+    k_gen_set_model(&ctx, model);
+
+    char output[256];
+    assert(k_gen_generate(&ctx, "кот сидит", 3, output, sizeof(output)) == 3);
+    assert(strcmp(output, "на ковре и") == 0);
+    assert(ctx.tokens_generated == 3);
+
+    char token[32];
+    assert(k_gen_next_token(&ctx, token, sizeof(token)) == 0);
+    assert(strcmp(token, "спит") == 0);
+
+    /* Beam search по последовательности и кандидаты следующего слова */
+    ctx.strategy = KOLIBRI_GEN_BEAM;
+    k_gen_set_beam_size(&ctx, 100);
+    assert(ctx.beam_size == KOLIBRI_BEAM_SIZE);
+    assert(k_gen_generate(&ctx, "собака", 3, output, sizeof(output)) == 3);
+    assert(strcmp(output, "спит у двери") == 0);
+
+    KolibriGenerationCandidate candidates[KOLIBRI_BEAM_SIZE];
+    size_t count = 0;
+    k_gen_set_beam_size(&ctx, 4);
+    assert(k_gen_generate(&ctx, "кот сидит на", 0, output, sizeof(output)) == 0);
+    assert(k_gen_beam_search(&ctx, candidates, &count) == 0);
+    assert(count == 4 && strcmp(candidates[0].token, "ковре") == 0);
+    assert(candidates[0].score >= candidates[3].score);
+
+    /* Выборка воспроизводима по seed */
+    char again[256];
+    ctx.strategy = KOLIBRI_GEN_SAMPLING;
+    k_gen_set_seed(&ctx, 7);
+    assert(k_gen_generate(&ctx, "кот", 20, output, sizeof(output)) == 20);
+    k_gen_set_seed(&ctx, 7);
+    assert(k_gen_generate(&ctx, "кот", 20, again, sizeof(again)) == 20);
+    assert(strcmp(output, again) == 0);
+
+    /* Маленький буфер: генерация останавливается, не переполняя его */
+    char tiny[12];
+    int written = k_gen_generate(&ctx, "кот", 20, tiny, sizeof(tiny));
+    assert(written >= 0 && written < 20 && strlen(tiny) < sizeof(tiny));
+
+    /* Обучающий текст вероятнее перемешанного */
+    const char *seen = "кот сидит на ковре и спит";
+    const char *shuffled = "ковре спит и на сидит кот";
+    double ppl_seen = k_gen_perplexity(&ctx, seen, strlen(seen));
+    double ppl_shuffled = k_gen_perplexity(&ctx, shuffled, strlen(shuffled));
+    assert(ppl_seen >= 1.0 && ppl_seen < ppl_shuffled);
+    assert(k_gen_perplexity(&ctx, "...", 3) == -1.0);
+
+    k_gen_free(&ctx);
+    k_ngram_free(model);
+    k_corpus_free(&corpus);
+    printf("OK\n");
+}
+
+static void test_latency(void) {
+    printf("test_latency... ");
+
+    /* Синтетический корпус: 4000 слов, ~200k токенов по закону Ципфа */
+    KolibriNgramBuilder *builder = k_ngram_builder_create(3);
+    assert(builder);
+    uint64_t state = 0x12345678ULL;
+    char *text = malloc(1 << 21);
+    assert(text);
+    for (int doc = 0; doc < 10; doc++) {
+        size_t pos = 0;
+        for (int i = 0; i < 20000; i++) {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            double u = (double)(state >> 11) / 9007199254740992.0;
+            unsigned word = (unsigned)(4000.0 * u * u * u);
+            pos += (size_t)snprintf(text + pos, 32, "w%u ", word);
+        }
+        assert(k_ngram_builder_add_text(builder, text, pos) == 0);
+    }
+    free(text);
+
+    double start = now_seconds();
+    KolibriNgramModel *model = k_ngram_build(builder);
+    double build_time = now_seconds() - start;
+    assert(model);
+    k_ngram_builder_destroy(builder);
+
+    KolibriNgramInfo info;
+    k_ngram_get_info(model, &info);
+
+    uint32_t history[KOLIBRI_NGRAM_MAX_ORDER] = {0};
+    size_t history_len = 0;
+    uint64_t rng = 99;
+    size_t tokens = 100000;
+    start = now_seconds();
+    for (size_t i = 0; i < tokens; i++) {
+        uint32_t word = k_ngram_sample(model, history, history_len, 1.0, &rng);
+        assert(word != KOLIBRI_NGRAM_UNK);
+        if (history_len == 2) {
+            history[0] = history[1];
+            history_len = 1;
+        }
+        history[history_len++] = word;
+    }
+    double per_token = (now_seconds() - start) / (double)tokens;
+
+    printf("%zu words, %zu bytes, build %.3fs, %.2f us/token... ",
+           info.vocab_size, info.bytes, build_time, per_token * 1e6);
+
+    k_ngram_free(model);
+    printf("OK\n");
+}
+
+int main(void) {
+    printf("Running n-gram model tests...\n\n");
+
+    test_build_and_query();
+    test_save_load();
+    test_corrupt_entries();
+    test_sampling();
+    test_generation_context();
+    test_latency();
+
+    printf("\n✓ All n-gram model tests passed!\n");
+    return 0;
+}
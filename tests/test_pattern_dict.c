@@ -0,0 +1,179 @@
+/*
+ * Tests for the packed pattern dictionary and batched pattern compression
+ */
+
+#include "kolibri/generation.h"
+#include "kolibri/pattern_dict.h"
+#include "test_util.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void make_pattern(KolibriSemanticPattern *pattern, uint64_t seed) {
+    k_semantic_pattern_init(pattern);
+    for (size_t i = 0; i < KOLIBRI_SEMANTIC_PATTERN_SIZE; i++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        pattern->pattern[i] = (uint8_t)((seed >> 33) % 10);
+    }
+}
+
+static int pattern_hash(const KolibriSemanticPattern *pattern) {
+    char text[KOLIBRI_SEMANTIC_PATTERN_SIZE + 1];
+    for (size_t i = 0; i < KOLIBRI_SEMANTIC_PATTERN_SIZE; i++) text[i] = (char)('0' + pattern->pattern[i]);
+    text[KOLIBRI_SEMANTIC_PATTERN_SIZE] = '\0';
+    return kf_hash_from_text(text);
+}
+
+static void test_dictionary(void) {
+    printf("test_dictionary... ");
+
+    KolibriPatternDict dict;
+    assert(k_pattern_dict_init(&dict, 4) == 0);
+    assert(sizeof(KolibriPatternEntry) == 40);
+
+    KolibriSemanticPattern p;
+    uint8_t out[KOLIBRI_SEMANTIC_PATTERN_SIZE];
+    for (int i = 0; i < 5000; i++) {
+        make_pattern(&p, (uint64_t)i);
+        assert(k_pattern_dict_put(&dict, i * 7919, p.pattern) == 1);
+    }
+    assert(dict.count == 5000 && dict.pending == 5000 && dict.inserted == 5000);
+
+    /* Повтор не создаёт записи; новое значение помечается заново */
+    make_pattern(&p, 3);
+    assert(k_pattern_dict_put(&dict, 3 * 7919, p.pattern) == 0);
+    k_pattern_dict_clear_pending(&dict);
+    assert(k_pattern_dict_put(&dict, 3 * 7919, p.pattern) == 0 && dict.pending == 0);
+    make_pattern(&p, 99999);
+    assert(k_pattern_dict_put(&dict, 3 * 7919, p.pattern) == 0 && dict.pending == 1);
+    assert(dict.count == 5000 && dict.inserted == 0);
+
+    for (int i = 0; i < 5000; i += 97) {
+        const KolibriPatternEntry *entry = k_pattern_dict_find(&dict, i * 7919);
+        assert(entry && entry->hash == i * 7919);
+        k_pattern_dict_unpack(entry, out);
+        make_pattern(&p, i == 3 ? 99999 : (uint64_t)i);
+        assert(memcmp(out, p.pattern, sizeof(out)) == 0);
+    }
+    assert(k_pattern_dict_find(&dict, -1) == NULL);
+
+    k_pattern_dict_free(&dict);
+    printf("OK\n");
+}
+
+static void test_compress_batch(void) {
+    printf("test_compress_batch... ");
+
+    KolibriCorpusContext corpus;
+    assert(k_corpus_init(&corpus, 0, 0) == 0);
+    KolibriGenerationContext ctx;
+    assert(k_gen_init(&ctx, &corpus, KOLIBRI_GEN_FORMULA) == 0);
+
+    KolibriFormula formula;
+    KolibriSemanticPattern p, restored;
+    for (int i = 0; i < 100; i++) {
+        make_pattern(&p, (uint64_t)i % 60);  /* 40 повторов */
+        double progress = k_gen_compress_pattern(&ctx, &p, &formula);
+        assert(progress == (double)(i < 60 ? i + 1 : 60));
+    }
+    assert(ctx.formula_pool->association_count == 0);
+
+    /* Поиск в словаре без выгрузки */
+    make_pattern(&p, 17);
+    assert(k_gen_lookup_pattern(&ctx, pattern_hash(&p), &restored) == 0);
+    assert(memcmp(restored.pattern, p.pattern, KOLIBRI_SEMANTIC_PATTERN_SIZE) == 0);
+    assert(k_gen_lookup_pattern(&ctx, 12345, &restored) == -1);
+
+    /* Выгрузка пакетом: уникальные паттерны в порядке вставки */
+    assert(k_gen_flush_patterns(&ctx) == 60);
+    assert(ctx.formula_pool->association_count == 60);
+    assert(k_gen_flush_patterns(&ctx) == 0);
+    make_pattern(&p, 0);
+    const KolibriAssociation *first = &ctx.formula_pool->associations[0];
+    assert(first->input_hash == pattern_hash(&p));
+    assert(strcmp(first->source, "compress") == 0 && strlen(first->answer) == 64);
+    assert(first->answer[0] == (char)('0' + p.pattern[0]));
+
+    /* Тексты и формулы дедуплицируются через индекс пула */
+    assert(k_gen_compress_text(&ctx, "одна и та же строка", &formula) == 61.0);
+    assert(k_gen_compress_text(&ctx, "одна и та же строка", &formula) == 61.0);
+
+    assert(k_gen_finalize_compression(&ctx, 5) == 0);
+    const KolibriFormula *best = kf_pool_best(ctx.formula_pool);
+    assert(best && best->association_count > 0);
+    assert(k_gen_compress_formula(&ctx, best, &formula) == 0);
+    assert(k_gen_compress_formula(&ctx, best, &formula) == 1);
+    assert(ctx.formula_pool->association_count == 62);
+
+    /* Декомпрессия из формулы видит выгруженный паттерн */
+    KolibriFormula single;
+    memset(&single, 0, sizeof(single));
+    single.associations[0] = ctx.formula_pool->associations[5];
+    single.association_count = 1;
+    make_pattern(&p, 5);
+    assert(k_gen_decompress_pattern(&ctx, &single, &restored) == 0);
+    assert(memcmp(restored.pattern, p.pattern, KOLIBRI_SEMANTIC_PATTERN_SIZE) == 0);
+
+    k_gen_free(&ctx);
+    k_corpus_free(&corpus);
+    printf("OK\n");
+}
+
+static void test_compress_overflow(void) {
+    printf("test_compress_overflow... ");
+
+    KolibriCorpusContext corpus;
+    assert(k_corpus_init(&corpus, 0, 0) == 0);
+    KolibriGenerationContext ctx;
+    assert(k_gen_init(&ctx, &corpus, KOLIBRI_GEN_FORMULA) == 0);
+
+    /* Больше паттернов, чем вмещает пул: остаются новейшие */
+    size_t total = KOLIBRI_POOL_MAX_ASSOCIATIONS + 2500;
+    KolibriFormula formula;
+    KolibriSemanticPattern p;
+    double start = now_seconds();
+    for (size_t i = 0; i < total; i++) {
+        make_pattern(&p, i + 1000);
+        k_gen_compress_pattern(&ctx, &p, &formula);
+    }
+    double insert_time = now_seconds() - start;
+    assert(ctx.patterns.count == total);
+
+    start = now_seconds();
+    assert(k_gen_flush_patterns(&ctx) == KOLIBRI_POOL_MAX_ASSOCIATIONS);
+    double flush_time = now_seconds() - start;
+    assert(ctx.formula_pool->association_count == KOLIBRI_POOL_MAX_ASSOCIATIONS);
+    make_pattern(&p, 2500 + 1000);
+    assert(ctx.formula_pool->associations[0].input_hash == pattern_hash(&p));
+    make_pattern(&p, total - 1 + 1000);
+    assert(ctx.formula_pool->associations[KOLIBRI_POOL_MAX_ASSOCIATIONS - 1].input_hash ==
+           pattern_hash(&p));
+
+    /* Следующий пакет вытесняет старейшие одним сдвигом */
+    for (size_t i = 0; i < 10; i++) {
+        make_pattern(&p, 900000 + i);
+        k_gen_compress_pattern(&ctx, &p, &formula);
+    }
+    assert(k_gen_flush_patterns(&ctx) == 10);
+    make_pattern(&p, 2510 + 1000);
+    assert(ctx.formula_pool->associations[0].input_hash == pattern_hash(&p));
+
+    printf("%.0f patterns/s, flush %.1f ms... ", (double)total / insert_time, flush_time * 1e3);
+
+    k_gen_free(&ctx);
+    k_corpus_free(&corpus);
+    printf("OK\n");
+}
+
+int main(void) {
+    printf("Running pattern dictionary tests...\n\n");
+
+    test_dictionary();
+    test_compress_batch();
+    test_compress_overflow();
+
+    printf("\n✓ All pattern dictionary tests passed!\n");
+    return 0;
+}
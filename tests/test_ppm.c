@@ -0,0 +1,180 @@
+/*
+ * Tests for the arena-backed PPM model and the KOLIBRI_COMPRESS_PPM method
+ */
+
+#include "kolibri/compress.h"
+#include "kolibri/ppm.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static uint64_t rng_state = 0x2545F4914F6CDD1DULL;
+
+static uint64_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+/* Псевдотекст: слова из небольшого словаря, как в исходниках и логах */
+static void fill_text(uint8_t *data, size_t len) {
+    static const char *words[] = {"kolibri", "context", "model", "static", "return",
+                                  "size_t", "uint8_t", "if", "for", "=", "0;", "\n"};
+    size_t pos = 0;
+    while (pos < len) {
+        const char *w = words[next_random() % (sizeof(words) / sizeof(words[0]))];
+        for (size_t i = 0; w[i] && pos < len; i++) data[pos++] = (uint8_t)w[i];
+        if (pos < len) data[pos++] = ' ';
+    }
+}
+
+static size_t roundtrip(KolibriPpmModel *model, const uint8_t *input, size_t len) {
+    size_t cap = len + len / 2 + 64;
+    uint8_t *packed = malloc(cap);
+    uint8_t *unpacked = malloc(len ? len : 1);
+    assert(packed && unpacked);
+    size_t packed_size = 0;
+    assert(kolibri_ppm_encode(model, input, len, packed, cap, &packed_size) == 0);
+    assert(kolibri_ppm_decode(model, packed, packed_size, unpacked, len) == 0);
+    assert(memcmp(unpacked, input, len) == 0);
+    free(unpacked);
+    free(packed);
+    return packed_size;
+}
+
+static void test_ppm_orders(void) {
+    printf("test_ppm_orders... ");
+
+    size_t len = 200000;
+    uint8_t *text = malloc(len);
+    assert(text);
+    fill_text(text, len);
+
+    size_t previous = len, order1 = 0;
+    for (unsigned order = 1; order <= KOLIBRI_PPM_MAX_ORDER; order++) {
+        KolibriPpmConfig config = {order, 0};
+        KolibriPpmModel *model = kolibri_ppm_create(&config);
+        assert(model);
+        size_t packed = roundtrip(model, text, len);
+        /* Слова независимы: выигрыш от контекста растёт до order 3,
+         * дальше длинные контексты лишь не должны заметно проигрывать */
+        if (order == 1) order1 = packed;
+        if (order <= 3) assert(packed <= previous);
+        if (order >= 2) assert(packed < order1 / 2);
+        previous = packed;
+        kolibri_ppm_destroy(model);
+    }
+
+    /* Пустой и однобайтовый входы */
+    KolibriPpmModel *model = kolibri_ppm_create(NULL);
+    assert(model);
+    KolibriPpmConfig config;
+    kolibri_ppm_get_config(model, &config);
+    assert(config.order == KOLIBRI_PPM_DEFAULT_ORDER);
+    assert(config.memory_limit == KOLIBRI_PPM_DEFAULT_MEMORY);
+    roundtrip(model, text, 0);
+    roundtrip(model, text, 1);
+    kolibri_ppm_destroy(model);
+    free(text);
+
+    printf("OK\n");
+}
+
+static void test_ppm_memory_budget(void) {
+    printf("test_ppm_memory_budget... ");
+
+    /* Шум на минимальном бюджете: вытеснение и перезапуск модели */
+    size_t len = 300000;
+    uint8_t *data = malloc(len);
+    assert(data);
+    for (size_t i = 0; i < len; i++) data[i] = (uint8_t)next_random();
+
+    KolibriPpmConfig config = {6, KOLIBRI_PPM_MIN_MEMORY};
+    KolibriPpmModel *model = kolibri_ppm_create(&config);
+    assert(model);
+    roundtrip(model, data, len);
+    KolibriPpmStats stats;
+    kolibri_ppm_get_stats(model, &stats);
+    assert(stats.evictions > 0);
+    assert(stats.restarts > 0);
+    assert(stats.memory_used <= stats.memory_limit);
+    assert(stats.memory_limit == KOLIBRI_PPM_MIN_MEMORY);
+
+    /* Переполнение выхода сообщается, а не пишется за границу */
+    uint8_t small[100];
+    size_t written = 0;
+    assert(kolibri_ppm_encode(model, data, len, small, sizeof(small), &written) == -1);
+
+    /* Модель переиспользуется: результат не зависит от предыдущего входа */
+    uint8_t text[4096];
+    fill_text(text, sizeof(text));
+    size_t first = roundtrip(model, text, sizeof(text));
+    roundtrip(model, data, len);
+    assert(roundtrip(model, text, sizeof(text)) == first);
+
+    kolibri_ppm_destroy(model);
+    free(data);
+
+    printf("OK\n");
+}
+
+static void test_ppm_compress_method(void) {
+    printf("test_ppm_compress_method... ");
+
+    size_t len = 1u << 20;
+    uint8_t *input = malloc(len);
+    assert(input);
+    fill_text(input, len);
+
+    KolibriCompressor *comp = kolibri_compressor_create(KOLIBRI_COMPRESS_PPM);
+    assert(comp);
+    assert(kolibri_compressor_set_ppm(comp, 4, 8u << 20) == 0);
+    assert(kolibri_compressor_set_ppm(comp, KOLIBRI_PPM_MAX_ORDER + 1, 0) == -1);
+
+    uint8_t *packed = NULL, *unpacked = NULL;
+    size_t packed_size = 0, unpacked_size = 0;
+    KolibriCompressStats stats;
+    clock_t start = clock();
+    assert(kolibri_compress(comp, input, len, &packed, &packed_size, &stats) == 0);
+    assert(kolibri_decompress(packed, packed_size, &unpacked, &unpacked_size, NULL) == 0);
+    double elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+    assert(stats.methods_used == KOLIBRI_COMPRESS_PPM);
+    assert(unpacked_size == len && memcmp(unpacked, input, len) == 0);
+    assert(packed_size < len / 3);
+    printf("%.2fx, %.1f MB/s roundtrip... ", stats.compression_ratio, len / 1e6 / elapsed);
+
+    /* Порча данных обнаруживается контрольной суммой */
+    packed[packed_size / 2] ^= 0x20;
+    free(unpacked);
+    unpacked = NULL;
+    assert(kolibri_decompress(packed, packed_size, &unpacked, &unpacked_size, NULL) != 0);
+    free(packed);
+
+    /* Несжимаемый вход хранится как есть */
+    for (size_t i = 0; i < 10000; i++) input[i] = (uint8_t)next_random();
+    assert(kolibri_compress(comp, input, 10000, &packed, &packed_size, NULL) == 0);
+    assert(kolibri_decompress(packed, packed_size, &unpacked, &unpacked_size, NULL) == 0);
+    assert(unpacked_size == 10000 && memcmp(unpacked, input, 10000) == 0);
+    free(packed);
+    free(unpacked);
+
+    kolibri_compressor_destroy(comp);
+    free(input);
+
+    printf("OK\n");
+}
+
+int main(void) {
+    printf("Running PPM tests...\n\n");
+
+    test_ppm_orders();
+    test_ppm_memory_budget();
+    test_ppm_compress_method();
+
+    printf("\n✓ All PPM tests passed!\n");
+    return 0;
+}
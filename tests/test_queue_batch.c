@@ -0,0 +1,323 @@
+/*
+ * Tests for batched knowledge queue access: batch insert/moderate, arena fetch,
+ * keyset cursors and streaming export
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "kolibri/knowledge_queue.h"
+#include "test_util.h"
+
+#include <assert.h>
+#include <sqlite3.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static void remove_db(const char *path) {
+    char side[512];
+    unlink(path);
+    snprintf(side, sizeof(side), "%s-wal", path);
+    unlink(side);
+    snprintf(side, sizeof(side), "%s-shm", path);
+    unlink(side);
+}
+
+static void test_batch_round_trip(void) {
+    printf("test_batch_round_trip... ");
+    char path[] = "/tmp/kolibri_queueXXXXXX";
+    temp_name(path);
+    KolibriQueue *queue = NULL;
+    assert(kolibri_queue_open(path, &queue) == SQLITE_OK);
+
+    KolibriQueueSubmission items[3] = {
+        {"Первый", "Текст один", "lab", "{\"n\":1}"},
+        {"Второй", "Текст два", NULL, NULL},
+        {"Третий", "", "wiki", NULL},
+    };
+    long long ids[3] = {0, 0, 0};
+    assert(kolibri_queue_enqueue_batch(queue, items, 3U, ids) == SQLITE_OK);
+    assert(ids[0] > 0 && ids[1] == ids[0] + 1 && ids[2] == ids[1] + 1);
+
+    KolibriQueueRecord *records = NULL;
+    size_t count = 0U;
+    assert(kolibri_queue_fetch(queue, KOLIBRI_QUEUE_STATUS_PENDING, 10U, &records, &count) == SQLITE_OK);
+    assert(count == 3U);
+    for (size_t i = 0; i < count; ++i) {
+        size_t k = (size_t)(records[i].submission_id - ids[0]);
+        assert(k < 3U);
+        assert(strcmp(records[i].title, items[k].title) == 0);
+        assert(strcmp(records[i].content, items[k].content) == 0);
+        assert((records[i].source == NULL) == (items[k].source == NULL));
+        assert(!items[k].source || strcmp(records[i].source, items[k].source) == 0);
+        assert(records[i].moderator == NULL);
+        assert(records[i].created_at && records[i].created_at[0]);
+    }
+    kolibri_queue_free_records(records, count);
+
+    /* Неполная заявка откатывает всю пачку */
+    KolibriQueueSubmission broken[2] = {
+        {"Четвёртый", "ok", NULL, NULL},
+        {NULL, "без заголовка", NULL, NULL},
+    };
+    assert(kolibri_queue_enqueue_batch(queue, broken, 2U, NULL) != SQLITE_OK);
+    assert(kolibri_queue_fetch(queue, KOLIBRI_QUEUE_STATUS_PENDING, 10U, &records, &count) == SQLITE_OK);
+    assert(count == 3U);
+    kolibri_queue_free_records(records, count);
+
+    KolibriQueueModeration decisions[3] = {
+        {ids[0], KOLIBRI_QUEUE_STATUS_APPROVED, "tester", "ok"},
+        {ids[2], KOLIBRI_QUEUE_STATUS_REJECTED, "tester", NULL},
+        {ids[2] + 100, KOLIBRI_QUEUE_STATUS_APPROVED, "tester", NULL},
+    };
+    size_t updated = 0U;
+    assert(kolibri_queue_moderate_batch(queue, decisions, 3U, &updated) == SQLITE_OK);
+    assert(updated == 2U);
+    assert(kolibri_queue_moderate(queue, ids[2] + 100, KOLIBRI_QUEUE_STATUS_APPROVED, "x", NULL) ==
+           SQLITE_NOTFOUND);
+
+    assert(kolibri_queue_fetch(queue, KOLIBRI_QUEUE_STATUS_APPROVED, 10U, &records, &count) == SQLITE_OK);
+    assert(count == 1U);
+    assert(records[0].submission_id == ids[0]);
+    assert(strcmp(records[0].moderator, "tester") == 0);
+    assert(strcmp(records[0].moderation_note, "ok") == 0);
+    assert(records[0].moderated_at != NULL);
+    kolibri_queue_free_records(records, count);
+
+    kolibri_queue_close(queue);
+    remove_db(path);
+    printf("OK\n");
+}
+
+static void test_batch_throughput(void) {
+    printf("test_batch_throughput... ");
+    char path[] = "/tmp/kolibri_queueXXXXXX";
+    temp_name(path);
+    KolibriQueue *queue = NULL;
+    assert(kolibri_queue_open(path, &queue) == SQLITE_OK);
+
+    enum { ROWS = 20000, CHUNK = 1000 };
+    KolibriQueueSubmission items[CHUNK];
+    char titles[CHUNK][32];
+    for (size_t i = 0; i < CHUNK; ++i) {
+        snprintf(titles[i], sizeof(titles[i]), "Заявка %zu", i);
+        items[i].title = titles[i];
+        items[i].content = "Содержимое заявки для проверки пропускной способности очереди.";
+        items[i].source = "bench";
+        items[i].metadata_json = NULL;
+    }
+    double start = now_seconds();
+    for (size_t done = 0; done < ROWS; done += CHUNK) {
+        assert(kolibri_queue_enqueue_batch(queue, items, CHUNK, NULL) == SQLITE_OK);
+    }
+    double inserted = now_seconds();
+
+    KolibriQueueRecord *records = NULL;
+    size_t count = 0U;
+    assert(kolibri_queue_fetch(queue, KOLIBRI_QUEUE_STATUS_PENDING, ROWS, &records, &count) == SQLITE_OK);
+    double fetched = now_seconds();
+    assert(count == ROWS);
+    kolibri_queue_free_records(records, count);
+
+    double insert_rate = ROWS / (inserted - start);
+    double fetch_rate = ROWS / (fetched - inserted);
+    printf("вставка %.0f строк/с, выборка %.0f строк/с... ", insert_rate, fetch_rate);
+
+    kolibri_queue_close(queue);
+    remove_db(path);
+    printf("OK\n");
+}
+
+static void test_cursor_pages(void) {
+    printf("test_cursor_pages... ");
+    char path[] = "/tmp/kolibri_queueXXXXXX";
+    temp_name(path);
+    KolibriQueue *queue = NULL;
+    assert(kolibri_queue_open(path, &queue) == SQLITE_OK);
+
+    enum { ROWS = 25 };
+    KolibriQueueSubmission items[ROWS];
+    char titles[ROWS][32];
+    for (size_t i = 0; i < ROWS; ++i) {
+        snprintf(titles[i], sizeof(titles[i]), "Заявка %zu", i);
+        items[i].title = titles[i];
+        items[i].content = "Текст \"в кавычках\"\nи перевод строки";
+        items[i].source = (i % 2U) ? "lab" : NULL;
+        items[i].metadata_json = (i % 3U) ? NULL : "{\"n\":1}";
+    }
+    long long ids[ROWS];
+    assert(kolibri_queue_enqueue_batch(queue, items, ROWS, ids) == SQLITE_OK);
+    KolibriQueueModeration decision = {ids[4], KOLIBRI_QUEUE_STATUS_APPROVED, "tester", NULL};
+    assert(kolibri_queue_moderate_batch(queue, &decision, 1U, NULL) == SQLITE_OK);
+
+    /* Страницы по 7 строк: все ожидающие по возрастанию id, без пропусков */
+    KolibriQueueCursor *cursor = NULL;
+    assert(kolibri_queue_cursor_open(queue, KOLIBRI_QUEUE_STATUS_PENDING, 0, 1, 7U, &cursor) ==
+           SQLITE_OK);
+    const KolibriQueueRecord *record = NULL;
+    size_t seen = 0U;
+    long long last = 0;
+    int rc;
+    while ((rc = kolibri_queue_cursor_next(cursor, &record)) == SQLITE_ROW) {
+        assert(record->submission_id > last);
+        assert(record->submission_id != ids[4]);
+        assert(record->status == KOLIBRI_QUEUE_STATUS_PENDING);
+        size_t k = (size_t)(record->submission_id - ids[0]);
+        assert(strcmp(record->title, titles[k]) == 0);
+        assert(record->content && strcmp(record->content, items[k].content) == 0);
+        last = record->submission_id;
+        seen++;
+    }
+    assert(rc == SQLITE_DONE);
+    assert(seen == ROWS - 1U);
+    assert(kolibri_queue_cursor_position(cursor) == ids[ROWS - 1]);
+    assert(kolibri_queue_cursor_next(cursor, &record) == SQLITE_DONE);
+    kolibri_queue_cursor_close(cursor);
+
+    /* Продолжение с позиции и выборка без содержимого */
+    assert(kolibri_queue_cursor_open(queue, KOLIBRI_QUEUE_STATUS_PENDING, ids[19], 0, 0U, &cursor) ==
+           SQLITE_OK);
+    seen = 0U;
+    while (kolibri_queue_cursor_next(cursor, &record) == SQLITE_ROW) {
+        assert(record->submission_id > ids[19]);
+        assert(record->content == NULL);
+        assert(record->title != NULL);
+        seen++;
+    }
+    assert(seen == 5U);
+    kolibri_queue_cursor_close(cursor);
+
+    /* JSON Lines: одна строка на заявку, спецсимволы экранированы */
+    char *json = NULL;
+    size_t json_size = 0U;
+    FILE *out = open_memstream(&json, &json_size);
+    assert(out);
+    size_t exported = 0U;
+    assert(kolibri_queue_export_jsonl(queue, KOLIBRI_QUEUE_STATUS_PENDING, out, &exported) == SQLITE_OK);
+    fclose(out);
+    assert(exported == ROWS - 1U);
+    size_t lines = 0U;
+    for (size_t i = 0; i < json_size; ++i) {
+        lines += json[i] == '\n';
+    }
+    assert(lines == exported);
+    assert(strstr(json, "\"content\":\"Текст \\\"в кавычках\\\"\\nи перевод строки\"") != NULL);
+    assert(strstr(json, "\"metadata\":{\"n\":1}") != NULL);
+    assert(strstr(json, "\"source\":null") != NULL);
+    free(json);
+
+    kolibri_queue_close(queue);
+    remove_db(path);
+    printf("OK\n");
+}
+
+static void test_metadata_json(void) {
+    printf("test_metadata_json... ");
+    char path[] = "/tmp/kolibri_queueXXXXXX";
+    temp_name(path);
+    KolibriQueue *queue = NULL;
+    assert(kolibri_queue_open(path, &queue) == SQLITE_OK);
+
+    /* Не-JSON отклоняется, пакет откатывается целиком */
+    assert(kolibri_queue_enqueue(queue, "Плохая", "Текст", NULL, "{\"n\":", NULL) == SQLITE_CONSTRAINT);
+    KolibriQueueSubmission items[2] = {
+        {"Первая", "Текст", NULL, "[1,2]"},
+        {"Вторая", "Текст", NULL, "not json"},
+    };
+    assert(kolibri_queue_enqueue_batch(queue, items, 2U, NULL) == SQLITE_CONSTRAINT);
+    KolibriQueueRecord *records = NULL;
+    size_t count = 0U;
+    assert(kolibri_queue_fetch(queue, KOLIBRI_QUEUE_STATUS_PENDING, 10U, &records, &count) == SQLITE_OK);
+    assert(count == 0U);
+    kolibri_queue_free_records(records, count);
+    assert(kolibri_queue_enqueue_batch(queue, items, 1U, NULL) == SQLITE_OK);
+
+    /* Строка, записанная до проверки, выгружается строкой JSON */
+    sqlite3 *db = NULL;
+    assert(sqlite3_open(path, &db) == SQLITE_OK);
+    assert(sqlite3_exec(db,
+                        "INSERT INTO submissions (created_at, title, content, metadata, status) "
+                        "VALUES ('2024-01-01T00:00:00Z', 'Старая', 'Текст', '\"},{\"x', 'pending')",
+                        NULL, NULL, NULL) == SQLITE_OK);
+    sqlite3_close(db);
+
+    char *json = NULL;
+    size_t json_size = 0U;
+    FILE *out = open_memstream(&json, &json_size);
+    assert(out);
+    size_t exported = 0U;
+    assert(kolibri_queue_export_jsonl(queue, KOLIBRI_QUEUE_STATUS_PENDING, out, &exported) == SQLITE_OK);
+    fclose(out);
+    assert(exported == 2U);
+    assert(strstr(json, "\"metadata\":[1,2]") != NULL);
+    assert(strstr(json, "\"metadata\":\"\\\"},{\\\"x\"") != NULL);
+    free(json);
+
+    kolibri_queue_close(queue);
+    remove_db(path);
+    printf("OK\n");
+}
+
+static void test_cursor_memory(void) {
+    printf("test_cursor_memory... ");
+    char path[] = "/tmp/kolibri_queueXXXXXX";
+    temp_name(path);
+    KolibriQueue *queue = NULL;
+    assert(kolibri_queue_open(path, &queue) == SQLITE_OK);
+
+    /* Крупные тексты: полная выборка держит их все, курсор — одну страницу */
+    enum { ROWS = 2000, CHUNK = 200, CONTENT = 4096 };
+    char *content = (char *)malloc(CONTENT + 1U);
+    assert(content);
+    memset(content, 'x', CONTENT);
+    content[CONTENT] = '\0';
+    KolibriQueueSubmission items[CHUNK];
+    for (size_t i = 0; i < CHUNK; ++i) {
+        items[i].title = "Большая заявка";
+        items[i].content = content;
+        items[i].source = NULL;
+        items[i].metadata_json = NULL;
+    }
+    for (size_t done = 0; done < ROWS; done += CHUNK) {
+        assert(kolibri_queue_enqueue_batch(queue, items, CHUNK, NULL) == SQLITE_OK);
+    }
+
+    double start = now_seconds();
+    KolibriQueueCursor *cursor = NULL;
+    assert(kolibri_queue_cursor_open(queue, KOLIBRI_QUEUE_STATUS_PENDING, 0, 0, 0U, &cursor) ==
+           SQLITE_OK);
+    const KolibriQueueRecord *record = NULL;
+    size_t seen = 0U;
+    while (kolibri_queue_cursor_next(cursor, &record) == SQLITE_ROW) {
+        seen++;
+    }
+    kolibri_queue_cursor_close(cursor);
+    double light = now_seconds();
+    assert(seen == ROWS);
+
+    KolibriQueueRecord *records = NULL;
+    size_t count = 0U;
+    assert(kolibri_queue_fetch(queue, KOLIBRI_QUEUE_STATUS_PENDING, ROWS, &records, &count) == SQLITE_OK);
+    double full = now_seconds();
+    assert(count == ROWS);
+    kolibri_queue_free_records(records, count);
+    printf("курсор без текста %.1f мс, полная выборка %.1f мс... ", (light - start) * 1e3,
+           (full - light) * 1e3);
+
+    free(content);
+    kolibri_queue_close(queue);
+    remove_db(path);
+    printf("OK\n");
+}
+
+int main(void) {
+    printf("Running knowledge queue batch tests...\n\n");
+    test_batch_round_trip();
+    test_batch_throughput();
+    test_cursor_pages();
+    test_metadata_json();
+    test_cursor_memory();
+    printf("\n✓ All knowledge queue batch tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,330 @@
+/*
+ * Tests for shared-base KolibriScript contexts and the context pool
+ */
+
+#include "kolibri/script_pool.h"
+#include "test_util.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static KolibriFormulaPool *make_base(void) {
+    KolibriFormulaPool *base = (KolibriFormulaPool *)calloc(1, sizeof(KolibriFormulaPool));
+    assert(base);
+    kf_pool_init(base, 424242ULL);
+    return base;
+}
+
+static int run(KolibriScript *script, const char *program) {
+    if (ks_load_text(script, program) != 0) {
+        return -1;
+    }
+    return ks_execute(script);
+}
+
+static void test_overlay(void) {
+    printf("test_overlay... ");
+    KolibriFormulaPool *base = make_base();
+    KolibriFormulaPool *pristine = (KolibriFormulaPool *)malloc(sizeof(KolibriFormulaPool));
+    assert(pristine);
+    memcpy(pristine, base, sizeof(KolibriFormulaPool));
+
+    KolibriScript a;
+    KolibriScript b;
+    assert(ks_init_shared(&a, base, NULL) == 0);
+    assert(ks_init_shared(&b, base, NULL) == 0);
+    ks_capture_output(&a);
+    ks_capture_output(&b);
+
+    /* Чтение ничего не пишет в оверлей */
+    assert(run(&a, "начало:\n    показать \"только чтение\"\nконец.\n") == 0);
+    assert(a.pool == base);
+    assert(a.overlay.fresh_count == 0U);
+
+    assert(run(&a,
+               "начало:\n"
+               "    обучить связь \"небо\" -> \"голубое\"\n"
+               "    вызвать эволюцию\n"
+               "    создать формулу ответ из \"ассоциация\"\n"
+               "    оценить ответ на задаче \"небо\"\n"
+               "    показать итог\n"
+               "конец.\n") == 0);
+    assert(a.pool == base);
+    assert(a.overlay.fresh_count > 0U);
+    assert(a.overlay.formula_count > 0U);
+    size_t length = 0U;
+    const char *output = ks_output(&a, &length);
+    assert(output && strstr(output, "голубое") != NULL);
+    assert(base->association_count == 0U);
+    assert(memcmp(base, pristine, sizeof(KolibriFormulaPool)) == 0);
+
+    /* Обучение в одном контексте не видно другому */
+    assert(run(&b,
+               "начало:\n"
+               "    создать формулу ответ из \"ассоциация\"\n"
+               "    оценить ответ на задаче \"небо\"\n"
+               "    показать итог\n"
+               "конец.\n") == 0);
+    output = ks_output(&b, &length);
+    assert(output && strstr(output, "голубое") == NULL);
+
+    /* Сброс возвращает контекст к базе и откатывает новые символы */
+    size_t symbols = a.symbol_table.count;
+    size_t capacity = a.overlay.fresh_capacity;
+    assert(run(&a, "начало:\n    обучить связь \"αβγ\" -> \"δ\"\nконец.\n") == 0);
+    assert(a.symbol_table.count > symbols);
+    ks_reset(&a);
+    assert(a.overlay.fresh_count == 0U);
+    assert(a.overlay.formula_count == 0U);
+    assert(a.overlay.fresh_capacity >= capacity && capacity > 0U);
+    assert(a.symbol_table.count == a.symbol_mark);
+    output = ks_output(&a, &length);
+    assert(output && length == 0U);
+    uint8_t digits[KOLIBRI_SYMBOL_DIGITS];
+    assert(kolibri_symbol_encode(&a.symbol_table, 0x03B1U, digits) == 0);
+    ks_reset(&a);
+
+    /* После сброса контекст снова видит только base */
+    assert(run(&a,
+               "начало:\n"
+               "    создать формулу ответ из \"ассоциация\"\n"
+               "    оценить ответ на задаче \"небо\"\n"
+               "    показать итог\n"
+               "конец.\n") == 0);
+    output = ks_output(&a, &length);
+    assert(output && strstr(output, "голубое") == NULL);
+    assert(memcmp(base, pristine, sizeof(KolibriFormulaPool)) == 0);
+
+    ks_free(&a);
+    ks_free(&b);
+    free(pristine);
+    free(base);
+    printf("OK\n");
+}
+
+static void test_overlay_replaces_base(void) {
+    printf("test_overlay_replaces_base... ");
+    KolibriFormulaPool *base = make_base();
+    KolibriSymbolTable symbols;
+    kolibri_symbol_table_init(&symbols, NULL);
+    assert(kf_pool_add_association(base, &symbols, "небо", "голубое", "base", 1U) == 0);
+    assert(kf_pool_add_association(base, &symbols, "трава", "зелёная", "base", 1U) == 0);
+    KolibriFormulaPool *pristine = (KolibriFormulaPool *)malloc(sizeof(KolibriFormulaPool));
+    assert(pristine);
+    memcpy(pristine, base, sizeof(KolibriFormulaPool));
+
+    const char *ask =
+        "начало:\n"
+        "    создать формулу ответ из \"ассоциация\"\n"
+        "    оценить ответ на задаче \"небо\"\n"
+        "    показать итог\n"
+        "конец.\n";
+    KolibriScript a;
+    KolibriScript b;
+    assert(ks_init_shared(&a, base, NULL) == 0);
+    assert(ks_init_shared(&b, base, NULL) == 0);
+    ks_capture_output(&a);
+    ks_capture_output(&b);
+
+    /* Новый ответ на вопрос из base заменяет его на месте */
+    assert(run(&a, "начало:\n    обучить связь \"небо\" -> \"серое\"\nконец.\n") == 0);
+    assert(a.overlay.replaced_count == 1U);
+    assert(kf_overlay_association_count(&a.overlay) == base->association_count);
+    assert(strcmp(kf_overlay_association(&a.overlay, 0)->answer, "серое") == 0);
+    assert(strcmp(kf_overlay_association(&a.overlay, 1)->answer, "зелёная") == 0);
+    assert(run(&a, ask) == 0);
+    size_t length = 0U;
+    const char *output = ks_output(&a, &length);
+    assert(output && strstr(output, "серое") != NULL);
+
+    assert(run(&b, ask) == 0);
+    output = ks_output(&b, &length);
+    assert(output && strstr(output, "голубое") != NULL);
+    assert(memcmp(base, pristine, sizeof(KolibriFormulaPool)) == 0);
+
+    ks_free(&a);
+    ks_free(&b);
+    free(pristine);
+    free(base);
+    printf("OK\n");
+}
+
+/* Контекст над общим пулом ведёт себя как интерпретатор над копией base */
+static void test_overlay_matches_private_pool(void) {
+    printf("test_overlay_matches_private_pool... ");
+    KolibriFormulaPool *base = make_base();
+    KolibriSymbolTable symbols;
+    kolibri_symbol_table_init(&symbols, NULL);
+    assert(kf_pool_add_association(base, &symbols, "небо", "голубое", "base", 1U) == 0);
+    KolibriFormulaPool *copy = (KolibriFormulaPool *)malloc(sizeof(KolibriFormulaPool));
+    assert(copy);
+    memcpy(copy, base, sizeof(KolibriFormulaPool));
+
+    const char *program =
+        "начало:\n"
+        "    создать формулу ответ из \"ассоциация\"\n"
+        "    сохранить ответ в геном\n"
+        "    обучить связь \"небо\" -> \"серое\"\n"
+        "    обучить связь \"как дела у тебя\" -> \"хорошо\"\n"
+        "    вызвать эволюцию\n"
+        "    вызвать эволюцию\n"
+        "    оценить ответ на задаче \"как дела\"\n"
+        "    показать итог\n"
+        "    оценить ответ на задаче \"небо\"\n"
+        "    показать итог\n"
+        "конец.\n";
+    KolibriScript shared;
+    KolibriScript private_script;
+    assert(ks_init_shared(&shared, base, NULL) == 0);
+    assert(ks_init(&private_script, copy, NULL) == 0);
+    ks_capture_output(&shared);
+    ks_capture_output(&private_script);
+    assert(run(&private_script, program) == 0);
+    assert(run(&shared, program) == 0);
+
+    size_t shared_length = 0U;
+    size_t private_length = 0U;
+    const char *shared_output = ks_output(&shared, &shared_length);
+    const char *private_output = ks_output(&private_script, &private_length);
+    assert(shared_output && private_output);
+    assert(shared_length == private_length);
+    assert(memcmp(shared_output, private_output, shared_length) == 0);
+
+    assert(kf_overlay_association_count(&shared.overlay) == copy->association_count);
+    for (size_t i = 0; i < copy->association_count; ++i) {
+        const KolibriAssociation *assoc = kf_overlay_association(&shared.overlay, i);
+        assert(strcmp(assoc->question, copy->associations[i].question) == 0);
+        assert(strcmp(assoc->answer, copy->associations[i].answer) == 0);
+    }
+    assert(kf_overlay_formula_count(&shared.overlay) == copy->count);
+    for (size_t i = 0; i < copy->count; ++i) {
+        KolibriFormulaView view;
+        assert(kf_overlay_formula(&shared.overlay, i, &view) == 0);
+        assert(memcmp(&view.gene, &copy->formulas[i].gene, sizeof(KolibriGene)) == 0);
+        assert(view.association_count == copy->formulas[i].association_count);
+    }
+
+    ks_free(&shared);
+    ks_free(&private_script);
+    free(copy);
+    free(base);
+    printf("OK\n");
+}
+
+typedef struct {
+    KolibriScriptContextPool *contexts;
+    int worker;
+    int requests;
+    int failures;
+} Worker;
+
+static void *worker_main(void *arg) {
+    Worker *worker = (Worker *)arg;
+    for (int i = 0; i < worker->requests; ++i) {
+        KolibriScript *script = ks_context_acquire(worker->contexts);
+        char program[256];
+        char expected[64];
+        snprintf(expected, sizeof(expected), "поток %d запрос %d", worker->worker, i);
+        snprintf(program, sizeof(program),
+                 "начало:\n"
+                 "    обучить связь \"%d\" -> \"%d\"\n"
+                 "    показать \"%s\"\n"
+                 "конец.\n",
+                 i, i + worker->worker, expected);
+        size_t length = 0U;
+        const char *output = NULL;
+        if (run(script, program) == 0) {
+            output = ks_output(script, &length);
+        }
+        /* В выводе только текущий запрос */
+        if (!output || strstr(output, expected) == NULL || strstr(output, "поток") != strstr(output, expected)) {
+            worker->failures++;
+        }
+        ks_context_release(worker->contexts, script);
+    }
+    return NULL;
+}
+
+static void test_context_pool_threads(void) {
+    printf("test_context_pool_threads... ");
+    KolibriFormulaPool *base = make_base();
+    KolibriScriptContextPool *contexts = ks_context_pool_create(base, 3);
+    assert(contexts);
+    assert(ks_context_pool_size(contexts) == 3U);
+
+    enum { THREADS = 6, REQUESTS = 200 };
+    pthread_t threads[THREADS];
+    Worker workers[THREADS];
+    for (int t = 0; t < THREADS; ++t) {
+        workers[t].contexts = contexts;
+        workers[t].worker = t;
+        workers[t].requests = REQUESTS;
+        workers[t].failures = 0;
+        assert(pthread_create(&threads[t], NULL, worker_main, &workers[t]) == 0);
+    }
+    for (int t = 0; t < THREADS; ++t) {
+        pthread_join(threads[t], NULL);
+        assert(workers[t].failures == 0);
+    }
+    assert(base->association_count == 0U);
+
+    ks_context_pool_destroy(contexts);
+    free(base);
+    printf("OK\n");
+}
+
+static void test_request_cost(void) {
+    printf("test_request_cost... ");
+    KolibriFormulaPool *base = make_base();
+    const char *program =
+        "начало:\n"
+        "    обучить связь \"2\" -> \"4\"\n"
+        "    показать \"готово\"\n"
+        "конец.\n";
+    enum { REQUESTS = 50 };
+
+    /* Прежний путь: отдельный пул и интерпретатор на каждый запрос */
+    double start = now_seconds();
+    for (int i = 0; i < REQUESTS; ++i) {
+        KolibriFormulaPool *pool = (KolibriFormulaPool *)malloc(sizeof(KolibriFormulaPool));
+        assert(pool);
+        kf_pool_init(pool, 424242ULL);
+        KolibriScript script;
+        assert(ks_init(&script, pool, NULL) == 0);
+        ks_capture_output(&script);
+        assert(run(&script, program) == 0);
+        ks_free(&script);
+        free(pool);
+    }
+    double fresh = now_seconds() - start;
+
+    KolibriScriptContextPool *contexts = ks_context_pool_create(base, 1);
+    assert(contexts);
+    start = now_seconds();
+    for (int i = 0; i < REQUESTS; ++i) {
+        KolibriScript *script = ks_context_acquire(contexts);
+        assert(run(script, program) == 0);
+        ks_context_release(contexts, script);
+    }
+    double pooled = now_seconds() - start;
+    printf("%.2f мс против %.2f мс на запрос... ", pooled * 1e3 / REQUESTS,
+           fresh * 1e3 / REQUESTS);
+
+    ks_context_pool_destroy(contexts);
+    free(base);
+    printf("OK\n");
+}
+
+int main(void) {
+    printf("Running script context pool tests...\n\n");
+    test_overlay();
+    test_overlay_replaces_base();
+    test_overlay_matches_private_pool();
+    test_context_pool_threads();
+    test_request_cost();
+    printf("\n✓ All script context pool tests passed!\n");
+    return 0;
+}
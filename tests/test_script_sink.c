@@ -0,0 +1,118 @@
+/*
+ * Tests for KolibriScript output sinks and the in-memory output buffer
+ */
+
+#include "kolibri/formula.h"
+#include "kolibri/script.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    char text[256];
+    size_t length;
+    size_t calls;
+} SborVyvoda;
+
+static int sobrat_vyvod(void *user, const char *data, size_t length) {
+    SborVyvoda *sbor = (SborVyvoda *)user;
+    if (sbor->length + length >= sizeof(sbor->text)) {
+        return -1;
+    }
+    memcpy(sbor->text + sbor->length, data, length);
+    sbor->length += length;
+    sbor->text[sbor->length] = '\0';
+    sbor->calls += 1U;
+    return 0;
+}
+
+static KolibriFormulaPool *make_pool(void) {
+    KolibriFormulaPool *pool = (KolibriFormulaPool *)calloc(1, sizeof(KolibriFormulaPool));
+    assert(pool != NULL);
+    kf_pool_init(pool, 515151ULL);
+    return pool;
+}
+
+static void test_capture_output(void) {
+    printf("test_capture_output... ");
+
+    KolibriFormulaPool *pool = make_pool();
+    KolibriScript skript;
+    assert(ks_init(&skript, pool, NULL) == 0);
+
+    /* Встроенный буфер: вывод без FILE*, повторный захват очищает буфер */
+    ks_capture_output(&skript);
+    assert(ks_load_text(&skript, "начало:\n    показать \"первый\"\nконец.\n") == 0);
+    assert(ks_execute(&skript) == 0);
+    size_t dlina = 0U;
+    const char *vyvod = ks_output(&skript, &dlina);
+    assert(vyvod != NULL);
+    assert(dlina == strlen(vyvod));
+    assert(strstr(vyvod, "первый\n") != NULL);
+
+    ks_capture_output(&skript);
+    assert(ks_load_text(&skript,
+                        "начало:\n"
+                        "    показать \"второй\"\n"
+                        "    показать \"третий\"\n"
+                        "конец.\n") == 0);
+    assert(ks_execute(&skript) == 0);
+    vyvod = ks_output(&skript, &dlina);
+    assert(strstr(vyvod, "первый") == NULL);
+    assert(strstr(vyvod, "второй\n") != NULL);
+    assert(strstr(vyvod, "третий\n") != NULL);
+
+    /* Длинная строка заставляет буфер вырасти */
+    char programma[4096];
+    char dlinnaya[2001];
+    memset(dlinnaya, 'x', sizeof(dlinnaya) - 1U);
+    dlinnaya[sizeof(dlinnaya) - 1U] = '\0';
+    snprintf(programma, sizeof(programma), "начало:\n    показать \"%s\"\nконец.\n", dlinnaya);
+    ks_capture_output(&skript);
+    assert(ks_load_text(&skript, programma) == 0);
+    assert(ks_execute(&skript) == 0);
+    vyvod = ks_output(&skript, &dlina);
+    assert(dlina >= sizeof(dlinnaya) - 1U);
+    assert(strstr(vyvod, dlinnaya) != NULL);
+
+    ks_free(&skript);
+    free(pool);
+    printf("OK\n");
+}
+
+static void test_user_sink(void) {
+    printf("test_user_sink... ");
+
+    KolibriFormulaPool *pool = make_pool();
+    KolibriScript skript;
+    assert(ks_init(&skript, pool, NULL) == 0);
+
+    /* Пользовательский приёмник получает готовые фрагменты */
+    SborVyvoda sbor;
+    memset(&sbor, 0, sizeof(sbor));
+    ks_set_sink(&skript, sobrat_vyvod, &sbor);
+    assert(ks_load_text(&skript, "начало:\n    показать \"приёмник\"\nконец.\n") == 0);
+    assert(ks_execute(&skript) == 0);
+    assert(sbor.calls >= 1U);
+    assert(strstr(sbor.text, "приёмник\n") != NULL);
+
+    /* Приёмник заменяет встроенный буфер */
+    size_t dlina = 1U;
+    ks_output(&skript, &dlina);
+    assert(dlina == 0U);
+
+    ks_set_sink(&skript, NULL, NULL);
+    ks_free(&skript);
+    free(pool);
+    printf("OK\n");
+}
+
+int main(void) {
+    printf("Running script output sink tests...\n\n");
+    test_capture_output();
+    test_user_sink();
+    printf("\n✓ All script output sink tests passed!\n");
+    return 0;
+}
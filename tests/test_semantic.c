@@ -183,6 +183,51 @@ static void test_validate(void) {
     printf("OK\n");
 }
 
+static void test_evolution_config(void) {
+    printf("test_evolution_config... ");
+    
+    KolibriSemanticContext ctx;
+    k_semantic_context_init(&ctx);
+    k_semantic_context_add_word(&ctx, "животное", 1.0);
+    k_semantic_context_add_word(&ctx, "мяукает", 0.9);
+    k_semantic_context_add_word(&ctx, "хвост", 0.5);
+    
+    /* Один seed — один результат */
+    KolibriSemanticPattern a, b;
+    assert(k_semantic_learn_seeded("кот", &ctx, 200, 42, &a) == 0);
+    assert(k_semantic_learn_seeded("кот", &ctx, 200, 42, &b) == 0);
+    assert(memcmp(a.pattern, b.pattern, KOLIBRI_SEMANTIC_PATTERN_SIZE) == 0);
+    assert(a.context_weight == b.context_weight);
+    
+    /* Ранняя остановка на плато и тот же уровень качества */
+    KolibriEvolutionConfig config;
+    k_semantic_evolution_config_default(&config);
+    config.seed = 7;
+    config.generations = 5000;
+    size_t run = 0;
+    KolibriSemanticPattern early;
+    assert(k_semantic_learn_config("кот", &ctx, &config, &early, &run) == 0);
+    assert(run > 0 && run < config.generations);
+    
+    /* Полный прогон с прежним бюджетом (100 поколений) */
+    config.patience = 0;
+    config.generations = 100;
+    size_t full_run = 0;
+    KolibriSemanticPattern full;
+    assert(k_semantic_learn_config("кот", &ctx, &config, &full, &full_run) == 0);
+    printf("early %zu gens %.3f / full %zu gens %.3f... ",
+           run, early.context_weight, full_run, full.context_weight);
+    assert(early.context_weight >= full.context_weight);
+    assert(k_semantic_validate(&early, &ctx) == early.context_weight);
+    
+    config.population = 1;
+    assert(k_semantic_learn_config("кот", &ctx, &config, &early, NULL) == -1);
+    
+    k_semantic_context_free(&ctx);
+    
+    printf("OK\n");
+}
+
 int main(void) {
     printf("╔════════════════════════════════════════════════════════════╗\n");
     printf("║         SEMANTIC DIGITS TESTS (v2.0 Phase 1)             ║\n");
@@ -196,6 +241,7 @@ int main(void) {
     test_find_nearest();
     test_merge_patterns();
     test_validate();
+    test_evolution_config();
     
     printf("\n✓ All semantic tests passed!\n");
     printf("\nSTATUS: Phase 1 (Semantic Encoding) - INITIAL IMPLEMENTATION\n");
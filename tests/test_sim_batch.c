@@ -0,0 +1,142 @@
+/*
+ * Tests for independent KolibriSim instances and batched ticking
+ */
+
+#include "kolibri/sim.h"
+#include "test_util.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SIM_COUNT 64
+
+static KolibriSim *make_sim(uint32_t seed) {
+    KolibriSimConfig cfg = {
+        .seed = seed,
+        .hmac_key = "kolibri-hmac",
+        .trace_path = NULL,
+        .trace_include_genome = 0,
+        .genome_path = NULL,
+    };
+    KolibriSim *sim = kolibri_sim_create(&cfg);
+    assert(sim);
+    return sim;
+}
+
+/* Последняя запись журнала и лучший фитнес - отпечаток состояния */
+static void fingerprint(KolibriSim *sim, char *out, size_t out_len) {
+    KolibriSimLog logs[KOLIBRI_SIM_LOG_CAPACITY];
+    size_t count = 0, offset = 0;
+    assert(kolibri_sim_get_logs(sim, logs, KOLIBRI_SIM_LOG_CAPACITY, &count, &offset) == 0);
+    assert(count > 0);
+    KolibriSimFormula formulas[1];
+    size_t fcount = 0;
+    assert(kolibri_sim_get_formulas(sim, formulas, 1, &fcount) == 0 && fcount == 1);
+    snprintf(out, out_len, "%zu/%zu %s %.9f", count, offset,
+             logs[count - 1].soobshenie, formulas[0].fitness);
+}
+
+static void run_batch(size_t threads, size_t steps, char prints[SIM_COUNT][256]) {
+    KolibriSim *sims[SIM_COUNT];
+    for (size_t i = 0; i < SIM_COUNT; i++) sims[i] = make_sim((uint32_t)(1000 + i));
+    assert(kolibri_sim_tick_many(sims, SIM_COUNT, steps, threads) == 0);
+    for (size_t i = 0; i < SIM_COUNT; i++) {
+        fingerprint(sims[i], prints[i], 256);
+        kolibri_sim_destroy(sims[i]);
+    }
+}
+
+static void test_determinism(void) {
+    printf("test_determinism... ");
+
+    static char serial[SIM_COUNT][256], parallel[SIM_COUNT][256], automatic[SIM_COUNT][256];
+    run_batch(1, 5, serial);
+    run_batch(8, 5, parallel);
+    run_batch(0, 5, automatic);
+    for (size_t i = 0; i < SIM_COUNT; i++) {
+        assert(strcmp(serial[i], parallel[i]) == 0);
+        assert(strcmp(serial[i], automatic[i]) == 0);
+    }
+
+    /* Пакет эквивалентен поочерёдным kolibri_sim_tick */
+    KolibriSim *sim = make_sim(1000 + 7);
+    for (int i = 0; i < 5; i++) assert(kolibri_sim_tick(sim) == 0);
+    char single[256];
+    fingerprint(sim, single, sizeof(single));
+    assert(strcmp(single, serial[7]) == 0);
+
+    /* После reset экземпляр повторяет свою историю */
+    KolibriSimConfig cfg = {.seed = 1000 + 7, .hmac_key = "kolibri-hmac"};
+    assert(kolibri_sim_reset(sim, &cfg) == 0);
+    KolibriSim *one[1] = {sim};
+    assert(kolibri_sim_tick_many(one, 1, 5, 4) == 0);
+    char again[256];
+    fingerprint(sim, again, sizeof(again));
+    assert(strcmp(strchr(single, ' '), strchr(again, ' ')) == 0);
+    kolibri_sim_destroy(sim);
+
+    assert(kolibri_sim_tick_many(NULL, 0, 1, 1) == 0);
+    assert(kolibri_sim_tick_many(NULL, 1, 1, 1) == -1);
+    KolibriSim *holes[2] = {NULL, NULL};
+    assert(kolibri_sim_tick_many(holes, 2, 1, 1) == -1);
+    printf("OK\n");
+}
+
+static void test_log_ring(void) {
+    printf("test_log_ring... ");
+
+    KolibriSim *sim = make_sim(42);
+    KolibriSim *one[1] = {sim};
+    assert(kolibri_sim_tick_many(one, 1, KOLIBRI_SIM_LOG_CAPACITY + 10, 1) == 0);
+
+    KolibriSimLog logs[KOLIBRI_SIM_LOG_CAPACITY];
+    size_t count = 0, offset = 0;
+    assert(kolibri_sim_get_logs(sim, logs, KOLIBRI_SIM_LOG_CAPACITY, &count, &offset) == 0);
+    assert(count == KOLIBRI_SIM_LOG_CAPACITY);
+    assert(offset == 11);  /* init + 10 вытесненных записей */
+    for (size_t i = 0; i < count; i++) {
+        assert(strcmp(logs[i].tip, "best") == 0);
+        assert(strlen(logs[i].soobshenie) < KOLIBRI_SIM_LOG_MESSAGE_MAX);
+    }
+
+    KolibriSimConfig cfg = {.seed = 42};
+    assert(kolibri_sim_reset(sim, &cfg) == 0);
+    assert(kolibri_sim_get_logs(sim, logs, KOLIBRI_SIM_LOG_CAPACITY, &count, &offset) == 0);
+    assert(count == 1 && offset == 0 && strcmp(logs[0].tip, "reset") == 0);
+    kolibri_sim_destroy(sim);
+    printf("OK\n");
+}
+
+static void test_throughput(void) {
+    printf("test_throughput... ");
+
+    KolibriSim *sims[SIM_COUNT];
+    for (size_t i = 0; i < SIM_COUNT; i++) sims[i] = make_sim((uint32_t)i);
+
+    size_t steps = 20;
+    double start = now_seconds();
+    assert(kolibri_sim_tick_many(sims, SIM_COUNT, steps, 1) == 0);
+    double serial = now_seconds() - start;
+    start = now_seconds();
+    assert(kolibri_sim_tick_many(sims, SIM_COUNT, steps, 0) == 0);
+    double parallel = now_seconds() - start;
+
+    printf("%zu sims, %.0f ticks/s serial, %.0f ticks/s parallel... ", (size_t)SIM_COUNT,
+           (double)(SIM_COUNT * steps) / serial, (double)(SIM_COUNT * steps) / parallel);
+
+    for (size_t i = 0; i < SIM_COUNT; i++) kolibri_sim_destroy(sims[i]);
+    printf("OK\n");
+}
+
+int main(void) {
+    printf("Running simulation batch tests...\n\n");
+
+    test_determinism();
+    test_log_ring();
+    test_throughput();
+
+    printf("\n✓ All simulation batch tests passed!\n");
+    return 0;
+}
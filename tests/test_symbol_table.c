@@ -0,0 +1,223 @@
+/*
+ * Tests for the symbol table: direct-mapped lookup, code space limits and
+ * batched persistence in the genome
+ */
+
+#include "kolibri/genome.h"
+#include "kolibri/symbol_table.h"
+#include "test_util.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void test_symbol_table_cyrillic(void) {
+    printf("test_symbol_table_cyrillic... ");
+
+    KolibriSymbolTable table;
+    kolibri_symbol_table_init(&table, NULL);
+    kolibri_symbol_table_seed_defaults(&table);
+
+    size_t seeded = table.count;
+    kolibri_symbol_table_seed_defaults(&table);
+    assert(table.count == seeded);
+
+    uint8_t digits[KOLIBRI_SYMBOL_DIGITS];
+    uint32_t decoded = 0U;
+
+    assert(kolibri_symbol_encode(&table, 0x043FU, digits) == 0); /* п */
+    assert(kolibri_symbol_decode(&table, digits, &decoded) == 0);
+    assert(decoded == 0x043FU);
+
+    assert(kolibri_symbol_encode(&table, 0x0451U, digits) == 0); /* ё */
+    assert(kolibri_symbol_decode(&table, digits, &decoded) == 0);
+    assert(decoded == 0x0451U);
+
+    assert(kolibri_symbol_encode(&table, 0x0020U, digits) == 0); /* пробел */
+    assert(kolibri_symbol_encode(&table, 0x041FU, digits) == 0); /* П */
+
+    size_t before = table.count;
+    assert(kolibri_symbol_encode(&table, 0x2728U, digits) == 0); /* новая точка */
+    assert(table.count == before + 1U);
+    printf("OK\n");
+}
+
+static void test_symbol_table_capacity(void) {
+    printf("test_symbol_table_capacity... ");
+
+    static KolibriSymbolTable table;
+    kolibri_symbol_table_init(&table, NULL);
+    kolibri_symbol_table_seed_defaults(&table);
+
+    uint8_t digits[KOLIBRI_SYMBOL_DIGITS];
+    uint32_t decoded = 0U;
+    /* CJK: далеко за пределами прежних 256 символов */
+    for (uint32_t cp = 0x4E00U; table.count < KOLIBRI_SYMBOL_MAX; ++cp) {
+        assert(kolibri_symbol_encode(&table, cp, digits) == 0);
+        assert(kolibri_symbol_decode(&table, digits, &decoded) == 0);
+        assert(decoded == cp);
+    }
+    assert(kolibri_symbol_encode(&table, 0x1F600U, digits) == -1);
+    assert(kolibri_symbol_encode(&table, 0x043FU, digits) == 0);
+    assert(kolibri_symbol_decode(&table, digits, &decoded) == 0);
+    assert(decoded == 0x043FU);
+
+    /* Строка с символом без кода - ошибка, а не укороченная запись */
+    const char *text = "пп\xF0\x9F\x98\x80п"; /* п п U+1F600 п */
+    uint8_t encoded[32];
+    size_t encoded_len = 99U;
+    assert(kolibri_symbol_encode_utf8(&table, text, strlen(text), encoded, sizeof(encoded),
+                                      &encoded_len) == -1);
+    assert(encoded_len == 2U * KOLIBRI_SYMBOL_DIGITS);
+    assert(kolibri_symbol_encode_utf8(&table, "пп", strlen("пп"), encoded, sizeof(encoded),
+                                      &encoded_len) == 0);
+    assert(encoded_len == 2U * KOLIBRI_SYMBOL_DIGITS);
+    printf("OK\n");
+}
+
+static void test_symbol_table_sparse_pages(void) {
+    printf("test_symbol_table_sparse_pages... ");
+
+    static KolibriSymbolTable table;
+    kolibri_symbol_table_init(&table, NULL);
+
+    uint8_t digits[KOLIBRI_SYMBOL_DIGITS];
+    uint32_t decoded = 0U;
+    /* По символу на блок: страниц пула меньше, чем блоков */
+    size_t mark_count = 0U;
+    size_t mark_pages = 0U;
+    for (size_t i = 0; i < KOLIBRI_SYMBOL_MAX; ++i) {
+        if (i == 200U) {
+            mark_count = table.count;
+            mark_pages = table.page_count;
+        }
+        uint32_t cp = 0x10000U + (uint32_t)i * KOLIBRI_SYMBOL_PAGE_SIZE;
+        assert(kolibri_symbol_encode(&table, cp, digits) == 0);
+        assert(kolibri_symbol_decode(&table, digits, &decoded) == 0);
+        assert(decoded == cp);
+    }
+    assert(table.page_count == KOLIBRI_SYMBOL_PAGE_POOL);
+    assert(table.count == KOLIBRI_SYMBOL_MAX);
+
+    /* Повторное кодирование находит те же записи, включая overflow */
+    uint8_t again[KOLIBRI_SYMBOL_DIGITS];
+    for (size_t i = 0; i < KOLIBRI_SYMBOL_MAX; i += 37U) {
+        uint32_t cp = 0x10000U + (uint32_t)i * KOLIBRI_SYMBOL_PAGE_SIZE;
+        assert(kolibri_symbol_encode(&table, cp, digits) == 0);
+        assert(kolibri_symbol_encode(&table, cp, again) == 0);
+        assert(memcmp(digits, again, sizeof(digits)) == 0);
+    }
+    assert(table.count == KOLIBRI_SYMBOL_MAX);
+
+    /* Откат к отметке убирает новые overflow-записи, старые остаются */
+    kolibri_symbol_table_rollback(&table, mark_count, mark_pages);
+    assert(table.count == 200U && table.overflow_count == 200U - KOLIBRI_SYMBOL_PAGE_POOL);
+    uint32_t kept = 0x10000U + 150U * KOLIBRI_SYMBOL_PAGE_SIZE;
+    assert(kolibri_symbol_encode(&table, kept, digits) == 0);
+    assert(table.count == 200U);
+    assert(kolibri_symbol_decode(&table, digits, &decoded) == 0);
+    assert(decoded == kept);
+    uint32_t dropped = 0x10000U + 500U * KOLIBRI_SYMBOL_PAGE_SIZE;
+    assert(kolibri_symbol_encode(&table, dropped, digits) == 0);
+    assert(table.count == 201U);
+    printf("OK\n");
+}
+
+static void test_symbol_table_persistence(void) {
+    printf("test_symbol_table_persistence... ");
+
+    unsigned char key[KOLIBRI_HMAC_KEY_SIZE];
+    memset(key, 2, sizeof(key));
+
+    char path[] = "/tmp/kolibri_symbols_XXXXXX";
+    temp_path(path);
+
+    KolibriGenome genome;
+    assert(kg_open(&genome, path, key, sizeof(key)) == 0);
+
+    static KolibriSymbolTable table;
+    kolibri_symbol_table_init(&table, &genome);
+    kolibri_symbol_table_seed_defaults(&table);
+    const char *text = "Привет, мир! \xE2\x9C\xA8 hello";
+    uint8_t encoded[128];
+    size_t encoded_len = 0U;
+    assert(kolibri_symbol_encode_utf8(&table, text, strlen(text), encoded, sizeof(encoded),
+                                      &encoded_len) == 0);
+    assert(encoded_len > 0U && encoded_len % KOLIBRI_SYMBOL_DIGITS == 0U);
+    assert(kolibri_symbol_table_flush(&table) == 0);
+    size_t count = table.count;
+
+    static KolibriSymbolTable reloaded;
+    kolibri_symbol_table_init(&reloaded, &genome);
+    kolibri_symbol_table_load(&reloaded);
+    assert(reloaded.count == count);
+    uint8_t again[128];
+    size_t again_len = 0U;
+    assert(kolibri_symbol_encode_utf8(&reloaded, text, strlen(text), again, sizeof(again),
+                                      &again_len) == 0);
+    assert(again_len == encoded_len);
+    assert(memcmp(again, encoded, encoded_len) == 0);
+    assert(reloaded.count == count);
+
+    kg_close(&genome);
+    remove(path);
+    printf("OK\n");
+}
+
+static void test_symbol_table_failed_flush(void) {
+    printf("test_symbol_table_failed_flush... ");
+
+    unsigned char key[KOLIBRI_HMAC_KEY_SIZE];
+    memset(key, 3, sizeof(key));
+
+    char path[] = "/tmp/kolibri_symbols_XXXXXX";
+    temp_path(path);
+
+    KolibriGenome genome;
+    assert(kg_open(&genome, path, key, sizeof(key)) == 0);
+
+    static KolibriSymbolTable table;
+    kolibri_symbol_table_init(&table, &genome);
+    kolibri_symbol_table_seed_defaults(&table);
+    assert(table.pending_count == 0U);
+
+    /* Запись в геном не удаётся: блок остаётся в очереди */
+    FILE *file = genome.file;
+    genome.file = fopen("/dev/full", "wb");
+    assert(genome.file);
+    uint8_t digits[KOLIBRI_SYMBOL_DIGITS];
+    assert(kolibri_symbol_encode(&table, 0x2728U, digits) == 0);
+    assert(kolibri_symbol_table_flush(&table) == -1);
+    assert(table.pending_count == 1U);
+    fclose(genome.file);
+    genome.file = file;
+
+    /* Следующий flush дописывает отложенный блок */
+    assert(kolibri_symbol_table_flush(&table) == 0);
+    assert(table.pending_count == 0U);
+
+    static KolibriSymbolTable reloaded;
+    kolibri_symbol_table_init(&reloaded, &genome);
+    kolibri_symbol_table_load(&reloaded);
+    assert(reloaded.count == table.count);
+    uint32_t decoded = 0U;
+    assert(kolibri_symbol_decode(&reloaded, digits, &decoded) == 0);
+    assert(decoded == 0x2728U);
+
+    kg_close(&genome);
+    remove(path);
+    printf("OK\n");
+}
+
+int main(void) {
+    printf("Running symbol table tests...\n\n");
+    test_symbol_table_cyrillic();
+    test_symbol_table_capacity();
+    test_symbol_table_sparse_pages();
+    test_symbol_table_persistence();
+    test_symbol_table_failed_flush();
+    printf("\n✓ All symbol table tests passed!\n");
+    return 0;
+}
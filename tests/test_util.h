@@ -0,0 +1,41 @@
+/*
+ * Shared helpers for the standalone tests: a monotonic clock for printed
+ * timings and temporary files and directories
+ */
+
+#ifndef KOLIBRI_TEST_UTIL_H
+#define KOLIBRI_TEST_UTIL_H
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Время только печатается: сравнения замеров в assert нестабильны */
+static inline double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/* Создаёт пустой файл по шаблону mkstemp ("...XXXXXX") */
+static inline void temp_path(char *path) {
+    int fd = mkstemp(path);
+    assert(fd != -1);
+    close(fd);
+}
+
+/* Уникальное имя по шаблону; сам файл не создаётся */
+static inline void temp_name(char *path) {
+    temp_path(path);
+    unlink(path);
+}
+
+static inline void remove_tree(const char *root) {
+    char command[600];
+    snprintf(command, sizeof(command), "rm -rf '%s'", root);
+    assert(system(command) == 0);
+}
+
+#endif /* KOLIBRI_TEST_UTIL_H */
@@ -1,8 +1,13 @@
 /*
  * KOLIBRI FRACTAL v40 - 4 уровня + смешанный контекст
  * Берём лучшее из v37 + улучшаем контекст для bits0
+ *
+ * BWT строится по суффиксному массиву (SA-IS) блоками, параллельно:
+ *   cc -O2 -Ibackend/include tools/kolibri_v40.c backend/src/bwt.c -lpthread
  */
 
+#include "kolibri/bwt.h"
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -22,42 +27,6 @@ static uint32_t calc_crc32(const uint8_t *d, size_t len) {
     return crc ^ 0xFFFFFFFF;
 }
 
-static const uint8_t *g_bwt_data;
-static size_t g_bwt_len;
-static int bwt_cmp(const void *a, const void *b) {
-    size_t i = *(const size_t *)a, j = *(const size_t *)b;
-    for (size_t k = 0; k < g_bwt_len; k++) {
-        uint8_t ci = g_bwt_data[(i + k) % g_bwt_len];
-        uint8_t cj = g_bwt_data[(j + k) % g_bwt_len];
-        if (ci != cj) return (int)ci - (int)cj;
-    }
-    return 0;
-}
-static size_t bwt_encode(const uint8_t *in, size_t len, uint8_t *out) {
-    size_t *idx = malloc(len * sizeof(size_t));
-    for (size_t i = 0; i < len; i++) idx[i] = i;
-    g_bwt_data = in; g_bwt_len = len;
-    qsort(idx, len, sizeof(size_t), bwt_cmp);
-    size_t orig = 0;
-    for (size_t i = 0; i < len; i++) {
-        out[i] = in[(idx[i] + len - 1) % len];
-        if (idx[i] == 0) orig = i;
-    }
-    free(idx);
-    return orig;
-}
-static void bwt_decode(const uint8_t *L, size_t len, size_t I, uint8_t *out) {
-    size_t C[256] = {0}, K[256], sum = 0;
-    for (size_t i = 0; i < len; i++) C[L[i]]++;
-    for (int c = 0; c < 256; c++) { K[c] = sum; sum += C[c]; }
-    size_t *P = malloc(len * sizeof(size_t));
-    size_t cnt[256] = {0};
-    for (size_t i = 0; i < len; i++) P[i] = cnt[L[i]]++;
-    size_t j = I;
-    for (size_t i = len; i > 0; i--) { out[i - 1] = L[j]; j = K[L[j]] + P[j]; }
-    free(P);
-}
-
 static void mtf_encode(const uint8_t *in, size_t len, uint8_t *out) {
     uint8_t tbl[256];
     for (int i = 0; i < 256; i++) tbl[i] = (uint8_t)i;
@@ -276,7 +245,8 @@ static uint32_t read32(const uint8_t *in, size_t *pos) {
     return x;
 }
 
-#define MAGIC 0x4B463430u
+#define MAGIC 0x4B463431u /* KF41: блочный BWT с терминатором */
+#define BWT_BLOCK KOLIBRI_BWT_DEFAULT_BLOCK
 
 static int compress_file(const char *in_path, const char *out_path) {
     FILE *fin = fopen(in_path, "rb");
@@ -291,7 +261,13 @@ static int compress_file(const char *in_path, const char *out_path) {
     uint32_t crc = calc_crc32(in_data, in_size);
     
     uint8_t *bwt_out = malloc(in_size);
-    size_t bwt_idx = bwt_encode(in_data, in_size, bwt_out);
+    size_t blocks = kolibri_bwt_block_count(in_size, BWT_BLOCK);
+    uint32_t *primaries = malloc((blocks + 1) * sizeof(uint32_t));
+    if (!bwt_out || !primaries ||
+        kolibri_bwt_encode_blocks(in_data, in_size, BWT_BLOCK, 0, bwt_out, primaries) != 0) {
+        free(bwt_out); free(primaries); free(in_data);
+        return 1;
+    }
     
     uint8_t *mtf = malloc(in_size);
     mtf_encode(bwt_out, in_size, mtf);
@@ -438,7 +414,7 @@ static int compress_file(const char *in_path, const char *out_path) {
     rc_enc_flush(&rc);
     size_t sv4 = rc.out_size;
     
-    size_t sf = sb0 + sb1 + sb2 + sb3 + sv1 + sv2 + sv3 + sv4 + 44;
+    size_t sf = sb0 + sb1 + sb2 + sb3 + sv1 + sv2 + sv3 + sv4 + 44 + blocks * 4;
     
     printf("=== v40 ===\n");
     printf("B0(rl): %zu, B1: %zu, B2: %zu, B3: %zu\n", sb0, sb1, sb2, sb3);
@@ -451,7 +427,7 @@ static int compress_file(const char *in_path, const char *out_path) {
     
     write32(out, &pos, MAGIC);
     write32(out, &pos, (uint32_t)in_size);
-    write32(out, &pos, (uint32_t)bwt_idx);
+    write32(out, &pos, (uint32_t)BWT_BLOCK);
     write32(out, &pos, crc);
     write32(out, &pos, (uint32_t)sb0);
     write32(out, &pos, (uint32_t)sb1);
@@ -460,6 +436,7 @@ static int compress_file(const char *in_path, const char *out_path) {
     write32(out, &pos, (uint32_t)sv1);
     write32(out, &pos, (uint32_t)sv2);
     write32(out, &pos, (uint32_t)sv3);
+    for (size_t b = 0; b < blocks; b++) write32(out, &pos, primaries[b]);
     
     memcpy(out + pos, bits0, sb0); pos += sb0;
     memcpy(out + pos, bits1, sb1); pos += sb1;
@@ -476,7 +453,7 @@ static int compress_file(const char *in_path, const char *out_path) {
     
     printf("Выход: %zu (%.2fx)\n", pos, (double)in_size/pos);
     
-    free(m256);
+    free(m256); free(primaries);
     free(bits0); free(bits1); free(bits2); free(bits3);
     free(v1); free(v2); free(v3); free(v4);
     free(in_data); free(mtf); free(out);
@@ -499,7 +476,7 @@ static int decompress_file(const char *in_path, const char *out_path) {
     if (magic != MAGIC) { free(in_data); return 1; }
     
     uint32_t orig = read32(in_data, &pos);
-    uint32_t bwt_idx = read32(in_data, &pos);
+    uint32_t block_size = read32(in_data, &pos);
     uint32_t stored_crc = read32(in_data, &pos);
     uint32_t sb0 = read32(in_data, &pos);
     uint32_t sb1 = read32(in_data, &pos);
@@ -509,6 +486,11 @@ static int decompress_file(const char *in_path, const char *out_path) {
     uint32_t sv2 = read32(in_data, &pos);
     uint32_t sv3 = read32(in_data, &pos);
     
+    size_t blocks = kolibri_bwt_block_count(orig, block_size);
+    if (block_size == 0 || pos + blocks * 4 > in_size) { free(in_data); return 1; }
+    uint32_t *primaries = malloc((blocks + 1) * sizeof(uint32_t));
+    for (size_t b = 0; b < blocks; b++) primaries[b] = read32(in_data, &pos);
+    
     RC rc;
     
     /* Decode bits0 */
@@ -657,8 +639,9 @@ static int decompress_file(const char *in_path, const char *out_path) {
     free(mtf);
     
     uint8_t *out = malloc(orig);
-    bwt_decode(bwt_out, orig, bwt_idx, out);
-    free(bwt_out);
+    int bwt_rc = kolibri_bwt_decode_blocks(bwt_out, orig, block_size, 0, primaries, out);
+    free(bwt_out); free(primaries);
+    if (bwt_rc != 0) { free(in_data); free(out); return 1; }
     
     uint32_t calc_crc = calc_crc32(out, orig);
     printf("CRC: %08X vs %08X %s\n", stored_crc, calc_crc, stored_crc==calc_crc?"OK":"FAIL");